@@ -0,0 +1,205 @@
+/*
+ *@BEGIN LICENSE
+ *
+ * v2RDM-CASSCF, a plugin to:
+ *
+ * Psi4: an open-source quantum chemistry software package
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (c) 2014, The Florida State University. All rights reserved.
+ * 
+ *@END LICENSE
+ *
+ */
+
+#include"v2rdm_solver.h"
+#include "blas.h"
+#include<psi4/libqt/qt.h>
+
+#include<math.h>
+#include<string.h>
+
+using namespace psi;
+
+using namespace fnocc;
+
+/*================================================================
+
+   anderson acceleration
+
+   for fixed mu, one boundary-point iteration maps the dual solution y and
+   M = mu x - z, from which x and z follow by projection (see Update_xz),
+   onto new ones: g = G(u), with u = (y,M).  anderson acceleration replaces
+   g with the combination of the last few g that minimizes the
+   corresponding combination of the residuals f = g - u:
+
+       u+ = g - dG.gamma
+
+   where the columns of dF and dG are the changes in f and g over the last
+   anderson_max_ iterations.  type II:  gamma minimizes |f - dF.gamma|.
+   type I:  dU^T.( f - dF.gamma ) = 0, with dU = dG - dF.  the changes are
+   kept in memory, in a ring buffer, along with dF^T.dF and dG^T.dF, to
+   which each iteration adds one row and column.
+
+   safeguards: the history is discarded when the norm of the residual
+   increases, and a plain step is taken if the coefficients are not
+   determined or are too large.
+
+================================================================*/
+
+namespace psi{ namespace v2rdm_casscf{
+
+// forget the history (when mu or the orbitals change, the fixed-point map
+// changes, too)
+void v2RDMSolver::Anderson_Reset(){
+    anderson_have_u_    = false;
+    anderson_have_prev_ = false;
+    anderson_iter_      = 0;
+    anderson_nvec_      = 0;
+}
+
+// replace g = (y,M), where M = ATy on entry, by the accelerated u+
+void v2RDMSolver::Anderson_Step(){
+
+    long int ny  = nconstraints_;
+    long int n   = anderson_dim_;
+    long int max = anderson_max_;
+
+    double * y_p = y->pointer();
+    double * M_p = ATy->pointer();
+    double * u_p = anderson_u_;
+
+    anderson_restart_ = false;
+    anderson_used_    = 0;
+
+    if ( !anderson_have_u_ ) {
+        C_DCOPY(ny,y_p,1,u_p,1);
+        C_DCOPY(dimx_,M_p,1,u_p + ny,1);
+        anderson_have_u_ = true;
+        return;
+    }
+
+    // |f|, with f = g - u
+    double fnorm = 0.0;
+    for (long int i = 0; i < ny; i++) {
+        double dum = y_p[i] - u_p[i];
+        fnorm += dum * dum;
+    }
+    for (long int i = 0; i < dimx_; i++) {
+        double dum = M_p[i] - u_p[ny + i];
+        fnorm += dum * dum;
+    }
+    fnorm = sqrt(fnorm);
+
+    if ( anderson_have_prev_ && fnorm > anderson_fnorm_ ) {
+        anderson_nvec_ = 0;
+        anderson_iter_ = 0;
+        anderson_restart_ = true;
+        anderson_nrestart_++;
+    }
+
+    // dF = f - f_prev and dG = g - g_prev, then f_prev = f and g_prev = g
+    long int k = anderson_iter_ % max;
+    double * df = anderson_df_ + k * n;
+    double * dg = anderson_dg_ + k * n;
+    double * f  = anderson_f_;
+    double * g  = anderson_g_;
+    bool add = anderson_have_prev_ && !anderson_restart_;
+    for (long int i = 0; i < n; i++) {
+        double gi = ( i < ny ) ? y_p[i] : M_p[i - ny];
+        double fi = gi - u_p[i];
+        if ( add ) {
+            df[i] = fi - f[i];
+            dg[i] = gi - g[i];
+        }
+        f[i] = fi;
+        g[i] = gi;
+    }
+    anderson_have_prev_ = true;
+    anderson_fnorm_     = fnorm;
+
+    // new row and column of dF^T.dF and dG^T.dF
+    if ( add ) {
+        anderson_iter_++;
+        anderson_nvec_ = anderson_iter_ < max ? anderson_iter_ : max;
+        for (long int j = 0; j < anderson_nvec_; j++) {
+            double * dfj = anderson_df_ + j * n;
+            double * dgj = anderson_dg_ + j * n;
+            double ff = C_DDOT(n,df,1,dfj,1);
+            anderson_ff_[k * max + j] = ff;
+            anderson_ff_[j * max + k] = ff;
+            anderson_gf_[k * max + j] = C_DDOT(n,dg,1,dfj,1);
+            anderson_gf_[j * max + k] = C_DDOT(n,dgj,1,df,1);
+        }
+    }
+
+    long int m = anderson_nvec_;
+    if ( m > 0 ) {
+
+        // type II: ( dF^T.dF ) gamma = dF^T.f
+        // type I:  ( dU^T.dF ) gamma = dU^T.f, with dU = dG - dF
+        // the matrix is stored by columns: A[j*m+i] = dX_i^T.dF_j
+        double * A      = anderson_a_;
+        double * gamma  = anderson_gamma_;
+        long int * ipiv = anderson_ipiv_;
+
+        double amax = 0.0;
+        for (long int i = 0; i < m; i++) {
+            for (long int j = 0; j < m; j++) {
+                double dum = anderson_ff_[i * max + j];
+                if ( anderson_type_ == 1 ) dum = anderson_gf_[i * max + j] - dum;
+                A[j * m + i] = dum;
+            }
+            double dum = C_DDOT(n,anderson_df_ + i * n,1,f,1);
+            if ( anderson_type_ == 1 ) dum = C_DDOT(n,anderson_dg_ + i * n,1,f,1) - dum;
+            gamma[i] = dum;
+            if ( fabs(A[i * m + i]) > amax ) amax = fabs(A[i * m + i]);
+        }
+
+        // a small shift of the diagonal for the least-squares problem
+        if ( anderson_type_ == 2 ) {
+            for (long int i = 0; i < m; i++) {
+                A[i * m + i] += 1.0e-12 * amax;
+            }
+        }
+
+        long int nrhs = 1;
+        long int lda  = m;
+        long int ldb  = m;
+        long int info = 0;
+        DGESV(m,nrhs,A,lda,ipiv,gamma,ldb,info);
+
+        double gmax = 0.0;
+        for (long int i = 0; i < m; i++) {
+            if ( fabs(gamma[i]) > gmax ) gmax = fabs(gamma[i]);
+        }
+
+        // u+ = g - dG.gamma
+        if ( info == 0 && amax > 0.0 && gmax < 1.0e4 && gmax == gmax ) {
+            for (long int j = 0; j < m; j++) {
+                double * dgj = anderson_dg_ + j * n;
+                C_DAXPY(ny,-gamma[j],dgj,1,y_p,1);
+                C_DAXPY(dimx_,-gamma[j],dgj + ny,1,M_p,1);
+            }
+            anderson_used_ = m;
+        }
+    }
+
+    C_DCOPY(ny,y_p,1,u_p,1);
+    C_DCOPY(dimx_,M_p,1,u_p + ny,1);
+}
+
+}}
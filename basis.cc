@@ -53,6 +53,18 @@ using namespace psi;
 
 namespace psi{ namespace v2rdm_casscf{
 
+// allocate a 64-byte aligned index table of length n, initialized to -999
+static int * IndexTable(long int n) {
+    void * ptr;
+    if ( posix_memalign(&ptr,64,n*sizeof(int)) != 0 ) {
+        throw PsiException("v2RDMSolver: could not allocate index table",__FILE__,__LINE__);
+    }
+    int * table = (int*)ptr;
+    for (long int i = 0; i < n; i++) {
+        table[i] = -999;
+    }
+    return table;
+}
 
 void v2RDMSolver::BuildBasis() {
 
@@ -451,15 +463,38 @@ void v2RDMSolver::BuildBasis() {
         gems.push_back(mygems);
     }
 
-    bas_ab_sym           = (int***)malloc(nirrep_*sizeof(int**));
-    bas_aa_sym           = (int***)malloc(nirrep_*sizeof(int**));
-    bas_00_sym           = (int***)malloc(nirrep_*sizeof(int**));
+    // active space geminals: all irreps are stored contiguously, and the
+    // aa and 00 blocks are no larger than the ab block
+    long int ngems = 0;
+    for (int h = 0; h < nirrep_; h++) {
+        ngems += gems[h].size();
+    }
+    bas_ab_sym           = (int(**)[2])malloc(nirrep_*sizeof(int(*)[2]));
+    bas_aa_sym           = (int(**)[2])malloc(nirrep_*sizeof(int(*)[2]));
+    bas_00_sym           = (int(**)[2])malloc(nirrep_*sizeof(int(*)[2]));
+    bas_ab_sym[0]        = (int(*)[2])malloc(ngems*sizeof(int[2]));
+    bas_aa_sym[0]        = (int(*)[2])malloc(ngems*sizeof(int[2]));
+    bas_00_sym[0]        = (int(*)[2])malloc(ngems*sizeof(int[2]));
+    for (long int n = 0; n < ngems; n++) {
+        for (int j = 0; j < 2; j++) {
+            bas_ab_sym[0][n][j] = -999;
+            bas_aa_sym[0][n][j] = -999;
+            bas_00_sym[0][n][j] = -999;
+        }
+    }
+    for (int h = 1; h < nirrep_; h++) {
+        bas_ab_sym[h] = bas_ab_sym[h-1] + gems[h-1].size();
+        bas_aa_sym[h] = bas_aa_sym[h-1] + gems[h-1].size();
+        bas_00_sym[h] = bas_00_sym[h-1] + gems[h-1].size();
+    }
+
+    ibas_ab_             = IndexTable(amo_*amo_);
+    ibas_aa_             = IndexTable(amo_*amo_);
+    ibas_00_             = IndexTable(amo_*amo_);
+
     bas_full_sym         = (int***)malloc(nirrep_*sizeof(int**));
     bas_really_full_sym  = (int***)malloc(nirrep_*sizeof(int**));
 
-    ibas_ab_sym          = (int***)malloc(nirrep_*sizeof(int**));
-    ibas_aa_sym          = (int***)malloc(nirrep_*sizeof(int**));
-    ibas_00_sym          = (int***)malloc(nirrep_*sizeof(int**));
     ibas_full_sym        = (int***)malloc(nirrep_*sizeof(int**));
     ibas_really_full_sym = (int***)malloc(nirrep_*sizeof(int**));
 
@@ -471,39 +506,12 @@ void v2RDMSolver::BuildBasis() {
 
     for (int h = 0; h < nirrep_; h++) {
 
-        ibas_ab_sym[h]          = (int**)malloc(amo_*sizeof(int*));
-        ibas_aa_sym[h]          = (int**)malloc(amo_*sizeof(int*));
-        ibas_00_sym[h]          = (int**)malloc(amo_*sizeof(int*));
         ibas_full_sym[h]        = (int**)malloc(nmo_*sizeof(int*));
         ibas_really_full_sym[h] = (int**)malloc(nmo_*sizeof(int*));
 
-        bas_ab_sym[h]         = (int**)malloc(amo_*amo_*sizeof(int*));
-        bas_aa_sym[h]         = (int**)malloc(amo_*amo_*sizeof(int*));
-        bas_00_sym[h]         = (int**)malloc(amo_*amo_*sizeof(int*));
         bas_full_sym[h]       = (int**)malloc(nmo_*nmo_*sizeof(int*));
         bas_really_full_sym[h]       = (int**)malloc(nmo_*nmo_*sizeof(int*));
 
-        // active space geminals
-        for (int i = 0; i < amo_; i++) {
-            ibas_ab_sym[h][i] = (int*)malloc(amo_*sizeof(int));
-            ibas_aa_sym[h][i] = (int*)malloc(amo_*sizeof(int));
-            ibas_00_sym[h][i] = (int*)malloc(amo_*sizeof(int));
-            for (int j = 0; j < amo_; j++) {
-                ibas_ab_sym[h][i][j] = -999;
-                ibas_aa_sym[h][i][j] = -999;
-                ibas_00_sym[h][i][j] = -999;
-            }
-        }
-        for (int i = 0; i < amo_*amo_; i++) {
-            bas_ab_sym[h][i] = (int*)malloc(2*sizeof(int));
-            bas_aa_sym[h][i] = (int*)malloc(2*sizeof(int));
-            bas_00_sym[h][i] = (int*)malloc(2*sizeof(int));
-            for (int j = 0; j < 2; j++) {
-                bas_ab_sym[h][i][j] = -999;
-                bas_aa_sym[h][i][j] = -999;
-                bas_00_sym[h][i][j] = -999;
-            }
-        }
         // full space geminals
         for (int i = 0; i < nmo_; i++) {
             ibas_full_sym[h][i]        = (int*)malloc(nmo_*sizeof(int));
@@ -529,15 +537,15 @@ void v2RDMSolver::BuildBasis() {
             int i = gems[h][n].first;
             int j = gems[h][n].second;
 
-            ibas_ab_sym[h][i][j] = n;
+            ibas_ab_[i*amo_+j]   = n;
             bas_ab_sym[h][n][0]  = i;
             bas_ab_sym[h][n][1]  = j;
             count_ab++;
 
             if ( i <= j ) continue;
 
-            ibas_aa_sym[h][i][j] = count_aa;
-            ibas_aa_sym[h][j][i] = count_aa;
+            ibas_aa_[i*amo_+j]   = count_aa;
+            ibas_aa_[j*amo_+i]   = count_aa;
             bas_aa_sym[h][count_aa][0] = i;
             bas_aa_sym[h][count_aa][1] = j;
             count_aa++;
@@ -640,8 +648,8 @@ void v2RDMSolver::BuildBasis() {
 
             int hij   = SymmetryPair(hi,hj);
 
-            ibas_00_sym[hij][iact][jact] = gems_00[hij];
-            ibas_00_sym[hij][jact][iact] = gems_00[hij];
+            ibas_00_[iact*amo_+jact] = gems_00[hij];
+            ibas_00_[jact*amo_+iact] = gems_00[hij];
 
             bas_00_sym[hij][gems_00[hij]][0] = iact;
             bas_00_sym[hij][gems_00[hij]][1] = jact;
@@ -670,47 +678,40 @@ void v2RDMSolver::BuildBasis() {
             }
             triplets.push_back(mytrip);
         }
-        bas_aaa_sym  = (int***)malloc(nirrep_*sizeof(int**));
-        bas_aab_sym  = (int***)malloc(nirrep_*sizeof(int**));
-        bas_aba_sym  = (int***)malloc(nirrep_*sizeof(int**));
-        ibas_aaa_sym = (int****)malloc(nirrep_*sizeof(int***));
-        ibas_aab_sym = (int****)malloc(nirrep_*sizeof(int***));
-        ibas_aba_sym = (int****)malloc(nirrep_*sizeof(int***));
+        // all irreps are stored contiguously, and the aab and aaa blocks
+        // are no larger than the aba block
+        long int ntrip = 0;
+        for (int h = 0; h < nirrep_; h++) {
+            ntrip += triplets[h].size();
+        }
+        bas_aaa_sym  = (int(**)[3])malloc(nirrep_*sizeof(int(*)[3]));
+        bas_aab_sym  = (int(**)[3])malloc(nirrep_*sizeof(int(*)[3]));
+        bas_aba_sym  = (int(**)[3])malloc(nirrep_*sizeof(int(*)[3]));
+        bas_aaa_sym[0] = (int(*)[3])malloc(ntrip*sizeof(int[3]));
+        bas_aab_sym[0] = (int(*)[3])malloc(ntrip*sizeof(int[3]));
+        bas_aba_sym[0] = (int(*)[3])malloc(ntrip*sizeof(int[3]));
+        for (long int n = 0; n < ntrip; n++) {
+            for (int j = 0; j < 3; j++) {
+                bas_aaa_sym[0][n][j] = -999;
+                bas_aab_sym[0][n][j] = -999;
+                bas_aba_sym[0][n][j] = -999;
+            }
+        }
+        for (int h = 1; h < nirrep_; h++) {
+            bas_aaa_sym[h] = bas_aaa_sym[h-1] + triplets[h-1].size();
+            bas_aab_sym[h] = bas_aab_sym[h-1] + triplets[h-1].size();
+            bas_aba_sym[h] = bas_aba_sym[h-1] + triplets[h-1].size();
+        }
+
+        long int amo3 = (long int)amo_*amo_*amo_;
+        ibas_aaa_    = IndexTable(amo3);
+        ibas_aab_    = IndexTable(amo3);
+        ibas_aba_    = IndexTable(amo3);
+
         trip_aaa    = (int*)malloc(nirrep_*sizeof(int));
         trip_aab    = (int*)malloc(nirrep_*sizeof(int));
         trip_aba    = (int*)malloc(nirrep_*sizeof(int));
         for (int h = 0; h < nirrep_; h++) {
-            ibas_aaa_sym[h] = (int***)malloc(amo_*sizeof(int**));
-            ibas_aab_sym[h] = (int***)malloc(amo_*sizeof(int**));
-            ibas_aba_sym[h] = (int***)malloc(amo_*sizeof(int**));
-            bas_aaa_sym[h]  = (int**)malloc(amo_*amo_*amo_*sizeof(int*));
-            bas_aab_sym[h]  = (int**)malloc(amo_*amo_*amo_*sizeof(int*));
-            bas_aba_sym[h]  = (int**)malloc(amo_*amo_*amo_*sizeof(int*));
-            for (int i = 0; i < amo_; i++) {
-                ibas_aaa_sym[h][i] = (int**)malloc(amo_*sizeof(int*));
-                ibas_aab_sym[h][i] = (int**)malloc(amo_*sizeof(int*));
-                ibas_aba_sym[h][i] = (int**)malloc(amo_*sizeof(int*));
-                for (int j = 0; j < amo_; j++) {
-                    ibas_aaa_sym[h][i][j] = (int*)malloc(amo_*sizeof(int));
-                    ibas_aab_sym[h][i][j] = (int*)malloc(amo_*sizeof(int));
-                    ibas_aba_sym[h][i][j] = (int*)malloc(amo_*sizeof(int));
-                    for (int k = 0; k < amo_; k++) {
-                        ibas_aaa_sym[h][i][j][k] = -999;
-                        ibas_aab_sym[h][i][j][k] = -999;
-                        ibas_aba_sym[h][i][j][k] = -999;
-                    }
-                }
-            }
-            for (int i = 0; i < amo_*amo_*amo_; i++) {
-                bas_aaa_sym[h][i] = (int*)malloc(3*sizeof(int));
-                bas_aab_sym[h][i] = (int*)malloc(3*sizeof(int));
-                bas_aba_sym[h][i] = (int*)malloc(3*sizeof(int));
-                for (int j = 0; j < 3; j++) {
-                    bas_aaa_sym[h][i][j] = -999;
-                    bas_aab_sym[h][i][j] = -999;
-                    bas_aba_sym[h][i][j] = -999;
-                }
-            }
 
             // mappings:
             int count_aaa = 0;
@@ -721,7 +722,7 @@ void v2RDMSolver::BuildBasis() {
                 int j = std::get<1>(triplets[h][n]);
                 int k = std::get<2>(triplets[h][n]);
 
-                ibas_aba_sym[h][i][j][k] = count_aba;
+                ibas_aba_[(i*amo_+j)*amo_+k] = count_aba;
                 bas_aba_sym[h][count_aba][0]  = i;
                 bas_aba_sym[h][count_aba][1]  = j;
                 bas_aba_sym[h][count_aba][2]  = k;
@@ -729,8 +730,8 @@ void v2RDMSolver::BuildBasis() {
 
                 if ( i >= j ) continue;
 
-                ibas_aab_sym[h][i][j][k] = count_aab;
-                ibas_aab_sym[h][j][i][k] = count_aab;
+                ibas_aab_[(i*amo_+j)*amo_+k] = count_aab;
+                ibas_aab_[(j*amo_+i)*amo_+k] = count_aab;
                 bas_aab_sym[h][count_aab][0]  = i;
                 bas_aab_sym[h][count_aab][1]  = j;
                 bas_aab_sym[h][count_aab][2]  = k;
@@ -738,12 +739,12 @@ void v2RDMSolver::BuildBasis() {
 
                 if ( j >= k ) continue;
 
-                ibas_aaa_sym[h][i][j][k] = count_aaa;
-                ibas_aaa_sym[h][i][k][j] = count_aaa;
-                ibas_aaa_sym[h][j][i][k] = count_aaa;
-                ibas_aaa_sym[h][j][k][i] = count_aaa;
-                ibas_aaa_sym[h][k][i][j] = count_aaa;
-                ibas_aaa_sym[h][k][j][i] = count_aaa;
+                ibas_aaa_[(i*amo_+j)*amo_+k] = count_aaa;
+                ibas_aaa_[(i*amo_+k)*amo_+j] = count_aaa;
+                ibas_aaa_[(j*amo_+i)*amo_+k] = count_aaa;
+                ibas_aaa_[(j*amo_+k)*amo_+i] = count_aaa;
+                ibas_aaa_[(k*amo_+i)*amo_+j] = count_aaa;
+                ibas_aaa_[(k*amo_+j)*amo_+i] = count_aaa;
                 bas_aaa_sym[h][count_aaa][0]  = i;
                 bas_aaa_sym[h][count_aaa][1]  = j;
                 bas_aaa_sym[h][count_aaa][2]  = k;
@@ -129,6 +129,30 @@ extern "C" {
 inline void DSYEV(char&JOBZ,char&UPLO,integer&N,doublereal*A,integer&LDA,doublereal*W,doublereal*WORK,integer&LWORK,integer&INFO){
     dsyev(JOBZ,UPLO,N,A,LDA,W,WORK,LWORK,INFO);
 }
+/**
+ * name mangling dsyevr
+ */
+extern "C" {
+    void dsyevr(char&JOBZ,char&RANGE,char&UPLO,integer&N,doublereal*A,integer&LDA,doublereal&VL,doublereal&VU,
+         integer&IL,integer&IU,doublereal&ABSTOL,integer&M,doublereal*W,doublereal*Z,integer&LDZ,integer*ISUPPZ,
+         doublereal*WORK,integer&LWORK,integer*IWORK,integer&LIWORK,integer&INFO);
+};
+inline void DSYEVR(char&JOBZ,char&RANGE,char&UPLO,integer&N,doublereal*A,integer&LDA,doublereal&VL,doublereal&VU,
+         integer&IL,integer&IU,doublereal&ABSTOL,integer&M,doublereal*W,doublereal*Z,integer&LDZ,integer*ISUPPZ,
+         doublereal*WORK,integer&LWORK,integer*IWORK,integer&LIWORK,integer&INFO){
+    dsyevr(JOBZ,RANGE,UPLO,N,A,LDA,VL,VU,IL,IU,ABSTOL,M,W,Z,LDZ,ISUPPZ,WORK,LWORK,IWORK,LIWORK,INFO);
+}
+/**
+ * name mangling dsyrk
+ */
+extern "C" {
+    void dsyrk(char&UPLO,char&TRANS,integer&N,integer&K,doublereal&ALPHA,doublereal*A,integer&LDA,
+         doublereal&BETA,doublereal*C,integer&LDC);
+};
+inline void DSYRK(char&UPLO,char&TRANS,integer&N,integer&K,doublereal&ALPHA,doublereal*A,integer&LDA,
+         doublereal&BETA,doublereal*C,integer&LDC){
+    dsyrk(UPLO,TRANS,N,K,ALPHA,A,LDA,BETA,C,LDC);
+}
 /**
  * diagonalize a real symmetric packed matrix
  */
@@ -157,6 +181,34 @@ inline void DGESVD(char&JOBU,char&JOBVT,integer&M,integer&N,doublereal*A,integer
     dgesvd(JOBU,JOBVT,M,N,A,LDA,S,U,LDU,VT,LDVT,WORK,LWORK,INFO);
 }
 
+/**
+ * thread control for threaded blas/lapack (mkl or openblas).  the symbols
+ * are weak, so they are null if the linked library provides neither
+ */
+extern "C" {
+    void mkl_set_num_threads(int nthreads) __attribute__((weak));
+    int  mkl_get_max_threads(void) __attribute__((weak));
+    void openblas_set_num_threads(int nthreads) __attribute__((weak));
+    int  openblas_get_num_threads(void) __attribute__((weak));
+};
+/**
+ * set the number of blas/lapack threads.  returns the previous number, or 0
+ * if it could not be set (any other blas), in which case the caller can't
+ * assume that blas is single threaded.  call outside of parallel regions
+ * only.
+ */
+inline int SetBLASThreads(int nthreads){
+    int previous = 0;
+    if ( mkl_set_num_threads && mkl_get_max_threads ) {
+        previous = mkl_get_max_threads();
+        mkl_set_num_threads(nthreads);
+    }else if ( openblas_set_num_threads && openblas_get_num_threads ) {
+        previous = openblas_get_num_threads();
+        openblas_set_num_threads(nthreads);
+    }
+    return previous;
+}
+
 }}
 
 #endif
\ No newline at end of file
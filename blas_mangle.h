@@ -46,6 +46,8 @@
 #define dgesv  FC_GLOBAL(dgesv , DGESV)
 #define ddot   FC_GLOBAL(ddot  , DDOT)
 #define dsyev  FC_GLOBAL(dsyev , DSYEV)
+#define dsyevr FC_GLOBAL(dsyevr, DSYEVR)
+#define dsyrk  FC_GLOBAL(dsyrk , DSYRK)
 #define dspev  FC_GLOBAL(dspev , DSPEV)
 #define dgesvd FC_GLOBAL(dgesvd, DGESVD)
 #else // USE_FCMANGLE_H
@@ -58,6 +60,8 @@
 #define dgesv  dgesv_
 #define ddot   ddot_  
 #define dsyev  dsyev_ 
+#define dsyevr dsyevr_
+#define dsyrk  dsyrk_
 #define dspev  dspev_
 #define dgesvd dgesvd_
 #elif FC_SYMBOL==1
@@ -69,6 +73,8 @@
 #define dgesv  dgesv
 #define ddot   ddot 
 #define dsyev  dsyev
+#define dsyevr dsyevr
+#define dsyrk  dsyrk
 #define dspev  dspev
 #define dgesvd dgesvd
 #elif FC_SYMBOL==3
@@ -80,6 +86,8 @@
 #define dgesv  DGESV
 #define ddot   DDOT
 #define dsyev  DSYEV
+#define dsyevr DSYEVR
+#define dsyrk  DSYRK
 #define dspev  DSPEV
 #define dgesvd DGESVD
 #elif FC_SYMBOL==4
@@ -91,6 +99,8 @@
 #define dgesv  DGESV_
 #define ddot   DDOT_
 #define dsyev  DSYEV_
+#define dsyevr DSYEVR_
+#define dsyrk  DSYRK_
 #define dspev  DSPEV_
 #define dgesvd DGESVD_
 #endif // FC_SYMBOL
@@ -28,6 +28,7 @@
 #include<stdio.h>
 #include<stdlib.h>
 #include<math.h>
+#include<string.h>
 
 #include <psi4/libplugin/plugin.h>
 #include <psi4/psi4-dec.h>
@@ -36,11 +37,16 @@
 #include <psi4/libpsio/psio.hpp>
 //#include <../bin/fnocc/blas.h>
 #include <psi4/libqt/qt.h>
+#include <psi4/libmints/matrix.h>
 #include "cg_solver.h"
 
 
 namespace psi{ 
 
+void CGOperator::apply_sp(long int n, float * Ax, const float * x) {
+    throw PsiException("CGOperator: no single-precision product",__FILE__,__LINE__);
+}
+
 CGSolver::CGSolver(long int n) {
     n_              = n;
     iter_           = 0;
@@ -48,7 +54,10 @@ CGSolver::CGSolver(long int n) {
     cg_convergence_ = 1e-9;
     p = SharedVector(new Vector(n));
     r = SharedVector(new Vector(n));
-    //z = SharedVector(new Vector(n));
+    z = SharedVector(new Vector(n));
+    nrecycle_       = 0;
+    nw_             = 0;
+    nv_             = 0;
 }
 CGSolver::~CGSolver(){
 }
@@ -58,13 +67,49 @@ void CGSolver::set_max_iter(int iter) {
 void CGSolver::set_convergence(double conv) {
     cg_convergence_ = conv;
 }
+void CGSolver::set_recycle_dimension(int k) {
+    nrecycle_ = k;
+    nw_       = 0;
+    nv_       = 0;
+    W_.clear();
+    AW_.clear();
+    V_.clear();
+    AV_.clear();
+    Wnew_.clear();
+    AWnew_.clear();
+    for (int i = 0; i < nrecycle_; i++) {
+        W_.push_back(SharedVector(new Vector(n_)));
+        AW_.push_back(SharedVector(new Vector(n_)));
+        Wnew_.push_back(SharedVector(new Vector(n_)));
+        AWnew_.push_back(SharedVector(new Vector(n_)));
+    }
+    for (int i = 0; i < 2 * nrecycle_; i++) {
+        V_.push_back(SharedVector(new Vector(n_)));
+        AV_.push_back(SharedVector(new Vector(n_)));
+    }
+    Ap_old_ = nrecycle_ > 0 ? SharedVector(new Vector(n_)) : SharedVector();
+    mu_.assign(nrecycle_,0.0);
+
+    long int nz = 3 * nrecycle_;
+    rr_z_.assign(nz,(double*)NULL);
+    rr_az_.assign(nz,(double*)NULL);
+    rr_g_.assign(nz * nz,0.0);
+    rr_f_.assign(nz * nz,0.0);
+    rr_c_.assign(nz * nz,0.0);
+    rr_fc_.assign(nz * nz,0.0);
+    rr_h_.assign(nz * nz,0.0);
+    rr_lambda_.assign(nz,0.0);
+    rr_sigma_.assign(nz,0.0);
+    rr_work_.assign(3 * nz + 1,0.0);
+    rr_keep_.assign(nz,0);
+}
 
 void CGSolver::preconditioned_solve(long int n,
                     SharedVector Ap, 
                     SharedVector  x, 
                     SharedVector  b, 
                     SharedVector  precon, 
-                    CallbackType function, void * data) {
+                    CGOperator & A) {
 
     if ( n != n_ ) {
         throw PsiException("Warning: dimension does not match dimension from initialization",__FILE__,__LINE__);
@@ -77,8 +122,8 @@ void CGSolver::preconditioned_solve(long int n,
     double alpha = 0.0;
     double beta  = 0.0;
 
-    // call some function to evaluate A.x.  Result in Ap
-    function(n,Ap,x,data);
+    // evaluate A.x.  Result in Ap
+    A.apply(n,Ap,x);
 
     double * b_p      = b->pointer();
     double * x_p      = x->pointer();
@@ -94,8 +139,8 @@ void CGSolver::preconditioned_solve(long int n,
     iter_ = 0;
     do {
 
-        // call some function to evaluate A.p.  Result in Ap
-        function(n,Ap,p,data);
+        // evaluate A.p.  Result in Ap
+        A.apply(n,Ap,p);
 
         double rz  = C_DDOT(n_,r_p,1,z_p,1);
         double pap = C_DDOT(n_,p_p,1,Ap_p,1);
@@ -122,11 +167,22 @@ void CGSolver::preconditioned_solve(long int n,
     }while(iter_ < cg_max_iter_ );
 }
 
+// CG, deflated by the recycled subspace W if there is one (Saad, Yeung,
+// Erhel, and Guyomarc'h, SIAM J. Sci. Comput. 21, 1909 (2000)).  the initial
+// residual is made orthogonal to W, and the search directions are kept
+// A-orthogonal to W, so CG only sees the rest of the spectrum of A.
+//
+// the normalized residuals (the lanczos vectors of the deflated operator)
+// are collected in a window, V, which is compressed to its nrecycle_ lowest
+// ritz vectors whenever it fills, as in eigCG (Stathopoulos and Orginos,
+// SIAM J. Sci. Comput. 32, 439 (2010)).  A.r is obtained from A.p, so no
+// additional products with A are needed.  at the end, W is replaced by the
+// lowest ritz vectors in span(W,V).
 void CGSolver::solve(long int n,
                     SharedVector Ap, 
                     SharedVector  x, 
                     SharedVector  b, 
-                    CallbackType function, void * data) {
+                    CGOperator & A) {
 
     if ( n != n_ ) {
         throw PsiException("Warning: dimension does not match dimension from initialization",__FILE__,__LINE__);
@@ -138,8 +194,8 @@ void CGSolver::solve(long int n,
     double alpha = 0.0;
     double beta  = 0.0;
 
-    // call some function to evaluate A.x.  Result in Ap
-    function(n,Ap,x,data);
+    // evaluate A.x.  Result in Ap
+    A.apply(n,Ap,x);
 
     double * b_p  = b->pointer();
     double * x_p  = x->pointer();
@@ -148,17 +204,65 @@ void CGSolver::solve(long int n,
     for (int i = 0; i < n; i++) {
         r_p[i] = b_p[i] - Ap_p[i];
     }
+
+    // x += W.W^T.r, r -= A.W.W^T.r
+    for (int j = 0; j < nw_; j++) {
+        double c = C_DDOT(n_,W_[j]->pointer(),1,r_p,1);
+        C_DAXPY(n_,c,W_[j]->pointer(),1,x_p,1);
+        C_DAXPY(n_,-c,AW_[j]->pointer(),1,r_p,1);
+    }
+
+    // p = r - W.mu, mu = (AW)^T.r
     C_DCOPY(n,r_p,1,p_p,1);
+    for (int j = 0; j < nw_; j++) {
+        mu_[j] = C_DDOT(n_,AW_[j]->pointer(),1,r_p,1);
+        C_DAXPY(n_,-mu_[j],W_[j]->pointer(),1,p_p,1);
+    }
+
+    nv_ = 0;
+    double beta_old = 0.0;
 
     iter_ = 0;
     do {
 
-        // call some function to evaluate A.p.  Result in Ap
-        function(n,Ap,p,data);
+        // evaluate A.p.  Result in Ap
+        A.apply(n,Ap,p);
 
         double rr  = C_DDOT(n_,r_p,1,r_p,1);
         double pap = C_DDOT(n_,p_p,1,Ap_p,1);
         double alpha = rr / pap;
+
+        // v = r / |r| and A.v = ( A.p - beta_old A.p_old + A.W.mu ) / |r|
+        if ( nrecycle_ > 0 ) {
+            double * v_p  = V_[nv_]->pointer();
+            double * Av_p = AV_[nv_]->pointer();
+            double rnrm = sqrt(rr);
+            C_DCOPY(n_,r_p,1,v_p,1);
+            C_DCOPY(n_,Ap_p,1,Av_p,1);
+            C_DAXPY(n_,-beta_old,Ap_old_->pointer(),1,Av_p,1);
+            for (int j = 0; j < nw_; j++) {
+                C_DAXPY(n_,mu_[j],AW_[j]->pointer(),1,Av_p,1);
+            }
+            C_DSCAL(n_,1.0/rnrm,v_p,1);
+            C_DSCAL(n_,1.0/rnrm,Av_p,1);
+            C_DCOPY(n_,Ap_p,1,Ap_old_->pointer(),1);
+            nv_++;
+
+            // compress full window to its lowest ritz vectors
+            if ( nv_ == 2 * nrecycle_ ) {
+                for (int i = 0; i < nv_; i++) {
+                    rr_z_[i]  = V_[i]->pointer();
+                    rr_az_[i] = AV_[i]->pointer();
+                }
+                int nkeep = RayleighRitz(nv_);
+                for (int i = 0; i < nkeep; i++) {
+                    V_[i].swap(Wnew_[i]);
+                    AV_[i].swap(AWnew_[i]);
+                }
+                nv_ = nkeep;
+            }
+        }
+
         C_DAXPY(n_,alpha,p_p,1,x_p,1);
         C_DAXPY(n_,-alpha,Ap_p,1,r_p,1);
 
@@ -171,9 +275,349 @@ void CGSolver::solve(long int n,
         C_DSCAL(n_,beta,p_p,1);
         C_DAXPY(n_,1.0,r_p,1,p_p,1);
 
+        for (int j = 0; j < nw_; j++) {
+            mu_[j] = C_DDOT(n_,AW_[j]->pointer(),1,r_p,1);
+            C_DAXPY(n_,-mu_[j],W_[j]->pointer(),1,p_p,1);
+        }
+        beta_old = beta;
+
         iter_++;
 
     }while(iter_ < cg_max_iter_ );
+
+    // new recycled subspace from span(W,V)
+    if ( nrecycle_ > 0 ) {
+        for (int i = 0; i < nw_; i++) {
+            rr_z_[i]  = W_[i]->pointer();
+            rr_az_[i] = AW_[i]->pointer();
+        }
+        for (int i = 0; i < nv_; i++) {
+            rr_z_[nw_ + i]  = V_[i]->pointer();
+            rr_az_[nw_ + i] = AV_[i]->pointer();
+        }
+        int nkeep = RayleighRitz(nw_ + nv_);
+        for (int i = 0; i < nkeep; i++) {
+            W_[i].swap(Wnew_[i]);
+            AW_[i].swap(AWnew_[i]);
+        }
+        nw_ = nkeep;
+    }
+}
+
+// pipelined CG (Ghysels and Vanroose, Parallel Comput. 40, 224 (2014)).
+// with w = A.r, s = A.p, and z = A.s kept by recurrences, the dot products
+// (r,r) and (w,r) for the next iteration are available before the next
+// product with A (q = A.w), and all of the vector updates and both dot
+// products are fused into a single threaded pass over memory.
+//
+// the recurrence for r can drift from b - A.x, so when it is converged,
+// the true residual is evaluated, and the iterations are restarted from
+// it if necessary.
+void CGSolver::pipelined_solve(long int n,
+                    SharedVector Ap,
+                    SharedVector  x,
+                    SharedVector  b,
+                    CGOperator & A) {
+
+    if ( n != n_ ) {
+        throw PsiException("Warning: dimension does not match dimension from initialization",__FILE__,__LINE__);
+    }
+
+    if ( !w ) {
+        w = SharedVector(new Vector(n_));
+        s = SharedVector(new Vector(n_));
+    }
+
+    double * p_p = p->pointer();
+    double * r_p = r->pointer();
+    double * z_p = z->pointer();
+    double * w_p = w->pointer();
+    double * s_p = s->pointer();
+
+    double * b_p  = b->pointer();
+    double * x_p  = x->pointer();
+    double * q_p  = Ap->pointer();
+
+    iter_ = 0;
+    bool restart = true;
+
+    double gamma     = 0.0;
+    double delta     = 0.0;
+    double gamma_old = 0.0;
+    double alpha_old = 0.0;
+
+    do {
+
+        if ( restart ) {
+
+            // r = b - A.x, w = A.r
+            A.apply(n,Ap,x);
+            for (long int i = 0; i < n_; i++) {
+                r_p[i] = b_p[i] - q_p[i];
+            }
+            A.apply(n,w,r);
+
+            gamma = C_DDOT(n_,r_p,1,r_p,1);
+            delta = C_DDOT(n_,w_p,1,r_p,1);
+            if ( sqrt(gamma) < cg_convergence_ ) break;
+
+        }
+
+        // evaluate A.w.  Result in Ap (q)
+        A.apply(n,Ap,w);
+
+        double alpha;
+        double beta;
+        if ( restart ) {
+            beta  = 0.0;
+            alpha = gamma / delta;
+        }else {
+            beta  = gamma / gamma_old;
+            alpha = gamma / ( delta - beta * gamma / alpha_old );
+        }
+        restart = false;
+
+        // z = q + beta z, s = w + beta s, p = r + beta p,
+        // x += alpha p, r -= alpha s, w -= alpha z
+        double gamma_new = 0.0;
+        double delta_new = 0.0;
+        #pragma omp parallel for schedule (static) reduction(+:gamma_new,delta_new)
+        for (long int i = 0; i < n_; i++) {
+            double zi = q_p[i] + beta * z_p[i];
+            double si = w_p[i] + beta * s_p[i];
+            double pi = r_p[i] + beta * p_p[i];
+            double ri = r_p[i] - alpha * si;
+            double wi = w_p[i] - alpha * zi;
+            z_p[i]  = zi;
+            s_p[i]  = si;
+            p_p[i]  = pi;
+            x_p[i] += alpha * pi;
+            r_p[i]  = ri;
+            w_p[i]  = wi;
+            gamma_new += ri * ri;
+            delta_new += wi * ri;
+        }
+
+        gamma_old = gamma;
+        alpha_old = alpha;
+        gamma     = gamma_new;
+        delta     = delta_new;
+
+        iter_++;
+
+        // if r is sufficiently small, check the true residual
+        if ( sqrt(gamma) < cg_convergence_ ) restart = true;
+
+    }while(iter_ < cg_max_iter_ );
+}
+
+// mixed-precision CG.  each refinement step evaluates the residual,
+// r = b - A.x, in double precision and solves A.d = r with CG in single
+// precision (vectors and A), with dot products accumulated in double
+// precision.  single precision resolves about 1e-7 of the residual norm, so
+// each inner solution is only asked to reduce it by a factor of 1e-4, and x
+// is refined until the double-precision residual is converged.  if a
+// refinement step stalls, the rest of the solution is done by solve.
+void CGSolver::mixed_precision_solve(long int n,
+                    SharedVector Ap,
+                    SharedVector  x,
+                    SharedVector  b,
+                    CGOperator & A) {
+
+    if ( n != n_ ) {
+        throw PsiException("Warning: dimension does not match dimension from initialization",__FILE__,__LINE__);
+    }
+
+    if ( (long int)r_sp_.size() != n_ ) {
+        r_sp_.resize(n_);
+        p_sp_.resize(n_);
+        Ap_sp_.resize(n_);
+        d_sp_.resize(n_);
+    }
+
+    float * r_f  = r_sp_.data();
+    float * p_f  = p_sp_.data();
+    float * Ap_f = Ap_sp_.data();
+    float * d_f  = d_sp_.data();
+
+    double * r_p  = r->pointer();
+    double * b_p  = b->pointer();
+    double * x_p  = x->pointer();
+    double * Ap_p = Ap->pointer();
+
+    int total_iter = 0;
+    double nrm_old = 0.0;
+
+    for (int refine = 0; ; refine++) {
+
+        // r = b - A.x in double precision
+        A.apply(n,Ap,x);
+        double rr = 0.0;
+        #pragma omp parallel for schedule (static) reduction(+:rr)
+        for (long int i = 0; i < n_; i++) {
+            double ri = b_p[i] - Ap_p[i];
+            r_p[i] = ri;
+            rr += ri * ri;
+        }
+        double nrm = sqrt(rr);
+        if ( nrm < cg_convergence_ ) break;
+        if ( total_iter >= cg_max_iter_ ) break;
+
+        // stalled: finish in double precision
+        if ( refine > 0 && nrm > 0.5 * nrm_old ) {
+            int max_iter = cg_max_iter_;
+            cg_max_iter_ = max_iter - total_iter;
+            solve(n,Ap,x,b,A);
+            cg_max_iter_ = max_iter;
+            total_iter += iter_;
+            break;
+        }
+        nrm_old = nrm;
+
+        // A.d = r / |r| in single precision
+        double conv = cg_convergence_ / nrm;
+        if ( conv < 1e-4 ) conv = 1e-4;
+
+        double rr_f = 0.0;
+        #pragma omp parallel for schedule (static) reduction(+:rr_f)
+        for (long int i = 0; i < n_; i++) {
+            float ri = (float)( r_p[i] / nrm );
+            r_f[i] = ri;
+            p_f[i] = ri;
+            d_f[i] = 0.0f;
+            rr_f += (double)ri * ri;
+        }
+
+        do {
+
+            A.apply_sp(n,Ap_f,p_f);
+
+            double pap = 0.0;
+            #pragma omp parallel for schedule (static) reduction(+:pap)
+            for (long int i = 0; i < n_; i++) {
+                pap += (double)p_f[i] * Ap_f[i];
+            }
+            float alpha = (float)( rr_f / pap );
+
+            double rrnew = 0.0;
+            #pragma omp parallel for schedule (static) reduction(+:rrnew)
+            for (long int i = 0; i < n_; i++) {
+                d_f[i] += alpha * p_f[i];
+                float ri = r_f[i] - alpha * Ap_f[i];
+                r_f[i] = ri;
+                rrnew += (double)ri * ri;
+            }
+            float beta = (float)( rrnew / rr_f );
+            rr_f = rrnew;
+
+            total_iter++;
+
+            if ( sqrt(rr_f) < conv ) break;
+
+            #pragma omp parallel for schedule (static)
+            for (long int i = 0; i < n_; i++) {
+                p_f[i] = r_f[i] + beta * p_f[i];
+            }
+
+        }while( total_iter < cg_max_iter_ );
+
+        // x += |r| d
+        #pragma omp parallel for schedule (static)
+        for (long int i = 0; i < n_; i++) {
+            x_p[i] += nrm * d_f[i];
+        }
+    }
+
+    iter_ = total_iter;
+}
+
+// the ritz pairs of A in span(Z) solve G.v = theta F.v, with G = Z^T.A.Z and
+// F = Z^T.Z.  G is first reduced to the identity, which drops directions
+// that are (numerically) linearly dependent or in the null space of A.  the
+// (at most nrecycle_) ritz vectors with the smallest ritz values, normalized
+// so that Wnew^T.A.Wnew = 1, are placed in Wnew_ (and A times them in AWnew_).
+// all of the small matrices live in the rr_ workspace (see
+// set_recycle_dimension), with leading dimension nz or nc.
+int CGSolver::RayleighRitz(int nz) {
+
+    if ( nz == 0 ) return 0;
+
+    double ** Z  = rr_z_.data();
+    double ** AZ = rr_az_.data();
+    double * G_p = rr_g_.data();
+    double * F_p = rr_f_.data();
+    for (int i = 0; i < nz; i++) {
+        for (int j = i; j < nz; j++) {
+            double gij = 0.5 * ( C_DDOT(n_,Z[i],1,AZ[j],1) + C_DDOT(n_,Z[j],1,AZ[i],1) );
+            double fij = C_DDOT(n_,Z[i],1,Z[j],1);
+            G_p[i*nz+j] = G_p[j*nz+i] = gij;
+            F_p[i*nz+j] = F_p[j*nz+i] = fij;
+        }
+    }
+
+    // C = U.lambda^{-1/2}, so C^T.G.C = 1.  eigenvector k of G is row k
+    double * l_p = rr_lambda_.data();
+    int info = C_DSYEV('V','U',nz,G_p,nz,l_p,rr_work_.data(),(int)rr_work_.size());
+    if ( info != 0 ) return 0;
+
+    double lmax = l_p[nz-1];
+    int * keep = rr_keep_.data();
+    int nc = 0;
+    for (int i = 0; i < nz; i++) {
+        if ( l_p[i] > 1e-10 * lmax ) keep[nc++] = i;
+    }
+    if ( nc == 0 ) return 0;
+
+    double * C_p = rr_c_.data();
+    for (int i = 0; i < nz; i++) {
+        for (int k = 0; k < nc; k++) {
+            C_p[i*nc+k] = G_p[keep[k]*nz+i] / sqrt(l_p[keep[k]]);
+        }
+    }
+
+    // the smallest ritz values are the largest eigenvalues of C^T.F.C
+    double * FC_p = rr_fc_.data();
+    double * H_p  = rr_h_.data();
+    for (int i = 0; i < nz; i++) {
+        for (int l = 0; l < nc; l++) {
+            double dum = 0.0;
+            for (int j = 0; j < nz; j++) {
+                dum += F_p[i*nz+j] * C_p[j*nc+l];
+            }
+            FC_p[i*nc+l] = dum;
+        }
+    }
+    for (int k = 0; k < nc; k++) {
+        for (int l = 0; l < nc; l++) {
+            double dum = 0.0;
+            for (int i = 0; i < nz; i++) {
+                dum += C_p[i*nc+k] * FC_p[i*nc+l];
+            }
+            H_p[k*nc+l] = dum;
+        }
+    }
+    info = C_DSYEV('V','U',nc,H_p,nc,rr_sigma_.data(),rr_work_.data(),(int)rr_work_.size());
+    if ( info != 0 ) return 0;
+
+    // Wnew = Z.C.y and A.Wnew = A.Z.C.y for the largest sigma (y is row col
+    // of H)
+    int nkeep = nc < nrecycle_ ? nc : nrecycle_;
+    for (int k = 0; k < nkeep; k++) {
+        int col = nc - 1 - k;
+        double * w_p  = Wnew_[k]->pointer();
+        double * aw_p = AWnew_[k]->pointer();
+        memset((void*)w_p,'\0',n_*sizeof(double));
+        memset((void*)aw_p,'\0',n_*sizeof(double));
+        for (int i = 0; i < nz; i++) {
+            double dum = 0.0;
+            for (int l = 0; l < nc; l++) {
+                dum += C_p[i*nc+l] * H_p[col*nc+l];
+            }
+            C_DAXPY(n_,dum,Z[i],1,w_p,1);
+            C_DAXPY(n_,dum,AZ[i],1,aw_p,1);
+        }
+    }
+    return nkeep;
 }
 
 int CGSolver::total_iterations() {
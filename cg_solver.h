@@ -30,10 +30,22 @@
 
 #include<psi4/libmints/vector.h>
 
+#include<vector>
+
 
 namespace psi{ 
 
-typedef void (*CallbackType)(long int,SharedVector,SharedVector,void *);  
+/// a symmetric positive definite operator for CGSolver.  apply evaluates
+/// Ax = A.x; apply_sp is the same product in single precision, which only
+/// mixed_precision_solve needs.  the operator owns its workspace, so an
+/// operator built on the stack lets every solver below run without
+/// allocating
+class CGOperator {
+public:
+    virtual ~CGOperator() {}
+    virtual void apply(long int n, SharedVector Ax, SharedVector x) = 0;
+    virtual void apply_sp(long int n, float * Ax, const float * x);
+};
 
 class CGSolver {
 public:
@@ -45,17 +57,38 @@ public:
                SharedVector  x,
                SharedVector  b,
                SharedVector  precon,
-               CallbackType function, void * data);
+               CGOperator & A);
     void solve(long int n,
                SharedVector Ap,
                SharedVector  x,
                SharedVector  b,
-               CallbackType function, void * data);
+               CGOperator & A);
+
+    /// pipelined CG (Ghysels and Vanroose): one fused pass over the vectors
+    /// per iteration, and the dot products do not wait for A.p
+    void pipelined_solve(long int n,
+               SharedVector Ap,
+               SharedVector  x,
+               SharedVector  b,
+               CGOperator & A);
+
+    /// CG with A applied in single precision (A.apply_sp), within
+    /// iterative refinement in double precision (A.apply)
+    void mixed_precision_solve(long int n,
+               SharedVector Ap,
+               SharedVector  x,
+               SharedVector  b,
+               CGOperator & A);
 
     int total_iterations();
     void set_max_iter(int iter);
     void set_convergence(double conv);
 
+    /// keep (approximate) eigenvectors of the k smallest eigenvalues of A
+    /// between calls to solve and deflate them from later solves (deflated
+    /// CG).  A must be the same in every call.  k = 0 disables recycling.
+    void set_recycle_dimension(int k);
+
 private:
 
     int    n_;
@@ -66,6 +99,60 @@ private:
     SharedVector r;
     SharedVector z;
 
+    /// extra vectors for pipelined_solve (allocated on first use)
+    SharedVector w;
+    SharedVector s;
+
+    /// single-precision vectors for mixed_precision_solve (allocated on
+    /// first use)
+    std::vector<float> r_sp_;
+    std::vector<float> p_sp_;
+    std::vector<float> Ap_sp_;
+    std::vector<float> d_sp_;
+
+    /// recycled subspace: W^T.A.W = 1 (nw_ vectors, at most nrecycle_)
+    int nrecycle_;
+    int nw_;
+    std::vector<SharedVector> W_;
+    std::vector<SharedVector> AW_;
+
+    /// window of normalized residuals (and A times them) in the current
+    /// solve: nv_ of them, at most 2 * nrecycle_
+    int nv_;
+    std::vector<SharedVector> V_;
+    std::vector<SharedVector> AV_;
+
+    /// A.p from the previous iteration and the W components removed from p
+    SharedVector Ap_old_;
+    std::vector<double> mu_;
+
+    /// ritz vectors from RayleighRitz
+    std::vector<SharedVector> Wnew_;
+    std::vector<SharedVector> AWnew_;
+
+    /// rayleigh-ritz for A in span(Z), with Z the first nz vectors in rr_z_
+    /// (and A.Z in rr_az_): the lowest ritz vectors (at most nrecycle_, with
+    /// Wnew^T.A.Wnew = 1) go to Wnew_ and AWnew_.  returns the number of
+    /// ritz vectors
+    int RayleighRitz(int nz);
+
+    /// workspace for RayleighRitz, for up to 3 * nrecycle_ vectors (W and a
+    /// window that is not yet full, at the end of a solve): the vectors and
+    /// A times them, G = Z^T.A.Z (then its eigenvectors), F = Z^T.Z, C, F.C,
+    /// H = C^T.F.C (then its eigenvectors), the eigenvalues of G and H, and
+    /// the dsyev work array
+    std::vector<double*> rr_z_;
+    std::vector<double*> rr_az_;
+    std::vector<double> rr_g_;
+    std::vector<double> rr_f_;
+    std::vector<double> rr_c_;
+    std::vector<double> rr_fc_;
+    std::vector<double> rr_h_;
+    std::vector<double> rr_lambda_;
+    std::vector<double> rr_sigma_;
+    std::vector<double> rr_work_;
+    std::vector<int> rr_keep_;
+
 };
 
 } // end of namespace
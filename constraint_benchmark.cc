@@ -0,0 +1,295 @@
+/*
+ *@BEGIN LICENSE
+ *
+ * v2RDM-CASSCF, a plugin to:
+ *
+ * Psi4: an open-source quantum chemistry software package
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (c) 2014, The Florida State University. All rights reserved.
+ *
+ *@END LICENSE
+ *
+ */
+
+#include <psi4/psi4-dec.h>
+#include <psi4/liboptions/liboptions.h>
+#include <psi4/libqt/qt.h>
+
+#include<psi4/libtrans/integraltransform.h>
+#include<psi4/libtrans/mospace.h>
+
+#include<psi4/libmints/wavefunction.h>
+#include<psi4/libmints/vector.h>
+#include<psi4/libmints/matrix.h>
+#include<math.h>
+#include<time.h>
+
+#include<vector>
+
+#include"v2rdm_solver.h"
+
+#ifdef _OPENMP
+    #include<omp.h>
+#else
+    #define omp_get_wtime() ( (double)clock() / CLOCKS_PER_SEC )
+    #define omp_get_max_threads() 1
+    #define omp_set_num_threads(n)
+#endif
+
+using namespace psi;
+
+namespace psi{ namespace v2rdm_casscf{
+
+// verification and timings for the individual constraint mappings
+//
+// each family of constraints (D2, Q2, G2, T1, T2, D3) owns a contiguous
+// range of rows of A, starting at the offsets determined in common_init.
+// for each family, A.u and A^T.u are checked for adjointness,
+// <A.u,v> = <u,A^T.v>, with random u and with v nonzero only in the rows
+// of that family, and are then timed for 1, 2, 4, ... threads.  the fused
+// A.A^T.u used by the CG microiterations (bpsdp_AATu) is also compared to
+// bpsdp_Au(bpsdp_ATu(u)) with one thread and with all of them.
+
+// one family of constraints and its mappings
+struct ConstraintFamily {
+    const char * name;
+    long int rowoff;
+    long int nrow;
+    void (v2RDMSolver::*Au)(SharedVector,SharedVector);
+    void (v2RDMSolver::*ATu)(SharedVector,SharedVector);
+};
+
+void v2RDMSolver::BenchmarkConstraints() {
+
+    std::vector<ConstraintFamily> families;
+
+    ConstraintFamily d2 = {"D2",0,nconstraints_d2_,
+        &v2RDMSolver::D2_constraints_Au,&v2RDMSolver::D2_constraints_ATu};
+    families.push_back(d2);
+
+    if ( constrain_q2_ ) {
+        ConstraintFamily q2 = {"Q2",nconstraints_d2_,nconstraints_d2q2_ - nconstraints_d2_,
+            &v2RDMSolver::Q2_constraints_Au,&v2RDMSolver::Q2_constraints_ATu};
+        if ( spin_adapt_q2_ ) {
+            q2.name = "Q2 (spin adapted)";
+            q2.Au   = &v2RDMSolver::Q2_constraints_Au_spin_adapted;
+            q2.ATu  = &v2RDMSolver::Q2_constraints_ATu_spin_adapted;
+        }
+        families.push_back(q2);
+    }
+    if ( constrain_g2_ ) {
+        ConstraintFamily g2 = {"G2",nconstraints_d2q2_,nconstraints_d2q2g2_ - nconstraints_d2q2_,
+            &v2RDMSolver::G2_constraints_Au,&v2RDMSolver::G2_constraints_ATu};
+        if ( spin_adapt_g2_ ) {
+            g2.name = "G2 (spin adapted)";
+            g2.Au   = &v2RDMSolver::G2_constraints_Au_spin_adapted;
+            g2.ATu  = &v2RDMSolver::G2_constraints_ATu_spin_adapted;
+        }
+        families.push_back(g2);
+    }
+    if ( constrain_t1_ ) {
+        ConstraintFamily t1 = {"T1",nconstraints_d2q2g2_,nconstraints_d2q2g2t1_ - nconstraints_d2q2g2_,
+            &v2RDMSolver::T1_constraints_Au,&v2RDMSolver::T1_constraints_ATu};
+        families.push_back(t1);
+    }
+    if ( constrain_t2_ ) {
+        ConstraintFamily t2 = {"T2",nconstraints_d2q2g2t1_,nconstraints_d2q2g2t1t2_ - nconstraints_d2q2g2t1_,
+            &v2RDMSolver::T2_constraints_Au,&v2RDMSolver::T2_constraints_ATu};
+        families.push_back(t2);
+        ConstraintFamily t2_slow = {"T2 (slow)",nconstraints_d2q2g2t1_,nconstraints_d2q2g2t1t2_ - nconstraints_d2q2g2t1_,
+            &v2RDMSolver::T2_constraints_Au_slow,&v2RDMSolver::T2_constraints_ATu_slow};
+        families.push_back(t2_slow);
+    }
+    if ( constrain_d3_ ) {
+        ConstraintFamily d3 = {"D3",nconstraints_d2q2g2t1t2_,nconstraints_ - nconstraints_d2q2g2t1t2_,
+            &v2RDMSolver::D3_constraints_Au,&v2RDMSolver::D3_constraints_ATu};
+        families.push_back(d3);
+    }
+
+    SharedVector u   (new Vector("u",dimx_));
+    SharedVector v   (new Vector("v",nconstraints_));
+    SharedVector Au  (new Vector("Au",nconstraints_));
+    SharedVector ATv (new Vector("ATv",dimx_));
+
+    double * u_p   = u->pointer();
+    double * v_p   = v->pointer();
+    double * Au_p  = Au->pointer();
+    double * ATv_p = ATv->pointer();
+
+    srand(0);
+    for (long int i = 0; i < dimx_; i++) {
+        u_p[i] = ( (double)rand()/RAND_MAX - 0.5 ) * 2.0;
+    }
+
+    outfile->Printf("\n");
+    outfile->Printf("  ==> Constraint mappings: verification <==\n");
+    outfile->Printf("\n");
+    outfile->Printf("        number of primal variables: %12li\n",dimx_);
+    outfile->Printf("        number of constraints:      %12li\n",nconstraints_);
+    outfile->Printf("\n");
+    outfile->Printf("        %-20s %12s %20s %12s\n","family","rows","<A.u,v>","rel. error");
+
+    double max_error = 0.0;
+    for (int f = 0; f < families.size(); f++) {
+
+        ConstraintFamily & fam = families[f];
+
+        // v is nonzero only in the rows of this family
+        memset((void*)v_p,'\0',nconstraints_*sizeof(double));
+        for (long int i = fam.rowoff; i < fam.rowoff + fam.nrow; i++) {
+            v_p[i] = ( (double)rand()/RAND_MAX - 0.5 ) * 2.0;
+        }
+
+        memset((void*)Au_p,'\0',nconstraints_*sizeof(double));
+        memset((void*)ATv_p,'\0',dimx_*sizeof(double));
+
+        BenchmarkAu(fam.Au,fam.rowoff,Au,u);
+        offset = fam.rowoff;
+        (this->*fam.ATu)(ATv,v);
+
+        double left  = C_DDOT(fam.nrow,Au_p + fam.rowoff,1,v_p + fam.rowoff,1);
+        double right = C_DDOT(dimx_,u_p,1,ATv_p,1);
+
+        double scale = fabs(left) > 1.0 ? fabs(left) : 1.0;
+        double error = fabs(left - right) / scale;
+        if ( error > max_error ) max_error = error;
+
+        outfile->Printf("        %-20s %12li %20.12lf %12.3le\n",fam.name,fam.nrow,left,error);
+    }
+    outfile->Printf("\n");
+
+    Process::environment.globals["V2RDM CONSTRAINT ADJOINTNESS ERROR"] = max_error;
+
+    // fused A.A^T.u.  with T2 conditions, it requires the fast T2 mappings
+    // (see cg_Ax)
+    int max_threads  = omp_get_max_threads();
+    int atu_nthreads = ATu_nthreads_;
+    if ( !constrain_t2_ || fast_t2_ ) {
+
+        SharedVector AATv1 (new Vector("A.A^T.v",nconstraints_));
+        SharedVector AATv2 (new Vector("A.A^T.v",nconstraints_));
+        double * AATv1_p = AATv1->pointer();
+        double * AATv2_p = AATv2->pointer();
+
+        for (long int i = 0; i < nconstraints_; i++) {
+            v_p[i] = ( (double)rand()/RAND_MAX - 0.5 ) * 2.0;
+        }
+
+        outfile->Printf("        %-20s %8s %20s %12s\n","A.A^T.u","threads","","max. error");
+
+        double max_fused_error = 0.0;
+        int nthreads[2] = {1, max_threads};
+        for (int t = 0; t < ( max_threads > 1 ? 2 : 1 ); t++) {
+
+            omp_set_num_threads(nthreads[t]);
+            ATu_nthreads_ = nthreads[t] < atu_nthreads ? nthreads[t] : atu_nthreads;
+
+            bpsdp_ATu(ATv,v);
+            bpsdp_Au(AATv1,ATv);
+            bpsdp_AATu(AATv2,v);
+
+            double error = 0.0;
+            for (long int i = 0; i < nconstraints_; i++) {
+                double dum = fabs(AATv1_p[i] - AATv2_p[i]);
+                if ( dum > error ) error = dum;
+            }
+            if ( error > max_fused_error ) max_fused_error = error;
+
+            outfile->Printf("        %-20s %8i %20s %12.3le\n",t == 0 ? "fused/unfused" : "",nthreads[t],"",error);
+        }
+        outfile->Printf("\n");
+
+        omp_set_num_threads(max_threads);
+        ATu_nthreads_ = atu_nthreads;
+
+        Process::environment.globals["V2RDM FUSED AATU ERROR"] = max_fused_error;
+    }
+
+    // timings
+    int reps = options_.get_int("CONSTRAINT_BENCHMARK_REPETITIONS");
+
+    std::vector<int> threads;
+    for (int n = 1; n < max_threads; n *= 2) {
+        threads.push_back(n);
+    }
+    threads.push_back(max_threads);
+
+    outfile->Printf("  ==> Constraint mappings: timings <==\n");
+    outfile->Printf("\n");
+    outfile->Printf("        wall time (s) per call, average of %i calls\n",reps);
+    outfile->Printf("\n");
+    outfile->Printf("        %-20s %8s %12s %12s %10s %10s\n","family","threads","A.u","A^T.u","speedup","speedup");
+
+    for (int f = 0; f < families.size(); f++) {
+
+        ConstraintFamily & fam = families[f];
+
+        double t_Au_1  = 0.0;
+        double t_ATu_1 = 0.0;
+
+        for (int t = 0; t < threads.size(); t++) {
+
+            omp_set_num_threads(threads[t]);
+
+            // the T1/T2 parts of A^T.u use per-thread buffers, of which
+            // there are atu_nthreads
+            ATu_nthreads_ = threads[t] < atu_nthreads ? threads[t] : atu_nthreads;
+
+            double start = omp_get_wtime();
+            for (int r = 0; r < reps; r++) {
+                BenchmarkAu(fam.Au,fam.rowoff,Au,u);
+            }
+            double t_Au = ( omp_get_wtime() - start ) / reps;
+
+            start = omp_get_wtime();
+            for (int r = 0; r < reps; r++) {
+                offset = fam.rowoff;
+                (this->*fam.ATu)(ATv,v);
+            }
+            double t_ATu = ( omp_get_wtime() - start ) / reps;
+
+            if ( t == 0 ) {
+                t_Au_1  = t_Au;
+                t_ATu_1 = t_ATu;
+            }
+
+            outfile->Printf("        %-20s %8i %12.6lf %12.6lf %10.2lf %10.2lf\n",
+                t == 0 ? fam.name : "",threads[t],t_Au,t_ATu,t_Au_1/t_Au,t_ATu_1/t_ATu);
+        }
+    }
+    outfile->Printf("\n");
+
+    omp_set_num_threads(max_threads);
+    ATu_nthreads_ = atu_nthreads;
+    offset = nconstraints_;
+}
+
+// A.u for a single family of constraints.  the A.u mappings spawn tasks, so
+// they are called from within a parallel region, as in Au_tasks
+void v2RDMSolver::BenchmarkAu(ConstraintKernel Au, long int rowoff, SharedVector A, SharedVector u) {
+
+    #pragma omp parallel
+    {
+        #pragma omp single
+        {
+            offset = rowoff;
+            (this->*Au)(A,u);
+        }
+    }
+}
+
+}} // end namespaces
@@ -65,8 +65,8 @@ void v2RDMSolver::D2_constraints_ATu(SharedVector A,SharedVector u){
             for (int j = 0; j < amo_; j++){
                 int h = SymmetryPair(symmetry[i],symmetry[j]);
                 if ( gems_ab[h] == 0 ) continue;
-                int ij = ibas_ab_sym[h][i][j];
-                int ji = ibas_ab_sym[h][j][i];
+                int ij = ibas_ab(i,j);
+                int ji = ibas_ab(j,i);
                 A_p[d2aboff[h] + ij*gems_ab[h]+ji] += u_p[offset];
             }
         }
@@ -78,7 +78,7 @@ void v2RDMSolver::D2_constraints_ATu(SharedVector A,SharedVector u){
     for (int i = 0; i < amo_; i++){
         for (int j = 0; j < amo_; j++){
             int h = SymmetryPair(symmetry[i],symmetry[j]);
-            int ij = ibas_ab_sym[h][i][j];
+            int ij = ibas_ab(i,j);
             if ( gems_ab[h] == 0 ) continue;
             A_p[d2aboff[h] + ij*gems_ab[h]+ij] += u_p[offset];
         }
@@ -91,7 +91,7 @@ void v2RDMSolver::D2_constraints_ATu(SharedVector A,SharedVector u){
             if ( i==j ) continue;
             int h = SymmetryPair(symmetry[i],symmetry[j]);
             if ( gems_aa[h] == 0 ) continue;
-            int ij = ibas_aa_sym[h][i][j];
+            int ij = ibas_aa(i,j);
             A_p[d2aaoff[h]+ij*gems_aa[h]+ij] += u_p[offset];
         }
     }
@@ -102,7 +102,7 @@ void v2RDMSolver::D2_constraints_ATu(SharedVector A,SharedVector u){
             if ( i==j ) continue;
             int h = SymmetryPair(symmetry[i],symmetry[j]);
             if ( gems_aa[h] == 0 ) continue;
-            int ij = ibas_aa_sym[h][i][j];
+            int ij = ibas_aa(i,j);
             A_p[d2bboff[h]+ij*gems_aa[h]+ij] += u_p[offset];
         }
     }
@@ -147,8 +147,8 @@ void v2RDMSolver::D2_constraints_ATu(SharedVector A,SharedVector u){
                 int jj = j + poff;
                 for (int k = 0; k < amo_; k++){
                     int h2  = SymmetryPair(symmetry[ii],symmetry[k]);
-                    int ik = ibas_ab_sym[h2][ii][k];
-                    int jk = ibas_ab_sym[h2][jj][k];
+                    int ik = ibas_ab(ii,k);
+                    int jk = ibas_ab(jj,k);
                     A_p[d2aboff[h2] + ik*gems_ab[h2]+jk] -= u_p[offset + i*amopi_[h]+j];
                 }
             }
@@ -167,8 +167,8 @@ void v2RDMSolver::D2_constraints_ATu(SharedVector A,SharedVector u){
                 int jj = j + poff;
                 for(int k = 0; k < amo_; k++){
                     int h2  = SymmetryPair(symmetry[ii],symmetry[k]);
-                    int ik = ibas_ab_sym[h2][k][ii];
-                    int jk = ibas_ab_sym[h2][k][jj];
+                    int ik = ibas_ab(k,ii);
+                    int jk = ibas_ab(k,jj);
                     A_p[d2aboff[h2] + ik*gems_ab[h2]+jk] -= u_p[offset + i*amopi_[h]+j];
                 }
             }
@@ -188,8 +188,8 @@ void v2RDMSolver::D2_constraints_ATu(SharedVector A,SharedVector u){
                 for(int k =0; k < amo_; k++){
                     if( ii==k || jj==k )continue;
                     int h2  = SymmetryPair(symmetry[ii],symmetry[k]);
-                    int ik = ibas_aa_sym[h2][ii][k];
-                    int jk = ibas_aa_sym[h2][jj][k];
+                    int ik = ibas_aa(ii,k);
+                    int jk = ibas_aa(jj,k);
                     int sik = ( ii < k ? 1 : -1);
                     int sjk = ( jj < k ? 1 : -1);
                     A_p[d2aaoff[h2] + ik*gems_aa[h2]+jk] -= sik*sjk*u_p[offset + i*amopi_[h]+j];
@@ -211,8 +211,8 @@ void v2RDMSolver::D2_constraints_ATu(SharedVector A,SharedVector u){
                 for(int k =0; k < amo_; k++){
                     if( ii==k || jj==k )continue;
                     int h2  = SymmetryPair(symmetry[ii],symmetry[k]);
-                    int ik = ibas_aa_sym[h2][ii][k];
-                    int jk = ibas_aa_sym[h2][jj][k];
+                    int ik = ibas_aa(ii,k);
+                    int jk = ibas_aa(jj,k);
                     int sik = ( ii < k ? 1 : -1);
                     int sjk = ( jj < k ? 1 : -1);
                     A_p[d2bboff[h2] + ik*gems_aa[h2]+jk] -= sik*sjk*u_p[offset + i*amopi_[h]+j];
@@ -226,17 +226,19 @@ void v2RDMSolver::D2_constraints_ATu(SharedVector A,SharedVector u){
 
     // additional spin constraints for singlets:
     if ( constrain_spin_ && nalpha_ == nbeta_ ) {
-        // D1a = D1b
-        for ( int h = 0; h < nirrep_; h++) {
-            C_DAXPY(amopi_[h]*amopi_[h], 1.0, u_p + offset, 1, A_p + d1aoff[h],1);
-            C_DAXPY(amopi_[h]*amopi_[h],-1.0, u_p + offset, 1, A_p + d1boff[h],1);
-            offset += amopi_[h]*amopi_[h];
-        }
-        // D2aa = D2bb
-        for ( int h = 0; h < nirrep_; h++) {
-            C_DAXPY(gems_aa[h]*gems_aa[h], 1.0, u_p + offset, 1, A_p + d2aaoff[h],1);
-            C_DAXPY(gems_aa[h]*gems_aa[h],-1.0, u_p + offset, 1, A_p + d2bboff[h],1);
-            offset += gems_aa[h]*gems_aa[h];
+        if ( !spin_restricted_ ) {
+            // D1a = D1b
+            for ( int h = 0; h < nirrep_; h++) {
+                C_DAXPY(amopi_[h]*amopi_[h], 1.0, u_p + offset, 1, A_p + d1aoff[h],1);
+                C_DAXPY(amopi_[h]*amopi_[h],-1.0, u_p + offset, 1, A_p + d1boff[h],1);
+                offset += amopi_[h]*amopi_[h];
+            }
+            // D2aa = D2bb
+            for ( int h = 0; h < nirrep_; h++) {
+                C_DAXPY(gems_aa[h]*gems_aa[h], 1.0, u_p + offset, 1, A_p + d2aaoff[h],1);
+                C_DAXPY(gems_aa[h]*gems_aa[h],-1.0, u_p + offset, 1, A_p + d2bboff[h],1);
+                offset += gems_aa[h]*gems_aa[h];
+            }
         }
         // D2aa[pq][rs] = 1/2(D2ab[pq][rs] - D2ab[pq][sr] - D2ab[qp][rs] + D2ab[qp][sr])
         for ( int h = 0; h < nirrep_; h++) {
@@ -244,13 +246,13 @@ void v2RDMSolver::D2_constraints_ATu(SharedVector A,SharedVector u){
             for (int ij = 0; ij < gems_aa[h]; ij++) {
                 int i = bas_aa_sym[h][ij][0]; 
                 int j = bas_aa_sym[h][ij][1];
-                int ijb = ibas_ab_sym[h][i][j];
-                int jib = ibas_ab_sym[h][j][i];
+                int ijb = ibas_ab(i,j);
+                int jib = ibas_ab(j,i);
                 for (int kl = 0; kl < gems_aa[h]; kl++) {
                     int k = bas_aa_sym[h][kl][0]; 
                     int l = bas_aa_sym[h][kl][1];
-                    int klb = ibas_ab_sym[h][k][l];
-                    int lkb = ibas_ab_sym[h][l][k];
+                    int klb = ibas_ab(k,l);
+                    int lkb = ibas_ab(l,k);
                     A_p[d2aboff[h] + ijb*gems_ab[h] + klb] -= 0.5 * u_p[offset + ij*gems_aa[h] + kl];
                     A_p[d2aboff[h] + jib*gems_ab[h] + klb] += 0.5 * u_p[offset + ij*gems_aa[h] + kl];
                     A_p[d2aboff[h] + ijb*gems_ab[h] + lkb] += 0.5 * u_p[offset + ij*gems_aa[h] + kl];
@@ -265,13 +267,13 @@ void v2RDMSolver::D2_constraints_ATu(SharedVector A,SharedVector u){
             for (int ij = 0; ij < gems_aa[h]; ij++) {
                 int i = bas_aa_sym[h][ij][0];
                 int j = bas_aa_sym[h][ij][1];
-                int ijb = ibas_ab_sym[h][i][j];
-                int jib = ibas_ab_sym[h][j][i];
+                int ijb = ibas_ab(i,j);
+                int jib = ibas_ab(j,i);
                 for (int kl = 0; kl < gems_aa[h]; kl++) {
                     int k = bas_aa_sym[h][kl][0];
                     int l = bas_aa_sym[h][kl][1];
-                    int klb = ibas_ab_sym[h][k][l];
-                    int lkb = ibas_ab_sym[h][l][k];
+                    int klb = ibas_ab(k,l);
+                    int lkb = ibas_ab(l,k);
                     A_p[d2aboff[h] + ijb*gems_ab[h] + klb] -= 0.5 * u_p[offset + ij*gems_aa[h] + kl];
                     A_p[d2aboff[h] + jib*gems_ab[h] + klb] += 0.5 * u_p[offset + ij*gems_aa[h] + kl];
                     A_p[d2aboff[h] + ijb*gems_ab[h] + lkb] += 0.5 * u_p[offset + ij*gems_aa[h] + kl];
@@ -286,12 +288,12 @@ void v2RDMSolver::D2_constraints_ATu(SharedVector A,SharedVector u){
             for (int ij = 0; ij < gems_ab[h]; ij++) {
                 int i = bas_ab_sym[h][ij][0];
                 int j = bas_ab_sym[h][ij][1];
-                int ji = ibas_ab_sym[h][j][i];
+                int ji = ibas_ab(j,i);
                 double dij = ( i == j ) ? sqrt(2.0) : 1.0;
                 for (int kl = 0; kl < gems_ab[h]; kl++) {
                     int k = bas_ab_sym[h][kl][0];
                     int l = bas_ab_sym[h][kl][1];
-                    int lk = ibas_ab_sym[h][l][k];
+                    int lk = ibas_ab(l,k);
                     double dkl = ( k == l ) ? sqrt(2.0) : 1.0;
                     A_p[d2aboff[h] + ij*gems_ab[h] + kl] -= 0.5 / ( dij * dkl ) * u_p[offset + ij*gems_ab[h] + kl];
                     A_p[d2aboff[h] + ji*gems_ab[h] + kl] -= 0.5 / ( dij * dkl ) * u_p[offset + ij*gems_ab[h] + kl];
@@ -308,12 +310,12 @@ void v2RDMSolver::D2_constraints_ATu(SharedVector A,SharedVector u){
             for (int ij = 0; ij < gems_ab[h]; ij++) {
                 int i = bas_ab_sym[h][ij][0];
                 int j = bas_ab_sym[h][ij][1];
-                int ji = ibas_ab_sym[h][j][i];
+                int ji = ibas_ab(j,i);
                 double dij = ( i == j ) ? sqrt(2.0) : 1.0;
                 for (int kl = 0; kl < gems_ab[h]; kl++) {
                     int k = bas_ab_sym[h][kl][0];
                     int l = bas_ab_sym[h][kl][1];
-                    int lk = ibas_ab_sym[h][l][k];
+                    int lk = ibas_ab(l,k);
                     double dkl = ( k == l ) ? sqrt(2.0) : 1.0;
                     A_p[d200off[h] + ij*2*gems_ab[h] + kl] += u_p[offset + ij*2*gems_ab[h] + kl];
                     A_p[d2aboff[h] + ij*gems_ab[h] + kl] -= 0.5 / ( dij * dkl ) * u_p[offset + ij*2*gems_ab[h] + kl];
@@ -326,12 +328,12 @@ void v2RDMSolver::D2_constraints_ATu(SharedVector A,SharedVector u){
             for (int ij = 0; ij < gems_ab[h]; ij++) {
                 int i = bas_ab_sym[h][ij][0];
                 int j = bas_ab_sym[h][ij][1];
-                int ji = ibas_ab_sym[h][j][i];
+                int ji = ibas_ab(j,i);
                 double dij = ( i == j ) ? sqrt(2.0) : 1.0;
                 for (int kl = 0; kl < gems_ab[h]; kl++) {
                     int k = bas_ab_sym[h][kl][0];
                     int l = bas_ab_sym[h][kl][1];
-                    int lk = ibas_ab_sym[h][l][k];
+                    int lk = ibas_ab(l,k);
                     A_p[d200off[h] + (ij)*2*gems_ab[h] + (kl+gems_ab[h])] += u_p[offset + (ij)*2*gems_ab[h] + (kl+gems_ab[h])];
                     A_p[d2aboff[h] + ij*gems_ab[h] + kl] -= 0.5 / dij * u_p[offset + (ij)*2*gems_ab[h] + (kl+gems_ab[h])];
                     A_p[d2aboff[h] + ij*gems_ab[h] + lk] += 0.5 / dij * u_p[offset + (ij)*2*gems_ab[h] + (kl+gems_ab[h])];
@@ -343,11 +345,11 @@ void v2RDMSolver::D2_constraints_ATu(SharedVector A,SharedVector u){
             for (int ij = 0; ij < gems_ab[h]; ij++) {
                 int i = bas_ab_sym[h][ij][0];
                 int j = bas_ab_sym[h][ij][1];
-                int ji = ibas_ab_sym[h][j][i];
+                int ji = ibas_ab(j,i);
                 for (int kl = 0; kl < gems_ab[h]; kl++) {
                     int k = bas_ab_sym[h][kl][0];
                     int l = bas_ab_sym[h][kl][1];
-                    int lk = ibas_ab_sym[h][l][k];
+                    int lk = ibas_ab(l,k);
                     double dkl = ( k == l ) ? sqrt(2.0) : 1.0;
                     A_p[d200off[h] + (ij+gems_ab[h])*2*gems_ab[h] + (kl)] += u_p[offset + (ij+gems_ab[h])*2*gems_ab[h] + (kl)];
                     A_p[d2aboff[h] + ij*gems_ab[h] + kl] -= 0.5 / dkl * u_p[offset + (ij+gems_ab[h])*2*gems_ab[h] + (kl)];
@@ -360,11 +362,11 @@ void v2RDMSolver::D2_constraints_ATu(SharedVector A,SharedVector u){
             for (int ij = 0; ij < gems_ab[h]; ij++) {
                 int i = bas_ab_sym[h][ij][0];
                 int j = bas_ab_sym[h][ij][1];
-                int ji = ibas_ab_sym[h][j][i];
+                int ji = ibas_ab(j,i);
                 for (int kl = 0; kl < gems_ab[h]; kl++) {
                     int k = bas_ab_sym[h][kl][0];
                     int l = bas_ab_sym[h][kl][1];
-                    int lk = ibas_ab_sym[h][l][k];
+                    int lk = ibas_ab(l,k);
                     A_p[d200off[h] + (ij+gems_ab[h])*2*gems_ab[h] + (kl+gems_ab[h])] += u_p[offset + (ij+gems_ab[h])*2*gems_ab[h] + (kl+gems_ab[h])];
                     A_p[d2aboff[h] + ij*gems_ab[h] + kl] -= 0.5 * u_p[offset + (ij+gems_ab[h])*2*gems_ab[h] + (kl+gems_ab[h])];
                     A_p[d2aboff[h] + ji*gems_ab[h] + kl] += 0.5 * u_p[offset + (ij+gems_ab[h])*2*gems_ab[h] + (kl+gems_ab[h])];
@@ -391,8 +393,8 @@ void v2RDMSolver::D2_constraints_Au(SharedVector A,SharedVector u){
             for (int j = 0; j < amo_; j++){
                 int h = SymmetryPair(symmetry[i],symmetry[j]);
                 if ( gems_ab[h] == 0 ) continue;
-                int ij = ibas_ab_sym[h][i][j];
-                int ji = ibas_ab_sym[h][j][i];
+                int ij = ibas_ab(i,j);
+                int ji = ibas_ab(j,i);
                 s2 += u_p[d2aboff[h] + ij*gems_ab[h]+ji];
             }
         }
@@ -407,7 +409,7 @@ void v2RDMSolver::D2_constraints_Au(SharedVector A,SharedVector u){
         for (int j = 0; j < amo_; j++){
             int h = SymmetryPair(symmetry[i],symmetry[j]);
             if ( gems_ab[h] == 0 ) continue;
-            int ij = ibas_ab_sym[h][i][j];
+            int ij = ibas_ab(i,j);
             sumab += u_p[d2aboff[h] + ij*gems_ab[h]+ij];
         }
     }
@@ -421,7 +423,7 @@ void v2RDMSolver::D2_constraints_Au(SharedVector A,SharedVector u){
             if ( i==j ) continue;
             int h = SymmetryPair(symmetry[i],symmetry[j]);
             if ( gems_aa[h] == 0 ) continue;
-            int ij = ibas_aa_sym[h][i][j];
+            int ij = ibas_aa(i,j);
             sumaa += u_p[d2aaoff[h] + ij*gems_aa[h]+ij];
         }
 
@@ -436,7 +438,7 @@ void v2RDMSolver::D2_constraints_Au(SharedVector A,SharedVector u){
             if ( i==j ) continue;
             int h = SymmetryPair(symmetry[i],symmetry[j]);
             if ( gems_aa[h] == 0 ) continue;
-            int ij = ibas_aa_sym[h][i][j];
+            int ij = ibas_aa(i,j);
             sumbb += u_p[d2bboff[h] + ij*gems_aa[h]+ij];
         }
 
@@ -446,9 +448,13 @@ void v2RDMSolver::D2_constraints_Au(SharedVector A,SharedVector u){
 
     // d1 / q1 a
     for (int h = 0; h < nirrep_; h++) {
-        for(int i = 0; i < amopi_[h]; i++){
-            for(int j = 0; j < amopi_[h]; j++){
-                A_p[offset+i*amopi_[h]+j] = u_p[d1aoff[h]+j*amopi_[h]+i] + u_p[q1aoff[h]+i*amopi_[h]+j];
+        long int myoffset = offset;
+        #pragma omp task
+        {
+            for(int i = 0; i < amopi_[h]; i++){
+                for(int j = 0; j < amopi_[h]; j++){
+                    A_p[myoffset+i*amopi_[h]+j] = u_p[d1aoff[h]+j*amopi_[h]+i] + u_p[q1aoff[h]+i*amopi_[h]+j];
+                }
             }
         }
         offset += amopi_[h]*amopi_[h];
@@ -456,9 +462,13 @@ void v2RDMSolver::D2_constraints_Au(SharedVector A,SharedVector u){
 
     // d1 / q1 b
     for (int h = 0; h < nirrep_; h++) {
-        for(int i = 0; i < amopi_[h]; i++){
-            for(int j = 0; j < amopi_[h]; j++){
-                A_p[offset+i*amopi_[h]+j] = u_p[d1boff[h]+j*amopi_[h]+i] + u_p[q1boff[h]+i*amopi_[h]+j];
+        long int myoffset = offset;
+        #pragma omp task
+        {
+            for(int i = 0; i < amopi_[h]; i++){
+                for(int j = 0; j < amopi_[h]; j++){
+                    A_p[myoffset+i*amopi_[h]+j] = u_p[d1boff[h]+j*amopi_[h]+i] + u_p[q1boff[h]+i*amopi_[h]+j];
+                }
             }
         }
         offset += amopi_[h]*amopi_[h];
@@ -474,18 +484,22 @@ void v2RDMSolver::D2_constraints_Au(SharedVector A,SharedVector u){
     // contraction: D2ab -> D1 a
     poff = 0;
     for (int h = 0; h < nirrep_; h++) {
-        for (int i = 0; i < amopi_[h]; i++){
-            for (int j = 0; j < amopi_[h]; j++){
-                double sum = nb * u_p[d1aoff[h] + i*amopi_[h]+j];
-                int ii  = i + poff;
-                int jj  = j + poff;
-                for(int k = 0; k < amo_; k++){
-                    int h2  = SymmetryPair(symmetry[ii],symmetry[k]);
-                    int ik = ibas_ab_sym[h2][ii][k];
-                    int jk = ibas_ab_sym[h2][jj][k];
-                    sum -= u_p[d2aboff[h2] + ik*gems_ab[h2]+jk];
+        long int myoffset = offset;
+        #pragma omp task
+        {
+            for (int i = 0; i < amopi_[h]; i++){
+                for (int j = 0; j < amopi_[h]; j++){
+                    double sum = nb * u_p[d1aoff[h] + i*amopi_[h]+j];
+                    int ii  = i + poff;
+                    int jj  = j + poff;
+                    for(int k = 0; k < amo_; k++){
+                        int h2  = SymmetryPair(symmetry[ii],symmetry[k]);
+                        int ik = ibas_ab(ii,k);
+                        int jk = ibas_ab(jj,k);
+                        sum -= u_p[d2aboff[h2] + ik*gems_ab[h2]+jk];
+                    }
+                    A_p[myoffset + i*amopi_[h]+j] = sum;
                 }
-                A_p[offset + i*amopi_[h]+j] = sum;
             }
         }
         offset += amopi_[h]*amopi_[h];
@@ -495,18 +509,22 @@ void v2RDMSolver::D2_constraints_Au(SharedVector A,SharedVector u){
     // contraction: D2ab -> D1 b
     poff = 0;
     for (int h = 0; h < nirrep_; h++) {
-        for (int i = 0; i < amopi_[h]; i++){
-            for (int j = 0; j < amopi_[h]; j++){
-                double sum = na * u_p[d1boff[h] + i*amopi_[h]+j];
-                int ii  = i + poff;
-                int jj  = j + poff;
-                for(int k = 0; k < amo_; k++){
-                    int h2  = SymmetryPair(symmetry[ii],symmetry[k]);
-                    int ik = ibas_ab_sym[h2][k][ii];
-                    int jk = ibas_ab_sym[h2][k][jj];
-                    sum -= u_p[d2aboff[h2] + ik*gems_ab[h2]+jk];
+        long int myoffset = offset;
+        #pragma omp task
+        {
+            for (int i = 0; i < amopi_[h]; i++){
+                for (int j = 0; j < amopi_[h]; j++){
+                    double sum = na * u_p[d1boff[h] + i*amopi_[h]+j];
+                    int ii  = i + poff;
+                    int jj  = j + poff;
+                    for(int k = 0; k < amo_; k++){
+                        int h2  = SymmetryPair(symmetry[ii],symmetry[k]);
+                        int ik = ibas_ab(k,ii);
+                        int jk = ibas_ab(k,jj);
+                        sum -= u_p[d2aboff[h2] + ik*gems_ab[h2]+jk];
+                    }
+                    A_p[myoffset + i*amopi_[h]+j] = sum;
                 }
-                A_p[offset + i*amopi_[h]+j] = sum;
             }
         }
         offset += amopi_[h]*amopi_[h];
@@ -516,21 +534,25 @@ void v2RDMSolver::D2_constraints_Au(SharedVector A,SharedVector u){
     //contract D2aa -> D1 a
     poff = 0;
     for (int h = 0; h < nirrep_; h++) {
-        for (int i = 0; i < amopi_[h]; i++){
-            for (int j = 0; j < amopi_[h]; j++){
-                double sum = (na - 1.0) * u_p[d1aoff[h] + i*amopi_[h]+j];
-                int ii  = i + poff;
-                int jj  = j + poff;
-                for(int k = 0; k < amo_; k++){
-                    if( ii==k || jj==k ) continue;
-                    int h2   = SymmetryPair(symmetry[ii],symmetry[k]);
-                    int ik  = ibas_aa_sym[h2][ii][k];
-                    int jk  = ibas_aa_sym[h2][jj][k];
-                    int sik = ( ii < k ) ? 1 : -1;
-                    int sjk = ( jj < k ) ? 1 : -1;
-                    sum -= sik*sjk*u_p[d2aaoff[h2] + ik*gems_aa[h2]+jk];
+        long int myoffset = offset;
+        #pragma omp task
+        {
+            for (int i = 0; i < amopi_[h]; i++){
+                for (int j = 0; j < amopi_[h]; j++){
+                    double sum = (na - 1.0) * u_p[d1aoff[h] + i*amopi_[h]+j];
+                    int ii  = i + poff;
+                    int jj  = j + poff;
+                    for(int k = 0; k < amo_; k++){
+                        if( ii==k || jj==k ) continue;
+                        int h2   = SymmetryPair(symmetry[ii],symmetry[k]);
+                        int ik  = ibas_aa(ii,k);
+                        int jk  = ibas_aa(jj,k);
+                        int sik = ( ii < k ) ? 1 : -1;
+                        int sjk = ( jj < k ) ? 1 : -1;
+                        sum -= sik*sjk*u_p[d2aaoff[h2] + ik*gems_aa[h2]+jk];
+                    }
+                    A_p[myoffset+i*amopi_[h]+j] = sum;
                 }
-                A_p[offset+i*amopi_[h]+j] = sum;
             }
         }
         offset += amopi_[h]*amopi_[h];
@@ -540,21 +562,25 @@ void v2RDMSolver::D2_constraints_Au(SharedVector A,SharedVector u){
     //contract D2bb -> D1 b
     poff = 0;
     for (int h = 0; h < nirrep_; h++) {
-        for (int i = 0; i < amopi_[h]; i++){
-            for (int j = 0; j < amopi_[h]; j++){
-                double sum = (nb - 1.0) * u_p[d1boff[h] + i*amopi_[h]+j];
-                int ii  = i + poff;
-                int jj  = j + poff;
-                for(int k = 0; k < amo_; k++){
-                    if( ii==k || jj==k ) continue;
-                    int h2   = SymmetryPair(symmetry[ii],symmetry[k]);
-                    int ik  = ibas_aa_sym[h2][ii][k];
-                    int jk  = ibas_aa_sym[h2][jj][k];
-                    int sik = ( ii < k ) ? 1 : -1;
-                    int sjk = ( jj < k ) ? 1 : -1;
-                    sum -= sik*sjk*u_p[d2bboff[h2] + ik*gems_aa[h2]+jk];
+        long int myoffset = offset;
+        #pragma omp task
+        {
+            for (int i = 0; i < amopi_[h]; i++){
+                for (int j = 0; j < amopi_[h]; j++){
+                    double sum = (nb - 1.0) * u_p[d1boff[h] + i*amopi_[h]+j];
+                    int ii  = i + poff;
+                    int jj  = j + poff;
+                    for(int k = 0; k < amo_; k++){
+                        if( ii==k || jj==k ) continue;
+                        int h2   = SymmetryPair(symmetry[ii],symmetry[k]);
+                        int ik  = ibas_aa(ii,k);
+                        int jk  = ibas_aa(jj,k);
+                        int sik = ( ii < k ) ? 1 : -1;
+                        int sjk = ( jj < k ) ? 1 : -1;
+                        sum -= sik*sjk*u_p[d2bboff[h2] + ik*gems_aa[h2]+jk];
+                    }
+                    A_p[myoffset+i*amopi_[h]+j] = sum;
                 }
-                A_p[offset+i*amopi_[h]+j] = sum;
             }
         }
         offset += amopi_[h]*amopi_[h];
@@ -563,77 +589,99 @@ void v2RDMSolver::D2_constraints_Au(SharedVector A,SharedVector u){
 
     // additional spin constraints for singlets:
     if ( constrain_spin_ && nalpha_ == nbeta_ ) {
-        // D1a = D1b
-        for ( int h = 0; h < nirrep_; h++) {
-            C_DCOPY(amopi_[h]*amopi_[h],     u_p + d1aoff[h],1,A_p + offset,1);
-            C_DAXPY(amopi_[h]*amopi_[h],-1.0,u_p + d1boff[h],1,A_p + offset,1);
-            offset += amopi_[h]*amopi_[h]; 
-        }
-        // D2aa = D2bb
-        for ( int h = 0; h < nirrep_; h++) {
-            C_DCOPY(gems_aa[h]*gems_aa[h],     u_p + d2aaoff[h],1,A_p + offset,1);
-            C_DAXPY(gems_aa[h]*gems_aa[h],-1.0,u_p + d2bboff[h],1,A_p + offset,1);
-            offset += gems_aa[h]*gems_aa[h];
+        if ( !spin_restricted_ ) {
+            // D1a = D1b
+            for ( int h = 0; h < nirrep_; h++) {
+                long int myoffset = offset;
+                #pragma omp task
+                {
+                    C_DCOPY(amopi_[h]*amopi_[h],     u_p + d1aoff[h],1,A_p + myoffset,1);
+                    C_DAXPY(amopi_[h]*amopi_[h],-1.0,u_p + d1boff[h],1,A_p + myoffset,1);
+                }
+                offset += amopi_[h]*amopi_[h]; 
+            }
+            // D2aa = D2bb
+            for ( int h = 0; h < nirrep_; h++) {
+                long int myoffset = offset;
+                #pragma omp task
+                {
+                    C_DCOPY(gems_aa[h]*gems_aa[h],     u_p + d2aaoff[h],1,A_p + myoffset,1);
+                    C_DAXPY(gems_aa[h]*gems_aa[h],-1.0,u_p + d2bboff[h],1,A_p + myoffset,1);
+                }
+                offset += gems_aa[h]*gems_aa[h];
+            }
         }
         // D2aa[pq][rs] = 1/2(D2ab[pq][rs] - D2ab[pq][sr] - D2ab[qp][rs] + D2ab[qp][sr])
         for ( int h = 0; h < nirrep_; h++) {
-            C_DCOPY(gems_aa[h]*gems_aa[h],u_p + d2aaoff[h],1,A_p + offset,1);
-            for (int ij = 0; ij < gems_aa[h]; ij++) {
-                int i = bas_aa_sym[h][ij][0];
-                int j = bas_aa_sym[h][ij][1];
-                int ijb = ibas_ab_sym[h][i][j];
-                int jib = ibas_ab_sym[h][j][i];
-                for (int kl = 0; kl < gems_aa[h]; kl++) {
-                    int k = bas_aa_sym[h][kl][0];
-                    int l = bas_aa_sym[h][kl][1];
-                    int klb = ibas_ab_sym[h][k][l];
-                    int lkb = ibas_ab_sym[h][l][k];
-                    A_p[offset + ij*gems_aa[h] + kl] -= 0.5 * u_p[d2aboff[h] + ijb*gems_ab[h] + klb];
-                    A_p[offset + ij*gems_aa[h] + kl] += 0.5 * u_p[d2aboff[h] + jib*gems_ab[h] + klb];
-                    A_p[offset + ij*gems_aa[h] + kl] += 0.5 * u_p[d2aboff[h] + ijb*gems_ab[h] + lkb];
-                    A_p[offset + ij*gems_aa[h] + kl] -= 0.5 * u_p[d2aboff[h] + jib*gems_ab[h] + lkb];
+            long int myoffset = offset;
+            #pragma omp task
+            {
+                C_DCOPY(gems_aa[h]*gems_aa[h],u_p + d2aaoff[h],1,A_p + myoffset,1);
+                for (int ij = 0; ij < gems_aa[h]; ij++) {
+                    int i = bas_aa_sym[h][ij][0];
+                    int j = bas_aa_sym[h][ij][1];
+                    int ijb = ibas_ab(i,j);
+                    int jib = ibas_ab(j,i);
+                    for (int kl = 0; kl < gems_aa[h]; kl++) {
+                        int k = bas_aa_sym[h][kl][0];
+                        int l = bas_aa_sym[h][kl][1];
+                        int klb = ibas_ab(k,l);
+                        int lkb = ibas_ab(l,k);
+                        A_p[myoffset + ij*gems_aa[h] + kl] -= 0.5 * u_p[d2aboff[h] + ijb*gems_ab[h] + klb];
+                        A_p[myoffset + ij*gems_aa[h] + kl] += 0.5 * u_p[d2aboff[h] + jib*gems_ab[h] + klb];
+                        A_p[myoffset + ij*gems_aa[h] + kl] += 0.5 * u_p[d2aboff[h] + ijb*gems_ab[h] + lkb];
+                        A_p[myoffset + ij*gems_aa[h] + kl] -= 0.5 * u_p[d2aboff[h] + jib*gems_ab[h] + lkb];
+                    }
                 }
             }
             offset += gems_aa[h]*gems_aa[h];
         }
         // D2bb[pq][rs] = 1/2(D2ab[pq][rs] - D2ab[pq][sr] - D2ab[qp][rs] + D2ab[qp][sr])
         for ( int h = 0; h < nirrep_; h++) {
-            C_DCOPY(gems_aa[h]*gems_aa[h],u_p + d2bboff[h],1,A_p + offset,1);
-            for (int ij = 0; ij < gems_aa[h]; ij++) {
-                int i = bas_aa_sym[h][ij][0];
-                int j = bas_aa_sym[h][ij][1];
-                int ijb = ibas_ab_sym[h][i][j];
-                int jib = ibas_ab_sym[h][j][i];
-                for (int kl = 0; kl < gems_aa[h]; kl++) {
-                    int k = bas_aa_sym[h][kl][0];
-                    int l = bas_aa_sym[h][kl][1];
-                    int klb = ibas_ab_sym[h][k][l];
-                    int lkb = ibas_ab_sym[h][l][k];
-                    A_p[offset + ij*gems_aa[h] + kl] -= 0.5 * u_p[d2aboff[h] + ijb*gems_ab[h] + klb];
-                    A_p[offset + ij*gems_aa[h] + kl] += 0.5 * u_p[d2aboff[h] + jib*gems_ab[h] + klb];
-                    A_p[offset + ij*gems_aa[h] + kl] += 0.5 * u_p[d2aboff[h] + ijb*gems_ab[h] + lkb];
-                    A_p[offset + ij*gems_aa[h] + kl] -= 0.5 * u_p[d2aboff[h] + jib*gems_ab[h] + lkb];
+            long int myoffset = offset;
+            #pragma omp task
+            {
+                C_DCOPY(gems_aa[h]*gems_aa[h],u_p + d2bboff[h],1,A_p + myoffset,1);
+                for (int ij = 0; ij < gems_aa[h]; ij++) {
+                    int i = bas_aa_sym[h][ij][0];
+                    int j = bas_aa_sym[h][ij][1];
+                    int ijb = ibas_ab(i,j);
+                    int jib = ibas_ab(j,i);
+                    for (int kl = 0; kl < gems_aa[h]; kl++) {
+                        int k = bas_aa_sym[h][kl][0];
+                        int l = bas_aa_sym[h][kl][1];
+                        int klb = ibas_ab(k,l);
+                        int lkb = ibas_ab(l,k);
+                        A_p[myoffset + ij*gems_aa[h] + kl] -= 0.5 * u_p[d2aboff[h] + ijb*gems_ab[h] + klb];
+                        A_p[myoffset + ij*gems_aa[h] + kl] += 0.5 * u_p[d2aboff[h] + jib*gems_ab[h] + klb];
+                        A_p[myoffset + ij*gems_aa[h] + kl] += 0.5 * u_p[d2aboff[h] + ijb*gems_ab[h] + lkb];
+                        A_p[myoffset + ij*gems_aa[h] + kl] -= 0.5 * u_p[d2aboff[h] + jib*gems_ab[h] + lkb];
+                    }
                 }
             }
             offset += gems_aa[h]*gems_aa[h];
         }
         // D200 = 1/(2 sqrt(1+dpq)sqrt(1+drs)) ( D2ab[pq][rs] + D2ab[pq][sr] + D2ab[qp][rs] + D2ab[qp][sr] )
         for ( int h = 0; h < nirrep_; h++) {
-            C_DCOPY(gems_ab[h]*gems_ab[h],u_p + d200off[h],1,A_p + offset,1);
-            for (int ij = 0; ij < gems_ab[h]; ij++) {
-                int i = bas_ab_sym[h][ij][0];
-                int j = bas_ab_sym[h][ij][1];
-                int ji = ibas_ab_sym[h][j][i];
-                double dij = ( i == j ) ? sqrt(2.0) : 1.0;
-                for (int kl = 0; kl < gems_ab[h]; kl++) {
-                    int k = bas_ab_sym[h][kl][0];
-                    int l = bas_ab_sym[h][kl][1];
-                    int lk = ibas_ab_sym[h][l][k];
-                    double dkl = ( k == l ) ? sqrt(2.0) : 1.0;
-                    A_p[offset + ij*gems_ab[h] + kl] -= 0.5 / ( dij * dkl ) * u_p[d2aboff[h] + ij*gems_ab[h] + kl];
-                    A_p[offset + ij*gems_ab[h] + kl] -= 0.5 / ( dij * dkl ) * u_p[d2aboff[h] + ji*gems_ab[h] + kl];
-                    A_p[offset + ij*gems_ab[h] + kl] -= 0.5 / ( dij * dkl ) * u_p[d2aboff[h] + ij*gems_ab[h] + lk];
-                    A_p[offset + ij*gems_ab[h] + kl] -= 0.5 / ( dij * dkl ) * u_p[d2aboff[h] + ji*gems_ab[h] + lk];
+            long int myoffset = offset;
+            #pragma omp task
+            {
+                C_DCOPY(gems_ab[h]*gems_ab[h],u_p + d200off[h],1,A_p + myoffset,1);
+                for (int ij = 0; ij < gems_ab[h]; ij++) {
+                    int i = bas_ab_sym[h][ij][0];
+                    int j = bas_ab_sym[h][ij][1];
+                    int ji = ibas_ab(j,i);
+                    double dij = ( i == j ) ? sqrt(2.0) : 1.0;
+                    for (int kl = 0; kl < gems_ab[h]; kl++) {
+                        int k = bas_ab_sym[h][kl][0];
+                        int l = bas_ab_sym[h][kl][1];
+                        int lk = ibas_ab(l,k);
+                        double dkl = ( k == l ) ? sqrt(2.0) : 1.0;
+                        A_p[myoffset + ij*gems_ab[h] + kl] -= 0.5 / ( dij * dkl ) * u_p[d2aboff[h] + ij*gems_ab[h] + kl];
+                        A_p[myoffset + ij*gems_ab[h] + kl] -= 0.5 / ( dij * dkl ) * u_p[d2aboff[h] + ji*gems_ab[h] + kl];
+                        A_p[myoffset + ij*gems_ab[h] + kl] -= 0.5 / ( dij * dkl ) * u_p[d2aboff[h] + ij*gems_ab[h] + lk];
+                        A_p[myoffset + ij*gems_ab[h] + kl] -= 0.5 / ( dij * dkl ) * u_p[d2aboff[h] + ji*gems_ab[h] + lk];
+                    }
                 }
             }
             offset += gems_ab[h]*gems_ab[h];
@@ -641,72 +689,76 @@ void v2RDMSolver::D2_constraints_Au(SharedVector A,SharedVector u){
     }else if ( constrain_spin_ ) { // nonsinglets ... big block
 
         for ( int h = 0; h < nirrep_; h++) {
-            // D200
-            for (int ij = 0; ij < gems_ab[h]; ij++) {
-                int i = bas_ab_sym[h][ij][0];
-                int j = bas_ab_sym[h][ij][1];
-                int ji = ibas_ab_sym[h][j][i];
-                double dij = ( i == j ) ? sqrt(2.0) : 1.0;
-                for (int kl = 0; kl < gems_ab[h]; kl++) {
-                    int k = bas_ab_sym[h][kl][0];
-                    int l = bas_ab_sym[h][kl][1];
-                    int lk = ibas_ab_sym[h][l][k];
-                    double dkl = ( k == l ) ? sqrt(2.0) : 1.0;
-                    A_p[offset + ij*2*gems_ab[h] + kl] += u_p[d200off[h] + ij*2*gems_ab[h] + kl];
-                    A_p[offset + ij*2*gems_ab[h] + kl] -= 0.5 / ( dij * dkl ) * u_p[d2aboff[h] + ij*gems_ab[h] + kl];
-                    A_p[offset + ij*2*gems_ab[h] + kl] -= 0.5 / ( dij * dkl ) * u_p[d2aboff[h] + ji*gems_ab[h] + kl];
-                    A_p[offset + ij*2*gems_ab[h] + kl] -= 0.5 / ( dij * dkl ) * u_p[d2aboff[h] + ij*gems_ab[h] + lk];
-                    A_p[offset + ij*2*gems_ab[h] + kl] -= 0.5 / ( dij * dkl ) * u_p[d2aboff[h] + ji*gems_ab[h] + lk];
+            long int myoffset = offset;
+            #pragma omp task
+            {
+                // D200
+                for (int ij = 0; ij < gems_ab[h]; ij++) {
+                    int i = bas_ab_sym[h][ij][0];
+                    int j = bas_ab_sym[h][ij][1];
+                    int ji = ibas_ab(j,i);
+                    double dij = ( i == j ) ? sqrt(2.0) : 1.0;
+                    for (int kl = 0; kl < gems_ab[h]; kl++) {
+                        int k = bas_ab_sym[h][kl][0];
+                        int l = bas_ab_sym[h][kl][1];
+                        int lk = ibas_ab(l,k);
+                        double dkl = ( k == l ) ? sqrt(2.0) : 1.0;
+                        A_p[myoffset + ij*2*gems_ab[h] + kl] += u_p[d200off[h] + ij*2*gems_ab[h] + kl];
+                        A_p[myoffset + ij*2*gems_ab[h] + kl] -= 0.5 / ( dij * dkl ) * u_p[d2aboff[h] + ij*gems_ab[h] + kl];
+                        A_p[myoffset + ij*2*gems_ab[h] + kl] -= 0.5 / ( dij * dkl ) * u_p[d2aboff[h] + ji*gems_ab[h] + kl];
+                        A_p[myoffset + ij*2*gems_ab[h] + kl] -= 0.5 / ( dij * dkl ) * u_p[d2aboff[h] + ij*gems_ab[h] + lk];
+                        A_p[myoffset + ij*2*gems_ab[h] + kl] -= 0.5 / ( dij * dkl ) * u_p[d2aboff[h] + ji*gems_ab[h] + lk];
+                    }
                 }
-            }
-            // D201
-            for (int ij = 0; ij < gems_ab[h]; ij++) {
-                int i = bas_ab_sym[h][ij][0];
-                int j = bas_ab_sym[h][ij][1];
-                int ji = ibas_ab_sym[h][j][i];
-                double dij = ( i == j ) ? sqrt(2.0) : 1.0;
-                for (int kl = 0; kl < gems_ab[h]; kl++) {
-                    int k = bas_ab_sym[h][kl][0];
-                    int l = bas_ab_sym[h][kl][1];
-                    int lk = ibas_ab_sym[h][l][k];
-                    A_p[offset + (ij)*2*gems_ab[h] + (kl+gems_ab[h])] += u_p[d200off[h] + (ij)*2*gems_ab[h] + (kl+gems_ab[h])];
-                    A_p[offset + (ij)*2*gems_ab[h] + (kl+gems_ab[h])] -= 0.5 / dij * u_p[d2aboff[h] + ij*gems_ab[h] + kl];
-                    A_p[offset + (ij)*2*gems_ab[h] + (kl+gems_ab[h])] += 0.5 / dij * u_p[d2aboff[h] + ij*gems_ab[h] + lk];
-                    A_p[offset + (ij)*2*gems_ab[h] + (kl+gems_ab[h])] -= 0.5 / dij * u_p[d2aboff[h] + ji*gems_ab[h] + kl];
-                    A_p[offset + (ij)*2*gems_ab[h] + (kl+gems_ab[h])] += 0.5 / dij * u_p[d2aboff[h] + ji*gems_ab[h] + lk];
+                // D201
+                for (int ij = 0; ij < gems_ab[h]; ij++) {
+                    int i = bas_ab_sym[h][ij][0];
+                    int j = bas_ab_sym[h][ij][1];
+                    int ji = ibas_ab(j,i);
+                    double dij = ( i == j ) ? sqrt(2.0) : 1.0;
+                    for (int kl = 0; kl < gems_ab[h]; kl++) {
+                        int k = bas_ab_sym[h][kl][0];
+                        int l = bas_ab_sym[h][kl][1];
+                        int lk = ibas_ab(l,k);
+                        A_p[myoffset + (ij)*2*gems_ab[h] + (kl+gems_ab[h])] += u_p[d200off[h] + (ij)*2*gems_ab[h] + (kl+gems_ab[h])];
+                        A_p[myoffset + (ij)*2*gems_ab[h] + (kl+gems_ab[h])] -= 0.5 / dij * u_p[d2aboff[h] + ij*gems_ab[h] + kl];
+                        A_p[myoffset + (ij)*2*gems_ab[h] + (kl+gems_ab[h])] += 0.5 / dij * u_p[d2aboff[h] + ij*gems_ab[h] + lk];
+                        A_p[myoffset + (ij)*2*gems_ab[h] + (kl+gems_ab[h])] -= 0.5 / dij * u_p[d2aboff[h] + ji*gems_ab[h] + kl];
+                        A_p[myoffset + (ij)*2*gems_ab[h] + (kl+gems_ab[h])] += 0.5 / dij * u_p[d2aboff[h] + ji*gems_ab[h] + lk];
+                    }
                 }
-            }
-            // D210
-            for (int ij = 0; ij < gems_ab[h]; ij++) {
-                int i = bas_ab_sym[h][ij][0];
-                int j = bas_ab_sym[h][ij][1];
-                int ji = ibas_ab_sym[h][j][i];
-                for (int kl = 0; kl < gems_ab[h]; kl++) {
-                    int k = bas_ab_sym[h][kl][0];
-                    int l = bas_ab_sym[h][kl][1];
-                    int lk = ibas_ab_sym[h][l][k];
-                    double dkl = ( k == l ) ? sqrt(2.0) : 1.0;
-                    A_p[offset + (ij+gems_ab[h])*2*gems_ab[h] + (kl)] += u_p[d200off[h] + (ij+gems_ab[h])*2*gems_ab[h] + (kl)];
-                    A_p[offset + (ij+gems_ab[h])*2*gems_ab[h] + (kl)] -= 0.5 / dkl * u_p[d2aboff[h] + ij*gems_ab[h] + kl];
-                    A_p[offset + (ij+gems_ab[h])*2*gems_ab[h] + (kl)] -= 0.5 / dkl * u_p[d2aboff[h] + ij*gems_ab[h] + lk];
-                    A_p[offset + (ij+gems_ab[h])*2*gems_ab[h] + (kl)] += 0.5 / dkl * u_p[d2aboff[h] + ji*gems_ab[h] + kl];
-                    A_p[offset + (ij+gems_ab[h])*2*gems_ab[h] + (kl)] += 0.5 / dkl * u_p[d2aboff[h] + ji*gems_ab[h] + lk];
+                // D210
+                for (int ij = 0; ij < gems_ab[h]; ij++) {
+                    int i = bas_ab_sym[h][ij][0];
+                    int j = bas_ab_sym[h][ij][1];
+                    int ji = ibas_ab(j,i);
+                    for (int kl = 0; kl < gems_ab[h]; kl++) {
+                        int k = bas_ab_sym[h][kl][0];
+                        int l = bas_ab_sym[h][kl][1];
+                        int lk = ibas_ab(l,k);
+                        double dkl = ( k == l ) ? sqrt(2.0) : 1.0;
+                        A_p[myoffset + (ij+gems_ab[h])*2*gems_ab[h] + (kl)] += u_p[d200off[h] + (ij+gems_ab[h])*2*gems_ab[h] + (kl)];
+                        A_p[myoffset + (ij+gems_ab[h])*2*gems_ab[h] + (kl)] -= 0.5 / dkl * u_p[d2aboff[h] + ij*gems_ab[h] + kl];
+                        A_p[myoffset + (ij+gems_ab[h])*2*gems_ab[h] + (kl)] -= 0.5 / dkl * u_p[d2aboff[h] + ij*gems_ab[h] + lk];
+                        A_p[myoffset + (ij+gems_ab[h])*2*gems_ab[h] + (kl)] += 0.5 / dkl * u_p[d2aboff[h] + ji*gems_ab[h] + kl];
+                        A_p[myoffset + (ij+gems_ab[h])*2*gems_ab[h] + (kl)] += 0.5 / dkl * u_p[d2aboff[h] + ji*gems_ab[h] + lk];
+                    }
                 }
-            }
-            // D211
-            for (int ij = 0; ij < gems_ab[h]; ij++) {
-                int i = bas_ab_sym[h][ij][0];
-                int j = bas_ab_sym[h][ij][1];
-                int ji = ibas_ab_sym[h][j][i];
-                for (int kl = 0; kl < gems_ab[h]; kl++) {
-                    int k = bas_ab_sym[h][kl][0];
-                    int l = bas_ab_sym[h][kl][1];
-                    int lk = ibas_ab_sym[h][l][k];
-                    A_p[offset + (ij+gems_ab[h])*2*gems_ab[h] + (kl+gems_ab[h])] += u_p[d200off[h] + (ij+gems_ab[h])*2*gems_ab[h] + (kl+gems_ab[h])];
-                    A_p[offset + (ij+gems_ab[h])*2*gems_ab[h] + (kl+gems_ab[h])] -= 0.5 * u_p[d2aboff[h] + ij*gems_ab[h] + kl];
-                    A_p[offset + (ij+gems_ab[h])*2*gems_ab[h] + (kl+gems_ab[h])] += 0.5 * u_p[d2aboff[h] + ji*gems_ab[h] + kl];
-                    A_p[offset + (ij+gems_ab[h])*2*gems_ab[h] + (kl+gems_ab[h])] += 0.5 * u_p[d2aboff[h] + ij*gems_ab[h] + lk];
-                    A_p[offset + (ij+gems_ab[h])*2*gems_ab[h] + (kl+gems_ab[h])] -= 0.5 * u_p[d2aboff[h] + ji*gems_ab[h] + lk];
+                // D211
+                for (int ij = 0; ij < gems_ab[h]; ij++) {
+                    int i = bas_ab_sym[h][ij][0];
+                    int j = bas_ab_sym[h][ij][1];
+                    int ji = ibas_ab(j,i);
+                    for (int kl = 0; kl < gems_ab[h]; kl++) {
+                        int k = bas_ab_sym[h][kl][0];
+                        int l = bas_ab_sym[h][kl][1];
+                        int lk = ibas_ab(l,k);
+                        A_p[myoffset + (ij+gems_ab[h])*2*gems_ab[h] + (kl+gems_ab[h])] += u_p[d200off[h] + (ij+gems_ab[h])*2*gems_ab[h] + (kl+gems_ab[h])];
+                        A_p[myoffset + (ij+gems_ab[h])*2*gems_ab[h] + (kl+gems_ab[h])] -= 0.5 * u_p[d2aboff[h] + ij*gems_ab[h] + kl];
+                        A_p[myoffset + (ij+gems_ab[h])*2*gems_ab[h] + (kl+gems_ab[h])] += 0.5 * u_p[d2aboff[h] + ji*gems_ab[h] + kl];
+                        A_p[myoffset + (ij+gems_ab[h])*2*gems_ab[h] + (kl+gems_ab[h])] += 0.5 * u_p[d2aboff[h] + ij*gems_ab[h] + lk];
+                        A_p[myoffset + (ij+gems_ab[h])*2*gems_ab[h] + (kl+gems_ab[h])] -= 0.5 * u_p[d2aboff[h] + ji*gems_ab[h] + lk];
+                    }
                 }
             }
             offset += 4*gems_ab[h]*gems_ab[h];
@@ -65,7 +65,8 @@ void v2RDMSolver::D3_constraints_Au(SharedVector A,SharedVector u){
     // D3aaa -> D2aa
     if ( na > 2 ) {
         for ( int h = 0; h < nirrep_; h++) {
-            #pragma omp parallel for schedule (static)
+            long int myoffset = offset;
+            #pragma omp taskloop nogroup
             for ( int ij = 0; ij < gems_aa[h]; ij++) {
                 int i = bas_aa_sym[h][ij][0];
                 int j = bas_aa_sym[h][ij][1];
@@ -77,8 +78,8 @@ void v2RDMSolver::D3_constraints_Au(SharedVector A,SharedVector u){
                         if ( i == p || j == p ) continue;
                         if ( k == p || l == p ) continue;
                         int h2 = SymmetryPair(h,symmetry[p]);
-                        int ijp = ibas_aaa_sym[h2][i][j][p];
-                        int klp = ibas_aaa_sym[h2][k][l][p];
+                        int ijp = ibas_aaa(i,j,p);
+                        int klp = ibas_aaa(k,l,p);
                         int s = 1;
                         if ( p < i ) s = -s;
                         if ( p < j ) s = -s;
@@ -86,7 +87,7 @@ void v2RDMSolver::D3_constraints_Au(SharedVector A,SharedVector u){
                         if ( p < l ) s = -s;
                         dum -= s * u_p[d3aaaoff[h2] + ijp*trip_aaa[h2]+klp];
                     }
-                    A_p[offset + ij*gems_aa[h]+kl] = dum;
+                    A_p[myoffset + ij*gems_aa[h]+kl] = dum;
                 }
             }
             offset += gems_aa[h] * gems_aa[h];
@@ -95,7 +96,8 @@ void v2RDMSolver::D3_constraints_Au(SharedVector A,SharedVector u){
     if ( nb > 2 ) {
         // D3bbb -> D2bb
         for ( int h = 0; h < nirrep_; h++) {
-            #pragma omp parallel for schedule (static)
+            long int myoffset = offset;
+            #pragma omp taskloop nogroup
             for ( int ij = 0; ij < gems_aa[h]; ij++) {
                 int i = bas_aa_sym[h][ij][0];
                 int j = bas_aa_sym[h][ij][1];
@@ -107,8 +109,8 @@ void v2RDMSolver::D3_constraints_Au(SharedVector A,SharedVector u){
                         if ( i == p || j == p ) continue;
                         if ( k == p || l == p ) continue;
                         int h2 = SymmetryPair(h,symmetry[p]);
-                        int ijp = ibas_aaa_sym[h2][i][j][p];
-                        int klp = ibas_aaa_sym[h2][k][l][p];
+                        int ijp = ibas_aaa(i,j,p);
+                        int klp = ibas_aaa(k,l,p);
                         int s = 1;
                         if ( p < i ) s = -s;
                         if ( p < j ) s = -s;
@@ -116,7 +118,7 @@ void v2RDMSolver::D3_constraints_Au(SharedVector A,SharedVector u){
                         if ( p < l ) s = -s;
                         dum -= s * u_p[d3bbboff[h2] + ijp*trip_aaa[h2]+klp];
                     }
-                    A_p[offset + ij*gems_aa[h]+kl] = dum;
+                    A_p[myoffset + ij*gems_aa[h]+kl] = dum;
                 }
             }
             offset += gems_aa[h] * gems_aa[h];
@@ -124,7 +126,8 @@ void v2RDMSolver::D3_constraints_Au(SharedVector A,SharedVector u){
     }
     // D3aab -> D2aa
     for ( int h = 0; h < nirrep_; h++) {
-        #pragma omp parallel for schedule (static)
+        long int myoffset = offset;
+        #pragma omp taskloop nogroup
         for ( int ij = 0; ij < gems_aa[h]; ij++) {
             int i = bas_aa_sym[h][ij][0];
             int j = bas_aa_sym[h][ij][1];
@@ -134,18 +137,19 @@ void v2RDMSolver::D3_constraints_Au(SharedVector A,SharedVector u){
                 double dum = nb * u_p[d2aaoff[h] + ij*gems_aa[h] + kl];
                 for ( int p = 0; p < amo_; p++) {
                     int h2 = SymmetryPair(h,symmetry[p]);
-                    int ijp = ibas_aab_sym[h2][i][j][p];
-                    int klp = ibas_aab_sym[h2][k][l][p];
+                    int ijp = ibas_aab(i,j,p);
+                    int klp = ibas_aab(k,l,p);
                     dum -= u_p[d3aaboff[h2] + ijp*trip_aab[h2]+klp];
                 }
-                A_p[offset + ij*gems_aa[h]+kl] = dum;
+                A_p[myoffset + ij*gems_aa[h]+kl] = dum;
             }
         }
         offset += gems_aa[h] * gems_aa[h];
     }
     // D3bba -> D2bb
     for ( int h = 0; h < nirrep_; h++) {
-        #pragma omp parallel for schedule (static)
+        long int myoffset = offset;
+        #pragma omp taskloop nogroup
         for ( int ij = 0; ij < gems_aa[h]; ij++) {
             int i = bas_aa_sym[h][ij][0];
             int j = bas_aa_sym[h][ij][1];
@@ -155,11 +159,11 @@ void v2RDMSolver::D3_constraints_Au(SharedVector A,SharedVector u){
                 double dum = na * u_p[d2bboff[h] + ij*gems_aa[h] + kl];
                 for ( int p = 0; p < amo_; p++) {
                     int h2 = SymmetryPair(h,symmetry[p]);
-                    int ijp = ibas_aab_sym[h2][i][j][p];
-                    int klp = ibas_aab_sym[h2][k][l][p];
+                    int ijp = ibas_aab(i,j,p);
+                    int klp = ibas_aab(k,l,p);
                     dum -= u_p[d3bbaoff[h2] + ijp*trip_aab[h2]+klp];
                 }
-                A_p[offset + ij*gems_aa[h]+kl] = dum;
+                A_p[myoffset + ij*gems_aa[h]+kl] = dum;
             }
         }
         offset += gems_aa[h] * gems_aa[h];
@@ -167,7 +171,8 @@ void v2RDMSolver::D3_constraints_Au(SharedVector A,SharedVector u){
     if ( na > 1 ) {
         // D3aab -> D2ab
         for ( int h = 0; h < nirrep_; h++) {
-            #pragma omp parallel for schedule (static)
+            long int myoffset = offset;
+            #pragma omp taskloop nogroup
             for ( int ij = 0; ij < gems_ab[h]; ij++) {
                 int i = bas_ab_sym[h][ij][0];
                 int j = bas_ab_sym[h][ij][1];
@@ -179,14 +184,14 @@ void v2RDMSolver::D3_constraints_Au(SharedVector A,SharedVector u){
                         if ( i == p) continue;
                         if ( k == p) continue;
                         int h2 = SymmetryPair(h,symmetry[p]);
-                        int ijp = ibas_aab_sym[h2][i][p][j];
-                        int klp = ibas_aab_sym[h2][k][p][l];
+                        int ijp = ibas_aab(i,p,j);
+                        int klp = ibas_aab(k,p,l);
                         int s = 1;
                         if ( p < i ) s = -s;
                         if ( p < k ) s = -s;
                         dum -= s * u_p[d3aaboff[h2] + ijp*trip_aab[h2]+klp];
                     }
-                    A_p[offset + ij*gems_ab[h]+kl] = dum;
+                    A_p[myoffset + ij*gems_ab[h]+kl] = dum;
                 }
             }
             offset += gems_ab[h] * gems_ab[h];
@@ -195,7 +200,8 @@ void v2RDMSolver::D3_constraints_Au(SharedVector A,SharedVector u){
     if ( nb > 1 ) {
         // D3bba -> D2ab
         for ( int h = 0; h < nirrep_; h++) {
-            #pragma omp parallel for schedule (static)
+            long int myoffset = offset;
+            #pragma omp taskloop nogroup
             for ( int ij = 0; ij < gems_ab[h]; ij++) {
                 int i = bas_ab_sym[h][ij][0];
                 int j = bas_ab_sym[h][ij][1];
@@ -207,14 +213,14 @@ void v2RDMSolver::D3_constraints_Au(SharedVector A,SharedVector u){
                         if ( j == p) continue;
                         if ( l == p) continue;
                         int h2 = SymmetryPair(h,symmetry[p]);
-                        int ijp = ibas_aab_sym[h2][j][p][i];
-                        int klp = ibas_aab_sym[h2][l][p][k];
+                        int ijp = ibas_aab(j,p,i);
+                        int klp = ibas_aab(l,p,k);
                         int s = 1;
                         if ( p < j ) s = -s;
                         if ( p < l ) s = -s;
                         dum -= s * u_p[d3bbaoff[h2] + ijp*trip_aab[h2]+klp];
                     }
-                    A_p[offset + ij*gems_ab[h]+kl] = dum;
+                    A_p[myoffset + ij*gems_ab[h]+kl] = dum;
                 }
             }
             offset += gems_ab[h] * gems_ab[h];
@@ -223,72 +229,82 @@ void v2RDMSolver::D3_constraints_Au(SharedVector A,SharedVector u){
 
     // additional spin constraints for singlets:
     if ( constrain_spin_ && nalpha_ == nbeta_ ) {
-        // D3aab = D3bba
-        for ( int h = 0; h < nirrep_; h++) {
-            C_DCOPY(trip_aab[h]*trip_aab[h],u_p + d3aaboff[h],1,A_p + offset,1);
-            C_DAXPY(trip_aab[h]*trip_aab[h],-1.0,u_p + d3bbaoff[h],1,A_p + offset,1);
-            offset += trip_aab[h]*trip_aab[h];
+        if ( !spin_restricted_ ) {
+            // D3aab = D3bba
+            for ( int h = 0; h < nirrep_; h++) {
+                long int myoffset = offset;
+                #pragma omp task
+                {
+                    C_DCOPY(trip_aab[h]*trip_aab[h],u_p + d3aaboff[h],1,A_p + myoffset,1);
+                    C_DAXPY(trip_aab[h]*trip_aab[h],-1.0,u_p + d3bbaoff[h],1,A_p + myoffset,1);
+                }
+                offset += trip_aab[h]*trip_aab[h];
+            }
         }
         // D3aaa <- D3aab
         for ( int h = 0; h < nirrep_; h++) {
-            C_DCOPY(trip_aaa[h]*trip_aaa[h],u_p + d3aaaoff[h],1,A_p + offset,1);
+            long int myoffset = offset;
+            #pragma omp taskloop nogroup
             for (int pqr = 0; pqr < trip_aaa[h]; pqr++) {
+                C_DCOPY(trip_aaa[h],u_p + d3aaaoff[h] + pqr*trip_aaa[h],1,A_p + myoffset + pqr*trip_aaa[h],1);
                 int p = bas_aaa_sym[h][pqr][0];
                 int q = bas_aaa_sym[h][pqr][1];
                 int r = bas_aaa_sym[h][pqr][2];
-                int pqr_b = ibas_aab_sym[h][p][q][r];
-                int prq_b = ibas_aab_sym[h][p][r][q];
-                int qrp_b = ibas_aab_sym[h][q][r][p];
+                int pqr_b = ibas_aab(p,q,r);
+                int prq_b = ibas_aab(p,r,q);
+                int qrp_b = ibas_aab(q,r,p);
                 for (int stu = 0; stu < trip_aaa[h]; stu++) {
                     int s = bas_aaa_sym[h][stu][0];
                     int t = bas_aaa_sym[h][stu][1];
                     int u = bas_aaa_sym[h][stu][2];
-                    int stu_b = ibas_aab_sym[h][s][t][u];
-                    int sut_b = ibas_aab_sym[h][s][u][t];
-                    int tus_b = ibas_aab_sym[h][t][u][s];
-                    A_p[offset + pqr*trip_aaa[h] + stu] -= 1.0/3.0 * u_p[d3aaboff[h] + pqr_b * trip_aab[h] + stu_b];
-                    A_p[offset + pqr*trip_aaa[h] + stu] += 1.0/3.0 * u_p[d3aaboff[h] + pqr_b * trip_aab[h] + sut_b];
-                    A_p[offset + pqr*trip_aaa[h] + stu] -= 1.0/3.0 * u_p[d3aaboff[h] + pqr_b * trip_aab[h] + tus_b];
+                    int stu_b = ibas_aab(s,t,u);
+                    int sut_b = ibas_aab(s,u,t);
+                    int tus_b = ibas_aab(t,u,s);
+                    A_p[myoffset + pqr*trip_aaa[h] + stu] -= 1.0/3.0 * u_p[d3aaboff[h] + pqr_b * trip_aab[h] + stu_b];
+                    A_p[myoffset + pqr*trip_aaa[h] + stu] += 1.0/3.0 * u_p[d3aaboff[h] + pqr_b * trip_aab[h] + sut_b];
+                    A_p[myoffset + pqr*trip_aaa[h] + stu] -= 1.0/3.0 * u_p[d3aaboff[h] + pqr_b * trip_aab[h] + tus_b];
 
-                    A_p[offset + pqr*trip_aaa[h] + stu] += 1.0/3.0 * u_p[d3aaboff[h] + prq_b * trip_aab[h] + stu_b];
-                    A_p[offset + pqr*trip_aaa[h] + stu] -= 1.0/3.0 * u_p[d3aaboff[h] + prq_b * trip_aab[h] + sut_b];
-                    A_p[offset + pqr*trip_aaa[h] + stu] += 1.0/3.0 * u_p[d3aaboff[h] + prq_b * trip_aab[h] + tus_b];
+                    A_p[myoffset + pqr*trip_aaa[h] + stu] += 1.0/3.0 * u_p[d3aaboff[h] + prq_b * trip_aab[h] + stu_b];
+                    A_p[myoffset + pqr*trip_aaa[h] + stu] -= 1.0/3.0 * u_p[d3aaboff[h] + prq_b * trip_aab[h] + sut_b];
+                    A_p[myoffset + pqr*trip_aaa[h] + stu] += 1.0/3.0 * u_p[d3aaboff[h] + prq_b * trip_aab[h] + tus_b];
 
-                    A_p[offset + pqr*trip_aaa[h] + stu] -= 1.0/3.0 * u_p[d3aaboff[h] + qrp_b * trip_aab[h] + stu_b];
-                    A_p[offset + pqr*trip_aaa[h] + stu] += 1.0/3.0 * u_p[d3aaboff[h] + qrp_b * trip_aab[h] + sut_b];
-                    A_p[offset + pqr*trip_aaa[h] + stu] -= 1.0/3.0 * u_p[d3aaboff[h] + qrp_b * trip_aab[h] + tus_b];
+                    A_p[myoffset + pqr*trip_aaa[h] + stu] -= 1.0/3.0 * u_p[d3aaboff[h] + qrp_b * trip_aab[h] + stu_b];
+                    A_p[myoffset + pqr*trip_aaa[h] + stu] += 1.0/3.0 * u_p[d3aaboff[h] + qrp_b * trip_aab[h] + sut_b];
+                    A_p[myoffset + pqr*trip_aaa[h] + stu] -= 1.0/3.0 * u_p[d3aaboff[h] + qrp_b * trip_aab[h] + tus_b];
                 }
             }
             offset += trip_aaa[h]*trip_aaa[h];
         }
         // D3bbb <- D3bba
         for ( int h = 0; h < nirrep_; h++) {
-            C_DCOPY(trip_aaa[h]*trip_aaa[h],u_p + d3bbboff[h],1,A_p + offset,1);
+            long int myoffset = offset;
+            #pragma omp taskloop nogroup
             for (int pqr = 0; pqr < trip_aaa[h]; pqr++) {
+                C_DCOPY(trip_aaa[h],u_p + d3bbboff[h] + pqr*trip_aaa[h],1,A_p + myoffset + pqr*trip_aaa[h],1);
                 int p = bas_aaa_sym[h][pqr][0];
                 int q = bas_aaa_sym[h][pqr][1];
                 int r = bas_aaa_sym[h][pqr][2];
-                int pqr_b = ibas_aab_sym[h][p][q][r];
-                int prq_b = ibas_aab_sym[h][p][r][q];
-                int qrp_b = ibas_aab_sym[h][q][r][p];
+                int pqr_b = ibas_aab(p,q,r);
+                int prq_b = ibas_aab(p,r,q);
+                int qrp_b = ibas_aab(q,r,p);
                 for (int stu = 0; stu < trip_aaa[h]; stu++) {
                     int s = bas_aaa_sym[h][stu][0];
                     int t = bas_aaa_sym[h][stu][1];
                     int u = bas_aaa_sym[h][stu][2];
-                    int stu_b = ibas_aab_sym[h][s][t][u];
-                    int sut_b = ibas_aab_sym[h][s][u][t];
-                    int tus_b = ibas_aab_sym[h][t][u][s];
-                    A_p[offset + pqr*trip_aaa[h] + stu] -= 1.0/3.0 * u_p[d3bbaoff[h] + pqr_b * trip_aab[h] + stu_b];
-                    A_p[offset + pqr*trip_aaa[h] + stu] += 1.0/3.0 * u_p[d3bbaoff[h] + pqr_b * trip_aab[h] + sut_b];
-                    A_p[offset + pqr*trip_aaa[h] + stu] -= 1.0/3.0 * u_p[d3bbaoff[h] + pqr_b * trip_aab[h] + tus_b];
+                    int stu_b = ibas_aab(s,t,u);
+                    int sut_b = ibas_aab(s,u,t);
+                    int tus_b = ibas_aab(t,u,s);
+                    A_p[myoffset + pqr*trip_aaa[h] + stu] -= 1.0/3.0 * u_p[d3bbaoff[h] + pqr_b * trip_aab[h] + stu_b];
+                    A_p[myoffset + pqr*trip_aaa[h] + stu] += 1.0/3.0 * u_p[d3bbaoff[h] + pqr_b * trip_aab[h] + sut_b];
+                    A_p[myoffset + pqr*trip_aaa[h] + stu] -= 1.0/3.0 * u_p[d3bbaoff[h] + pqr_b * trip_aab[h] + tus_b];
 
-                    A_p[offset + pqr*trip_aaa[h] + stu] += 1.0/3.0 * u_p[d3bbaoff[h] + prq_b * trip_aab[h] + stu_b];
-                    A_p[offset + pqr*trip_aaa[h] + stu] -= 1.0/3.0 * u_p[d3bbaoff[h] + prq_b * trip_aab[h] + sut_b];
-                    A_p[offset + pqr*trip_aaa[h] + stu] += 1.0/3.0 * u_p[d3bbaoff[h] + prq_b * trip_aab[h] + tus_b];
+                    A_p[myoffset + pqr*trip_aaa[h] + stu] += 1.0/3.0 * u_p[d3bbaoff[h] + prq_b * trip_aab[h] + stu_b];
+                    A_p[myoffset + pqr*trip_aaa[h] + stu] -= 1.0/3.0 * u_p[d3bbaoff[h] + prq_b * trip_aab[h] + sut_b];
+                    A_p[myoffset + pqr*trip_aaa[h] + stu] += 1.0/3.0 * u_p[d3bbaoff[h] + prq_b * trip_aab[h] + tus_b];
 
-                    A_p[offset + pqr*trip_aaa[h] + stu] -= 1.0/3.0 * u_p[d3bbaoff[h] + qrp_b * trip_aab[h] + stu_b];
-                    A_p[offset + pqr*trip_aaa[h] + stu] += 1.0/3.0 * u_p[d3bbaoff[h] + qrp_b * trip_aab[h] + sut_b];
-                    A_p[offset + pqr*trip_aaa[h] + stu] -= 1.0/3.0 * u_p[d3bbaoff[h] + qrp_b * trip_aab[h] + tus_b];
+                    A_p[myoffset + pqr*trip_aaa[h] + stu] -= 1.0/3.0 * u_p[d3bbaoff[h] + qrp_b * trip_aab[h] + stu_b];
+                    A_p[myoffset + pqr*trip_aaa[h] + stu] += 1.0/3.0 * u_p[d3bbaoff[h] + qrp_b * trip_aab[h] + sut_b];
+                    A_p[myoffset + pqr*trip_aaa[h] + stu] -= 1.0/3.0 * u_p[d3bbaoff[h] + qrp_b * trip_aab[h] + tus_b];
                 }
             }
             offset += trip_aaa[h]*trip_aaa[h];
@@ -297,6 +313,88 @@ void v2RDMSolver::D3_constraints_Au(SharedVector A,SharedVector u){
 
 }
 
+// D3 portion of diag(A.A^T).  the rows are visited in the same order as in
+// D3_constraints_Au; each row contains one D2 term, scaled by the number of
+// remaining electrons, and one D3 term (coefficient +/- 1) for each
+// orbital p that survives the exclusions in the sum over p.
+void v2RDMSolver::D3_constraints_AAT_diagonal(double * d){
+
+    int na = nalpha_ - nrstc_ - nfrzc_;
+    int nb = nbeta_ - nrstc_ - nfrzc_;
+
+    // D3aaa -> D2aa, D3bbb -> D2bb
+    for (int spin = 0; spin < 2; spin++) {
+        int n = ( spin == 0 ) ? na : nb;
+        if ( n <= 2 ) continue;
+        for ( int h = 0; h < nirrep_; h++) {
+            for ( int ij = 0; ij < gems_aa[h]; ij++) {
+                int i = bas_aa_sym[h][ij][0];
+                int j = bas_aa_sym[h][ij][1];
+                for ( int kl = 0; kl < gems_aa[h]; kl++) {
+                    int k = bas_aa_sym[h][kl][0];
+                    int l = bas_aa_sym[h][kl][1];
+                    // orbitals in {i,j,k,l}; i != j and k != l
+                    int nexcluded = 2;
+                    if ( k != i && k != j ) nexcluded++;
+                    if ( l != i && l != j ) nexcluded++;
+                    d[offset + ij*gems_aa[h]+kl] = (n - 2.0) * (n - 2.0) + amo_ - nexcluded;
+                }
+            }
+            offset += gems_aa[h] * gems_aa[h];
+        }
+    }
+    // D3aab -> D2aa, D3bba -> D2bb
+    for (int spin = 0; spin < 2; spin++) {
+        int n = ( spin == 0 ) ? nb : na;
+        for ( int h = 0; h < nirrep_; h++) {
+            for ( long int ijkl = 0; ijkl < (long int)gems_aa[h] * gems_aa[h]; ijkl++) {
+                d[offset + ijkl] = (double)n * n + amo_;
+            }
+            offset += gems_aa[h] * gems_aa[h];
+        }
+    }
+    // D3aab -> D2ab (p != i, p != k), D3bba -> D2ab (p != j, p != l)
+    for (int spin = 0; spin < 2; spin++) {
+        int n = ( spin == 0 ) ? na : nb;
+        if ( n <= 1 ) continue;
+        for ( int h = 0; h < nirrep_; h++) {
+            for ( int ij = 0; ij < gems_ab[h]; ij++) {
+                int i = bas_ab_sym[h][ij][0];
+                int j = bas_ab_sym[h][ij][1];
+                for ( int kl = 0; kl < gems_ab[h]; kl++) {
+                    int k = bas_ab_sym[h][kl][0];
+                    int l = bas_ab_sym[h][kl][1];
+                    bool same = ( spin == 0 ) ? ( i == k ) : ( j == l );
+                    int nexcluded = same ? 1 : 2;
+                    d[offset + ij*gems_ab[h]+kl] = (n - 1.0) * (n - 1.0) + amo_ - nexcluded;
+                }
+            }
+            offset += gems_ab[h] * gems_ab[h];
+        }
+    }
+
+    // additional spin constraints for singlets.  D3aab = D3bba: two terms.
+    // D3aaa <- D3aab and D3bbb <- D3bba: one term plus nine of magnitude 1/3.
+    if ( constrain_spin_ && nalpha_ == nbeta_ ) {
+        if ( !spin_restricted_ ) {
+            for ( int h = 0; h < nirrep_; h++) {
+                for ( long int i = 0; i < (long int)trip_aab[h] * trip_aab[h]; i++) {
+                    d[offset + i] = 2.0;
+                }
+                offset += trip_aab[h]*trip_aab[h];
+            }
+        }
+        for (int spin = 0; spin < 2; spin++) {
+            for ( int h = 0; h < nirrep_; h++) {
+                for ( long int i = 0; i < (long int)trip_aaa[h] * trip_aaa[h]; i++) {
+                    d[offset + i] = 2.0;
+                }
+                offset += trip_aaa[h]*trip_aaa[h];
+            }
+        }
+    }
+}
+
 // D3 portion of A^T.y 
 void v2RDMSolver::D3_constraints_ATu(SharedVector A,SharedVector u){
 
@@ -306,23 +404,35 @@ void v2RDMSolver::D3_constraints_ATu(SharedVector A,SharedVector u){
     int na = nalpha_ - nrstc_ - nfrzc_;
     int nb = nbeta_ - nrstc_ - nfrzc_;
 
+    // a given D3aaa (or D3aab in the D3aab -> D2ab mapping) element receives
+    // contributions from several rows of A, but, for a fixed orbital p, the
+    // map from rows to D3 elements is one-to-one.  the p loops below are
+    // therefore serial, and the row loops are parallel.  the order of the
+    // accumulation does not depend on the number of threads.
+
     if ( na > 2 ) {
         // D3aaa -> D2aa
+        int saveoff = offset;
         for ( int h = 0; h < nirrep_; h++) {
-            for ( int ij = 0; ij < gems_aa[h]; ij++) {
-                int i = bas_aa_sym[h][ij][0];
-                int j = bas_aa_sym[h][ij][1];
-                for ( int kl = 0; kl < gems_aa[h]; kl++) {
-                    int k = bas_aa_sym[h][kl][0];
-                    int l = bas_aa_sym[h][kl][1];
-                    double dum = u_p[offset + ij*gems_aa[h] + kl];
-                    A_p[d2aaoff[h] + ij*gems_aa[h] + kl] += (na - 2.0) * dum;
-                    for ( int p = 0; p < amo_; p++) {
-                        if ( i == p || j == p ) continue;
+            C_DAXPY(gems_aa[h]*gems_aa[h],na - 2.0,u_p + offset,1,A_p + d2aaoff[h],1);
+            offset += gems_aa[h] * gems_aa[h];
+        }
+        for ( int p = 0; p < amo_; p++) {
+            int myoffset = saveoff;
+            for ( int h = 0; h < nirrep_; h++) {
+                int h2 = SymmetryPair(h,symmetry[p]);
+                #pragma omp parallel for schedule (static)
+                for ( int ij = 0; ij < gems_aa[h]; ij++) {
+                    int i = bas_aa_sym[h][ij][0];
+                    int j = bas_aa_sym[h][ij][1];
+                    if ( i == p || j == p ) continue;
+                    for ( int kl = 0; kl < gems_aa[h]; kl++) {
+                        int k = bas_aa_sym[h][kl][0];
+                        int l = bas_aa_sym[h][kl][1];
                         if ( k == p || l == p ) continue;
-                        int h2 = SymmetryPair(h,symmetry[p]);
-                        int ijp = ibas_aaa_sym[h2][i][j][p];
-                        int klp = ibas_aaa_sym[h2][k][l][p];
+                        double dum = u_p[myoffset + ij*gems_aa[h] + kl];
+                        int ijp = ibas_aaa(i,j,p);
+                        int klp = ibas_aaa(k,l,p);
                         int s = 1;
                         if ( p < i ) s = -s;
                         if ( p < j ) s = -s;
@@ -331,27 +441,33 @@ void v2RDMSolver::D3_constraints_ATu(SharedVector A,SharedVector u){
                         A_p[d3aaaoff[h2] + ijp*trip_aaa[h2]+klp] -= s * dum;
                     }
                 }
+                myoffset += gems_aa[h] * gems_aa[h];
             }
-            offset += gems_aa[h] * gems_aa[h];
         }
     }
     if ( nb > 2 ) {
         // D3bbb -> D2bb
+        int saveoff = offset;
         for ( int h = 0; h < nirrep_; h++) {
-            for ( int ij = 0; ij < gems_aa[h]; ij++) {
-                int i = bas_aa_sym[h][ij][0];
-                int j = bas_aa_sym[h][ij][1];
-                for ( int kl = 0; kl < gems_aa[h]; kl++) {
-                    int k = bas_aa_sym[h][kl][0];
-                    int l = bas_aa_sym[h][kl][1];
-                    double dum = u_p[offset + ij*gems_aa[h] + kl];
-                    A_p[d2bboff[h] + ij*gems_aa[h] + kl] += (nb - 2.0) * dum;
-                    for ( int p = 0; p < amo_; p++) {
-                        if ( i == p || j == p ) continue;
+            C_DAXPY(gems_aa[h]*gems_aa[h],nb - 2.0,u_p + offset,1,A_p + d2bboff[h],1);
+            offset += gems_aa[h] * gems_aa[h];
+        }
+        for ( int p = 0; p < amo_; p++) {
+            int myoffset = saveoff;
+            for ( int h = 0; h < nirrep_; h++) {
+                int h2 = SymmetryPair(h,symmetry[p]);
+                #pragma omp parallel for schedule (static)
+                for ( int ij = 0; ij < gems_aa[h]; ij++) {
+                    int i = bas_aa_sym[h][ij][0];
+                    int j = bas_aa_sym[h][ij][1];
+                    if ( i == p || j == p ) continue;
+                    for ( int kl = 0; kl < gems_aa[h]; kl++) {
+                        int k = bas_aa_sym[h][kl][0];
+                        int l = bas_aa_sym[h][kl][1];
                         if ( k == p || l == p ) continue;
-                        int h2 = SymmetryPair(h,symmetry[p]);
-                        int ijp = ibas_aaa_sym[h2][i][j][p];
-                        int klp = ibas_aaa_sym[h2][k][l][p];
+                        double dum = u_p[myoffset + ij*gems_aa[h] + kl];
+                        int ijp = ibas_aaa(i,j,p);
+                        int klp = ibas_aaa(k,l,p);
                         int s = 1;
                         if ( p < i ) s = -s;
                         if ( p < j ) s = -s;
@@ -360,12 +476,13 @@ void v2RDMSolver::D3_constraints_ATu(SharedVector A,SharedVector u){
                         A_p[d3bbboff[h2] + ijp*trip_aaa[h2]+klp] -= s * dum;
                     }
                 }
+                myoffset += gems_aa[h] * gems_aa[h];
             }
-            offset += gems_aa[h] * gems_aa[h];
         }
     }
-    // D3aab -> D2aa
+    // D3aab -> D2aa (each D3aab element appears in only one row)
     for ( int h = 0; h < nirrep_; h++) {
+        #pragma omp parallel for schedule (static)
         for ( int ij = 0; ij < gems_aa[h]; ij++) {
             int i = bas_aa_sym[h][ij][0];
             int j = bas_aa_sym[h][ij][1];
@@ -376,16 +493,17 @@ void v2RDMSolver::D3_constraints_ATu(SharedVector A,SharedVector u){
                 A_p[d2aaoff[h] + ij*gems_aa[h] + kl] += nb * dum;
                 for ( int p = 0; p < amo_; p++) {
                     int h2 = SymmetryPair(h,symmetry[p]);
-                    int ijp = ibas_aab_sym[h2][i][j][p];
-                    int klp = ibas_aab_sym[h2][k][l][p];
+                    int ijp = ibas_aab(i,j,p);
+                    int klp = ibas_aab(k,l,p);
                     A_p[d3aaboff[h2] + ijp*trip_aab[h2]+klp] -= dum;
                 }
             }
         }
         offset += gems_aa[h] * gems_aa[h];
     }
-    // D3bba -> D2bb
+    // D3bba -> D2bb (each D3bba element appears in only one row)
     for ( int h = 0; h < nirrep_; h++) {
+        #pragma omp parallel for schedule (static)
         for ( int ij = 0; ij < gems_aa[h]; ij++) {
             int i = bas_aa_sym[h][ij][0];
             int j = bas_aa_sym[h][ij][1];
@@ -396,8 +514,8 @@ void v2RDMSolver::D3_constraints_ATu(SharedVector A,SharedVector u){
                 A_p[d2bboff[h] + ij*gems_aa[h] + kl] += na * dum;
                 for ( int p = 0; p < amo_; p++) {
                     int h2 = SymmetryPair(h,symmetry[p]);
-                    int ijp = ibas_aab_sym[h2][i][j][p];
-                    int klp = ibas_aab_sym[h2][k][l][p];
+                    int ijp = ibas_aab(i,j,p);
+                    int klp = ibas_aab(k,l,p);
                     A_p[d3bbaoff[h2] + ijp*trip_aab[h2]+klp] -= dum;
                 }
             }
@@ -406,84 +524,99 @@ void v2RDMSolver::D3_constraints_ATu(SharedVector A,SharedVector u){
     }
     if ( na > 1 ) {
         // D3aab -> D2ab
+        int saveoff = offset;
         for ( int h = 0; h < nirrep_; h++) {
-            for ( int ij = 0; ij < gems_ab[h]; ij++) {
-                int i = bas_ab_sym[h][ij][0];
-                int j = bas_ab_sym[h][ij][1];
-                for ( int kl = 0; kl < gems_ab[h]; kl++) {
-                    int k = bas_ab_sym[h][kl][0];
-                    int l = bas_ab_sym[h][kl][1];
-                    double dum = u_p[offset + ij*gems_ab[h] + kl];
-                    A_p[d2aboff[h] + ij*gems_ab[h] + kl] += (na - 1.0) * dum;
-                    for ( int p = 0; p < amo_; p++) {
-                        if ( i == p) continue;
-                        if ( k == p) continue;
-                        int h2 = SymmetryPair(h,symmetry[p]);
-                        int ijp = ibas_aab_sym[h2][i][p][j];
-                        int klp = ibas_aab_sym[h2][k][p][l];
+            C_DAXPY(gems_ab[h]*gems_ab[h],na - 1.0,u_p + offset,1,A_p + d2aboff[h],1);
+            offset += gems_ab[h] * gems_ab[h];
+        }
+        for ( int p = 0; p < amo_; p++) {
+            int myoffset = saveoff;
+            for ( int h = 0; h < nirrep_; h++) {
+                int h2 = SymmetryPair(h,symmetry[p]);
+                #pragma omp parallel for schedule (static)
+                for ( int ij = 0; ij < gems_ab[h]; ij++) {
+                    int i = bas_ab_sym[h][ij][0];
+                    int j = bas_ab_sym[h][ij][1];
+                    if ( i == p ) continue;
+                    for ( int kl = 0; kl < gems_ab[h]; kl++) {
+                        int k = bas_ab_sym[h][kl][0];
+                        int l = bas_ab_sym[h][kl][1];
+                        if ( k == p ) continue;
+                        double dum = u_p[myoffset + ij*gems_ab[h] + kl];
+                        int ijp = ibas_aab(i,p,j);
+                        int klp = ibas_aab(k,p,l);
                         int s = 1;
                         if ( p < i ) s = -s;
                         if ( p < k ) s = -s;
                         A_p[d3aaboff[h2] + ijp*trip_aab[h2]+klp] -= s * dum;
                     }
                 }
+                myoffset += gems_ab[h] * gems_ab[h];
             }
-            offset += gems_ab[h] * gems_ab[h];
         }
     }
     if ( nb > 1 ) {
         // D3bba -> D2ab
+        int saveoff = offset;
         for ( int h = 0; h < nirrep_; h++) {
-            for ( int ij = 0; ij < gems_ab[h]; ij++) {
-                int i = bas_ab_sym[h][ij][0];
-                int j = bas_ab_sym[h][ij][1];
-                for ( int kl = 0; kl < gems_ab[h]; kl++) {
-                    int k = bas_ab_sym[h][kl][0];
-                    int l = bas_ab_sym[h][kl][1];
-                    double dum = u_p[offset + ij*gems_ab[h] + kl];
-                    A_p[d2aboff[h] + ij*gems_ab[h] + kl] += (nb - 1.0) * dum;
-                    for ( int p = 0; p < amo_; p++) {
-                        if ( j == p) continue;
-                        if ( l == p) continue;
-                        int h2 = SymmetryPair(h,symmetry[p]);
-                        int ijp = ibas_aab_sym[h2][j][p][i];
-                        int klp = ibas_aab_sym[h2][l][p][k];
+            C_DAXPY(gems_ab[h]*gems_ab[h],nb - 1.0,u_p + offset,1,A_p + d2aboff[h],1);
+            offset += gems_ab[h] * gems_ab[h];
+        }
+        for ( int p = 0; p < amo_; p++) {
+            int myoffset = saveoff;
+            for ( int h = 0; h < nirrep_; h++) {
+                int h2 = SymmetryPair(h,symmetry[p]);
+                #pragma omp parallel for schedule (static)
+                for ( int ij = 0; ij < gems_ab[h]; ij++) {
+                    int i = bas_ab_sym[h][ij][0];
+                    int j = bas_ab_sym[h][ij][1];
+                    if ( j == p ) continue;
+                    for ( int kl = 0; kl < gems_ab[h]; kl++) {
+                        int k = bas_ab_sym[h][kl][0];
+                        int l = bas_ab_sym[h][kl][1];
+                        if ( l == p ) continue;
+                        double dum = u_p[myoffset + ij*gems_ab[h] + kl];
+                        int ijp = ibas_aab(j,p,i);
+                        int klp = ibas_aab(l,p,k);
                         int s = 1;
                         if ( p < j ) s = -s;
                         if ( p < l ) s = -s;
                         A_p[d3bbaoff[h2] + ijp*trip_aab[h2]+klp] -= s * dum;
                     }
                 }
+                myoffset += gems_ab[h] * gems_ab[h];
             }
-            offset += gems_ab[h] * gems_ab[h];
         }
     }
 
     // additional spin constraints for singlets:
     if ( constrain_spin_ && nalpha_ == nbeta_ ) {
-        // D3aab = D3bba
-        for ( int h = 0; h < nirrep_; h++) {
-            C_DAXPY(trip_aab[h]*trip_aab[h], 1.0,u_p + offset,1,A_p + d3aaboff[h],1);
-            C_DAXPY(trip_aab[h]*trip_aab[h],-1.0,u_p + offset,1,A_p + d3bbaoff[h],1);
-            offset += trip_aab[h]*trip_aab[h];
+        if ( !spin_restricted_ ) {
+            // D3aab = D3bba
+            for ( int h = 0; h < nirrep_; h++) {
+                C_DAXPY(trip_aab[h]*trip_aab[h], 1.0,u_p + offset,1,A_p + d3aaboff[h],1);
+                C_DAXPY(trip_aab[h]*trip_aab[h],-1.0,u_p + offset,1,A_p + d3bbaoff[h],1);
+                offset += trip_aab[h]*trip_aab[h];
+            }
         }
         // D3aaa <- D3aab
         for ( int h = 0; h < nirrep_; h++) {
             C_DAXPY(trip_aaa[h]*trip_aaa[h],1.0,u_p + offset,1,A_p+d3aaaoff[h],1);
+            #pragma omp parallel for schedule (static)
             for (int pqr = 0; pqr < trip_aaa[h]; pqr++) {
                 int p = bas_aaa_sym[h][pqr][0];
                 int q = bas_aaa_sym[h][pqr][1];
                 int r = bas_aaa_sym[h][pqr][2];
-                int pqr_b = ibas_aab_sym[h][p][q][r];
-                int prq_b = ibas_aab_sym[h][p][r][q];
-                int qrp_b = ibas_aab_sym[h][q][r][p];
+                int pqr_b = ibas_aab(p,q,r);
+                int prq_b = ibas_aab(p,r,q);
+                int qrp_b = ibas_aab(q,r,p);
                 for (int stu = 0; stu < trip_aaa[h]; stu++) {
                     int s = bas_aaa_sym[h][stu][0];
                     int t = bas_aaa_sym[h][stu][1];
                     int u = bas_aaa_sym[h][stu][2];
-                    int stu_b = ibas_aab_sym[h][s][t][u];
-                    int sut_b = ibas_aab_sym[h][s][u][t];
-                    int tus_b = ibas_aab_sym[h][t][u][s];
+                    int stu_b = ibas_aab(s,t,u);
+                    int sut_b = ibas_aab(s,u,t);
+                    int tus_b = ibas_aab(t,u,s);
                     A_p[d3aaboff[h] + pqr_b * trip_aab[h] + stu_b] -= 1.0/3.0 * u_p[offset + pqr*trip_aaa[h] + stu];
                     A_p[d3aaboff[h] + pqr_b * trip_aab[h] + sut_b] += 1.0/3.0 * u_p[offset + pqr*trip_aaa[h] + stu];
                     A_p[d3aaboff[h] + pqr_b * trip_aab[h] + tus_b] -= 1.0/3.0 * u_p[offset + pqr*trip_aaa[h] + stu];
@@ -502,20 +635,21 @@ void v2RDMSolver::D3_constraints_ATu(SharedVector A,SharedVector u){
         // D3bbb <- D3bba
         for ( int h = 0; h < nirrep_; h++) {
             C_DAXPY(trip_aaa[h]*trip_aaa[h],1.0,u_p + offset,1,A_p+d3bbboff[h],1);
+            #pragma omp parallel for schedule (static)
             for (int pqr = 0; pqr < trip_aaa[h]; pqr++) {
                 int p = bas_aaa_sym[h][pqr][0];
                 int q = bas_aaa_sym[h][pqr][1];
                 int r = bas_aaa_sym[h][pqr][2];
-                int pqr_b = ibas_aab_sym[h][p][q][r];
-                int prq_b = ibas_aab_sym[h][p][r][q];
-                int qrp_b = ibas_aab_sym[h][q][r][p];
+                int pqr_b = ibas_aab(p,q,r);
+                int prq_b = ibas_aab(p,r,q);
+                int qrp_b = ibas_aab(q,r,p);
                 for (int stu = 0; stu < trip_aaa[h]; stu++) {
                     int s = bas_aaa_sym[h][stu][0];
                     int t = bas_aaa_sym[h][stu][1];
                     int u = bas_aaa_sym[h][stu][2];
-                    int stu_b = ibas_aab_sym[h][s][t][u];
-                    int sut_b = ibas_aab_sym[h][s][u][t];
-                    int tus_b = ibas_aab_sym[h][t][u][s];
+                    int stu_b = ibas_aab(s,t,u);
+                    int sut_b = ibas_aab(s,u,t);
+                    int tus_b = ibas_aab(t,u,s);
                     A_p[d3bbaoff[h] + pqr_b * trip_aab[h] + stu_b] -= 1.0/3.0 * u_p[offset + pqr*trip_aaa[h] + stu];
                     A_p[d3bbaoff[h] + pqr_b * trip_aab[h] + sut_b] += 1.0/3.0 * u_p[offset + pqr*trip_aaa[h] + stu];
                     A_p[d3bbaoff[h] + pqr_b * trip_aab[h] + tus_b] -= 1.0/3.0 * u_p[offset + pqr*trip_aaa[h] + stu];
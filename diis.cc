@@ -26,12 +26,10 @@
  */
 
 #include"v2rdm_solver.h"
-//#include<../bin/fnocc/blas.h>
-//#include<psi4/src/psi4/fnocc/blas.h>
 #include "blas.h"
 #include<psi4/libqt/qt.h>
 
-#include<psi4/psifiles.h>
+#include<string.h>
 
 using namespace psi;
 
@@ -41,210 +39,121 @@ using namespace fnocc;
 
    diis functions
 
+   the boundary-point iterations are a fixed-point iteration in x and z.
+   DIIS extrapolates their square roots, (rx,rz), which are computed in
+   Update_xz, so the extrapolated x = rx^2 and z = rz^2 remain positive
+   semidefinite.  the error vector of each iteration is the change in
+   (rx,rz).  the vectors, the errors, and the overlaps of the errors are
+   kept in memory for the last maxdiis_ iterations, in a ring buffer; a
+   new error vector only adds one row to the overlap matrix.
+
 ================================================================*/
 
 namespace psi{ namespace v2rdm_casscf{
 
-// TODO: replace junk1/junk2
-void v2RDMSolver::DIIS(double*c,long int nvec,int replace_diis_iter){
-    long int nvar      = nvec+1;
-    long int * ipiv    = (long int*)malloc(nvar*sizeof(long int));
-    double * temp      = (double*)malloc(sizeof(double)*maxdiis_*maxdiis_);
-    double * A         = (double*)malloc(sizeof(double)*nvar*nvar);
-    double * B         = (double*)malloc(sizeof(double)*nvar);
-    memset((void*)A,'\0',nvar*nvar*sizeof(double));
-    memset((void*)B,'\0',nvar*sizeof(double));
-    B[nvec] = -1.;
-
-    char*evector=(char*)malloc(1000*sizeof(char));
-
-    std::shared_ptr<PSIO> psio(new PSIO());
-    psio->open(PSIF_DCC_EVEC,PSIO_OPEN_OLD);
-
-    // add row to matrix, don't build the whole thing.
-    psio->read_entry(PSIF_DCC_EVEC,"error matrix",(char*)&temp[0],maxdiis_*maxdiis_*sizeof(double));
-    for (long int i = 0; i < nvec; i++){
-        for (long int j = 0; j < nvec; j++){
-            A[i*nvar+j] = temp[i*maxdiis_+j];
-        }
-    }
-
-    if (nvec <= 3) {
-        for (long int i = 0; i < nvec; i++) {
-            sprintf(evector,"evector%li",i+1);
-            psio->read_entry(PSIF_DCC_EVEC,evector,(char*)&junk1[0],dimdiis_*sizeof(double));
-            for (long int j = i; j < nvec; j++){
-                sprintf(evector,"evector%li",j+1);
-                psio->read_entry(PSIF_DCC_EVEC,evector,(char*)&junk2[0],dimdiis_*sizeof(double));
-                double sum  = C_DDOT(dimdiis_,junk1,1,junk2,1);
-                A[i*nvar+j] = sum;
-                A[j*nvar+i] = sum;
-            }
-        }
-    }else {
-        long int i;
-        if (nvec<=maxdiis_ && diis_oiter_<=maxdiis_){
-            i = nvec - 1;
-        }
-        else{
-            i = replace_diis_iter - 1;
-        }
-        sprintf(evector,"evector%li",i+1);
-        psio->read_entry(PSIF_DCC_EVEC,evector,(char*)&junk1[0],dimdiis_*sizeof(double));
-        for (long int j = 0; j < nvec; j++){
-            sprintf(evector,"evector%li",j+1);
-            psio->read_entry(PSIF_DCC_EVEC,evector,(char*)&junk2[0],dimdiis_*sizeof(double));
-            double sum  = C_DDOT(dimdiis_,junk1,1,junk2,1);
-            A[i*nvar+j] = sum;
-            A[j*nvar+i] = sum;
-        }
-    }
-
-    long int j = nvec;
-    for (long int i = 0; i < nvar; i++){
-        A[j*nvar+i] = -1.0;
-        A[i*nvar+j] = -1.0;
+// forget the stored vectors (when mu or the orbitals change, the
+// fixed-point map changes, too).  the first call with DIIS enabled also
+// allocates the workspace for the DIIS equations, so that DIIS_Extrapolate
+// doesn't allocate
+void v2RDMSolver::DIIS_Reset(){
+    diis_iter_    = 0;
+    diis_have_in_ = false;
+    if ( diis_vec_ && !diis_A_ ) {
+        diis_A_    = (double*)malloc((maxdiis_ + 1) * (maxdiis_ + 1) * sizeof(double));
+        diis_ipiv_ = (long int*)malloc((maxdiis_ + 1) * sizeof(long int));
     }
-    A[nvar*nvar-1] = 0.;
-
-    // save matrix for next iteration
-    for (long int i = 0; i < nvec; i++){
-        for (long int j = 0; j < nvec; j++){
-            temp[i*maxdiis_+j] = A[i*nvar+j];
-        }
-    }
-    psio->write_entry(PSIF_DCC_EVEC,"error matrix",(char*)&temp[0],maxdiis_*maxdiis_*sizeof(double));
-    free(temp);
-    psio->close(PSIF_DCC_EVEC,1);
-    free(evector);
-
-    long int nrhs,lda,ldb,info;
-    nrhs = 1;
-    lda = ldb = nvar;
-    info = 0;
-    DGESV(nvar,nrhs,A,lda,ipiv,B,ldb,info);
-    C_DCOPY(nvec,B,1,c,1);
-
-    free(A);
-    free(B);
-    free(ipiv);
-    psio.reset();
 }
 
-void v2RDMSolver::DIIS_WriteOldVector(long int iter,int diis_iter,int replace_diis_iter){
-
-    char*oldvector=(char*)malloc(1000*sizeof(char));
-
-    if (diis_iter<=maxdiis_ && iter<=maxdiis_){
-       sprintf(oldvector,"oldvector%i",diis_iter);
-    }
-    else{
-       sprintf(oldvector,"oldvector%i",replace_diis_iter);
-    }
-
-    std::shared_ptr<PSIO> psio(new PSIO());
-    if (diis_iter==0) {
-       psio->open(PSIF_DCC_OVEC,PSIO_OPEN_NEW);
-    }else {
-       psio->open(PSIF_DCC_OVEC,PSIO_OPEN_OLD);
-    }
-
-    psio_address addr;
-    addr = PSIO_ZERO;
+// store (rx,rz) and its change from the input of this iteration, and make
+// it the input of the next one
+void v2RDMSolver::DIIS_WriteVector(){
 
-    psio->write(PSIF_DCC_OVEC,oldvector,(char*)&rx->pointer()[0],dimdiis_*sizeof(double),addr,&addr);
-    psio->write(PSIF_DCC_OVEC,oldvector,(char*)&rz->pointer()[0],dimdiis_*sizeof(double),addr,&addr);
-    psio->close(PSIF_DCC_OVEC,1);
-    psio.reset();
+    double * rx_p = rx->pointer();
+    double * rz_p = rz->pointer();
 
-    free(oldvector);
-}
-void v2RDMSolver::DIIS_WriteErrorVector(int diis_iter,int replace_diis_iter,int iter){
+    if ( diis_have_in_ ) {
+        long int k = diis_iter_ % maxdiis_;
+        double * v = diis_vec_ + k * dimdiis_;
+        double * e = diis_err_ + k * dimdiis_;
 
-    char*evector   = (char*)malloc(1000*sizeof(char));
-    if (diis_iter<=maxdiis_ && iter<=maxdiis_){
-       sprintf(evector,"evector%i",diis_iter);
-    }
-    else{
-       sprintf(evector,"evector%i",replace_diis_iter);
-    }
+        C_DCOPY(dimx_,rx_p,1,v,1);
+        C_DCOPY(dimx_,rz_p,1,v + dimx_,1);
+        for (long int i = 0; i < dimdiis_; i++) {
+            e[i] = v[i] - diis_in_[i];
+        }
 
-    std::shared_ptr<PSIO> psio(new PSIO());
-    if (diis_iter==0) {
-       psio->open(PSIF_DCC_EVEC,PSIO_OPEN_NEW);
-       double * temp = (double*)malloc(maxdiis_*maxdiis_*sizeof(double));
-       memset((void*)temp,'\0',maxdiis_*maxdiis_*sizeof(double));
-       psio->write_entry(PSIF_DCC_EVEC,"error matrix",(char*)&temp[0],maxdiis_*maxdiis_*sizeof(double));
-       free(temp);
-    }
-    else {
-       psio->open(PSIF_DCC_EVEC,PSIO_OPEN_OLD);
+        // new row of the overlap matrix
+        diis_iter_++;
+        long int nvec = diis_iter_ < maxdiis_ ? diis_iter_ : maxdiis_;
+        for (long int j = 0; j < nvec; j++) {
+            double dum = C_DDOT(dimdiis_,e,1,diis_err_ + j * dimdiis_,1);
+            diis_b_[k * maxdiis_ + j] = dum;
+            diis_b_[j * maxdiis_ + k] = dum;
+        }
     }
 
-    psio_address addr;
-    addr = PSIO_ZERO;
-
-    psio->write(PSIF_DCC_EVEC,evector,(char*)&rx_error->pointer()[0],dimdiis_*sizeof(double),addr,&addr);
-    psio->write(PSIF_DCC_EVEC,evector,(char*)&rz_error->pointer()[0],dimdiis_*sizeof(double),addr,&addr);
-
-    psio->close(PSIF_DCC_EVEC,1);
-    psio.reset();
-
-    free(evector);
+    C_DCOPY(dimx_,rx_p,1,diis_in_,1);
+    C_DCOPY(dimx_,rz_p,1,diis_in_ + dimx_,1);
+    diis_have_in_ = true;
 }
-void v2RDMSolver::DIIS_Extrapolate(int diis_iter,int&replace_diis_iter){
-
-    char*oldvector;
-    oldvector=(char*)malloc(1000*sizeof(char));
 
-    std::shared_ptr<PSIO> psio(new PSIO());
-    psio->open(PSIF_DCC_OVEC,PSIO_OPEN_OLD);
+// extrapolate (rx,rz) from the stored vectors, and build x = rx^2 and
+// z = rz^2.  returns false if there are too few vectors or the DIIS
+// equations are singular
+bool v2RDMSolver::DIIS_Extrapolate(){
 
-    psio_address addr;
+    long int nvec = diis_iter_ < maxdiis_ ? diis_iter_ : maxdiis_;
+    if ( nvec < 2 ) return false;
 
-    memset((void*)rx->pointer(),'\0',dimdiis_*sizeof(double));
-    memset((void*)rz->pointer(),'\0',dimdiis_*sizeof(double));
+    // DIIS equations, scaled by the largest error overlap
+    long int nvar = nvec + 1;
+    double * A    = diis_A_;
 
-    long int max = diis_iter;
-    if (max > maxdiis_) max = maxdiis_;
+    double bmax = 0.0;
+    for (long int i = 0; i < nvec; i++) {
+        if ( diis_b_[i * maxdiis_ + i] > bmax ) bmax = diis_b_[i * maxdiis_ + i];
+    }
+    if ( bmax == 0.0 ) bmax = 1.0;
 
-    double min = 1.e9;
-    for (long int j=1; j<=max; j++){
-        addr = PSIO_ZERO;
-        sprintf(oldvector,"oldvector%li",j);
+    for (long int i = 0; i < nvec; i++) {
+        for (long int j = 0; j < nvec; j++) {
+            A[i * nvar + j] = diis_b_[i * maxdiis_ + j] / bmax;
+        }
+        A[i * nvar + nvec] = -1.0;
+        A[nvec * nvar + i] = -1.0;
+        diisvec_[i] = 0.0;
+    }
+    A[nvar * nvar - 1] = 0.0;
+    diisvec_[nvec] = -1.0;
 
-        psio->read(PSIF_DCC_OVEC,oldvector,(char*)&junk1[0],dimdiis_*sizeof(double),addr,&addr);
-        C_DAXPY(dimdiis_,diisvec_[j-1],junk1,1,rx->pointer(),1);
+    long int nrhs = 1;
+    long int lda  = nvar;
+    long int ldb  = nvar;
+    long int info = 0;
+    DGESV(nvar,nrhs,A,lda,diis_ipiv_,diisvec_,ldb,info);
 
-        psio->read(PSIF_DCC_OVEC,oldvector,(char*)&junk1[0],dimdiis_*sizeof(double),addr,&addr);
-        C_DAXPY(dimdiis_,diisvec_[j-1],junk1,1,rz->pointer(),1);
+    if ( info != 0 ) return false;
 
-        //if ( fabs( diisvec[j-1] ) < min ) {
-        //    min = fabs( diisvec[j-1] );
-        //    replace_diis_iter = j;
-        //}
+    // (rx,rz) is the input of the next iteration
+    memset((void*)diis_in_,'\0',dimdiis_ * sizeof(double));
+    for (long int j = 0; j < nvec; j++) {
+        C_DAXPY(dimdiis_,diisvec_[j],diis_vec_ + j * dimdiis_,1,diis_in_,1);
     }
-    psio->close(PSIF_DCC_OVEC,1);
-    free(oldvector);
 
-    // now, build x = rx^2, z = rz^2
     double * x_p  = x->pointer();
     double * z_p  = z->pointer();
-    double * rx_p = rx->pointer();
-    double * rz_p = rz->pointer();
+    double * rx_p = diis_in_;
+    double * rz_p = diis_in_ + dimx_;
 
     // loop over each block of x/z
     for (int i = 0; i < dimensions_.size(); i++) {
         if ( dimensions_[i] == 0 ) continue;
-        int myoffset = 0;
-        for (int j = 0; j < i; j++) {
-            myoffset += dimensions_[j] * dimensions_[j];
-        }
+        long int myoffset = block_offsets_[i];
         F_DGEMM('n','n',dimensions_[i],dimensions_[i],dimensions_[i],1.0,rx_p+myoffset,dimensions_[i],rx_p+myoffset,dimensions_[i],0.0,x_p+myoffset,dimensions_[i]);
         F_DGEMM('n','n',dimensions_[i],dimensions_[i],dimensions_[i],1.0,rz_p+myoffset,dimensions_[i],rz_p+myoffset,dimensions_[i],0.0,z_p+myoffset,dimensions_[i]);
     }
 
-    psio.reset();
+    return true;
 }
 
 }}
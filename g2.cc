@@ -40,6 +40,7 @@
 #include<time.h>
 
 #include"v2rdm_solver.h"
+#include"symmetry_policy.h"
 
 #ifdef _OPENMP
     #include<omp.h>
@@ -88,20 +89,20 @@ void v2RDMSolver::G2_constraints_guess_spin_adapted(SharedVector u){
                     int skj = ( k < j ? 1 : -1 );
 
 
-                    int ild = ibas_aa_sym[h2][i][l];
-                    int kjd = ibas_aa_sym[h2][k][j];
+                    int ild = ibas_aa(i,l);
+                    int kjd = ibas_aa(k,j);
                     dum       -=  u_p[d2aaoff[h2] + ild*gems_aa[h2]+kjd] * sil * skj * 0.5; // -D2aa(il,kj)
                     dum       -=  u_p[d2bboff[h2] + ild*gems_aa[h2]+kjd] * sil * skj * 0.5; // -D2bb(il,kj)
 
                 }
 
-                int ild = ibas_ab_sym[h2][i][l];
-                int jkd = ibas_ab_sym[h2][j][k];
+                int ild = ibas_ab(i,l);
+                int jkd = ibas_ab(j,k);
 
                 dum       +=  u_p[d2aboff[h2] + ild*gems_ab[h2]+jkd] * 0.5; // D2ab(il,jk)
 
-                int lid = ibas_ab_sym[h2][l][i];
-                int kjd = ibas_ab_sym[h2][k][j];
+                int lid = ibas_ab(l,i);
+                int kjd = ibas_ab(k,j);
 
                 dum       +=  u_p[d2aboff[h2] + lid*gems_ab[h2]+kjd] * 0.5; // D2ab(li,kj)
 
@@ -140,19 +141,19 @@ void v2RDMSolver::G2_constraints_guess_spin_adapted(SharedVector u){
                     int sil = ( i < l ? 1 : -1 );
                     int skj = ( k < j ? 1 : -1 );
 
-                    int ild = ibas_aa_sym[h2][i][l];
-                    int kjd = ibas_aa_sym[h2][k][j];
+                    int ild = ibas_aa(i,l);
+                    int kjd = ibas_aa(k,j);
                     dum       -=  u_p[d2aaoff[h2] + ild*gems_aa[h2]+kjd] * sil * skj * 0.5; // -D2aa(il,kj)
                     dum       -=  u_p[d2bboff[h2] + ild*gems_aa[h2]+kjd] * sil * skj * 0.5; // -D2bb(il,kj)
                 }
 
-                int ild = ibas_ab_sym[h2][i][l];
-                int jkd = ibas_ab_sym[h2][j][k];
+                int ild = ibas_ab(i,l);
+                int jkd = ibas_ab(j,k);
 
                 dum       -=  u_p[d2aboff[h2] + ild*gems_ab[h2]+jkd] * 0.5; // D2ab(il,jk)
 
-                int lid = ibas_ab_sym[h2][l][i];
-                int kjd = ibas_ab_sym[h2][k][j];
+                int lid = ibas_ab(l,i);
+                int kjd = ibas_ab(k,j);
 
                 dum       -=  u_p[d2aboff[h2] + lid*gems_ab[h2]+kjd] * 0.5; // D2ab(li,kj)
 
@@ -186,8 +187,8 @@ void v2RDMSolver::G2_constraints_guess_spin_adapted(SharedVector u){
 
                 int h2 = SymmetryPair(symmetry[i],symmetry[l]);
 
-                int ild = ibas_ab_sym[h2][i][l];
-                int kjd = ibas_ab_sym[h2][k][j];
+                int ild = ibas_ab(i,l);
+                int kjd = ibas_ab(k,j);
 
                 dum       -=  u_p[d2aboff[h2] + ild*gems_ab[h2]+kjd];   // - D2ab(il,kj)
 
@@ -221,8 +222,8 @@ void v2RDMSolver::G2_constraints_guess_spin_adapted(SharedVector u){
 
                 int h2 = SymmetryPair(symmetry[i],symmetry[l]);
 
-                int ild = ibas_ab_sym[h2][l][i];
-                int kjd = ibas_ab_sym[h2][j][k];
+                int ild = ibas_ab(l,i);
+                int kjd = ibas_ab(j,k);
 
                 dum       -=  u_p[d2aboff[h2] + ild*gems_ab[h2]+kjd];   // - D2ab(il,kj)
 
@@ -232,14 +233,18 @@ void v2RDMSolver::G2_constraints_guess_spin_adapted(SharedVector u){
         offset += gems_ab[h]*gems_ab[h];
     }
 }
-void v2RDMSolver::G2_constraints_Au_spin_adapted(SharedVector A,SharedVector u){
+template <class Symmetry>
+void v2RDMSolver::G2_constraints_Au_spin_adapted_kernel(SharedVector A,SharedVector u,const SkippedBlocks & skip){
+
+    Symmetry sym(nirrep_,symmetry,pitzer_offset,amopi_,table);
 
     double * A_p = A->pointer();
     double * u_p = u->pointer();
 
     // G200
-    for (int h = 0; h < nirrep_; h++) {
-        #pragma omp parallel for schedule (static)
+    for (int h = 0; h < sym.nirrep(); h++) {
+        long int myoffset = offset;
+        #pragma omp taskloop nogroup
         for (int ijg = 0; ijg < gems_ab[h]; ijg++) {
 
             int i = bas_ab_sym[h][ijg][0];
@@ -253,16 +258,16 @@ void v2RDMSolver::G2_constraints_Au_spin_adapted(SharedVector A,SharedVector u){
                 double dum = -u_p[g2soff[h] + ijg*gems_ab[h]+klg];          // - G2s(ij,kl)
 
                 if ( j == l ) {
-                    int h3 = symmetry[i];
-                    int ii = i - pitzer_offset[h3];
-                    int kk = k - pitzer_offset[h3];
-                    dum       +=  u_p[d1aoff[h3] + ii*amopi_[h3]+kk] * 0.5; //   D1(i,k) djl
-                    dum       +=  u_p[d1boff[h3] + ii*amopi_[h3]+kk] * 0.5; //   D1(i,k) djl
+                    int h3 = sym.irrep(i);
+                    int ii = i - sym.offset(h3);
+                    int kk = k - sym.offset(h3);
+                    dum       +=  u_p[d1aoff[h3] + ii*sym.size(h3)+kk] * 0.5; //   D1(i,k) djl
+                    dum       +=  u_p[d1boff[h3] + ii*sym.size(h3)+kk] * 0.5; //   D1(i,k) djl
                 }
 
-                int h2 = SymmetryPair(symmetry[i],symmetry[l]);
-                //int ils = ibas_00_sym[h2][i][l];
-                //int jks = ibas_00_sym[h2][j][k];
+                int h2 = sym.pair(sym.irrep(i),sym.irrep(l));
+                //int ils = ibas_00(i,l);
+                //int jks = ibas_00(j,k);
 
                 //dum       +=  u_p[d2soff[h2] + INDEX(ils,jks)] * 0.5; //   D2s(li,kj)
 
@@ -272,37 +277,38 @@ void v2RDMSolver::G2_constraints_Au_spin_adapted(SharedVector A,SharedVector u){
                     int skj = ( k < j ? 1 : -1 );
 
 
-                    int ild = ibas_aa_sym[h2][i][l];
-                    int kjd = ibas_aa_sym[h2][k][j];
+                    int ild = ibas_aa(i,l);
+                    int kjd = ibas_aa(k,j);
                     dum       -=  u_p[d2aaoff[h2] + ild*gems_aa[h2]+kjd] * sil * skj * 0.5; // -D2aa(il,kj)
                     dum       -=  u_p[d2bboff[h2] + ild*gems_aa[h2]+kjd] * sil * skj * 0.5; // -D2bb(il,kj)
 
-                    //int ilt = ibas_aa_sym[h2][i][l];
-                    //int kjt = ibas_aa_sym[h2][k][j];
+                    //int ilt = ibas_aa(i,l);
+                    //int kjt = ibas_aa(k,j);
                     //dum       -=  u_p[d2toff[h2]    + INDEX(ilt,kjt)] * sil * skj * 0.5; //   D210(il,kj)
                     //dum       -=  u_p[d2toff_p1[h2] + INDEX(ilt,kjt)] * sil * skj * 0.5; //   D211(il,kj)
                     //dum       -=  u_p[d2toff_m1[h2] + INDEX(ilt,kjt)] * sil * skj * 0.5; //   D21-1(il,kj)
 
                 }
 
-                int ild = ibas_ab_sym[h2][i][l];
-                int jkd = ibas_ab_sym[h2][j][k];
+                int ild = ibas_ab(i,l);
+                int jkd = ibas_ab(j,k);
 
                 dum       +=  u_p[d2aboff[h2] + ild*gems_ab[h2]+jkd] * 0.5; // D2ab(il,jk)
 
-                int lid = ibas_ab_sym[h2][l][i];
-                int kjd = ibas_ab_sym[h2][k][j];
+                int lid = ibas_ab(l,i);
+                int kjd = ibas_ab(k,j);
 
                 dum       +=  u_p[d2aboff[h2] + lid*gems_ab[h2]+kjd] * 0.5; // D2ab(li,kj)
 
-                A_p[offset + ijg*gems_ab[h]+klg] = dum;
+                A_p[myoffset + ijg*gems_ab[h]+klg] = dum;
             }
         }
         offset += gems_ab[h]*gems_ab[h];
     }
     // G210
-    for (int h = 0; h < nirrep_; h++) {
-        #pragma omp parallel for schedule (static)
+    for (int h = 0; h < sym.nirrep(); h++) {
+        long int myoffset = offset;
+        #pragma omp taskloop nogroup
         for (int ijg = 0; ijg < gems_ab[h]; ijg++) {
 
             int i = bas_ab_sym[h][ijg][0];
@@ -316,16 +322,16 @@ void v2RDMSolver::G2_constraints_Au_spin_adapted(SharedVector A,SharedVector u){
                 double dum = -u_p[g2toff[h] + ijg*gems_ab[h]+klg];          // - G2t(ij,kl)
 
                 if ( j == l ) {
-                    int h3 = symmetry[i];
-                    int ii = i - pitzer_offset[h3];
-                    int kk = k - pitzer_offset[h3];
-                    dum       +=  u_p[d1aoff[h3] + ii*amopi_[h3]+kk] * 0.5; //   D1(i,k) djl
-                    dum       +=  u_p[d1boff[h3] + ii*amopi_[h3]+kk] * 0.5; //   D1(i,k) djl
+                    int h3 = sym.irrep(i);
+                    int ii = i - sym.offset(h3);
+                    int kk = k - sym.offset(h3);
+                    dum       +=  u_p[d1aoff[h3] + ii*sym.size(h3)+kk] * 0.5; //   D1(i,k) djl
+                    dum       +=  u_p[d1boff[h3] + ii*sym.size(h3)+kk] * 0.5; //   D1(i,k) djl
                 }
 
-                int h2 = SymmetryPair(symmetry[i],symmetry[l]);
-                //int ils = ibas_00_sym[h2][i][l];
-                //int jks = ibas_00_sym[h2][j][k];
+                int h2 = sym.pair(sym.irrep(i),sym.irrep(l));
+                //int ils = ibas_00(i,l);
+                //int jks = ibas_00(j,k);
 
                 //dum       -=  u_p[d2soff[h2] + INDEX(ils,jks)] * 0.5; //   D2s(li,kj)
 
@@ -334,38 +340,39 @@ void v2RDMSolver::G2_constraints_Au_spin_adapted(SharedVector A,SharedVector u){
                     int sil = ( i < l ? 1 : -1 );
                     int skj = ( k < j ? 1 : -1 );
 
-                    int ild = ibas_aa_sym[h2][i][l];
-                    int kjd = ibas_aa_sym[h2][k][j];
+                    int ild = ibas_aa(i,l);
+                    int kjd = ibas_aa(k,j);
                     dum       -=  u_p[d2aaoff[h2] + ild*gems_aa[h2]+kjd] * sil * skj * 0.5; // -D2aa(il,kj)
                     dum       -=  u_p[d2bboff[h2] + ild*gems_aa[h2]+kjd] * sil * skj * 0.5; // -D2bb(il,kj)
 
-                    //int ilt = ibas_aa_sym[h2][i][l];
-                    //int kjt = ibas_aa_sym[h2][k][j];
+                    //int ilt = ibas_aa(i,l);
+                    //int kjt = ibas_aa(k,j);
                     //dum       +=  u_p[d2toff[h2]    + INDEX(ilt,kjt)] * sil * skj * 0.5; //   D210(il,kj)
                     //dum       -=  u_p[d2toff_p1[h2] + INDEX(ilt,kjt)] * sil * skj * 0.5; //   D211(il,kj)
                     //dum       -=  u_p[d2toff_m1[h2] + INDEX(ilt,kjt)] * sil * skj * 0.5; //   D21-1(il,kj)
 
                 }
 
-                int ild = ibas_ab_sym[h2][i][l];
-                int jkd = ibas_ab_sym[h2][j][k];
+                int ild = ibas_ab(i,l);
+                int jkd = ibas_ab(j,k);
 
                 dum       -=  u_p[d2aboff[h2] + ild*gems_ab[h2]+jkd] * 0.5; // D2ab(il,jk)
 
-                int lid = ibas_ab_sym[h2][l][i];
-                int kjd = ibas_ab_sym[h2][k][j];
+                int lid = ibas_ab(l,i);
+                int kjd = ibas_ab(k,j);
 
                 dum       -=  u_p[d2aboff[h2] + lid*gems_ab[h2]+kjd] * 0.5; // D2ab(li,kj)
 
-                A_p[offset + ijg*gems_ab[h]+klg] = dum;
+                A_p[myoffset + ijg*gems_ab[h]+klg] = dum;
             }
         }
         offset += gems_ab[h]*gems_ab[h];
     }
        
     // G211 constraints:
-    for (int h = 0; h < nirrep_; h++) {
-        #pragma omp parallel for schedule (static)
+    for (int h = 0; h < sym.nirrep(); h++) {
+        long int myoffset = offset;
+        #pragma omp taskloop nogroup
         for (int ijg = 0; ijg < gems_ab[h]; ijg++) {
 
             int i = bas_ab_sym[h][ijg][0];
@@ -379,22 +386,22 @@ void v2RDMSolver::G2_constraints_Au_spin_adapted(SharedVector A,SharedVector u){
                 double dum = -u_p[g2toff_p1[h] + ijg*gems_ab[h]+klg];    // - G2ab(ij,kl)
 
                 if ( j==l ) {
-                    int h3 = symmetry[i];
-                    int ii = i - pitzer_offset[h3];
-                    int kk = k - pitzer_offset[h3];
-                    dum   +=  u_p[d1aoff[h3] + ii*amopi_[h3]+kk];      //   D1(i,k) djl
+                    int h3 = sym.irrep(i);
+                    int ii = i - sym.offset(h3);
+                    int kk = k - sym.offset(h3);
+                    dum   +=  u_p[d1aoff[h3] + ii*sym.size(h3)+kk];      //   D1(i,k) djl
                 }
 
-                int h2 = SymmetryPair(symmetry[i],symmetry[l]);
+                int h2 = sym.pair(sym.irrep(i),sym.irrep(l));
 
-                int ild = ibas_ab_sym[h2][i][l];
-                int kjd = ibas_ab_sym[h2][k][j];
+                int ild = ibas_ab(i,l);
+                int kjd = ibas_ab(k,j);
 
                 dum       -=  u_p[d2aboff[h2] + ild*gems_ab[h2]+kjd];   // - D2ab(il,kj)
 
                 //int h2 = SymmetryPair(symmetry[i],symmetry[l]);
-                //int ils = ibas_00_sym[h2][i][l];
-                //int kjs = ibas_00_sym[h2][k][j];
+                //int ils = ibas_00(i,l);
+                //int kjs = ibas_00(k,j);
                 //dum       -=  u_p[d2soff[h2] + INDEX(ils,kjs)] * 0.5; //   D2s(li,kj)
 
                 //if ( i != l && k != j ) {
@@ -402,21 +409,22 @@ void v2RDMSolver::G2_constraints_Au_spin_adapted(SharedVector A,SharedVector u){
                 //    int sil = ( i < l ? 1 : -1 );
                 //    int skj = ( k < j ? 1 : -1 );
 
-                //    int ilt = ibas_aa_sym[h2][i][l];
-                //    int kjt = ibas_aa_sym[h2][k][j];
+                //    int ilt = ibas_aa(i,l);
+                //    int kjt = ibas_aa(k,j);
 
                 //    dum       -=  u_p[d2toff_p1[h2] + INDEX(ilt,kjt)] * sil * skj * 0.5; //   D211(il,kj)
 
                 //}
 
-                A_p[offset + ijg*gems_ab[h]+klg] = dum;
+                A_p[myoffset + ijg*gems_ab[h]+klg] = dum;
             }
         }
         offset += gems_ab[h]*gems_ab[h];
     }
     // G21-1 constraints:
-    for (int h = 0; h < nirrep_; h++) {
-        #pragma omp parallel for schedule (static)
+    for (int h = 0; h < sym.nirrep(); h++) {
+        long int myoffset = offset;
+        #pragma omp taskloop nogroup
         for (int ijg = 0; ijg < gems_ab[h]; ijg++) {
 
             int i = bas_ab_sym[h][ijg][0];
@@ -430,22 +438,22 @@ void v2RDMSolver::G2_constraints_Au_spin_adapted(SharedVector A,SharedVector u){
                 double dum = -u_p[g2toff_m1[h] + ijg*gems_ab[h]+klg];    // - G2ab(ij,kl)
 
                 if ( j == l ) {
-                    int h3 = symmetry[i];
-                    int ii = i - pitzer_offset[h3];
-                    int kk = k - pitzer_offset[h3];
-                    dum   +=  u_p[d1boff[h3] + ii*amopi_[h3]+kk];      //   D1(i,k) djl
+                    int h3 = sym.irrep(i);
+                    int ii = i - sym.offset(h3);
+                    int kk = k - sym.offset(h3);
+                    dum   +=  u_p[d1boff[h3] + ii*sym.size(h3)+kk];      //   D1(i,k) djl
                 }
 
-                int h2 = SymmetryPair(symmetry[i],symmetry[l]);
+                int h2 = sym.pair(sym.irrep(i),sym.irrep(l));
 
-                int ild = ibas_ab_sym[h2][l][i];
-                int kjd = ibas_ab_sym[h2][j][k];
+                int ild = ibas_ab(l,i);
+                int kjd = ibas_ab(j,k);
 
                 dum       -=  u_p[d2aboff[h2] + ild*gems_ab[h2]+kjd];   // - D2ab(il,kj)
 
                 //int h2 = SymmetryPair(symmetry[i],symmetry[l]);
-                //int ils = ibas_00_sym[h2][i][l];
-                //int kjs = ibas_00_sym[h2][k][j];
+                //int ils = ibas_00(i,l);
+                //int kjs = ibas_00(k,j);
                 //dum       -=  u_p[d2soff[h2] + INDEX(ils,kjs)] * 0.5; //   D2s(li,kj)
 
                 //if ( i != l && k != j ) {
@@ -453,14 +461,14 @@ void v2RDMSolver::G2_constraints_Au_spin_adapted(SharedVector A,SharedVector u){
                 //    int sil = ( i < l ? 1 : -1 );
                 //    int skj = ( k < j ? 1 : -1 );
 
-                //    int ilt = ibas_aa_sym[h2][i][l];
-                //    int kjt = ibas_aa_sym[h2][k][j];
+                //    int ilt = ibas_aa(i,l);
+                //    int kjt = ibas_aa(k,j);
 
                 //    dum       -=  u_p[d2toff_m1[h2] + INDEX(ilt,kjt)] * sil * skj * 0.5; //   D211(il,kj)
 
                 //}
 
-                A_p[offset + ijg*gems_ab[h]+klg] = dum;
+                A_p[myoffset + ijg*gems_ab[h]+klg] = dum;
             }
         }
         offset += gems_ab[h]*gems_ab[h];
@@ -469,7 +477,7 @@ void v2RDMSolver::G2_constraints_Au_spin_adapted(SharedVector A,SharedVector u){
     /*int na = nalpha_ - nrstc_ - nfrzc_;
     int nb = nbeta_ - nrstc_ - nfrzc_;
     int ms = (multiplicity_ - 1)/2;
-    for (int h = 0; h < nirrep_; h++) {
+    for (int h = 0; h < sym.nirrep(); h++) {
         for (int klg = 0; klg < gems_ab[h]; klg++) {
 
             int k = bas_ab_sym[h][klg][0];
@@ -496,7 +504,7 @@ void v2RDMSolver::G2_constraints_Au_spin_adapted(SharedVector A,SharedVector u){
     offset += amo_*amo_;*/
     
     // maximal spin constraint:
-    /*for (int h = 0; h < nirrep_; h++) {
+    /*for (int h = 0; h < sym.nirrep(); h++) {
         for (int klg = 0; klg < gems_ab[h]; klg++) {
 
             int k = bas_ab_sym[h][klg][0];
@@ -520,7 +528,7 @@ printf("%20.12lf\n",maxs);
         }
     }
     offset += amo_*amo_;
-    for (int h = 0; h < nirrep_; h++) {
+    for (int h = 0; h < sym.nirrep(); h++) {
         for (int klg = 0; klg < gems_ab[h]; klg++) {
 
             int k = bas_ab_sym[h][klg][0];
@@ -545,14 +553,21 @@ printf("%20.12lf\n",maxs);
     offset += amo_*amo_;*/
 
 }
+
+void v2RDMSolver::G2_constraints_Au_spin_adapted(SharedVector A,SharedVector u){
+    (this->*G2_constraints_Au_spin_adapted_fn_)(A,u,SkippedBlocks());
+}
 // G2 portion of A^T.y (spin adapted)
-void v2RDMSolver::G2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u){
+template <class Symmetry>
+void v2RDMSolver::G2_constraints_ATu_spin_adapted_kernel(SharedVector A,SharedVector u,const SkippedBlocks & skip){
+
+    Symmetry sym(nirrep_,symmetry,pitzer_offset,amopi_,table);
 
     double * A_p = A->pointer();
     double * u_p = u->pointer();
 
     // G200
-    for (int h = 0; h < nirrep_; h++) {
+    for (int h = 0; h < sym.nirrep(); h++) {
         for (int ijg = 0; ijg < gems_ab[h]; ijg++) {
 
             int i = bas_ab_sym[h][ijg][0];
@@ -568,16 +583,16 @@ void v2RDMSolver::G2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u)
                 A_p[g2soff[h] + ijg*gems_ab[h]+klg] -= dum;
 
                 if ( j == l ) {
-                    int h3 = symmetry[i];
-                    int ii = i - pitzer_offset[h3];
-                    int kk = k - pitzer_offset[h3];
-                    A_p[d1aoff[h3] + ii*amopi_[h3]+kk]         += 0.5 * dum;
-                    A_p[d1boff[h3] + ii*amopi_[h3]+kk]         += 0.5 * dum;
+                    int h3 = sym.irrep(i);
+                    int ii = i - sym.offset(h3);
+                    int kk = k - sym.offset(h3);
+                    A_p[d1aoff[h3] + ii*sym.size(h3)+kk]         += 0.5 * dum;
+                    A_p[d1boff[h3] + ii*sym.size(h3)+kk]         += 0.5 * dum;
                 }
 
                 //int h2 = SymmetryPair(symmetry[i],symmetry[l]);
-                //int ils = ibas_00_sym[h2][i][l];
-                //int jks = ibas_00_sym[h2][j][k];
+                //int ils = ibas_00(i,l);
+                //int jks = ibas_00(j,k);
                 //A_p[d2soff[h2] + INDEX(ils,jks)] += dum * 0.5;
 
                 if ( i != l && k != j ) {
@@ -585,30 +600,30 @@ void v2RDMSolver::G2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u)
                     int sil = ( i < l ? 1 : -1 );
                     int skj = ( k < j ? 1 : -1 );
 
-                    int h2 = SymmetryPair(symmetry[i],symmetry[l]);
+                    int h2 = sym.pair(sym.irrep(i),sym.irrep(l));
 
-                    int ild = ibas_aa_sym[h2][i][l];
-                    int kjd = ibas_aa_sym[h2][k][j];
+                    int ild = ibas_aa(i,l);
+                    int kjd = ibas_aa(k,j);
 
                     A_p[d2aaoff[h2] + ild*gems_aa[h2]+kjd] -= 0.5 * dum * sil * skj;
                     A_p[d2bboff[h2] + ild*gems_aa[h2]+kjd] -= 0.5 * dum * sil * skj;
 
-                    //int ilt = ibas_aa_sym[h2][i][l];
-                    //int kjt = ibas_aa_sym[h2][k][j];
+                    //int ilt = ibas_aa(i,l);
+                    //int kjt = ibas_aa(k,j);
                     //A_p[d2toff[h2]    + INDEX(ilt,kjt)] -= dum * sil * skj * 0.5; // 10
                     //A_p[d2toff_p1[h2] + INDEX(ilt,kjt)] -= dum * sil * skj * 0.5; // 11
                     //A_p[d2toff_m1[h2] + INDEX(ilt,kjt)] -= dum * sil * skj * 0.5; // 1-1
                 }
 
-                int h2 = SymmetryPair(symmetry[i],symmetry[l]);
+                int h2 = sym.pair(sym.irrep(i),sym.irrep(l));
 
-                int ild = ibas_ab_sym[h2][i][l];
-                int jkd = ibas_ab_sym[h2][j][k];
+                int ild = ibas_ab(i,l);
+                int jkd = ibas_ab(j,k);
 
                 A_p[d2aboff[h2] + ild*gems_ab[h2]+jkd] += 0.5 * dum;
 
-                int lid = ibas_ab_sym[h2][l][i];
-                int kjd = ibas_ab_sym[h2][k][j];
+                int lid = ibas_ab(l,i);
+                int kjd = ibas_ab(k,j);
 
                 A_p[d2aboff[h2] + lid*gems_ab[h2]+kjd] += 0.5 * dum;
             }
@@ -617,7 +632,7 @@ void v2RDMSolver::G2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u)
         offset += gems_ab[h]*gems_ab[h];
     }
     // G210
-    for (int h = 0; h < nirrep_; h++) {
+    for (int h = 0; h < sym.nirrep(); h++) {
         for (int ijg = 0; ijg < gems_ab[h]; ijg++) {
 
             int i = bas_ab_sym[h][ijg][0];
@@ -633,16 +648,16 @@ void v2RDMSolver::G2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u)
                 A_p[g2toff[h] + ijg*gems_ab[h]+klg] -= dum;
 
                 if ( j == l ) {
-                    int h3 = symmetry[i];
-                    int ii = i - pitzer_offset[h3];
-                    int kk = k - pitzer_offset[h3];
-                    A_p[d1aoff[h3] + ii*amopi_[h3]+kk]         += 0.5 * dum;
-                    A_p[d1boff[h3] + ii*amopi_[h3]+kk]         += 0.5 * dum;
+                    int h3 = sym.irrep(i);
+                    int ii = i - sym.offset(h3);
+                    int kk = k - sym.offset(h3);
+                    A_p[d1aoff[h3] + ii*sym.size(h3)+kk]         += 0.5 * dum;
+                    A_p[d1boff[h3] + ii*sym.size(h3)+kk]         += 0.5 * dum;
                 }
 
                 //int h2 = SymmetryPair(symmetry[i],symmetry[l]);
-                //int ils = ibas_00_sym[h2][i][l];
-                //int jks = ibas_00_sym[h2][j][k];
+                //int ils = ibas_00(i,l);
+                //int jks = ibas_00(j,k);
 
                 //A_p[d2soff[h2] + INDEX(ils,jks)] -= dum * 0.5;
 
@@ -651,8 +666,8 @@ void v2RDMSolver::G2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u)
                 //    int sil = ( i < l ? 1 : -1 );
                 //    int skj = ( k < j ? 1 : -1 );
 
-                //    int ilt = ibas_aa_sym[h2][i][l];
-                //    int kjt = ibas_aa_sym[h2][k][j];
+                //    int ilt = ibas_aa(i,l);
+                //    int kjt = ibas_aa(k,j);
 
                 //    A_p[d2toff[h2]    + INDEX(ilt,kjt)] += dum * sil * skj * 0.5; // 10
                 //    A_p[d2toff_p1[h2] + INDEX(ilt,kjt)] -= dum * sil * skj * 0.5; // 11
@@ -664,24 +679,24 @@ void v2RDMSolver::G2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u)
                     int sil = ( i < l ? 1 : -1 );
                     int skj = ( k < j ? 1 : -1 );
 
-                    int h2 = SymmetryPair(symmetry[i],symmetry[l]);
+                    int h2 = sym.pair(sym.irrep(i),sym.irrep(l));
 
-                    int ild = ibas_aa_sym[h2][i][l];
-                    int kjd = ibas_aa_sym[h2][k][j];
+                    int ild = ibas_aa(i,l);
+                    int kjd = ibas_aa(k,j);
 
                     A_p[d2aaoff[h2] + ild*gems_aa[h2]+kjd] -= 0.5 * dum * sil * skj;
                     A_p[d2bboff[h2] + ild*gems_aa[h2]+kjd] -= 0.5 * dum * sil * skj;
                 }
 
-                int h2 = SymmetryPair(symmetry[i],symmetry[l]);
+                int h2 = sym.pair(sym.irrep(i),sym.irrep(l));
 
-                int ild = ibas_ab_sym[h2][i][l];
-                int jkd = ibas_ab_sym[h2][j][k];
+                int ild = ibas_ab(i,l);
+                int jkd = ibas_ab(j,k);
 
                 A_p[d2aboff[h2] + ild*gems_ab[h2]+jkd] -= 0.5 * dum;
 
-                int lid = ibas_ab_sym[h2][l][i];
-                int kjd = ibas_ab_sym[h2][k][j];
+                int lid = ibas_ab(l,i);
+                int kjd = ibas_ab(k,j);
 
                 A_p[d2aboff[h2] + lid*gems_ab[h2]+kjd] -= 0.5 * dum;
             }
@@ -690,7 +705,7 @@ void v2RDMSolver::G2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u)
         offset += gems_ab[h]*gems_ab[h];
     }
     // G211 constraints:
-    for (int h = 0; h < nirrep_; h++) {
+    for (int h = 0; h < sym.nirrep(); h++) {
         for (int ijg = 0; ijg < gems_ab[h]; ijg++) {
 
             int i = bas_ab_sym[h][ijg][0];
@@ -706,22 +721,22 @@ void v2RDMSolver::G2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u)
                 A_p[g2toff_p1[h] + ijg*gems_ab[h]+klg] -= dum;    // - G2ab(ij,kl)
 
                 if ( j == l ) {
-                    int h3 = symmetry[i];
-                    int ii = i - pitzer_offset[h3];
-                    int kk = k - pitzer_offset[h3];
-                    A_p[d1aoff[h3] + ii*amopi_[h3]+kk] += dum;      //   D1(i,k) djl
+                    int h3 = sym.irrep(i);
+                    int ii = i - sym.offset(h3);
+                    int kk = k - sym.offset(h3);
+                    A_p[d1aoff[h3] + ii*sym.size(h3)+kk] += dum;      //   D1(i,k) djl
                 }
 
-                int h2 = SymmetryPair(symmetry[i],symmetry[l]);
+                int h2 = sym.pair(sym.irrep(i),sym.irrep(l));
 
-                int ild = ibas_ab_sym[h2][i][l];
-                int kjd = ibas_ab_sym[h2][k][j];
+                int ild = ibas_ab(i,l);
+                int kjd = ibas_ab(k,j);
 
                 A_p[d2aboff[h2] + ild*gems_ab[h2]+kjd] -= dum;   // - D2ab(il,kj)
 
                 //int h2 = SymmetryPair(symmetry[i],symmetry[l]);
-                //int ils = ibas_00_sym[h2][i][l];
-                //int kjs = ibas_00_sym[h2][k][j];
+                //int ils = ibas_00(i,l);
+                //int kjs = ibas_00(k,j);
                 //A_p[d2soff[h2] + INDEX(ils,kjs)]             -= dum * 0.5;
 
                 //if ( i != l && k != j ) {
@@ -729,8 +744,8 @@ void v2RDMSolver::G2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u)
                 //    int sil = ( i < l ? 1 : -1 );
                 //    int skj = ( k < j ? 1 : -1 );
 
-                //    int ilt = ibas_aa_sym[h2][i][l];
-                //    int kjt = ibas_aa_sym[h2][k][j];
+                //    int ilt = ibas_aa(i,l);
+                //    int kjt = ibas_aa(k,j);
 
                 //    A_p[d2toff_p1[h2] + INDEX(ilt,kjt)] -= dum * sil * skj * 0.5;
                 //}
@@ -739,7 +754,7 @@ void v2RDMSolver::G2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u)
         offset += gems_ab[h]*gems_ab[h];
     }
     // G21-1 constraints:
-    for (int h = 0; h < nirrep_; h++) {
+    for (int h = 0; h < sym.nirrep(); h++) {
         for (int ijg = 0; ijg < gems_ab[h]; ijg++) {
 
             int i = bas_ab_sym[h][ijg][0];
@@ -755,22 +770,22 @@ void v2RDMSolver::G2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u)
                 A_p[g2toff_m1[h] + ijg*gems_ab[h]+klg] -= dum;    // - G2ab(ij,kl)
 
                 if ( j == l ) {
-                    int h3 = symmetry[i];
-                    int ii = i - pitzer_offset[h3];
-                    int kk = k - pitzer_offset[h3];
-                    A_p[d1boff[h3] + ii*amopi_[h3]+kk] += dum;      //   D1(i,k) djl
+                    int h3 = sym.irrep(i);
+                    int ii = i - sym.offset(h3);
+                    int kk = k - sym.offset(h3);
+                    A_p[d1boff[h3] + ii*sym.size(h3)+kk] += dum;      //   D1(i,k) djl
                 }
 
-                int h2 = SymmetryPair(symmetry[i],symmetry[l]);
+                int h2 = sym.pair(sym.irrep(i),sym.irrep(l));
 
-                int ild = ibas_ab_sym[h2][l][i];
-                int kjd = ibas_ab_sym[h2][j][k];
+                int ild = ibas_ab(l,i);
+                int kjd = ibas_ab(j,k);
 
                 A_p[d2aboff[h2] + ild*gems_ab[h2]+kjd] -= dum;   // - D2ab(il,kj)
 
                 //int h2 = SymmetryPair(symmetry[i],symmetry[l]);
-                //int ils = ibas_00_sym[h2][i][l];
-                //int kjs = ibas_00_sym[h2][k][j];
+                //int ils = ibas_00(i,l);
+                //int kjs = ibas_00(k,j);
                 //A_p[d2soff[h2] + INDEX(ils,kjs)]             -= dum * 0.5;
 
                 //if ( i != l && k != j ) {
@@ -778,8 +793,8 @@ void v2RDMSolver::G2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u)
                 //    int sil = ( i < l ? 1 : -1 );
                 //    int skj = ( k < j ? 1 : -1 );
 
-                //    int ilt = ibas_aa_sym[h2][i][l];
-                //    int kjt = ibas_aa_sym[h2][k][j];
+                //    int ilt = ibas_aa(i,l);
+                //    int kjt = ibas_aa(k,j);
 
                 //    A_p[d2toff_m1[h2] + INDEX(ilt,kjt)] -= dum * sil * skj * 0.5;
                 //}
@@ -791,7 +806,7 @@ void v2RDMSolver::G2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u)
     /*int na = nalpha_ - nrstc_ - nfrzc_;
     int nb = nbeta_ - nrstc_ - nfrzc_;
     int ms = (multiplicity_ - 1)/2;
-    for (int h = 0; h < nirrep_; h++) {
+    for (int h = 0; h < sym.nirrep(); h++) {
         for (int klg = 0; klg < gems_ab[h]; klg++) {
     
             int k = bas_ab_sym[h][klg][0];
@@ -813,7 +828,7 @@ void v2RDMSolver::G2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u)
     }
     offset += amo_*amo_;*/
     // maximal spin constraint:
-    /*for (int h = 0; h < nirrep_; h++) {
+    /*for (int h = 0; h < sym.nirrep(); h++) {
         for (int klg = 0; klg < gems_ab[h]; klg++) {
 
             int k = bas_ab_sym[h][klg][0];
@@ -833,7 +848,7 @@ void v2RDMSolver::G2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u)
         }
     }
     offset += amo_*amo_;
-    for (int h = 0; h < nirrep_; h++) {
+    for (int h = 0; h < sym.nirrep(); h++) {
         for (int klg = 0; klg < gems_ab[h]; klg++) {
 
             int k = bas_ab_sym[h][klg][0];
@@ -855,6 +870,10 @@ void v2RDMSolver::G2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u)
     offset += amo_*amo_;*/
 }
 
+void v2RDMSolver::G2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u){
+    (this->*G2_constraints_ATu_spin_adapted_fn_)(A,u,SkippedBlocks());
+}
+
 void v2RDMSolver::G2_constraints_guess(SharedVector u){
 
     double* u_p = u->pointer();
@@ -882,8 +901,8 @@ void v2RDMSolver::G2_constraints_guess(SharedVector u){
                 }
 
                 int h2 = SymmetryPair(symmetry[i],symmetry[l]);
-                int ild = ibas_ab_sym[h2][i][l];
-                int kjd = ibas_ab_sym[h2][k][j];
+                int ild = ibas_ab(i,l);
+                int kjd = ibas_ab(k,j);
 
                 dum       -=  u_p[d2aboff[h2] + ild*gems_ab[h2]+kjd];   // - D2ab(il,kj)
 
@@ -915,8 +934,8 @@ void v2RDMSolver::G2_constraints_guess(SharedVector u){
                 }
 
                 int h2 = SymmetryPair(symmetry[i],symmetry[l]);
-                int lid = ibas_ab_sym[h2][l][i];
-                int jkd = ibas_ab_sym[h2][j][k];
+                int lid = ibas_ab(l,i);
+                int jkd = ibas_ab(j,k);
 
                 dum    -=  u_p[d2aboff[h2] + lid*gems_ab[h2]+jkd];       //   -D2ab(li,jk)
 
@@ -955,8 +974,8 @@ void v2RDMSolver::G2_constraints_guess(SharedVector u){
                     int sil = ( i < l ? 1 : -1 );
                     int skj = ( k < j ? 1 : -1 );
 
-                    int ild = ibas_aa_sym[h2][i][l];
-                    int kjd = ibas_aa_sym[h2][k][j];
+                    int ild = ibas_aa(i,l);
+                    int kjd = ibas_aa(k,j);
 
                     dum       -=  u_p[d2aaoff[h2] + ild*gems_aa[h2]+kjd] * sil * skj; // -D2aa(il,kj)
 
@@ -993,8 +1012,8 @@ void v2RDMSolver::G2_constraints_guess(SharedVector u){
                     int sil = ( i < l ? 1 : -1 );
                     int skj = ( k < j ? 1 : -1 );
 
-                    int ild = ibas_aa_sym[h2][i][l];
-                    int kjd = ibas_aa_sym[h2][k][j];
+                    int ild = ibas_aa(i,l);
+                    int kjd = ibas_aa(k,j);
 
                     dum       -=  u_p[d2bboff[h2] + ild*gems_aa[h2]+kjd] * sil * skj; // -D2bb(il,kj)
 
@@ -1020,8 +1039,8 @@ void v2RDMSolver::G2_constraints_guess(SharedVector u){
 
                 double dum = 0.0;
 
-                int ild = ibas_ab_sym[h2][i][l];
-                int jkd = ibas_ab_sym[h2][j][k];
+                int ild = ibas_ab(i,l);
+                int jkd = ibas_ab(j,k);
 
                 dum       +=  u_p[d2aboff[h2] + ild*gems_ab[h2]+jkd]; // D2ab(il,jk)
 
@@ -1045,8 +1064,8 @@ void v2RDMSolver::G2_constraints_guess(SharedVector u){
 
                 double dum = 0.0;
 
-                int lid = ibas_ab_sym[h2][l][i];
-                int kjd = ibas_ab_sym[h2][k][j];
+                int lid = ibas_ab(l,i);
+                int kjd = ibas_ab(k,j);
 
                 dum       +=  u_p[d2aboff[h2] + lid*gems_ab[h2]+kjd]; // D2ab(li,kj)
 
@@ -1058,14 +1077,19 @@ void v2RDMSolver::G2_constraints_guess(SharedVector u){
 }
 
 // G2 portion of A.x (with symmetry)
-void v2RDMSolver::G2_constraints_Au(SharedVector A,SharedVector u){
+template <class Symmetry>
+void v2RDMSolver::G2_constraints_Au_kernel(SharedVector A,SharedVector u,const SkippedBlocks & skip){
+
+    Symmetry sym(nirrep_,symmetry,pitzer_offset,amopi_,table);
+    bool skip_g2 = skip.g2;
     double* A_p = A->pointer();
     double* u_p = u->pointer();
 
     // G2ab constraints:
 // heyheyhey
-    for (int h = 0; h < nirrep_; h++) {
-        #pragma omp parallel for schedule (static)
+    for (int h = 0; h < sym.nirrep(); h++) {
+        long int myoffset = offset;
+        #pragma omp taskloop nogroup
         for (int ijg = 0; ijg < gems_ab[h]; ijg++) {
 
             int i = bas_ab_sym[h][ijg][0];
@@ -1077,29 +1101,30 @@ void v2RDMSolver::G2_constraints_Au(SharedVector A,SharedVector u){
                 int l = bas_ab_sym[h][klg][1];
 
 
-                double dum = -u_p[g2aboff[h] + ijg*gems_ab[h]+klg];    // - G2ab(ij,kl)
+                double dum = skip_g2 ? 0.0 : -u_p[g2aboff[h] + ijg*gems_ab[h]+klg];    // - G2ab(ij,kl)
 
                 if ( j==l ) {
-                    int h3 = symmetry[i];
-                    int ii = i - pitzer_offset[h3];
-                    int kk = k - pitzer_offset[h3];
-                    dum   +=  u_p[d1aoff[h3] + ii*amopi_[h3]+kk];      //   D1(i,k) djl
+                    int h3 = sym.irrep(i);
+                    int ii = i - sym.offset(h3);
+                    int kk = k - sym.offset(h3);
+                    dum   +=  u_p[d1aoff[h3] + ii*sym.size(h3)+kk];      //   D1(i,k) djl
                 }
 
-                int h2 = SymmetryPair(symmetry[i],symmetry[l]);
-                int ild = ibas_ab_sym[h2][i][l];
-                int kjd = ibas_ab_sym[h2][k][j];
+                int h2 = sym.pair(sym.irrep(i),sym.irrep(l));
+                int ild = ibas_ab(i,l);
+                int kjd = ibas_ab(k,j);
 
                 dum       -=  u_p[d2aboff[h2] + ild*gems_ab[h2]+kjd];   // - D2ab(il,kj)
 
-                A_p[offset + ijg*gems_ab[h]+klg] = dum;
+                A_p[myoffset + ijg*gems_ab[h]+klg] = dum;
             }
         }
         offset += gems_ab[h]*gems_ab[h];
     }
     // G2ba constraints:
-    for (int h = 0; h < nirrep_; h++) {
-        #pragma omp parallel for schedule (static)
+    for (int h = 0; h < sym.nirrep(); h++) {
+        long int myoffset = offset;
+        #pragma omp taskloop nogroup
         for (int ijg = 0; ijg < gems_ab[h]; ijg++) {
 
             int i = bas_ab_sym[h][ijg][0];
@@ -1110,30 +1135,31 @@ void v2RDMSolver::G2_constraints_Au(SharedVector A,SharedVector u){
                 int k = bas_ab_sym[h][klg][0];
                 int l = bas_ab_sym[h][klg][1];
 
-                double dum = -u_p[g2baoff[h] + ijg*gems_ab[h]+klg];        // - G2ba(ij,kl)
+                double dum = skip_g2 ? 0.0 : -u_p[g2baoff[h] + ijg*gems_ab[h]+klg];        // - G2ba(ij,kl)
 
                 if ( j==l ) {
-                    int h3 = symmetry[i];
-                    int ii = i - pitzer_offset[h3];
-                    int kk = k - pitzer_offset[h3];
-                    dum       +=  u_p[d1boff[h3] + ii*amopi_[h3]+kk];      //   D1(i,k) djl
+                    int h3 = sym.irrep(i);
+                    int ii = i - sym.offset(h3);
+                    int kk = k - sym.offset(h3);
+                    dum       +=  u_p[d1boff[h3] + ii*sym.size(h3)+kk];      //   D1(i,k) djl
                 }
 
-                int h2 = SymmetryPair(symmetry[i],symmetry[l]);
-                int lid = ibas_ab_sym[h2][l][i];
-                int jkd = ibas_ab_sym[h2][j][k];
+                int h2 = sym.pair(sym.irrep(i),sym.irrep(l));
+                int lid = ibas_ab(l,i);
+                int jkd = ibas_ab(j,k);
 
                 dum    -=  u_p[d2aboff[h2] + lid*gems_ab[h2]+jkd];       //   -D2ab(li,jk)
 
-                A_p[offset + ijg*gems_ab[h]+klg] = dum;
+                A_p[myoffset + ijg*gems_ab[h]+klg] = dum;
             }
         }
         offset += gems_ab[h]*gems_ab[h];
     }
     // G2aaaa / G2aabb / G2bbaa / G2bbbb
-    for (int h = 0; h < nirrep_; h++) {
+    for (int h = 0; h < sym.nirrep(); h++) {
         // G2aaaa
-        #pragma omp parallel for schedule (static)
+        long int myoffset = offset;
+        #pragma omp taskloop nogroup
         for (int ijg = 0; ijg < gems_ab[h]; ijg++) {
 
             int i = bas_ab_sym[h][ijg][0];
@@ -1144,14 +1170,14 @@ void v2RDMSolver::G2_constraints_Au(SharedVector A,SharedVector u){
                 int k = bas_ab_sym[h][klg][0];
                 int l = bas_ab_sym[h][klg][1];
 
-                int h2 = SymmetryPair(symmetry[i],symmetry[l]);
+                int h2 = sym.pair(sym.irrep(i),sym.irrep(l));
 
-                double dum = -u_p[g2aaoff[h] + ijg*2*gems_ab[h]+klg];       // - G2aaaa(ij,kl)
+                double dum = skip_g2 ? 0.0 : -u_p[g2aaoff[h] + ijg*2*gems_ab[h]+klg];       // - G2aaaa(ij,kl)
                 if ( j == l ) {
-                    int h3 = symmetry[i];
-                    int ii = i - pitzer_offset[h3];
-                    int kk = k - pitzer_offset[h3];
-                    dum       +=  u_p[d1aoff[h3] + ii*amopi_[h3]+kk];    //   D1(i,k) djl
+                    int h3 = sym.irrep(i);
+                    int ii = i - sym.offset(h3);
+                    int kk = k - sym.offset(h3);
+                    dum       +=  u_p[d1aoff[h3] + ii*sym.size(h3)+kk];    //   D1(i,k) djl
                 }
 
                 if ( i != l && k != j ) {
@@ -1159,18 +1185,18 @@ void v2RDMSolver::G2_constraints_Au(SharedVector A,SharedVector u){
                     int sil = ( i < l ? 1 : -1 );
                     int skj = ( k < j ? 1 : -1 );
 
-                    int ild = ibas_aa_sym[h2][i][l];
-                    int kjd = ibas_aa_sym[h2][k][j];
+                    int ild = ibas_aa(i,l);
+                    int kjd = ibas_aa(k,j);
 
                     dum       -=  u_p[d2aaoff[h2] + ild*gems_aa[h2]+kjd] * sil * skj; // -D2aa(il,kj)
 
                 }
 
-                A_p[offset + ijg*2*gems_ab[h]+klg] = dum;
+                A_p[myoffset + ijg*2*gems_ab[h]+klg] = dum;
             }
         }
         // G2bbbb
-        #pragma omp parallel for schedule (static)
+        #pragma omp taskloop nogroup
         for (int ijg = 0; ijg < gems_ab[h]; ijg++) {
 
             int i = bas_ab_sym[h][ijg][0];
@@ -1181,14 +1207,14 @@ void v2RDMSolver::G2_constraints_Au(SharedVector A,SharedVector u){
                 int k = bas_ab_sym[h][klg][0];
                 int l = bas_ab_sym[h][klg][1];
 
-                int h2 = SymmetryPair(symmetry[i],symmetry[l]);
+                int h2 = sym.pair(sym.irrep(i),sym.irrep(l));
 
-                double dum = -u_p[g2aaoff[h] + (gems_ab[h] + ijg)*2*gems_ab[h] + (gems_ab[h] + klg)]; // - G2bbbb(ij,kl)
+                double dum = skip_g2 ? 0.0 : -u_p[g2aaoff[h] + (gems_ab[h] + ijg)*2*gems_ab[h] + (gems_ab[h] + klg)]; // - G2bbbb(ij,kl)
                 if ( j == l ) {
-                    int h3 = symmetry[i];
-                    int ii = i - pitzer_offset[h3];
-                    int kk = k - pitzer_offset[h3];
-                    dum       +=  u_p[d1boff[h3] + ii*amopi_[h3]+kk];    //   D1(i,k) djl
+                    int h3 = sym.irrep(i);
+                    int ii = i - sym.offset(h3);
+                    int kk = k - sym.offset(h3);
+                    dum       +=  u_p[d1boff[h3] + ii*sym.size(h3)+kk];    //   D1(i,k) djl
                 }
 
                 if ( i != l && k != j ) {
@@ -1196,18 +1222,18 @@ void v2RDMSolver::G2_constraints_Au(SharedVector A,SharedVector u){
                     int sil = ( i < l ? 1 : -1 );
                     int skj = ( k < j ? 1 : -1 );
 
-                    int ild = ibas_aa_sym[h2][i][l];
-                    int kjd = ibas_aa_sym[h2][k][j];
+                    int ild = ibas_aa(i,l);
+                    int kjd = ibas_aa(k,j);
 
                     dum       -=  u_p[d2bboff[h2] + ild*gems_aa[h2]+kjd] * sil * skj; // -D2bb(il,kj)
 
                 }
 
-                A_p[offset + (gems_ab[h] + ijg)*2*gems_ab[h] + (gems_ab[h] + klg)] = dum;
+                A_p[myoffset + (gems_ab[h] + ijg)*2*gems_ab[h] + (gems_ab[h] + klg)] = dum;
             }
         }
         // G2aabb
-        #pragma omp parallel for schedule (static)
+        #pragma omp taskloop nogroup
         for (int ijg = 0; ijg < gems_ab[h]; ijg++) {
 
             int i = bas_ab_sym[h][ijg][0];
@@ -1218,20 +1244,20 @@ void v2RDMSolver::G2_constraints_Au(SharedVector A,SharedVector u){
                 int k = bas_ab_sym[h][klg][0];
                 int l = bas_ab_sym[h][klg][1];
 
-                int h2 = SymmetryPair(symmetry[i],symmetry[l]);
+                int h2 = sym.pair(sym.irrep(i),sym.irrep(l));
 
-                double dum = -u_p[g2aaoff[h] + (ijg)*2*gems_ab[h] + (gems_ab[h] + klg)];       // - G2aabb(ij,kl)
+                double dum = skip_g2 ? 0.0 : -u_p[g2aaoff[h] + (ijg)*2*gems_ab[h] + (gems_ab[h] + klg)];       // - G2aabb(ij,kl)
 
-                int ild = ibas_ab_sym[h2][i][l];
-                int jkd = ibas_ab_sym[h2][j][k];
+                int ild = ibas_ab(i,l);
+                int jkd = ibas_ab(j,k);
 
                 dum       +=  u_p[d2aboff[h2] + ild*gems_ab[h2]+jkd]; // D2ab(il,jk)
 
-                A_p[offset + (ijg)*2*gems_ab[h] + (gems_ab[h] + klg)] = dum;
+                A_p[myoffset + (ijg)*2*gems_ab[h] + (gems_ab[h] + klg)] = dum;
             }
         }
         // G2bbaa
-        #pragma omp parallel for schedule (static)
+        #pragma omp taskloop nogroup
         for (int ijg = 0; ijg < gems_ab[h]; ijg++) {
 
             int i = bas_ab_sym[h][ijg][0];
@@ -1242,16 +1268,16 @@ void v2RDMSolver::G2_constraints_Au(SharedVector A,SharedVector u){
                 int k = bas_ab_sym[h][klg][0];
                 int l = bas_ab_sym[h][klg][1];
 
-                int h2 = SymmetryPair(symmetry[i],symmetry[l]);
+                int h2 = sym.pair(sym.irrep(i),sym.irrep(l));
 
-                double dum = -u_p[g2aaoff[h] + (gems_ab[h] + ijg)*2*gems_ab[h] + (klg)];       // - G2bbaa(ij,kl)
+                double dum = skip_g2 ? 0.0 : -u_p[g2aaoff[h] + (gems_ab[h] + ijg)*2*gems_ab[h] + (klg)];       // - G2bbaa(ij,kl)
 
-                int lid = ibas_ab_sym[h2][l][i];
-                int kjd = ibas_ab_sym[h2][k][j];
+                int lid = ibas_ab(l,i);
+                int kjd = ibas_ab(k,j);
 
                 dum       +=  u_p[d2aboff[h2] + lid*gems_ab[h2]+kjd]; // D2ab(li,kj)
 
-                A_p[offset + (gems_ab[h] + ijg)*2*gems_ab[h] + (klg)] = dum;
+                A_p[myoffset + (gems_ab[h] + ijg)*2*gems_ab[h] + (klg)] = dum;
             }
         }
         offset += 2*gems_ab[h]*2*gems_ab[h];
@@ -1261,7 +1287,7 @@ void v2RDMSolver::G2_constraints_Au(SharedVector A,SharedVector u){
     /*for (int kl = 0; kl < gems_ab[0]; kl++) {
         double dum = 0.0;
         for (int i = 0; i < amo_; i++) {
-            int ii = ibas_ab_sym[0][i][i];
+            int ii = ibas_ab(i,i);
             dum += u_p[g2aboff[0] + kl*gems_ab[0]+ii];
         }
         A_p[offset + kl] = dum;
@@ -1270,22 +1296,34 @@ void v2RDMSolver::G2_constraints_Au(SharedVector A,SharedVector u){
     for (int kl = 0; kl < gems_ab[0]; kl++) {
         double dum = 0.0;
         for (int i = 0; i < amo_; i++) {
-            int ii = ibas_ab_sym[0][i][i];
+            int ii = ibas_ab(i,i);
             dum += u_p[g2aboff[0] + ii*gems_ab[0]+kl];
         }
         A_p[offset + kl] = dum;
     }*/
 }
 
+void v2RDMSolver::G2_constraints_Au(SharedVector A,SharedVector u){
+    (this->*G2_constraints_Au_fn_)(A,u,SkippedBlocks());
+}
+
+void v2RDMSolver::G2_constraints_Au(SharedVector A,SharedVector u,const SkippedBlocks & skip){
+    (this->*G2_constraints_Au_fn_)(A,u,skip);
+}
+
 // G2 portion of A^T.y (with symmetry)
-void v2RDMSolver::G2_constraints_ATu(SharedVector A,SharedVector u){
+template <class Symmetry>
+void v2RDMSolver::G2_constraints_ATu_kernel(SharedVector A,SharedVector u,const SkippedBlocks & skip){
+
+    Symmetry sym(nirrep_,symmetry,pitzer_offset,amopi_,table);
+    bool skip_g2 = skip.g2;
 
     double* A_p = A->pointer();
     double* u_p = u->pointer();
 
     // G2ab constraints:
 // heyheyhey
-    for (int h = 0; h < nirrep_; h++) {
+    for (int h = 0; h < sym.nirrep(); h++) {
         for (int ijg = 0; ijg < gems_ab[h]; ijg++) {
 
             int i = bas_ab_sym[h][ijg][0];
@@ -1298,18 +1336,18 @@ void v2RDMSolver::G2_constraints_ATu(SharedVector A,SharedVector u){
 
                 double dum = u_p[offset + ijg*gems_ab[h]+klg];
 
-                A_p[g2aboff[h] + ijg*gems_ab[h]+klg] -= dum;    // - G2ab(ij,kl)
+                if ( !skip_g2 ) A_p[g2aboff[h] + ijg*gems_ab[h]+klg] -= dum;    // - G2ab(ij,kl)
 
                 if ( j == l ) {
-                    int h3 = symmetry[i];
-                    int ii = i - pitzer_offset[h3];
-                    int kk = k - pitzer_offset[h3];
-                    A_p[d1aoff[h3] + ii*amopi_[h3]+kk] += dum;      //   D1(i,k) djl
+                    int h3 = sym.irrep(i);
+                    int ii = i - sym.offset(h3);
+                    int kk = k - sym.offset(h3);
+                    A_p[d1aoff[h3] + ii*sym.size(h3)+kk] += dum;      //   D1(i,k) djl
                 }
 
-                int h2 = SymmetryPair(symmetry[i],symmetry[l]);
-                int ild = ibas_ab_sym[h2][i][l];
-                int kjd = ibas_ab_sym[h2][k][j];
+                int h2 = sym.pair(sym.irrep(i),sym.irrep(l));
+                int ild = ibas_ab(i,l);
+                int kjd = ibas_ab(k,j);
 
                 A_p[d2aboff[h2] + ild*gems_ab[h2]+kjd] -= dum;   // - D2ab(il,kj)
             }
@@ -1317,7 +1355,7 @@ void v2RDMSolver::G2_constraints_ATu(SharedVector A,SharedVector u){
         offset += gems_ab[h]*gems_ab[h];
     }
     // G2ba constraints:
-    for (int h = 0; h < nirrep_; h++) {
+    for (int h = 0; h < sym.nirrep(); h++) {
         for (int ijg = 0; ijg < gems_ab[h]; ijg++) {
 
             int i = bas_ab_sym[h][ijg][0];
@@ -1330,18 +1368,18 @@ void v2RDMSolver::G2_constraints_ATu(SharedVector A,SharedVector u){
 
                 double dum = u_p[offset + ijg*gems_ab[h]+klg];
 
-                A_p[g2baoff[h] + ijg*gems_ab[h]+klg]  -= dum;
+                if ( !skip_g2 ) A_p[g2baoff[h] + ijg*gems_ab[h]+klg]  -= dum;
 
                 if ( j == l ) {
-                    int h3 = symmetry[i];
-                    int ii = i - pitzer_offset[h3];
-                    int kk = k - pitzer_offset[h3];
-                    A_p[d1boff[h3] + ii*amopi_[h3]+kk]      += dum;
+                    int h3 = sym.irrep(i);
+                    int ii = i - sym.offset(h3);
+                    int kk = k - sym.offset(h3);
+                    A_p[d1boff[h3] + ii*sym.size(h3)+kk]      += dum;
                 }
 
-                int h2 = SymmetryPair(symmetry[i],symmetry[l]);
-                int lid = ibas_ab_sym[h2][l][i];
-                int jkd = ibas_ab_sym[h2][j][k];
+                int h2 = sym.pair(sym.irrep(i),sym.irrep(l));
+                int lid = ibas_ab(l,i);
+                int jkd = ibas_ab(j,k);
 
                 A_p[d2aboff[h2] + lid*gems_ab[h2]+jkd] -= dum;
             }
@@ -1349,7 +1387,7 @@ void v2RDMSolver::G2_constraints_ATu(SharedVector A,SharedVector u){
         offset += gems_ab[h]*gems_ab[h];
     }
     // G2aaaa / G2aabb / G2bbaa / G2bbbb constraints:
-    for (int h = 0; h < nirrep_; h++) {
+    for (int h = 0; h < sym.nirrep(); h++) {
         // G2aaaa
         for (int ijg = 0; ijg < gems_ab[h]; ijg++) {
 
@@ -1363,13 +1401,13 @@ void v2RDMSolver::G2_constraints_ATu(SharedVector A,SharedVector u){
 
                 double dum = u_p[offset + ijg*2*gems_ab[h]+klg];
 
-                A_p[g2aaoff[h] + ijg*2*gems_ab[h]+klg] -= dum;
+                if ( !skip_g2 ) A_p[g2aaoff[h] + ijg*2*gems_ab[h]+klg] -= dum;
 
                 if ( j == l ) {
-                    int h3 = symmetry[i];
-                    int ii = i - pitzer_offset[h3];
-                    int kk = k - pitzer_offset[h3];
-                    A_p[d1aoff[h3] + ii*amopi_[h3]+kk]         += dum;
+                    int h3 = sym.irrep(i);
+                    int ii = i - sym.offset(h3);
+                    int kk = k - sym.offset(h3);
+                    A_p[d1aoff[h3] + ii*sym.size(h3)+kk]         += dum;
                 }
 
                 if ( i != l && k != j ) {
@@ -1377,10 +1415,10 @@ void v2RDMSolver::G2_constraints_ATu(SharedVector A,SharedVector u){
                     int sil = ( i < l ? 1 : -1 );
                     int skj = ( k < j ? 1 : -1 );
 
-                    int h2 = SymmetryPair(symmetry[i],symmetry[l]);
+                    int h2 = sym.pair(sym.irrep(i),sym.irrep(l));
 
-                    int ild = ibas_aa_sym[h2][i][l];
-                    int kjd = ibas_aa_sym[h2][k][j];
+                    int ild = ibas_aa(i,l);
+                    int kjd = ibas_aa(k,j);
 
                     A_p[d2aaoff[h2] + ild*gems_aa[h2]+kjd] -= dum * sil * skj;
                 }
@@ -1399,13 +1437,13 @@ void v2RDMSolver::G2_constraints_ATu(SharedVector A,SharedVector u){
 
                 double dum = u_p[offset + (gems_ab[h] + ijg)*2*gems_ab[h]+(gems_ab[h] + klg)];
 
-                A_p[g2aaoff[h] + (gems_ab[h] + ijg)*2*gems_ab[h]+(gems_ab[h] + klg)] -= dum;
+                if ( !skip_g2 ) A_p[g2aaoff[h] + (gems_ab[h] + ijg)*2*gems_ab[h]+(gems_ab[h] + klg)] -= dum;
 
                 if ( j == l ) {
-                    int h3 = symmetry[i];
-                    int ii = i - pitzer_offset[h3];
-                    int kk = k - pitzer_offset[h3];
-                    A_p[d1boff[h3] + ii*amopi_[h3]+kk]         += dum;
+                    int h3 = sym.irrep(i);
+                    int ii = i - sym.offset(h3);
+                    int kk = k - sym.offset(h3);
+                    A_p[d1boff[h3] + ii*sym.size(h3)+kk]         += dum;
                 }
 
                 if ( i != l && k != j ) {
@@ -1413,10 +1451,10 @@ void v2RDMSolver::G2_constraints_ATu(SharedVector A,SharedVector u){
                     int sil = ( i < l ? 1 : -1 );
                     int skj = ( k < j ? 1 : -1 );
 
-                    int h2 = SymmetryPair(symmetry[i],symmetry[l]);
+                    int h2 = sym.pair(sym.irrep(i),sym.irrep(l));
 
-                    int ild = ibas_aa_sym[h2][i][l];
-                    int kjd = ibas_aa_sym[h2][k][j];
+                    int ild = ibas_aa(i,l);
+                    int kjd = ibas_aa(k,j);
 
                     A_p[d2bboff[h2] + ild*gems_aa[h2]+kjd] -= dum * sil * skj;
                 }
@@ -1435,12 +1473,12 @@ void v2RDMSolver::G2_constraints_ATu(SharedVector A,SharedVector u){
 
                 double dum = u_p[offset + ijg*2*gems_ab[h]+(klg + gems_ab[h])];
 
-                A_p[g2aaoff[h] + ijg*2*gems_ab[h]+(klg + gems_ab[h])] -= dum;
+                if ( !skip_g2 ) A_p[g2aaoff[h] + ijg*2*gems_ab[h]+(klg + gems_ab[h])] -= dum;
 
-                int h2 = SymmetryPair(symmetry[i],symmetry[l]);
+                int h2 = sym.pair(sym.irrep(i),sym.irrep(l));
 
-                int ild = ibas_ab_sym[h2][i][l];
-                int jkd = ibas_ab_sym[h2][j][k];
+                int ild = ibas_ab(i,l);
+                int jkd = ibas_ab(j,k);
 
                 A_p[d2aboff[h2] + ild*gems_ab[h2]+jkd] += dum;
             }
@@ -1458,12 +1496,12 @@ void v2RDMSolver::G2_constraints_ATu(SharedVector A,SharedVector u){
 
                 double dum = u_p[offset + (ijg + gems_ab[h])*2*gems_ab[h]+klg];
 
-                A_p[g2aaoff[h] + (ijg + gems_ab[h])*2*gems_ab[h]+klg] -= dum;
+                if ( !skip_g2 ) A_p[g2aaoff[h] + (ijg + gems_ab[h])*2*gems_ab[h]+klg] -= dum;
 
-                int h2 = SymmetryPair(symmetry[i],symmetry[l]);
+                int h2 = sym.pair(sym.irrep(i),sym.irrep(l));
 
-                int lid = ibas_ab_sym[h2][l][i];
-                int kjd = ibas_ab_sym[h2][k][j];
+                int lid = ibas_ab(l,i);
+                int kjd = ibas_ab(k,j);
 
                 A_p[d2aboff[h2] + lid*gems_ab[h2]+kjd] += dum;
             }
@@ -1476,7 +1514,7 @@ void v2RDMSolver::G2_constraints_ATu(SharedVector A,SharedVector u){
     /*for (int kl = 0; kl < gems_ab[0]; kl++) {
         double dum = u_p[offset + kl];
         for (int i = 0; i < amo_; i++) {
-            int ii = ibas_ab_sym[0][i][i];
+            int ii = ibas_ab(i,i);
             A_p[g2aboff[0] + kl*gems_ab[0]+ii] += dum;
         }
     }
@@ -1484,11 +1522,29 @@ void v2RDMSolver::G2_constraints_ATu(SharedVector A,SharedVector u){
     for (int kl = 0; kl < gems_ab[0]; kl++) {
         double dum = u_p[offset + kl];
         for (int i = 0; i < amo_; i++) {
-            int ii = ibas_ab_sym[0][i][i];
+            int ii = ibas_ab(i,i);
             A_p[g2aboff[0] + ii*gems_ab[0]+kl] += dum;
         }
     }
     offset += gems_ab[0];*/
 }
 
+void v2RDMSolver::G2_constraints_ATu(SharedVector A,SharedVector u){
+    (this->*G2_constraints_ATu_fn_)(A,u,SkippedBlocks());
+}
+
+void v2RDMSolver::G2_constraints_ATu(SharedVector A,SharedVector u,const SkippedBlocks & skip){
+    (this->*G2_constraints_ATu_fn_)(A,u,skip);
+}
+
+// C1 and point-group instantiations (selected in common_init)
+template void v2RDMSolver::G2_constraints_Au_spin_adapted_kernel<C1Symmetry>(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+template void v2RDMSolver::G2_constraints_ATu_spin_adapted_kernel<C1Symmetry>(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+template void v2RDMSolver::G2_constraints_Au_kernel<C1Symmetry>(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+template void v2RDMSolver::G2_constraints_ATu_kernel<C1Symmetry>(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+template void v2RDMSolver::G2_constraints_Au_spin_adapted_kernel<PointGroupSymmetry>(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+template void v2RDMSolver::G2_constraints_ATu_spin_adapted_kernel<PointGroupSymmetry>(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+template void v2RDMSolver::G2_constraints_Au_kernel<PointGroupSymmetry>(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+template void v2RDMSolver::G2_constraints_ATu_kernel<PointGroupSymmetry>(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+
 }} // end namespaces
@@ -0,0 +1,169 @@
+/*
+ *@BEGIN LICENSE
+ *
+ * v2RDM-CASSCF, a plugin to:
+ *
+ * Psi4: an open-source quantum chemistry software package
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (c) 2014, The Florida State University. All rights reserved.
+ *
+ *@END LICENSE
+ *
+ */
+
+#include <psi4/psi4-dec.h>
+#include <psi4/liboptions/liboptions.h>
+#include <psi4/libpsi4util/PsiOutStream.h>
+
+#include<psi4/libmints/wavefunction.h>
+#include<psi4/libmints/vector.h>
+
+#include<math.h>
+
+#include"v2rdm_solver.h"
+
+using namespace psi;
+
+namespace psi{ namespace v2rdm_casscf{
+
+// forget the history of the controller (at the start of the iterations
+// and when the orbitals change)
+void v2RDMSolver::ResetMuController(int oiter) {
+    mu_log_ratio_  = 0.0;
+    mu_nsamples_   = 0;
+    mu_last_update_ = oiter;
+    mu_best_error_ = -1.0;
+    mu_best_iter_  = oiter;
+    mu_gap_ref_    = -1.0;
+    mu_rate_       = 1.0;
+    mu_error_prev_ = -1.0;
+    cg_last_update_ = oiter;
+}
+
+// update the penalty parameter, mu, after iteration oiter.  returns true if
+// mu changed.
+//
+// MU_UPDATE = FIXED: mu = mu * ep / ed every MU_UPDATE_FREQUENCY iterations.
+//
+// MU_UPDATE = ADAPTIVE: the boundary-point iterations converge fastest when
+// the primal and dual errors, ep and ed, decrease together, so mu is
+// steered by their ratio.  the ratio fluctuates from one iteration to the
+// next, so its logarithm is averaged (exponentially, with weight 0.1 for
+// the newest value), and mu is multiplied by the averaged ratio only if it
+// lies outside a band around 1 (hysteresis), and not within 25 iterations
+// of the previous change, which gives the averages time to reflect it.
+// the band is [1/10,10] while the larger error decreases steadily, and
+// shrinks to [1/1.5,1.5] when it stalls (no 10% reduction in 100
+// iterations) or when the energy gap has grown since the last change.  mu
+// is changed by at most a factor of 10 at once, and at least every
+// MU_UPDATE_FREQUENCY iterations, as in the fixed scheme.
+//
+// the same controller chooses the CG forcing term, the ratio of the CG
+// convergence threshold to the smaller error: if the averaged (geometric
+// mean) reduction of the larger error per iteration is too slow (above 0.995), the linear
+// solutions are tightened by a factor of 2, and if it is fast (below 0.95)
+// they are relaxed by a factor of 2, within [1e-4,0.1], at most every 25
+// iterations.
+//
+// each decision is printed.
+bool v2RDMSolver::UpdateMu(int oiter, double ep, double ed, double egap, int frequency) {
+
+    if ( !adaptive_mu_ ) {
+        if ( oiter % frequency != 0 || oiter == 0 ) return false;
+        mu = mu*ep/ed;
+        return true;
+    }
+
+    const double weight       = 0.1;
+    const int    min_interval = 25;
+    const int    stall_window = 100;
+    const double wide_band    = log(10.0);
+    const double narrow_band  = log(1.5);
+    const double max_step     = log(10.0);
+    const double forcing_min  = 1.0e-4;
+    const double forcing_max  = 0.1;
+
+    if ( ep <= 0.0 || ed <= 0.0 ) return false;
+
+    // averaged log(ep/ed)
+    double lr = log(ep / ed);
+    mu_log_ratio_ = ( mu_nsamples_ == 0 ) ? lr : ( 1.0 - weight ) * mu_log_ratio_ + weight * lr;
+    mu_nsamples_++;
+
+    // progress in the larger error, and its averaged rate of reduction
+    double error = ( ep > ed ) ? ep : ed;
+    if ( mu_best_error_ < 0.0 || error < 0.9 * mu_best_error_ ) {
+        mu_best_error_ = error;
+        mu_best_iter_  = oiter;
+    }
+    if ( mu_error_prev_ > 0.0 ) {
+        mu_rate_ = pow(mu_rate_, 1.0 - weight) * pow(error / mu_error_prev_, weight);
+    }
+    mu_error_prev_ = error;
+    // (the gap is not known before the first iteration)
+    if ( mu_gap_ref_ <= 0.0 ) mu_gap_ref_ = egap;
+
+    // CG forcing term
+    if ( oiter - cg_last_update_ >= min_interval ) {
+        double old = cg_forcing_;
+        if ( mu_rate_ > 0.995 && cg_forcing_ > forcing_min ) {
+            cg_forcing_ = ( 0.5 * cg_forcing_ > forcing_min ) ? 0.5 * cg_forcing_ : forcing_min;
+        }else if ( mu_rate_ < 0.95 && cg_forcing_ < forcing_max ) {
+            cg_forcing_ = ( 2.0 * cg_forcing_ < forcing_max ) ? 2.0 * cg_forcing_ : forcing_max;
+        }
+        if ( cg_forcing_ != old ) {
+            outfile->Printf("      CG forcing term: %9.2le -> %9.2le (error reduction per iteration %7.4lf)\n",
+                old,cg_forcing_,mu_rate_);
+            cg_last_update_ = oiter;
+        }
+    }
+
+    // mu
+    if ( oiter - mu_last_update_ < min_interval ) return false;
+
+    bool stalled = ( oiter - mu_best_iter_ >= stall_window );
+    bool gap_up  = ( mu_gap_ref_ > 0.0 && egap > mu_gap_ref_ );
+    bool forced  = ( oiter - mu_last_update_ >= frequency );
+    double band  = ( stalled || gap_up ) ? narrow_band : wide_band;
+
+    if ( fabs(mu_log_ratio_) <= band && !forced ) return false;
+
+    double step = mu_log_ratio_;
+    if ( step >  max_step ) step =  max_step;
+    if ( step < -max_step ) step = -max_step;
+
+    const char * reason = forced  ? "interval"
+                        : ( fabs(mu_log_ratio_) > wide_band ) ? "imbalance"
+                        : stalled ? "stalled"
+                        : "gap increasing";
+
+    double old = mu;
+    mu *= exp(step);
+    outfile->Printf("      mu: %9.2le -> %9.2le (averaged ep/ed %9.2le, %s)\n",old,mu,exp(mu_log_ratio_),reason);
+
+    // the averages restart from the new balance
+    mu_log_ratio_   = 0.0;
+    mu_nsamples_    = 0;
+    mu_last_update_ = oiter;
+    mu_best_error_  = error;
+    mu_best_iter_   = oiter;
+    mu_gap_ref_     = egap;
+
+    return true;
+}
+
+}} // end namespaces
@@ -0,0 +1,215 @@
+/*
+ *@BEGIN LICENSE
+ *
+ * v2RDM-CASSCF, a plugin to:
+ *
+ * Psi4: an open-source quantum chemistry software package
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (c) 2014, The Florida State University. All rights reserved.
+ *
+ *@END LICENSE
+ *
+ */
+
+#include <psi4/psi4-dec.h>
+#include <psi4/liboptions/liboptions.h>
+#include <psi4/libqt/qt.h>
+#include <psi4/libpsi4util/PsiOutStream.h>
+
+#include<psi4/libmints/wavefunction.h>
+#include<psi4/libmints/vector.h>
+#include<psi4/libmints/matrix.h>
+
+#include<math.h>
+#include<limits.h>
+
+#include"v2rdm_solver.h"
+#include"sparse_matrix.h"
+#include"sparse_cholesky.h"
+
+#ifdef _OPENMP
+    #include<omp.h>
+#else
+    #define omp_get_wtime() ( (double)clock() / CLOCKS_PER_SEC )
+    #define omp_get_max_threads() 1
+#endif
+
+using namespace psi;
+
+namespace psi{ namespace v2rdm_casscf{
+
+// jacobi preconditioner for the CG solution of A.A^T.y = b
+//
+// the diagonal of A.A^T is the squared norm of each row of A.  for the D2,
+// Q2, and G2 rows, the norms are accumulated during a counting pass of the
+// sparse assembly (see sparse_constraints.cc), so they are exact and no
+// matrix is stored.  the T1, T2, and D3 rows are enumerated in the same
+// order as in the matrix-free A.u.
+void v2RDMSolver::BuildPreconditioner() {
+
+    double start = omp_get_wtime();
+
+    cg_precon_ = SharedVector(new Vector("CG preconditioner",nconstraints_));
+    double * d = cg_precon_->pointer();
+
+    AATDiagonal(d);
+
+    // invert.  an empty row leaves the corresponding element unscaled
+    double dmin = 0.0;
+    double dmax = 0.0;
+    long int nempty = 0;
+    for (long int i = 0; i < nconstraints_; i++) {
+        if ( d[i] == 0.0 ) {
+            d[i] = 1.0;
+            nempty++;
+            continue;
+        }
+        if ( dmin == 0.0 || d[i] < dmin ) dmin = d[i];
+        if ( d[i] > dmax ) dmax = d[i];
+        d[i] = 1.0 / d[i];
+    }
+
+    outfile->Printf("\n");
+    outfile->Printf("  ==> CG preconditioner <==\n");
+    outfile->Printf("\n");
+    outfile->Printf("        Type:                          %10s\n","JACOBI");
+    outfile->Printf("        Smallest diagonal of A.A^T:    %10.2le\n",dmin);
+    outfile->Printf("        Largest diagonal of A.A^T:     %10.2le\n",dmax);
+    if ( nempty > 0 ) {
+        outfile->Printf("        Empty rows:                    %10li\n",nempty);
+    }
+    outfile->Printf("        Time for construction:         %7.2lf s\n",omp_get_wtime() - start);
+    outfile->Printf("\n");
+}
+
+void v2RDMSolver::AATDiagonal(double * d) {
+
+    // D2, Q2, G2
+    std::shared_ptr<SparseMatrix> A (new SparseMatrix(nconstraints_d2q2g2_,dimx_));
+    A->set_row_norms(d);
+    A->begin_assembly(true);
+    D2Q2G2_constraints_sparse(A);
+    A->end_assembly();
+
+    // T1, T2, D3
+    if ( constrain_t1_ ) {
+        offset = nconstraints_d2q2g2_;
+        T1_constraints_AAT_diagonal(d);
+    }
+    if ( constrain_t2_ ) {
+        offset = nconstraints_d2q2g2t1_;
+        T2_constraints_AAT_diagonal(d);
+    }
+    if ( constrain_d3_ ) {
+        offset = nconstraints_d2q2g2t1t2_;
+        D3_constraints_AAT_diagonal(d);
+    }
+    offset = nconstraints_;
+}
+
+// presolve for the CG solution of A.A^T.y = b
+//
+// the D2 and D1 mappings (traces, contractions, and spin conditions) make
+// some rows of A linearly dependent, so A.A^T is singular.  the dependent
+// D2, Q2, and G2 rows are identified by a cholesky factorization of their
+// part of A.A^T, ordered by minimum degree, in which the pivots of
+// dependent rows vanish (see sparse_cholesky.cc).  the factor is discarded;
+// the T1, T2, and D3 rows are not checked.  b is consistent, so the dropped
+// rows can be given zero dual values without changing A^T.y.
+//
+// the remaining rows are scaled to unit norm, S = diag(A.A^T)^(-1/2), and
+// CG is applied to (S.A).(S.A)^T.y' = S.b, with y = S.y' in the original
+// numbering of the constraints.  only the linear solve sees the scaled
+// rows; the errors in the primal and dual solutions refer to A and b.
+void v2RDMSolver::BuildPresolve() {
+
+    if ( row_scale_ ) return;
+
+    double start = omp_get_wtime();
+
+    outfile->Printf("\n");
+    outfile->Printf("  ==> Constraint presolve <==\n");
+    outfile->Printf("\n");
+
+    row_scale_   = SharedVector(new Vector("row scaling",nconstraints_));
+    row_scale_u_ = SharedVector(new Vector("S.u",nconstraints_));
+    double * s = row_scale_->pointer();
+
+    AATDiagonal(s);
+
+    // dependent rows
+    long int ndropped = 0;
+    bool checked = false;
+    if ( dimx_ <= INT_MAX && nconstraints_d2q2g2_ <= INT_MAX ) {
+        std::shared_ptr<SparseMatrix> A = A_sparse_;
+        if ( !A ) {
+            A = AssembleSparseConstraints();
+        }
+
+        std::shared_ptr<SparseCholesky> chol (new SparseCholesky());
+        long int max_nnz = 0;
+        if ( A ) {
+            chol->form_normal_matrix(A.get());
+            A.reset();
+
+            double mem_aat = SparseCholesky::memory(chol->n(),chol->nnz_matrix());
+            max_nnz = (long int)( ( (double)available_memory_ - mem_aat ) / ( sizeof(int) + sizeof(double) ) );
+        }
+
+        if ( max_nnz > 0 && chol->analyze(max_nnz) ) {
+            chol->factorize();
+            for (long int i = 0; i < nconstraints_d2q2g2_; i++) {
+                if ( chol->dropped(i) ) {
+                    s[i] = 0.0;
+                    ndropped++;
+                }
+            }
+            checked = true;
+        }
+    }
+
+    // scale.  empty rows are dropped, too
+    double dmin = 0.0;
+    double dmax = 0.0;
+    long int nempty = 0;
+    for (long int i = 0; i < nconstraints_; i++) {
+        if ( s[i] == 0.0 ) {
+            if ( i >= nconstraints_d2q2g2_ || !checked ) nempty++;
+            continue;
+        }
+        if ( dmin == 0.0 || s[i] < dmin ) dmin = s[i];
+        if ( s[i] > dmax ) dmax = s[i];
+        s[i] = 1.0 / sqrt(s[i]);
+    }
+
+    outfile->Printf("        Smallest diagonal of A.A^T:    %10.2le\n",dmin);
+    outfile->Printf("        Largest diagonal of A.A^T:     %10.2le\n",dmax);
+    if ( checked ) {
+        outfile->Printf("        Linearly dependent rows of A:  %10li\n",ndropped);
+    }else {
+        outfile->Printf("        Dependent rows of A were not checked.\n");
+    }
+    if ( nempty > 0 ) {
+        outfile->Printf("        Empty rows:                    %10li\n",nempty);
+    }
+    outfile->Printf("        Time for presolve:             %7.2lf s\n",omp_get_wtime() - start);
+    outfile->Printf("\n");
+
+    available_memory_ -= 2L * nconstraints_ * sizeof(double);
+}
+
+}} // end namespaces
@@ -40,6 +40,7 @@
 #include<time.h>
 
 #include"v2rdm_solver.h"
+#include"symmetry_policy.h"
 
 #ifdef _OPENMP
     #include<omp.h>
@@ -64,16 +65,16 @@ void v2RDMSolver::Q2_constraints_guess_spin_adapted(SharedVector u){
         for (int ij = 0; ij < gems_00[h]; ij++) {
             int i = bas_00_sym[h][ij][0];
             int j = bas_00_sym[h][ij][1];
-            int ijd = ibas_ab_sym[h][i][j];
-            int jid = ibas_ab_sym[h][j][i];
+            int ijd = ibas_ab(i,j);
+            int jid = ibas_ab(j,i);
             for (int kl = 0; kl < gems_00[h]; kl++) {
                 int k = bas_00_sym[h][kl][0];
                 int l = bas_00_sym[h][kl][1];
 
                 double dum  = 0.0;
 
-                int kld = ibas_ab_sym[h][k][l];
-                int lkd = ibas_ab_sym[h][l][k];
+                int kld = ibas_ab(k,l);
+                int lkd = ibas_ab(l,k);
                 dum        +=  0.5 * u_p[d2aboff[h] + kld*gems_ab[h]+ijd];          // +D2(kl,ij)
                 dum        +=  0.5 * u_p[d2aboff[h] + lkd*gems_ab[h]+ijd];          // +D2(lk,ij)
                 dum        +=  0.5 * u_p[d2aboff[h] + kld*gems_ab[h]+jid];          // +D2(kl,ji)
@@ -118,8 +119,8 @@ void v2RDMSolver::Q2_constraints_guess_spin_adapted(SharedVector u){
         for (int ij = 0; ij < gems_aa[h]; ij++) {
             int i   =  bas_aa_sym[h][ij][0];
             int j   =  bas_aa_sym[h][ij][1];
-            int ijd = ibas_ab_sym[h][i][j];
-            int jid = ibas_ab_sym[h][j][i];
+            int ijd = ibas_ab(i,j);
+            int jid = ibas_ab(j,i);
             for (int kl = 0; kl < gems_aa[h]; kl++) {
                 int   k =  bas_aa_sym[h][kl][0];
                 int   l =  bas_aa_sym[h][kl][1];
@@ -127,8 +128,8 @@ void v2RDMSolver::Q2_constraints_guess_spin_adapted(SharedVector u){
                 double dum  = 0.0;
 
                 // not spin adapted
-                int kld = ibas_ab_sym[h][k][l];
-                int lkd = ibas_ab_sym[h][l][k];
+                int kld = ibas_ab(k,l);
+                int lkd = ibas_ab(l,k);
                 dum        +=  0.5 * u_p[d2aboff[h] + kld*gems_ab[h]+ijd];          // +D2(kl,ij)
                 dum        -=  0.5 * u_p[d2aboff[h] + lkd*gems_ab[h]+ijd];          // -D2(lk,ij)
                 dum        -=  0.5 * u_p[d2aboff[h] + kld*gems_ab[h]+jid];          // -D2(kl,ji)
@@ -257,28 +258,33 @@ void v2RDMSolver::Q2_constraints_guess_spin_adapted(SharedVector u){
     }
 }
 
-void v2RDMSolver::Q2_constraints_Au_spin_adapted(SharedVector A,SharedVector u){
+template <class Symmetry>
+void v2RDMSolver::Q2_constraints_Au_spin_adapted_kernel(SharedVector A,SharedVector u,const SkippedBlocks & skip){
+
+    Symmetry sym(nirrep_,symmetry,pitzer_offset,amopi_,table);
+    bool skip_q2 = skip.q2;
 
     double * A_p = A->pointer();
     double * u_p = u->pointer();
 
     // map D2ab to Q2s
-    for (int h = 0; h < nirrep_; h++) {
-        #pragma omp parallel for schedule (static)
+    for (int h = 0; h < sym.nirrep(); h++) {
+        long int myoffset = offset;
+        #pragma omp taskloop nogroup
         for (int ij = 0; ij < gems_00[h]; ij++) {
             int i = bas_00_sym[h][ij][0];
             int j = bas_00_sym[h][ij][1];
-            int ijd = ibas_ab_sym[h][i][j];
-            int jid = ibas_ab_sym[h][j][i];
+            int ijd = ibas_ab(i,j);
+            int jid = ibas_ab(j,i);
             for (int kl = 0; kl < gems_00[h]; kl++) {
                 int k = bas_00_sym[h][kl][0];
                 int l = bas_00_sym[h][kl][1];
 
-                double dum  = -u_p[q2soff[h] + ij*gems_00[h]+kl];          // -Q2(ij,kl)
+                double dum  = skip_q2 ? 0.0 : -u_p[q2soff[h] + ij*gems_00[h]+kl];          // -Q2(ij,kl)
 
                 // not spin adapted
-                int kld = ibas_ab_sym[h][k][l];
-                int lkd = ibas_ab_sym[h][l][k];
+                int kld = ibas_ab(k,l);
+                int lkd = ibas_ab(l,k);
                 dum        +=  0.5 * u_p[d2aboff[h] + kld*gems_ab[h]+ijd];          // +D2(kl,ij)
                 dum        +=  0.5 * u_p[d2aboff[h] + lkd*gems_ab[h]+ijd];          // +D2(lk,ij)
                 dum        +=  0.5 * u_p[d2aboff[h] + kld*gems_ab[h]+jid];          // +D2(kl,ji)
@@ -288,56 +294,57 @@ void v2RDMSolver::Q2_constraints_Au_spin_adapted(SharedVector A,SharedVector u){
                 //dum        +=  u_p[d2soff[h] + INDEX(kl,ij)];          // +D2(kl,ij)
 
                 if ( j==l ) {
-                    int h2 = symmetry[i];
-                    int ii = i - pitzer_offset[h2];
-                    int kk = k - pitzer_offset[h2];
-                    dum        +=  0.5 * u_p[q1aoff[h2] + ii*amopi_[h2]+kk]; // +Q1(i,k) djl
-                    dum        -=  0.5 * u_p[d1boff[h2] + ii*amopi_[h2]+kk]; // -D1(i,k) djl
+                    int h2 = sym.irrep(i);
+                    int ii = i - sym.offset(h2);
+                    int kk = k - sym.offset(h2);
+                    dum        +=  0.5 * u_p[q1aoff[h2] + ii*sym.size(h2)+kk]; // +Q1(i,k) djl
+                    dum        -=  0.5 * u_p[d1boff[h2] + ii*sym.size(h2)+kk]; // -D1(i,k) djl
                 }
                 if ( i==k ) {
-                    int h2 = symmetry[j];
-                    int jj = j - pitzer_offset[h2];
-                    int ll = l - pitzer_offset[h2];
-                    dum        +=  0.5 * u_p[q1aoff[h2] + ll*amopi_[h2]+jj]; // +Q1(l,j) dik
-                    dum        -=  0.5 * u_p[d1boff[h2] + ll*amopi_[h2]+jj]; // -D1(l,j) dik
+                    int h2 = sym.irrep(j);
+                    int jj = j - sym.offset(h2);
+                    int ll = l - sym.offset(h2);
+                    dum        +=  0.5 * u_p[q1aoff[h2] + ll*sym.size(h2)+jj]; // +Q1(l,j) dik
+                    dum        -=  0.5 * u_p[d1boff[h2] + ll*sym.size(h2)+jj]; // -D1(l,j) dik
                 }
                 if ( j==k ) {
-                    int h2 = symmetry[i];
-                    int ii = i - pitzer_offset[h2];
-                    int ll = l - pitzer_offset[h2];
-                    dum        +=  0.5 * u_p[q1aoff[h2] + ll*amopi_[h2]+ii]; // +Q1(l,i) djk
-                    dum        -=  0.5 * u_p[d1boff[h2] + ll*amopi_[h2]+ii]; // -D1(l,i) djk
+                    int h2 = sym.irrep(i);
+                    int ii = i - sym.offset(h2);
+                    int ll = l - sym.offset(h2);
+                    dum        +=  0.5 * u_p[q1aoff[h2] + ll*sym.size(h2)+ii]; // +Q1(l,i) djk
+                    dum        -=  0.5 * u_p[d1boff[h2] + ll*sym.size(h2)+ii]; // -D1(l,i) djk
                 }
                 if ( i==l ) {
-                    int h2 = symmetry[j];
-                    int jj = j - pitzer_offset[h2];
-                    int kk = k - pitzer_offset[h2];
-                    dum        +=  0.5 * u_p[q1aoff[h2] + kk*amopi_[h2]+jj]; // +Q1(k,j) dil
-                    dum        -=  0.5 * u_p[d1boff[h2] + kk*amopi_[h2]+jj]; // -D1(k,j) dil
+                    int h2 = sym.irrep(j);
+                    int jj = j - sym.offset(h2);
+                    int kk = k - sym.offset(h2);
+                    dum        +=  0.5 * u_p[q1aoff[h2] + kk*sym.size(h2)+jj]; // +Q1(k,j) dil
+                    dum        -=  0.5 * u_p[d1boff[h2] + kk*sym.size(h2)+jj]; // -D1(k,j) dil
                 }
 
-                A_p[offset + ij*gems_00[h]+kl] = dum;
+                A_p[myoffset + ij*gems_00[h]+kl] = dum;
             }
         }
         offset += gems_00[h]*gems_00[h];
     }
     // map D2ab to Q210
-    for (int h = 0; h < nirrep_; h++) {
-        #pragma omp parallel for schedule (static)
+    for (int h = 0; h < sym.nirrep(); h++) {
+        long int myoffset = offset;
+        #pragma omp taskloop nogroup
         for (int ij = 0; ij < gems_aa[h]; ij++) {
             int i   =  bas_aa_sym[h][ij][0];
             int j   =  bas_aa_sym[h][ij][1];
-            int ijd = ibas_ab_sym[h][i][j];
-            int jid = ibas_ab_sym[h][j][i];
+            int ijd = ibas_ab(i,j);
+            int jid = ibas_ab(j,i);
             for (int kl = 0; kl < gems_aa[h]; kl++) {
                 int   k =  bas_aa_sym[h][kl][0];
                 int   l =  bas_aa_sym[h][kl][1];
 
-                double dum  = -u_p[q2toff[h] + ij*gems_aa[h]+kl];          // -Q2(ij,kl)
+                double dum  = skip_q2 ? 0.0 : -u_p[q2toff[h] + ij*gems_aa[h]+kl];          // -Q2(ij,kl)
 
                 // not spin adapted
-                int kld = ibas_ab_sym[h][k][l];
-                int lkd = ibas_ab_sym[h][l][k];
+                int kld = ibas_ab(k,l);
+                int lkd = ibas_ab(l,k);
                 dum        +=  0.5 * u_p[d2aboff[h] + kld*gems_ab[h]+ijd];          // +D2(kl,ij)
                 dum        -=  0.5 * u_p[d2aboff[h] + lkd*gems_ab[h]+ijd];          // -D2(lk,ij)
                 dum        -=  0.5 * u_p[d2aboff[h] + kld*gems_ab[h]+jid];          // -D2(kl,ji)
@@ -347,149 +354,163 @@ void v2RDMSolver::Q2_constraints_Au_spin_adapted(SharedVector A,SharedVector u){
                 //dum        +=  u_p[d2toff[h] + INDEX(kl,ij)];          // +D2(kl,ij)
 
                 if ( j==l ) {
-                    int h2 = symmetry[i];
-                    int ii = i - pitzer_offset[h2];
-                    int kk = k - pitzer_offset[h2];
-                    dum        +=  0.5 * u_p[q1aoff[h2] + ii*amopi_[h2]+kk]; // +Q1(i,k) djl
-                    dum        -=  0.5 * u_p[d1boff[h2] + ii*amopi_[h2]+kk]; // -D1(i,k) djl
+                    int h2 = sym.irrep(i);
+                    int ii = i - sym.offset(h2);
+                    int kk = k - sym.offset(h2);
+                    dum        +=  0.5 * u_p[q1aoff[h2] + ii*sym.size(h2)+kk]; // +Q1(i,k) djl
+                    dum        -=  0.5 * u_p[d1boff[h2] + ii*sym.size(h2)+kk]; // -D1(i,k) djl
                 }
                 if ( i==k ) {
-                    int h2 = symmetry[j];
-                    int jj = j - pitzer_offset[h2];
-                    int ll = l - pitzer_offset[h2];
-                    dum        +=  0.5 * u_p[q1aoff[h2] + ll*amopi_[h2]+jj]; // +Q1(l,j) dik
-                    dum        -=  0.5 * u_p[d1boff[h2] + ll*amopi_[h2]+jj]; // -D1(l,j) dik
+                    int h2 = sym.irrep(j);
+                    int jj = j - sym.offset(h2);
+                    int ll = l - sym.offset(h2);
+                    dum        +=  0.5 * u_p[q1aoff[h2] + ll*sym.size(h2)+jj]; // +Q1(l,j) dik
+                    dum        -=  0.5 * u_p[d1boff[h2] + ll*sym.size(h2)+jj]; // -D1(l,j) dik
                 }
                 if ( j==k ) {
-                    int h2 = symmetry[i];
-                    int ii = i - pitzer_offset[h2];
-                    int ll = l - pitzer_offset[h2];
-                    dum        -=  0.5 * u_p[q1aoff[h2] + ll*amopi_[h2]+ii]; // -Q1(l,i) djk
-                    dum        +=  0.5 * u_p[d1boff[h2] + ll*amopi_[h2]+ii]; // +D1(l,i) djk
+                    int h2 = sym.irrep(i);
+                    int ii = i - sym.offset(h2);
+                    int ll = l - sym.offset(h2);
+                    dum        -=  0.5 * u_p[q1aoff[h2] + ll*sym.size(h2)+ii]; // -Q1(l,i) djk
+                    dum        +=  0.5 * u_p[d1boff[h2] + ll*sym.size(h2)+ii]; // +D1(l,i) djk
                 }
                 if ( i==l ) {
-                    int h2 = symmetry[j];
-                    int jj = j - pitzer_offset[h2];
-                    int kk = k - pitzer_offset[h2];
-                    dum        -=  0.5 * u_p[q1aoff[h2] + kk*amopi_[h2]+jj]; // -Q1(k,j) dil
-                    dum        +=  0.5 * u_p[d1boff[h2] + kk*amopi_[h2]+jj]; // +D1(k,j) dil
+                    int h2 = sym.irrep(j);
+                    int jj = j - sym.offset(h2);
+                    int kk = k - sym.offset(h2);
+                    dum        -=  0.5 * u_p[q1aoff[h2] + kk*sym.size(h2)+jj]; // -Q1(k,j) dil
+                    dum        +=  0.5 * u_p[d1boff[h2] + kk*sym.size(h2)+jj]; // +D1(k,j) dil
                 }
 
-                A_p[offset + ij*gems_aa[h]+kl] = dum;
+                A_p[myoffset + ij*gems_aa[h]+kl] = dum;
             }
         }
         offset += gems_aa[h]*gems_aa[h];
     }
     // map D2aa to Q211
-    for (int h = 0; h < nirrep_; h++) {
-        #pragma omp parallel for schedule (static)
+    for (int h = 0; h < sym.nirrep(); h++) {
+        long int myoffset = offset;
+        #pragma omp taskloop nogroup
         for (int ij = 0; ij < gems_aa[h]; ij++) {
             int i = bas_aa_sym[h][ij][0];
             int j = bas_aa_sym[h][ij][1];
             for (int kl = 0; kl < gems_aa[h]; kl++) {
                 int k = bas_aa_sym[h][kl][0];
                 int l = bas_aa_sym[h][kl][1];
-                double dum  = -u_p[q2toff_p1[h] + ij*gems_aa[h]+kl];    // -Q2(ij,kl)
+                double dum  = skip_q2 ? 0.0 : -u_p[q2toff_p1[h] + ij*gems_aa[h]+kl];    // -Q2(ij,kl)
                 dum        +=  u_p[d2aaoff[h] + kl*gems_aa[h]+ij];    // +D2(kl,ij)
 
                 if ( j==l ) {
-                    int h2 = symmetry[i];
-                    int ii = i - pitzer_offset[h2];
-                    int kk = k - pitzer_offset[h2];
-                    dum        +=  u_p[q1aoff[h2] + ii*amopi_[h2]+kk];  // +Q1(i,k) djl
+                    int h2 = sym.irrep(i);
+                    int ii = i - sym.offset(h2);
+                    int kk = k - sym.offset(h2);
+                    dum        +=  u_p[q1aoff[h2] + ii*sym.size(h2)+kk];  // +Q1(i,k) djl
                 }
                 if ( j==k ) {
-                    int h2 = symmetry[i];
-                    int ii = i - pitzer_offset[h2];
-                    int ll = l - pitzer_offset[h2];
-                    dum        +=  u_p[d1aoff[h2] + ll*amopi_[h2]+ii];  // +D1(l,i) djk
+                    int h2 = sym.irrep(i);
+                    int ii = i - sym.offset(h2);
+                    int ll = l - sym.offset(h2);
+                    dum        +=  u_p[d1aoff[h2] + ll*sym.size(h2)+ii];  // +D1(l,i) djk
                 }
                 if ( i==l ) {
-                    int h2 = symmetry[j];
-                    int jj = j - pitzer_offset[h2];
-                    int kk = k - pitzer_offset[h2];
-                    dum        -=  u_p[q1aoff[h2] + jj*amopi_[h2]+kk];  // -Q1(j,k) dil
+                    int h2 = sym.irrep(j);
+                    int jj = j - sym.offset(h2);
+                    int kk = k - sym.offset(h2);
+                    dum        -=  u_p[q1aoff[h2] + jj*sym.size(h2)+kk];  // -Q1(j,k) dil
                 }
                 if ( i==k ) {
-                    int h2 = symmetry[j];
-                    int jj = j - pitzer_offset[h2];
-                    int ll = l - pitzer_offset[h2];
-                    dum        -=  u_p[d1aoff[h2] + ll*amopi_[h2]+jj];  // -D1(l,j) dkl
+                    int h2 = sym.irrep(j);
+                    int jj = j - sym.offset(h2);
+                    int ll = l - sym.offset(h2);
+                    dum        -=  u_p[d1aoff[h2] + ll*sym.size(h2)+jj];  // -D1(l,j) dkl
                 }
 
-                A_p[offset + ij*gems_aa[h]+kl] = dum;
+                A_p[myoffset + ij*gems_aa[h]+kl] = dum;
             }
         }
         offset += gems_aa[h]*gems_aa[h];
     }
     // map D2bb to Q21-1
-    for (int h = 0; h < nirrep_; h++) {
-        #pragma omp parallel for schedule (static)
+    for (int h = 0; h < sym.nirrep(); h++) {
+        long int myoffset = offset;
+        #pragma omp taskloop nogroup
         for (int ij = 0; ij < gems_aa[h]; ij++) {
             int i = bas_aa_sym[h][ij][0];
             int j = bas_aa_sym[h][ij][1];
             for (int kl = 0; kl < gems_aa[h]; kl++) {
                 int k = bas_aa_sym[h][kl][0];
                 int l = bas_aa_sym[h][kl][1];
-                double dum  = -u_p[q2toff_m1[h] + ij*gems_aa[h]+kl];    // -Q2(ij,kl)
+                double dum  = skip_q2 ? 0.0 : -u_p[q2toff_m1[h] + ij*gems_aa[h]+kl];    // -Q2(ij,kl)
                 dum        +=  u_p[d2bboff[h] + kl*gems_aa[h]+ij];    // +D2(kl,ij)
 
                 if ( j==l ) {
-                    int h2 = symmetry[i];
-                    int ii = i - pitzer_offset[h2];
-                    int kk = k - pitzer_offset[h2];
-                    dum        +=  u_p[q1boff[h2] + ii*amopi_[h2]+kk];  // +Q1(i,k) djl
+                    int h2 = sym.irrep(i);
+                    int ii = i - sym.offset(h2);
+                    int kk = k - sym.offset(h2);
+                    dum        +=  u_p[q1boff[h2] + ii*sym.size(h2)+kk];  // +Q1(i,k) djl
                 }
                 if ( j==k ) {
-                    int h2 = symmetry[i];
-                    int ii = i - pitzer_offset[h2];
-                    int ll = l - pitzer_offset[h2];
-                    dum        +=  u_p[d1boff[h2] + ll*amopi_[h2]+ii];  // +D1(l,i) djk
+                    int h2 = sym.irrep(i);
+                    int ii = i - sym.offset(h2);
+                    int ll = l - sym.offset(h2);
+                    dum        +=  u_p[d1boff[h2] + ll*sym.size(h2)+ii];  // +D1(l,i) djk
                 }
                 if ( i==l ) {
-                    int h2 = symmetry[j];
-                    int jj = j - pitzer_offset[h2];
-                    int kk = k - pitzer_offset[h2];
-                    dum        -=  u_p[q1boff[h2] + jj*amopi_[h2]+kk];  // -Q1(j,k) dil
+                    int h2 = sym.irrep(j);
+                    int jj = j - sym.offset(h2);
+                    int kk = k - sym.offset(h2);
+                    dum        -=  u_p[q1boff[h2] + jj*sym.size(h2)+kk];  // -Q1(j,k) dil
                 }
                 if ( i==k ) {
-                    int h2 = symmetry[j];
-                    int jj = j - pitzer_offset[h2];
-                    int ll = l - pitzer_offset[h2];
-                    dum        -=  u_p[d1boff[h2] + ll*amopi_[h2]+jj];  // -D1(l,j) dkl
+                    int h2 = sym.irrep(j);
+                    int jj = j - sym.offset(h2);
+                    int ll = l - sym.offset(h2);
+                    dum        -=  u_p[d1boff[h2] + ll*sym.size(h2)+jj];  // -D1(l,j) dkl
                 }
 
-                A_p[offset + ij*gems_aa[h]+kl] = dum;
+                A_p[myoffset + ij*gems_aa[h]+kl] = dum;
             }
         }
         offset += gems_aa[h]*gems_aa[h];
     }
 }
 
+void v2RDMSolver::Q2_constraints_Au_spin_adapted(SharedVector A,SharedVector u){
+    (this->*Q2_constraints_Au_spin_adapted_fn_)(A,u,SkippedBlocks());
+}
+
+void v2RDMSolver::Q2_constraints_Au_spin_adapted(SharedVector A,SharedVector u,const SkippedBlocks & skip){
+    (this->*Q2_constraints_Au_spin_adapted_fn_)(A,u,skip);
+}
+
 // Q2 portion of A^T.y (spin adapted)
-void v2RDMSolver::Q2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u){
+template <class Symmetry>
+void v2RDMSolver::Q2_constraints_ATu_spin_adapted_kernel(SharedVector A,SharedVector u,const SkippedBlocks & skip){
+
+    Symmetry sym(nirrep_,symmetry,pitzer_offset,amopi_,table);
+    bool skip_q2 = skip.q2;
 
     double * A_p = A->pointer();
     double * u_p = u->pointer();
 
     // map D2ab to Q2s
-    for (int h = 0; h < nirrep_; h++) {
+    for (int h = 0; h < sym.nirrep(); h++) {
         for (int ij = 0; ij < gems_00[h]; ij++) {
             int i = bas_00_sym[h][ij][0];
             int j = bas_00_sym[h][ij][1];
-            int ijd = ibas_ab_sym[h][i][j];
-            int jid = ibas_ab_sym[h][j][i];
+            int ijd = ibas_ab(i,j);
+            int jid = ibas_ab(j,i);
             for (int kl = 0; kl < gems_00[h]; kl++) {
                 int k = bas_00_sym[h][kl][0];
                 int l = bas_00_sym[h][kl][1];
 
                 double dum  = u_p[offset + ij*gems_00[h]+kl];
 
-                A_p[q2soff[h] + ij*gems_00[h]+kl]    -= dum;          // -Q2(ij,kl)
+                if ( !skip_q2 ) A_p[q2soff[h] + ij*gems_00[h]+kl]    -= dum;          // -Q2(ij,kl)
 
                 // not spin adapted
-                int kld = ibas_ab_sym[h][k][l];
-                int lkd = ibas_ab_sym[h][l][k];
+                int kld = ibas_ab(k,l);
+                int lkd = ibas_ab(l,k);
                 A_p[d2aboff[h] + kld*gems_ab[h]+ijd] += 0.5 * dum;          // +D2(kl,ij)
                 A_p[d2aboff[h] + lkd*gems_ab[h]+ijd] += 0.5 * dum;          // +D2(lk,ij)
                 A_p[d2aboff[h] + kld*gems_ab[h]+jid] += 0.5 * dum;          // +D2(kl,ji)
@@ -499,55 +520,55 @@ void v2RDMSolver::Q2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u)
                 //A_p[d2soff[h] + INDEX(kl,ij)] += dum;          // +D2(kl,ij)
 
                 if ( j==l ) {
-                    int h2 = symmetry[i];
-                    int ii = i - pitzer_offset[h2];
-                    int kk = k - pitzer_offset[h2];
-                    A_p[q1aoff[h2] + ii*amopi_[h2]+kk] += 0.5 * dum; // +Q1(i,k) djl
-                    A_p[d1boff[h2] + ii*amopi_[h2]+kk] -= 0.5 * dum; // -D1(i,k) djl
+                    int h2 = sym.irrep(i);
+                    int ii = i - sym.offset(h2);
+                    int kk = k - sym.offset(h2);
+                    A_p[q1aoff[h2] + ii*sym.size(h2)+kk] += 0.5 * dum; // +Q1(i,k) djl
+                    A_p[d1boff[h2] + ii*sym.size(h2)+kk] -= 0.5 * dum; // -D1(i,k) djl
                 }
                 if ( i==k ) {
-                    int h2 = symmetry[j];
-                    int jj = j - pitzer_offset[h2];
-                    int ll = l - pitzer_offset[h2];
-                    A_p[q1aoff[h2] + ll*amopi_[h2]+jj] += 0.5 * dum; // +Q1(l,j) dik
-                    A_p[d1boff[h2] + ll*amopi_[h2]+jj] -= 0.5 * dum; // -D1(l,j) dik
+                    int h2 = sym.irrep(j);
+                    int jj = j - sym.offset(h2);
+                    int ll = l - sym.offset(h2);
+                    A_p[q1aoff[h2] + ll*sym.size(h2)+jj] += 0.5 * dum; // +Q1(l,j) dik
+                    A_p[d1boff[h2] + ll*sym.size(h2)+jj] -= 0.5 * dum; // -D1(l,j) dik
                 }
                 if ( j==k ) {
-                    int h2 = symmetry[i];
-                    int ii = i - pitzer_offset[h2];
-                    int ll = l - pitzer_offset[h2];
-                    A_p[q1aoff[h2] + ll*amopi_[h2]+ii] += 0.5 * dum; // +Q1(l,i) djk
-                    A_p[d1boff[h2] + ll*amopi_[h2]+ii] -= 0.5 * dum; // -D1(l,i) djk
+                    int h2 = sym.irrep(i);
+                    int ii = i - sym.offset(h2);
+                    int ll = l - sym.offset(h2);
+                    A_p[q1aoff[h2] + ll*sym.size(h2)+ii] += 0.5 * dum; // +Q1(l,i) djk
+                    A_p[d1boff[h2] + ll*sym.size(h2)+ii] -= 0.5 * dum; // -D1(l,i) djk
                 }
                 if ( i==l ) {
-                    int h2 = symmetry[j];
-                    int jj = j - pitzer_offset[h2];
-                    int kk = k - pitzer_offset[h2];
-                    A_p[q1aoff[h2] + kk*amopi_[h2]+jj] += 0.5 * dum; // +Q1(k,j) dil
-                    A_p[d1boff[h2] + kk*amopi_[h2]+jj] -= 0.5 * dum; // -D1(k,j) dil
+                    int h2 = sym.irrep(j);
+                    int jj = j - sym.offset(h2);
+                    int kk = k - sym.offset(h2);
+                    A_p[q1aoff[h2] + kk*sym.size(h2)+jj] += 0.5 * dum; // +Q1(k,j) dil
+                    A_p[d1boff[h2] + kk*sym.size(h2)+jj] -= 0.5 * dum; // -D1(k,j) dil
                 }
             }
         }
         offset += gems_00[h]*gems_00[h];
     }
     // map D2ab to Q210
-    for (int h = 0; h < nirrep_; h++) {
+    for (int h = 0; h < sym.nirrep(); h++) {
         for (int ij = 0; ij < gems_aa[h]; ij++) {
             int i   =  bas_aa_sym[h][ij][0];
             int j   =  bas_aa_sym[h][ij][1];
-            int ijd = ibas_ab_sym[h][i][j];
-            int jid = ibas_ab_sym[h][j][i];
+            int ijd = ibas_ab(i,j);
+            int jid = ibas_ab(j,i);
             for (int kl = 0; kl < gems_aa[h]; kl++) {
                 int k   =  bas_aa_sym[h][kl][0];
                 int l   =  bas_aa_sym[h][kl][1];
 
                 double dum  = u_p[offset + ij*gems_aa[h]+kl];
 
-                A_p[q2toff[h] + ij*gems_aa[h]+kl]    -= dum;          // -Q2(ij,kl)
+                if ( !skip_q2 ) A_p[q2toff[h] + ij*gems_aa[h]+kl]    -= dum;          // -Q2(ij,kl)
 
                 // not spin adapted
-                int kld = ibas_ab_sym[h][k][l];
-                int lkd = ibas_ab_sym[h][l][k];
+                int kld = ibas_ab(k,l);
+                int lkd = ibas_ab(l,k);
                 A_p[d2aboff[h] + kld*gems_ab[h]+ijd] += 0.5 * dum;          // +D2(kl,ij)
                 A_p[d2aboff[h] + lkd*gems_ab[h]+ijd] -= 0.5 * dum;          // +D2(lk,ij)
                 A_p[d2aboff[h] + kld*gems_ab[h]+jid] -= 0.5 * dum;          // +D2(kl,ji)
@@ -557,39 +578,39 @@ void v2RDMSolver::Q2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u)
                 //A_p[d2toff[h] + INDEX(kl,ij)] += dum;          // +D2(kl,ij)
 
                 if ( j==l ) {
-                    int h2 = symmetry[i];
-                    int ii = i - pitzer_offset[h2];
-                    int kk = k - pitzer_offset[h2];
-                    A_p[q1aoff[h2] + ii*amopi_[h2]+kk] += 0.5 * dum; // +Q1(i,k) djl
-                    A_p[d1boff[h2] + ii*amopi_[h2]+kk] -= 0.5 * dum; // -D1(i,k) djl
+                    int h2 = sym.irrep(i);
+                    int ii = i - sym.offset(h2);
+                    int kk = k - sym.offset(h2);
+                    A_p[q1aoff[h2] + ii*sym.size(h2)+kk] += 0.5 * dum; // +Q1(i,k) djl
+                    A_p[d1boff[h2] + ii*sym.size(h2)+kk] -= 0.5 * dum; // -D1(i,k) djl
                 }
                 if ( i==k ) {
-                    int h2 = symmetry[j];
-                    int jj = j - pitzer_offset[h2];
-                    int ll = l - pitzer_offset[h2];
-                    A_p[q1aoff[h2] + ll*amopi_[h2]+jj] += 0.5 * dum; // +Q1(l,j) dik
-                    A_p[d1boff[h2] + ll*amopi_[h2]+jj] -= 0.5 * dum; // -D1(l,j) dik
+                    int h2 = sym.irrep(j);
+                    int jj = j - sym.offset(h2);
+                    int ll = l - sym.offset(h2);
+                    A_p[q1aoff[h2] + ll*sym.size(h2)+jj] += 0.5 * dum; // +Q1(l,j) dik
+                    A_p[d1boff[h2] + ll*sym.size(h2)+jj] -= 0.5 * dum; // -D1(l,j) dik
                 }
                 if ( j==k ) {
-                    int h2 = symmetry[i];
-                    int ii = i - pitzer_offset[h2];
-                    int ll = l - pitzer_offset[h2];
-                    A_p[q1aoff[h2] + ll*amopi_[h2]+ii] -= 0.5 * dum; // +Q1(l,i) djk
-                    A_p[d1boff[h2] + ll*amopi_[h2]+ii] += 0.5 * dum; // -D1(l,i) djk
+                    int h2 = sym.irrep(i);
+                    int ii = i - sym.offset(h2);
+                    int ll = l - sym.offset(h2);
+                    A_p[q1aoff[h2] + ll*sym.size(h2)+ii] -= 0.5 * dum; // +Q1(l,i) djk
+                    A_p[d1boff[h2] + ll*sym.size(h2)+ii] += 0.5 * dum; // -D1(l,i) djk
                 }
                 if ( i==l ) {
-                    int h2 = symmetry[j];
-                    int jj = j - pitzer_offset[h2];
-                    int kk = k - pitzer_offset[h2];
-                    A_p[q1aoff[h2] + kk*amopi_[h2]+jj] -= 0.5 * dum; // +Q1(k,j) dil
-                    A_p[d1boff[h2] + kk*amopi_[h2]+jj] += 0.5 * dum; // -D1(k,j) dil
+                    int h2 = sym.irrep(j);
+                    int jj = j - sym.offset(h2);
+                    int kk = k - sym.offset(h2);
+                    A_p[q1aoff[h2] + kk*sym.size(h2)+jj] -= 0.5 * dum; // +Q1(k,j) dil
+                    A_p[d1boff[h2] + kk*sym.size(h2)+jj] += 0.5 * dum; // -D1(k,j) dil
                 }
             }
         }
         offset += gems_aa[h]*gems_aa[h];
     }
     // map D2aa to Q211
-    for (int h = 0; h < nirrep_; h++) {
+    for (int h = 0; h < sym.nirrep(); h++) {
         for (int ij = 0; ij < gems_aa[h]; ij++) {
             int i = bas_aa_sym[h][ij][0];
             int j = bas_aa_sym[h][ij][1];
@@ -597,38 +618,38 @@ void v2RDMSolver::Q2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u)
                 int k = bas_aa_sym[h][kl][0];
                 int l = bas_aa_sym[h][kl][1];
                 double val = u_p[offset + ij*gems_aa[h]+kl];
-                A_p[q2toff_p1[h] + ij*gems_aa[h]+kl] -= val;
+                if ( !skip_q2 ) A_p[q2toff_p1[h] + ij*gems_aa[h]+kl] -= val;
                 A_p[d2aaoff[h] + kl*gems_aa[h]+ij]   += val;
                 if ( j==l ) {
-                    int h2 = symmetry[i];
-                    int ii = i - pitzer_offset[h2];
-                    int kk = k - pitzer_offset[h2];
-                    A_p[q1aoff[h2]  + ii*amopi_[h2]+kk]      += val;
+                    int h2 = sym.irrep(i);
+                    int ii = i - sym.offset(h2);
+                    int kk = k - sym.offset(h2);
+                    A_p[q1aoff[h2]  + ii*sym.size(h2)+kk]      += val;
                 }
                 if ( j==k ) {
-                    int h2 = symmetry[i];
-                    int ii = i - pitzer_offset[h2];
-                    int ll = l - pitzer_offset[h2];
-                    A_p[d1aoff[h2]  + ll*amopi_[h2]+ii]      += val;
+                    int h2 = sym.irrep(i);
+                    int ii = i - sym.offset(h2);
+                    int ll = l - sym.offset(h2);
+                    A_p[d1aoff[h2]  + ll*sym.size(h2)+ii]      += val;
                 }
                 if ( i==l ) {
-                    int h2 = symmetry[j];
-                    int jj = j - pitzer_offset[h2];
-                    int kk = k - pitzer_offset[h2];
-                    A_p[q1aoff[h2]  + jj*amopi_[h2]+kk]      -= val;
+                    int h2 = sym.irrep(j);
+                    int jj = j - sym.offset(h2);
+                    int kk = k - sym.offset(h2);
+                    A_p[q1aoff[h2]  + jj*sym.size(h2)+kk]      -= val;
                 }
                 if ( i==k ) {
-                    int h2 = symmetry[j];
-                    int jj = j - pitzer_offset[h2];
-                    int ll = l - pitzer_offset[h2];
-                    A_p[d1aoff[h2]  + ll*amopi_[h2]+jj]      -= val;
+                    int h2 = sym.irrep(j);
+                    int jj = j - sym.offset(h2);
+                    int ll = l - sym.offset(h2);
+                    A_p[d1aoff[h2]  + ll*sym.size(h2)+jj]      -= val;
                 }
             }
         }
         offset += gems_aa[h]*gems_aa[h];
     }
     // map D2bb to Q21-1
-    for (int h = 0; h < nirrep_; h++) {
+    for (int h = 0; h < sym.nirrep(); h++) {
         for (int ij = 0; ij < gems_aa[h]; ij++) {
             int i = bas_aa_sym[h][ij][0];
             int j = bas_aa_sym[h][ij][1];
@@ -636,32 +657,32 @@ void v2RDMSolver::Q2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u)
                 int k = bas_aa_sym[h][kl][0];
                 int l = bas_aa_sym[h][kl][1];
                 double val = u_p[offset + ij*gems_aa[h]+kl];
-                A_p[q2toff_m1[h] + ij*gems_aa[h]+kl] -= val;
+                if ( !skip_q2 ) A_p[q2toff_m1[h] + ij*gems_aa[h]+kl] -= val;
                 //A_p[d2toff_m1[h] + INDEX(kl,ij)] += u_p[offset + INDEX(ij,kl)];
                 A_p[d2bboff[h] + kl*gems_aa[h]+ij] += val;
                 if ( j==l ) {
-                    int h2 = symmetry[i];
-                    int ii = i - pitzer_offset[h2];
-                    int kk = k - pitzer_offset[h2];
-                    A_p[q1boff[h2]  + ii*amopi_[h2]+kk]      += val;
+                    int h2 = sym.irrep(i);
+                    int ii = i - sym.offset(h2);
+                    int kk = k - sym.offset(h2);
+                    A_p[q1boff[h2]  + ii*sym.size(h2)+kk]      += val;
                 }
                 if ( j==k ) {
-                    int h2 = symmetry[i];
-                    int ii = i - pitzer_offset[h2];
-                    int ll = l - pitzer_offset[h2];
-                    A_p[d1boff[h2]  + ll*amopi_[h2]+ii]      += val;
+                    int h2 = sym.irrep(i);
+                    int ii = i - sym.offset(h2);
+                    int ll = l - sym.offset(h2);
+                    A_p[d1boff[h2]  + ll*sym.size(h2)+ii]      += val;
                 }
                 if ( i==l ) {
-                    int h2 = symmetry[j];
-                    int jj = j - pitzer_offset[h2];
-                    int kk = k - pitzer_offset[h2];
-                    A_p[q1boff[h2]  + jj*amopi_[h2]+kk]      -= val;
+                    int h2 = sym.irrep(j);
+                    int jj = j - sym.offset(h2);
+                    int kk = k - sym.offset(h2);
+                    A_p[q1boff[h2]  + jj*sym.size(h2)+kk]      -= val;
                 }
                 if ( i==k ) {
-                    int h2 = symmetry[j];
-                    int jj = j - pitzer_offset[h2];
-                    int ll = l - pitzer_offset[h2];
-                    A_p[d1boff[h2]  + ll*amopi_[h2]+jj]      -= val;
+                    int h2 = sym.irrep(j);
+                    int jj = j - sym.offset(h2);
+                    int ll = l - sym.offset(h2);
+                    A_p[d1boff[h2]  + ll*sym.size(h2)+jj]      -= val;
                 }
             }
         }
@@ -669,6 +690,14 @@ void v2RDMSolver::Q2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u)
     }
 }
 
+void v2RDMSolver::Q2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u){
+    (this->*Q2_constraints_ATu_spin_adapted_fn_)(A,u,SkippedBlocks());
+}
+
+void v2RDMSolver::Q2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u,const SkippedBlocks & skip){
+    (this->*Q2_constraints_ATu_spin_adapted_fn_)(A,u,skip);
+}
+
 // Q2 guess
 void v2RDMSolver::Q2_constraints_guess(SharedVector u){
 
@@ -798,23 +827,21 @@ void v2RDMSolver::Q2_constraints_guess(SharedVector u){
 }
 
 // Q2 portion of A.x (with symmetry)
-void v2RDMSolver::Q2_constraints_Au(SharedVector A,SharedVector u){
+template <class Symmetry>
+void v2RDMSolver::Q2_constraints_Au_kernel(SharedVector A,SharedVector u,const SkippedBlocks & skip){
+
+    Symmetry sym(nirrep_,symmetry,pitzer_offset,amopi_,table);
+    bool skip_q2 = skip.q2;
     double * A_p = A->pointer();
     double * u_p = u->pointer();
 
-    long int blocksize_ab = 0;
-    long int blocksize_aa = 0;
-    for (int h = 0; h < nirrep_; h++) {
-        blocksize_ab += gems_ab[h]*gems_ab[h];
-        blocksize_aa += gems_aa[h]*gems_aa[h];
-    }
-
     // map D2ab to Q2ab
-    C_DCOPY(blocksize_ab,u_p + d2aboff[0],1,A_p + offset,1);      // + D2(kl,ij)
-    C_DAXPY(blocksize_ab,-1.0,u_p + q2aboff[0],1,A_p + offset,1); // - Q2(kl,ij)
-    for (int h = 0; h < nirrep_; h++) {
-        #pragma omp parallel for schedule (static)
+    for (int h = 0; h < sym.nirrep(); h++) {
+        long int myoffset = offset;
+        #pragma omp taskloop nogroup
         for (int ij = 0; ij < gems_ab[h]; ij++) {
+            C_DCOPY(gems_ab[h],u_p + d2aboff[h] + ij*gems_ab[h],1,A_p + myoffset + ij*gems_ab[h],1);      // + D2(kl,ij)
+            if ( !skip_q2 ) C_DAXPY(gems_ab[h],-1.0,u_p + q2aboff[h] + ij*gems_ab[h],1,A_p + myoffset + ij*gems_ab[h],1); // - Q2(kl,ij)
             int i = bas_ab_sym[h][ij][0];
             int j = bas_ab_sym[h][ij][1];
 
@@ -823,36 +850,37 @@ void v2RDMSolver::Q2_constraints_Au(SharedVector A,SharedVector u){
             //int ii = i - pitzer_offset[hi];
             //for (int kk = 0; kk < amopi_[hi]; kk++) {
             //    int k  = kk + pitzer_offset[hi];
-            //    int kj = ibas_ab_sym[h][k][j];
-            //    A_p[offset + ij*gems_ab[h]+kj] += u_p[q1aoff[hi] + ii*amopi_[hi]+kk]; // +Q1(i,k) djl
+            //    int kj = ibas_ab(k,j);
+            //    A_p[myoffset + ij*gems_ab[h]+kj] += u_p[q1aoff[hi] + ii*amopi_[hi]+kk]; // +Q1(i,k) djl
             //}
             // -D1(k,i) djl
-            int hi = symmetry[i];
-            int ii = i - pitzer_offset[hi];
-            for (int kk = 0; kk < amopi_[hi]; kk++) {
-                int k  = kk + pitzer_offset[hi];
-                int kj = ibas_ab_sym[h][k][j];
-                A_p[offset + ij*gems_ab[h]+kj] -= u_p[d1aoff[hi] + kk*amopi_[hi]+ii]; // +Q1(k,i) djl
+            int hi = sym.irrep(i);
+            int ii = i - sym.offset(hi);
+            for (int kk = 0; kk < sym.size(hi); kk++) {
+                int k  = kk + sym.offset(hi);
+                int kj = ibas_ab(k,j);
+                A_p[myoffset + ij*gems_ab[h]+kj] -= u_p[d1aoff[hi] + kk*sym.size(hi)+ii]; // +Q1(k,i) djl
             }
 
             // -D1(l,j) dik
-            int hj = symmetry[j];
-            int jj = j - pitzer_offset[hj];
-            for (int ll = 0; ll < amopi_[hj]; ll++) {
-                int l  = ll + pitzer_offset[hj];
-                int il = ibas_ab_sym[h][i][l];
-                A_p[offset + ij*gems_ab[h]+il] -= u_p[d1boff[hj] + jj*amopi_[hj]+ll]; // -D1(l,j) dik
+            int hj = sym.irrep(j);
+            int jj = j - sym.offset(hj);
+            for (int ll = 0; ll < sym.size(hj); ll++) {
+                int l  = ll + sym.offset(hj);
+                int il = ibas_ab(i,l);
+                A_p[myoffset + ij*gems_ab[h]+il] -= u_p[d1boff[hj] + jj*sym.size(hj)+ll]; // -D1(l,j) dik
             }
         }
         offset += gems_ab[h]*gems_ab[h];
     }
 
     // map D2aa to Q2aa
-    C_DCOPY(blocksize_aa,u_p + d2aaoff[0],1,A_p + offset,1);      // + D2(kl,ij)
-    C_DAXPY(blocksize_aa,-1.0,u_p + q2aaoff[0],1,A_p + offset,1); // - Q2(kl,ij)
-    for (int h = 0; h < nirrep_; h++) {
-        #pragma omp parallel for schedule (static)
+    for (int h = 0; h < sym.nirrep(); h++) {
+        long int myoffset = offset;
+        #pragma omp taskloop nogroup
         for (int ij = 0; ij < gems_aa[h]; ij++) {
+            C_DCOPY(gems_aa[h],u_p + d2aaoff[h] + ij*gems_aa[h],1,A_p + myoffset + ij*gems_aa[h],1);      // + D2(kl,ij)
+            if ( !skip_q2 ) C_DAXPY(gems_aa[h],-1.0,u_p + q2aaoff[h] + ij*gems_aa[h],1,A_p + myoffset + ij*gems_aa[h],1); // - Q2(kl,ij)
             int i = bas_aa_sym[h][ij][0];
             int j = bas_aa_sym[h][ij][1];
             for (int kl = 0; kl < gems_aa[h]; kl++) {
@@ -864,34 +892,34 @@ void v2RDMSolver::Q2_constraints_Au(SharedVector A,SharedVector u){
                     //int ii = i - pitzer_offset[h2];
                     //int kk = k - pitzer_offset[h2];
                     //dum        +=  u_p[q1aoff[h2] + ii*amopi_[h2]+kk];  // +Q1(i,k) djl
-                    int h2 = symmetry[i];
-                    int ii = i - pitzer_offset[h2];
-                    int kk = k - pitzer_offset[h2];
-                    dum        -=  u_p[d1aoff[h2] + kk*amopi_[h2]+ii];  // -D1(k,i) djl
+                    int h2 = sym.irrep(i);
+                    int ii = i - sym.offset(h2);
+                    int kk = k - sym.offset(h2);
+                    dum        -=  u_p[d1aoff[h2] + kk*sym.size(h2)+ii];  // -D1(k,i) djl
                 }
                 if ( j==k ) {
-                    int h2 = symmetry[i];
-                    int ii = i - pitzer_offset[h2];
-                    int ll = l - pitzer_offset[h2];
-                    dum        +=  u_p[d1aoff[h2] + ll*amopi_[h2]+ii];  // +D1(l,i) djk
+                    int h2 = sym.irrep(i);
+                    int ii = i - sym.offset(h2);
+                    int ll = l - sym.offset(h2);
+                    dum        +=  u_p[d1aoff[h2] + ll*sym.size(h2)+ii];  // +D1(l,i) djk
                 }
                 if ( i==l ) {
                     //int h2 = symmetry[j];
                     //int jj = j - pitzer_offset[h2];
                     //int kk = k - pitzer_offset[h2];
                     //dum        -=  u_p[q1aoff[h2] + jj*amopi_[h2]+kk];  // -Q1(j,k) dil
-                    int h2 = symmetry[j];
-                    int jj = j - pitzer_offset[h2];
-                    int kk = k - pitzer_offset[h2];
-                    dum        +=  u_p[d1aoff[h2] + kk*amopi_[h2]+jj];  // +D1(k,j) dil
+                    int h2 = sym.irrep(j);
+                    int jj = j - sym.offset(h2);
+                    int kk = k - sym.offset(h2);
+                    dum        +=  u_p[d1aoff[h2] + kk*sym.size(h2)+jj];  // +D1(k,j) dil
                 }
                 if ( i==k ) {
-                    int h2 = symmetry[j];
-                    int jj = j - pitzer_offset[h2];
-                    int ll = l - pitzer_offset[h2];
-                    dum        -=  u_p[d1aoff[h2] + ll*amopi_[h2]+jj];  // -D1(l,j) dkl
+                    int h2 = sym.irrep(j);
+                    int jj = j - sym.offset(h2);
+                    int ll = l - sym.offset(h2);
+                    dum        -=  u_p[d1aoff[h2] + ll*sym.size(h2)+jj];  // -D1(l,j) dkl
                 }
-                A_p[offset + ij*gems_aa[h]+kl] += dum;
+                A_p[myoffset + ij*gems_aa[h]+kl] += dum;
             }
         }
         offset += gems_aa[h]*gems_aa[h];
@@ -899,11 +927,12 @@ void v2RDMSolver::Q2_constraints_Au(SharedVector A,SharedVector u){
 
 
     // map D2bb to Q2bb
-    C_DCOPY(blocksize_aa,u_p + d2bboff[0],1,A_p + offset,1);      // + D2(kl,ij)
-    C_DAXPY(blocksize_aa,-1.0,u_p + q2bboff[0],1,A_p + offset,1); // - Q2(kl,ij)
-    for (int h = 0; h < nirrep_; h++) {
-        #pragma omp parallel for schedule (static)
+    for (int h = 0; h < sym.nirrep(); h++) {
+        long int myoffset = offset;
+        #pragma omp taskloop nogroup
         for (int ij = 0; ij < gems_aa[h]; ij++) {
+            C_DCOPY(gems_aa[h],u_p + d2bboff[h] + ij*gems_aa[h],1,A_p + myoffset + ij*gems_aa[h],1);      // + D2(kl,ij)
+            if ( !skip_q2 ) C_DAXPY(gems_aa[h],-1.0,u_p + q2bboff[h] + ij*gems_aa[h],1,A_p + myoffset + ij*gems_aa[h],1); // - Q2(kl,ij)
             int i = bas_aa_sym[h][ij][0];
             int j = bas_aa_sym[h][ij][1];
             for (int kl = 0; kl < gems_aa[h]; kl++) {
@@ -915,57 +944,69 @@ void v2RDMSolver::Q2_constraints_Au(SharedVector A,SharedVector u){
                     //int ii = i - pitzer_offset[h2];
                     //int kk = k - pitzer_offset[h2];
                     //dum        +=  u_p[q1boff[h2] + ii*amopi_[h2]+kk];  // +Q1(i,k) djl
-                    int h2 = symmetry[i];
-                    int ii = i - pitzer_offset[h2];
-                    int kk = k - pitzer_offset[h2];
-                    dum        -=  u_p[d1boff[h2] + kk*amopi_[h2]+ii];  // -D1(k,i) djl
+                    int h2 = sym.irrep(i);
+                    int ii = i - sym.offset(h2);
+                    int kk = k - sym.offset(h2);
+                    dum        -=  u_p[d1boff[h2] + kk*sym.size(h2)+ii];  // -D1(k,i) djl
                 }
                 if ( j==k ) {
-                    int h2 = symmetry[i];
-                    int ii = i - pitzer_offset[h2];
-                    int ll = l - pitzer_offset[h2];
-                    dum        +=  u_p[d1boff[h2] + ll*amopi_[h2]+ii];  // +D1(l,i) djk
+                    int h2 = sym.irrep(i);
+                    int ii = i - sym.offset(h2);
+                    int ll = l - sym.offset(h2);
+                    dum        +=  u_p[d1boff[h2] + ll*sym.size(h2)+ii];  // +D1(l,i) djk
                 }
                 if ( i==l ) {
                     //int h2 = symmetry[j];
                     //int jj = j - pitzer_offset[h2];
                     //int kk = k - pitzer_offset[h2];
                     //dum        -=  u_p[q1boff[h2] + jj*amopi_[h2]+kk];  // -Q1(j,k) dil
-                    int h2 = symmetry[j];
-                    int jj = j - pitzer_offset[h2];
-                    int kk = k - pitzer_offset[h2];
-                    dum        +=  u_p[d1boff[h2] + kk*amopi_[h2]+jj];  // +Q1(k,j) dil
+                    int h2 = sym.irrep(j);
+                    int jj = j - sym.offset(h2);
+                    int kk = k - sym.offset(h2);
+                    dum        +=  u_p[d1boff[h2] + kk*sym.size(h2)+jj];  // +Q1(k,j) dil
                 }
                 if ( i==k ) {
-                    int h2 = symmetry[j];
-                    int jj = j - pitzer_offset[h2];
-                    int ll = l - pitzer_offset[h2];
-                    dum        -=  u_p[d1boff[h2] + ll*amopi_[h2]+jj];  // -D1(l,j) dkl
+                    int h2 = sym.irrep(j);
+                    int jj = j - sym.offset(h2);
+                    int ll = l - sym.offset(h2);
+                    dum        -=  u_p[d1boff[h2] + ll*sym.size(h2)+jj];  // -D1(l,j) dkl
                 }
-                A_p[offset + ij*gems_aa[h]+kl] += dum;
+                A_p[myoffset + ij*gems_aa[h]+kl] += dum;
             }
         }
         offset += gems_aa[h]*gems_aa[h];
     }
 }
 
+void v2RDMSolver::Q2_constraints_Au(SharedVector A,SharedVector u){
+    (this->*Q2_constraints_Au_fn_)(A,u,SkippedBlocks());
+}
+
+void v2RDMSolver::Q2_constraints_Au(SharedVector A,SharedVector u,const SkippedBlocks & skip){
+    (this->*Q2_constraints_Au_fn_)(A,u,skip);
+}
+
 // Q2 portion of A^T.y (with symmetry)
-void v2RDMSolver::Q2_constraints_ATu(SharedVector A,SharedVector u){
+template <class Symmetry>
+void v2RDMSolver::Q2_constraints_ATu_kernel(SharedVector A,SharedVector u,const SkippedBlocks & skip){
+
+    Symmetry sym(nirrep_,symmetry,pitzer_offset,amopi_,table);
+    bool skip_q2 = skip.q2;
 
     double * A_p = A->pointer();
     double * u_p = u->pointer();
 
     long int blocksize_ab = 0;
     long int blocksize_aa = 0;
-    for (int h = 0; h < nirrep_; h++) {
+    for (int h = 0; h < sym.nirrep(); h++) {
         blocksize_ab += gems_ab[h]*gems_ab[h];
         blocksize_aa += gems_aa[h]*gems_aa[h];
     }
 
     // map D2ab to Q2ab
     C_DAXPY(blocksize_ab, 1.0,u_p + offset,1,A_p + d2aboff[0],1); // + D2(kl,ij)
-    C_DAXPY(blocksize_ab,-1.0,u_p + offset,1,A_p + q2aboff[0],1); // - Q2(ij,kl)
-    for (int h = 0; h < nirrep_; h++) {
+    if ( !skip_q2 ) C_DAXPY(blocksize_ab,-1.0,u_p + offset,1,A_p + q2aboff[0],1); // - Q2(ij,kl)
+    for (int h = 0; h < sym.nirrep(); h++) {
         for (int ij = 0; ij < gems_ab[h]; ij++) {
             int i = bas_ab_sym[h][ij][0];
             int j = bas_ab_sym[h][ij][1];
@@ -975,25 +1016,25 @@ void v2RDMSolver::Q2_constraints_ATu(SharedVector A,SharedVector u){
             //int ii = i - pitzer_offset[hi];
             //for (int kk = 0; kk < amopi_[hi]; kk++) {
             //    int k  = kk + pitzer_offset[hi];
-            //    int kj = ibas_ab_sym[h][k][j];
+            //    int kj = ibas_ab(k,j);
             //    A_p[q1aoff[hi] + ii*amopi_[hi]+kk] += u_p[offset + ij*gems_ab[h]+kj]; // +Q1(i,k) djl
             //}
             // -D1(k,i) djl
-            int hi = symmetry[i];
-            int ii = i - pitzer_offset[hi];
-            for (int kk = 0; kk < amopi_[hi]; kk++) {
-                int k  = kk + pitzer_offset[hi];
-                int kj = ibas_ab_sym[h][k][j];
-                A_p[d1aoff[hi] + kk*amopi_[hi]+ii] -= u_p[offset + ij*gems_ab[h]+kj]; // -D1(k,i) djl
+            int hi = sym.irrep(i);
+            int ii = i - sym.offset(hi);
+            for (int kk = 0; kk < sym.size(hi); kk++) {
+                int k  = kk + sym.offset(hi);
+                int kj = ibas_ab(k,j);
+                A_p[d1aoff[hi] + kk*sym.size(hi)+ii] -= u_p[offset + ij*gems_ab[h]+kj]; // -D1(k,i) djl
             }
 
             // -D1(l,j) dik
-            int hj = symmetry[j];
-            int jj = j - pitzer_offset[hj];
-            for (int ll = 0; ll < amopi_[hj]; ll++) {
-                int l  = ll + pitzer_offset[hj];
-                int il = ibas_ab_sym[h][i][l];
-                A_p[d1boff[hj] + jj*amopi_[hj]+ll] -= u_p[offset + ij*gems_ab[h]+il]; // -D1(l,j) dik
+            int hj = sym.irrep(j);
+            int jj = j - sym.offset(hj);
+            for (int ll = 0; ll < sym.size(hj); ll++) {
+                int l  = ll + sym.offset(hj);
+                int il = ibas_ab(i,l);
+                A_p[d1boff[hj] + jj*sym.size(hj)+ll] -= u_p[offset + ij*gems_ab[h]+il]; // -D1(l,j) dik
             }
         }
         offset += gems_ab[h]*gems_ab[h];
@@ -1001,8 +1042,8 @@ void v2RDMSolver::Q2_constraints_ATu(SharedVector A,SharedVector u){
 
     // map D2aa to Q2aa
     C_DAXPY(blocksize_aa, 1.0,u_p + offset,1,A_p + d2aaoff[0],1); // + D2(kl,ij)
-    C_DAXPY(blocksize_aa,-1.0,u_p + offset,1,A_p + q2aaoff[0],1); // - Q2(ij,kl)
-    for (int h = 0; h < nirrep_; h++) {
+    if ( !skip_q2 ) C_DAXPY(blocksize_aa,-1.0,u_p + offset,1,A_p + q2aaoff[0],1); // - Q2(ij,kl)
+    for (int h = 0; h < sym.nirrep(); h++) {
         for (int ij = 0; ij < gems_aa[h]; ij++) {
             int i = bas_aa_sym[h][ij][0];
             int j = bas_aa_sym[h][ij][1];
@@ -1015,32 +1056,32 @@ void v2RDMSolver::Q2_constraints_ATu(SharedVector A,SharedVector u){
                     //int ii = i - pitzer_offset[h2];
                     //int kk = k - pitzer_offset[h2];
                     //A_p[q1aoff[h2]  + ii*amopi_[h2]+kk] += val;
-                    int h2 = symmetry[i];
-                    int ii = i - pitzer_offset[h2];
-                    int kk = k - pitzer_offset[h2];
-                    A_p[d1aoff[h2]  + kk*amopi_[h2]+ii] -= val;
+                    int h2 = sym.irrep(i);
+                    int ii = i - sym.offset(h2);
+                    int kk = k - sym.offset(h2);
+                    A_p[d1aoff[h2]  + kk*sym.size(h2)+ii] -= val;
                 }
                 if ( j==k ) {
-                    int h2 = symmetry[i];
-                    int ii = i - pitzer_offset[h2];
-                    int ll = l - pitzer_offset[h2];
-                    A_p[d1aoff[h2]  + ll*amopi_[h2]+ii] += val;
+                    int h2 = sym.irrep(i);
+                    int ii = i - sym.offset(h2);
+                    int ll = l - sym.offset(h2);
+                    A_p[d1aoff[h2]  + ll*sym.size(h2)+ii] += val;
                 }
                 if ( i==l ) {
                     //int h2 = symmetry[j];
                     //int jj = j - pitzer_offset[h2];
                     //int kk = k - pitzer_offset[h2];
                     //A_p[q1aoff[h2]  + jj*amopi_[h2]+kk] -= val;
-                    int h2 = symmetry[j];
-                    int jj = j - pitzer_offset[h2];
-                    int kk = k - pitzer_offset[h2];
-                    A_p[d1aoff[h2]  + kk*amopi_[h2]+jj] += val;
+                    int h2 = sym.irrep(j);
+                    int jj = j - sym.offset(h2);
+                    int kk = k - sym.offset(h2);
+                    A_p[d1aoff[h2]  + kk*sym.size(h2)+jj] += val;
                 }
                 if ( i==k ) {
-                    int h2 = symmetry[j];
-                    int jj = j - pitzer_offset[h2];
-                    int ll = l - pitzer_offset[h2];
-                    A_p[d1aoff[h2]  + ll*amopi_[h2]+jj] -= val;
+                    int h2 = sym.irrep(j);
+                    int jj = j - sym.offset(h2);
+                    int ll = l - sym.offset(h2);
+                    A_p[d1aoff[h2]  + ll*sym.size(h2)+jj] -= val;
                 }
             }
         }
@@ -1050,8 +1091,8 @@ void v2RDMSolver::Q2_constraints_ATu(SharedVector A,SharedVector u){
 
     // map D2bb to Q2bb
     C_DAXPY(blocksize_aa, 1.0,u_p + offset,1,A_p + d2bboff[0],1); // + D2(kl,ij)
-    C_DAXPY(blocksize_aa,-1.0,u_p + offset,1,A_p + q2bboff[0],1); // - Q2(ij,kl)
-    for (int h = 0; h < nirrep_; h++) {
+    if ( !skip_q2 ) C_DAXPY(blocksize_aa,-1.0,u_p + offset,1,A_p + q2bboff[0],1); // - Q2(ij,kl)
+    for (int h = 0; h < sym.nirrep(); h++) {
         for (int ij = 0; ij < gems_aa[h]; ij++) {
             int i = bas_aa_sym[h][ij][0];
             int j = bas_aa_sym[h][ij][1];
@@ -1064,32 +1105,32 @@ void v2RDMSolver::Q2_constraints_ATu(SharedVector A,SharedVector u){
                     //int ii = i - pitzer_offset[h2];
                     //int kk = k - pitzer_offset[h2];
                     //A_p[q1boff[h2]  + ii*amopi_[h2]+kk] += val;
-                    int h2 = symmetry[i];
-                    int ii = i - pitzer_offset[h2];
-                    int kk = k - pitzer_offset[h2];
-                    A_p[d1boff[h2]  + kk*amopi_[h2]+ii] -= val;
+                    int h2 = sym.irrep(i);
+                    int ii = i - sym.offset(h2);
+                    int kk = k - sym.offset(h2);
+                    A_p[d1boff[h2]  + kk*sym.size(h2)+ii] -= val;
                 }
                 if ( j==k ) {
-                    int h2 = symmetry[i];
-                    int ii = i - pitzer_offset[h2];
-                    int ll = l - pitzer_offset[h2];
-                    A_p[d1boff[h2]  + ll*amopi_[h2]+ii] += val;
+                    int h2 = sym.irrep(i);
+                    int ii = i - sym.offset(h2);
+                    int ll = l - sym.offset(h2);
+                    A_p[d1boff[h2]  + ll*sym.size(h2)+ii] += val;
                 }
                 if ( i==l ) {
                     //int h2 = symmetry[j];
                     //int jj = j - pitzer_offset[h2];
                     //int kk = k - pitzer_offset[h2];
                     //A_p[q1boff[h2]  + jj*amopi_[h2]+kk] -= val;
-                    int h2 = symmetry[j];
-                    int jj = j - pitzer_offset[h2];
-                    int kk = k - pitzer_offset[h2];
-                    A_p[d1boff[h2]  + kk*amopi_[h2]+jj] += val;
+                    int h2 = sym.irrep(j);
+                    int jj = j - sym.offset(h2);
+                    int kk = k - sym.offset(h2);
+                    A_p[d1boff[h2]  + kk*sym.size(h2)+jj] += val;
                 }
                 if ( i==k ) {
-                    int h2 = symmetry[j];
-                    int jj = j - pitzer_offset[h2];
-                    int ll = l - pitzer_offset[h2];
-                    A_p[d1boff[h2]  + ll*amopi_[h2]+jj] -= val;
+                    int h2 = sym.irrep(j);
+                    int jj = j - sym.offset(h2);
+                    int ll = l - sym.offset(h2);
+                    A_p[d1boff[h2]  + ll*sym.size(h2)+jj] -= val;
                 }
             }
         }
@@ -1098,4 +1139,22 @@ void v2RDMSolver::Q2_constraints_ATu(SharedVector A,SharedVector u){
 
 }
 
+void v2RDMSolver::Q2_constraints_ATu(SharedVector A,SharedVector u){
+    (this->*Q2_constraints_ATu_fn_)(A,u,SkippedBlocks());
+}
+
+void v2RDMSolver::Q2_constraints_ATu(SharedVector A,SharedVector u,const SkippedBlocks & skip){
+    (this->*Q2_constraints_ATu_fn_)(A,u,skip);
+}
+
+// C1 and point-group instantiations (selected in common_init)
+template void v2RDMSolver::Q2_constraints_Au_spin_adapted_kernel<C1Symmetry>(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+template void v2RDMSolver::Q2_constraints_ATu_spin_adapted_kernel<C1Symmetry>(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+template void v2RDMSolver::Q2_constraints_Au_kernel<C1Symmetry>(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+template void v2RDMSolver::Q2_constraints_ATu_kernel<C1Symmetry>(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+template void v2RDMSolver::Q2_constraints_Au_spin_adapted_kernel<PointGroupSymmetry>(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+template void v2RDMSolver::Q2_constraints_ATu_spin_adapted_kernel<PointGroupSymmetry>(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+template void v2RDMSolver::Q2_constraints_Au_kernel<PointGroupSymmetry>(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+template void v2RDMSolver::Q2_constraints_ATu_kernel<PointGroupSymmetry>(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+
 }} // end namespaces
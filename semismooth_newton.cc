@@ -0,0 +1,253 @@
+/*
+ *@BEGIN LICENSE
+ *
+ * v2RDM-CASSCF, a plugin to:
+ *
+ * Psi4: an open-source quantum chemistry software package
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (c) 2014, The Florida State University. All rights reserved.
+ *
+ *@END LICENSE
+ *
+ */
+
+#include <psi4/psi4-dec.h>
+#include <psi4/liboptions/liboptions.h>
+#include <psi4/libqt/qt.h>
+#include <psi4/libpsi4util/PsiOutStream.h>
+
+#include<psi4/libmints/wavefunction.h>
+#include<psi4/libmints/vector.h>
+#include<psi4/libmints/matrix.h>
+
+#include<math.h>
+#include<string.h>
+
+#include"v2rdm_solver.h"
+#include"cg_solver.h"
+#include"blas.h"
+
+#ifdef _OPENMP
+    #include<omp.h>
+#else
+    #define omp_get_wtime() ( (double)clock() / CLOCKS_PER_SEC )
+    #define omp_get_max_threads() 1
+    #define omp_get_thread_num() 0
+#endif
+
+using namespace psi;
+using namespace fnocc;
+
+// the newton operator, A.J.A^T + shift, for CGSolver
+class NewtonOperator : public CGOperator {
+public:
+    NewtonOperator(v2rdm_casscf::v2RDMSolver * solver) : solver_(solver) {}
+    void apply(long int n, SharedVector Ax, SharedVector x) {
+        solver_->ssn_Ax(n,Ax,x);
+    }
+private:
+    v2rdm_casscf::v2RDMSolver * solver_;
+};
+
+namespace psi{ namespace v2rdm_casscf{
+
+// semismooth newton-CG solver for the SDP (SDP_SOLVER = SSN_CG), after
+// SDPNAL (Zhao, Sun, and Toh, SIAM J. Optim. 20, 1737 (2010)).
+//
+// the boundary-point iterations are an augmented lagrangian method for
+// the dual problem, with penalty parameter 1/mu, in which the subproblem
+// in y is approximated by one linear solve.  here, the subproblem is
+// solved: for fixed x0, minimize
+//
+//     phi(y) = -b.y + mu/2 |x(y)|^2,   x(y) = P+(M(y)) / mu,
+//
+// with M(y) = mu x0 + A^T.y - c and P+ the projection onto the positive
+// semidefinite cone.  the gradient is -r, with r = b - A.x(y), and the
+// generalized hessian is A.J.A^T / mu, where J is the generalized jacobian
+// of P+ at M, which follows from the spectral decomposition of each block
+// that Update_xz already computes.  each newton step is obtained by CG
+// and followed by an armijo line search on phi.  at the solution, x and z
+// are those of the boundary-point update from M(y), and || Ax - b || = |r|.
+//
+// returns the total number of CG iterations.
+int v2RDMSolver::SemismoothNewton(double tol) {
+
+    const int max_newton    = 50;
+    const int max_backtrack = 20;
+    const double armijo     = 1.0e-4;
+
+    long int N = nconstraints_;
+
+    SharedVector r   = ssn_r_;
+    SharedVector d   = ssn_d_;
+    SharedVector rhs = ssn_rhs_;
+    SharedVector Ad  = ssn_Ad_;
+    SharedVector yt  = ssn_yt_;
+
+    std::shared_ptr<CGSolver> cg = ssn_cg_;
+    cg->set_max_iter(cg_maxiter_);
+    NewtonOperator newton(this);
+
+    // the subproblem is defined by x at its start
+    C_DCOPY(dimx_,x->pointer(),1,ssn_x0_->pointer(),1);
+
+    double phi = ssn_Evaluate(y,r);
+
+    int iiter = 0;
+    for (int iter = 0; iter < max_newton; iter++) {
+
+        double rnorm = r->norm();
+        if ( rnorm < tol ) break;
+
+        // ( A.J.A^T + shift ).d = mu r, to a relative accuracy of
+        // min(0.1,|r|).  the small shift makes the operator definite
+        double eta = ( rnorm < 0.1 ) ? rnorm : 0.1;
+        ssn_shift_ = 1.0e-4 * ( ( rnorm < 1.0 ) ? rnorm : 1.0 );
+
+        C_DCOPY(N,r->pointer(),1,rhs->pointer(),1);
+        rhs->scale(mu);
+        d->zero();
+        cg->set_convergence(eta * mu * rnorm);
+        cg->solve(N,Ad,d,rhs,newton);
+        iiter += cg->total_iterations();
+
+        // armijo line search.  the directional derivative of phi is -r.d
+        double slope = -C_DDOT(N,r->pointer(),1,d->pointer(),1);
+        double alpha = 1.0;
+        double phi_new = phi;
+        bool descent = false;
+        for (int k = 0; k <= max_backtrack; k++) {
+            C_DCOPY(N,y->pointer(),1,yt->pointer(),1);
+            C_DAXPY(N,alpha,d->pointer(),1,yt->pointer(),1);
+            phi_new = ssn_Evaluate(yt,r);
+            if ( phi_new <= phi + armijo * alpha * slope ) {
+                descent = true;
+                break;
+            }
+            alpha *= 0.5;
+        }
+
+        // no sufficient decrease along d (an inexact or non-descent newton
+        // step).  keep y, restore x, z, and r at y, and leave the
+        // subproblem to the next outer iteration
+        if ( !descent ) {
+            outfile->Printf("\n");
+            outfile->Printf("  SSN_CG: line search failed after %i backtracks (|r| = %10.5le)\n",max_backtrack,rnorm);
+            ssn_Evaluate(y,r);
+            break;
+        }
+
+        C_DCOPY(N,yt->pointer(),1,y->pointer(),1);
+        phi = phi_new;
+    }
+
+    return iiter;
+}
+
+// phi(u), with x, z, and the spectral decomposition of M(u) (see
+// SemismoothNewton), and the residual r = b - A.x
+double v2RDMSolver::ssn_Evaluate(SharedVector u, SharedVector r) {
+
+    // M(u) = mu x0 + A^T.u - c
+    bpsdp_ATu(ATy,u);
+    ATy->subtract(c);
+    C_DAXPY(dimx_,mu,ssn_x0_->pointer(),1,ATy->pointer(),1);
+
+    Project_xz();
+
+    bpsdp_Au(r,x);
+    r->scale(-1.0);
+    r->add(b);
+
+    double xx = C_DDOT(dimx_,x->pointer(),1,x->pointer(),1);
+    return -C_DDOT(nconstraints_,b->pointer(),1,u->pointer(),1) + 0.5 * mu * xx;
+}
+
+// the newton operator, A.J.A^T.u + shift u
+void v2RDMSolver::ssn_Ax(long int N, SharedVector A, SharedVector u) {
+
+    bpsdp_ATu(ssn_h_,u);
+
+    ForEachUpdateBlock(&v2RDMSolver::ssn_Jacobian_block);
+
+    bpsdp_Au(A,ssn_h_);
+    C_DAXPY(N,ssn_shift_,u->pointer(),1,A->pointer(),1);
+}
+
+// J.H for block i of H = ssn_h_, in place.  with M = Q.diag(lambda).Q^T,
+//
+//     J.H = Q.( Omega o ( Q^T.H.Q ) ).Q^T,
+//
+// where Omega(j,k) is 1 if lambda_j and lambda_k are both positive, 0 if
+// neither is, and lambda_j / ( lambda_j - lambda_k ) for positive lambda_j
+// and nonpositive lambda_k.  H is symmetrized first
+void v2RDMSolver::ssn_Jacobian_block(int i, int thread) {
+
+    long int n = dimensions_[i];
+
+    double * h_p   = ssn_h_->pointer() + block_offsets_[i];
+    double * q_p   = update_evec_->pointer() + block_offsets_[i];
+    double * lam_p = update_eval_->pointer() + update_eval_offsets_[i];
+    double * a_p   = update_work_[thread];
+    double * t_p   = a_p + n * n;
+
+    long int npos = 0;
+    for (long int j = 0; j < n; j++) {
+        if ( lam_p[j] > 0.0 ) npos++;
+    }
+
+    // J = 0 or J = 1
+    if ( npos == 0 ) {
+        memset((void*)h_p,'\0',n * n * sizeof(double));
+        return;
+    }
+    for (long int p = 0; p < n; p++) {
+        for (long int q = p + 1; q < n; q++) {
+            double dum = 0.5 * ( h_p[p * n + q] + h_p[q * n + p] );
+            h_p[p * n + q] = h_p[q * n + p] = dum;
+        }
+    }
+    if ( npos == n ) return;
+
+    // Q^T.H.Q
+    F_DGEMM('n','n',n,n,n,1.0,h_p,n,q_p,n,0.0,t_p,n);
+    F_DGEMM('t','n',n,n,n,1.0,q_p,n,t_p,n,0.0,a_p,n);
+
+    for (long int j = 0; j < n; j++) {
+        for (long int k = 0; k < n; k++) {
+            double lj = lam_p[j];
+            double lk = lam_p[k];
+            double omega;
+            if ( lj > 0.0 && lk > 0.0 ) {
+                omega = 1.0;
+            }else if ( lj <= 0.0 && lk <= 0.0 ) {
+                omega = 0.0;
+            }else if ( lj > 0.0 ) {
+                omega = lj / ( lj - lk );
+            }else {
+                omega = lk / ( lk - lj );
+            }
+            a_p[j * n + k] *= omega;
+        }
+    }
+
+    // Q.( ... ).Q^T
+    F_DGEMM('n','n',n,n,n,1.0,q_p,n,a_p,n,0.0,t_p,n);
+    F_DGEMM('n','t',n,n,n,1.0,t_p,n,q_p,n,0.0,h_p,n);
+}
+
+}} // end namespaces
@@ -0,0 +1,481 @@
+/*
+ *@BEGIN LICENSE
+ *
+ * v2RDM-CASSCF, a plugin to:
+ *
+ * Psi4: an open-source quantum chemistry software package
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (c) 2014, The Florida State University. All rights reserved.
+ *
+ *@END LICENSE
+ *
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<math.h>
+
+#include<algorithm>
+
+#include <psi4/psi4-dec.h>
+#include "sparse_matrix.h"
+#include "sparse_cholesky.h"
+
+#ifdef _OPENMP
+    #include<omp.h>
+#else
+    #define omp_get_thread_num() 0
+#endif
+
+namespace psi{
+
+// pivots smaller than this fraction of the original diagonal element belong
+// to linearly dependent rows of M and are dropped
+#define CHOLESKY_DROP_TOLERANCE 1e-10
+
+SparseCholesky::SparseCholesky() {
+    n_          = 0;
+    nnz_matrix_ = 0;
+    nnz_factor_ = 0;
+    Cp_ = NULL;
+    Ci_ = NULL;
+    Cx_ = NULL;
+    Up_ = NULL;
+    Ui_ = NULL;
+    Ux_ = NULL;
+    Lp_ = NULL;
+    Li_ = NULL;
+    Lx_ = NULL;
+}
+SparseCholesky::~SparseCholesky(){
+    free(Cp_);
+    free(Ci_);
+    free(Cx_);
+    free(Up_);
+    free(Ui_);
+    free(Ux_);
+    free(Lp_);
+    free(Li_);
+    free(Lx_);
+}
+
+double SparseCholesky::memory(long int n, long int nnz) {
+    return nnz * ( sizeof(int) + sizeof(double) ) + ( n + 1.0 ) * sizeof(long int);
+}
+
+// column j of the lower triangle of M.M^T holds <M(i,:),M(j,:)> for i >= j,
+// which is found by visiting, for each element M(j,k), the rows of column k
+void SparseCholesky::form_normal_matrix(SparseMatrix * M) {
+
+    n_ = M->nrow();
+
+    long int * rowptr   = M->rowptr();
+    int *      colind   = M->colind();
+    double *   val      = M->val();
+    long int * t_rowptr = M->t_rowptr();
+    int *      t_colind = M->t_colind();
+    double *   t_val    = M->t_val();
+
+    free(Cp_);
+    free(Ci_);
+    free(Cx_);
+    Cp_ = (long int*)malloc((n_+1)*sizeof(long int));
+    memset((void*)Cp_,'\0',(n_+1)*sizeof(long int));
+
+    // two passes: count elements in each column, then fill them
+    for (int pass = 0; pass < 2; pass++) {
+
+        if ( pass == 1 ) {
+            for (long int j = 0; j < n_; j++) {
+                Cp_[j+1] += Cp_[j];
+            }
+            nnz_matrix_ = Cp_[n_];
+            Ci_ = (int*)malloc(nnz_matrix_*sizeof(int));
+            Cx_ = (double*)malloc(nnz_matrix_*sizeof(double));
+        }
+
+        #pragma omp parallel
+        {
+            std::vector<long int> mark(n_,-1);
+            std::vector<double> work(n_,0.0);
+            std::vector<int> pattern;
+
+            #pragma omp for schedule (dynamic)
+            for (long int j = 0; j < n_; j++) {
+                pattern.clear();
+                for (long int p = rowptr[j]; p < rowptr[j+1]; p++) {
+                    int k = colind[p];
+                    for (long int q = t_rowptr[k]; q < t_rowptr[k+1]; q++) {
+                        int i = t_colind[q];
+                        if ( i < j ) continue;
+                        if ( mark[i] != j ) {
+                            mark[i] = j;
+                            work[i] = 0.0;
+                            pattern.push_back(i);
+                        }
+                        work[i] += val[p] * t_val[q];
+                    }
+                }
+                if ( pass == 0 ) {
+                    Cp_[j+1] = pattern.size();
+                }else {
+                    std::sort(pattern.begin(),pattern.end());
+                    long int n = Cp_[j];
+                    for (size_t q = 0; q < pattern.size(); q++) {
+                        Ci_[n] = pattern[q];
+                        Cx_[n] = work[pattern[q]];
+                        n++;
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool SparseCholesky::analyze(long int max_nnz) {
+
+    if ( !minimum_degree(max_nnz) ) return false;
+
+    permute();
+
+    // elimination tree
+    parent_.assign(n_,-1);
+    std::vector<int> ancestor(n_,-1);
+    for (int k = 0; k < n_; k++) {
+        for (long int p = Up_[k]; p < Up_[k+1]; p++) {
+            int i = Ui_[p];
+            while ( i != -1 && i < k ) {
+                int inext = ancestor[i];
+                ancestor[i] = k;
+                if ( inext == -1 ) parent_[i] = k;
+                i = inext;
+            }
+        }
+    }
+
+    // column counts of L, from the pattern of each row
+    std::vector<long int> count(n_,1);
+    std::vector<int> s(n_);
+    std::vector<int> w(n_,-1);
+    nnz_factor_ = n_;
+    for (int k = 0; k < n_; k++) {
+        int top = ereach(k,s,w);
+        for (int q = top; q < n_; q++) {
+            count[s[q]]++;
+        }
+        nnz_factor_ += n_ - top;
+        if ( nnz_factor_ > max_nnz ) return false;
+    }
+
+    free(Lp_);
+    Lp_ = (long int*)malloc((n_+1)*sizeof(long int));
+    Lp_[0] = 0;
+    for (int k = 0; k < n_; k++) {
+        Lp_[k+1] = Lp_[k] + count[k];
+    }
+
+    return true;
+}
+
+// minimum degree ordering on the explicit elimination graph.  eliminating a
+// node connects all of its neighbors; the node of smallest degree is
+// eliminated next.  nodes of very large degree (e.g., rows of A that touch
+// every element of a block of the 2-RDM) are ordered last.
+bool SparseCholesky::minimum_degree(long int max_nnz) {
+
+    int n = (int)n_;
+
+    std::vector< std::vector<int> > adj(n);
+    for (int j = 0; j < n; j++) {
+        for (long int p = Cp_[j]; p < Cp_[j+1]; p++) {
+            int i = Ci_[p];
+            if ( i == j ) continue;
+            adj[i].push_back(j);
+            adj[j].push_back(i);
+        }
+    }
+
+    size_t dense = (size_t)( 10.0 * sqrt((double)n) );
+    if ( dense < 16 ) dense = 16;
+
+    std::vector<bool> is_dense(n,false);
+    std::vector<int> dense_nodes;
+    for (int i = 0; i < n; i++) {
+        if ( adj[i].size() > dense ) {
+            is_dense[i] = true;
+            dense_nodes.push_back(i);
+        }
+    }
+
+    long int nedges = 0;
+    for (int i = 0; i < n; i++) {
+        if ( is_dense[i] ) {
+            std::vector<int>().swap(adj[i]);
+            continue;
+        }
+        std::vector<int> keep;
+        for (size_t q = 0; q < adj[i].size(); q++) {
+            if ( !is_dense[adj[i][q]] ) keep.push_back(adj[i][q]);
+        }
+        std::sort(keep.begin(),keep.end());
+        adj[i].swap(keep);
+        nedges += adj[i].size();
+    }
+
+    // degree lists
+    std::vector<int> head(n,-1);
+    std::vector<int> next(n,-1);
+    std::vector<int> prev(n,-1);
+    std::vector<int> degree(n,0);
+    for (int i = n - 1; i >= 0; i--) {
+        if ( is_dense[i] ) continue;
+        int d = adj[i].size();
+        degree[i] = d;
+        next[i] = head[d];
+        if ( head[d] != -1 ) prev[head[d]] = i;
+        head[d] = i;
+    }
+
+    perm_.clear();
+    int mindeg = 0;
+    std::vector<int> merged;
+    int nsparse = n - (int)dense_nodes.size();
+
+    for (int iter = 0; iter < nsparse; iter++) {
+
+        while ( head[mindeg] == -1 ) mindeg++;
+
+        // remove p from the degree lists
+        int p = head[mindeg];
+        head[mindeg] = next[p];
+        if ( next[p] != -1 ) prev[next[p]] = -1;
+        perm_.push_back(p);
+
+        std::vector<int> & nbr = adj[p];
+        for (size_t q = 0; q < nbr.size(); q++) {
+
+            int u = nbr[q];
+
+            // remove u from its degree list
+            if ( prev[u] != -1 ) next[prev[u]] = next[u];
+            else                 head[degree[u]] = next[u];
+            if ( next[u] != -1 ) prev[next[u]] = prev[u];
+
+            // adj(u) = adj(u) + adj(p) - {u,p}
+            merged.clear();
+            std::vector<int> & au = adj[u];
+            size_t a = 0, b = 0;
+            while ( a < au.size() || b < nbr.size() ) {
+                int x;
+                if ( b == nbr.size() || ( a < au.size() && au[a] < nbr[b] ) ) {
+                    x = au[a++];
+                }else if ( a == au.size() || nbr[b] < au[a] ) {
+                    x = nbr[b++];
+                }else {
+                    x = au[a++];
+                    b++;
+                }
+                if ( x == u || x == p ) continue;
+                merged.push_back(x);
+            }
+            nedges += (long int)merged.size() - (long int)au.size();
+            au.swap(merged);
+
+            int d = au.size();
+            degree[u] = d;
+            prev[u] = -1;
+            next[u] = head[d];
+            if ( head[d] != -1 ) prev[head[d]] = u;
+            head[d] = u;
+            if ( d < mindeg ) mindeg = d;
+        }
+        nedges -= nbr.size();
+        std::vector<int>().swap(nbr);
+
+        if ( nedges > 2 * max_nnz ) return false;
+    }
+
+    for (size_t q = 0; q < dense_nodes.size(); q++) {
+        perm_.push_back(dense_nodes[q]);
+    }
+
+    pinv_.resize(n);
+    for (int i = 0; i < n; i++) {
+        pinv_[perm_[i]] = i;
+    }
+
+    return true;
+}
+
+void SparseCholesky::permute() {
+
+    free(Up_);
+    free(Ui_);
+    free(Ux_);
+    Up_ = (long int*)malloc((n_+1)*sizeof(long int));
+    Ui_ = (int*)malloc(nnz_matrix_*sizeof(int));
+    Ux_ = (double*)malloc(nnz_matrix_*sizeof(double));
+    memset((void*)Up_,'\0',(n_+1)*sizeof(long int));
+
+    // element (i,j) of the lower triangle goes to column max(i',j') of the
+    // upper triangle of the permuted matrix
+    for (long int j = 0; j < n_; j++) {
+        for (long int p = Cp_[j]; p < Cp_[j+1]; p++) {
+            int a = pinv_[Ci_[p]];
+            int b = pinv_[j];
+            Up_[( a > b ? a : b ) + 1]++;
+        }
+    }
+    for (long int j = 0; j < n_; j++) {
+        Up_[j+1] += Up_[j];
+    }
+    std::vector<long int> pos(Up_,Up_+n_);
+    for (long int j = 0; j < n_; j++) {
+        for (long int p = Cp_[j]; p < Cp_[j+1]; p++) {
+            int a = pinv_[Ci_[p]];
+            int b = pinv_[j];
+            long int q = pos[ a > b ? a : b ]++;
+            Ui_[q] = a < b ? a : b;
+            Ux_[q] = Cx_[p];
+        }
+    }
+
+    free(Cp_);
+    free(Ci_);
+    free(Cx_);
+    Cp_ = NULL;
+    Ci_ = NULL;
+    Cx_ = NULL;
+}
+
+// walk up the elimination tree from each nonzero element of column k of the
+// upper triangle (see T. A. Davis, Direct Methods for Sparse Linear Systems)
+int SparseCholesky::ereach(int k, std::vector<int> & s, std::vector<int> & w) {
+
+    int top = n_;
+    w[k] = k;
+    for (long int p = Up_[k]; p < Up_[k+1]; p++) {
+        int i = Ui_[p];
+        if ( i > k ) continue;
+        int len = 0;
+        for ( ; w[i] != k; i = parent_[i]) {
+            s[len++] = i;
+            w[i] = k;
+        }
+        while ( len > 0 ) s[--top] = s[--len];
+    }
+    return top;
+}
+
+// up-looking factorization: row k of L is found by a sparse triangular solve
+// with the first k columns
+long int SparseCholesky::factorize() {
+
+    free(Li_);
+    free(Lx_);
+    Li_ = (int*)malloc(nnz_factor_*sizeof(int));
+    Lx_ = (double*)malloc(nnz_factor_*sizeof(double));
+
+    std::vector<long int> c(Lp_,Lp_+n_);
+    std::vector<double> x(n_,0.0);
+    std::vector<int> s(n_);
+    std::vector<int> w(n_,-1);
+
+    long int ndropped = 0;
+
+    for (int k = 0; k < n_; k++) {
+
+        int top = ereach(k,s,w);
+
+        x[k] = 0.0;
+        for (long int p = Up_[k]; p < Up_[k+1]; p++) {
+            if ( Ui_[p] <= k ) x[Ui_[p]] += Ux_[p];
+        }
+        double d = x[k];
+        double dk = d;
+        x[k] = 0.0;
+
+        for ( ; top < n_; top++) {
+            int i = s[top];
+            double lii = Lx_[Lp_[i]];
+            double lki = ( lii != 0.0 ) ? x[i] / lii : 0.0;
+            x[i] = 0.0;
+            if ( lki != 0.0 ) {
+                for (long int p = Lp_[i] + 1; p < c[i]; p++) {
+                    x[Li_[p]] -= Lx_[p] * lki;
+                }
+            }
+            d -= lki * lki;
+            long int p = c[i]++;
+            Li_[p] = k;
+            Lx_[p] = lki;
+        }
+
+        long int p = c[k]++;
+        Li_[p] = k;
+        if ( d <= CHOLESKY_DROP_TOLERANCE * dk ) {
+            Lx_[p] = 0.0;
+            ndropped++;
+        }else {
+            Lx_[p] = sqrt(d);
+        }
+    }
+
+    work_.resize(n_);
+
+    return ndropped;
+}
+
+void SparseCholesky::solve(double * x, double * b) {
+
+    double * w = work_.data();
+
+    for (long int i = 0; i < n_; i++) {
+        w[i] = b[perm_[i]];
+    }
+
+    // L.w = P.b
+    for (long int j = 0; j < n_; j++) {
+        double ljj = Lx_[Lp_[j]];
+        if ( ljj == 0.0 ) {
+            w[j] = 0.0;
+            continue;
+        }
+        w[j] /= ljj;
+        double wj = w[j];
+        for (long int p = Lp_[j] + 1; p < Lp_[j+1]; p++) {
+            w[Li_[p]] -= Lx_[p] * wj;
+        }
+    }
+
+    // L^T.w = w
+    for (long int j = n_ - 1; j >= 0; j--) {
+        double ljj = Lx_[Lp_[j]];
+        double dum = w[j];
+        for (long int p = Lp_[j] + 1; p < Lp_[j+1]; p++) {
+            dum -= Lx_[p] * w[Li_[p]];
+        }
+        w[j] = ( ljj == 0.0 ) ? 0.0 : dum / ljj;
+    }
+
+    for (long int i = 0; i < n_; i++) {
+        x[perm_[i]] = w[i];
+    }
+}
+
+}// end of namespace
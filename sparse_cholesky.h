@@ -0,0 +1,119 @@
+/*
+ *@BEGIN LICENSE
+ *
+ * v2RDM-CASSCF, a plugin to:
+ *
+ * Psi4: an open-source quantum chemistry software package
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (c) 2014, The Florida State University. All rights reserved.
+ *
+ *@END LICENSE
+ *
+ */
+
+#ifndef SPARSE_CHOLESKY_H
+#define SPARSE_CHOLESKY_H
+
+#include<vector>
+
+namespace psi{
+
+class SparseMatrix;
+
+/// sparse cholesky factorization, P.M.M^T.P^T = L.L^T, of the normal matrix
+/// of a csr matrix M.  the rows are ordered by minimum degree to reduce fill
+/// in L.  M.M^T may be singular (M may have linearly dependent rows): the
+/// pivots of dependent rows are dropped, and the corresponding elements of
+/// the solution are zero, which still solves a consistent system exactly.
+class SparseCholesky {
+public:
+
+    SparseCholesky();
+    ~SparseCholesky();
+
+    /// form the lower triangle of M.M^T
+    void form_normal_matrix(SparseMatrix * M);
+
+    /// fill-reducing ordering and symbolic factorization.  returns false
+    /// (and stops early) if L would have more than max_nnz elements
+    bool analyze(long int max_nnz);
+
+    /// numeric factorization.  returns the number of dropped pivots
+    long int factorize();
+
+    /// solve M.M^T.x = b
+    void solve(double * x, double * b);
+
+    /// was the pivot of row i of M dropped (after factorize)?
+    bool dropped(long int i) { return Lx_[Lp_[pinv_[i]]] == 0.0; }
+
+    /// dimension of M.M^T and number of elements in its lower triangle
+    long int n()          { return n_; }
+    long int nnz_matrix() { return nnz_matrix_; }
+
+    /// number of elements in L (after analyze)
+    long int nnz_factor() { return nnz_factor_; }
+
+    /// memory (bytes) required to store an n x n triangular matrix with nnz
+    /// elements
+    static double memory(long int n, long int nnz);
+
+private:
+
+    long int n_;
+    long int nnz_matrix_;
+    long int nnz_factor_;
+
+    /// lower triangle of M.M^T in csc format (row indices >= column)
+    long int * Cp_;
+    int * Ci_;
+    double * Cx_;
+
+    /// permutation: perm_[new] = old and pinv_[old] = new
+    std::vector<int> perm_;
+    std::vector<int> pinv_;
+
+    /// upper triangle of P.M.M^T.P^T in csc format
+    long int * Up_;
+    int * Ui_;
+    double * Ux_;
+
+    /// elimination tree of P.M.M^T.P^T
+    std::vector<int> parent_;
+
+    /// L in csc format (the diagonal element is first in each column)
+    long int * Lp_;
+    int * Li_;
+    double * Lx_;
+
+    /// work array for solve
+    std::vector<double> work_;
+
+    /// minimum degree ordering of the graph of M.M^T.  returns false if the
+    /// elimination graph grows beyond max_nnz edges
+    bool minimum_degree(long int max_nnz);
+
+    /// build the upper triangle of P.M.M^T.P^T (and free the lower triangle)
+    void permute();
+
+    /// nonzero pattern of row k of L, in s[top:n].  returns top
+    int ereach(int k, std::vector<int> & s, std::vector<int> & w);
+};
+
+} // end of namespace
+
+#endif
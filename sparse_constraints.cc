@@ -0,0 +1,1028 @@
+/*
+ *@BEGIN LICENSE
+ *
+ * v2RDM-CASSCF, a plugin to:
+ *
+ * Psi4: an open-source quantum chemistry software package
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (c) 2014, The Florida State University. All rights reserved.
+ *
+ *@END LICENSE
+ *
+ */
+
+#include <psi4/psi4-dec.h>
+#include <psi4/liboptions/liboptions.h>
+#include <psi4/libqt/qt.h>
+#include <psi4/libpsi4util/PsiOutStream.h>
+
+#include<psi4/libmints/wavefunction.h>
+#include<psi4/libmints/vector.h>
+#include<psi4/libmints/matrix.h>
+
+#include<math.h>
+#include<stdlib.h>
+#include<string.h>
+#include<limits.h>
+
+#include"v2rdm_solver.h"
+#include"sparse_matrix.h"
+#include"sparse_cholesky.h"
+
+#ifdef _OPENMP
+    #include<omp.h>
+#else
+    #define omp_get_wtime() ( (double)clock() / CLOCKS_PER_SEC )
+    #define omp_get_max_threads() 1
+#endif
+
+using namespace psi;
+
+namespace psi{ namespace v2rdm_casscf{
+
+// assemble the D2, Q2, and G2 rows of the constraint matrix in csr format.
+// the rows are added in exactly the order used by the matrix-free
+// D2/Q2/G2_constraints_Au functions.  T1, T2, and D3 rows are always
+// evaluated with the matrix-free functions.
+void v2RDMSolver::BuildSparseConstraints() {
+
+    if ( A_sparse_ ) return;
+
+    double start = omp_get_wtime();
+
+    outfile->Printf("\n");
+    outfile->Printf("  ==> Sparse constraint matrix <==\n");
+    outfile->Printf("\n");
+
+    if ( dimx_ > INT_MAX ) {
+        outfile->Printf("        Too many variables for sparse constraint matrix.\n");
+        outfile->Printf("        Falling back to matrix-free A.u and A^T.u.\n");
+        outfile->Printf("\n");
+        return;
+    }
+
+    std::shared_ptr<SparseMatrix> A (new SparseMatrix(nconstraints_d2q2g2_,dimx_));
+
+    // count nonzero elements
+    A->begin_assembly(true);
+    D2Q2G2_constraints_sparse(A);
+    A->end_assembly();
+
+    double mem = SparseMatrix::memory(A->nrow(),A->ncol(),A->nnz());
+
+    outfile->Printf("        Number of rows:                %10li\n",A->nrow());
+    outfile->Printf("        Number of nonzero elements:    %10li\n",A->nnz());
+    outfile->Printf("        Memory requirements:           %7.2lf mb\n",mem / 1024.0 / 1024.0);
+
+    if ( mem > (double)available_memory_ ) {
+        outfile->Printf("\n");
+        outfile->Printf("        Not enough memory for sparse constraint matrix.\n");
+        outfile->Printf("        Falling back to matrix-free A.u and A^T.u.\n");
+        outfile->Printf("\n");
+        return;
+    }
+
+    // fill nonzero elements
+    A->begin_assembly(false);
+    D2Q2G2_constraints_sparse(A);
+    A->end_assembly();
+
+    if ( !CheckSparseConstraints(A) ) {
+        outfile->Printf("        Falling back to matrix-free A.u and A^T.u.\n");
+        outfile->Printf("\n");
+        return;
+    }
+
+    A_sparse_ = A;
+    available_memory_ -= (long int)mem;
+
+    outfile->Printf("        Time for assembly:             %7.2lf s\n",omp_get_wtime() - start);
+    outfile->Printf("\n");
+}
+
+// factorize A.A^T once, for the direct solution of A.A^T.y = B in
+// compute_energy.  A and b depend only on the active space and the
+// positivity conditions, so the factorization is valid for the whole
+// computation, including orbital optimization.  CG is used instead if the
+// factor does not fit in the available memory or if A has rows (T1, T2, D3)
+// that are only available as matrix-free mappings.
+void v2RDMSolver::BuildCholeskyAAT() {
+
+    double start = omp_get_wtime();
+
+    outfile->Printf("\n");
+    outfile->Printf("  ==> Cholesky factorization of A.A^T <==\n");
+    outfile->Printf("\n");
+
+    if ( nconstraints_d2q2g2_ != nconstraints_ ) {
+        outfile->Printf("        T1, T2, and D3 constraints are not available in sparse form.\n");
+        outfile->Printf("        Falling back to CG.\n");
+        outfile->Printf("\n");
+        return;
+    }
+    if ( dimx_ > INT_MAX || nconstraints_ > INT_MAX ) {
+        outfile->Printf("        Too many variables for sparse constraint matrix.\n");
+        outfile->Printf("        Falling back to CG.\n");
+        outfile->Printf("\n");
+        return;
+    }
+
+    // the sparse constraint matrix is assembled here if it is not kept
+    std::shared_ptr<SparseMatrix> A = A_sparse_;
+    if ( !A ) {
+        A = AssembleSparseConstraints();
+    }
+    if ( !A ) {
+        outfile->Printf("        Falling back to CG.\n");
+        outfile->Printf("\n");
+        return;
+    }
+
+    std::shared_ptr<SparseCholesky> chol (new SparseCholesky());
+    chol->form_normal_matrix(A.get());
+    A.reset();
+
+    double mem_aat = SparseCholesky::memory(chol->n(),chol->nnz_matrix());
+
+    outfile->Printf("        Dimension of A.A^T:            %10li\n",chol->n());
+    outfile->Printf("        Nonzero elements of A.A^T:     %10li\n",chol->nnz_matrix());
+
+    // the factor must fit in the memory that remains after A.A^T
+    long int max_nnz = (long int)( ( (double)available_memory_ - mem_aat ) / ( sizeof(int) + sizeof(double) ) );
+
+    if ( max_nnz <= 0 || !chol->analyze(max_nnz) ) {
+        outfile->Printf("\n");
+        outfile->Printf("        Not enough memory for the Cholesky factor.\n");
+        outfile->Printf("        Falling back to CG.\n");
+        outfile->Printf("\n");
+        return;
+    }
+
+    double mem = mem_aat + SparseCholesky::memory(chol->n(),chol->nnz_factor());
+
+    outfile->Printf("        Nonzero elements of L:         %10li\n",chol->nnz_factor());
+    outfile->Printf("        Memory requirements:           %7.2lf mb\n",mem / 1024.0 / 1024.0);
+
+    long int ndropped = chol->factorize();
+
+    outfile->Printf("        Linearly dependent rows of A:  %10li\n",ndropped);
+    outfile->Printf("        Time for factorization:        %7.2lf s\n",omp_get_wtime() - start);
+    outfile->Printf("\n");
+
+    aat_cholesky_ = chol;
+    available_memory_ -= (long int)mem;
+}
+
+// single-precision copy of A (with the rows scaled by the presolve, if there
+// is one), for mixed-precision CG.  the single-precision
+// products with A.A^T use only the sparse matrix, so they are available if
+// A has no T1, T2, or D3 rows.  the sparse matrix is assembled here if it
+// has not been already.
+void v2RDMSolver::BuildSinglePrecisionAAT() {
+
+    if ( cg_mixed_precision_ ) return;
+
+    outfile->Printf("\n");
+    outfile->Printf("  ==> Single-precision A.A^T <==\n");
+    outfile->Printf("\n");
+
+    if ( nconstraints_d2q2g2_ != nconstraints_ ) {
+        outfile->Printf("        T1, T2, and D3 constraints are not available in sparse form.\n");
+        outfile->Printf("        Falling back to double-precision CG.\n");
+        outfile->Printf("\n");
+        return;
+    }
+
+    BuildSparseConstraints();
+    if ( !A_sparse_ ) {
+        outfile->Printf("        Falling back to double-precision CG.\n");
+        outfile->Printf("\n");
+        return;
+    }
+
+    // float copies of A and A^T, A^T.u, and four CG vectors
+    double mem = SparseMatrix::memory_single_precision(A_sparse_->nnz())
+               + ( dimx_ + 4.0 * nconstraints_ ) * sizeof(float);
+
+    outfile->Printf("        Memory requirements:           %7.2lf mb\n",mem / 1024.0 / 1024.0);
+
+    if ( mem > (double)available_memory_ ) {
+        outfile->Printf("\n");
+        outfile->Printf("        Not enough memory for single-precision A.A^T.\n");
+        outfile->Printf("        Falling back to double-precision CG.\n");
+        outfile->Printf("\n");
+        return;
+    }
+    outfile->Printf("\n");
+
+    A_sparse_->build_single_precision(row_scale_ ? row_scale_->pointer() : NULL);
+    ATy_sp_.resize(dimx_);
+
+    cg_mixed_precision_ = true;
+    available_memory_ -= (long int)mem;
+}
+
+// assemble the D2, Q2, and G2 rows of A without keeping them in A_sparse_
+// (for BuildCholeskyAAT and BuildPresolve).  returns NULL if the sparse rows
+// do not match the matrix-free mappings
+std::shared_ptr<SparseMatrix> v2RDMSolver::AssembleSparseConstraints() {
+
+    std::shared_ptr<SparseMatrix> A (new SparseMatrix(nconstraints_d2q2g2_,dimx_));
+    A->begin_assembly(true);
+    D2Q2G2_constraints_sparse(A);
+    A->end_assembly();
+    A->begin_assembly(false);
+    D2Q2G2_constraints_sparse(A);
+    A->end_assembly();
+
+    if ( !CheckSparseConstraints(A) ) {
+        A.reset();
+    }
+    return A;
+}
+
+// compare the sparse D2, Q2, and G2 rows of A to the matrix-free mappings
+// (D2/Q2/G2_constraints_Au and _ATu), which are the reference.  the two are
+// written separately, so any change to one that is not made to the other
+// is caught here
+bool v2RDMSolver::CheckSparseConstraints(std::shared_ptr<SparseMatrix> A) {
+
+    SharedVector u  (new Vector("u",dimx_));
+    SharedVector v  (new Vector("v",nconstraints_));
+    SharedVector Au1(new Vector("Au",nconstraints_));
+    SharedVector Au2(new Vector("Au",nconstraints_));
+    SharedVector ATv1(new Vector("ATv",dimx_));
+    SharedVector ATv2(new Vector("ATv",dimx_));
+
+    double * u_p = u->pointer();
+    double * v_p = v->pointer();
+
+    // v has nonzero elements only in the D2, Q2, and G2 rows
+    srand(0);
+    for (long int i = 0; i < dimx_; i++) {
+        u_p[i] = ( (double)rand()/RAND_MAX - 0.5 ) * 2.0;
+    }
+    for (long int i = 0; i < nconstraints_d2q2g2_; i++) {
+        v_p[i] = ( (double)rand()/RAND_MAX - 0.5 ) * 2.0;
+    }
+
+    double * Au1_p  = Au1->pointer();
+    double * Au2_p  = Au2->pointer();
+    double * ATv1_p = ATv1->pointer();
+    double * ATv2_p = ATv2->pointer();
+
+    A->Au(Au1_p,u_p);
+    A->ATu(ATv1_p,v_p);
+
+    memset((void*)Au2_p,'\0',nconstraints_*sizeof(double));
+    Au_tasks(Au2,u,true,fast_t2_,SkippedBlocks());
+
+    memset((void*)ATv2_p,'\0',dimx_*sizeof(double));
+    offset = 0;
+    D2_constraints_ATu(ATv2,v);
+    if ( constrain_q2_ ) {
+        if ( !spin_adapt_q2_ ) {
+            Q2_constraints_ATu(ATv2,v);
+        }else {
+            Q2_constraints_ATu_spin_adapted(ATv2,v);
+        }
+    }
+    if ( constrain_g2_ ) {
+        if ( ! spin_adapt_g2_ ) {
+            G2_constraints_ATu(ATv2,v);
+        }else {
+            G2_constraints_ATu_spin_adapted(ATv2,v);
+        }
+    }
+    offset = nconstraints_;
+
+    double max_Au = 0.0;
+    for (long int i = 0; i < nconstraints_d2q2g2_; i++) {
+        double dum = fabs(Au1_p[i] - Au2_p[i]);
+        if ( dum > max_Au ) max_Au = dum;
+    }
+    double max_ATu = 0.0;
+    for (long int i = 0; i < dimx_; i++) {
+        double dum = fabs(ATv1_p[i] - ATv2_p[i]);
+        if ( dum > max_ATu ) max_ATu = dum;
+    }
+
+    outfile->Printf("        max |A.u   (sparse) - A.u   (matrix-free)|: %10.3le\n",max_Au);
+    outfile->Printf("        max |A^T.u (sparse) - A^T.u (matrix-free)|: %10.3le\n",max_ATu);
+
+    if ( max_Au > 1e-10 || max_ATu > 1e-10 ) {
+        outfile->Printf("\n");
+        outfile->Printf("        Sparse constraint matrix failed check.\n");
+        return false;
+    }
+    return true;
+}
+
+// D2, Q2, and G2 rows of A, in the order used by the matrix-free mappings
+void v2RDMSolver::D2Q2G2_constraints_sparse(std::shared_ptr<SparseMatrix> A){
+    D2_constraints_sparse(A);
+    if ( constrain_q2_ ) {
+        if ( !spin_adapt_q2_ ) {
+            Q2_constraints_sparse(A);
+        }else {
+            Q2_constraints_sparse_spin_adapted(A);
+        }
+    }
+    if ( constrain_g2_ ) {
+        if ( ! spin_adapt_g2_ ) {
+            G2_constraints_sparse(A);
+        }else {
+            G2_constraints_sparse_spin_adapted(A);
+        }
+    }
+}
+
+// D2 portion of A ( and D1 / Q1 )
+void v2RDMSolver::D2_constraints_sparse(std::shared_ptr<SparseMatrix> A){
+
+    if ( constrain_spin_ ) {
+        // spin
+        for (int i = 0; i < amo_; i++){
+            for (int j = 0; j < amo_; j++){
+                int h = SymmetryPair(symmetry[i],symmetry[j]);
+                if ( gems_ab[h] == 0 ) continue;
+                int ij = ibas_ab(i,j);
+                int ji = ibas_ab(j,i);
+                A->add(d2aboff[h] + ij*gems_ab[h]+ji, 1.0);
+            }
+        }
+        A->end_row();
+    }
+
+    // Tr(D2ab)
+    for (int i = 0; i < amo_; i++){
+        for (int j = 0; j < amo_; j++){
+            int h = SymmetryPair(symmetry[i],symmetry[j]);
+            if ( gems_ab[h] == 0 ) continue;
+            int ij = ibas_ab(i,j);
+            A->add(d2aboff[h] + ij*gems_ab[h]+ij, 1.0);
+        }
+    }
+    A->end_row();
+
+    // Tr(D2aa)
+    for (int i = 0; i < amo_; i++){
+        for (int j = 0; j < amo_; j++){
+            if ( i==j ) continue;
+            int h = SymmetryPair(symmetry[i],symmetry[j]);
+            if ( gems_aa[h] == 0 ) continue;
+            int ij = ibas_aa(i,j);
+            A->add(d2aaoff[h] + ij*gems_aa[h]+ij, 1.0);
+        }
+    }
+    A->end_row();
+
+    // Tr(D2bb)
+    for (int i = 0; i < amo_; i++){
+        for (int j = 0; j < amo_; j++){
+            if ( i==j ) continue;
+            int h = SymmetryPair(symmetry[i],symmetry[j]);
+            if ( gems_aa[h] == 0 ) continue;
+            int ij = ibas_aa(i,j);
+            A->add(d2bboff[h] + ij*gems_aa[h]+ij, 1.0);
+        }
+    }
+    A->end_row();
+
+    // d1 / q1 a
+    for (int h = 0; h < nirrep_; h++) {
+        for(int i = 0; i < amopi_[h]; i++){
+            for(int j = 0; j < amopi_[h]; j++){
+                A->add(d1aoff[h]+j*amopi_[h]+i, 1.0);
+                A->add(q1aoff[h]+i*amopi_[h]+j, 1.0);
+                A->end_row();
+            }
+        }
+    }
+
+    // d1 / q1 b
+    for (int h = 0; h < nirrep_; h++) {
+        for(int i = 0; i < amopi_[h]; i++){
+            for(int j = 0; j < amopi_[h]; j++){
+                A->add(d1boff[h]+j*amopi_[h]+i, 1.0);
+                A->add(q1boff[h]+i*amopi_[h]+j, 1.0);
+                A->end_row();
+            }
+        }
+    }
+
+    int na = nalpha_ - nrstc_ - nfrzc_;
+    int nb = nbeta_ - nrstc_ - nfrzc_;
+
+    // contraction: D2ab -> D1 a
+    int poff = 0;
+    for (int h = 0; h < nirrep_; h++) {
+        for (int i = 0; i < amopi_[h]; i++){
+            for (int j = 0; j < amopi_[h]; j++){
+                A->add(d1aoff[h] + i*amopi_[h]+j, (double)nb);
+                int ii  = i + poff;
+                int jj  = j + poff;
+                for(int k = 0; k < amo_; k++){
+                    int h2  = SymmetryPair(symmetry[ii],symmetry[k]);
+                    int ik = ibas_ab(ii,k);
+                    int jk = ibas_ab(jj,k);
+                    A->add(d2aboff[h2] + ik*gems_ab[h2]+jk, -1.0);
+                }
+                A->end_row();
+            }
+        }
+        poff   += nmopi_[h] - rstcpi_[h] - frzcpi_[h] - rstvpi_[h] - frzvpi_[h];
+    }
+
+    // contraction: D2ab -> D1 b
+    poff = 0;
+    for (int h = 0; h < nirrep_; h++) {
+        for (int i = 0; i < amopi_[h]; i++){
+            for (int j = 0; j < amopi_[h]; j++){
+                A->add(d1boff[h] + i*amopi_[h]+j, (double)na);
+                int ii  = i + poff;
+                int jj  = j + poff;
+                for(int k = 0; k < amo_; k++){
+                    int h2  = SymmetryPair(symmetry[ii],symmetry[k]);
+                    int ik = ibas_ab(k,ii);
+                    int jk = ibas_ab(k,jj);
+                    A->add(d2aboff[h2] + ik*gems_ab[h2]+jk, -1.0);
+                }
+                A->end_row();
+            }
+        }
+        poff   += nmopi_[h] - rstcpi_[h] - frzcpi_[h] - rstvpi_[h] - frzvpi_[h];
+    }
+
+    //contract D2aa -> D1 a
+    poff = 0;
+    for (int h = 0; h < nirrep_; h++) {
+        for (int i = 0; i < amopi_[h]; i++){
+            for (int j = 0; j < amopi_[h]; j++){
+                A->add(d1aoff[h] + i*amopi_[h]+j, na - 1.0);
+                int ii  = i + poff;
+                int jj  = j + poff;
+                for(int k = 0; k < amo_; k++){
+                    if( ii==k || jj==k ) continue;
+                    int h2   = SymmetryPair(symmetry[ii],symmetry[k]);
+                    int ik  = ibas_aa(ii,k);
+                    int jk  = ibas_aa(jj,k);
+                    int sik = ( ii < k ) ? 1 : -1;
+                    int sjk = ( jj < k ) ? 1 : -1;
+                    A->add(d2aaoff[h2] + ik*gems_aa[h2]+jk, -sik*sjk);
+                }
+                A->end_row();
+            }
+        }
+        poff   += nmopi_[h] - rstcpi_[h] - frzcpi_[h] - rstvpi_[h] - frzvpi_[h];
+    }
+
+    //contract D2bb -> D1 b
+    poff = 0;
+    for (int h = 0; h < nirrep_; h++) {
+        for (int i = 0; i < amopi_[h]; i++){
+            for (int j = 0; j < amopi_[h]; j++){
+                A->add(d1boff[h] + i*amopi_[h]+j, nb - 1.0);
+                int ii  = i + poff;
+                int jj  = j + poff;
+                for(int k = 0; k < amo_; k++){
+                    if( ii==k || jj==k ) continue;
+                    int h2   = SymmetryPair(symmetry[ii],symmetry[k]);
+                    int ik  = ibas_aa(ii,k);
+                    int jk  = ibas_aa(jj,k);
+                    int sik = ( ii < k ) ? 1 : -1;
+                    int sjk = ( jj < k ) ? 1 : -1;
+                    A->add(d2bboff[h2] + ik*gems_aa[h2]+jk, -sik*sjk);
+                }
+                A->end_row();
+            }
+        }
+        poff   += nmopi_[h] - rstcpi_[h] - frzcpi_[h] - rstvpi_[h] - frzvpi_[h];
+    }
+
+    // additional spin constraints for singlets:
+    if ( constrain_spin_ && nalpha_ == nbeta_ ) {
+        if ( !spin_restricted_ ) {
+            // D1a = D1b
+            for ( int h = 0; h < nirrep_; h++) {
+                for (int ij = 0; ij < amopi_[h]*amopi_[h]; ij++) {
+                    A->add(d1aoff[h] + ij, 1.0);
+                    A->add(d1boff[h] + ij,-1.0);
+                    A->end_row();
+                }
+            }
+            // D2aa = D2bb
+            for ( int h = 0; h < nirrep_; h++) {
+                for (int ij = 0; ij < gems_aa[h]*gems_aa[h]; ij++) {
+                    A->add(d2aaoff[h] + ij, 1.0);
+                    A->add(d2bboff[h] + ij,-1.0);
+                    A->end_row();
+                }
+            }
+        }
+        // D2aa[pq][rs] = 1/2(D2ab[pq][rs] - D2ab[pq][sr] - D2ab[qp][rs] + D2ab[qp][sr])
+        for ( int h = 0; h < nirrep_; h++) {
+            for (int ij = 0; ij < gems_aa[h]; ij++) {
+                int i = bas_aa_sym[h][ij][0];
+                int j = bas_aa_sym[h][ij][1];
+                int ijb = ibas_ab(i,j);
+                int jib = ibas_ab(j,i);
+                for (int kl = 0; kl < gems_aa[h]; kl++) {
+                    int k = bas_aa_sym[h][kl][0];
+                    int l = bas_aa_sym[h][kl][1];
+                    int klb = ibas_ab(k,l);
+                    int lkb = ibas_ab(l,k);
+                    A->add(d2aaoff[h] + ij*gems_aa[h] + kl, 1.0);
+                    A->add(d2aboff[h] + ijb*gems_ab[h] + klb,-0.5);
+                    A->add(d2aboff[h] + jib*gems_ab[h] + klb, 0.5);
+                    A->add(d2aboff[h] + ijb*gems_ab[h] + lkb, 0.5);
+                    A->add(d2aboff[h] + jib*gems_ab[h] + lkb,-0.5);
+                    A->end_row();
+                }
+            }
+        }
+        // D2bb[pq][rs] = 1/2(D2ab[pq][rs] - D2ab[pq][sr] - D2ab[qp][rs] + D2ab[qp][sr])
+        for ( int h = 0; h < nirrep_; h++) {
+            for (int ij = 0; ij < gems_aa[h]; ij++) {
+                int i = bas_aa_sym[h][ij][0];
+                int j = bas_aa_sym[h][ij][1];
+                int ijb = ibas_ab(i,j);
+                int jib = ibas_ab(j,i);
+                for (int kl = 0; kl < gems_aa[h]; kl++) {
+                    int k = bas_aa_sym[h][kl][0];
+                    int l = bas_aa_sym[h][kl][1];
+                    int klb = ibas_ab(k,l);
+                    int lkb = ibas_ab(l,k);
+                    A->add(d2bboff[h] + ij*gems_aa[h] + kl, 1.0);
+                    A->add(d2aboff[h] + ijb*gems_ab[h] + klb,-0.5);
+                    A->add(d2aboff[h] + jib*gems_ab[h] + klb, 0.5);
+                    A->add(d2aboff[h] + ijb*gems_ab[h] + lkb, 0.5);
+                    A->add(d2aboff[h] + jib*gems_ab[h] + lkb,-0.5);
+                    A->end_row();
+                }
+            }
+        }
+        // D200 = 1/(2 sqrt(1+dpq)sqrt(1+drs)) ( D2ab[pq][rs] + D2ab[pq][sr] + D2ab[qp][rs] + D2ab[qp][sr] )
+        for ( int h = 0; h < nirrep_; h++) {
+            for (int ij = 0; ij < gems_ab[h]; ij++) {
+                int i = bas_ab_sym[h][ij][0];
+                int j = bas_ab_sym[h][ij][1];
+                int ji = ibas_ab(j,i);
+                double dij = ( i == j ) ? sqrt(2.0) : 1.0;
+                for (int kl = 0; kl < gems_ab[h]; kl++) {
+                    int k = bas_ab_sym[h][kl][0];
+                    int l = bas_ab_sym[h][kl][1];
+                    int lk = ibas_ab(l,k);
+                    double dkl = ( k == l ) ? sqrt(2.0) : 1.0;
+                    A->add(d200off[h] + ij*gems_ab[h] + kl, 1.0);
+                    A->add(d2aboff[h] + ij*gems_ab[h] + kl,-0.5 / ( dij * dkl ));
+                    A->add(d2aboff[h] + ji*gems_ab[h] + kl,-0.5 / ( dij * dkl ));
+                    A->add(d2aboff[h] + ij*gems_ab[h] + lk,-0.5 / ( dij * dkl ));
+                    A->add(d2aboff[h] + ji*gems_ab[h] + lk,-0.5 / ( dij * dkl ));
+                    A->end_row();
+                }
+            }
+        }
+    }else if ( constrain_spin_ ) { // nonsinglets ... big block
+
+        for ( int h = 0; h < nirrep_; h++) {
+            int g = gems_ab[h];
+            for (int IJ = 0; IJ < 2*g; IJ++) {
+                int ij = ( IJ < g ) ? IJ : IJ - g;
+                int i = bas_ab_sym[h][ij][0];
+                int j = bas_ab_sym[h][ij][1];
+                int ji = ibas_ab(j,i);
+                double dij = ( i == j ) ? sqrt(2.0) : 1.0;
+                for (int KL = 0; KL < 2*g; KL++) {
+                    int kl = ( KL < g ) ? KL : KL - g;
+                    int k = bas_ab_sym[h][kl][0];
+                    int l = bas_ab_sym[h][kl][1];
+                    int lk = ibas_ab(l,k);
+                    double dkl = ( k == l ) ? sqrt(2.0) : 1.0;
+                    A->add(d200off[h] + IJ*2*g + KL, 1.0);
+                    if ( IJ < g && KL < g ) {
+                        // D200
+                        A->add(d2aboff[h] + ij*g + kl,-0.5 / ( dij * dkl ));
+                        A->add(d2aboff[h] + ji*g + kl,-0.5 / ( dij * dkl ));
+                        A->add(d2aboff[h] + ij*g + lk,-0.5 / ( dij * dkl ));
+                        A->add(d2aboff[h] + ji*g + lk,-0.5 / ( dij * dkl ));
+                    }else if ( IJ < g ) {
+                        // D201
+                        A->add(d2aboff[h] + ij*g + kl,-0.5 / dij);
+                        A->add(d2aboff[h] + ij*g + lk, 0.5 / dij);
+                        A->add(d2aboff[h] + ji*g + kl,-0.5 / dij);
+                        A->add(d2aboff[h] + ji*g + lk, 0.5 / dij);
+                    }else if ( KL < g ) {
+                        // D210
+                        A->add(d2aboff[h] + ij*g + kl,-0.5 / dkl);
+                        A->add(d2aboff[h] + ij*g + lk,-0.5 / dkl);
+                        A->add(d2aboff[h] + ji*g + kl, 0.5 / dkl);
+                        A->add(d2aboff[h] + ji*g + lk, 0.5 / dkl);
+                    }else {
+                        // D211
+                        A->add(d2aboff[h] + ij*g + kl,-0.5);
+                        A->add(d2aboff[h] + ji*g + kl, 0.5);
+                        A->add(d2aboff[h] + ij*g + lk, 0.5);
+                        A->add(d2aboff[h] + ji*g + lk,-0.5);
+                    }
+                    A->end_row();
+                }
+            }
+        }
+    }
+}
+
+// Q2 portion of A (with symmetry)
+void v2RDMSolver::Q2_constraints_sparse(std::shared_ptr<SparseMatrix> A){
+
+    // map D2ab to Q2ab
+    for (int h = 0; h < nirrep_; h++) {
+        for (int ij = 0; ij < gems_ab[h]; ij++) {
+            int i = bas_ab_sym[h][ij][0];
+            int j = bas_ab_sym[h][ij][1];
+            int hi = symmetry[i];
+            int hj = symmetry[j];
+            int ii = i - pitzer_offset[hi];
+            int jj = j - pitzer_offset[hj];
+            for (int kl = 0; kl < gems_ab[h]; kl++) {
+                int k = bas_ab_sym[h][kl][0];
+                int l = bas_ab_sym[h][kl][1];
+                A->add(d2aboff[h] + ij*gems_ab[h]+kl, 1.0);                 // + D2(kl,ij)
+                A->add(q2aboff[h] + ij*gems_ab[h]+kl,-1.0);                 // - Q2(kl,ij)
+                if ( j==l ) {
+                    int kk = k - pitzer_offset[hi];
+                    A->add(d1aoff[hi] + kk*amopi_[hi]+ii,-1.0);            // -D1(k,i) djl
+                }
+                if ( i==k ) {
+                    int ll = l - pitzer_offset[hj];
+                    A->add(d1boff[hj] + jj*amopi_[hj]+ll,-1.0);            // -D1(l,j) dik
+                }
+                A->end_row();
+            }
+        }
+    }
+
+    // map D2aa to Q2aa, D2bb to Q2bb
+    for (int s = 0; s < 2; s++) {
+        int * d2off = ( s == 0 ) ? d2aaoff : d2bboff;
+        int * q2off = ( s == 0 ) ? q2aaoff : q2bboff;
+        int * d1off = ( s == 0 ) ? d1aoff  : d1boff;
+        for (int h = 0; h < nirrep_; h++) {
+            for (int ij = 0; ij < gems_aa[h]; ij++) {
+                int i = bas_aa_sym[h][ij][0];
+                int j = bas_aa_sym[h][ij][1];
+                for (int kl = 0; kl < gems_aa[h]; kl++) {
+                    int k = bas_aa_sym[h][kl][0];
+                    int l = bas_aa_sym[h][kl][1];
+                    A->add(d2off[h] + ij*gems_aa[h]+kl, 1.0);               // + D2(kl,ij)
+                    A->add(q2off[h] + ij*gems_aa[h]+kl,-1.0);               // - Q2(kl,ij)
+                    if ( j==l ) {
+                        int h2 = symmetry[i];
+                        int ii = i - pitzer_offset[h2];
+                        int kk = k - pitzer_offset[h2];
+                        A->add(d1off[h2] + kk*amopi_[h2]+ii,-1.0);         // -D1(k,i) djl
+                    }
+                    if ( j==k ) {
+                        int h2 = symmetry[i];
+                        int ii = i - pitzer_offset[h2];
+                        int ll = l - pitzer_offset[h2];
+                        A->add(d1off[h2] + ll*amopi_[h2]+ii, 1.0);         // +D1(l,i) djk
+                    }
+                    if ( i==l ) {
+                        int h2 = symmetry[j];
+                        int jj = j - pitzer_offset[h2];
+                        int kk = k - pitzer_offset[h2];
+                        A->add(d1off[h2] + kk*amopi_[h2]+jj, 1.0);         // +D1(k,j) dil
+                    }
+                    if ( i==k ) {
+                        int h2 = symmetry[j];
+                        int jj = j - pitzer_offset[h2];
+                        int ll = l - pitzer_offset[h2];
+                        A->add(d1off[h2] + ll*amopi_[h2]+jj,-1.0);         // -D1(l,j) dik
+                    }
+                    A->end_row();
+                }
+            }
+        }
+    }
+}
+
+// Q2 portion of A (spin adapted)
+void v2RDMSolver::Q2_constraints_sparse_spin_adapted(std::shared_ptr<SparseMatrix> A){
+
+    // map D2ab to Q2s (sg = 1) and Q210 (sg = -1)
+    for (int s = 0; s < 2; s++) {
+        double sg     = ( s == 0 ) ? 1.0 : -1.0;
+        int * gems    = ( s == 0 ) ? gems_00 : gems_aa;
+        int (** bas)[2] = ( s == 0 ) ? bas_00_sym : bas_aa_sym;
+        int * q2off   = ( s == 0 ) ? q2soff : q2toff;
+        for (int h = 0; h < nirrep_; h++) {
+            for (int ij = 0; ij < gems[h]; ij++) {
+                int i = bas[h][ij][0];
+                int j = bas[h][ij][1];
+                int ijd = ibas_ab(i,j);
+                int jid = ibas_ab(j,i);
+                for (int kl = 0; kl < gems[h]; kl++) {
+                    int k = bas[h][kl][0];
+                    int l = bas[h][kl][1];
+                    int kld = ibas_ab(k,l);
+                    int lkd = ibas_ab(l,k);
+
+                    A->add(q2off[h] + ij*gems[h]+kl,-1.0);                       // -Q2(ij,kl)
+                    A->add(d2aboff[h] + kld*gems_ab[h]+ijd, 0.5);                // +D2(kl,ij)
+                    A->add(d2aboff[h] + lkd*gems_ab[h]+ijd, 0.5 * sg);           // +D2(lk,ij)
+                    A->add(d2aboff[h] + kld*gems_ab[h]+jid, 0.5 * sg);           // +D2(kl,ji)
+                    A->add(d2aboff[h] + lkd*gems_ab[h]+jid, 0.5);                // +D2(lk,ji)
+
+                    if ( j==l ) {
+                        int h2 = symmetry[i];
+                        int ii = i - pitzer_offset[h2];
+                        int kk = k - pitzer_offset[h2];
+                        A->add(q1aoff[h2] + ii*amopi_[h2]+kk, 0.5);              // +Q1(i,k) djl
+                        A->add(d1boff[h2] + ii*amopi_[h2]+kk,-0.5);              // -D1(i,k) djl
+                    }
+                    if ( i==k ) {
+                        int h2 = symmetry[j];
+                        int jj = j - pitzer_offset[h2];
+                        int ll = l - pitzer_offset[h2];
+                        A->add(q1aoff[h2] + ll*amopi_[h2]+jj, 0.5);              // +Q1(l,j) dik
+                        A->add(d1boff[h2] + ll*amopi_[h2]+jj,-0.5);              // -D1(l,j) dik
+                    }
+                    if ( j==k ) {
+                        int h2 = symmetry[i];
+                        int ii = i - pitzer_offset[h2];
+                        int ll = l - pitzer_offset[h2];
+                        A->add(q1aoff[h2] + ll*amopi_[h2]+ii, 0.5 * sg);         // +Q1(l,i) djk
+                        A->add(d1boff[h2] + ll*amopi_[h2]+ii,-0.5 * sg);         // -D1(l,i) djk
+                    }
+                    if ( i==l ) {
+                        int h2 = symmetry[j];
+                        int jj = j - pitzer_offset[h2];
+                        int kk = k - pitzer_offset[h2];
+                        A->add(q1aoff[h2] + kk*amopi_[h2]+jj, 0.5 * sg);         // +Q1(k,j) dil
+                        A->add(d1boff[h2] + kk*amopi_[h2]+jj,-0.5 * sg);         // -D1(k,j) dil
+                    }
+                    A->end_row();
+                }
+            }
+        }
+    }
+
+    // map D2aa to Q211, D2bb to Q21-1
+    for (int s = 0; s < 2; s++) {
+        int * q2off = ( s == 0 ) ? q2toff_p1 : q2toff_m1;
+        int * d2off = ( s == 0 ) ? d2aaoff   : d2bboff;
+        int * q1off = ( s == 0 ) ? q1aoff    : q1boff;
+        int * d1off = ( s == 0 ) ? d1aoff    : d1boff;
+        for (int h = 0; h < nirrep_; h++) {
+            for (int ij = 0; ij < gems_aa[h]; ij++) {
+                int i = bas_aa_sym[h][ij][0];
+                int j = bas_aa_sym[h][ij][1];
+                for (int kl = 0; kl < gems_aa[h]; kl++) {
+                    int k = bas_aa_sym[h][kl][0];
+                    int l = bas_aa_sym[h][kl][1];
+                    A->add(q2off[h] + ij*gems_aa[h]+kl,-1.0);                    // -Q2(ij,kl)
+                    A->add(d2off[h] + kl*gems_aa[h]+ij, 1.0);                    // +D2(kl,ij)
+
+                    if ( j==l ) {
+                        int h2 = symmetry[i];
+                        int ii = i - pitzer_offset[h2];
+                        int kk = k - pitzer_offset[h2];
+                        A->add(q1off[h2] + ii*amopi_[h2]+kk, 1.0);               // +Q1(i,k) djl
+                    }
+                    if ( j==k ) {
+                        int h2 = symmetry[i];
+                        int ii = i - pitzer_offset[h2];
+                        int ll = l - pitzer_offset[h2];
+                        A->add(d1off[h2] + ll*amopi_[h2]+ii, 1.0);               // +D1(l,i) djk
+                    }
+                    if ( i==l ) {
+                        int h2 = symmetry[j];
+                        int jj = j - pitzer_offset[h2];
+                        int kk = k - pitzer_offset[h2];
+                        A->add(q1off[h2] + jj*amopi_[h2]+kk,-1.0);               // -Q1(j,k) dil
+                    }
+                    if ( i==k ) {
+                        int h2 = symmetry[j];
+                        int jj = j - pitzer_offset[h2];
+                        int ll = l - pitzer_offset[h2];
+                        A->add(d1off[h2] + ll*amopi_[h2]+jj,-1.0);               // -D1(l,j) dik
+                    }
+                    A->end_row();
+                }
+            }
+        }
+    }
+}
+
+// G2 portion of A (with symmetry)
+void v2RDMSolver::G2_constraints_sparse(std::shared_ptr<SparseMatrix> A){
+
+    // G2ab constraints:
+    for (int h = 0; h < nirrep_; h++) {
+        for (int ijg = 0; ijg < gems_ab[h]; ijg++) {
+            int i = bas_ab_sym[h][ijg][0];
+            int j = bas_ab_sym[h][ijg][1];
+            for (int klg = 0; klg < gems_ab[h]; klg++) {
+                int k = bas_ab_sym[h][klg][0];
+                int l = bas_ab_sym[h][klg][1];
+
+                A->add(g2aboff[h] + ijg*gems_ab[h]+klg,-1.0);                    // - G2ab(ij,kl)
+
+                if ( j==l ) {
+                    int h3 = symmetry[i];
+                    int ii = i - pitzer_offset[h3];
+                    int kk = k - pitzer_offset[h3];
+                    A->add(d1aoff[h3] + ii*amopi_[h3]+kk, 1.0);                  //   D1(i,k) djl
+                }
+
+                int h2 = SymmetryPair(symmetry[i],symmetry[l]);
+                int ild = ibas_ab(i,l);
+                int kjd = ibas_ab(k,j);
+                A->add(d2aboff[h2] + ild*gems_ab[h2]+kjd,-1.0);                  // - D2ab(il,kj)
+
+                A->end_row();
+            }
+        }
+    }
+    // G2ba constraints:
+    for (int h = 0; h < nirrep_; h++) {
+        for (int ijg = 0; ijg < gems_ab[h]; ijg++) {
+            int i = bas_ab_sym[h][ijg][0];
+            int j = bas_ab_sym[h][ijg][1];
+            for (int klg = 0; klg < gems_ab[h]; klg++) {
+                int k = bas_ab_sym[h][klg][0];
+                int l = bas_ab_sym[h][klg][1];
+
+                A->add(g2baoff[h] + ijg*gems_ab[h]+klg,-1.0);                    // - G2ba(ij,kl)
+
+                if ( j==l ) {
+                    int h3 = symmetry[i];
+                    int ii = i - pitzer_offset[h3];
+                    int kk = k - pitzer_offset[h3];
+                    A->add(d1boff[h3] + ii*amopi_[h3]+kk, 1.0);                  //   D1(i,k) djl
+                }
+
+                int h2 = SymmetryPair(symmetry[i],symmetry[l]);
+                int lid = ibas_ab(l,i);
+                int jkd = ibas_ab(j,k);
+                A->add(d2aboff[h2] + lid*gems_ab[h2]+jkd,-1.0);                  //   -D2ab(li,jk)
+
+                A->end_row();
+            }
+        }
+    }
+    // G2aaaa / G2aabb / G2bbaa / G2bbbb
+    for (int h = 0; h < nirrep_; h++) {
+        int g = gems_ab[h];
+        for (int IJ = 0; IJ < 2*g; IJ++) {
+            int ijg = ( IJ < g ) ? IJ : IJ - g;
+            int i = bas_ab_sym[h][ijg][0];
+            int j = bas_ab_sym[h][ijg][1];
+            for (int KL = 0; KL < 2*g; KL++) {
+                int klg = ( KL < g ) ? KL : KL - g;
+                int k = bas_ab_sym[h][klg][0];
+                int l = bas_ab_sym[h][klg][1];
+
+                int h2 = SymmetryPair(symmetry[i],symmetry[l]);
+
+                A->add(g2aaoff[h] + IJ*2*g + KL,-1.0);                           // - G2(ij,kl)
+
+                if ( ( IJ < g ) == ( KL < g ) ) {
+                    // G2aaaa / G2bbbb
+                    int * d1off = ( IJ < g ) ? d1aoff  : d1boff;
+                    int * d2off = ( IJ < g ) ? d2aaoff : d2bboff;
+                    if ( j == l ) {
+                        int h3 = symmetry[i];
+                        int ii = i - pitzer_offset[h3];
+                        int kk = k - pitzer_offset[h3];
+                        A->add(d1off[h3] + ii*amopi_[h3]+kk, 1.0);               //   D1(i,k) djl
+                    }
+                    if ( i != l && k != j ) {
+                        int sil = ( i < l ? 1 : -1 );
+                        int skj = ( k < j ? 1 : -1 );
+                        int ild = ibas_aa(i,l);
+                        int kjd = ibas_aa(k,j);
+                        A->add(d2off[h2] + ild*gems_aa[h2]+kjd,-sil*skj);        // -D2aa(il,kj)
+                    }
+                }else if ( IJ < g ) {
+                    // G2aabb
+                    int ild = ibas_ab(i,l);
+                    int jkd = ibas_ab(j,k);
+                    A->add(d2aboff[h2] + ild*gems_ab[h2]+jkd, 1.0);              // D2ab(il,jk)
+                }else {
+                    // G2bbaa
+                    int lid = ibas_ab(l,i);
+                    int kjd = ibas_ab(k,j);
+                    A->add(d2aboff[h2] + lid*gems_ab[h2]+kjd, 1.0);              // D2ab(li,kj)
+                }
+                A->end_row();
+            }
+        }
+    }
+}
+
+// G2 portion of A (spin adapted)
+void v2RDMSolver::G2_constraints_sparse_spin_adapted(std::shared_ptr<SparseMatrix> A){
+
+    // G200 (sg = 1) and G210 (sg = -1)
+    for (int s = 0; s < 2; s++) {
+        double sg   = ( s == 0 ) ? 1.0 : -1.0;
+        int * g2off = ( s == 0 ) ? g2soff : g2toff;
+        for (int h = 0; h < nirrep_; h++) {
+            for (int ijg = 0; ijg < gems_ab[h]; ijg++) {
+                int i = bas_ab_sym[h][ijg][0];
+                int j = bas_ab_sym[h][ijg][1];
+                for (int klg = 0; klg < gems_ab[h]; klg++) {
+                    int k = bas_ab_sym[h][klg][0];
+                    int l = bas_ab_sym[h][klg][1];
+
+                    A->add(g2off[h] + ijg*gems_ab[h]+klg,-1.0);                  // - G2(ij,kl)
+
+                    if ( j == l ) {
+                        int h3 = symmetry[i];
+                        int ii = i - pitzer_offset[h3];
+                        int kk = k - pitzer_offset[h3];
+                        A->add(d1aoff[h3] + ii*amopi_[h3]+kk, 0.5);              //   D1(i,k) djl
+                        A->add(d1boff[h3] + ii*amopi_[h3]+kk, 0.5);              //   D1(i,k) djl
+                    }
+
+                    int h2 = SymmetryPair(symmetry[i],symmetry[l]);
+
+                    if ( i != l && k != j ) {
+                        int sil = ( i < l ? 1 : -1 );
+                        int skj = ( k < j ? 1 : -1 );
+                        int ild = ibas_aa(i,l);
+                        int kjd = ibas_aa(k,j);
+                        A->add(d2aaoff[h2] + ild*gems_aa[h2]+kjd,-0.5 * sil * skj); // -D2aa(il,kj)
+                        A->add(d2bboff[h2] + ild*gems_aa[h2]+kjd,-0.5 * sil * skj); // -D2bb(il,kj)
+                    }
+
+                    int ild = ibas_ab(i,l);
+                    int jkd = ibas_ab(j,k);
+                    A->add(d2aboff[h2] + ild*gems_ab[h2]+jkd, 0.5 * sg);         // D2ab(il,jk)
+
+                    int lid = ibas_ab(l,i);
+                    int kjd = ibas_ab(k,j);
+                    A->add(d2aboff[h2] + lid*gems_ab[h2]+kjd, 0.5 * sg);         // D2ab(li,kj)
+
+                    A->end_row();
+                }
+            }
+        }
+    }
+
+    // G211 and G21-1 constraints:
+    for (int s = 0; s < 2; s++) {
+        int * g2off = ( s == 0 ) ? g2toff_p1 : g2toff_m1;
+        int * d1off = ( s == 0 ) ? d1aoff    : d1boff;
+        for (int h = 0; h < nirrep_; h++) {
+            for (int ijg = 0; ijg < gems_ab[h]; ijg++) {
+                int i = bas_ab_sym[h][ijg][0];
+                int j = bas_ab_sym[h][ijg][1];
+                for (int klg = 0; klg < gems_ab[h]; klg++) {
+                    int k = bas_ab_sym[h][klg][0];
+                    int l = bas_ab_sym[h][klg][1];
+
+                    A->add(g2off[h] + ijg*gems_ab[h]+klg,-1.0);                  // - G2(ij,kl)
+
+                    if ( j == l ) {
+                        int h3 = symmetry[i];
+                        int ii = i - pitzer_offset[h3];
+                        int kk = k - pitzer_offset[h3];
+                        A->add(d1off[h3] + ii*amopi_[h3]+kk, 1.0);               //   D1(i,k) djl
+                    }
+
+                    int h2 = SymmetryPair(symmetry[i],symmetry[l]);
+                    if ( s == 0 ) {
+                        int ild = ibas_ab(i,l);
+                        int kjd = ibas_ab(k,j);
+                        A->add(d2aboff[h2] + ild*gems_ab[h2]+kjd,-1.0);          // - D2ab(il,kj)
+                    }else {
+                        int lid = ibas_ab(l,i);
+                        int jkd = ibas_ab(j,k);
+                        A->add(d2aboff[h2] + lid*gems_ab[h2]+jkd,-1.0);          // - D2ab(li,jk)
+                    }
+
+                    A->end_row();
+                }
+            }
+        }
+    }
+}
+
+}}
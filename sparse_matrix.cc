@@ -0,0 +1,240 @@
+/*
+ *@BEGIN LICENSE
+ *
+ * v2RDM-CASSCF, a plugin to:
+ *
+ * Psi4: an open-source quantum chemistry software package
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (c) 2014, The Florida State University. All rights reserved.
+ *
+ *@END LICENSE
+ *
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<math.h>
+
+#include<algorithm>
+
+#include <psi4/psi4-dec.h>
+#include "sparse_matrix.h"
+
+namespace psi{
+
+SparseMatrix::SparseMatrix(long int nrow, long int ncol) {
+    nrow_       = nrow;
+    ncol_       = ncol;
+    nnz_        = 0;
+    row_        = 0;
+    count_only_ = true;
+    row_norms_  = NULL;
+
+    rowptr_     = (long int*)malloc((nrow_+1)*sizeof(long int));
+    t_rowptr_   = (long int*)malloc((ncol_+1)*sizeof(long int));
+    memset((void*)rowptr_,'\0',(nrow_+1)*sizeof(long int));
+    memset((void*)t_rowptr_,'\0',(ncol_+1)*sizeof(long int));
+
+    colind_     = NULL;
+    val_        = NULL;
+    t_colind_   = NULL;
+    t_val_      = NULL;
+    val_sp_     = NULL;
+    t_val_sp_   = NULL;
+}
+SparseMatrix::~SparseMatrix(){
+    free(rowptr_);
+    free(t_rowptr_);
+    free(colind_);
+    free(val_);
+    free(t_colind_);
+    free(t_val_);
+    free(val_sp_);
+    free(t_val_sp_);
+}
+
+double SparseMatrix::memory(long int nrow, long int ncol, long int nnz) {
+    return 2.0 * nnz * ( sizeof(int) + sizeof(double) ) + ( nrow + ncol + 2.0 ) * sizeof(long int);
+}
+
+double SparseMatrix::memory_single_precision(long int nnz) {
+    return 2.0 * nnz * sizeof(float);
+}
+
+void SparseMatrix::begin_assembly(bool count_only) {
+
+    count_only_ = count_only;
+    row_        = 0;
+    current_row_.clear();
+
+    if ( count_only_ ) return;
+
+    // allocate storage for elements counted in previous pass
+    nnz_ = rowptr_[nrow_];
+
+    free(colind_);
+    free(val_);
+    colind_ = (int*)malloc(nnz_*sizeof(int));
+    val_    = (double*)malloc(nnz_*sizeof(double));
+}
+
+void SparseMatrix::add(long int col, double val) {
+    current_row_.push_back(std::make_pair(col,val));
+}
+
+void SparseMatrix::end_row() {
+
+    if ( row_ >= nrow_ ) {
+        throw PsiException("SparseMatrix: too many rows",__FILE__,__LINE__);
+    }
+
+    // sort by column and sum duplicates
+    std::sort(current_row_.begin(),current_row_.end());
+
+    long int n = rowptr_[row_];
+    double norm = 0.0;
+    for (size_t i = 0; i < current_row_.size(); i++) {
+        long int col = current_row_[i].first;
+        double   val = current_row_[i].second;
+        while ( i + 1 < current_row_.size() && current_row_[i+1].first == col ) {
+            i++;
+            val += current_row_[i].second;
+        }
+        if ( val == 0.0 ) continue;
+        norm += val * val;
+        if ( !count_only_ ) {
+            colind_[n] = (int)col;
+            val_[n]    = val;
+        }
+        n++;
+    }
+    rowptr_[row_+1] = n;
+    if ( row_norms_ ) row_norms_[row_] = norm;
+
+    current_row_.clear();
+    row_++;
+}
+
+void SparseMatrix::end_assembly() {
+
+    if ( row_ != nrow_ ) {
+        throw PsiException("SparseMatrix: wrong number of rows",__FILE__,__LINE__);
+    }
+
+    if ( count_only_ ) {
+        nnz_ = rowptr_[nrow_];
+        return;
+    }
+
+    // transpose: count elements in each column
+    memset((void*)t_rowptr_,'\0',(ncol_+1)*sizeof(long int));
+    for (long int n = 0; n < nnz_; n++) {
+        t_rowptr_[colind_[n]+1]++;
+    }
+    for (long int i = 0; i < ncol_; i++) {
+        t_rowptr_[i+1] += t_rowptr_[i];
+    }
+
+    free(t_colind_);
+    free(t_val_);
+    t_colind_ = (int*)malloc(nnz_*sizeof(int));
+    t_val_    = (double*)malloc(nnz_*sizeof(double));
+
+    long int * pos = (long int*)malloc(ncol_*sizeof(long int));
+    memcpy((void*)pos,(void*)t_rowptr_,ncol_*sizeof(long int));
+    for (long int i = 0; i < nrow_; i++) {
+        for (long int n = rowptr_[i]; n < rowptr_[i+1]; n++) {
+            long int j = pos[colind_[n]]++;
+            t_colind_[j] = (int)i;
+            t_val_[j]    = val_[n];
+        }
+    }
+    free(pos);
+}
+
+void SparseMatrix::Au(double * A, double * u) {
+    #pragma omp parallel for schedule (static)
+    for (long int i = 0; i < nrow_; i++) {
+        double dum = 0.0;
+        for (long int n = rowptr_[i]; n < rowptr_[i+1]; n++) {
+            dum += val_[n] * u[colind_[n]];
+        }
+        A[i] = dum;
+    }
+}
+
+void SparseMatrix::ATu(double * A, double * u) {
+    ATu(A,u,ncol_);
+}
+
+void SparseMatrix::ATu(double * A, double * u, long int ncol) {
+    #pragma omp parallel for schedule (static)
+    for (long int i = 0; i < ncol; i++) {
+        double dum = 0.0;
+        for (long int n = t_rowptr_[i]; n < t_rowptr_[i+1]; n++) {
+            dum += t_val_[n] * u[t_colind_[n]];
+        }
+        A[i] = dum;
+    }
+}
+
+// the single-precision products stream half as many bytes of matrix
+// elements and vectors.  the column indices are shared with the double-
+// precision matrix.
+void SparseMatrix::build_single_precision(const double * row_scale) {
+    free(val_sp_);
+    free(t_val_sp_);
+    val_sp_   = (float*)malloc(nnz_*sizeof(float));
+    t_val_sp_ = (float*)malloc(nnz_*sizeof(float));
+    for (long int i = 0; i < nrow_; i++) {
+        double scale = row_scale ? row_scale[i] : 1.0;
+        for (long int n = rowptr_[i]; n < rowptr_[i+1]; n++) {
+            val_sp_[n] = (float)( scale * val_[n] );
+        }
+    }
+    for (long int n = 0; n < nnz_; n++) {
+        double scale = row_scale ? row_scale[t_colind_[n]] : 1.0;
+        t_val_sp_[n] = (float)( scale * t_val_[n] );
+    }
+}
+
+void SparseMatrix::Au(float * A, const float * u) {
+    #pragma omp parallel for schedule (static)
+    for (long int i = 0; i < nrow_; i++) {
+        float dum = 0.0f;
+        #pragma omp simd reduction(+:dum)
+        for (long int n = rowptr_[i]; n < rowptr_[i+1]; n++) {
+            dum += val_sp_[n] * u[colind_[n]];
+        }
+        A[i] = dum;
+    }
+}
+
+void SparseMatrix::ATu(float * A, const float * u) {
+    #pragma omp parallel for schedule (static)
+    for (long int i = 0; i < ncol_; i++) {
+        float dum = 0.0f;
+        #pragma omp simd reduction(+:dum)
+        for (long int n = t_rowptr_[i]; n < t_rowptr_[i+1]; n++) {
+            dum += t_val_sp_[n] * u[t_colind_[n]];
+        }
+        A[i] = dum;
+    }
+}
+
+}// end of namespace
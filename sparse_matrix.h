@@ -0,0 +1,134 @@
+/*
+ *@BEGIN LICENSE
+ *
+ * v2RDM-CASSCF, a plugin to:
+ *
+ * Psi4: an open-source quantum chemistry software package
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (c) 2014, The Florida State University. All rights reserved.
+ *
+ *@END LICENSE
+ *
+ */
+
+#ifndef SPARSE_MATRIX_H
+#define SPARSE_MATRIX_H
+
+#include<vector>
+#include<utility>
+
+namespace psi{
+
+/// compressed sparse row (CSR) matrix with a stored transpose.  the matrix
+/// is assembled row by row, twice: once to count the nonzero elements and
+/// once to fill them.
+class SparseMatrix {
+public:
+
+    SparseMatrix(long int nrow, long int ncol);
+    ~SparseMatrix();
+
+    /// begin an assembly pass.  if count_only, only count nonzero elements
+    void begin_assembly(bool count_only);
+
+    /// add an element to the current row
+    void add(long int col, double val);
+
+    /// close the current row (duplicate columns are summed)
+    void end_row();
+
+    /// close an assembly pass.  after the filling pass, build the transpose
+    void end_assembly();
+
+    /// during subsequent passes, store the squared norm of each row (the
+    /// diagonal of M.M^T) in row_norms
+    void set_row_norms(double * row_norms) { row_norms_ = row_norms; }
+
+    /// memory (bytes) required to store the matrix and its transpose
+    static double memory(long int nrow, long int ncol, long int nnz);
+
+    /// A = M.u
+    void Au(double * A, double * u);
+
+    /// A = M^T.u
+    void ATu(double * A, double * u);
+
+    /// A(0:ncol) = M(:,0:ncol)^T.u
+    void ATu(double * A, double * u, long int ncol);
+
+    /// keep single-precision copies of the elements of M and M^T (after
+    /// the filling pass), for the float versions of Au and ATu.  if
+    /// row_scale is given, row i of the copies is scaled by row_scale[i]
+    void build_single_precision(const double * row_scale = NULL);
+    bool has_single_precision() { return val_sp_ != NULL; }
+
+    /// memory (bytes) required by build_single_precision
+    static double memory_single_precision(long int nnz);
+
+    /// A = M.u and A = M^T.u in single precision
+    void Au(float * A, const float * u);
+    void ATu(float * A, const float * u);
+
+    long int nrow() { return nrow_; }
+    long int ncol() { return ncol_; }
+    long int nnz()  { return nnz_; }
+
+    /// csr arrays of M and of M^T (valid after the filling pass)
+    long int * rowptr()   { return rowptr_; }
+    int *      colind()   { return colind_; }
+    double *   val()      { return val_; }
+    long int * t_rowptr() { return t_rowptr_; }
+    int *      t_colind() { return t_colind_; }
+    double *   t_val()    { return t_val_; }
+
+private:
+
+    long int nrow_;
+    long int ncol_;
+    long int nnz_;
+
+    /// number of rows added during the current pass
+    long int row_;
+
+    /// counting (true) or filling (false) pass?
+    bool count_only_;
+
+    /// squared row norms (optional; see set_row_norms)
+    double * row_norms_;
+
+    /// elements of the row currently being assembled
+    std::vector < std::pair<long int,double> > current_row_;
+
+    /// M in csr format
+    long int * rowptr_;
+    int * colind_;
+    double * val_;
+
+    /// M^T in csr format
+    long int * t_rowptr_;
+    int * t_colind_;
+    double * t_val_;
+
+    /// single-precision copies of val_ and t_val_ (NULL if not built)
+    float * val_sp_;
+    float * t_val_sp_;
+
+};
+
+} // end of namespace
+
+#endif
@@ -0,0 +1,82 @@
+/*
+ *@BEGIN LICENSE
+ *
+ * v2RDM-CASSCF, a plugin to:
+ *
+ * Psi4: an open-source quantum chemistry software package
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (c) 2014, The Florida State University. All rights reserved.
+ *
+ *@END LICENSE
+ *
+ */
+
+#ifndef SYMMETRY_POLICY_H
+#define SYMMETRY_POLICY_H
+
+namespace psi{ namespace v2rdm_casscf{
+
+/// symmetry policies for the templated constraint kernels (Q2, G2, T1, T2).
+/// a policy answers the point-group questions that the kernels ask in their
+/// inner loops: the number of irreps, the irrep of an active orbital, the
+/// direct product of two irreps, and the first orbital / number of orbitals
+/// in an irrep.  both policies are small and are passed by value.
+
+/// any abelian point group: all lookups go through the solver's tables
+class PointGroupSymmetry {
+public:
+
+    PointGroupSymmetry(int nirrep, int * symmetry, int * pitzer_offset, int * amopi, int * table) :
+        nirrep_(nirrep), symmetry_(symmetry), pitzer_offset_(pitzer_offset), amopi_(amopi), table_(table) {}
+
+    inline int nirrep() const { return nirrep_; }
+    inline int irrep(int p) const { return symmetry_[p]; }
+    inline int pair(int h1, int h2) const { return table_[h1*8+h2]; }
+    inline int offset(int h) const { return pitzer_offset_[h]; }
+    inline int size(int h) const { return amopi_[h]; }
+
+private:
+
+    int nirrep_;
+    int * symmetry_;
+    int * pitzer_offset_;
+    int * amopi_;
+    int * table_;
+};
+
+/// C1: every lookup is a compile-time constant (except the number of active
+/// orbitals), so the kernels reduce to dense loops over all orbitals
+class C1Symmetry {
+public:
+
+    C1Symmetry(int nirrep, int * symmetry, int * pitzer_offset, int * amopi, int * table) :
+        amo_(amopi[0]) {}
+
+    inline int nirrep() const { return 1; }
+    inline int irrep(int p) const { return 0; }
+    inline int pair(int h1, int h2) const { return 0; }
+    inline int offset(int h) const { return 0; }
+    inline int size(int h) const { return amo_; }
+
+private:
+
+    int amo_;
+};
+
+}}
+
+#endif
@@ -40,12 +40,14 @@
 #include<time.h>
 
 #include"v2rdm_solver.h"
+#include"symmetry_policy.h"
 
 #ifdef _OPENMP
     #include<omp.h>
 #else
     #define omp_get_wtime() ( (double)clock() / CLOCKS_PER_SEC )
     #define omp_get_max_threads() 1
+    #define omp_get_thread_num() 0
 #endif
 
 using namespace psi;
@@ -79,37 +81,37 @@ void v2RDMSolver::T1_constraints_guess(SharedVector u){
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
                     dum += u_p[q2aaoff[hij] + ij*gems_aa[hij] + lm];  // Q2(ij,lm) dkn
                 }
 
                 if ( j == l ) {
                     int hki = SymmetryPair(symmetry[k],symmetry[i]);
-                    int nm = ibas_ab_sym[hki][m][n];
-                    int ki = ibas_ab_sym[hki][i][k];
+                    int nm = ibas_ab(m,n);
+                    int ki = ibas_ab(i,k);
                     dum -= u_p[d2aboff[hki] + nm*gems_ab[hki] + ki];  // -D2(nm,ki) dlj
                 }
 
                 if ( l == i ) {
                     int hkj = SymmetryPair(symmetry[k],symmetry[j]);
-                    int nm = ibas_ab_sym[hkj][m][n];
-                    int kj = ibas_ab_sym[hkj][j][k];
+                    int nm = ibas_ab(m,n);
+                    int kj = ibas_ab(j,k);
                     dum += u_p[d2aboff[hkj] + nm*gems_ab[hkj] + kj];  // D2(nm,kj) dli
                 }
 
                 if ( j == m ) {
                     int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int kl = ibas_ab_sym[hni][k][l];
+                    int ni = ibas_ab(n,i);
+                    int kl = ibas_ab(k,l);
                     dum -= u_p[g2baoff[hni] + ni*gems_ab[hni] + kl];  // -G2(ni,kl) djm
                     
                 }
 
                 if ( i == m ) {
                     int hkl = SymmetryPair(symmetry[k],symmetry[l]);
-                    int nj = ibas_ab_sym[hkl][n][j];
-                    int kl = ibas_ab_sym[hkl][k][l];
+                    int nj = ibas_ab(n,j);
+                    int kl = ibas_ab(k,l);
                     dum += u_p[g2baoff[hkl] + nj*gems_ab[hkl] + kl];  // G2(nj,kl) dim
                     
                 }
@@ -141,37 +143,37 @@ void v2RDMSolver::T1_constraints_guess(SharedVector u){
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
                     dum += u_p[q2bboff[hij] + ij*gems_aa[hij] + lm];  // Q2(ij,lm) dkn
                 }
 
                 if ( j == l ) {
                     int hki = SymmetryPair(symmetry[k],symmetry[i]);
-                    int nm = ibas_ab_sym[hki][n][m];
-                    int ki = ibas_ab_sym[hki][k][i];
+                    int nm = ibas_ab(n,m);
+                    int ki = ibas_ab(k,i);
                     dum -= u_p[d2aboff[hki] + nm*gems_ab[hki] + ki];  // -D2(nm,ki) dlj
                 }
 
                 if ( l == i ) {
                     int hkj = SymmetryPair(symmetry[k],symmetry[j]);
-                    int nm = ibas_ab_sym[hkj][n][m];
-                    int kj = ibas_ab_sym[hkj][k][j];
+                    int nm = ibas_ab(n,m);
+                    int kj = ibas_ab(k,j);
                     dum += u_p[d2aboff[hkj] + nm*gems_ab[hkj] + kj];  // D2(nm,kj) dli
                 }
 
                 if ( j == m ) {
                     int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int kl = ibas_ab_sym[hni][k][l];
+                    int ni = ibas_ab(n,i);
+                    int kl = ibas_ab(k,l);
                     dum -= u_p[g2aboff[hni] + ni*gems_ab[hni] + kl];  // -G2(ni,kl) djm
                     
                 }
 
                 if ( i == m ) {
                     int hkl = SymmetryPair(symmetry[k],symmetry[l]);
-                    int nj = ibas_ab_sym[hkl][n][j];
-                    int kl = ibas_ab_sym[hkl][k][l];
+                    int nj = ibas_ab(n,j);
+                    int kl = ibas_ab(k,l);
                     dum += u_p[g2aboff[hkl] + nj*gems_ab[hkl] + kl];  // G2(nj,kl) dim
                     
                 }
@@ -204,8 +206,8 @@ void v2RDMSolver::T1_constraints_guess(SharedVector u){
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
                     dum += u_p[q2aaoff[hij] + ij*gems_aa[hij] + lm];  // Q2(ij,lm) dkn
                 }
 
@@ -213,8 +215,8 @@ void v2RDMSolver::T1_constraints_guess(SharedVector u){
                     int hik = SymmetryPair(symmetry[i],symmetry[k]);
                     int hlm = SymmetryPair(symmetry[l],symmetry[m]);
                     if ( hik == hlm ) {
-                        int ik = ibas_aa_sym[hik][i][k];
-                        int lm = ibas_aa_sym[hik][l][m];
+                        int ik = ibas_aa(i,k);
+                        int lm = ibas_aa(l,m);
                         dum -= u_p[q2aaoff[hik] + ik*gems_aa[hik] + lm];  // -Q2(ik,lm) djn
                     }
                 }
@@ -223,8 +225,8 @@ void v2RDMSolver::T1_constraints_guess(SharedVector u){
                     int hjk = SymmetryPair(symmetry[j],symmetry[k]);
                     int hlm = SymmetryPair(symmetry[l],symmetry[m]);
                     if ( hjk == hlm ) {
-                        int jk = ibas_aa_sym[hjk][j][k];
-                        int lm = ibas_aa_sym[hjk][l][m];
+                        int jk = ibas_aa(j,k);
+                        int lm = ibas_aa(l,m);
                         dum += u_p[q2aaoff[hjk] + jk*gems_aa[hjk] + lm];  // Q2(jk,lm) din
                     }
                 }
@@ -234,23 +236,23 @@ void v2RDMSolver::T1_constraints_guess(SharedVector u){
                     int hnm = SymmetryPair(symmetry[n],symmetry[m]);
                     int hji = SymmetryPair(symmetry[j],symmetry[i]);
                     if ( hji == hnm ) {
-                        int nm = ibas_aa_sym[hji][n][m];
-                        int ji = ibas_aa_sym[hji][j][i];
+                        int nm = ibas_aa(n,m);
+                        int ji = ibas_aa(j,i);
                         dum += u_p[d2aaoff[hji] + nm*gems_aa[hji] + ji];  // D2(nm,ji) dlk
                     }
                 }
 
                 if ( j == l ) {
                     int hki = SymmetryPair(symmetry[k],symmetry[i]);
-                    int nm = ibas_aa_sym[hki][n][m];
-                    int ki = ibas_aa_sym[hki][k][i];
+                    int nm = ibas_aa(n,m);
+                    int ki = ibas_aa(k,i);
                     dum -= u_p[d2aaoff[hki] + nm*gems_aa[hki] + ki];  // -D2(nm,ki) dlj
                 }
 
                 if ( l == i ) {
                     int hkj = SymmetryPair(symmetry[k],symmetry[j]);
-                    int nm = ibas_aa_sym[hkj][n][m];
-                    int kj = ibas_aa_sym[hkj][k][j];
+                    int nm = ibas_aa(n,m);
+                    int kj = ibas_aa(k,j);
                     dum += u_p[d2aaoff[hkj] + nm*gems_aa[hkj] + kj];  // D2(nm,kj) dli
                 }
 
@@ -262,8 +264,8 @@ void v2RDMSolver::T1_constraints_guess(SharedVector u){
                         dum -= u_p[d1aoff[h2] + nn*amopi_[h2]+ii]; // - D1(n,i) djl dkm
                     }
                     int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int jl = ibas_ab_sym[hni][j][l];
+                    int ni = ibas_ab(n,i);
+                    int jl = ibas_ab(j,l);
                     dum += u_p[g2aaoff[hni] + ni*2*gems_ab[hni] + jl];  // G2(ni,jl) dkm
                     
                 }
@@ -276,8 +278,8 @@ void v2RDMSolver::T1_constraints_guess(SharedVector u){
                         dum += u_p[d1aoff[h2] + nn*amopi_[h2]+ii]; // D1(n,i) dkl djm
                     }
                     int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int kl = ibas_ab_sym[hni][k][l];
+                    int ni = ibas_ab(n,i);
+                    int kl = ibas_ab(k,l);
                     dum -= u_p[g2aaoff[hni] + ni*2*gems_ab[hni] + kl];  // -G2(ni,kl) djm
                     
                 }
@@ -290,8 +292,8 @@ void v2RDMSolver::T1_constraints_guess(SharedVector u){
                         dum -= u_p[d1aoff[h2] + nn*amopi_[h2]+jj]; // - D1(n,j) dkl dim
                     }
                     int hkl = SymmetryPair(symmetry[k],symmetry[l]);
-                    int nj = ibas_ab_sym[hkl][n][j];
-                    int kl = ibas_ab_sym[hkl][k][l];
+                    int nj = ibas_ab(n,j);
+                    int kl = ibas_ab(k,l);
                     dum += u_p[g2aaoff[hkl] + nj*2*gems_ab[hkl] + kl];  // G2(nj,kl) dim
                     
                 }
@@ -325,8 +327,8 @@ void v2RDMSolver::T1_constraints_guess(SharedVector u){
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
                     dum += u_p[q2bboff[hij] + ij*gems_aa[hij] + lm];  // Q2(ij,lm) dkn
                 }
 
@@ -334,8 +336,8 @@ void v2RDMSolver::T1_constraints_guess(SharedVector u){
                     int hik = SymmetryPair(symmetry[i],symmetry[k]);
                     int hlm = SymmetryPair(symmetry[l],symmetry[m]);
                     if ( hik == hlm ) {
-                        int ik = ibas_aa_sym[hik][i][k];
-                        int lm = ibas_aa_sym[hik][l][m];
+                        int ik = ibas_aa(i,k);
+                        int lm = ibas_aa(l,m);
                         dum -= u_p[q2bboff[hik] + ik*gems_aa[hik] + lm];  // -Q2(ik,lm) djn
                     }
                 }
@@ -344,8 +346,8 @@ void v2RDMSolver::T1_constraints_guess(SharedVector u){
                     int hjk = SymmetryPair(symmetry[j],symmetry[k]);
                     int hlm = SymmetryPair(symmetry[l],symmetry[m]);
                     if ( hjk == hlm ) {
-                        int jk = ibas_aa_sym[hjk][j][k];
-                        int lm = ibas_aa_sym[hjk][l][m];
+                        int jk = ibas_aa(j,k);
+                        int lm = ibas_aa(l,m);
                         dum += u_p[q2bboff[hjk] + jk*gems_aa[hjk] + lm];  // Q2(jk,lm) din
                     }
                 }
@@ -355,23 +357,23 @@ void v2RDMSolver::T1_constraints_guess(SharedVector u){
                     int hnm = SymmetryPair(symmetry[n],symmetry[m]);
                     int hji = SymmetryPair(symmetry[j],symmetry[i]);
                     if ( hji == hnm ) {
-                        int nm = ibas_aa_sym[hji][n][m];
-                        int ji = ibas_aa_sym[hji][j][i];
+                        int nm = ibas_aa(n,m);
+                        int ji = ibas_aa(j,i);
                         dum += u_p[d2bboff[hji] + nm*gems_aa[hji] + ji];  // D2(nm,ji) dlk
                     }
                 }
 
                 if ( j == l ) {
                     int hki = SymmetryPair(symmetry[k],symmetry[i]);
-                    int nm = ibas_aa_sym[hki][n][m];
-                    int ki = ibas_aa_sym[hki][k][i];
+                    int nm = ibas_aa(n,m);
+                    int ki = ibas_aa(k,i);
                     dum -= u_p[d2bboff[hki] + nm*gems_aa[hki] + ki];  // -D2(nm,ki) dlj
                 }
 
                 if ( l == i ) {
                     int hkj = SymmetryPair(symmetry[k],symmetry[j]);
-                    int nm = ibas_aa_sym[hkj][n][m];
-                    int kj = ibas_aa_sym[hkj][k][j];
+                    int nm = ibas_aa(n,m);
+                    int kj = ibas_aa(k,j);
                     dum += u_p[d2bboff[hkj] + nm*gems_aa[hkj] + kj];  // D2(nm,kj) dli
                 }
 
@@ -383,8 +385,8 @@ void v2RDMSolver::T1_constraints_guess(SharedVector u){
                         dum -= u_p[d1boff[h2] + nn*amopi_[h2]+ii]; // - D1(n,i) djl dkm
                     }
                     int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int jl = ibas_ab_sym[hni][j][l];
+                    int ni = ibas_ab(n,i);
+                    int jl = ibas_ab(j,l);
                     dum += u_p[g2aaoff[hni] + (ni+gems_ab[hni])*2*gems_ab[hni] + (jl+gems_ab[hni])];  // G2(ni,jl) dkm
                     
                 }
@@ -397,8 +399,8 @@ void v2RDMSolver::T1_constraints_guess(SharedVector u){
                         dum += u_p[d1boff[h2] + nn*amopi_[h2]+ii]; // D1(n,i) dkl djm
                     }
                     int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int kl = ibas_ab_sym[hni][k][l];
+                    int ni = ibas_ab(n,i);
+                    int kl = ibas_ab(k,l);
                     dum -= u_p[g2aaoff[hni] + (ni+gems_ab[hni])*2*gems_ab[hni] + (kl+gems_ab[hni])];  // -G2(ni,kl) djm
                     
                 }
@@ -411,8 +413,8 @@ void v2RDMSolver::T1_constraints_guess(SharedVector u){
                         dum -= u_p[d1boff[h2] + nn*amopi_[h2]+jj]; // - D1(n,j) dkl dim
                     }
                     int hkl = SymmetryPair(symmetry[k],symmetry[l]);
-                    int nj = ibas_ab_sym[hkl][n][j];
-                    int kl = ibas_ab_sym[hkl][k][l];
+                    int nj = ibas_ab(n,j);
+                    int kl = ibas_ab(k,l);
                     dum += u_p[g2aaoff[hkl] + (nj+gems_ab[hkl])*2*gems_ab[hkl] + (kl+gems_ab[hkl])];  // G2(nj,kl) dim
                     
                 }
@@ -430,15 +432,20 @@ void v2RDMSolver::T1_constraints_guess(SharedVector u){
 }
 
 // T1 portion of A.u 
-void v2RDMSolver::T1_constraints_Au(SharedVector A,SharedVector u){
+template <class Symmetry>
+void v2RDMSolver::T1_constraints_Au_kernel(SharedVector A,SharedVector u,const SkippedBlocks & skip){
+
+    Symmetry sym(nirrep_,symmetry,pitzer_offset,amopi_,table);
+    bool skip_t1 = skip.t1;
 
     double * A_p = A->pointer();
     double * u_p = u->pointer();
 
     // T1aab
-    for (int h = 0; h < nirrep_; h++) {
+    for (int h = 0; h < sym.nirrep(); h++) {
 
-        #pragma omp parallel for schedule (static)
+        long int myoffset = offset;
+        #pragma omp taskloop nogroup
         for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
 
             int i = bas_aab_sym[h][ijk][0];
@@ -451,47 +458,47 @@ void v2RDMSolver::T1_constraints_Au(SharedVector A,SharedVector u){
                 int m = bas_aab_sym[h][lmn][1];
                 int n = bas_aab_sym[h][lmn][2];
 
-                double dum = -u_p[t1aaboff[h] + ijk*trip_aab[h]+lmn]; // - T1(ijk,lmn)
+                double dum = skip_t1 ? 0.0 : -u_p[t1aaboff[h] + ijk*trip_aab[h]+lmn]; // - T1(ijk,lmn)
 
                 if ( k == n ) {
-                    int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
+                    int hij = sym.pair(sym.irrep(i),sym.irrep(j));
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
                     dum += u_p[q2aaoff[hij] + ij*gems_aa[hij] + lm];  // Q2(ij,lm) dkn
                 }
 
                 if ( j == l ) {
-                    int hki = SymmetryPair(symmetry[k],symmetry[i]);
-                    int nm = ibas_ab_sym[hki][m][n];
-                    int ki = ibas_ab_sym[hki][i][k];
+                    int hki = sym.pair(sym.irrep(k),sym.irrep(i));
+                    int nm = ibas_ab(m,n);
+                    int ki = ibas_ab(i,k);
                     dum -= u_p[d2aboff[hki] + nm*gems_ab[hki] + ki];  // -D2(nm,ki) dlj
                 }
 
                 if ( l == i ) {
-                    int hkj = SymmetryPair(symmetry[k],symmetry[j]);
-                    int nm = ibas_ab_sym[hkj][m][n];
-                    int kj = ibas_ab_sym[hkj][j][k];
+                    int hkj = sym.pair(sym.irrep(k),sym.irrep(j));
+                    int nm = ibas_ab(m,n);
+                    int kj = ibas_ab(j,k);
                     dum += u_p[d2aboff[hkj] + nm*gems_ab[hkj] + kj];  // D2(nm,kj) dli
                 }
 
                 if ( j == m ) {
-                    int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int kl = ibas_ab_sym[hni][k][l];
+                    int hni = sym.pair(sym.irrep(n),sym.irrep(i));
+                    int ni = ibas_ab(n,i);
+                    int kl = ibas_ab(k,l);
                     dum -= u_p[g2baoff[hni] + ni*gems_ab[hni] + kl];  // -G2(ni,kl) djm
                     
                 }
 
                 if ( i == m ) {
-                    int hkl = SymmetryPair(symmetry[k],symmetry[l]);
-                    int nj = ibas_ab_sym[hkl][n][j];
-                    int kl = ibas_ab_sym[hkl][k][l];
+                    int hkl = sym.pair(sym.irrep(k),sym.irrep(l));
+                    int nj = ibas_ab(n,j);
+                    int kl = ibas_ab(k,l);
                     dum += u_p[g2baoff[hkl] + nj*gems_ab[hkl] + kl];  // G2(nj,kl) dim
                     
                 }
 
 
-                A_p[offset + ijk*trip_aab[h]+lmn] = dum;
+                A_p[myoffset + ijk*trip_aab[h]+lmn] = dum;
 
 
             }
@@ -500,9 +507,10 @@ void v2RDMSolver::T1_constraints_Au(SharedVector A,SharedVector u){
 
     }
     // T1bba
-    for (int h = 0; h < nirrep_; h++) {
+    for (int h = 0; h < sym.nirrep(); h++) {
 
-        #pragma omp parallel for schedule (static)
+        long int myoffset = offset;
+        #pragma omp taskloop nogroup
         for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
 
             int i = bas_aab_sym[h][ijk][0];
@@ -515,47 +523,47 @@ void v2RDMSolver::T1_constraints_Au(SharedVector A,SharedVector u){
                 int m = bas_aab_sym[h][lmn][1];
                 int n = bas_aab_sym[h][lmn][2];
 
-                double dum = -u_p[t1bbaoff[h] + ijk*trip_aab[h]+lmn]; // - T1(ijk,lmn)
+                double dum = skip_t1 ? 0.0 : -u_p[t1bbaoff[h] + ijk*trip_aab[h]+lmn]; // - T1(ijk,lmn)
 
                 if ( k == n ) {
-                    int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
+                    int hij = sym.pair(sym.irrep(i),sym.irrep(j));
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
                     dum += u_p[q2bboff[hij] + ij*gems_aa[hij] + lm];  // Q2(ij,lm) dkn
                 }
 
                 if ( j == l ) {
-                    int hki = SymmetryPair(symmetry[k],symmetry[i]);
-                    int nm = ibas_ab_sym[hki][n][m];
-                    int ki = ibas_ab_sym[hki][k][i];
+                    int hki = sym.pair(sym.irrep(k),sym.irrep(i));
+                    int nm = ibas_ab(n,m);
+                    int ki = ibas_ab(k,i);
                     dum -= u_p[d2aboff[hki] + nm*gems_ab[hki] + ki];  // -D2(nm,ki) dlj
                 }
 
                 if ( l == i ) {
-                    int hkj = SymmetryPair(symmetry[k],symmetry[j]);
-                    int nm = ibas_ab_sym[hkj][n][m];
-                    int kj = ibas_ab_sym[hkj][k][j];
+                    int hkj = sym.pair(sym.irrep(k),sym.irrep(j));
+                    int nm = ibas_ab(n,m);
+                    int kj = ibas_ab(k,j);
                     dum += u_p[d2aboff[hkj] + nm*gems_ab[hkj] + kj];  // D2(nm,kj) dli
                 }
 
                 if ( j == m ) {
-                    int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int kl = ibas_ab_sym[hni][k][l];
+                    int hni = sym.pair(sym.irrep(n),sym.irrep(i));
+                    int ni = ibas_ab(n,i);
+                    int kl = ibas_ab(k,l);
                     dum -= u_p[g2aboff[hni] + ni*gems_ab[hni] + kl];  // -G2(ni,kl) djm
                     
                 }
 
                 if ( i == m ) {
-                    int hkl = SymmetryPair(symmetry[k],symmetry[l]);
-                    int nj = ibas_ab_sym[hkl][n][j];
-                    int kl = ibas_ab_sym[hkl][k][l];
+                    int hkl = sym.pair(sym.irrep(k),sym.irrep(l));
+                    int nj = ibas_ab(n,j);
+                    int kl = ibas_ab(k,l);
                     dum += u_p[g2aboff[hkl] + nj*gems_ab[hkl] + kl];  // G2(nj,kl) dim
                     
                 }
 
 
-                A_p[offset + ijk*trip_aab[h]+lmn] = dum;
+                A_p[myoffset + ijk*trip_aab[h]+lmn] = dum;
 
 
             }
@@ -564,9 +572,10 @@ void v2RDMSolver::T1_constraints_Au(SharedVector A,SharedVector u){
 
     }
     // T1aaa
-    for (int h = 0; h < nirrep_; h++) {
+    for (int h = 0; h < sym.nirrep(); h++) {
 
-        #pragma omp parallel for schedule (static)
+        long int myoffset = offset;
+        #pragma omp taskloop nogroup
         for (int ijk = 0; ijk < trip_aaa[h]; ijk++) {
 
             int i = bas_aaa_sym[h][ijk][0];
@@ -579,104 +588,104 @@ void v2RDMSolver::T1_constraints_Au(SharedVector A,SharedVector u){
                 int m = bas_aaa_sym[h][lmn][1];
                 int n = bas_aaa_sym[h][lmn][2];
 
-                double dum = -u_p[t1aaaoff[h] + ijk*trip_aaa[h]+lmn]; // - T1(ijk,lmn)
+                double dum = skip_t1 ? 0.0 : -u_p[t1aaaoff[h] + ijk*trip_aaa[h]+lmn]; // - T1(ijk,lmn)
 
                 if ( k == n ) {
-                    int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
+                    int hij = sym.pair(sym.irrep(i),sym.irrep(j));
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
                     dum += u_p[q2aaoff[hij] + ij*gems_aa[hij] + lm];  // Q2(ij,lm) dkn
                 }
 
                 if ( j == n ) {
-                    int hik = SymmetryPair(symmetry[i],symmetry[k]);
-                    int hlm = SymmetryPair(symmetry[l],symmetry[m]);
+                    int hik = sym.pair(sym.irrep(i),sym.irrep(k));
+                    int hlm = sym.pair(sym.irrep(l),sym.irrep(m));
                     if ( hik == hlm ) {
-                        int ik = ibas_aa_sym[hik][i][k];
-                        int lm = ibas_aa_sym[hik][l][m];
+                        int ik = ibas_aa(i,k);
+                        int lm = ibas_aa(l,m);
                         dum -= u_p[q2aaoff[hik] + ik*gems_aa[hik] + lm];  // -Q2(ik,lm) djn
                     }
                 }
 
                 if ( i == n ) {
-                    int hjk = SymmetryPair(symmetry[j],symmetry[k]);
-                    int hlm = SymmetryPair(symmetry[l],symmetry[m]);
+                    int hjk = sym.pair(sym.irrep(j),sym.irrep(k));
+                    int hlm = sym.pair(sym.irrep(l),sym.irrep(m));
                     if ( hjk == hlm ) {
-                        int jk = ibas_aa_sym[hjk][j][k];
-                        int lm = ibas_aa_sym[hjk][l][m];
+                        int jk = ibas_aa(j,k);
+                        int lm = ibas_aa(l,m);
                         dum += u_p[q2aaoff[hjk] + jk*gems_aa[hjk] + lm];  // Q2(jk,lm) din
                     }
                 }
 
 
                 if ( l == k ) {
-                    int hnm = SymmetryPair(symmetry[n],symmetry[m]);
-                    int hji = SymmetryPair(symmetry[j],symmetry[i]);
+                    int hnm = sym.pair(sym.irrep(n),sym.irrep(m));
+                    int hji = sym.pair(sym.irrep(j),sym.irrep(i));
                     if ( hji == hnm ) {
-                        int nm = ibas_aa_sym[hji][n][m];
-                        int ji = ibas_aa_sym[hji][j][i];
+                        int nm = ibas_aa(n,m);
+                        int ji = ibas_aa(j,i);
                         dum += u_p[d2aaoff[hji] + nm*gems_aa[hji] + ji];  // D2(nm,ji) dlk
                     }
                 }
 
                 if ( j == l ) {
-                    int hki = SymmetryPair(symmetry[k],symmetry[i]);
-                    int nm = ibas_aa_sym[hki][n][m];
-                    int ki = ibas_aa_sym[hki][k][i];
+                    int hki = sym.pair(sym.irrep(k),sym.irrep(i));
+                    int nm = ibas_aa(n,m);
+                    int ki = ibas_aa(k,i);
                     dum -= u_p[d2aaoff[hki] + nm*gems_aa[hki] + ki];  // -D2(nm,ki) dlj
                 }
 
                 if ( l == i ) {
-                    int hkj = SymmetryPair(symmetry[k],symmetry[j]);
-                    int nm = ibas_aa_sym[hkj][n][m];
-                    int kj = ibas_aa_sym[hkj][k][j];
+                    int hkj = sym.pair(sym.irrep(k),sym.irrep(j));
+                    int nm = ibas_aa(n,m);
+                    int kj = ibas_aa(k,j);
                     dum += u_p[d2aaoff[hkj] + nm*gems_aa[hkj] + kj];  // D2(nm,kj) dli
                 }
 
                 if ( k == m ) {
                     if ( j == l ) {
-                        int h2 = symmetry[n];
-                        int nn = n - pitzer_offset[h2];
-                        int ii = i - pitzer_offset[h2];
-                        dum -= u_p[d1aoff[h2] + nn*amopi_[h2]+ii]; // - D1(n,i) djl dkm
+                        int h2 = sym.irrep(n);
+                        int nn = n - sym.offset(h2);
+                        int ii = i - sym.offset(h2);
+                        dum -= u_p[d1aoff[h2] + nn*sym.size(h2)+ii]; // - D1(n,i) djl dkm
                     }
-                    int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int jl = ibas_ab_sym[hni][j][l];
+                    int hni = sym.pair(sym.irrep(n),sym.irrep(i));
+                    int ni = ibas_ab(n,i);
+                    int jl = ibas_ab(j,l);
                     dum += u_p[g2aaoff[hni] + ni*2*gems_ab[hni] + jl];  // G2(ni,jl) dkm
                     
                 }
 
                 if ( j == m ) {
                     if ( k == l ) {
-                        int h2 = symmetry[n];
-                        int nn = n - pitzer_offset[h2];
-                        int ii = i - pitzer_offset[h2];
-                        dum += u_p[d1aoff[h2] + nn*amopi_[h2]+ii]; // D1(n,i) dkl djm
+                        int h2 = sym.irrep(n);
+                        int nn = n - sym.offset(h2);
+                        int ii = i - sym.offset(h2);
+                        dum += u_p[d1aoff[h2] + nn*sym.size(h2)+ii]; // D1(n,i) dkl djm
                     }
-                    int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int kl = ibas_ab_sym[hni][k][l];
+                    int hni = sym.pair(sym.irrep(n),sym.irrep(i));
+                    int ni = ibas_ab(n,i);
+                    int kl = ibas_ab(k,l);
                     dum -= u_p[g2aaoff[hni] + ni*2*gems_ab[hni] + kl];  // -G2(ni,kl) djm
                     
                 }
 
                 if ( i == m ) {
                     if ( k == l ) {
-                        int h2 = symmetry[n];
-                        int nn = n - pitzer_offset[h2];
-                        int jj = j - pitzer_offset[h2];
-                        dum -= u_p[d1aoff[h2] + nn*amopi_[h2]+jj]; // - D1(n,j) dkl dim
+                        int h2 = sym.irrep(n);
+                        int nn = n - sym.offset(h2);
+                        int jj = j - sym.offset(h2);
+                        dum -= u_p[d1aoff[h2] + nn*sym.size(h2)+jj]; // - D1(n,j) dkl dim
                     }
-                    int hkl = SymmetryPair(symmetry[k],symmetry[l]);
-                    int nj = ibas_ab_sym[hkl][n][j];
-                    int kl = ibas_ab_sym[hkl][k][l];
+                    int hkl = sym.pair(sym.irrep(k),sym.irrep(l));
+                    int nj = ibas_ab(n,j);
+                    int kl = ibas_ab(k,l);
                     dum += u_p[g2aaoff[hkl] + nj*2*gems_ab[hkl] + kl];  // G2(nj,kl) dim
                     
                 }
 
 
-                A_p[offset + ijk*trip_aaa[h]+lmn] = dum;
+                A_p[myoffset + ijk*trip_aaa[h]+lmn] = dum;
 
 
             }
@@ -685,9 +694,10 @@ void v2RDMSolver::T1_constraints_Au(SharedVector A,SharedVector u){
 
     }
     // T1bbb
-    for (int h = 0; h < nirrep_; h++) {
+    for (int h = 0; h < sym.nirrep(); h++) {
 
-        #pragma omp parallel for schedule (static)
+        long int myoffset = offset;
+        #pragma omp taskloop nogroup
         for (int ijk = 0; ijk < trip_aaa[h]; ijk++) {
 
             int i = bas_aaa_sym[h][ijk][0];
@@ -700,104 +710,104 @@ void v2RDMSolver::T1_constraints_Au(SharedVector A,SharedVector u){
                 int m = bas_aaa_sym[h][lmn][1];
                 int n = bas_aaa_sym[h][lmn][2];
 
-                double dum = -u_p[t1bbboff[h] + ijk*trip_aaa[h]+lmn]; // - T1(ijk,lmn)
+                double dum = skip_t1 ? 0.0 : -u_p[t1bbboff[h] + ijk*trip_aaa[h]+lmn]; // - T1(ijk,lmn)
 
                 if ( k == n ) {
-                    int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
+                    int hij = sym.pair(sym.irrep(i),sym.irrep(j));
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
                     dum += u_p[q2bboff[hij] + ij*gems_aa[hij] + lm];  // Q2(ij,lm) dkn
                 }
 
                 if ( j == n ) {
-                    int hik = SymmetryPair(symmetry[i],symmetry[k]);
-                    int hlm = SymmetryPair(symmetry[l],symmetry[m]);
+                    int hik = sym.pair(sym.irrep(i),sym.irrep(k));
+                    int hlm = sym.pair(sym.irrep(l),sym.irrep(m));
                     if ( hik == hlm ) {
-                        int ik = ibas_aa_sym[hik][i][k];
-                        int lm = ibas_aa_sym[hik][l][m];
+                        int ik = ibas_aa(i,k);
+                        int lm = ibas_aa(l,m);
                         dum -= u_p[q2bboff[hik] + ik*gems_aa[hik] + lm];  // -Q2(ik,lm) djn
                     }
                 }
 
                 if ( i == n ) {
-                    int hjk = SymmetryPair(symmetry[j],symmetry[k]);
-                    int hlm = SymmetryPair(symmetry[l],symmetry[m]);
+                    int hjk = sym.pair(sym.irrep(j),sym.irrep(k));
+                    int hlm = sym.pair(sym.irrep(l),sym.irrep(m));
                     if ( hjk == hlm ) {
-                        int jk = ibas_aa_sym[hjk][j][k];
-                        int lm = ibas_aa_sym[hjk][l][m];
+                        int jk = ibas_aa(j,k);
+                        int lm = ibas_aa(l,m);
                         dum += u_p[q2bboff[hjk] + jk*gems_aa[hjk] + lm];  // Q2(jk,lm) din
                     }
                 }
 
 
                 if ( l == k ) {
-                    int hnm = SymmetryPair(symmetry[n],symmetry[m]);
-                    int hji = SymmetryPair(symmetry[j],symmetry[i]);
+                    int hnm = sym.pair(sym.irrep(n),sym.irrep(m));
+                    int hji = sym.pair(sym.irrep(j),sym.irrep(i));
                     if ( hji == hnm ) {
-                        int nm = ibas_aa_sym[hji][n][m];
-                        int ji = ibas_aa_sym[hji][j][i];
+                        int nm = ibas_aa(n,m);
+                        int ji = ibas_aa(j,i);
                         dum += u_p[d2bboff[hji] + nm*gems_aa[hji] + ji];  // D2(nm,ji) dlk
                     }
                 }
 
                 if ( j == l ) {
-                    int hki = SymmetryPair(symmetry[k],symmetry[i]);
-                    int nm = ibas_aa_sym[hki][n][m];
-                    int ki = ibas_aa_sym[hki][k][i];
+                    int hki = sym.pair(sym.irrep(k),sym.irrep(i));
+                    int nm = ibas_aa(n,m);
+                    int ki = ibas_aa(k,i);
                     dum -= u_p[d2bboff[hki] + nm*gems_aa[hki] + ki];  // -D2(nm,ki) dlj
                 }
 
                 if ( l == i ) {
-                    int hkj = SymmetryPair(symmetry[k],symmetry[j]);
-                    int nm = ibas_aa_sym[hkj][n][m];
-                    int kj = ibas_aa_sym[hkj][k][j];
+                    int hkj = sym.pair(sym.irrep(k),sym.irrep(j));
+                    int nm = ibas_aa(n,m);
+                    int kj = ibas_aa(k,j);
                     dum += u_p[d2bboff[hkj] + nm*gems_aa[hkj] + kj];  // D2(nm,kj) dli
                 }
 
                 if ( k == m ) {
                     if ( j == l ) {
-                        int h2 = symmetry[n];
-                        int nn = n - pitzer_offset[h2];
-                        int ii = i - pitzer_offset[h2];
-                        dum -= u_p[d1boff[h2] + nn*amopi_[h2]+ii]; // - D1(n,i) djl dkm
+                        int h2 = sym.irrep(n);
+                        int nn = n - sym.offset(h2);
+                        int ii = i - sym.offset(h2);
+                        dum -= u_p[d1boff[h2] + nn*sym.size(h2)+ii]; // - D1(n,i) djl dkm
                     }
-                    int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int jl = ibas_ab_sym[hni][j][l];
+                    int hni = sym.pair(sym.irrep(n),sym.irrep(i));
+                    int ni = ibas_ab(n,i);
+                    int jl = ibas_ab(j,l);
                     dum += u_p[g2aaoff[hni] + (ni+gems_ab[hni])*2*gems_ab[hni] + (jl+gems_ab[hni])];  // G2(ni,jl) dkm
                     
                 }
 
                 if ( j == m ) {
                     if ( k == l ) {
-                        int h2 = symmetry[n];
-                        int nn = n - pitzer_offset[h2];
-                        int ii = i - pitzer_offset[h2];
-                        dum += u_p[d1boff[h2] + nn*amopi_[h2]+ii]; // D1(n,i) dkl djm
+                        int h2 = sym.irrep(n);
+                        int nn = n - sym.offset(h2);
+                        int ii = i - sym.offset(h2);
+                        dum += u_p[d1boff[h2] + nn*sym.size(h2)+ii]; // D1(n,i) dkl djm
                     }
-                    int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int kl = ibas_ab_sym[hni][k][l];
+                    int hni = sym.pair(sym.irrep(n),sym.irrep(i));
+                    int ni = ibas_ab(n,i);
+                    int kl = ibas_ab(k,l);
                     dum -= u_p[g2aaoff[hni] + (ni+gems_ab[hni])*2*gems_ab[hni] + (kl+gems_ab[hni])];  // -G2(ni,kl) djm
                     
                 }
 
                 if ( i == m ) {
                     if ( k == l ) {
-                        int h2 = symmetry[n];
-                        int nn = n - pitzer_offset[h2];
-                        int jj = j - pitzer_offset[h2];
-                        dum -= u_p[d1boff[h2] + nn*amopi_[h2]+jj]; // - D1(n,j) dkl dim
+                        int h2 = sym.irrep(n);
+                        int nn = n - sym.offset(h2);
+                        int jj = j - sym.offset(h2);
+                        dum -= u_p[d1boff[h2] + nn*sym.size(h2)+jj]; // - D1(n,j) dkl dim
                     }
-                    int hkl = SymmetryPair(symmetry[k],symmetry[l]);
-                    int nj = ibas_ab_sym[hkl][n][j];
-                    int kl = ibas_ab_sym[hkl][k][l];
+                    int hkl = sym.pair(sym.irrep(k),sym.irrep(l));
+                    int nj = ibas_ab(n,j);
+                    int kl = ibas_ab(k,l);
                     dum += u_p[g2aaoff[hkl] + (nj+gems_ab[hkl])*2*gems_ab[hkl] + (kl+gems_ab[hkl])];  // G2(nj,kl) dim
                     
                 }
 
 
-                A_p[offset + ijk*trip_aaa[h]+lmn] = dum;
+                A_p[myoffset + ijk*trip_aaa[h]+lmn] = dum;
 
 
             }
@@ -808,17 +818,120 @@ void v2RDMSolver::T1_constraints_Au(SharedVector A,SharedVector u){
 
 }
 
+void v2RDMSolver::T1_constraints_Au(SharedVector A,SharedVector u){
+    (this->*T1_constraints_Au_fn_)(A,u,SkippedBlocks());
+}
+
+void v2RDMSolver::T1_constraints_Au(SharedVector A,SharedVector u,const SkippedBlocks & skip){
+    (this->*T1_constraints_Au_fn_)(A,u,skip);
+}
+
+// T1 portion of diag(A.A^T).  every coefficient in the T1 rows is +/- 1, so
+// each diagonal element is the number of terms that survive the delta
+// functions in T1_constraints_Au_kernel (the aab and bba blocks, and the aaa
+// and bbb blocks, have the same structure).
+void v2RDMSolver::T1_constraints_AAT_diagonal(double * d){
+
+    PointGroupSymmetry sym(nirrep_,symmetry,pitzer_offset,amopi_,table);
+
+    // T1aab, T1bba
+    for (int spin = 0; spin < 2; spin++) {
+        for (int h = 0; h < sym.nirrep(); h++) {
+
+            long int myoffset = offset;
+            #pragma omp parallel for schedule (static)
+            for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
+
+                int i = bas_aab_sym[h][ijk][0];
+                int j = bas_aab_sym[h][ijk][1];
+                int k = bas_aab_sym[h][ijk][2];
+
+                for (int lmn = 0; lmn < trip_aab[h]; lmn++) {
+
+                    int l = bas_aab_sym[h][lmn][0];
+                    int m = bas_aab_sym[h][lmn][1];
+                    int n = bas_aab_sym[h][lmn][2];
+
+                    double dum = 1.0; // - T1(ijk,lmn)
+                    if ( k == n ) dum += 1.0;
+                    if ( j == l ) dum += 1.0;
+                    if ( l == i ) dum += 1.0;
+                    if ( j == m ) dum += 1.0;
+                    if ( i == m ) dum += 1.0;
+
+                    d[myoffset + ijk*trip_aab[h]+lmn] = dum;
+                }
+            }
+            offset += trip_aab[h]*trip_aab[h];
+        }
+    }
+
+    // T1aaa, T1bbb
+    for (int spin = 0; spin < 2; spin++) {
+        for (int h = 0; h < sym.nirrep(); h++) {
+
+            long int myoffset = offset;
+            #pragma omp parallel for schedule (static)
+            for (int ijk = 0; ijk < trip_aaa[h]; ijk++) {
+
+                int i = bas_aaa_sym[h][ijk][0];
+                int j = bas_aaa_sym[h][ijk][1];
+                int k = bas_aaa_sym[h][ijk][2];
+
+                for (int lmn = 0; lmn < trip_aaa[h]; lmn++) {
+
+                    int l = bas_aaa_sym[h][lmn][0];
+                    int m = bas_aaa_sym[h][lmn][1];
+                    int n = bas_aaa_sym[h][lmn][2];
+
+                    int hik = sym.pair(sym.irrep(i),sym.irrep(k));
+                    int hjk = sym.pair(sym.irrep(j),sym.irrep(k));
+                    int hji = sym.pair(sym.irrep(j),sym.irrep(i));
+                    int hlm = sym.pair(sym.irrep(l),sym.irrep(m));
+                    int hnm = sym.pair(sym.irrep(n),sym.irrep(m));
+
+                    double dum = 1.0; // - T1(ijk,lmn)
+                    if ( k == n ) dum += 1.0;
+                    if ( j == n && hik == hlm ) dum += 1.0;
+                    if ( i == n && hjk == hlm ) dum += 1.0;
+                    if ( l == k && hji == hnm ) dum += 1.0;
+                    if ( j == l ) dum += 1.0;
+                    if ( l == i ) dum += 1.0;
+                    if ( k == m ) dum += ( j == l ) ? 2.0 : 1.0;
+                    if ( j == m ) dum += ( k == l ) ? 2.0 : 1.0;
+                    if ( i == m ) dum += ( k == l ) ? 2.0 : 1.0;
+
+                    d[myoffset + ijk*trip_aaa[h]+lmn] = dum;
+                }
+            }
+            offset += trip_aaa[h]*trip_aaa[h];
+        }
+    }
+}
+
 // T1 portion of A^T.y 
-void v2RDMSolver::T1_constraints_ATu(SharedVector A,SharedVector u){
+template <class Symmetry>
+void v2RDMSolver::T1_constraints_ATu_kernel(SharedVector A,SharedVector u,const SkippedBlocks & skip){
+
+    Symmetry sym(nirrep_,symmetry,pitzer_offset,amopi_,table);
+    bool skip_t1 = skip.t1;
 
     double * A_p = A->pointer();
     double * u_p = u->pointer();
 
+    // each row maps to a unique T1 element, so those contributions are
+    // written directly to A_p.  contributions to the D2, D1, Q2, and G2
+    // blocks are accumulated in per-thread buffers and reduced at the end.
+    ZeroATuBuffers();
+
     // T1aab
-    for (int h = 0; h < nirrep_; h++) {
+    for (int h = 0; h < sym.nirrep(); h++) {
 
+        #pragma omp parallel for schedule (static) num_threads(ATu_nthreads_)
         for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
 
+            double * myA_p = ATu_buffer_ + omp_get_thread_num() * dimx_d2q2g2_;
+
             int i = bas_aab_sym[h][ijk][0];
             int j = bas_aab_sym[h][ijk][1];
             int k = bas_aab_sym[h][ijk][2];
@@ -831,42 +944,42 @@ void v2RDMSolver::T1_constraints_ATu(SharedVector A,SharedVector u){
 
                 double dum = u_p[offset + ijk*trip_aab[h]+lmn]; 
 
-                A_p[t1aaboff[h] + ijk*trip_aab[h]+lmn] -= dum; // - T1(ijk,lmn)
+                if ( !skip_t1 ) A_p[t1aaboff[h] + ijk*trip_aab[h]+lmn] -= dum; // - T1(ijk,lmn)
 
                 if ( k == n ) {
-                    int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
-                    A_p[q2aaoff[hij] + ij*gems_aa[hij] + lm] += dum;  // Q2(ij,lm) dkn
+                    int hij = sym.pair(sym.irrep(i),sym.irrep(j));
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
+                    myA_p[q2aaoff[hij] + ij*gems_aa[hij] + lm] += dum;  // Q2(ij,lm) dkn
                 }
 
                 if ( j == l ) {
-                    int hki = SymmetryPair(symmetry[k],symmetry[i]);
-                    int nm = ibas_ab_sym[hki][m][n];
-                    int ki = ibas_ab_sym[hki][i][k];
-                    A_p[d2aboff[hki] + nm*gems_ab[hki] + ki] -= dum;  // -D2(nm,ki) dlj
+                    int hki = sym.pair(sym.irrep(k),sym.irrep(i));
+                    int nm = ibas_ab(m,n);
+                    int ki = ibas_ab(i,k);
+                    myA_p[d2aboff[hki] + nm*gems_ab[hki] + ki] -= dum;  // -D2(nm,ki) dlj
                 }
 
                 if ( l == i ) {
-                    int hkj = SymmetryPair(symmetry[k],symmetry[j]);
-                    int nm = ibas_ab_sym[hkj][m][n];
-                    int kj = ibas_ab_sym[hkj][j][k];
-                    A_p[d2aboff[hkj] + nm*gems_ab[hkj] + kj] += dum;  // D2(nm,kj) dli
+                    int hkj = sym.pair(sym.irrep(k),sym.irrep(j));
+                    int nm = ibas_ab(m,n);
+                    int kj = ibas_ab(j,k);
+                    myA_p[d2aboff[hkj] + nm*gems_ab[hkj] + kj] += dum;  // D2(nm,kj) dli
                 }
 
                 if ( j == m ) {
-                    int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int kl = ibas_ab_sym[hni][k][l];
-                    A_p[g2baoff[hni] + ni*gems_ab[hni] + kl] -= dum;  // -G2(ni,kl) djm
+                    int hni = sym.pair(sym.irrep(n),sym.irrep(i));
+                    int ni = ibas_ab(n,i);
+                    int kl = ibas_ab(k,l);
+                    myA_p[g2baoff[hni] + ni*gems_ab[hni] + kl] -= dum;  // -G2(ni,kl) djm
                     
                 }
 
                 if ( i == m ) {
-                    int hkl = SymmetryPair(symmetry[k],symmetry[l]);
-                    int nj = ibas_ab_sym[hkl][n][j];
-                    int kl = ibas_ab_sym[hkl][k][l];
-                    A_p[g2baoff[hkl] + nj*gems_ab[hkl] + kl] += dum;  // G2(nj,kl) dim
+                    int hkl = sym.pair(sym.irrep(k),sym.irrep(l));
+                    int nj = ibas_ab(n,j);
+                    int kl = ibas_ab(k,l);
+                    myA_p[g2baoff[hkl] + nj*gems_ab[hkl] + kl] += dum;  // G2(nj,kl) dim
                     
                 }
             }
@@ -875,10 +988,13 @@ void v2RDMSolver::T1_constraints_ATu(SharedVector A,SharedVector u){
 
     }
     // T1bba
-    for (int h = 0; h < nirrep_; h++) {
+    for (int h = 0; h < sym.nirrep(); h++) {
 
+        #pragma omp parallel for schedule (static) num_threads(ATu_nthreads_)
         for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
 
+            double * myA_p = ATu_buffer_ + omp_get_thread_num() * dimx_d2q2g2_;
+
             int i = bas_aab_sym[h][ijk][0];
             int j = bas_aab_sym[h][ijk][1];
             int k = bas_aab_sym[h][ijk][2];
@@ -891,42 +1007,42 @@ void v2RDMSolver::T1_constraints_ATu(SharedVector A,SharedVector u){
 
                 double dum = u_p[offset + ijk*trip_aab[h]+lmn]; 
 
-                A_p[t1bbaoff[h] + ijk*trip_aab[h]+lmn] -= dum; // - T1(ijk,lmn)
+                if ( !skip_t1 ) A_p[t1bbaoff[h] + ijk*trip_aab[h]+lmn] -= dum; // - T1(ijk,lmn)
 
                 if ( k == n ) {
-                    int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
-                    A_p[q2bboff[hij] + ij*gems_aa[hij] + lm] += dum;  // Q2(ij,lm) dkn
+                    int hij = sym.pair(sym.irrep(i),sym.irrep(j));
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
+                    myA_p[q2bboff[hij] + ij*gems_aa[hij] + lm] += dum;  // Q2(ij,lm) dkn
                 }
 
                 if ( j == l ) {
-                    int hki = SymmetryPair(symmetry[k],symmetry[i]);
-                    int nm = ibas_ab_sym[hki][n][m];
-                    int ki = ibas_ab_sym[hki][k][i];
-                    A_p[d2aboff[hki] + nm*gems_ab[hki] + ki] -= dum;  // -D2(nm,ki) dlj
+                    int hki = sym.pair(sym.irrep(k),sym.irrep(i));
+                    int nm = ibas_ab(n,m);
+                    int ki = ibas_ab(k,i);
+                    myA_p[d2aboff[hki] + nm*gems_ab[hki] + ki] -= dum;  // -D2(nm,ki) dlj
                 }
 
                 if ( l == i ) {
-                    int hkj = SymmetryPair(symmetry[k],symmetry[j]);
-                    int nm = ibas_ab_sym[hkj][n][m];
-                    int kj = ibas_ab_sym[hkj][k][j];
-                    A_p[d2aboff[hkj] + nm*gems_ab[hkj] + kj] += dum;  // D2(nm,kj) dli
+                    int hkj = sym.pair(sym.irrep(k),sym.irrep(j));
+                    int nm = ibas_ab(n,m);
+                    int kj = ibas_ab(k,j);
+                    myA_p[d2aboff[hkj] + nm*gems_ab[hkj] + kj] += dum;  // D2(nm,kj) dli
                 }
 
                 if ( j == m ) {
-                    int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int kl = ibas_ab_sym[hni][k][l];
-                    A_p[g2aboff[hni] + ni*gems_ab[hni] + kl] -= dum;  // -G2(ni,kl) djm
+                    int hni = sym.pair(sym.irrep(n),sym.irrep(i));
+                    int ni = ibas_ab(n,i);
+                    int kl = ibas_ab(k,l);
+                    myA_p[g2aboff[hni] + ni*gems_ab[hni] + kl] -= dum;  // -G2(ni,kl) djm
                     
                 }
 
                 if ( i == m ) {
-                    int hkl = SymmetryPair(symmetry[k],symmetry[l]);
-                    int nj = ibas_ab_sym[hkl][n][j];
-                    int kl = ibas_ab_sym[hkl][k][l];
-                    A_p[g2aboff[hkl] + nj*gems_ab[hkl] + kl] += dum;  // G2(nj,kl) dim
+                    int hkl = sym.pair(sym.irrep(k),sym.irrep(l));
+                    int nj = ibas_ab(n,j);
+                    int kl = ibas_ab(k,l);
+                    myA_p[g2aboff[hkl] + nj*gems_ab[hkl] + kl] += dum;  // G2(nj,kl) dim
                     
                 }
             }
@@ -935,10 +1051,13 @@ void v2RDMSolver::T1_constraints_ATu(SharedVector A,SharedVector u){
 
     }
     // T1aaa
-    for (int h = 0; h < nirrep_; h++) {
+    for (int h = 0; h < sym.nirrep(); h++) {
 
+        #pragma omp parallel for schedule (static) num_threads(ATu_nthreads_)
         for (int ijk = 0; ijk < trip_aaa[h]; ijk++) {
 
+            double * myA_p = ATu_buffer_ + omp_get_thread_num() * dimx_d2q2g2_;
+
             int i = bas_aaa_sym[h][ijk][0];
             int j = bas_aaa_sym[h][ijk][1];
             int k = bas_aaa_sym[h][ijk][2];
@@ -951,99 +1070,99 @@ void v2RDMSolver::T1_constraints_ATu(SharedVector A,SharedVector u){
 
                 double dum = u_p[offset + ijk*trip_aaa[h] + lmn];
 
-                A_p[t1aaaoff[h] + ijk*trip_aaa[h]+lmn] -= dum; // - T1(ijk,lmn)
+                if ( !skip_t1 ) A_p[t1aaaoff[h] + ijk*trip_aaa[h]+lmn] -= dum; // - T1(ijk,lmn)
 
                 if ( k == n ) {
-                    int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
-                    A_p[q2aaoff[hij] + ij*gems_aa[hij] + lm] += dum;  // Q2(ij,lm) dkn
+                    int hij = sym.pair(sym.irrep(i),sym.irrep(j));
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
+                    myA_p[q2aaoff[hij] + ij*gems_aa[hij] + lm] += dum;  // Q2(ij,lm) dkn
                 }
 
                 if ( j == n ) {
-                    int hik = SymmetryPair(symmetry[i],symmetry[k]);
-                    int hlm = SymmetryPair(symmetry[l],symmetry[m]);
+                    int hik = sym.pair(sym.irrep(i),sym.irrep(k));
+                    int hlm = sym.pair(sym.irrep(l),sym.irrep(m));
                     if ( hik == hlm ) {
-                        int ik = ibas_aa_sym[hik][i][k];
-                        int lm = ibas_aa_sym[hik][l][m];
-                        A_p[q2aaoff[hik] + ik*gems_aa[hik] + lm] -= dum;  // -Q2(ik,lm) djn
+                        int ik = ibas_aa(i,k);
+                        int lm = ibas_aa(l,m);
+                        myA_p[q2aaoff[hik] + ik*gems_aa[hik] + lm] -= dum;  // -Q2(ik,lm) djn
                     }
                 }
 
                 if ( i == n ) {
-                    int hjk = SymmetryPair(symmetry[j],symmetry[k]);
-                    int hlm = SymmetryPair(symmetry[l],symmetry[m]);
+                    int hjk = sym.pair(sym.irrep(j),sym.irrep(k));
+                    int hlm = sym.pair(sym.irrep(l),sym.irrep(m));
                     if ( hjk == hlm ) {
-                        int jk = ibas_aa_sym[hjk][j][k];
-                        int lm = ibas_aa_sym[hjk][l][m];
-                        A_p[q2aaoff[hjk] + jk*gems_aa[hjk] + lm] += dum;  // Q2(jk,lm) din
+                        int jk = ibas_aa(j,k);
+                        int lm = ibas_aa(l,m);
+                        myA_p[q2aaoff[hjk] + jk*gems_aa[hjk] + lm] += dum;  // Q2(jk,lm) din
                     }
                 }
 
 
                 if ( l == k ) {
-                    int hji = SymmetryPair(symmetry[j],symmetry[i]);
-                    int hnm = SymmetryPair(symmetry[n],symmetry[m]);
+                    int hji = sym.pair(sym.irrep(j),sym.irrep(i));
+                    int hnm = sym.pair(sym.irrep(n),sym.irrep(m));
                     if ( hji == hnm ) {
-                        int ji = ibas_aa_sym[hji][j][i];
-                        int nm = ibas_aa_sym[hji][n][m];
-                        A_p[d2aaoff[hji] + nm*gems_aa[hji] + ji] += dum;  // D2(nm,ji) dlk
+                        int ji = ibas_aa(j,i);
+                        int nm = ibas_aa(n,m);
+                        myA_p[d2aaoff[hji] + nm*gems_aa[hji] + ji] += dum;  // D2(nm,ji) dlk
                     }
                 }
 
                 if ( j == l ) {
-                    int hki = SymmetryPair(symmetry[k],symmetry[i]);
-                    int ki = ibas_aa_sym[hki][k][i];
-                    int nm = ibas_aa_sym[hki][n][m];
-                    A_p[d2aaoff[hki] + nm*gems_aa[hki] + ki] -= dum;  // -D2(nm,ki) dlj
+                    int hki = sym.pair(sym.irrep(k),sym.irrep(i));
+                    int ki = ibas_aa(k,i);
+                    int nm = ibas_aa(n,m);
+                    myA_p[d2aaoff[hki] + nm*gems_aa[hki] + ki] -= dum;  // -D2(nm,ki) dlj
                 }
 
                 if ( l == i ) {
-                    int hkj = SymmetryPair(symmetry[k],symmetry[j]);
-                    int kj = ibas_aa_sym[hkj][k][j];
-                    int nm = ibas_aa_sym[hkj][n][m];
-                    A_p[d2aaoff[hkj] + nm*gems_aa[hkj] + kj] += dum;  // D2(nm,kj) dli
+                    int hkj = sym.pair(sym.irrep(k),sym.irrep(j));
+                    int kj = ibas_aa(k,j);
+                    int nm = ibas_aa(n,m);
+                    myA_p[d2aaoff[hkj] + nm*gems_aa[hkj] + kj] += dum;  // D2(nm,kj) dli
                 }
 
                 if ( k == m ) {
                     if ( j == l ) {
-                        int h2 = symmetry[n];
-                        int nn = n - pitzer_offset[h2];
-                        int ii = i - pitzer_offset[h2];
-                        A_p[d1aoff[h2] + nn*amopi_[h2]+ii] -= dum; // - D1(n,i) djl dkm
+                        int h2 = sym.irrep(n);
+                        int nn = n - sym.offset(h2);
+                        int ii = i - sym.offset(h2);
+                        myA_p[d1aoff[h2] + nn*sym.size(h2)+ii] -= dum; // - D1(n,i) djl dkm
                     }
-                    int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int jl = ibas_ab_sym[hni][j][l];
-                    A_p[g2aaoff[hni] + ni*2*gems_ab[hni] + jl] += dum;  // G2(ni,jl) dkm
+                    int hni = sym.pair(sym.irrep(n),sym.irrep(i));
+                    int ni = ibas_ab(n,i);
+                    int jl = ibas_ab(j,l);
+                    myA_p[g2aaoff[hni] + ni*2*gems_ab[hni] + jl] += dum;  // G2(ni,jl) dkm
                     
                 }
 
                 if ( j == m ) {
                     if ( k == l ) {
-                        int h2 = symmetry[n];
-                        int nn = n - pitzer_offset[h2];
-                        int ii = i - pitzer_offset[h2];
-                        A_p[d1aoff[h2] + nn*amopi_[h2]+ii] += dum; // D1(n,i) dkl djm
+                        int h2 = sym.irrep(n);
+                        int nn = n - sym.offset(h2);
+                        int ii = i - sym.offset(h2);
+                        myA_p[d1aoff[h2] + nn*sym.size(h2)+ii] += dum; // D1(n,i) dkl djm
                     }
-                    int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int kl = ibas_ab_sym[hni][k][l];
-                    A_p[g2aaoff[hni] + ni*2*gems_ab[hni] + kl] -= dum;  // -G2(ni,kl) djm
+                    int hni = sym.pair(sym.irrep(n),sym.irrep(i));
+                    int ni = ibas_ab(n,i);
+                    int kl = ibas_ab(k,l);
+                    myA_p[g2aaoff[hni] + ni*2*gems_ab[hni] + kl] -= dum;  // -G2(ni,kl) djm
                     
                 }
 
                 if ( i == m ) {
                     if ( k == l ) {
-                        int h2 = symmetry[n];
-                        int nn = n - pitzer_offset[h2];
-                        int jj = j - pitzer_offset[h2];
-                        A_p[d1aoff[h2] + nn*amopi_[h2]+jj] -= dum; // - D1(n,j) dkl dim
+                        int h2 = sym.irrep(n);
+                        int nn = n - sym.offset(h2);
+                        int jj = j - sym.offset(h2);
+                        myA_p[d1aoff[h2] + nn*sym.size(h2)+jj] -= dum; // - D1(n,j) dkl dim
                     }
-                    int hkl = SymmetryPair(symmetry[k],symmetry[l]);
-                    int nj = ibas_ab_sym[hkl][n][j];
-                    int kl = ibas_ab_sym[hkl][k][l];
-                    A_p[g2aaoff[hkl] + nj*2*gems_ab[hkl] + kl] += dum;  // G2(nj,kl) dim
+                    int hkl = sym.pair(sym.irrep(k),sym.irrep(l));
+                    int nj = ibas_ab(n,j);
+                    int kl = ibas_ab(k,l);
+                    myA_p[g2aaoff[hkl] + nj*2*gems_ab[hkl] + kl] += dum;  // G2(nj,kl) dim
                     
                 }
 
@@ -1053,10 +1172,13 @@ void v2RDMSolver::T1_constraints_ATu(SharedVector A,SharedVector u){
 
     }
     // T1bbb
-    for (int h = 0; h < nirrep_; h++) {
+    for (int h = 0; h < sym.nirrep(); h++) {
 
+        #pragma omp parallel for schedule (static) num_threads(ATu_nthreads_)
         for (int ijk = 0; ijk < trip_aaa[h]; ijk++) {
 
+            double * myA_p = ATu_buffer_ + omp_get_thread_num() * dimx_d2q2g2_;
+
             int i = bas_aaa_sym[h][ijk][0];
             int j = bas_aaa_sym[h][ijk][1];
             int k = bas_aaa_sym[h][ijk][2];
@@ -1069,99 +1191,99 @@ void v2RDMSolver::T1_constraints_ATu(SharedVector A,SharedVector u){
 
                 double dum = u_p[offset + ijk*trip_aaa[h] + lmn];
 
-                A_p[t1bbboff[h] + ijk*trip_aaa[h]+lmn] -= dum; // - T1(ijk,lmn)
+                if ( !skip_t1 ) A_p[t1bbboff[h] + ijk*trip_aaa[h]+lmn] -= dum; // - T1(ijk,lmn)
 
                 if ( k == n ) {
-                    int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
-                    A_p[q2bboff[hij] + ij*gems_aa[hij] + lm] += dum;  // Q2(ij,lm) dkn
+                    int hij = sym.pair(sym.irrep(i),sym.irrep(j));
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
+                    myA_p[q2bboff[hij] + ij*gems_aa[hij] + lm] += dum;  // Q2(ij,lm) dkn
                 }
 
                 if ( j == n ) {
-                    int hik = SymmetryPair(symmetry[i],symmetry[k]);
-                    int hlm = SymmetryPair(symmetry[l],symmetry[m]);
+                    int hik = sym.pair(sym.irrep(i),sym.irrep(k));
+                    int hlm = sym.pair(sym.irrep(l),sym.irrep(m));
                     if ( hik == hlm ) {
-                        int ik = ibas_aa_sym[hik][i][k];
-                        int lm = ibas_aa_sym[hik][l][m];
-                        A_p[q2bboff[hik] + ik*gems_aa[hik] + lm] -= dum;  // -Q2(ik,lm) djn
+                        int ik = ibas_aa(i,k);
+                        int lm = ibas_aa(l,m);
+                        myA_p[q2bboff[hik] + ik*gems_aa[hik] + lm] -= dum;  // -Q2(ik,lm) djn
                     }
                 }
 
                 if ( i == n ) {
-                    int hjk = SymmetryPair(symmetry[j],symmetry[k]);
-                    int hlm = SymmetryPair(symmetry[l],symmetry[m]);
+                    int hjk = sym.pair(sym.irrep(j),sym.irrep(k));
+                    int hlm = sym.pair(sym.irrep(l),sym.irrep(m));
                     if ( hjk == hlm ) {
-                        int jk = ibas_aa_sym[hjk][j][k];
-                        int lm = ibas_aa_sym[hjk][l][m];
-                        A_p[q2bboff[hjk] + jk*gems_aa[hjk] + lm] += dum;  // Q2(jk,lm) din
+                        int jk = ibas_aa(j,k);
+                        int lm = ibas_aa(l,m);
+                        myA_p[q2bboff[hjk] + jk*gems_aa[hjk] + lm] += dum;  // Q2(jk,lm) din
                     }
                 }
 
 
                 if ( l == k ) {
-                    int hji = SymmetryPair(symmetry[j],symmetry[i]);
-                    int hnm = SymmetryPair(symmetry[n],symmetry[m]);
+                    int hji = sym.pair(sym.irrep(j),sym.irrep(i));
+                    int hnm = sym.pair(sym.irrep(n),sym.irrep(m));
                     if ( hji == hnm ) {
-                        int ji = ibas_aa_sym[hji][j][i];
-                        int nm = ibas_aa_sym[hji][n][m];
-                        A_p[d2bboff[hji] + nm*gems_aa[hji] + ji] += dum;  // D2(nm,ji) dlk
+                        int ji = ibas_aa(j,i);
+                        int nm = ibas_aa(n,m);
+                        myA_p[d2bboff[hji] + nm*gems_aa[hji] + ji] += dum;  // D2(nm,ji) dlk
                     }
                 }
 
                 if ( j == l ) {
-                    int hki = SymmetryPair(symmetry[k],symmetry[i]);
-                    int ki = ibas_aa_sym[hki][k][i];
-                    int nm = ibas_aa_sym[hki][n][m];
-                    A_p[d2bboff[hki] + nm*gems_aa[hki] + ki] -= dum;  // -D2(nm,ki) dlj
+                    int hki = sym.pair(sym.irrep(k),sym.irrep(i));
+                    int ki = ibas_aa(k,i);
+                    int nm = ibas_aa(n,m);
+                    myA_p[d2bboff[hki] + nm*gems_aa[hki] + ki] -= dum;  // -D2(nm,ki) dlj
                 }
 
                 if ( l == i ) {
-                    int hkj = SymmetryPair(symmetry[k],symmetry[j]);
-                    int kj = ibas_aa_sym[hkj][k][j];
-                    int nm = ibas_aa_sym[hkj][n][m];
-                    A_p[d2bboff[hkj] + nm*gems_aa[hkj] + kj] += dum;  // D2(nm,kj) dli
+                    int hkj = sym.pair(sym.irrep(k),sym.irrep(j));
+                    int kj = ibas_aa(k,j);
+                    int nm = ibas_aa(n,m);
+                    myA_p[d2bboff[hkj] + nm*gems_aa[hkj] + kj] += dum;  // D2(nm,kj) dli
                 }
 
                 if ( k == m ) {
                     if ( j == l ) {
-                        int h2 = symmetry[n];
-                        int nn = n - pitzer_offset[h2];
-                        int ii = i - pitzer_offset[h2];
-                        A_p[d1boff[h2] + nn*amopi_[h2]+ii] -= dum; // - D1(n,i) djl dkm
+                        int h2 = sym.irrep(n);
+                        int nn = n - sym.offset(h2);
+                        int ii = i - sym.offset(h2);
+                        myA_p[d1boff[h2] + nn*sym.size(h2)+ii] -= dum; // - D1(n,i) djl dkm
                     }
-                    int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int jl = ibas_ab_sym[hni][j][l];
-                    A_p[g2aaoff[hni] + (ni+gems_ab[hni])*2*gems_ab[hni] + (jl+gems_ab[hni])] += dum;  // G2(ni,jl) dkm
+                    int hni = sym.pair(sym.irrep(n),sym.irrep(i));
+                    int ni = ibas_ab(n,i);
+                    int jl = ibas_ab(j,l);
+                    myA_p[g2aaoff[hni] + (ni+gems_ab[hni])*2*gems_ab[hni] + (jl+gems_ab[hni])] += dum;  // G2(ni,jl) dkm
                     
                 }
 
                 if ( j == m ) {
                     if ( k == l ) {
-                        int h2 = symmetry[n];
-                        int nn = n - pitzer_offset[h2];
-                        int ii = i - pitzer_offset[h2];
-                        A_p[d1boff[h2] + nn*amopi_[h2]+ii] += dum; // D1(n,i) dkl djm
+                        int h2 = sym.irrep(n);
+                        int nn = n - sym.offset(h2);
+                        int ii = i - sym.offset(h2);
+                        myA_p[d1boff[h2] + nn*sym.size(h2)+ii] += dum; // D1(n,i) dkl djm
                     }
-                    int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int kl = ibas_ab_sym[hni][k][l];
-                    A_p[g2aaoff[hni] + (ni+gems_ab[hni])*2*gems_ab[hni] + (kl+gems_ab[hni])] -= dum;  // -G2(ni,kl) djm
+                    int hni = sym.pair(sym.irrep(n),sym.irrep(i));
+                    int ni = ibas_ab(n,i);
+                    int kl = ibas_ab(k,l);
+                    myA_p[g2aaoff[hni] + (ni+gems_ab[hni])*2*gems_ab[hni] + (kl+gems_ab[hni])] -= dum;  // -G2(ni,kl) djm
                     
                 }
 
                 if ( i == m ) {
                     if ( k == l ) {
-                        int h2 = symmetry[n];
-                        int nn = n - pitzer_offset[h2];
-                        int jj = j - pitzer_offset[h2];
-                        A_p[d1boff[h2] + nn*amopi_[h2]+jj] -= dum; // - D1(n,j) dkl dim
+                        int h2 = sym.irrep(n);
+                        int nn = n - sym.offset(h2);
+                        int jj = j - sym.offset(h2);
+                        myA_p[d1boff[h2] + nn*sym.size(h2)+jj] -= dum; // - D1(n,j) dkl dim
                     }
-                    int hkl = SymmetryPair(symmetry[k],symmetry[l]);
-                    int nj = ibas_ab_sym[hkl][n][j];
-                    int kl = ibas_ab_sym[hkl][k][l];
-                    A_p[g2aaoff[hkl] + (nj+gems_ab[hkl])*2*gems_ab[hkl] + (kl+gems_ab[hkl])] += dum;  // G2(nj,kl) dim
+                    int hkl = sym.pair(sym.irrep(k),sym.irrep(l));
+                    int nj = ibas_ab(n,j);
+                    int kl = ibas_ab(k,l);
+                    myA_p[g2aaoff[hkl] + (nj+gems_ab[hkl])*2*gems_ab[hkl] + (kl+gems_ab[hkl])] += dum;  // G2(nj,kl) dim
                     
                 }
 
@@ -1170,6 +1292,22 @@ void v2RDMSolver::T1_constraints_ATu(SharedVector A,SharedVector u){
         offset += trip_aaa[h]*trip_aaa[h];
 
     }
+
+    ReduceATuBuffers(A_p);
+}
+
+void v2RDMSolver::T1_constraints_ATu(SharedVector A,SharedVector u){
+    (this->*T1_constraints_ATu_fn_)(A,u,SkippedBlocks());
 }
 
+void v2RDMSolver::T1_constraints_ATu(SharedVector A,SharedVector u,const SkippedBlocks & skip){
+    (this->*T1_constraints_ATu_fn_)(A,u,skip);
+}
+
+// C1 and point-group instantiations (selected in common_init)
+template void v2RDMSolver::T1_constraints_Au_kernel<C1Symmetry>(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+template void v2RDMSolver::T1_constraints_ATu_kernel<C1Symmetry>(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+template void v2RDMSolver::T1_constraints_Au_kernel<PointGroupSymmetry>(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+template void v2RDMSolver::T1_constraints_ATu_kernel<PointGroupSymmetry>(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+
 }} // end namespaces
@@ -40,12 +40,14 @@
 #include<time.h>
 
 #include"v2rdm_solver.h"
+#include"symmetry_policy.h"
 
 #ifdef _OPENMP
     #include<omp.h>
 #else
     #define omp_get_wtime() ( (double)clock() / CLOCKS_PER_SEC )
     #define omp_get_max_threads() 1
+    #define omp_get_thread_num() 0
 #endif
 
 using namespace psi;
@@ -53,1821 +55,534 @@ using namespace psi;
 
 namespace psi{ namespace v2rdm_casscf{
 
-// T2 portion of A.u 
-void v2RDMSolver::T2_constraints_Au(SharedVector A,SharedVector u){
-
-    double * A_p = A->pointer();
-    double * u_p = u->pointer();
-
-    int saveoff = offset;
-
-    // T2aab
-    for (int h = 0; h < nirrep_; h++) {
+// T2 mappings (fast versions)
+//
+// A.u and A^T.u share the same enumeration of nonzero elements of A.  For
+// each row (ijk,lmn) of a T2 block, -T2(ijk,lmn) is handled by a single
+// daxpy over the row, and only those columns lmn that satisfy one of the
+// kronecker deltas in the T2 condition are visited for the D2 and D1
+// terms.  For A.u, the rows are split into tasks that write only to their
+// own rows of A; for A^T.u, the D2 and D1 contributions are accumulated in
+// per-thread buffers.
+
+// the same enumeration also gives the T2 part of the diagonal of A.A^T
+// (the squared norm of each row), which is used by the CG preconditioner.
+// terms that fall on the same element of D2 are counted separately, so a
+// few of these diagonal elements are approximate.  the diagonal only
+// scales the CG equations (CG_PRECONDITIONER, PRESOLVE_CONSTRAINTS), so
+// this affects the rate of convergence, not the solution.
+
+// the enumeration is applied as A.u, A^T.u, or diag(A.A^T)
+enum T2Mapping { T2_AU, T2_ATU, T2_AAT_DIAGONAL };
+
+// A(row) += c * u(col), A(col) += c * u(row), or A(row) += c * c
+static inline void T2Accumulate(double * A_p, double * u_p, long int row, long int col, double c, int mapping) {
+    if ( mapping == T2_ATU ) {
+        A_p[col] += c * u_p[row];
+    }else if ( mapping == T2_AU ) {
+        A_p[row] += c * u_p[col];
+    }else {
+        A_p[row] += c * c;
+    }
+}
 
-        #pragma omp parallel for schedule (static)
-        for (int ij = 0; ij < gems_aa[h]; ij++) {
-            int i = bas_aa_sym[h][ij][0];
-            int j = bas_aa_sym[h][ij][1];
-            for (int lm = 0; lm < gems_aa[h]; lm++) {
-                int l = bas_aa_sym[h][lm][0];
-                int m = bas_aa_sym[h][lm][1];
-                for (int k = 0; k < amo_; k++) {
-                    int h2 = SymmetryPair(h,symmetry[k]);
-                    int myoffset = saveoff;
-                    for (int myh = 0; myh < h2; myh++) {
-                        myoffset += trip_aab[myh]*trip_aab[myh];
-                    }
-                    int ijk = ibas_aab_sym[h2][i][j][k];
-                    int lmn = ibas_aab_sym[h2][l][m][k];
-                    A_p[myoffset + ijk*trip_aab[h2]+lmn] += u_p[d2aaoff[h] + ij*gems_aa[h]+lm]; // + D2(ij,lm) dkn
-                }
-            }
-        }
+// T2aab (beta = false) or T2bba (beta = true) block of symmetry h, whose
+// rows begin at rowoff
+template <class Symmetry>
+void v2RDMSolver::T2_constraints_aab_terms(Symmetry sym, double * A_p, double * u_p, int h, long int rowoff, long int t2off, bool beta, int mapping, bool skip_t2) {
 
-        #pragma omp parallel for schedule (static)
+    if ( mapping == T2_ATU ) {
+        #pragma omp parallel for schedule (static) num_threads(ATu_nthreads_)
         for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
-            int i = bas_aab_sym[h][ijk][0];
-            int j = bas_aab_sym[h][ijk][1];
-            int k = bas_aab_sym[h][ijk][2];
-
-
-            for (int m = 0; m < amo_; m++) {
-                if ( i >= m ) continue;
-                int l = i;
-                int hmk = SymmetryPair(symmetry[k],symmetry[m]);
-                int mk = ibas_ab_sym[hmk][m][k];
-                int hlm  = SymmetryPair(symmetry[m],symmetry[l]);
-                int hn  = SymmetryPair(h,hlm);
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    int jn = ibas_ab_sym[hmk][j][n];
-                    int lmn  = ibas_aab_sym[h][l][m][n];
-
-                    A_p[offset + ijk*trip_aab[h]+lmn] -= u_p[d2aboff[hmk] + jn*gems_ab[hmk]+mk]; // - D2(nj,km) dil
-                }
-            }
-
-            for (int m = 0; m < amo_; m++) {
-                if ( j >= m ) continue;
-                int l = j;
-                int hmk = SymmetryPair(symmetry[k],symmetry[m]);
-                int mk = ibas_ab_sym[hmk][m][k];
-                int hlm  = SymmetryPair(symmetry[m],symmetry[l]);
-                int hn  = SymmetryPair(h,hlm);
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    int in = ibas_ab_sym[hmk][i][n];
-                    int lmn  = ibas_aab_sym[h][j][m][n];
-
-                    A_p[offset + ijk*trip_aab[h]+lmn] += u_p[d2aboff[hmk] + in*gems_ab[hmk]+mk]; // D2(ni,km) djl
-                }
-            }
-
-            for (int l = 0; l < amo_; l++) {
-                int m = i;
-                if ( l >= m ) continue;
-                int hlk = SymmetryPair(symmetry[k],symmetry[l]);
-                int lk = ibas_ab_sym[hlk][l][k];
-                int hlm  = SymmetryPair(symmetry[m],symmetry[l]);
-                int hn  = SymmetryPair(h,hlm);
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    int jn = ibas_ab_sym[hlk][j][n];
-                    int lmn  = ibas_aab_sym[h][l][m][n];
-
-                    A_p[offset + ijk*trip_aab[h]+lmn] += u_p[d2aboff[hlk] + jn*gems_ab[hlk]+lk]; // D2(nj,kl) dim
-
-                }
-            }
-
-            for (int l = 0; l < amo_; l++) {
-                int m = j;
-                if ( l >= m ) continue;
-                int hlk = SymmetryPair(symmetry[k],symmetry[l]);
-                int lk = ibas_ab_sym[hlk][l][k];
-                int hlm  = SymmetryPair(symmetry[m],symmetry[l]);
-                int hn  = SymmetryPair(h,hlm);
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    int in = ibas_ab_sym[hlk][i][n];
-                    int lmn  = ibas_aab_sym[h][l][m][n];
-
-                    A_p[offset + ijk*trip_aab[h]+lmn] -= u_p[d2aboff[hlk] + in*gems_ab[hlk]+lk]; // -D2(ni,kl) djm
-
-                }
-            }
-
-            for (int n = 0; n < amo_; n++) {
-                int m = j;
-                int l = i;
-                if ( l >= m ) continue;
-
-                int hmn  = SymmetryPair(symmetry[m],symmetry[n]);
-                int hlmn = SymmetryPair(hmn,symmetry[l]);
-                if ( hlmn != h ) continue;
-
-                int lmn  = ibas_aab_sym[h][l][m][n];
-
-                int h2 = symmetry[k];
-                int kk = k - pitzer_offset[h2];
-                int nn = n - pitzer_offset[h2];
-
-                A_p[offset + ijk*trip_aab[h]+lmn] += u_p[d1boff[h2] + nn*amopi_[h2]+kk]; // + D1(n,k) djm dil
-            }
+            T2_constraints_aab_row<Symmetry>(sym,A_p,u_p,h,rowoff,t2off,ijk,beta,mapping,skip_t2);
         }
-        C_DAXPY(trip_aab[h] * trip_aab[h], -1.0, &u_p[t2aaboff[h]],1,&A_p[offset],1);
-
-
-        /*#pragma omp parallel for schedule (static)
+    }else {
+        #pragma omp taskloop nogroup
         for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
+            T2_constraints_aab_row<Symmetry>(sym,A_p,u_p,h,rowoff,t2off,ijk,beta,mapping,skip_t2);
+        }
+    }
+}
 
-            int i = bas_aab_sym[h][ijk][0];
-            int j = bas_aab_sym[h][ijk][1];
-            int k = bas_aab_sym[h][ijk][2];
-
-            for (int lmn = 0; lmn < trip_aab[h]; lmn++) {
-
-                int l = bas_aab_sym[h][lmn][0];
-                int m = bas_aab_sym[h][lmn][1];
-                int n = bas_aab_sym[h][lmn][2];
-
-                double dum = -u_p[t2aaboff[h] + ijk*trip_aab[h]+lmn]; // - T2(ijk,lmn)
+// row ijk of the T2aab (beta = false) or T2bba (beta = true) block of
+// symmetry h.  the -T2 term of the row is included when skip_t2 is
+// false; T2(ijk,lmn) begins at t2off.
+template <class Symmetry>
+void v2RDMSolver::T2_constraints_aab_row(Symmetry sym, double * A_p, double * u_p, int h, long int rowoff, long int t2off, int ijk, bool beta, int mapping, bool skip_t2) {
 
-                if ( k == n ) {
-                    int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
-                    dum += u_p[d2aaoff[hij] + ij*gems_aa[hij]+lm]; // + D2(ij,lm) dkn
-                }
+    int * d2off = beta ? d2bboff : d2aaoff;
+    int * d1off = beta ? d1aoff  : d1boff;
 
-                if ( j == m && i == l ) {
-                    int h2 = symmetry[k];
-                    int kk = k - pitzer_offset[h2];
-                    int nn = n - pitzer_offset[h2];
-                    dum += u_p[d1boff[h2] + nn*amopi_[h2]+kk]; // + D1(n,k) djm dil
-                }
+    long int dim = trip_aab[h];
 
-                if ( j == l && i == m ) { // this one never gets used ...
-                    int h2 = symmetry[k];
-                    int kk = k - pitzer_offset[h2];
-                    int nn = n - pitzer_offset[h2];
-                    dum -= u_p[d1boff[h2] + nn*amopi_[h2]+kk]; // - D1(n,k) djl dim
-                }
+    double * myA_p = mapping == T2_ATU ? ATu_buffer_ + omp_get_thread_num() * dimx_d2q2g2_ : A_p;
 
-                if ( i == l ) {
-                    int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                    int nj = ibas_ab_sym[hnj][j][n];
-                    int km = ibas_ab_sym[hnj][m][k];
-                    dum -= u_p[d2aboff[hnj] + nj*gems_ab[hnj]+km]; // - D2(nj,km) dil
-                }
 
-                if ( j == l ) {
-                    int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][i][n];
-                    int km = ibas_ab_sym[hni][m][k];
-                    dum += u_p[d2aboff[hni] + ni*gems_ab[hni]+km]; // D2(ni,km) djl
-                }
+    int i = bas_aab_sym[h][ijk][0];
+    int j = bas_aab_sym[h][ijk][1];
+    int k = bas_aab_sym[h][ijk][2];
 
-                if ( i == m ) {
-                    int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                    int nj = ibas_ab_sym[hnj][j][n];
-                    int kl = ibas_ab_sym[hnj][l][k];
-                    dum += u_p[d2aboff[hnj] + nj*gems_ab[hnj]+kl]; // D2(nj,kl) dim
-                }
-                if ( j == m ) {
-                    int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][i][n];
-                    int kl = ibas_ab_sym[hni][l][k];
-                    dum -= u_p[d2aboff[hni] + ni*gems_ab[hni]+kl]; // -D2(ni,kl) djm
-                }
-    
-                A_p[offset + ijk*trip_aab[h]+lmn] += dum;
+    long int row = rowoff + ijk * dim;
 
+    // - T2(ijk,lmn)
+    if ( !skip_t2 ) {
+        if ( mapping == T2_ATU ) {
+            C_DAXPY(dim,-1.0,u_p + row,1,A_p + t2off + ijk * dim,1);
+        }else if ( mapping == T2_AU ) {
+            C_DAXPY(dim,-1.0,u_p + t2off + ijk * dim,1,A_p + row,1);
+        }else {
+            for (long int lmn = 0; lmn < dim; lmn++) {
+                A_p[row + lmn] += 1.0;
             }
-        }*/
-        offset += trip_aab[h]*trip_aab[h];
+        }
     }
 
-    saveoff = offset;
+    // + D2(ij,lm) dkn
+    int hij = sym.pair(sym.irrep(i),sym.irrep(j));
+    int ij  = ibas_aa(i,j);
+    for (int lm = 0; lm < gems_aa[hij]; lm++) {
+        int l = bas_aa_sym[hij][lm][0];
+        int m = bas_aa_sym[hij][lm][1];
+        int lmn = ibas_aab(l,m,k);
+        T2Accumulate(myA_p,u_p,row + lmn,d2off[hij] + ij*gems_aa[hij]+lm,1.0,mapping);
+    }
 
-    // T2bba
-    for (int h = 0; h < nirrep_; h++) {
+    // + D1(n,k) djm dil
+    int hk = sym.irrep(k);
+    int kk = k - sym.offset(hk);
+    for (int n = sym.offset(hk); n < sym.offset(hk) + sym.size(hk); n++) {
+        int nn  = n - sym.offset(hk);
+        int lmn = ibas_aab(i,j,n);
+        T2Accumulate(myA_p,u_p,row + lmn,d1off[hk] + nn*sym.size(hk)+kk,1.0,mapping);
+    }
 
-        #pragma omp parallel for schedule (static)
-        for (int ij = 0; ij < gems_aa[h]; ij++) {
-            int i = bas_aa_sym[h][ij][0];
-            int j = bas_aa_sym[h][ij][1];
-            for (int lm = 0; lm < gems_aa[h]; lm++) {
-                int l = bas_aa_sym[h][lm][0];
-                int m = bas_aa_sym[h][lm][1];
-                for (int k = 0; k < amo_; k++) {
-                    int h2 = SymmetryPair(h,symmetry[k]);
-                    int myoffset = saveoff;
-                    for (int myh = 0; myh < h2; myh++) {
-                        myoffset += trip_aab[myh]*trip_aab[myh];
-                    }
-                    int ijk = ibas_aab_sym[h2][i][j][k];
-                    int lmn = ibas_aab_sym[h2][l][m][k];
-                    A_p[myoffset + ijk*trip_aab[h2]+lmn] += u_p[d2bboff[h] + ij*gems_aa[h]+lm]; // + D2(ij,lm) dkn
-                }
-            }
+    // - D2(nj,km) dil
+    for (int m = i + 1; m < amo_; m++) {
+        int hn = sym.pair(h,sym.pair(sym.irrep(i),sym.irrep(m)));
+        for (int n = sym.offset(hn); n < sym.offset(hn) + sym.size(hn); n++) {
+            int hnj = sym.pair(sym.irrep(n),sym.irrep(j));
+            int nj  = beta ? ibas_ab(n,j) : ibas_ab(j,n);
+            int km  = beta ? ibas_ab(k,m) : ibas_ab(m,k);
+            int lmn = ibas_aab(i,m,n);
+            T2Accumulate(myA_p,u_p,row + lmn,d2aboff[hnj] + nj*gems_ab[hnj]+km,-1.0,mapping);
         }
+    }
 
-        #pragma omp parallel for schedule (static)
-        for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
-            int i = bas_aab_sym[h][ijk][0];
-            int j = bas_aab_sym[h][ijk][1];
-            int k = bas_aab_sym[h][ijk][2];
-
-
-            for (int m = 0; m < amo_; m++) {
-                if ( i >= m ) continue;
-                int l = i;
-                int hmk = SymmetryPair(symmetry[k],symmetry[m]);
-                int mk = ibas_ab_sym[hmk][k][m];
-                int hlm  = SymmetryPair(symmetry[m],symmetry[l]);
-                int hn  = SymmetryPair(h,hlm);
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    int jn = ibas_ab_sym[hmk][n][j];
-                    int lmn  = ibas_aab_sym[h][l][m][n];
-
-                    A_p[offset + ijk*trip_aab[h]+lmn] -= u_p[d2aboff[hmk] + jn*gems_ab[hmk]+mk]; // - D2(nj,km) dil
-                }
-            }
-
-            for (int m = 0; m < amo_; m++) {
-                if ( j >= m ) continue;
-                int l = j;
-                int hmk = SymmetryPair(symmetry[k],symmetry[m]);
-                int mk = ibas_ab_sym[hmk][k][m];
-                int hlm  = SymmetryPair(symmetry[m],symmetry[l]);
-                int hn  = SymmetryPair(h,hlm);
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    int in = ibas_ab_sym[hmk][n][i];
-                    int lmn  = ibas_aab_sym[h][j][m][n];
-
-                    A_p[offset + ijk*trip_aab[h]+lmn] += u_p[d2aboff[hmk] + in*gems_ab[hmk]+mk]; // D2(ni,km) djl
-                }
-            }
-
-            for (int l = 0; l < amo_; l++) {
-                int m = i;
-                if ( l >= m ) continue;
-                int hlk = SymmetryPair(symmetry[k],symmetry[l]);
-                int lk = ibas_ab_sym[hlk][k][l];
-                int hlm  = SymmetryPair(symmetry[m],symmetry[l]);
-                int hn  = SymmetryPair(h,hlm);
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    int jn = ibas_ab_sym[hlk][n][j];
-                    int lmn  = ibas_aab_sym[h][l][m][n];
-
-                    A_p[offset + ijk*trip_aab[h]+lmn] += u_p[d2aboff[hlk] + jn*gems_ab[hlk]+lk]; // D2(nj,kl) dim
-
-                }
-            }
-
-            for (int l = 0; l < amo_; l++) {
-                int m = j;
-                if ( l >= m ) continue;
-                int hlk = SymmetryPair(symmetry[k],symmetry[l]);
-                int lk = ibas_ab_sym[hlk][k][l];
-                int hlm  = SymmetryPair(symmetry[m],symmetry[l]);
-                int hn  = SymmetryPair(h,hlm);
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    int in = ibas_ab_sym[hlk][n][i];
-                    int lmn  = ibas_aab_sym[h][l][m][n];
-
-                    A_p[offset + ijk*trip_aab[h]+lmn] -= u_p[d2aboff[hlk] + in*gems_ab[hlk]+lk]; // -D2(ni,kl) djm
-
-                }
-            }
-
-            for (int n = 0; n < amo_; n++) {
-                int m = j;
-                int l = i;
-                if ( l >= m ) continue;
-
-                int hmn  = SymmetryPair(symmetry[m],symmetry[n]);
-                int hlmn = SymmetryPair(hmn,symmetry[l]);
-                if ( hlmn != h ) continue;
-
-                int lmn  = ibas_aab_sym[h][l][m][n];
-
-                int h2 = symmetry[k];
-                int kk = k - pitzer_offset[h2];
-                int nn = n - pitzer_offset[h2];
-
-                A_p[offset + ijk*trip_aab[h]+lmn] += u_p[d1aoff[h2] + nn*amopi_[h2]+kk]; // + D1(n,k) djm dil
-            }
+    // + D2(ni,km) djl
+    for (int m = j + 1; m < amo_; m++) {
+        int hn = sym.pair(h,sym.pair(sym.irrep(j),sym.irrep(m)));
+        for (int n = sym.offset(hn); n < sym.offset(hn) + sym.size(hn); n++) {
+            int hni = sym.pair(sym.irrep(n),sym.irrep(i));
+            int ni  = beta ? ibas_ab(n,i) : ibas_ab(i,n);
+            int km  = beta ? ibas_ab(k,m) : ibas_ab(m,k);
+            int lmn = ibas_aab(j,m,n);
+            T2Accumulate(myA_p,u_p,row + lmn,d2aboff[hni] + ni*gems_ab[hni]+km,1.0,mapping);
         }
-        C_DAXPY(trip_aab[h] * trip_aab[h], -1.0, &u_p[t2bbaoff[h]],1,&A_p[offset],1);
-
-        /*#pragma omp parallel for schedule (static)
-        for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
-
-            int i = bas_aab_sym[h][ijk][0];
-            int j = bas_aab_sym[h][ijk][1];
-            int k = bas_aab_sym[h][ijk][2];
-
-            for (int lmn = 0; lmn < trip_aab[h]; lmn++) {
-
-                int l = bas_aab_sym[h][lmn][0];
-                int m = bas_aab_sym[h][lmn][1];
-                int n = bas_aab_sym[h][lmn][2];
-
-                double dum = -u_p[t2bbaoff[h] + ijk*trip_aab[h]+lmn]; // - T2(ijk,lmn)
-
-                if ( k == n ) {
-                    int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
-                    dum += u_p[d2bboff[hij] + ij*gems_aa[hij]+lm]; // + D2(ij,lm) dkn
-                }
-
-                if ( j == m && i == l ) {
-                    int h2 = symmetry[k];
-                    int kk = k - pitzer_offset[h2];
-                    int nn = n - pitzer_offset[h2];
-                    dum += u_p[d1aoff[h2] + nn*amopi_[h2]+kk]; // + D1(n,k) djm dil
-                }
-                if ( j == l && i == m ) {
-                    int h2 = symmetry[k];
-                    int kk = k - pitzer_offset[h2];
-                    int nn = n - pitzer_offset[h2];
-                    dum -= u_p[d1aoff[h2] + nn*amopi_[h2]+kk]; // - D1(n,k) djl dim
-                }
-
-                if ( i == l ) {
-                    int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                    int nj = ibas_ab_sym[hnj][n][j];
-                    int km = ibas_ab_sym[hnj][k][m];
-                    dum -= u_p[d2aboff[hnj] + nj*gems_ab[hnj]+km]; // - D2(nj,km) dil
-                }
-                if ( j == l ) {
-                    int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int km = ibas_ab_sym[hni][k][m];
-                    dum += u_p[d2aboff[hni] + ni*gems_ab[hni]+km]; // D2(ni,km) djl
-                }
-                if ( i == m ) {
-                    int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                    int nj = ibas_ab_sym[hnj][n][j];
-                    int kl = ibas_ab_sym[hnj][k][l];
-                    dum += u_p[d2aboff[hnj] + nj*gems_ab[hnj]+kl]; // D2(nj,kl) dim
-                }
-                if ( j == m ) {
-                    int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int kl = ibas_ab_sym[hni][k][l];
-                    dum -= u_p[d2aboff[hni] + ni*gems_ab[hni]+kl]; // -D2(ni,kl) djm
-                }
-    
-                A_p[offset + ijk*trip_aab[h]+lmn] = dum;
-
-            }
-        }*/
-        offset += trip_aab[h]*trip_aab[h];
     }
 
-    // big block 1: T2aaa + T2abb
-#if 1
-    for (int h = 0; h < nirrep_; h++) {
-
-        // T2aaa/aaa
-        #pragma omp parallel for schedule (static)
-        for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
-
-            int i = bas_aab_sym[h][ijk][0];
-            int j = bas_aab_sym[h][ijk][1];
-            int k = bas_aab_sym[h][ijk][2];
-            int hij = SymmetryPair(symmetry[i],symmetry[j]);
-            int ij = ibas_aa_sym[hij][i][j];
-            int ijk_id = offset + ijk*(trip_aab[h]+trip_aba[h]);
-
-            for (int l = 0; l < amo_; l++) {
-                int n = k;
-                int hln  = SymmetryPair(symmetry[n],symmetry[l]);
-                int hm  = SymmetryPair(h,hln);
-                for (int m = ( l + 1 > pitzer_offset[hm] ? l : pitzer_offset[hm] ); m < pitzer_offset[hm]+amopi_[hm]; m++) {
-                    int lm = ibas_aa_sym[hij][l][m];
-                    int lmn  = ibas_aab_sym[h][l][m][n];
-
-                    A_p[ijk_id + lmn] += u_p[d2aaoff[hij] + ij*gems_aa[hij]+lm]; // + D2(ij,lm) dkn
-                }
-            }
-
-            for (int m = i+1; m < amo_; m++) {
-                if ( k == m ) continue;
-                int l = i;
-                int hml = SymmetryPair(symmetry[m],symmetry[l]);
-                int hkm = SymmetryPair(symmetry[m],symmetry[k]);
-                int hn  = SymmetryPair(h,hml);
-                int km = ibas_aa_sym[hkm][k][m];
-                int s1 = 1;
-                if ( k > m ) s1 = -s1;
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    if ( j == n ) continue;
-                    int s2 = s1;
-                    if ( n > j ) s2 = -s2;
-
-                    int nj   = ibas_aa_sym[hkm][n][j];
-                    int lmn  = ibas_aab_sym[h][l][m][n];
-                    A_p[ijk_id + lmn] -= s2 * u_p[d2aaoff[hkm] + nj*gems_aa[hkm]+km]; // - D2(nj,km) dil
-                }
-            }
-            for (int m = j+1; m < amo_; m++) {
-                if ( k == m ) continue;
-                int l = j;
-                int hml = SymmetryPair(symmetry[m],symmetry[l]);
-                int hkm = SymmetryPair(symmetry[m],symmetry[k]);
-                int hn  = SymmetryPair(h,hml);
-                int km = ibas_aa_sym[hkm][k][m];
-                int s1 = 1;
-                if ( k > m ) s1 = -s1;
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    if ( i == n ) continue;
-                    int s2 = s1;
-                    if ( n > i ) s2 = -s2;
-
-                    int ni   = ibas_aa_sym[hkm][n][i];
-                    int lmn  = ibas_aab_sym[h][l][m][n];
-
-                    A_p[ijk_id + lmn] += s2 * u_p[d2aaoff[hkm] + ni*gems_aa[hkm]+km]; // D2(ni,km) djl
-                }
-            }
-            for (int l = 0; l < i; l++) {
-                if ( k == l ) continue;
-                int m = i;
-                int hml = SymmetryPair(symmetry[m],symmetry[l]);
-                int hkl = SymmetryPair(symmetry[l],symmetry[k]);
-                int hn  = SymmetryPair(h,hml);
-                int kl = ibas_aa_sym[hkl][k][l];
-                int s1 = 1;
-                if ( k > l ) s1 = -s1;
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    if ( j == n ) continue;
-                    int s2 = s1;
-                    if ( n > j ) s2 = -s2;
-
-                    int nj   = ibas_aa_sym[hkl][n][j];
-                    int lmn  = ibas_aab_sym[h][l][m][n];
-                    A_p[ijk_id + lmn] += s2 * u_p[d2aaoff[hkl] + nj*gems_aa[hkl]+kl]; // D2(nj,kl) dim
-                }
-            }
-            for (int l = 0; l < j; l++) {
-                if ( k == l ) continue;
-                int m = j;
-                int hml = SymmetryPair(symmetry[m],symmetry[l]);
-                int hkl = SymmetryPair(symmetry[l],symmetry[k]);
-                int hn  = SymmetryPair(h,hml);
-                int kl = ibas_aa_sym[hkl][k][l];
-                int s1 = 1;
-                if ( k > l ) s1 = -s1;
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    if ( i == n ) continue;
-                    int s2 = s1;
-                    if ( n > i ) s2 = -s2;
-
-                    int ni   = ibas_aa_sym[hkl][n][i];
-                    int lmn  = ibas_aab_sym[h][l][m][n];
-                    A_p[ijk_id + lmn] -= s2 * u_p[d2aaoff[hkl] + ni*gems_aa[hkl]+kl]; // -D2(ni,kl) djm
-                }
-            }
-            int hk = symmetry[k];
-            int kk = k - pitzer_offset[hk];
-            int m = j;
-            int l = i;
-            for (int n = pitzer_offset[hk]; n < pitzer_offset[hk] + amopi_[hk]; n++) {
-                int nn = n - pitzer_offset[hk];
-                int lmn  = ibas_aab_sym[h][l][m][n];
-                A_p[ijk_id + lmn] += u_p[d1aoff[hk] + nn*amopi_[hk]+kk]; // + D1(n,k) djm dil
-            }
+    // + D2(nj,kl) dim
+    for (int l = 0; l < i; l++) {
+        int hn = sym.pair(h,sym.pair(sym.irrep(i),sym.irrep(l)));
+        for (int n = sym.offset(hn); n < sym.offset(hn) + sym.size(hn); n++) {
+            int hnj = sym.pair(sym.irrep(n),sym.irrep(j));
+            int nj  = beta ? ibas_ab(n,j) : ibas_ab(j,n);
+            int kl  = beta ? ibas_ab(k,l) : ibas_ab(l,k);
+            int lmn = ibas_aab(l,i,n);
+            T2Accumulate(myA_p,u_p,row + lmn,d2aboff[hnj] + nj*gems_ab[hnj]+kl,1.0,mapping);
         }
+    }
 
-        /*#pragma omp parallel for schedule (static)
-        for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
-
-            int i = bas_aab_sym[h][ijk][0];
-            int j = bas_aab_sym[h][ijk][1];
-            int k = bas_aab_sym[h][ijk][2];
-
-            for (int lmn = 0; lmn < trip_aab[h]; lmn++) {
+    // - D2(ni,kl) djm
+    for (int l = 0; l < j; l++) {
+        int hn = sym.pair(h,sym.pair(sym.irrep(j),sym.irrep(l)));
+        for (int n = sym.offset(hn); n < sym.offset(hn) + sym.size(hn); n++) {
+            int hni = sym.pair(sym.irrep(n),sym.irrep(i));
+            int ni  = beta ? ibas_ab(n,i) : ibas_ab(i,n);
+            int kl  = beta ? ibas_ab(k,l) : ibas_ab(l,k);
+            int lmn = ibas_aab(l,j,n);
+            T2Accumulate(myA_p,u_p,row + lmn,d2aboff[hni] + ni*gems_ab[hni]+kl,-1.0,mapping);
+        }
+    }
+}
 
-                int l = bas_aab_sym[h][lmn][0];
-                int m = bas_aab_sym[h][lmn][1];
-                int n = bas_aab_sym[h][lmn][2];
+// T2aaa (beta = false) or T2bbb (beta = true) block of symmetry h, whose
+// rows begin at rowoff.  the block has dimension trip_aab[h] + trip_aba[h]:
+// aab triples followed by aba triples.
+template <class Symmetry>
+void v2RDMSolver::T2_constraints_aaa_terms(Symmetry sym, double * A_p, double * u_p, int h, long int rowoff, long int t2off, bool beta, int mapping, bool skip_t2) {
 
-                int id = ijk*(trip_aab[h]+trip_aba[h])+lmn;
-                //int id = ijk*trip_aab[h]+lmn;
+    long int dim = trip_aab[h] + trip_aba[h];
 
-                double dum = -u_p[t2aaaoff[h] + id]; // - T2(ijk,lmn)
+    if ( mapping == T2_ATU ) {
+        #pragma omp parallel for schedule (static) num_threads(ATu_nthreads_)
+        for (int ijk = 0; ijk < dim; ijk++) {
+            T2_constraints_aaa_row<Symmetry>(sym,A_p,u_p,h,rowoff,t2off,ijk,beta,mapping,skip_t2);
+        }
+    }else {
+        #pragma omp taskloop nogroup
+        for (int ijk = 0; ijk < dim; ijk++) {
+            T2_constraints_aaa_row<Symmetry>(sym,A_p,u_p,h,rowoff,t2off,ijk,beta,mapping,skip_t2);
+        }
+    }
+}
 
-                if ( k == n ) {
-                    int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
-                    dum += u_p[d2aaoff[hij] + ij*gems_aa[hij]+lm]; // + D2(ij,lm) dkn
-                }
+// row ijk of the T2aaa (beta = false) or T2bbb (beta = true) block of
+// symmetry h.  rows ijk < trip_aab[h] are aab triples; the rest are aba.
+// T2(ijk,lmn) begins at t2off.
+template <class Symmetry>
+void v2RDMSolver::T2_constraints_aaa_row(Symmetry sym, double * A_p, double * u_p, int h, long int rowoff, long int t2off, int ijk, bool beta, int mapping, bool skip_t2) {
 
-                if ( j == m && i == l ) {
-                    int h2 = symmetry[k];
-                    int kk = k - pitzer_offset[h2];
-                    int nn = n - pitzer_offset[h2];
-                    dum += u_p[d1aoff[h2] + nn*amopi_[h2]+kk]; // + D1(n,k) djm dil
-                }
-                // this one is never entered
-                if ( j == l && i == m ) {
-                    int h2 = symmetry[k];
-                    int kk = k - pitzer_offset[h2];
-                    int nn = n - pitzer_offset[h2];
-                    dum -= u_p[d1aoff[h2] + nn*amopi_[h2]+kk]; // - D1(n,k) djl dim
-                }
+    int * d2off_same  = beta ? d2bboff : d2aaoff;
+    int * d2off_other = beta ? d2aaoff : d2bboff;
+    int * d1off_same  = beta ? d1boff  : d1aoff;
+    int * d1off_other = beta ? d1aoff  : d1boff;
 
-                if ( i == l ) {
-                    if ( n != j && k != m ) {
-                        int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int km = ibas_aa_sym[hnj][k][m];
+    long int dim = trip_aab[h] + trip_aba[h];
 
-                        int s = 1;
-                        if ( n > j ) s = -s;
-                        if ( k > m ) s = -s;
-
-                        dum -= s * u_p[d2aaoff[hnj] + nj*gems_aa[hnj]+km]; // - D2(nj,km) dil
-                    }
-                }
-                if ( j == l ) {
-                    if ( n != i && k != m ) {
-                        int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                        int ni = ibas_aa_sym[hni][n][i];
-                        int km = ibas_aa_sym[hni][k][m];
-
-                        int s = 1;
-                        if ( n > i ) s = -s;
-                        if ( k > m ) s = -s;
-
-                        dum += s * u_p[d2aaoff[hni] + ni*gems_aa[hni]+km]; // D2(ni,km) djl
-                    }
-                }
-                if ( i == m ) {
-                    if ( n != j && k != l ) {
-                        int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int kl = ibas_aa_sym[hnj][k][l];
-
-                        int s = 1;
-                        if ( n > j ) s = -s;
-                        if ( k > l ) s = -s;
-
-                        dum += s * u_p[d2aaoff[hnj] + nj*gems_aa[hnj]+kl]; // D2(nj,kl) dim
-                    }
-                }
-                if ( j == m ) {
-                    if ( n != i && k != l ) {
-                        int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                        int ni = ibas_aa_sym[hni][n][i];
-                        int kl = ibas_aa_sym[hni][k][l];
-
-                        int s = 1;
-                        if ( n > i ) s = -s;
-                        if ( k > l ) s = -s;
-
-                        dum -= s * u_p[d2aaoff[hni] + ni*gems_aa[hni]+kl]; // -D2(ni,kl) djm
-                    }
-                }
-    
-                A_p[offset + id] += dum;
-
-            }
-        }*/
-        // T2aaa/abb
-        #pragma omp parallel for schedule (static)
-        for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
-
-            int i = bas_aab_sym[h][ijk][0];
-            int j = bas_aab_sym[h][ijk][1];
-            int k = bas_aab_sym[h][ijk][2];
-
-            int ijk_id = offset + ijk*(trip_aab[h]+trip_aba[h]);
-
-            for (int m = 0; m < amo_; m++) {
-                int l = i;
-                int hml = SymmetryPair(symmetry[m],symmetry[l]);
-                int hkm = SymmetryPair(symmetry[m],symmetry[k]);
-                int hn  = SymmetryPair(h,hml);
-                int km = ibas_ab_sym[hkm][k][m];
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    int jn = ibas_ab_sym[hkm][j][n];
-                    int lmn  = ibas_aba_sym[h][l][m][n];
-                    A_p[ijk_id + (trip_aab[h] + lmn)] += u_p[d2aboff[hkm]+jn*gems_ab[hkm]+km]; // D2(jn,km) dil
-                    A_p[offset + (trip_aab[h] + lmn)*(trip_aab[h]+trip_aba[h]) + ijk] += u_p[d2aboff[hkm]+jn*gems_ab[hkm]+km]; // D2(jn,km) dil
-                }
-            }
-            for (int m = 0; m < amo_; m++) {
-                int l = j;
-                int hml = SymmetryPair(symmetry[m],symmetry[l]);
-                int hkm = SymmetryPair(symmetry[m],symmetry[k]);
-                int hn  = SymmetryPair(h,hml);
-                int km = ibas_ab_sym[hkm][k][m];
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    int in = ibas_ab_sym[hkm][i][n];
-                    int lmn  = ibas_aba_sym[h][l][m][n];
-                    A_p[ijk_id + (trip_aab[h] + lmn)] -= u_p[d2aboff[hkm]+in*gems_ab[hkm]+km]; // -D2(in,km) djl
-                    A_p[offset + (trip_aab[h] + lmn)*(trip_aab[h]+trip_aba[h]) + ijk] -= u_p[d2aboff[hkm]+in*gems_ab[hkm]+km]; // -D2(in,km) djl
-                }
-            }
-        }
-
-        /*#pragma omp parallel for schedule (static)
-        for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
-
-            int i = bas_aab_sym[h][ijk][0];
-            int j = bas_aab_sym[h][ijk][1];
-            int k = bas_aab_sym[h][ijk][2];
-
-            for (int lmn = 0; lmn < trip_aba[h]; lmn++) {
-
-                int l = bas_aba_sym[h][lmn][0];
-                int m = bas_aba_sym[h][lmn][1];
-                int n = bas_aba_sym[h][lmn][2];
-
-                int id = ijk*(trip_aab[h]+trip_aba[h])+(lmn+trip_aab[h]);
-
-                double dum = 0.0;//-u_p[t2aaaoff[h] + id]; // - T2(ijk,lmn)
-
-                if ( i == l ) {
-                    int hjn = SymmetryPair(symmetry[j],symmetry[n]);
-                    int jn = ibas_ab_sym[hjn][j][n];
-                    int km = ibas_ab_sym[hjn][k][m];
-                    dum += u_p[d2aboff[hjn]+jn*gems_ab[hjn]+km]; // D2(jn,km) dil
-                }
-                if ( j == l ) {
-                    int hin = SymmetryPair(symmetry[i],symmetry[n]);
-                    int in = ibas_ab_sym[hin][i][n];
-                    int km = ibas_ab_sym[hin][k][m];
-                    dum -= u_p[d2aboff[hin]+in*gems_ab[hin]+km]; // -D2(in,km) djl
-                }
-
-                A_p[offset + id] += dum;
-
-            }
-        }*/
-
-        // T2abb/aaa
-        /*#pragma omp parallel for schedule (static)
-        for (int ijk = 0; ijk < trip_aba[h]; ijk++) {
-
-            int i = bas_aba_sym[h][ijk][0];
-            int j = bas_aba_sym[h][ijk][1];
-            int k = bas_aba_sym[h][ijk][2];
-
-            for (int lmn = 0; lmn < trip_aab[h]; lmn++) {
-
-                int l = bas_aab_sym[h][lmn][0];
-                int m = bas_aab_sym[h][lmn][1];
-                int n = bas_aab_sym[h][lmn][2];
-
-                int id = (ijk+trip_aab[h])*(trip_aab[h]+trip_aba[h])+lmn;
-
-                double dum = 0.0;//-u_p[t2aaaoff[h] + id]; // - T2(ijk,lmn)
-
-                if ( i == l ) {
-                    int hjn = SymmetryPair(symmetry[j],symmetry[n]);
-                    int jn = ibas_ab_sym[hjn][n][j];
-                    int km = ibas_ab_sym[hjn][m][k];
-                    dum += u_p[d2aboff[hjn]+jn*gems_ab[hjn]+km]; // D2(jn,km) dil
-                }
-                if ( i == m ) {
-                    int hnj = SymmetryPair(symmetry[j],symmetry[n]);
-                    int nj = ibas_ab_sym[hnj][n][j];
-                    int lk = ibas_ab_sym[hnj][l][k];
-                    dum -= u_p[d2aboff[hnj]+nj*gems_ab[hnj]+lk]; // -D2(in,km) djl
-                }
-
-                A_p[offset + id] += dum;
-
-            }
-        }*/
-
-        // T2abb/abb
-        #pragma omp parallel for schedule (static)
-        for (int ijk = 0; ijk < trip_aba[h]; ijk++) {
-
-            int i = bas_aba_sym[h][ijk][0];
-            int j = bas_aba_sym[h][ijk][1];
-            int k = bas_aba_sym[h][ijk][2];
-
-            int ijk_id = offset + (ijk+trip_aab[h])*(trip_aab[h]+trip_aba[h]);
-            int hij = SymmetryPair(symmetry[i],symmetry[j]);
-            int ij = ibas_ab_sym[hij][i][j];
-            for (int lm = 0; lm < gems_ab[hij]; lm++) {
-                int l = bas_ab_sym[hij][lm][0];
-                int m = bas_ab_sym[hij][lm][1];
-                int n = k;
-                int lmn = ibas_aba_sym[h][l][m][n];
-                A_p[ijk_id + (trip_aab[h] + lmn)] += u_p[d2aboff[hij] + ij*gems_ab[hij]+lm]; // + D2(ij,lm) dkn
-            }
-
-            for (int l = 0; l < amo_; l++) {
-                int hlk = SymmetryPair(symmetry[k],symmetry[l]);
-                int lk = ibas_ab_sym[hlk][l][k];
-                int m = j;
-                int hlm = SymmetryPair(symmetry[l],symmetry[m]);
-                int hn = SymmetryPair(h,hlm);
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    int ni = ibas_ab_sym[hlk][i][n];
-                    int lmn = ibas_aba_sym[h][l][m][n];
-                    A_p[ijk_id + (trip_aab[h] + lmn)] -= u_p[d2aboff[hlk] + ni*gems_ab[hlk]+lk]; // -D2(ni,kl) djm
-                }
-            }
-            for (int m = 0; m < amo_; m++) {
-                if ( k == m ) continue;
-                int hkm = SymmetryPair(symmetry[k],symmetry[m]);
-                int km = ibas_aa_sym[hkm][k][m];
-                int l = i;
-                int hlm = SymmetryPair(symmetry[l],symmetry[m]);
-                int hn = SymmetryPair(h,hlm);
-                int s1 = 1;
-                if ( k > m ) s1 = -s1;
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    if ( n == j ) continue;
-                    int nj = ibas_aa_sym[hkm][n][j];
-                    int lmn = ibas_aba_sym[h][l][m][n];
-                    int s2 = s1;
-                    if ( n > j ) s2 = -s2;
-                    A_p[ijk_id + (trip_aab[h] + lmn)] -= s2 * u_p[d2bboff[hkm] + nj*gems_aa[hkm]+km]; // - D2(nj,km) dil
-                }
-            }
-            int m = j;
-            int l = i;
-            int hk = symmetry[k];
-            int kk = k - pitzer_offset[hk];
-            for (int n = pitzer_offset[hk]; n < pitzer_offset[hk]+amopi_[hk]; n++) {
-                int nn = n - pitzer_offset[hk];
-                int lmn = ibas_aba_sym[h][l][m][n];
-                A_p[ijk_id + (trip_aab[h] + lmn)] += u_p[d1boff[hk] + nn*amopi_[hk]+kk]; // + D1(n,k) djm dil
-            }
-
-        }
-        /*#pragma omp parallel for schedule (static)
-        for (int ijk = 0; ijk < trip_aba[h]; ijk++) {
-
-            int i = bas_aba_sym[h][ijk][0];
-            int j = bas_aba_sym[h][ijk][1];
-            int k = bas_aba_sym[h][ijk][2];
-
-            for (int lmn = 0; lmn < trip_aba[h]; lmn++) {
-
-                int l = bas_aba_sym[h][lmn][0];
-                int m = bas_aba_sym[h][lmn][1];
-                int n = bas_aba_sym[h][lmn][2];
-
-                int id = (ijk+trip_aab[h])*(trip_aab[h]+trip_aba[h])+(lmn+trip_aab[h]);
-
-                double dum = 0.0;//-u_p[t2aaaoff[h] + id]; // - T2(ijk,lmn)
-
-                if ( k == n ) {
-                    int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_ab_sym[hij][i][j];
-                    int lm = ibas_ab_sym[hij][l][m];
-                    dum += u_p[d2aboff[hij] + ij*gems_ab[hij]+lm]; // + D2(ij,lm) dkn
-                }
-
-                if ( j == m && i == l ) {
-                    int h2 = symmetry[k];
-                    int kk = k - pitzer_offset[h2];
-                    int nn = n - pitzer_offset[h2];
-                    dum += u_p[d1boff[h2] + nn*amopi_[h2]+kk]; // + D1(n,k) djm dil
-                }
-
-                if ( i == l ) {
-                    if ( n != j && k != m ) {
-                        int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int km = ibas_aa_sym[hnj][k][m];
-
-                        int s = 1;
-                        if ( n > j ) s = -s;
-                        if ( k > m ) s = -s;
-
-                        dum -= s * u_p[d2bboff[hnj] + nj*gems_aa[hnj]+km]; // - D2(nj,km) dil
-                    }
-                }
-                if ( j == m ) {
-                    int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][i][n];
-                    int kl = ibas_ab_sym[hni][l][k];
-                    dum -= u_p[d2aboff[hni] + ni*gems_ab[hni]+kl]; // -D2(ni,kl) djm
-                }
-    
-                A_p[offset + id] += dum;
-
-            }
-        }*/
-        C_DAXPY((trip_aba[h] + trip_aab[h]) * (trip_aba[h] + trip_aab[h]), -1.0, &u_p[t2aaaoff[h]],1,&A_p[offset],1);
-
-        offset += (trip_aba[h]+trip_aab[h])*(trip_aba[h]+trip_aab[h]);
-        //offset += trip_aab[h]*trip_aab[h];
-    }
-
-    // big block 2: T2bbb + T2baa
-    for (int h = 0; h < nirrep_; h++) {
-
-        // T2bbb/bbb
-        #pragma omp parallel for schedule (static)
-        for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
-
-            int i = bas_aab_sym[h][ijk][0];
-            int j = bas_aab_sym[h][ijk][1];
-            int k = bas_aab_sym[h][ijk][2];
-            int hij = SymmetryPair(symmetry[i],symmetry[j]);
-            int ij = ibas_aa_sym[hij][i][j];
-            int ijk_id = offset + ijk*(trip_aab[h]+trip_aba[h]);
-
-            for (int l = 0; l < amo_; l++) {
-                int n = k;
-                int hln  = SymmetryPair(symmetry[n],symmetry[l]);
-                int hm  = SymmetryPair(h,hln);
-                for (int m = ( l + 1 > pitzer_offset[hm] ? l : pitzer_offset[hm] ); m < pitzer_offset[hm]+amopi_[hm]; m++) {
-                    int lm = ibas_aa_sym[hij][l][m];
-                    int lmn  = ibas_aab_sym[h][l][m][n];
-
-                    A_p[ijk_id + lmn] += u_p[d2bboff[hij] + ij*gems_aa[hij]+lm]; // + D2(ij,lm) dkn
-                }
-            }
-
-            for (int m = i+1; m < amo_; m++) {
-                if ( k == m ) continue;
-                int l = i;
-                int hml = SymmetryPair(symmetry[m],symmetry[l]);
-                int hkm = SymmetryPair(symmetry[m],symmetry[k]);
-                int hn  = SymmetryPair(h,hml);
-                int km = ibas_aa_sym[hkm][k][m];
-                int s1 = 1;
-                if ( k > m ) s1 = -s1;
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    if ( j == n ) continue;
-                    int s2 = s1;
-                    if ( n > j ) s2 = -s2;
-
-                    int nj   = ibas_aa_sym[hkm][n][j];
-                    int lmn  = ibas_aab_sym[h][l][m][n];
-                    A_p[ijk_id + lmn] -= s2 * u_p[d2bboff[hkm] + nj*gems_aa[hkm]+km]; // - D2(nj,km) dil
-                }
-            }
-            for (int m = j+1; m < amo_; m++) {
-                if ( k == m ) continue;
-                int l = j;
-                int hml = SymmetryPair(symmetry[m],symmetry[l]);
-                int hkm = SymmetryPair(symmetry[m],symmetry[k]);
-                int hn  = SymmetryPair(h,hml);
-                int km = ibas_aa_sym[hkm][k][m];
-                int s1 = 1;
-                if ( k > m ) s1 = -s1;
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    if ( i == n ) continue;
-                    int s2 = s1;
-                    if ( n > i ) s2 = -s2;
-
-                    int ni   = ibas_aa_sym[hkm][n][i];
-                    int lmn  = ibas_aab_sym[h][l][m][n];
-
-                    A_p[ijk_id + lmn] += s2 * u_p[d2bboff[hkm] + ni*gems_aa[hkm]+km]; // D2(ni,km) djl
-                }
-            }
-            for (int l = 0; l < i; l++) {
-                if ( k == l ) continue;
-                int m = i;
-                int hml = SymmetryPair(symmetry[m],symmetry[l]);
-                int hkl = SymmetryPair(symmetry[l],symmetry[k]);
-                int hn  = SymmetryPair(h,hml);
-                int kl = ibas_aa_sym[hkl][k][l];
-                int s1 = 1;
-                if ( k > l ) s1 = -s1;
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    if ( j == n ) continue;
-                    int s2 = s1;
-                    if ( n > j ) s2 = -s2;
-
-                    int nj   = ibas_aa_sym[hkl][n][j];
-                    int lmn  = ibas_aab_sym[h][l][m][n];
-                    A_p[ijk_id + lmn] += s2 * u_p[d2bboff[hkl] + nj*gems_aa[hkl]+kl]; // D2(nj,kl) dim
-                }
-            }
-            for (int l = 0; l < j; l++) {
-                if ( k == l ) continue;
-                int m = j;
-                int hml = SymmetryPair(symmetry[m],symmetry[l]);
-                int hkl = SymmetryPair(symmetry[l],symmetry[k]);
-                int hn  = SymmetryPair(h,hml);
-                int kl = ibas_aa_sym[hkl][k][l];
-                int s1 = 1;
-                if ( k > l ) s1 = -s1;
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    if ( i == n ) continue;
-                    int s2 = s1;
-                    if ( n > i ) s2 = -s2;
-
-                    int ni   = ibas_aa_sym[hkl][n][i];
-                    int lmn  = ibas_aab_sym[h][l][m][n];
-                    A_p[ijk_id + lmn] -= s2 * u_p[d2bboff[hkl] + ni*gems_aa[hkl]+kl]; // -D2(ni,kl) djm
-                }
-            }
-            int hk = symmetry[k];
-            int kk = k - pitzer_offset[hk];
-            int m = j;
-            int l = i;
-            for (int n = pitzer_offset[hk]; n < pitzer_offset[hk] + amopi_[hk]; n++) {
-                int nn = n - pitzer_offset[hk];
-                int lmn  = ibas_aab_sym[h][l][m][n];
-                A_p[ijk_id + lmn] += u_p[d1boff[hk] + nn*amopi_[hk]+kk]; // + D1(n,k) djm dil
-            }
-        }
-
-        /*#pragma omp parallel for schedule (static)
-        for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
-
-            int i = bas_aab_sym[h][ijk][0];
-            int j = bas_aab_sym[h][ijk][1];
-            int k = bas_aab_sym[h][ijk][2];
-
-            for (int lmn = 0; lmn < trip_aab[h]; lmn++) {
-
-                int l = bas_aab_sym[h][lmn][0];
-                int m = bas_aab_sym[h][lmn][1];
-                int n = bas_aab_sym[h][lmn][2];
-
-                int id = ijk*(trip_aab[h]+trip_aba[h])+lmn;
-                //int id = ijk*trip_aab[h]+lmn;
-
-                double dum = 0.0;//-u_p[t2bbboff[h] + id]; // - T2(ijk,lmn)
-
-                if ( k == n ) {
-                    int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
-                    dum += u_p[d2bboff[hij] + ij*gems_aa[hij]+lm]; // + D2(ij,lm) dkn
-                }
-
-                if ( j == m && i == l ) {
-                    int h2 = symmetry[k];
-                    int kk = k - pitzer_offset[h2];
-                    int nn = n - pitzer_offset[h2];
-                    dum += u_p[d1boff[h2] + nn*amopi_[h2]+kk]; // + D1(n,k) djm dil
-                }
-                if ( j == l && i == m ) {
-                    int h2 = symmetry[k];
-                    int kk = k - pitzer_offset[h2];
-                    int nn = n - pitzer_offset[h2];
-                    dum -= u_p[d1boff[h2] + nn*amopi_[h2]+kk]; // - D1(n,k) djl dim
-                }
-
-                if ( i == l ) {
-                    if ( n != j && k != m ) {
-                        int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int km = ibas_aa_sym[hnj][k][m];
-
-                        int s = 1;
-                        if ( n > j ) s = -s;
-                        if ( k > m ) s = -s;
-
-                        dum -= s * u_p[d2bboff[hnj] + nj*gems_aa[hnj]+km]; // - D2(nj,km) dil
-                    }
-                }
-                if ( j == l ) {
-                    if ( n != i && k != m ) {
-                        int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                        int ni = ibas_aa_sym[hni][n][i];
-                        int km = ibas_aa_sym[hni][k][m];
-
-                        int s = 1;
-                        if ( n > i ) s = -s;
-                        if ( k > m ) s = -s;
-
-                        dum += s * u_p[d2bboff[hni] + ni*gems_aa[hni]+km]; // D2(ni,km) djl
-                    }
-                }
-                if ( i == m ) {
-                    if ( n != j && k != l ) {
-                        int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int kl = ibas_aa_sym[hnj][k][l];
-
-                        int s = 1;
-                        if ( n > j ) s = -s;
-                        if ( k > l ) s = -s;
-
-                        dum += s * u_p[d2bboff[hnj] + nj*gems_aa[hnj]+kl]; // D2(nj,kl) dim
-                    }
-                }
-                if ( j == m ) {
-                    if ( n != i && k != l ) {
-                        int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                        int ni = ibas_aa_sym[hni][n][i];
-                        int kl = ibas_aa_sym[hni][k][l];
-
-                        int s = 1;
-                        if ( n > i ) s = -s;
-                        if ( k > l ) s = -s;
-
-                        dum -= s * u_p[d2bboff[hni] + ni*gems_aa[hni]+kl]; // -D2(ni,kl) djm
-                    }
-                }
-    
-                A_p[offset + id] = dum;
-
-            }
-        }*/
-
-        // T2bbb/baa
-        #pragma omp parallel for schedule (static)
-        for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
-
-            int i = bas_aab_sym[h][ijk][0];
-            int j = bas_aab_sym[h][ijk][1];
-            int k = bas_aab_sym[h][ijk][2];
-
-            int ijk_id = offset + ijk*(trip_aab[h]+trip_aba[h]);
-
-            for (int m = 0; m < amo_; m++) {
-                int l = i;
-                int hml = SymmetryPair(symmetry[m],symmetry[l]);
-                int hkm = SymmetryPair(symmetry[m],symmetry[k]);
-                int hn  = SymmetryPair(h,hml);
-                int km = ibas_ab_sym[hkm][m][k];
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    int jn = ibas_ab_sym[hkm][n][j];
-                    int lmn  = ibas_aba_sym[h][l][m][n];
-                    A_p[ijk_id + (trip_aab[h] + lmn)] += u_p[d2aboff[hkm]+jn*gems_ab[hkm]+km]; // D2(jn,km) dil
-                    A_p[offset + (trip_aab[h] + lmn)*(trip_aab[h]+trip_aba[h]) + ijk] += u_p[d2aboff[hkm]+jn*gems_ab[hkm]+km]; // D2(jn,km) dil
-                }
-            }
-            for (int m = 0; m < amo_; m++) {
-                int l = j;
-                int hml = SymmetryPair(symmetry[m],symmetry[l]);
-                int hkm = SymmetryPair(symmetry[m],symmetry[k]);
-                int hn  = SymmetryPair(h,hml);
-                int km = ibas_ab_sym[hkm][m][k];
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    int in = ibas_ab_sym[hkm][n][i];
-                    int lmn  = ibas_aba_sym[h][l][m][n];
-                    A_p[ijk_id + (trip_aab[h] + lmn)] -= u_p[d2aboff[hkm]+in*gems_ab[hkm]+km]; // -D2(in,km) djl
-                    A_p[offset + (trip_aab[h] + lmn)*(trip_aab[h]+trip_aba[h]) + ijk] -= u_p[d2aboff[hkm]+in*gems_ab[hkm]+km]; // -D2(in,km) djl
-                }
-            }
-        }
-        /*#pragma omp parallel for schedule (static)
-        for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
-
-            int i = bas_aab_sym[h][ijk][0];
-            int j = bas_aab_sym[h][ijk][1];
-            int k = bas_aab_sym[h][ijk][2];
-
-            for (int lmn = 0; lmn < trip_aba[h]; lmn++) {
-
-                int l = bas_aba_sym[h][lmn][0];
-                int m = bas_aba_sym[h][lmn][1];
-                int n = bas_aba_sym[h][lmn][2];
-
-                int id = ijk*(trip_aab[h]+trip_aba[h])+(lmn+trip_aab[h]);
-
-                double dum = 0.0;//-u_p[t2bbboff[h] + id]; // - T2(ijk,lmn)
-
-                if ( i == l ) {
-                    int hjn = SymmetryPair(symmetry[j],symmetry[n]);
-                    int jn = ibas_ab_sym[hjn][n][j];
-                    int km = ibas_ab_sym[hjn][m][k];
-                    dum += u_p[d2aboff[hjn]+jn*gems_ab[hjn]+km]; // D2(jn,km) dil
-                }
-                if ( j == l ) {
-                    int hin = SymmetryPair(symmetry[i],symmetry[n]);
-                    int in = ibas_ab_sym[hin][n][i];
-                    int km = ibas_ab_sym[hin][m][k];
-                    dum -= u_p[d2aboff[hin]+in*gems_ab[hin]+km]; // -D2(in,km) djl
-                }
-
-                A_p[offset + id] = dum;
-
-            }
-        }*/
-
-        // T2baa/bbb
-        /*#pragma omp parallel for schedule (static)
-        for (int ijk = 0; ijk < trip_aba[h]; ijk++) {
-
-            int i = bas_aba_sym[h][ijk][0];
-            int j = bas_aba_sym[h][ijk][1];
-            int k = bas_aba_sym[h][ijk][2];
-
-            for (int lmn = 0; lmn < trip_aab[h]; lmn++) {
-
-                int l = bas_aab_sym[h][lmn][0];
-                int m = bas_aab_sym[h][lmn][1];
-                int n = bas_aab_sym[h][lmn][2];
-
-                int id = (ijk+trip_aab[h])*(trip_aab[h]+trip_aba[h])+lmn;
-
-                double dum = 0.0;//-u_p[t2bbboff[h] + id]; // - T2(ijk,lmn)
-
-                if ( i == l ) {
-                    int hjn = SymmetryPair(symmetry[j],symmetry[n]);
-                    int jn = ibas_ab_sym[hjn][j][n];
-                    int km = ibas_ab_sym[hjn][k][m];
-                    dum += u_p[d2aboff[hjn]+jn*gems_ab[hjn]+km]; // D2(jn,km) dil
-                }
-                if ( i == m ) {
-                    int hnj = SymmetryPair(symmetry[j],symmetry[n]);
-                    int nj = ibas_ab_sym[hnj][j][n];
-                    int lk = ibas_ab_sym[hnj][k][l];
-                    dum -= u_p[d2aboff[hnj]+nj*gems_ab[hnj]+lk]; // -D2(in,km) djl
-                }
-
-                A_p[offset + id] = dum;
-
-            }
-        }*/
-        // T2baa/baa
-        #pragma omp parallel for schedule (static)
-        for (int ijk = 0; ijk < trip_aba[h]; ijk++) {
-
-            int i = bas_aba_sym[h][ijk][0];
-            int j = bas_aba_sym[h][ijk][1];
-            int k = bas_aba_sym[h][ijk][2];
-
-            for (int lmn = 0; lmn < trip_aba[h]; lmn++) {
-
-                int l = bas_aba_sym[h][lmn][0];
-                int m = bas_aba_sym[h][lmn][1];
-                int n = bas_aba_sym[h][lmn][2];
-
-                int id = (ijk+trip_aab[h])*(trip_aab[h]+trip_aba[h])+(lmn+trip_aab[h]);
-
-                double dum = 0.0;//-u_p[t2bbboff[h] + id]; // - T2(ijk,lmn)
-
-                if ( k == n ) {
-                    int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_ab_sym[hij][j][i];
-                    int lm = ibas_ab_sym[hij][m][l];
-                    dum += u_p[d2aboff[hij] + ij*gems_ab[hij]+lm]; // + D2(ij,lm) dkn
-                }
-
-                if ( j == m && i == l ) {
-                    int h2 = symmetry[k];
-                    int kk = k - pitzer_offset[h2];
-                    int nn = n - pitzer_offset[h2];
-                    dum += u_p[d1aoff[h2] + nn*amopi_[h2]+kk]; // + D1(n,k) djm dil
-                }
-
-                if ( i == l ) {
-                    if ( n != j && k != m ) {
-                        int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int km = ibas_aa_sym[hnj][k][m];
-
-                        int s = 1;
-                        if ( n > j ) s = -s;
-                        if ( k > m ) s = -s;
-
-                        dum -= s * u_p[d2aaoff[hnj] + nj*gems_aa[hnj]+km]; // - D2(nj,km) dil
-                    }
-                }
-                if ( j == m ) {
-                    int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int kl = ibas_ab_sym[hni][k][l];
-                    dum -= u_p[d2aboff[hni] + ni*gems_ab[hni]+kl]; // -D2(ni,kl) djm
-                }
-    
-                A_p[offset + id] = dum;
-
-            }
-        }
-        C_DAXPY((trip_aba[h] + trip_aab[h]) * (trip_aba[h] + trip_aab[h]), -1.0, &u_p[t2bbboff[h]],1,&A_p[offset],1);
-
-        offset += (trip_aba[h]+trip_aab[h])*(trip_aba[h]+trip_aab[h]);
-        //offset += trip_aab[h]*trip_aab[h];
-    }
-#endif
-
-}
-// T2 portion of A.u (slow version!)
-void v2RDMSolver::T2_constraints_Au_slow(SharedVector A,SharedVector u){
-
-    double * A_p = A->pointer();
-    double * u_p = u->pointer();
-
-    // T2aab
-    for (int h = 0; h < nirrep_; h++) {
-
-        #pragma omp parallel for schedule (static)
-        for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
-
-            int i = bas_aab_sym[h][ijk][0];
-            int j = bas_aab_sym[h][ijk][1];
-            int k = bas_aab_sym[h][ijk][2];
-
-            for (int lmn = 0; lmn < trip_aab[h]; lmn++) {
-
-                int l = bas_aab_sym[h][lmn][0];
-                int m = bas_aab_sym[h][lmn][1];
-                int n = bas_aab_sym[h][lmn][2];
-
-                double dum = -u_p[t2aaboff[h] + ijk*trip_aab[h]+lmn]; // - T2(ijk,lmn)
-
-                if ( k == n ) {
-                    int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
-                    dum += u_p[d2aaoff[hij] + ij*gems_aa[hij]+lm]; // + D2(ij,lm) dkn
-                }
-
-                if ( j == m && i == l ) {
-                    int h2 = symmetry[k];
-                    int kk = k - pitzer_offset[h2];
-                    int nn = n - pitzer_offset[h2];
-                    dum += u_p[d1boff[h2] + nn*amopi_[h2]+kk]; // + D1(n,k) djm dil
-                }
-                if ( j == l && i == m ) {
-                    int h2 = symmetry[k];
-                    int kk = k - pitzer_offset[h2];
-                    int nn = n - pitzer_offset[h2];
-                    dum -= u_p[d1boff[h2] + nn*amopi_[h2]+kk]; // - D1(n,k) djl dim
-                }
-
-                if ( i == l ) {
-                    int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                    int nj = ibas_ab_sym[hnj][j][n];
-                    int km = ibas_ab_sym[hnj][m][k];
-                    dum -= u_p[d2aboff[hnj] + nj*gems_ab[hnj]+km]; // - D2(nj,km) dil
-                }
-                if ( j == l ) {
-                    int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][i][n];
-                    int km = ibas_ab_sym[hni][m][k];
-                    dum += u_p[d2aboff[hni] + ni*gems_ab[hni]+km]; // D2(ni,km) djl
-                }
-                if ( i == m ) {
-                    int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                    int nj = ibas_ab_sym[hnj][j][n];
-                    int kl = ibas_ab_sym[hnj][l][k];
-                    dum += u_p[d2aboff[hnj] + nj*gems_ab[hnj]+kl]; // D2(nj,kl) dim
-                }
-                if ( j == m ) {
-                    int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][i][n];
-                    int kl = ibas_ab_sym[hni][l][k];
-                    dum -= u_p[d2aboff[hni] + ni*gems_ab[hni]+kl]; // -D2(ni,kl) djm
-                }
-    
-                A_p[offset + ijk*trip_aab[h]+lmn] = dum;
-
-            }
-        }
-        offset += trip_aab[h]*trip_aab[h];
-    }
-
-    // T2bba
-    for (int h = 0; h < nirrep_; h++) {
-
-        #pragma omp parallel for schedule (static)
-        for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
-
-            int i = bas_aab_sym[h][ijk][0];
-            int j = bas_aab_sym[h][ijk][1];
-            int k = bas_aab_sym[h][ijk][2];
-
-            for (int lmn = 0; lmn < trip_aab[h]; lmn++) {
-
-                int l = bas_aab_sym[h][lmn][0];
-                int m = bas_aab_sym[h][lmn][1];
-                int n = bas_aab_sym[h][lmn][2];
-
-                double dum = -u_p[t2bbaoff[h] + ijk*trip_aab[h]+lmn]; // - T2(ijk,lmn)
-
-                if ( k == n ) {
-                    int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
-                    dum += u_p[d2bboff[hij] + ij*gems_aa[hij]+lm]; // + D2(ij,lm) dkn
-                }
-
-                if ( j == m && i == l ) {
-                    int h2 = symmetry[k];
-                    int kk = k - pitzer_offset[h2];
-                    int nn = n - pitzer_offset[h2];
-                    dum += u_p[d1aoff[h2] + nn*amopi_[h2]+kk]; // + D1(n,k) djm dil
-                }
-                if ( j == l && i == m ) {
-                    int h2 = symmetry[k];
-                    int kk = k - pitzer_offset[h2];
-                    int nn = n - pitzer_offset[h2];
-                    dum -= u_p[d1aoff[h2] + nn*amopi_[h2]+kk]; // - D1(n,k) djl dim
-                }
-
-                if ( i == l ) {
-                    int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                    int nj = ibas_ab_sym[hnj][n][j];
-                    int km = ibas_ab_sym[hnj][k][m];
-                    dum -= u_p[d2aboff[hnj] + nj*gems_ab[hnj]+km]; // - D2(nj,km) dil
-                }
-                if ( j == l ) {
-                    int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int km = ibas_ab_sym[hni][k][m];
-                    dum += u_p[d2aboff[hni] + ni*gems_ab[hni]+km]; // D2(ni,km) djl
-                }
-                if ( i == m ) {
-                    int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                    int nj = ibas_ab_sym[hnj][n][j];
-                    int kl = ibas_ab_sym[hnj][k][l];
-                    dum += u_p[d2aboff[hnj] + nj*gems_ab[hnj]+kl]; // D2(nj,kl) dim
-                }
-                if ( j == m ) {
-                    int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int kl = ibas_ab_sym[hni][k][l];
-                    dum -= u_p[d2aboff[hni] + ni*gems_ab[hni]+kl]; // -D2(ni,kl) djm
-                }
-    
-                A_p[offset + ijk*trip_aab[h]+lmn] = dum;
-
-            }
-        }
-        offset += trip_aab[h]*trip_aab[h];
-    }
-
-    // big block 1: T2aaa + T2abb
-#if 1
-    for (int h = 0; h < nirrep_; h++) {
-
-        // T2aaa/aaa
-        #pragma omp parallel for schedule (static)
-        for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
-
-            int i = bas_aab_sym[h][ijk][0];
-            int j = bas_aab_sym[h][ijk][1];
-            int k = bas_aab_sym[h][ijk][2];
-
-            for (int lmn = 0; lmn < trip_aab[h]; lmn++) {
-
-                int l = bas_aab_sym[h][lmn][0];
-                int m = bas_aab_sym[h][lmn][1];
-                int n = bas_aab_sym[h][lmn][2];
-
-                int id = ijk*(trip_aab[h]+trip_aba[h])+lmn;
-                //int id = ijk*trip_aab[h]+lmn;
-
-                double dum = -u_p[t2aaaoff[h] + id]; // - T2(ijk,lmn)
-
-                if ( k == n ) {
-                    int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
-                    dum += u_p[d2aaoff[hij] + ij*gems_aa[hij]+lm]; // + D2(ij,lm) dkn
-                }
-
-                if ( j == m && i == l ) {
-                    int h2 = symmetry[k];
-                    int kk = k - pitzer_offset[h2];
-                    int nn = n - pitzer_offset[h2];
-                    dum += u_p[d1aoff[h2] + nn*amopi_[h2]+kk]; // + D1(n,k) djm dil
-                }
-                if ( j == l && i == m ) {
-                    int h2 = symmetry[k];
-                    int kk = k - pitzer_offset[h2];
-                    int nn = n - pitzer_offset[h2];
-                    dum -= u_p[d1aoff[h2] + nn*amopi_[h2]+kk]; // - D1(n,k) djl dim
-                }
-
-                if ( i == l ) {
-                    if ( n != j && k != m ) {
-                        int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int km = ibas_aa_sym[hnj][k][m];
-
-                        int s = 1;
-                        if ( n > j ) s = -s;
-                        if ( k > m ) s = -s;
-
-                        dum -= s * u_p[d2aaoff[hnj] + nj*gems_aa[hnj]+km]; // - D2(nj,km) dil
-                    }
-                }
-                if ( j == l ) {
-                    if ( n != i && k != m ) {
-                        int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                        int ni = ibas_aa_sym[hni][n][i];
-                        int km = ibas_aa_sym[hni][k][m];
-
-                        int s = 1;
-                        if ( n > i ) s = -s;
-                        if ( k > m ) s = -s;
-
-                        dum += s * u_p[d2aaoff[hni] + ni*gems_aa[hni]+km]; // D2(ni,km) djl
-                    }
-                }
-                if ( i == m ) {
-                    if ( n != j && k != l ) {
-                        int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int kl = ibas_aa_sym[hnj][k][l];
-
-                        int s = 1;
-                        if ( n > j ) s = -s;
-                        if ( k > l ) s = -s;
-
-                        dum += s * u_p[d2aaoff[hnj] + nj*gems_aa[hnj]+kl]; // D2(nj,kl) dim
-                    }
-                }
-                if ( j == m ) {
-                    if ( n != i && k != l ) {
-                        int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                        int ni = ibas_aa_sym[hni][n][i];
-                        int kl = ibas_aa_sym[hni][k][l];
-
-                        int s = 1;
-                        if ( n > i ) s = -s;
-                        if ( k > l ) s = -s;
-
-                        dum -= s * u_p[d2aaoff[hni] + ni*gems_aa[hni]+kl]; // -D2(ni,kl) djm
-                    }
-                }
-    
-                A_p[offset + id] = dum;
-
-            }
-        }
-        // T2aaa/abb
-        #pragma omp parallel for schedule (static)
-        for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
-
-            int i = bas_aab_sym[h][ijk][0];
-            int j = bas_aab_sym[h][ijk][1];
-            int k = bas_aab_sym[h][ijk][2];
-
-            for (int lmn = 0; lmn < trip_aba[h]; lmn++) {
-
-                int l = bas_aba_sym[h][lmn][0];
-                int m = bas_aba_sym[h][lmn][1];
-                int n = bas_aba_sym[h][lmn][2];
-
-                int id = ijk*(trip_aab[h]+trip_aba[h])+(lmn+trip_aab[h]);
-
-                double dum = -u_p[t2aaaoff[h] + id]; // - T2(ijk,lmn)
-
-                if ( i == l ) {
-                    int hjn = SymmetryPair(symmetry[j],symmetry[n]);
-                    int jn = ibas_ab_sym[hjn][j][n];
-                    int km = ibas_ab_sym[hjn][k][m];
-                    dum += u_p[d2aboff[hjn]+jn*gems_ab[hjn]+km]; // D2(jn,km) dil
-                }
-                if ( j == l ) {
-                    int hin = SymmetryPair(symmetry[i],symmetry[n]);
-                    int in = ibas_ab_sym[hin][i][n];
-                    int km = ibas_ab_sym[hin][k][m];
-                    dum -= u_p[d2aboff[hin]+in*gems_ab[hin]+km]; // -D2(in,km) djl
-                }
-
-                A_p[offset + id] = dum;
-
-            }
-        }
-
-        // T2abb/aaa
-        #pragma omp parallel for schedule (static)
-        for (int ijk = 0; ijk < trip_aba[h]; ijk++) {
-
-            int i = bas_aba_sym[h][ijk][0];
-            int j = bas_aba_sym[h][ijk][1];
-            int k = bas_aba_sym[h][ijk][2];
-
-            for (int lmn = 0; lmn < trip_aab[h]; lmn++) {
-
-                int l = bas_aab_sym[h][lmn][0];
-                int m = bas_aab_sym[h][lmn][1];
-                int n = bas_aab_sym[h][lmn][2];
-
-                int id = (ijk+trip_aab[h])*(trip_aab[h]+trip_aba[h])+lmn;
-
-                double dum = -u_p[t2aaaoff[h] + id]; // - T2(ijk,lmn)
-
-                if ( i == l ) {
-                    int hjn = SymmetryPair(symmetry[j],symmetry[n]);
-                    int jn = ibas_ab_sym[hjn][n][j];
-                    int km = ibas_ab_sym[hjn][m][k];
-                    dum += u_p[d2aboff[hjn]+jn*gems_ab[hjn]+km]; // D2(jn,km) dil
-                }
-                if ( i == m ) {
-                    int hnj = SymmetryPair(symmetry[j],symmetry[n]);
-                    int nj = ibas_ab_sym[hnj][n][j];
-                    int lk = ibas_ab_sym[hnj][l][k];
-                    dum -= u_p[d2aboff[hnj]+nj*gems_ab[hnj]+lk]; // -D2(in,km) djl
-                }
-
-                A_p[offset + id] = dum;
-
-            }
-        }
-
-        // T2abb/abb
-        #pragma omp parallel for schedule (static)
-        for (int ijk = 0; ijk < trip_aba[h]; ijk++) {
-
-            int i = bas_aba_sym[h][ijk][0];
-            int j = bas_aba_sym[h][ijk][1];
-            int k = bas_aba_sym[h][ijk][2];
-
-            for (int lmn = 0; lmn < trip_aba[h]; lmn++) {
-
-                int l = bas_aba_sym[h][lmn][0];
-                int m = bas_aba_sym[h][lmn][1];
-                int n = bas_aba_sym[h][lmn][2];
-
-                int id = (ijk+trip_aab[h])*(trip_aab[h]+trip_aba[h])+(lmn+trip_aab[h]);
-
-                double dum = -u_p[t2aaaoff[h] + id]; // - T2(ijk,lmn)
-
-                if ( k == n ) {
-                    int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_ab_sym[hij][i][j];
-                    int lm = ibas_ab_sym[hij][l][m];
-                    dum += u_p[d2aboff[hij] + ij*gems_ab[hij]+lm]; // + D2(ij,lm) dkn
-                }
-
-                if ( j == m && i == l ) {
-                    int h2 = symmetry[k];
-                    int kk = k - pitzer_offset[h2];
-                    int nn = n - pitzer_offset[h2];
-                    dum += u_p[d1boff[h2] + nn*amopi_[h2]+kk]; // + D1(n,k) djm dil
-                }
-
-                if ( i == l ) {
-                    if ( n != j && k != m ) {
-                        int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int km = ibas_aa_sym[hnj][k][m];
-
-                        int s = 1;
-                        if ( n > j ) s = -s;
-                        if ( k > m ) s = -s;
-
-                        dum -= s * u_p[d2bboff[hnj] + nj*gems_aa[hnj]+km]; // - D2(nj,km) dil
-                    }
-                }
-                if ( j == m ) {
-                    int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][i][n];
-                    int kl = ibas_ab_sym[hni][l][k];
-                    dum -= u_p[d2aboff[hni] + ni*gems_ab[hni]+kl]; // -D2(ni,kl) djm
-                }
-    
-                A_p[offset + id] = dum;
-
-            }
-        }
-        //C_DAXPY((trip_aba[h] + trip_aab[h]) * (trip_aba[h] + trip_aab[h]), -1.0, &u_p[t2aaaoff[h]],1,&A_p[offset],1);
-        offset += (trip_aba[h]+trip_aab[h])*(trip_aba[h]+trip_aab[h]);
-        //offset += trip_aab[h]*trip_aab[h];
-    }
-
-    // big block 2: T2bbb + T2baa
-    for (int h = 0; h < nirrep_; h++) {
-
-        // T2bbb/bbb
-        #pragma omp parallel for schedule (static)
-        for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
-
-            int i = bas_aab_sym[h][ijk][0];
-            int j = bas_aab_sym[h][ijk][1];
-            int k = bas_aab_sym[h][ijk][2];
-
-            for (int lmn = 0; lmn < trip_aab[h]; lmn++) {
-
-                int l = bas_aab_sym[h][lmn][0];
-                int m = bas_aab_sym[h][lmn][1];
-                int n = bas_aab_sym[h][lmn][2];
-
-                int id = ijk*(trip_aab[h]+trip_aba[h])+lmn;
-                //int id = ijk*trip_aab[h]+lmn;
-
-                double dum = -u_p[t2bbboff[h] + id]; // - T2(ijk,lmn)
-
-                if ( k == n ) {
-                    int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
-                    dum += u_p[d2bboff[hij] + ij*gems_aa[hij]+lm]; // + D2(ij,lm) dkn
-                }
-
-                if ( j == m && i == l ) {
-                    int h2 = symmetry[k];
-                    int kk = k - pitzer_offset[h2];
-                    int nn = n - pitzer_offset[h2];
-                    dum += u_p[d1boff[h2] + nn*amopi_[h2]+kk]; // + D1(n,k) djm dil
-                }
-                if ( j == l && i == m ) {
-                    int h2 = symmetry[k];
-                    int kk = k - pitzer_offset[h2];
-                    int nn = n - pitzer_offset[h2];
-                    dum -= u_p[d1boff[h2] + nn*amopi_[h2]+kk]; // - D1(n,k) djl dim
-                }
-
-                if ( i == l ) {
-                    if ( n != j && k != m ) {
-                        int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int km = ibas_aa_sym[hnj][k][m];
-
-                        int s = 1;
-                        if ( n > j ) s = -s;
-                        if ( k > m ) s = -s;
-
-                        dum -= s * u_p[d2bboff[hnj] + nj*gems_aa[hnj]+km]; // - D2(nj,km) dil
-                    }
-                }
-                if ( j == l ) {
-                    if ( n != i && k != m ) {
-                        int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                        int ni = ibas_aa_sym[hni][n][i];
-                        int km = ibas_aa_sym[hni][k][m];
-
-                        int s = 1;
-                        if ( n > i ) s = -s;
-                        if ( k > m ) s = -s;
-
-                        dum += s * u_p[d2bboff[hni] + ni*gems_aa[hni]+km]; // D2(ni,km) djl
-                    }
-                }
-                if ( i == m ) {
-                    if ( n != j && k != l ) {
-                        int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int kl = ibas_aa_sym[hnj][k][l];
-
-                        int s = 1;
-                        if ( n > j ) s = -s;
-                        if ( k > l ) s = -s;
-
-                        dum += s * u_p[d2bboff[hnj] + nj*gems_aa[hnj]+kl]; // D2(nj,kl) dim
-                    }
-                }
-                if ( j == m ) {
-                    if ( n != i && k != l ) {
-                        int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                        int ni = ibas_aa_sym[hni][n][i];
-                        int kl = ibas_aa_sym[hni][k][l];
-
-                        int s = 1;
-                        if ( n > i ) s = -s;
-                        if ( k > l ) s = -s;
-
-                        dum -= s * u_p[d2bboff[hni] + ni*gems_aa[hni]+kl]; // -D2(ni,kl) djm
-                    }
-                }
-    
-                A_p[offset + id] = dum;
+    double * myA_p = mapping == T2_ATU ? ATu_buffer_ + omp_get_thread_num() * dimx_d2q2g2_ : A_p;
 
+    long int row = rowoff + ijk * dim;
+
+    // - T2(ijk,lmn)
+    if ( !skip_t2 ) {
+        if ( mapping == T2_ATU ) {
+            C_DAXPY(dim,-1.0,u_p + row,1,A_p + t2off + ijk * dim,1);
+        }else if ( mapping == T2_AU ) {
+            C_DAXPY(dim,-1.0,u_p + t2off + ijk * dim,1,A_p + row,1);
+        }else {
+            for (long int lmn = 0; lmn < dim; lmn++) {
+                A_p[row + lmn] += 1.0;
             }
         }
-        // T2bbb/baa
-        #pragma omp parallel for schedule (static)
-        for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
-
-            int i = bas_aab_sym[h][ijk][0];
-            int j = bas_aab_sym[h][ijk][1];
-            int k = bas_aab_sym[h][ijk][2];
+    }
 
-            for (int lmn = 0; lmn < trip_aba[h]; lmn++) {
+    if ( ijk < trip_aab[h] ) {
 
-                int l = bas_aba_sym[h][lmn][0];
-                int m = bas_aba_sym[h][lmn][1];
-                int n = bas_aba_sym[h][lmn][2];
+        // aab rows
 
-                int id = ijk*(trip_aab[h]+trip_aba[h])+(lmn+trip_aab[h]);
+        int i = bas_aab_sym[h][ijk][0];
+        int j = bas_aab_sym[h][ijk][1];
+        int k = bas_aab_sym[h][ijk][2];
 
-                double dum = -u_p[t2bbboff[h] + id]; // - T2(ijk,lmn)
+        // aab/aab: + D2(ij,lm) dkn
+        int hij = sym.pair(sym.irrep(i),sym.irrep(j));
+        int ij  = ibas_aa(i,j);
+        for (int lm = 0; lm < gems_aa[hij]; lm++) {
+            int l = bas_aa_sym[hij][lm][0];
+            int m = bas_aa_sym[hij][lm][1];
+            int lmn = ibas_aab(l,m,k);
+            T2Accumulate(myA_p,u_p,row + lmn,d2off_same[hij] + ij*gems_aa[hij]+lm,1.0,mapping);
+        }
 
-                if ( i == l ) {
-                    int hjn = SymmetryPair(symmetry[j],symmetry[n]);
-                    int jn = ibas_ab_sym[hjn][n][j];
-                    int km = ibas_ab_sym[hjn][m][k];
-                    dum += u_p[d2aboff[hjn]+jn*gems_ab[hjn]+km]; // D2(jn,km) dil
-                }
-                if ( j == l ) {
-                    int hin = SymmetryPair(symmetry[i],symmetry[n]);
-                    int in = ibas_ab_sym[hin][n][i];
-                    int km = ibas_ab_sym[hin][m][k];
-                    dum -= u_p[d2aboff[hin]+in*gems_ab[hin]+km]; // -D2(in,km) djl
-                }
+        // aab/aab: + D1(n,k) djm dil
+        int hk = sym.irrep(k);
+        int kk = k - sym.offset(hk);
+        for (int n = sym.offset(hk); n < sym.offset(hk) + sym.size(hk); n++) {
+            int nn  = n - sym.offset(hk);
+            int lmn = ibas_aab(i,j,n);
+            T2Accumulate(myA_p,u_p,row + lmn,d1off_same[hk] + nn*sym.size(hk)+kk,1.0,mapping);
+        }
 
-                A_p[offset + id] = dum;
+        // aab/aab: - D2(nj,km) dil
+        for (int m = i + 1; m < amo_; m++) {
+            if ( k == m ) continue;
+            int hn = sym.pair(h,sym.pair(sym.irrep(i),sym.irrep(m)));
+            for (int n = sym.offset(hn); n < sym.offset(hn) + sym.size(hn); n++) {
+                if ( n == j ) continue;
+                int hnj = sym.pair(sym.irrep(n),sym.irrep(j));
+                int nj  = ibas_aa(n,j);
+                int km  = ibas_aa(k,m);
+                double s = ( n > j ) == ( k > m ) ? 1.0 : -1.0;
+                int lmn = ibas_aab(i,m,n);
+                T2Accumulate(myA_p,u_p,row + lmn,d2off_same[hnj] + nj*gems_aa[hnj]+km,-s,mapping);
+            }
+        }
 
+        // aab/aab: + D2(ni,km) djl
+        for (int m = j + 1; m < amo_; m++) {
+            if ( k == m ) continue;
+            int hn = sym.pair(h,sym.pair(sym.irrep(j),sym.irrep(m)));
+            for (int n = sym.offset(hn); n < sym.offset(hn) + sym.size(hn); n++) {
+                if ( n == i ) continue;
+                int hni = sym.pair(sym.irrep(n),sym.irrep(i));
+                int ni  = ibas_aa(n,i);
+                int km  = ibas_aa(k,m);
+                double s = ( n > i ) == ( k > m ) ? 1.0 : -1.0;
+                int lmn = ibas_aab(j,m,n);
+                T2Accumulate(myA_p,u_p,row + lmn,d2off_same[hni] + ni*gems_aa[hni]+km,s,mapping);
             }
         }
 
-        // T2baa/bbb
-        #pragma omp parallel for schedule (static)
-        for (int ijk = 0; ijk < trip_aba[h]; ijk++) {
+        // aab/aab: + D2(nj,kl) dim
+        for (int l = 0; l < i; l++) {
+            if ( k == l ) continue;
+            int hn = sym.pair(h,sym.pair(sym.irrep(i),sym.irrep(l)));
+            for (int n = sym.offset(hn); n < sym.offset(hn) + sym.size(hn); n++) {
+                if ( n == j ) continue;
+                int hnj = sym.pair(sym.irrep(n),sym.irrep(j));
+                int nj  = ibas_aa(n,j);
+                int kl  = ibas_aa(k,l);
+                double s = ( n > j ) == ( k > l ) ? 1.0 : -1.0;
+                int lmn = ibas_aab(l,i,n);
+                T2Accumulate(myA_p,u_p,row + lmn,d2off_same[hnj] + nj*gems_aa[hnj]+kl,s,mapping);
+            }
+        }
 
-            int i = bas_aba_sym[h][ijk][0];
-            int j = bas_aba_sym[h][ijk][1];
-            int k = bas_aba_sym[h][ijk][2];
+        // aab/aab: - D2(ni,kl) djm
+        for (int l = 0; l < j; l++) {
+            if ( k == l ) continue;
+            int hn = sym.pair(h,sym.pair(sym.irrep(j),sym.irrep(l)));
+            for (int n = sym.offset(hn); n < sym.offset(hn) + sym.size(hn); n++) {
+                if ( n == i ) continue;
+                int hni = sym.pair(sym.irrep(n),sym.irrep(i));
+                int ni  = ibas_aa(n,i);
+                int kl  = ibas_aa(k,l);
+                double s = ( n > i ) == ( k > l ) ? 1.0 : -1.0;
+                int lmn = ibas_aab(l,j,n);
+                T2Accumulate(myA_p,u_p,row + lmn,d2off_same[hni] + ni*gems_aa[hni]+kl,-s,mapping);
+            }
+        }
 
-            for (int lmn = 0; lmn < trip_aab[h]; lmn++) {
+        // aab/aba: + D2(jn,km) dil
+        for (int m = 0; m < amo_; m++) {
+            int hn = sym.pair(h,sym.pair(sym.irrep(i),sym.irrep(m)));
+            for (int n = sym.offset(hn); n < sym.offset(hn) + sym.size(hn); n++) {
+                int hjn = sym.pair(sym.irrep(j),sym.irrep(n));
+                int jn  = beta ? ibas_ab(n,j) : ibas_ab(j,n);
+                int km  = beta ? ibas_ab(m,k) : ibas_ab(k,m);
+                int lmn = trip_aab[h] + ibas_aba(i,m,n);
+                T2Accumulate(myA_p,u_p,row + lmn,d2aboff[hjn] + jn*gems_ab[hjn]+km,1.0,mapping);
+            }
+        }
 
-                int l = bas_aab_sym[h][lmn][0];
-                int m = bas_aab_sym[h][lmn][1];
-                int n = bas_aab_sym[h][lmn][2];
+        // aab/aba: - D2(in,km) djl
+        for (int m = 0; m < amo_; m++) {
+            int hn = sym.pair(h,sym.pair(sym.irrep(j),sym.irrep(m)));
+            for (int n = sym.offset(hn); n < sym.offset(hn) + sym.size(hn); n++) {
+                int hin = sym.pair(sym.irrep(i),sym.irrep(n));
+                int in  = beta ? ibas_ab(n,i) : ibas_ab(i,n);
+                int km  = beta ? ibas_ab(m,k) : ibas_ab(k,m);
+                int lmn = trip_aab[h] + ibas_aba(j,m,n);
+                T2Accumulate(myA_p,u_p,row + lmn,d2aboff[hin] + in*gems_ab[hin]+km,-1.0,mapping);
+            }
+        }
+    }else {
+
+        // aba rows
+        int i = bas_aba_sym[h][ijk - trip_aab[h]][0];
+        int j = bas_aba_sym[h][ijk - trip_aab[h]][1];
+        int k = bas_aba_sym[h][ijk - trip_aab[h]][2];
+
+        // aba/aab: + D2(jn,km) dil
+        for (int m = i + 1; m < amo_; m++) {
+            int hn = sym.pair(h,sym.pair(sym.irrep(i),sym.irrep(m)));
+            for (int n = sym.offset(hn); n < sym.offset(hn) + sym.size(hn); n++) {
+                int hjn = sym.pair(sym.irrep(j),sym.irrep(n));
+                int jn  = beta ? ibas_ab(j,n) : ibas_ab(n,j);
+                int km  = beta ? ibas_ab(k,m) : ibas_ab(m,k);
+                int lmn = ibas_aab(i,m,n);
+                T2Accumulate(myA_p,u_p,row + lmn,d2aboff[hjn] + jn*gems_ab[hjn]+km,1.0,mapping);
+            }
+        }
 
-                int id = (ijk+trip_aab[h])*(trip_aab[h]+trip_aba[h])+lmn;
+        // aba/aab: - D2(nj,lk) dim
+        for (int l = 0; l < i; l++) {
+            int hn = sym.pair(h,sym.pair(sym.irrep(i),sym.irrep(l)));
+            for (int n = sym.offset(hn); n < sym.offset(hn) + sym.size(hn); n++) {
+                int hnj = sym.pair(sym.irrep(j),sym.irrep(n));
+                int nj  = beta ? ibas_ab(j,n) : ibas_ab(n,j);
+                int lk  = beta ? ibas_ab(k,l) : ibas_ab(l,k);
+                int lmn = ibas_aab(l,i,n);
+                T2Accumulate(myA_p,u_p,row + lmn,d2aboff[hnj] + nj*gems_ab[hnj]+lk,-1.0,mapping);
+            }
+        }
 
-                double dum = -u_p[t2bbboff[h] + id]; // - T2(ijk,lmn)
+        // aba/aba: + D2(ij,lm) dkn
+        int hij = sym.pair(sym.irrep(i),sym.irrep(j));
+        int ij  = beta ? ibas_ab(j,i) : ibas_ab(i,j);
+        for (int lm = 0; lm < gems_ab[hij]; lm++) {
+            int l = beta ? bas_ab_sym[hij][lm][1] : bas_ab_sym[hij][lm][0];
+            int m = beta ? bas_ab_sym[hij][lm][0] : bas_ab_sym[hij][lm][1];
+            int lmn = trip_aab[h] + ibas_aba(l,m,k);
+            T2Accumulate(myA_p,u_p,row + lmn,d2aboff[hij] + ij*gems_ab[hij]+lm,1.0,mapping);
+        }
 
-                if ( i == l ) {
-                    int hjn = SymmetryPair(symmetry[j],symmetry[n]);
-                    int jn = ibas_ab_sym[hjn][j][n];
-                    int km = ibas_ab_sym[hjn][k][m];
-                    dum += u_p[d2aboff[hjn]+jn*gems_ab[hjn]+km]; // D2(jn,km) dil
-                }
-                if ( i == m ) {
-                    int hnj = SymmetryPair(symmetry[j],symmetry[n]);
-                    int nj = ibas_ab_sym[hnj][j][n];
-                    int lk = ibas_ab_sym[hnj][k][l];
-                    dum -= u_p[d2aboff[hnj]+nj*gems_ab[hnj]+lk]; // -D2(in,km) djl
-                }
+        // aba/aba: + D1(n,k) djm dil
+        int hk = sym.irrep(k);
+        int kk = k - sym.offset(hk);
+        for (int n = sym.offset(hk); n < sym.offset(hk) + sym.size(hk); n++) {
+            int nn  = n - sym.offset(hk);
+            int lmn = trip_aab[h] + ibas_aba(i,j,n);
+            T2Accumulate(myA_p,u_p,row + lmn,d1off_other[hk] + nn*sym.size(hk)+kk,1.0,mapping);
+        }
 
-                A_p[offset + id] = dum;
+        // aba/aba: - D2(nj,km) dil
+        for (int m = 0; m < amo_; m++) {
+            if ( k == m ) continue;
+            int hn = sym.pair(h,sym.pair(sym.irrep(i),sym.irrep(m)));
+            for (int n = sym.offset(hn); n < sym.offset(hn) + sym.size(hn); n++) {
+                if ( n == j ) continue;
+                int hnj = sym.pair(sym.irrep(n),sym.irrep(j));
+                int nj  = ibas_aa(n,j);
+                int km  = ibas_aa(k,m);
+                double s = ( n > j ) == ( k > m ) ? 1.0 : -1.0;
+                int lmn = trip_aab[h] + ibas_aba(i,m,n);
+                T2Accumulate(myA_p,u_p,row + lmn,d2off_other[hnj] + nj*gems_aa[hnj]+km,-s,mapping);
+            }
+        }
 
+        // aba/aba: - D2(ni,kl) djm
+        for (int l = 0; l < amo_; l++) {
+            int hn = sym.pair(h,sym.pair(sym.irrep(j),sym.irrep(l)));
+            for (int n = sym.offset(hn); n < sym.offset(hn) + sym.size(hn); n++) {
+                int hni = sym.pair(sym.irrep(n),sym.irrep(i));
+                int ni  = beta ? ibas_ab(n,i) : ibas_ab(i,n);
+                int kl  = beta ? ibas_ab(k,l) : ibas_ab(l,k);
+                int lmn = trip_aab[h] + ibas_aba(l,j,n);
+                T2Accumulate(myA_p,u_p,row + lmn,d2aboff[hni] + ni*gems_ab[hni]+kl,-1.0,mapping);
             }
         }
-        // T2baa/baa
-        #pragma omp parallel for schedule (static)
-        for (int ijk = 0; ijk < trip_aba[h]; ijk++) {
+    }
+}
 
-            int i = bas_aba_sym[h][ijk][0];
-            int j = bas_aba_sym[h][ijk][1];
-            int k = bas_aba_sym[h][ijk][2];
+// T2 portion of A.u
+template <class Symmetry>
+void v2RDMSolver::T2_constraints_Au_kernel(SharedVector A,SharedVector u,const SkippedBlocks & skip){
 
-            for (int lmn = 0; lmn < trip_aba[h]; lmn++) {
+    Symmetry sym(nirrep_,symmetry,pitzer_offset,amopi_,table);
 
-                int l = bas_aba_sym[h][lmn][0];
-                int m = bas_aba_sym[h][lmn][1];
-                int n = bas_aba_sym[h][lmn][2];
+    double * A_p = A->pointer();
+    double * u_p = u->pointer();
 
-                int id = (ijk+trip_aab[h])*(trip_aab[h]+trip_aba[h])+(lmn+trip_aab[h]);
+    // T2aab
+    for (int h = 0; h < sym.nirrep(); h++) {
+        T2_constraints_aab_terms<Symmetry>(sym,A_p,u_p,h,offset,t2aaboff[h],false,T2_AU,skip.t2);
+        offset += trip_aab[h]*trip_aab[h];
+    }
 
-                double dum = -u_p[t2bbboff[h] + id]; // - T2(ijk,lmn)
+    // T2bba
+    for (int h = 0; h < sym.nirrep(); h++) {
+        T2_constraints_aab_terms<Symmetry>(sym,A_p,u_p,h,offset,t2bbaoff[h],true,T2_AU,skip.t2);
+        offset += trip_aab[h]*trip_aab[h];
+    }
 
-                if ( k == n ) {
-                    int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_ab_sym[hij][j][i];
-                    int lm = ibas_ab_sym[hij][m][l];
-                    dum += u_p[d2aboff[hij] + ij*gems_ab[hij]+lm]; // + D2(ij,lm) dkn
-                }
+    // big block 1: T2aaa + T2abb
+    for (int h = 0; h < sym.nirrep(); h++) {
+        T2_constraints_aaa_terms<Symmetry>(sym,A_p,u_p,h,offset,t2aaaoff[h],false,T2_AU,skip.t2);
+        offset += (trip_aba[h]+trip_aab[h])*(trip_aba[h]+trip_aab[h]);
+    }
 
-                if ( j == m && i == l ) {
-                    int h2 = symmetry[k];
-                    int kk = k - pitzer_offset[h2];
-                    int nn = n - pitzer_offset[h2];
-                    dum += u_p[d1aoff[h2] + nn*amopi_[h2]+kk]; // + D1(n,k) djm dil
-                }
+    // big block 2: T2bbb + T2baa
+    for (int h = 0; h < sym.nirrep(); h++) {
+        T2_constraints_aaa_terms<Symmetry>(sym,A_p,u_p,h,offset,t2bbboff[h],true,T2_AU,skip.t2);
+        offset += (trip_aba[h]+trip_aab[h])*(trip_aba[h]+trip_aab[h]);
+    }
 
-                if ( i == l ) {
-                    if ( n != j && k != m ) {
-                        int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int km = ibas_aa_sym[hnj][k][m];
+}
 
-                        int s = 1;
-                        if ( n > j ) s = -s;
-                        if ( k > m ) s = -s;
+void v2RDMSolver::T2_constraints_Au(SharedVector A,SharedVector u){
+    (this->*T2_constraints_Au_fn_)(A,u,SkippedBlocks());
+}
 
-                        dum -= s * u_p[d2aaoff[hnj] + nj*gems_aa[hnj]+km]; // - D2(nj,km) dil
-                    }
-                }
-                if ( j == m ) {
-                    int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int kl = ibas_ab_sym[hni][k][l];
-                    dum -= u_p[d2aboff[hni] + ni*gems_ab[hni]+kl]; // -D2(ni,kl) djm
-                }
-    
-                A_p[offset + id] = dum;
+void v2RDMSolver::T2_constraints_Au(SharedVector A,SharedVector u,const SkippedBlocks & skip){
+    (this->*T2_constraints_Au_fn_)(A,u,skip);
+}
+
+// T2 portion of diag(A.A^T).  the T2 rows of d must be zero on entry.
+void v2RDMSolver::T2_constraints_AAT_diagonal(double * d){
 
+    PointGroupSymmetry sym(nirrep_,symmetry,pitzer_offset,amopi_,table);
+
+    #pragma omp parallel
+    {
+        #pragma omp single
+        {
+            for (int h = 0; h < nirrep_; h++) {
+                T2_constraints_aab_terms<PointGroupSymmetry>(sym,d,NULL,h,offset,t2aaboff[h],false,T2_AAT_DIAGONAL,false);
+                offset += trip_aab[h]*trip_aab[h];
+            }
+            for (int h = 0; h < nirrep_; h++) {
+                T2_constraints_aab_terms<PointGroupSymmetry>(sym,d,NULL,h,offset,t2bbaoff[h],true,T2_AAT_DIAGONAL,false);
+                offset += trip_aab[h]*trip_aab[h];
+            }
+            for (int h = 0; h < nirrep_; h++) {
+                T2_constraints_aaa_terms<PointGroupSymmetry>(sym,d,NULL,h,offset,t2aaaoff[h],false,T2_AAT_DIAGONAL,false);
+                offset += (trip_aba[h]+trip_aab[h])*(trip_aba[h]+trip_aab[h]);
+            }
+            for (int h = 0; h < nirrep_; h++) {
+                T2_constraints_aaa_terms<PointGroupSymmetry>(sym,d,NULL,h,offset,t2bbboff[h],true,T2_AAT_DIAGONAL,false);
+                offset += (trip_aba[h]+trip_aab[h])*(trip_aba[h]+trip_aab[h]);
             }
         }
-        //C_DAXPY((trip_aba[h] + trip_aab[h]) * (trip_aba[h] + trip_aab[h]), -1.0, &u_p[t2bbboff[h]],1,&A_p[offset],1);
-        offset += (trip_aba[h]+trip_aab[h])*(trip_aba[h]+trip_aab[h]);
-        //offset += trip_aab[h]*trip_aab[h];
     }
-#endif
+}
+// compare fast T2 mappings to the slow reference implementation.  if they
+// disagree, fall back to the slow mappings
+void v2RDMSolver::CheckT2Constraints(){
+
+    SharedVector u  (new Vector("u",dimx_));
+    SharedVector v  (new Vector("v",nconstraints_));
+    SharedVector Au1(new Vector("Au",nconstraints_));
+    SharedVector Au2(new Vector("Au",nconstraints_));
+    SharedVector ATv1(new Vector("ATv",dimx_));
+    SharedVector ATv2(new Vector("ATv",dimx_));
+
+    double * u_p = u->pointer();
+    double * v_p = v->pointer();
+
+    srand(0);
+    for (long int i = 0; i < dimx_; i++) {
+        u_p[i] = ( (double)rand()/RAND_MAX - 0.5 ) * 2.0;
+    }
+    for (long int i = 0; i < nconstraints_; i++) {
+        v_p[i] = ( (double)rand()/RAND_MAX - 0.5 ) * 2.0;
+    }
+
+    bpsdp_Au(Au1,u);
+    bpsdp_Au_slow(Au2,u);
+    bpsdp_ATu(ATv1,v);
+    bpsdp_ATu_slow(ATv2,v);
 
+    double * Au1_p  = Au1->pointer();
+    double * Au2_p  = Au2->pointer();
+    double * ATv1_p = ATv1->pointer();
+    double * ATv2_p = ATv2->pointer();
+
+    double max_Au = 0.0;
+    for (long int i = 0; i < nconstraints_; i++) {
+        double dum = fabs(Au1_p[i] - Au2_p[i]);
+        if ( dum > max_Au ) max_Au = dum;
+    }
+    double max_ATu = 0.0;
+    for (long int i = 0; i < dimx_; i++) {
+        double dum = fabs(ATv1_p[i] - ATv2_p[i]);
+        if ( dum > max_ATu ) max_ATu = dum;
+    }
+
+    outfile->Printf("\n");
+    outfile->Printf("        Check fast T2 mappings against reference:\n");
+    outfile->Printf("        max |A.u   (fast) - A.u   (slow)|: %10.3le\n",max_Au);
+    outfile->Printf("        max |A^T.u (fast) - A^T.u (slow)|: %10.3le\n",max_ATu);
+    outfile->Printf("\n");
+
+    if ( max_Au > 1e-10 || max_ATu > 1e-10 ) {
+        outfile->Printf("        Fast T2 mappings failed check.  Falling back to slow mappings.\n");
+        outfile->Printf("\n");
+        fast_t2_ = false;
+    }
 }
-// T2 guess
-void v2RDMSolver::T2_constraints_guess(SharedVector u){
 
+// T2 portion of A.u (slow version!)
+void v2RDMSolver::T2_constraints_Au_slow(SharedVector A,SharedVector u){
+
+    double * A_p = A->pointer();
     double * u_p = u->pointer();
 
     // T2aab
     for (int h = 0; h < nirrep_; h++) {
 
-        #pragma omp parallel for schedule (static)
+        long int myoffset = offset;
+        #pragma omp taskloop nogroup
         for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
 
             int i = bas_aab_sym[h][ijk][0];
@@ -1880,12 +595,12 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
                 int m = bas_aab_sym[h][lmn][1];
                 int n = bas_aab_sym[h][lmn][2];
 
-                double dum = 0.0;//-u_p[t2aaboff[h] + ijk*trip_aab[h]+lmn]; // - T2(ijk,lmn)
+                double dum = -u_p[t2aaboff[h] + ijk*trip_aab[h]+lmn]; // - T2(ijk,lmn)
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
                     dum += u_p[d2aaoff[hij] + ij*gems_aa[hij]+lm]; // + D2(ij,lm) dkn
                 }
 
@@ -1904,30 +619,30 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
 
                 if ( i == l ) {
                     int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                    int nj = ibas_ab_sym[hnj][j][n];
-                    int km = ibas_ab_sym[hnj][m][k];
+                    int nj = ibas_ab(j,n);
+                    int km = ibas_ab(m,k);
                     dum -= u_p[d2aboff[hnj] + nj*gems_ab[hnj]+km]; // - D2(nj,km) dil
                 }
                 if ( j == l ) {
                     int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][i][n];
-                    int km = ibas_ab_sym[hni][m][k];
+                    int ni = ibas_ab(i,n);
+                    int km = ibas_ab(m,k);
                     dum += u_p[d2aboff[hni] + ni*gems_ab[hni]+km]; // D2(ni,km) djl
                 }
                 if ( i == m ) {
                     int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                    int nj = ibas_ab_sym[hnj][j][n];
-                    int kl = ibas_ab_sym[hnj][l][k];
+                    int nj = ibas_ab(j,n);
+                    int kl = ibas_ab(l,k);
                     dum += u_p[d2aboff[hnj] + nj*gems_ab[hnj]+kl]; // D2(nj,kl) dim
                 }
                 if ( j == m ) {
                     int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][i][n];
-                    int kl = ibas_ab_sym[hni][l][k];
+                    int ni = ibas_ab(i,n);
+                    int kl = ibas_ab(l,k);
                     dum -= u_p[d2aboff[hni] + ni*gems_ab[hni]+kl]; // -D2(ni,kl) djm
                 }
     
-                u_p[t2aaboff[h] + ijk*trip_aab[h]+lmn] = dum; // - T2(ijk,lmn)
+                A_p[myoffset + ijk*trip_aab[h]+lmn] = dum;
 
             }
         }
@@ -1937,7 +652,8 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
     // T2bba
     for (int h = 0; h < nirrep_; h++) {
 
-        #pragma omp parallel for schedule (static)
+        long int myoffset = offset;
+        #pragma omp taskloop nogroup
         for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
 
             int i = bas_aab_sym[h][ijk][0];
@@ -1950,12 +666,12 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
                 int m = bas_aab_sym[h][lmn][1];
                 int n = bas_aab_sym[h][lmn][2];
 
-                double dum = 0.0;//-u_p[t2bbaoff[h] + ijk*trip_aab[h]+lmn]; // - T2(ijk,lmn)
+                double dum = -u_p[t2bbaoff[h] + ijk*trip_aab[h]+lmn]; // - T2(ijk,lmn)
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
                     dum += u_p[d2bboff[hij] + ij*gems_aa[hij]+lm]; // + D2(ij,lm) dkn
                 }
 
@@ -1974,30 +690,30 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
 
                 if ( i == l ) {
                     int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                    int nj = ibas_ab_sym[hnj][n][j];
-                    int km = ibas_ab_sym[hnj][k][m];
+                    int nj = ibas_ab(n,j);
+                    int km = ibas_ab(k,m);
                     dum -= u_p[d2aboff[hnj] + nj*gems_ab[hnj]+km]; // - D2(nj,km) dil
                 }
                 if ( j == l ) {
                     int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int km = ibas_ab_sym[hni][k][m];
+                    int ni = ibas_ab(n,i);
+                    int km = ibas_ab(k,m);
                     dum += u_p[d2aboff[hni] + ni*gems_ab[hni]+km]; // D2(ni,km) djl
                 }
                 if ( i == m ) {
                     int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                    int nj = ibas_ab_sym[hnj][n][j];
-                    int kl = ibas_ab_sym[hnj][k][l];
+                    int nj = ibas_ab(n,j);
+                    int kl = ibas_ab(k,l);
                     dum += u_p[d2aboff[hnj] + nj*gems_ab[hnj]+kl]; // D2(nj,kl) dim
                 }
                 if ( j == m ) {
                     int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int kl = ibas_ab_sym[hni][k][l];
+                    int ni = ibas_ab(n,i);
+                    int kl = ibas_ab(k,l);
                     dum -= u_p[d2aboff[hni] + ni*gems_ab[hni]+kl]; // -D2(ni,kl) djm
                 }
     
-                u_p[t2bbaoff[h] + ijk*trip_aab[h]+lmn] = dum; // - T2(ijk,lmn)
+                A_p[myoffset + ijk*trip_aab[h]+lmn] = dum;
 
             }
         }
@@ -2009,7 +725,8 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
     for (int h = 0; h < nirrep_; h++) {
 
         // T2aaa/aaa
-        #pragma omp parallel for schedule (static)
+        long int myoffset = offset;
+        #pragma omp taskloop nogroup
         for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
 
             int i = bas_aab_sym[h][ijk][0];
@@ -2025,12 +742,12 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
                 int id = ijk*(trip_aab[h]+trip_aba[h])+lmn;
                 //int id = ijk*trip_aab[h]+lmn;
 
-                double dum = 0.0;//-u_p[t2aaaoff[h] + id]; // - T2(ijk,lmn)
+                double dum = -u_p[t2aaaoff[h] + id]; // - T2(ijk,lmn)
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
                     dum += u_p[d2aaoff[hij] + ij*gems_aa[hij]+lm]; // + D2(ij,lm) dkn
                 }
 
@@ -2050,8 +767,8 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
                 if ( i == l ) {
                     if ( n != j && k != m ) {
                         int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int km = ibas_aa_sym[hnj][k][m];
+                        int nj = ibas_aa(n,j);
+                        int km = ibas_aa(k,m);
 
                         int s = 1;
                         if ( n > j ) s = -s;
@@ -2063,8 +780,8 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
                 if ( j == l ) {
                     if ( n != i && k != m ) {
                         int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                        int ni = ibas_aa_sym[hni][n][i];
-                        int km = ibas_aa_sym[hni][k][m];
+                        int ni = ibas_aa(n,i);
+                        int km = ibas_aa(k,m);
 
                         int s = 1;
                         if ( n > i ) s = -s;
@@ -2076,8 +793,8 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
                 if ( i == m ) {
                     if ( n != j && k != l ) {
                         int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int kl = ibas_aa_sym[hnj][k][l];
+                        int nj = ibas_aa(n,j);
+                        int kl = ibas_aa(k,l);
 
                         int s = 1;
                         if ( n > j ) s = -s;
@@ -2089,8 +806,8 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
                 if ( j == m ) {
                     if ( n != i && k != l ) {
                         int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                        int ni = ibas_aa_sym[hni][n][i];
-                        int kl = ibas_aa_sym[hni][k][l];
+                        int ni = ibas_aa(n,i);
+                        int kl = ibas_aa(k,l);
 
                         int s = 1;
                         if ( n > i ) s = -s;
@@ -2100,12 +817,12 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
                     }
                 }
     
-                u_p[t2aaaoff[h] + id] = dum; // - T2(ijk,lmn)
+                A_p[myoffset + id] = dum;
 
             }
         }
         // T2aaa/abb
-        #pragma omp parallel for schedule (static)
+        #pragma omp taskloop nogroup
         for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
 
             int i = bas_aab_sym[h][ijk][0];
@@ -2120,28 +837,28 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
 
                 int id = ijk*(trip_aab[h]+trip_aba[h])+(lmn+trip_aab[h]);
 
-                double dum = 0.0;//-u_p[t2aaaoff[h] + id]; // - T2(ijk,lmn)
+                double dum = -u_p[t2aaaoff[h] + id]; // - T2(ijk,lmn)
 
                 if ( i == l ) {
                     int hjn = SymmetryPair(symmetry[j],symmetry[n]);
-                    int jn = ibas_ab_sym[hjn][j][n];
-                    int km = ibas_ab_sym[hjn][k][m];
+                    int jn = ibas_ab(j,n);
+                    int km = ibas_ab(k,m);
                     dum += u_p[d2aboff[hjn]+jn*gems_ab[hjn]+km]; // D2(jn,km) dil
                 }
                 if ( j == l ) {
                     int hin = SymmetryPair(symmetry[i],symmetry[n]);
-                    int in = ibas_ab_sym[hin][i][n];
-                    int km = ibas_ab_sym[hin][k][m];
+                    int in = ibas_ab(i,n);
+                    int km = ibas_ab(k,m);
                     dum -= u_p[d2aboff[hin]+in*gems_ab[hin]+km]; // -D2(in,km) djl
                 }
 
-                u_p[t2aaaoff[h] + id] = 0.0; // - T2(ijk,lmn)
+                A_p[myoffset + id] = dum;
 
             }
         }
 
         // T2abb/aaa
-        #pragma omp parallel for schedule (static)
+        #pragma omp taskloop nogroup
         for (int ijk = 0; ijk < trip_aba[h]; ijk++) {
 
             int i = bas_aba_sym[h][ijk][0];
@@ -2156,28 +873,28 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
 
                 int id = (ijk+trip_aab[h])*(trip_aab[h]+trip_aba[h])+lmn;
 
-                double dum = 0.0;//-u_p[t2aaaoff[h] + id]; // - T2(ijk,lmn)
+                double dum = -u_p[t2aaaoff[h] + id]; // - T2(ijk,lmn)
 
                 if ( i == l ) {
                     int hjn = SymmetryPair(symmetry[j],symmetry[n]);
-                    int jn = ibas_ab_sym[hjn][n][j];
-                    int km = ibas_ab_sym[hjn][m][k];
+                    int jn = ibas_ab(n,j);
+                    int km = ibas_ab(m,k);
                     dum += u_p[d2aboff[hjn]+jn*gems_ab[hjn]+km]; // D2(jn,km) dil
                 }
                 if ( i == m ) {
                     int hnj = SymmetryPair(symmetry[j],symmetry[n]);
-                    int nj = ibas_ab_sym[hnj][n][j];
-                    int lk = ibas_ab_sym[hnj][l][k];
+                    int nj = ibas_ab(n,j);
+                    int lk = ibas_ab(l,k);
                     dum -= u_p[d2aboff[hnj]+nj*gems_ab[hnj]+lk]; // -D2(in,km) djl
                 }
 
-                u_p[t2aaaoff[h] + id] = dum; // - T2(ijk,lmn)
+                A_p[myoffset + id] = dum;
 
             }
         }
 
         // T2abb/abb
-        #pragma omp parallel for schedule (static)
+        #pragma omp taskloop nogroup
         for (int ijk = 0; ijk < trip_aba[h]; ijk++) {
 
             int i = bas_aba_sym[h][ijk][0];
@@ -2192,12 +909,12 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
 
                 int id = (ijk+trip_aab[h])*(trip_aab[h]+trip_aba[h])+(lmn+trip_aab[h]);
 
-                double dum = 0.0;//-u_p[t2aaaoff[h] + id]; // - T2(ijk,lmn)
+                double dum = -u_p[t2aaaoff[h] + id]; // - T2(ijk,lmn)
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_ab_sym[hij][i][j];
-                    int lm = ibas_ab_sym[hij][l][m];
+                    int ij = ibas_ab(i,j);
+                    int lm = ibas_ab(l,m);
                     dum += u_p[d2aboff[hij] + ij*gems_ab[hij]+lm]; // + D2(ij,lm) dkn
                 }
 
@@ -2211,8 +928,8 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
                 if ( i == l ) {
                     if ( n != j && k != m ) {
                         int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int km = ibas_aa_sym[hnj][k][m];
+                        int nj = ibas_aa(n,j);
+                        int km = ibas_aa(k,m);
 
                         int s = 1;
                         if ( n > j ) s = -s;
@@ -2223,12 +940,12 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
                 }
                 if ( j == m ) {
                     int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][i][n];
-                    int kl = ibas_ab_sym[hni][l][k];
+                    int ni = ibas_ab(i,n);
+                    int kl = ibas_ab(l,k);
                     dum -= u_p[d2aboff[hni] + ni*gems_ab[hni]+kl]; // -D2(ni,kl) djm
                 }
     
-                u_p[t2aaaoff[h] + id] = dum; // - T2(ijk,lmn)
+                A_p[myoffset + id] = dum;
 
             }
         }
@@ -2241,7 +958,8 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
     for (int h = 0; h < nirrep_; h++) {
 
         // T2bbb/bbb
-        #pragma omp parallel for schedule (static)
+        long int myoffset = offset;
+        #pragma omp taskloop nogroup
         for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
 
             int i = bas_aab_sym[h][ijk][0];
@@ -2257,12 +975,12 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
                 int id = ijk*(trip_aab[h]+trip_aba[h])+lmn;
                 //int id = ijk*trip_aab[h]+lmn;
 
-                double dum = 0.0;//-u_p[t2bbboff[h] + id]; // - T2(ijk,lmn)
+                double dum = -u_p[t2bbboff[h] + id]; // - T2(ijk,lmn)
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
                     dum += u_p[d2bboff[hij] + ij*gems_aa[hij]+lm]; // + D2(ij,lm) dkn
                 }
 
@@ -2282,8 +1000,8 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
                 if ( i == l ) {
                     if ( n != j && k != m ) {
                         int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int km = ibas_aa_sym[hnj][k][m];
+                        int nj = ibas_aa(n,j);
+                        int km = ibas_aa(k,m);
 
                         int s = 1;
                         if ( n > j ) s = -s;
@@ -2295,8 +1013,8 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
                 if ( j == l ) {
                     if ( n != i && k != m ) {
                         int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                        int ni = ibas_aa_sym[hni][n][i];
-                        int km = ibas_aa_sym[hni][k][m];
+                        int ni = ibas_aa(n,i);
+                        int km = ibas_aa(k,m);
 
                         int s = 1;
                         if ( n > i ) s = -s;
@@ -2308,8 +1026,8 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
                 if ( i == m ) {
                     if ( n != j && k != l ) {
                         int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int kl = ibas_aa_sym[hnj][k][l];
+                        int nj = ibas_aa(n,j);
+                        int kl = ibas_aa(k,l);
 
                         int s = 1;
                         if ( n > j ) s = -s;
@@ -2321,8 +1039,8 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
                 if ( j == m ) {
                     if ( n != i && k != l ) {
                         int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                        int ni = ibas_aa_sym[hni][n][i];
-                        int kl = ibas_aa_sym[hni][k][l];
+                        int ni = ibas_aa(n,i);
+                        int kl = ibas_aa(k,l);
 
                         int s = 1;
                         if ( n > i ) s = -s;
@@ -2332,12 +1050,12 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
                     }
                 }
     
-                u_p[t2bbboff[h] + id] = dum; // - T2(ijk,lmn)
+                A_p[myoffset + id] = dum;
 
             }
         }
         // T2bbb/baa
-        #pragma omp parallel for schedule (static)
+        #pragma omp taskloop nogroup
         for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
 
             int i = bas_aab_sym[h][ijk][0];
@@ -2352,28 +1070,28 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
 
                 int id = ijk*(trip_aab[h]+trip_aba[h])+(lmn+trip_aab[h]);
 
-                double dum = 0.0;//-u_p[t2bbboff[h] + id]; // - T2(ijk,lmn)
+                double dum = -u_p[t2bbboff[h] + id]; // - T2(ijk,lmn)
 
                 if ( i == l ) {
                     int hjn = SymmetryPair(symmetry[j],symmetry[n]);
-                    int jn = ibas_ab_sym[hjn][n][j];
-                    int km = ibas_ab_sym[hjn][m][k];
+                    int jn = ibas_ab(n,j);
+                    int km = ibas_ab(m,k);
                     dum += u_p[d2aboff[hjn]+jn*gems_ab[hjn]+km]; // D2(jn,km) dil
                 }
                 if ( j == l ) {
                     int hin = SymmetryPair(symmetry[i],symmetry[n]);
-                    int in = ibas_ab_sym[hin][n][i];
-                    int km = ibas_ab_sym[hin][m][k];
+                    int in = ibas_ab(n,i);
+                    int km = ibas_ab(m,k);
                     dum -= u_p[d2aboff[hin]+in*gems_ab[hin]+km]; // -D2(in,km) djl
                 }
 
-                u_p[t2bbboff[h] + id] = dum; // - T2(ijk,lmn)
+                A_p[myoffset + id] = dum;
 
             }
         }
 
         // T2baa/bbb
-        #pragma omp parallel for schedule (static)
+        #pragma omp taskloop nogroup
         for (int ijk = 0; ijk < trip_aba[h]; ijk++) {
 
             int i = bas_aba_sym[h][ijk][0];
@@ -2388,27 +1106,27 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
 
                 int id = (ijk+trip_aab[h])*(trip_aab[h]+trip_aba[h])+lmn;
 
-                double dum = 0.0;//-u_p[t2bbboff[h] + id]; // - T2(ijk,lmn)
+                double dum = -u_p[t2bbboff[h] + id]; // - T2(ijk,lmn)
 
                 if ( i == l ) {
                     int hjn = SymmetryPair(symmetry[j],symmetry[n]);
-                    int jn = ibas_ab_sym[hjn][j][n];
-                    int km = ibas_ab_sym[hjn][k][m];
+                    int jn = ibas_ab(j,n);
+                    int km = ibas_ab(k,m);
                     dum += u_p[d2aboff[hjn]+jn*gems_ab[hjn]+km]; // D2(jn,km) dil
                 }
                 if ( i == m ) {
                     int hnj = SymmetryPair(symmetry[j],symmetry[n]);
-                    int nj = ibas_ab_sym[hnj][j][n];
-                    int lk = ibas_ab_sym[hnj][k][l];
+                    int nj = ibas_ab(j,n);
+                    int lk = ibas_ab(k,l);
                     dum -= u_p[d2aboff[hnj]+nj*gems_ab[hnj]+lk]; // -D2(in,km) djl
                 }
 
-                u_p[t2bbboff[h] + id] = dum; // - T2(ijk,lmn)
+                A_p[myoffset + id] = dum;
 
             }
         }
         // T2baa/baa
-        #pragma omp parallel for schedule (static)
+        #pragma omp taskloop nogroup
         for (int ijk = 0; ijk < trip_aba[h]; ijk++) {
 
             int i = bas_aba_sym[h][ijk][0];
@@ -2423,12 +1141,12 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
 
                 int id = (ijk+trip_aab[h])*(trip_aab[h]+trip_aba[h])+(lmn+trip_aab[h]);
 
-                double dum = 0.0;//-u_p[t2bbboff[h] + id]; // - T2(ijk,lmn)
+                double dum = -u_p[t2bbboff[h] + id]; // - T2(ijk,lmn)
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_ab_sym[hij][j][i];
-                    int lm = ibas_ab_sym[hij][m][l];
+                    int ij = ibas_ab(j,i);
+                    int lm = ibas_ab(m,l);
                     dum += u_p[d2aboff[hij] + ij*gems_ab[hij]+lm]; // + D2(ij,lm) dkn
                 }
 
@@ -2437,160 +1155,49 @@ void v2RDMSolver::T2_constraints_guess(SharedVector u){
                     int kk = k - pitzer_offset[h2];
                     int nn = n - pitzer_offset[h2];
                     dum += u_p[d1aoff[h2] + nn*amopi_[h2]+kk]; // + D1(n,k) djm dil
-                }
-
-                if ( i == l ) {
-                    if ( n != j && k != m ) {
-                        int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int km = ibas_aa_sym[hnj][k][m];
-
-                        int s = 1;
-                        if ( n > j ) s = -s;
-                        if ( k > m ) s = -s;
-
-                        dum -= s * u_p[d2aaoff[hnj] + nj*gems_aa[hnj]+km]; // - D2(nj,km) dil
-                    }
-                }
-                if ( j == m ) {
-                    int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int kl = ibas_ab_sym[hni][k][l];
-                    dum -= u_p[d2aboff[hni] + ni*gems_ab[hni]+kl]; // -D2(ni,kl) djm
-                }
-    
-                u_p[t2bbboff[h] + id] = dum; // - T2(ijk,lmn)
-
-            }
-        }
-        //C_DAXPY((trip_aba[h] + trip_aab[h]) * (trip_aba[h] + trip_aab[h]), -1.0, &u_p[t2bbboff[h]],1,&A_p[offset],1);
-        offset += (trip_aba[h]+trip_aab[h])*(trip_aba[h]+trip_aab[h]);
-        //offset += trip_aab[h]*trip_aab[h];
-    }
-#endif
-
-}
-
-// T2 portion of A^T.y 
-void v2RDMSolver::T2_constraints_ATu(SharedVector A,SharedVector u){
-
-    double * A_p = A->pointer();
-    double * u_p = u->pointer();
-
-    int saveoff = offset;
-
-    // T2aab
-    for (int h = 0; h < nirrep_; h++) {
-
-        for (int ij = 0; ij < gems_aa[h]; ij++) {
-            int i = bas_aa_sym[h][ij][0];
-            int j = bas_aa_sym[h][ij][1];
-            for (int lm = 0; lm < gems_aa[h]; lm++) {
-                int l = bas_aa_sym[h][lm][0];
-                int m = bas_aa_sym[h][lm][1];
-                for (int k = 0; k < amo_; k++) {
-                    int h2 = SymmetryPair(h,symmetry[k]);
-                    int myoffset = saveoff;
-                    for (int myh = 0; myh < h2; myh++) {
-                        myoffset += trip_aab[myh]*trip_aab[myh];
-                    }
-                    int ijk = ibas_aab_sym[h2][i][j][k];
-                    int lmn = ibas_aab_sym[h2][l][m][k];
-                    A_p[d2aaoff[h] + ij*gems_aa[h]+lm] += u_p[myoffset + ijk*trip_aab[h2]+lmn]; // + D2(ij,lm) dkn
-                }
-            }
-        }
-
-        for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
-            int i = bas_aab_sym[h][ijk][0];
-            int j = bas_aab_sym[h][ijk][1];
-            int k = bas_aab_sym[h][ijk][2];
-
-
-            for (int m = 0; m < amo_; m++) {
-                if ( i >= m ) continue;
-                int l = i;
-                int hmk = SymmetryPair(symmetry[k],symmetry[m]);
-                int mk = ibas_ab_sym[hmk][m][k];
-                int hlm  = SymmetryPair(symmetry[m],symmetry[l]);
-                int hn  = SymmetryPair(h,hlm);
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    int jn = ibas_ab_sym[hmk][j][n];
-                    int lmn  = ibas_aab_sym[h][l][m][n];
-
-                    A_p[d2aboff[hmk] + jn*gems_ab[hmk]+mk] -= u_p[offset + ijk*trip_aab[h]+lmn]; // - D2(nj,km) dil
-                }
-            }
-
-            for (int m = 0; m < amo_; m++) {
-                if ( j >= m ) continue;
-                int l = j;
-                int hmk = SymmetryPair(symmetry[k],symmetry[m]);
-                int mk = ibas_ab_sym[hmk][m][k];
-                int hlm  = SymmetryPair(symmetry[m],symmetry[l]);
-                int hn  = SymmetryPair(h,hlm);
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    int in = ibas_ab_sym[hmk][i][n];
-                    int lmn  = ibas_aab_sym[h][j][m][n];
-
-                    A_p[d2aboff[hmk] + in*gems_ab[hmk]+mk] += u_p[offset + ijk*trip_aab[h]+lmn]; // D2(ni,km) djl
-                }
-            }
-
-            for (int l = 0; l < amo_; l++) {
-                int m = i;
-                if ( l >= m ) continue;
-                int hlk = SymmetryPair(symmetry[k],symmetry[l]);
-                int lk = ibas_ab_sym[hlk][l][k];
-                int hlm  = SymmetryPair(symmetry[m],symmetry[l]);
-                int hn  = SymmetryPair(h,hlm);
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    int jn = ibas_ab_sym[hlk][j][n];
-                    int lmn  = ibas_aab_sym[h][l][m][n];
-
-                    A_p[d2aboff[hlk] + jn*gems_ab[hlk]+lk] += u_p[offset + ijk*trip_aab[h]+lmn]; // D2(nj,kl) dim
-
-                }
-            }
-
-            for (int l = 0; l < amo_; l++) {
-                int m = j;
-                if ( l >= m ) continue;
-                int hlk = SymmetryPair(symmetry[k],symmetry[l]);
-                int lk = ibas_ab_sym[hlk][l][k];
-                int hlm  = SymmetryPair(symmetry[m],symmetry[l]);
-                int hn  = SymmetryPair(h,hlm);
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    int in = ibas_ab_sym[hlk][i][n];
-                    int lmn  = ibas_aab_sym[h][l][m][n];
-
-                    A_p[d2aboff[hlk] + in*gems_ab[hlk]+lk] -= u_p[offset + ijk*trip_aab[h]+lmn]; // -D2(ni,kl) djm
-
-                }
-            }
-
-            for (int n = 0; n < amo_; n++) {
-                int m = j;
-                int l = i;
-                if ( l >= m ) continue;
+                }
 
-                int hmn  = SymmetryPair(symmetry[m],symmetry[n]);
-                int hlmn = SymmetryPair(hmn,symmetry[l]);
-                if ( hlmn != h ) continue;
+                if ( i == l ) {
+                    if ( n != j && k != m ) {
+                        int hnj = SymmetryPair(symmetry[n],symmetry[j]);
+                        int nj = ibas_aa(n,j);
+                        int km = ibas_aa(k,m);
 
-                int lmn  = ibas_aab_sym[h][l][m][n];
+                        int s = 1;
+                        if ( n > j ) s = -s;
+                        if ( k > m ) s = -s;
 
-                int h2 = symmetry[k];
-                int kk = k - pitzer_offset[h2];
-                int nn = n - pitzer_offset[h2];
+                        dum -= s * u_p[d2aaoff[hnj] + nj*gems_aa[hnj]+km]; // - D2(nj,km) dil
+                    }
+                }
+                if ( j == m ) {
+                    int hni = SymmetryPair(symmetry[n],symmetry[i]);
+                    int ni = ibas_ab(n,i);
+                    int kl = ibas_ab(k,l);
+                    dum -= u_p[d2aboff[hni] + ni*gems_ab[hni]+kl]; // -D2(ni,kl) djm
+                }
+    
+                A_p[myoffset + id] = dum;
 
-                A_p[d1boff[h2] + nn*amopi_[h2]+kk] += u_p[offset + ijk*trip_aab[h]+lmn]; // + D1(n,k) djm dil
             }
         }
-        C_DAXPY(trip_aab[h] * trip_aab[h], -1.0, &u_p[offset],1,&A_p[t2aaboff[h]],1);
+        //C_DAXPY((trip_aba[h] + trip_aab[h]) * (trip_aba[h] + trip_aab[h]), -1.0, &u_p[t2bbboff[h]],1,&A_p[offset],1);
+        offset += (trip_aba[h]+trip_aab[h])*(trip_aba[h]+trip_aab[h]);
+        //offset += trip_aab[h]*trip_aab[h];
+    }
+#endif
+
+}
+// T2 guess
+void v2RDMSolver::T2_constraints_guess(SharedVector u){
 
+    double * u_p = u->pointer();
+
+    // T2aab
+    for (int h = 0; h < nirrep_; h++) {
 
-        /*for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
+        #pragma omp parallel for schedule (static)
+        for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
 
             int i = bas_aab_sym[h][ijk][0];
             int j = bas_aab_sym[h][ijk][1];
@@ -2602,172 +1209,65 @@ void v2RDMSolver::T2_constraints_ATu(SharedVector A,SharedVector u){
                 int m = bas_aab_sym[h][lmn][1];
                 int n = bas_aab_sym[h][lmn][2];
 
-                double dum = u_p[offset + ijk*trip_aab[h]+lmn];
-
-                A_p[t2aaboff[h] + ijk*trip_aab[h]+lmn] -= dum; // - T2(ijk,lmn)
+                double dum = 0.0;//-u_p[t2aaboff[h] + ijk*trip_aab[h]+lmn]; // - T2(ijk,lmn)
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
-                    A_p[d2aaoff[hij] + ij*gems_aa[hij]+lm] += dum; // + D2(ij,lm) dkn
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
+                    dum += u_p[d2aaoff[hij] + ij*gems_aa[hij]+lm]; // + D2(ij,lm) dkn
                 }
 
                 if ( j == m && i == l ) {
                     int h2 = symmetry[k];
                     int kk = k - pitzer_offset[h2];
                     int nn = n - pitzer_offset[h2];
-                    A_p[d1boff[h2] + nn*amopi_[h2]+kk] += dum; // + D1(n,k) djm dil
+                    dum += u_p[d1boff[h2] + nn*amopi_[h2]+kk]; // + D1(n,k) djm dil
                 }
                 if ( j == l && i == m ) {
                     int h2 = symmetry[k];
                     int kk = k - pitzer_offset[h2];
                     int nn = n - pitzer_offset[h2];
-                    A_p[d1boff[h2] + nn*amopi_[h2]+kk] -= dum; // - D1(n,k) djl dim
+                    dum -= u_p[d1boff[h2] + nn*amopi_[h2]+kk]; // - D1(n,k) djl dim
                 }
 
                 if ( i == l ) {
                     int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                    int nj = ibas_ab_sym[hnj][j][n];
-                    int km = ibas_ab_sym[hnj][m][k];
-                    A_p[d2aboff[hnj] + nj*gems_ab[hnj]+km] -= dum; // - D2(nj,km) dil
+                    int nj = ibas_ab(j,n);
+                    int km = ibas_ab(m,k);
+                    dum -= u_p[d2aboff[hnj] + nj*gems_ab[hnj]+km]; // - D2(nj,km) dil
                 }
                 if ( j == l ) {
                     int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][i][n];
-                    int km = ibas_ab_sym[hni][m][k];
-                    A_p[d2aboff[hni] + ni*gems_ab[hni]+km] += dum; // D2(ni,km) djl
+                    int ni = ibas_ab(i,n);
+                    int km = ibas_ab(m,k);
+                    dum += u_p[d2aboff[hni] + ni*gems_ab[hni]+km]; // D2(ni,km) djl
                 }
                 if ( i == m ) {
                     int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                    int nj = ibas_ab_sym[hnj][j][n];
-                    int kl = ibas_ab_sym[hnj][l][k];
-                    A_p[d2aboff[hnj] + nj*gems_ab[hnj]+kl] += dum; // D2(nj,kl) dim
+                    int nj = ibas_ab(j,n);
+                    int kl = ibas_ab(l,k);
+                    dum += u_p[d2aboff[hnj] + nj*gems_ab[hnj]+kl]; // D2(nj,kl) dim
                 }
                 if ( j == m ) {
                     int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][i][n];
-                    int kl = ibas_ab_sym[hni][l][k];
-                    A_p[d2aboff[hni] + ni*gems_ab[hni]+kl] -= dum; // -D2(ni,kl) djm
+                    int ni = ibas_ab(i,n);
+                    int kl = ibas_ab(l,k);
+                    dum -= u_p[d2aboff[hni] + ni*gems_ab[hni]+kl]; // -D2(ni,kl) djm
                 }
+    
+                u_p[t2aaboff[h] + ijk*trip_aab[h]+lmn] = dum; // - T2(ijk,lmn)
+
             }
-        }*/
+        }
         offset += trip_aab[h]*trip_aab[h];
     }
 
-    saveoff = offset;
-
     // T2bba
     for (int h = 0; h < nirrep_; h++) {
 
-        for (int ij = 0; ij < gems_aa[h]; ij++) {
-            int i = bas_aa_sym[h][ij][0];
-            int j = bas_aa_sym[h][ij][1];
-            for (int lm = 0; lm < gems_aa[h]; lm++) {
-                int l = bas_aa_sym[h][lm][0];
-                int m = bas_aa_sym[h][lm][1];
-                for (int k = 0; k < amo_; k++) {
-                    int h2 = SymmetryPair(h,symmetry[k]);
-                    int myoffset = saveoff;
-                    for (int myh = 0; myh < h2; myh++) {
-                        myoffset += trip_aab[myh]*trip_aab[myh];
-                    }
-                    int ijk = ibas_aab_sym[h2][i][j][k];
-                    int lmn = ibas_aab_sym[h2][l][m][k];
-                    A_p[d2bboff[h] + ij*gems_aa[h]+lm] += u_p[myoffset + ijk*trip_aab[h2]+lmn]; // + D2(ij,lm) dkn
-                }
-            }
-        }
-
+        #pragma omp parallel for schedule (static)
         for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
-            int i = bas_aab_sym[h][ijk][0];
-            int j = bas_aab_sym[h][ijk][1];
-            int k = bas_aab_sym[h][ijk][2];
-
-
-            for (int m = 0; m < amo_; m++) {
-                if ( i >= m ) continue;
-                int l = i;
-                int hmk = SymmetryPair(symmetry[k],symmetry[m]);
-                int mk = ibas_ab_sym[hmk][k][m];
-                int hlm  = SymmetryPair(symmetry[m],symmetry[l]);
-                int hn  = SymmetryPair(h,hlm);
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    int jn = ibas_ab_sym[hmk][n][j];
-                    int lmn  = ibas_aab_sym[h][l][m][n];
-
-                    A_p[d2aboff[hmk] + jn*gems_ab[hmk]+mk] -= u_p[offset + ijk*trip_aab[h]+lmn]; // - D2(nj,km) dil
-                }
-            }
-
-            for (int m = 0; m < amo_; m++) {
-                if ( j >= m ) continue;
-                int l = j;
-                int hmk = SymmetryPair(symmetry[k],symmetry[m]);
-                int mk = ibas_ab_sym[hmk][k][m];
-                int hlm  = SymmetryPair(symmetry[m],symmetry[l]);
-                int hn  = SymmetryPair(h,hlm);
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    int in = ibas_ab_sym[hmk][n][i];
-                    int lmn  = ibas_aab_sym[h][j][m][n];
-
-                    A_p[d2aboff[hmk] + in*gems_ab[hmk]+mk] += u_p[offset + ijk*trip_aab[h]+lmn]; // D2(ni,km) djl
-                }
-            }
-
-            for (int l = 0; l < amo_; l++) {
-                int m = i;
-                if ( l >= m ) continue;
-                int hlk = SymmetryPair(symmetry[k],symmetry[l]);
-                int lk = ibas_ab_sym[hlk][k][l];
-                int hlm  = SymmetryPair(symmetry[m],symmetry[l]);
-                int hn  = SymmetryPair(h,hlm);
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    int jn = ibas_ab_sym[hlk][n][j];
-                    int lmn  = ibas_aab_sym[h][l][m][n];
-
-                    A_p[d2aboff[hlk] + jn*gems_ab[hlk]+lk] += u_p[offset + ijk*trip_aab[h]+lmn]; // D2(nj,kl) dim
-
-                }
-            }
-
-            for (int l = 0; l < amo_; l++) {
-                int m = j;
-                if ( l >= m ) continue;
-                int hlk = SymmetryPair(symmetry[k],symmetry[l]);
-                int lk = ibas_ab_sym[hlk][k][l];
-                int hlm  = SymmetryPair(symmetry[m],symmetry[l]);
-                int hn  = SymmetryPair(h,hlm);
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    int in = ibas_ab_sym[hlk][n][i];
-                    int lmn  = ibas_aab_sym[h][l][m][n];
-
-                    A_p[d2aboff[hlk] + in*gems_ab[hlk]+lk] -= u_p[offset + ijk*trip_aab[h]+lmn]; // -D2(ni,kl) djm
-
-                }
-            }
-
-            for (int n = 0; n < amo_; n++) {
-                int m = j;
-                int l = i;
-                if ( l >= m ) continue;
-
-                int hmn  = SymmetryPair(symmetry[m],symmetry[n]);
-                int hlmn = SymmetryPair(hmn,symmetry[l]);
-                if ( hlmn != h ) continue;
-
-                int lmn  = ibas_aab_sym[h][l][m][n];
-
-                int h2 = symmetry[k];
-                int kk = k - pitzer_offset[h2];
-                int nn = n - pitzer_offset[h2];
-
-                A_p[d1aoff[h2] + nn*amopi_[h2]+kk] += u_p[offset + ijk*trip_aab[h]+lmn]; // + D1(n,k) djm dil
-            }
-        }
-        C_DAXPY(trip_aab[h] * trip_aab[h], -1.0, &u_p[offset],1,&A_p[t2bbaoff[h]],1);
-
-        /*for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
 
             int i = bas_aab_sym[h][ijk][0];
             int j = bas_aab_sym[h][ijk][1];
@@ -2779,56 +1279,57 @@ void v2RDMSolver::T2_constraints_ATu(SharedVector A,SharedVector u){
                 int m = bas_aab_sym[h][lmn][1];
                 int n = bas_aab_sym[h][lmn][2];
 
-                double dum = u_p[offset + ijk*trip_aab[h]+lmn];
-
-                A_p[t2bbaoff[h] + ijk*trip_aab[h]+lmn] -= dum; // - T2(ijk,lmn)
+                double dum = 0.0;//-u_p[t2bbaoff[h] + ijk*trip_aab[h]+lmn]; // - T2(ijk,lmn)
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
-                    A_p[d2bboff[hij] + ij*gems_aa[hij]+lm] += dum; // + D2(ij,lm) dkn
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
+                    dum += u_p[d2bboff[hij] + ij*gems_aa[hij]+lm]; // + D2(ij,lm) dkn
                 }
 
                 if ( j == m && i == l ) {
                     int h2 = symmetry[k];
                     int kk = k - pitzer_offset[h2];
                     int nn = n - pitzer_offset[h2];
-                    A_p[d1aoff[h2] + nn*amopi_[h2]+kk] += dum; // + D1(n,k) djm dil
+                    dum += u_p[d1aoff[h2] + nn*amopi_[h2]+kk]; // + D1(n,k) djm dil
                 }
                 if ( j == l && i == m ) {
                     int h2 = symmetry[k];
                     int kk = k - pitzer_offset[h2];
                     int nn = n - pitzer_offset[h2];
-                    A_p[d1aoff[h2] + nn*amopi_[h2]+kk] -= dum; // - D1(n,k) djl dim
+                    dum -= u_p[d1aoff[h2] + nn*amopi_[h2]+kk]; // - D1(n,k) djl dim
                 }
 
                 if ( i == l ) {
                     int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                    int nj = ibas_ab_sym[hnj][n][j];
-                    int km = ibas_ab_sym[hnj][k][m];
-                    A_p[d2aboff[hnj] + nj*gems_ab[hnj]+km] -= dum; // - D2(nj,km) dil
+                    int nj = ibas_ab(n,j);
+                    int km = ibas_ab(k,m);
+                    dum -= u_p[d2aboff[hnj] + nj*gems_ab[hnj]+km]; // - D2(nj,km) dil
                 }
                 if ( j == l ) {
                     int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int km = ibas_ab_sym[hni][k][m];
-                    A_p[d2aboff[hni] + ni*gems_ab[hni]+km] += dum; // D2(ni,km) djl
+                    int ni = ibas_ab(n,i);
+                    int km = ibas_ab(k,m);
+                    dum += u_p[d2aboff[hni] + ni*gems_ab[hni]+km]; // D2(ni,km) djl
                 }
                 if ( i == m ) {
                     int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                    int nj = ibas_ab_sym[hnj][n][j];
-                    int kl = ibas_ab_sym[hnj][k][l];
-                    A_p[d2aboff[hnj] + nj*gems_ab[hnj]+kl] += dum; // D2(nj,kl) dim
+                    int nj = ibas_ab(n,j);
+                    int kl = ibas_ab(k,l);
+                    dum += u_p[d2aboff[hnj] + nj*gems_ab[hnj]+kl]; // D2(nj,kl) dim
                 }
                 if ( j == m ) {
                     int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int kl = ibas_ab_sym[hni][k][l];
-                    A_p[d2aboff[hni] + ni*gems_ab[hni]+kl] -= dum; // -D2(ni,kl) djm
+                    int ni = ibas_ab(n,i);
+                    int kl = ibas_ab(k,l);
+                    dum -= u_p[d2aboff[hni] + ni*gems_ab[hni]+kl]; // -D2(ni,kl) djm
                 }
+    
+                u_p[t2bbaoff[h] + ijk*trip_aab[h]+lmn] = dum; // - T2(ijk,lmn)
+
             }
-        }*/
+        }
         offset += trip_aab[h]*trip_aab[h];
     }
 
@@ -2837,117 +1338,9 @@ void v2RDMSolver::T2_constraints_ATu(SharedVector A,SharedVector u){
     for (int h = 0; h < nirrep_; h++) {
 
         // T2aaa/aaa
+        #pragma omp parallel for schedule (static)
         for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
 
-            int i = bas_aab_sym[h][ijk][0];
-            int j = bas_aab_sym[h][ijk][1];
-            int k = bas_aab_sym[h][ijk][2];
-            int hij = SymmetryPair(symmetry[i],symmetry[j]);
-            int ij = ibas_aa_sym[hij][i][j];
-            int ijk_id = offset + ijk*(trip_aab[h]+trip_aba[h]);
-
-            for (int l = 0; l < amo_; l++) {
-                int n = k;
-                int hln  = SymmetryPair(symmetry[n],symmetry[l]);
-                int hm  = SymmetryPair(h,hln);
-                for (int m = ( l + 1 > pitzer_offset[hm] ? l : pitzer_offset[hm] ); m < pitzer_offset[hm]+amopi_[hm]; m++) {
-                    int lm = ibas_aa_sym[hij][l][m];
-                    int lmn  = ibas_aab_sym[h][l][m][n];
-
-                    A_p[d2aaoff[hij] + ij*gems_aa[hij]+lm] += u_p[ijk_id + lmn]; // + D2(ij,lm) dkn
-                }
-            }
-
-            for (int m = i+1; m < amo_; m++) {
-                if ( k == m ) continue;
-                int l = i;
-                int hml = SymmetryPair(symmetry[m],symmetry[l]);
-                int hkm = SymmetryPair(symmetry[m],symmetry[k]);
-                int hn  = SymmetryPair(h,hml);
-                int km = ibas_aa_sym[hkm][k][m];
-                int s1 = 1;
-                if ( k > m ) s1 = -s1;
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    if ( j == n ) continue;
-                    int s2 = s1;
-                    if ( n > j ) s2 = -s2;
-
-                    int nj   = ibas_aa_sym[hkm][n][j];
-                    int lmn  = ibas_aab_sym[h][l][m][n];
-                    A_p[d2aaoff[hkm] + nj*gems_aa[hkm]+km] -= s2 * u_p[ijk_id + lmn]; // - D2(nj,km) dil
-                }
-            }
-            for (int m = j+1; m < amo_; m++) {
-                if ( k == m ) continue;
-                int l = j;
-                int hml = SymmetryPair(symmetry[m],symmetry[l]);
-                int hkm = SymmetryPair(symmetry[m],symmetry[k]);
-                int hn  = SymmetryPair(h,hml);
-                int km = ibas_aa_sym[hkm][k][m];
-                int s1 = 1;
-                if ( k > m ) s1 = -s1;
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    if ( i == n ) continue;
-                    int s2 = s1;
-                    if ( n > i ) s2 = -s2;
-
-                    int ni   = ibas_aa_sym[hkm][n][i];
-                    int lmn  = ibas_aab_sym[h][l][m][n];
-
-                    A_p[d2aaoff[hkm] + ni*gems_aa[hkm]+km] += s2 * u_p[ijk_id + lmn]; // D2(ni,km) djl
-                }
-            }
-            for (int l = 0; l < i; l++) {
-                if ( k == l ) continue;
-                int m = i;
-                int hml = SymmetryPair(symmetry[m],symmetry[l]);
-                int hkl = SymmetryPair(symmetry[l],symmetry[k]);
-                int hn  = SymmetryPair(h,hml);
-                int kl = ibas_aa_sym[hkl][k][l];
-                int s1 = 1;
-                if ( k > l ) s1 = -s1;
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    if ( j == n ) continue;
-                    int s2 = s1;
-                    if ( n > j ) s2 = -s2;
-
-                    int nj   = ibas_aa_sym[hkl][n][j];
-                    int lmn  = ibas_aab_sym[h][l][m][n];
-                    A_p[d2aaoff[hkl] + nj*gems_aa[hkl]+kl] += s2 * u_p[ijk_id + lmn]; // D2(nj,kl) dim
-                }
-            }
-            for (int l = 0; l < j; l++) {
-                if ( k == l ) continue;
-                int m = j;
-                int hml = SymmetryPair(symmetry[m],symmetry[l]);
-                int hkl = SymmetryPair(symmetry[l],symmetry[k]);
-                int hn  = SymmetryPair(h,hml);
-                int kl = ibas_aa_sym[hkl][k][l];
-                int s1 = 1;
-                if ( k > l ) s1 = -s1;
-                for (int n = pitzer_offset[hn]; n < pitzer_offset[hn]+amopi_[hn]; n++) {
-                    if ( i == n ) continue;
-                    int s2 = s1;
-                    if ( n > i ) s2 = -s2;
-
-                    int ni   = ibas_aa_sym[hkl][n][i];
-                    int lmn  = ibas_aab_sym[h][l][m][n];
-                    A_p[d2aaoff[hkl] + ni*gems_aa[hkl]+kl] -= s2 * u_p[ijk_id + lmn]; // -D2(ni,kl) djm
-                }
-            }
-            int hk = symmetry[k];
-            int kk = k - pitzer_offset[hk];
-            int m = j;
-            int l = i;
-            for (int n = pitzer_offset[hk]; n < pitzer_offset[hk] + amopi_[hk]; n++) {
-                int nn = n - pitzer_offset[hk];
-                int lmn  = ibas_aab_sym[h][l][m][n];
-                A_p[d1aoff[hk] + nn*amopi_[hk]+kk] += u_p[ijk_id + lmn]; // + D1(n,k) djm dil
-            }
-        }
-
-        /*for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
-
             int i = bas_aab_sym[h][ijk][0];
             int j = bas_aab_sym[h][ijk][1];
             int k = bas_aab_sym[h][ijk][2];
@@ -2959,86 +1352,89 @@ void v2RDMSolver::T2_constraints_ATu(SharedVector A,SharedVector u){
                 int n = bas_aab_sym[h][lmn][2];
 
                 int id = ijk*(trip_aab[h]+trip_aba[h])+lmn;
+                //int id = ijk*trip_aab[h]+lmn;
 
-                double dum = u_p[offset + id];
-
-                A_p[t2aaaoff[h] + id] -= dum; // - T2(ijk,lmn)
+                double dum = 0.0;//-u_p[t2aaaoff[h] + id]; // - T2(ijk,lmn)
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
-                    A_p[d2aaoff[hij] + ij*gems_aa[hij]+lm] += dum; // + D2(ij,lm) dkn
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
+                    dum += u_p[d2aaoff[hij] + ij*gems_aa[hij]+lm]; // + D2(ij,lm) dkn
                 }
 
                 if ( j == m && i == l ) {
                     int h2 = symmetry[k];
                     int kk = k - pitzer_offset[h2];
                     int nn = n - pitzer_offset[h2];
-                    A_p[d1aoff[h2] + nn*amopi_[h2]+kk] += dum; // + D1(n,k) djm dil
+                    dum += u_p[d1aoff[h2] + nn*amopi_[h2]+kk]; // + D1(n,k) djm dil
                 }
                 if ( j == l && i == m ) {
                     int h2 = symmetry[k];
                     int kk = k - pitzer_offset[h2];
                     int nn = n - pitzer_offset[h2];
-                    A_p[d1aoff[h2] + nn*amopi_[h2]+kk] -= dum; // - D1(n,k) djl dim
+                    dum -= u_p[d1aoff[h2] + nn*amopi_[h2]+kk]; // - D1(n,k) djl dim
                 }
 
                 if ( i == l ) {
                     if ( n != j && k != m ) {
                         int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int km = ibas_aa_sym[hnj][k][m];
+                        int nj = ibas_aa(n,j);
+                        int km = ibas_aa(k,m);
 
                         int s = 1;
                         if ( n > j ) s = -s;
                         if ( k > m ) s = -s;
 
-                        A_p[d2aaoff[hnj] + nj*gems_aa[hnj]+km] -= s * dum; // - D2(nj,km) dil
+                        dum -= s * u_p[d2aaoff[hnj] + nj*gems_aa[hnj]+km]; // - D2(nj,km) dil
                     }
                 }
                 if ( j == l ) {
                     if ( n != i && k != m ) {
                         int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                        int ni = ibas_aa_sym[hni][n][i];
-                        int km = ibas_aa_sym[hni][k][m];
+                        int ni = ibas_aa(n,i);
+                        int km = ibas_aa(k,m);
 
                         int s = 1;
                         if ( n > i ) s = -s;
                         if ( k > m ) s = -s;
 
-                        A_p[d2aaoff[hni] + ni*gems_aa[hni]+km] += s * dum; // D2(ni,km) djl
+                        dum += s * u_p[d2aaoff[hni] + ni*gems_aa[hni]+km]; // D2(ni,km) djl
                     }
                 }
                 if ( i == m ) {
                     if ( n != j && k != l ) {
                         int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int kl = ibas_aa_sym[hnj][k][l];
+                        int nj = ibas_aa(n,j);
+                        int kl = ibas_aa(k,l);
 
                         int s = 1;
                         if ( n > j ) s = -s;
                         if ( k > l ) s = -s;
 
-                        A_p[d2aaoff[hnj] + nj*gems_aa[hnj]+kl] += s * dum; // D2(nj,kl) dim
+                        dum += s * u_p[d2aaoff[hnj] + nj*gems_aa[hnj]+kl]; // D2(nj,kl) dim
                     }
                 }
                 if ( j == m ) {
                     if ( n != i && k != l ) {
                         int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                        int ni = ibas_aa_sym[hni][n][i];
-                        int kl = ibas_aa_sym[hni][k][l];
+                        int ni = ibas_aa(n,i);
+                        int kl = ibas_aa(k,l);
 
                         int s = 1;
                         if ( n > i ) s = -s;
                         if ( k > l ) s = -s;
 
-                        A_p[d2aaoff[hni] + ni*gems_aa[hni]+kl] -= s * dum; // -D2(ni,kl) djm
+                        dum -= s * u_p[d2aaoff[hni] + ni*gems_aa[hni]+kl]; // -D2(ni,kl) djm
                     }
                 }
+    
+                u_p[t2aaaoff[h] + id] = dum; // - T2(ijk,lmn)
+
             }
-        }*/
+        }
         // T2aaa/abb
+        #pragma omp parallel for schedule (static)
         for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
 
             int i = bas_aab_sym[h][ijk][0];
@@ -3052,30 +1448,30 @@ void v2RDMSolver::T2_constraints_ATu(SharedVector A,SharedVector u){
                 int n = bas_aba_sym[h][lmn][2];
 
                 int id = ijk*(trip_aab[h]+trip_aba[h])+(lmn+trip_aab[h]);
-                double dum = u_p[offset + id];
-
-                int id2 = (lmn+trip_aab[h])*(trip_aab[h]+trip_aba[h])+ijk;
-                double dum2 = u_p[offset + id2];
 
-                //A_p[t2aaaoff[h] + id] -= dum; // - T2(ijk,lmn)
+                double dum = 0.0;//-u_p[t2aaaoff[h] + id]; // - T2(ijk,lmn)
 
                 if ( i == l ) {
                     int hjn = SymmetryPair(symmetry[j],symmetry[n]);
-                    int jn = ibas_ab_sym[hjn][j][n];
-                    int km = ibas_ab_sym[hjn][k][m];
-                    A_p[d2aboff[hjn]+jn*gems_ab[hjn]+km] += dum + dum2; // D2(jn,km) dil
+                    int jn = ibas_ab(j,n);
+                    int km = ibas_ab(k,m);
+                    dum += u_p[d2aboff[hjn]+jn*gems_ab[hjn]+km]; // D2(jn,km) dil
                 }
                 if ( j == l ) {
                     int hin = SymmetryPair(symmetry[i],symmetry[n]);
-                    int in = ibas_ab_sym[hin][i][n];
-                    int km = ibas_ab_sym[hin][k][m];
-                    A_p[d2aboff[hin]+in*gems_ab[hin]+km] -= dum + dum2; // -D2(in,km) djl
+                    int in = ibas_ab(i,n);
+                    int km = ibas_ab(k,m);
+                    dum -= u_p[d2aboff[hin]+in*gems_ab[hin]+km]; // -D2(in,km) djl
                 }
+
+                u_p[t2aaaoff[h] + id] = 0.0; // - T2(ijk,lmn)
+
             }
         }
 
         // T2abb/aaa
-        /*for (int ijk = 0; ijk < trip_aba[h]; ijk++) {
+        #pragma omp parallel for schedule (static)
+        for (int ijk = 0; ijk < trip_aba[h]; ijk++) {
 
             int i = bas_aba_sym[h][ijk][0];
             int j = bas_aba_sym[h][ijk][1];
@@ -3089,26 +1485,28 @@ void v2RDMSolver::T2_constraints_ATu(SharedVector A,SharedVector u){
 
                 int id = (ijk+trip_aab[h])*(trip_aab[h]+trip_aba[h])+lmn;
 
-                double dum = u_p[offset + id];
-
-                //A_p[t2aaaoff[h] + id] -= dum; // - T2(ijk,lmn)
+                double dum = 0.0;//-u_p[t2aaaoff[h] + id]; // - T2(ijk,lmn)
 
                 if ( i == l ) {
                     int hjn = SymmetryPair(symmetry[j],symmetry[n]);
-                    int jn = ibas_ab_sym[hjn][n][j];
-                    int km = ibas_ab_sym[hjn][m][k];
-                    A_p[d2aboff[hjn]+jn*gems_ab[hjn]+km] += dum; // D2(jn,km) dil
+                    int jn = ibas_ab(n,j);
+                    int km = ibas_ab(m,k);
+                    dum += u_p[d2aboff[hjn]+jn*gems_ab[hjn]+km]; // D2(jn,km) dil
                 }
                 if ( i == m ) {
                     int hnj = SymmetryPair(symmetry[j],symmetry[n]);
-                    int nj = ibas_ab_sym[hnj][n][j];
-                    int lk = ibas_ab_sym[hnj][l][k];
-                    A_p[d2aboff[hnj]+nj*gems_ab[hnj]+lk] -= dum; // -D2(in,km) djl
+                    int nj = ibas_ab(n,j);
+                    int lk = ibas_ab(l,k);
+                    dum -= u_p[d2aboff[hnj]+nj*gems_ab[hnj]+lk]; // -D2(in,km) djl
                 }
+
+                u_p[t2aaaoff[h] + id] = dum; // - T2(ijk,lmn)
+
             }
-        }*/
+        }
 
         // T2abb/abb
+        #pragma omp parallel for schedule (static)
         for (int ijk = 0; ijk < trip_aba[h]; ijk++) {
 
             int i = bas_aba_sym[h][ijk][0];
@@ -3123,46 +1521,47 @@ void v2RDMSolver::T2_constraints_ATu(SharedVector A,SharedVector u){
 
                 int id = (ijk+trip_aab[h])*(trip_aab[h]+trip_aba[h])+(lmn+trip_aab[h]);
 
-                double dum = u_p[offset + id];
-
-                //A_p[t2aaaoff[h] + id] -= dum; // - T2(ijk,lmn)
+                double dum = 0.0;//-u_p[t2aaaoff[h] + id]; // - T2(ijk,lmn)
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_ab_sym[hij][i][j];
-                    int lm = ibas_ab_sym[hij][l][m];
-                    A_p[d2aboff[hij] + ij*gems_ab[hij]+lm] += dum; // + D2(ij,lm) dkn
+                    int ij = ibas_ab(i,j);
+                    int lm = ibas_ab(l,m);
+                    dum += u_p[d2aboff[hij] + ij*gems_ab[hij]+lm]; // + D2(ij,lm) dkn
                 }
 
                 if ( j == m && i == l ) {
                     int h2 = symmetry[k];
                     int kk = k - pitzer_offset[h2];
                     int nn = n - pitzer_offset[h2];
-                    A_p[d1boff[h2] + nn*amopi_[h2]+kk] += dum; // + D1(n,k) djm dil
+                    dum += u_p[d1boff[h2] + nn*amopi_[h2]+kk]; // + D1(n,k) djm dil
                 }
 
                 if ( i == l ) {
                     if ( n != j && k != m ) {
                         int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int km = ibas_aa_sym[hnj][k][m];
+                        int nj = ibas_aa(n,j);
+                        int km = ibas_aa(k,m);
 
                         int s = 1;
                         if ( n > j ) s = -s;
                         if ( k > m ) s = -s;
 
-                        A_p[d2bboff[hnj] + nj*gems_aa[hnj]+km] -= s * dum; // - D2(nj,km) dil
+                        dum -= s * u_p[d2bboff[hnj] + nj*gems_aa[hnj]+km]; // - D2(nj,km) dil
                     }
                 }
                 if ( j == m ) {
                     int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][i][n];
-                    int kl = ibas_ab_sym[hni][l][k];
-                    A_p[d2aboff[hni] + ni*gems_ab[hni]+kl] -= dum; // -D2(ni,kl) djm
+                    int ni = ibas_ab(i,n);
+                    int kl = ibas_ab(l,k);
+                    dum -= u_p[d2aboff[hni] + ni*gems_ab[hni]+kl]; // -D2(ni,kl) djm
                 }
+    
+                u_p[t2aaaoff[h] + id] = dum; // - T2(ijk,lmn)
+
             }
         }
-        C_DAXPY((trip_aba[h] + trip_aab[h]) * (trip_aba[h] + trip_aab[h]), -1.0, &u_p[offset],1,&A_p[t2aaaoff[h]],1);
+        //C_DAXPY((trip_aba[h] + trip_aab[h]) * (trip_aba[h] + trip_aab[h]), -1.0, &u_p[t2aaaoff[h]],1,&A_p[offset],1);
         offset += (trip_aba[h]+trip_aab[h])*(trip_aba[h]+trip_aab[h]);
         //offset += trip_aab[h]*trip_aab[h];
     }
@@ -3171,6 +1570,7 @@ void v2RDMSolver::T2_constraints_ATu(SharedVector A,SharedVector u){
     for (int h = 0; h < nirrep_; h++) {
 
         // T2bbb/bbb
+        #pragma omp parallel for schedule (static)
         for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
 
             int i = bas_aab_sym[h][ijk][0];
@@ -3186,85 +1586,87 @@ void v2RDMSolver::T2_constraints_ATu(SharedVector A,SharedVector u){
                 int id = ijk*(trip_aab[h]+trip_aba[h])+lmn;
                 //int id = ijk*trip_aab[h]+lmn;
 
-                double dum = u_p[offset + id];
-
-                //A_p[t2bbboff[h] + id] -= dum; // - T2(ijk,lmn)
+                double dum = 0.0;//-u_p[t2bbboff[h] + id]; // - T2(ijk,lmn)
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
-                    A_p[d2bboff[hij] + ij*gems_aa[hij]+lm] += dum; // + D2(ij,lm) dkn
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
+                    dum += u_p[d2bboff[hij] + ij*gems_aa[hij]+lm]; // + D2(ij,lm) dkn
                 }
 
                 if ( j == m && i == l ) {
                     int h2 = symmetry[k];
                     int kk = k - pitzer_offset[h2];
                     int nn = n - pitzer_offset[h2];
-                    A_p[d1boff[h2] + nn*amopi_[h2]+kk] += dum; // + D1(n,k) djm dil
+                    dum += u_p[d1boff[h2] + nn*amopi_[h2]+kk]; // + D1(n,k) djm dil
                 }
                 if ( j == l && i == m ) {
                     int h2 = symmetry[k];
                     int kk = k - pitzer_offset[h2];
                     int nn = n - pitzer_offset[h2];
-                    A_p[d1boff[h2] + nn*amopi_[h2]+kk] -= dum; // - D1(n,k) djl dim
+                    dum -= u_p[d1boff[h2] + nn*amopi_[h2]+kk]; // - D1(n,k) djl dim
                 }
 
                 if ( i == l ) {
                     if ( n != j && k != m ) {
                         int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int km = ibas_aa_sym[hnj][k][m];
+                        int nj = ibas_aa(n,j);
+                        int km = ibas_aa(k,m);
 
                         int s = 1;
                         if ( n > j ) s = -s;
                         if ( k > m ) s = -s;
 
-                        A_p[d2bboff[hnj] + nj*gems_aa[hnj]+km] -= s * dum; // - D2(nj,km) dil
+                        dum -= s * u_p[d2bboff[hnj] + nj*gems_aa[hnj]+km]; // - D2(nj,km) dil
                     }
                 }
                 if ( j == l ) {
                     if ( n != i && k != m ) {
                         int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                        int ni = ibas_aa_sym[hni][n][i];
-                        int km = ibas_aa_sym[hni][k][m];
+                        int ni = ibas_aa(n,i);
+                        int km = ibas_aa(k,m);
 
                         int s = 1;
                         if ( n > i ) s = -s;
                         if ( k > m ) s = -s;
 
-                        A_p[d2bboff[hni] + ni*gems_aa[hni]+km] += s * dum; // D2(ni,km) djl
+                        dum += s * u_p[d2bboff[hni] + ni*gems_aa[hni]+km]; // D2(ni,km) djl
                     }
                 }
                 if ( i == m ) {
                     if ( n != j && k != l ) {
                         int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int kl = ibas_aa_sym[hnj][k][l];
+                        int nj = ibas_aa(n,j);
+                        int kl = ibas_aa(k,l);
 
                         int s = 1;
                         if ( n > j ) s = -s;
                         if ( k > l ) s = -s;
 
-                        A_p[d2bboff[hnj] + nj*gems_aa[hnj]+kl] += s * dum; // D2(nj,kl) dim
+                        dum += s * u_p[d2bboff[hnj] + nj*gems_aa[hnj]+kl]; // D2(nj,kl) dim
                     }
                 }
                 if ( j == m ) {
                     if ( n != i && k != l ) {
                         int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                        int ni = ibas_aa_sym[hni][n][i];
-                        int kl = ibas_aa_sym[hni][k][l];
+                        int ni = ibas_aa(n,i);
+                        int kl = ibas_aa(k,l);
 
                         int s = 1;
                         if ( n > i ) s = -s;
                         if ( k > l ) s = -s;
 
-                        A_p[d2bboff[hni] + ni*gems_aa[hni]+kl] -= s * dum; // -D2(ni,kl) djm
+                        dum -= s * u_p[d2bboff[hni] + ni*gems_aa[hni]+kl]; // -D2(ni,kl) djm
                     }
                 }
+    
+                u_p[t2bbboff[h] + id] = dum; // - T2(ijk,lmn)
+
             }
         }
         // T2bbb/baa
+        #pragma omp parallel for schedule (static)
         for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
 
             int i = bas_aab_sym[h][ijk][0];
@@ -3278,30 +1680,30 @@ void v2RDMSolver::T2_constraints_ATu(SharedVector A,SharedVector u){
                 int n = bas_aba_sym[h][lmn][2];
 
                 int id = ijk*(trip_aab[h]+trip_aba[h])+(lmn+trip_aab[h]);
-                double dum = u_p[offset + id];
-
-                int id2 = (lmn+trip_aab[h])*(trip_aab[h]+trip_aba[h])+ijk;
-                double dum2 = u_p[offset + id2];
 
-                //A_p[t2bbboff[h] + id] -= dum; // - T2(ijk,lmn)
+                double dum = 0.0;//-u_p[t2bbboff[h] + id]; // - T2(ijk,lmn)
 
                 if ( i == l ) {
                     int hjn = SymmetryPair(symmetry[j],symmetry[n]);
-                    int jn = ibas_ab_sym[hjn][n][j];
-                    int km = ibas_ab_sym[hjn][m][k];
-                    A_p[d2aboff[hjn]+jn*gems_ab[hjn]+km] += dum + dum2; // D2(jn,km) dil
+                    int jn = ibas_ab(n,j);
+                    int km = ibas_ab(m,k);
+                    dum += u_p[d2aboff[hjn]+jn*gems_ab[hjn]+km]; // D2(jn,km) dil
                 }
                 if ( j == l ) {
                     int hin = SymmetryPair(symmetry[i],symmetry[n]);
-                    int in = ibas_ab_sym[hin][n][i];
-                    int km = ibas_ab_sym[hin][m][k];
-                    A_p[d2aboff[hin]+in*gems_ab[hin]+km] -= dum + dum2; // -D2(in,km) djl
+                    int in = ibas_ab(n,i);
+                    int km = ibas_ab(m,k);
+                    dum -= u_p[d2aboff[hin]+in*gems_ab[hin]+km]; // -D2(in,km) djl
                 }
+
+                u_p[t2bbboff[h] + id] = dum; // - T2(ijk,lmn)
+
             }
         }
 
         // T2baa/bbb
-        /*for (int ijk = 0; ijk < trip_aba[h]; ijk++) {
+        #pragma omp parallel for schedule (static)
+        for (int ijk = 0; ijk < trip_aba[h]; ijk++) {
 
             int i = bas_aba_sym[h][ijk][0];
             int j = bas_aba_sym[h][ijk][1];
@@ -3315,26 +1717,27 @@ void v2RDMSolver::T2_constraints_ATu(SharedVector A,SharedVector u){
 
                 int id = (ijk+trip_aab[h])*(trip_aab[h]+trip_aba[h])+lmn;
 
-                double dum = u_p[offset + id];
-
-                //A_p[t2bbboff[h] + id] -= dum; // - T2(ijk,lmn)
+                double dum = 0.0;//-u_p[t2bbboff[h] + id]; // - T2(ijk,lmn)
 
                 if ( i == l ) {
                     int hjn = SymmetryPair(symmetry[j],symmetry[n]);
-                    int jn = ibas_ab_sym[hjn][j][n];
-                    int km = ibas_ab_sym[hjn][k][m];
-                    A_p[d2aboff[hjn]+jn*gems_ab[hjn]+km] += dum; // D2(jn,km) dil
+                    int jn = ibas_ab(j,n);
+                    int km = ibas_ab(k,m);
+                    dum += u_p[d2aboff[hjn]+jn*gems_ab[hjn]+km]; // D2(jn,km) dil
                 }
                 if ( i == m ) {
                     int hnj = SymmetryPair(symmetry[j],symmetry[n]);
-                    int nj = ibas_ab_sym[hnj][j][n];
-                    int lk = ibas_ab_sym[hnj][k][l];
-                    A_p[d2aboff[hnj]+nj*gems_ab[hnj]+lk] -= dum; // -D2(in,km) djl
+                    int nj = ibas_ab(j,n);
+                    int lk = ibas_ab(k,l);
+                    dum -= u_p[d2aboff[hnj]+nj*gems_ab[hnj]+lk]; // -D2(in,km) djl
                 }
-            }
-        }*/
 
+                u_p[t2bbboff[h] + id] = dum; // - T2(ijk,lmn)
+
+            }
+        }
         // T2baa/baa
+        #pragma omp parallel for schedule (static)
         for (int ijk = 0; ijk < trip_aba[h]; ijk++) {
 
             int i = bas_aba_sym[h][ijk][0];
@@ -3349,65 +1752,121 @@ void v2RDMSolver::T2_constraints_ATu(SharedVector A,SharedVector u){
 
                 int id = (ijk+trip_aab[h])*(trip_aab[h]+trip_aba[h])+(lmn+trip_aab[h]);
 
-                double dum = u_p[offset + id];
-
-                ///A_p[t2bbboff[h] + id] -= dum; // - T2(ijk,lmn)
+                double dum = 0.0;//-u_p[t2bbboff[h] + id]; // - T2(ijk,lmn)
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_ab_sym[hij][j][i];
-                    int lm = ibas_ab_sym[hij][m][l];
-                    A_p[d2aboff[hij] + ij*gems_ab[hij]+lm] += dum; // + D2(ij,lm) dkn
+                    int ij = ibas_ab(j,i);
+                    int lm = ibas_ab(m,l);
+                    dum += u_p[d2aboff[hij] + ij*gems_ab[hij]+lm]; // + D2(ij,lm) dkn
                 }
 
                 if ( j == m && i == l ) {
                     int h2 = symmetry[k];
                     int kk = k - pitzer_offset[h2];
                     int nn = n - pitzer_offset[h2];
-                    A_p[d1aoff[h2] + nn*amopi_[h2]+kk] += dum; // + D1(n,k) djm dil
+                    dum += u_p[d1aoff[h2] + nn*amopi_[h2]+kk]; // + D1(n,k) djm dil
                 }
 
                 if ( i == l ) {
                     if ( n != j && k != m ) {
                         int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int km = ibas_aa_sym[hnj][k][m];
+                        int nj = ibas_aa(n,j);
+                        int km = ibas_aa(k,m);
 
                         int s = 1;
                         if ( n > j ) s = -s;
                         if ( k > m ) s = -s;
 
-                        A_p[d2aaoff[hnj] + nj*gems_aa[hnj]+km] -= s * dum; // - D2(nj,km) dil
+                        dum -= s * u_p[d2aaoff[hnj] + nj*gems_aa[hnj]+km]; // - D2(nj,km) dil
                     }
                 }
                 if ( j == m ) {
                     int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int kl = ibas_ab_sym[hni][k][l];
-                    A_p[d2aboff[hni] + ni*gems_ab[hni]+kl] -= dum; // -D2(ni,kl) djm
+                    int ni = ibas_ab(n,i);
+                    int kl = ibas_ab(k,l);
+                    dum -= u_p[d2aboff[hni] + ni*gems_ab[hni]+kl]; // -D2(ni,kl) djm
                 }
+    
+                u_p[t2bbboff[h] + id] = dum; // - T2(ijk,lmn)
+
             }
         }
-        C_DAXPY((trip_aba[h] + trip_aab[h]) * (trip_aba[h] + trip_aab[h]), -1.0, &u_p[offset],1,&A_p[t2bbboff[h]],1);
+        //C_DAXPY((trip_aba[h] + trip_aab[h]) * (trip_aba[h] + trip_aab[h]), -1.0, &u_p[t2bbboff[h]],1,&A_p[offset],1);
         offset += (trip_aba[h]+trip_aab[h])*(trip_aba[h]+trip_aab[h]);
         //offset += trip_aab[h]*trip_aab[h];
     }
 #endif
 
 }
+
+// T2 portion of A^T.y
+template <class Symmetry>
+void v2RDMSolver::T2_constraints_ATu_kernel(SharedVector A,SharedVector u,const SkippedBlocks & skip){
+
+    Symmetry sym(nirrep_,symmetry,pitzer_offset,amopi_,table);
+
+    double * A_p = A->pointer();
+    double * u_p = u->pointer();
+
+    ZeroATuBuffers();
+
+    // T2aab
+    for (int h = 0; h < sym.nirrep(); h++) {
+        T2_constraints_aab_terms<Symmetry>(sym,A_p,u_p,h,offset,t2aaboff[h],false,T2_ATU,skip.t2);
+        offset += trip_aab[h]*trip_aab[h];
+    }
+
+    // T2bba
+    for (int h = 0; h < sym.nirrep(); h++) {
+        T2_constraints_aab_terms<Symmetry>(sym,A_p,u_p,h,offset,t2bbaoff[h],true,T2_ATU,skip.t2);
+        offset += trip_aab[h]*trip_aab[h];
+    }
+
+    // big block 1: T2aaa + T2abb
+    for (int h = 0; h < sym.nirrep(); h++) {
+        T2_constraints_aaa_terms<Symmetry>(sym,A_p,u_p,h,offset,t2aaaoff[h],false,T2_ATU,skip.t2);
+        offset += (trip_aba[h]+trip_aab[h])*(trip_aba[h]+trip_aab[h]);
+    }
+
+    // big block 2: T2bbb + T2baa
+    for (int h = 0; h < sym.nirrep(); h++) {
+        T2_constraints_aaa_terms<Symmetry>(sym,A_p,u_p,h,offset,t2bbboff[h],true,T2_ATU,skip.t2);
+        offset += (trip_aba[h]+trip_aab[h])*(trip_aba[h]+trip_aab[h]);
+    }
+
+    ReduceATuBuffers(A_p);
+
+}
+
+void v2RDMSolver::T2_constraints_ATu(SharedVector A,SharedVector u){
+    (this->*T2_constraints_ATu_fn_)(A,u,SkippedBlocks());
+}
+
+void v2RDMSolver::T2_constraints_ATu(SharedVector A,SharedVector u,const SkippedBlocks & skip){
+    (this->*T2_constraints_ATu_fn_)(A,u,skip);
+}
 // T2 portion of A^T.y (slow version!)
 void v2RDMSolver::T2_constraints_ATu_slow(SharedVector A,SharedVector u){
 
     double * A_p = A->pointer();
     double * u_p = u->pointer();
 
+    // each row maps to a unique T2 element, so those contributions are
+    // written directly to A_p.  contributions to the D2, D1, Q2, and G2
+    // blocks are accumulated in per-thread buffers and reduced at the end.
+    ZeroATuBuffers();
+
     int saveoff = offset;
 
     // T2aab
     for (int h = 0; h < nirrep_; h++) {
 
+        #pragma omp parallel for schedule (static) num_threads(ATu_nthreads_)
         for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
 
+            double * myA_p = ATu_buffer_ + omp_get_thread_num() * dimx_d2q2g2_;
+
             int i = bas_aab_sym[h][ijk][0];
             int j = bas_aab_sym[h][ijk][1];
             int k = bas_aab_sym[h][ijk][2];
@@ -3424,47 +1883,47 @@ void v2RDMSolver::T2_constraints_ATu_slow(SharedVector A,SharedVector u){
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
-                    A_p[d2aaoff[hij] + ij*gems_aa[hij]+lm] += dum; // + D2(ij,lm) dkn
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
+                    myA_p[d2aaoff[hij] + ij*gems_aa[hij]+lm] += dum; // + D2(ij,lm) dkn
                 }
 
                 if ( j == m && i == l ) {
                     int h2 = symmetry[k];
                     int kk = k - pitzer_offset[h2];
                     int nn = n - pitzer_offset[h2];
-                    A_p[d1boff[h2] + nn*amopi_[h2]+kk] += dum; // + D1(n,k) djm dil
+                    myA_p[d1boff[h2] + nn*amopi_[h2]+kk] += dum; // + D1(n,k) djm dil
                 }
                 if ( j == l && i == m ) {
                     int h2 = symmetry[k];
                     int kk = k - pitzer_offset[h2];
                     int nn = n - pitzer_offset[h2];
-                    A_p[d1boff[h2] + nn*amopi_[h2]+kk] -= dum; // - D1(n,k) djl dim
+                    myA_p[d1boff[h2] + nn*amopi_[h2]+kk] -= dum; // - D1(n,k) djl dim
                 }
 
                 if ( i == l ) {
                     int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                    int nj = ibas_ab_sym[hnj][j][n];
-                    int km = ibas_ab_sym[hnj][m][k];
-                    A_p[d2aboff[hnj] + nj*gems_ab[hnj]+km] -= dum; // - D2(nj,km) dil
+                    int nj = ibas_ab(j,n);
+                    int km = ibas_ab(m,k);
+                    myA_p[d2aboff[hnj] + nj*gems_ab[hnj]+km] -= dum; // - D2(nj,km) dil
                 }
                 if ( j == l ) {
                     int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][i][n];
-                    int km = ibas_ab_sym[hni][m][k];
-                    A_p[d2aboff[hni] + ni*gems_ab[hni]+km] += dum; // D2(ni,km) djl
+                    int ni = ibas_ab(i,n);
+                    int km = ibas_ab(m,k);
+                    myA_p[d2aboff[hni] + ni*gems_ab[hni]+km] += dum; // D2(ni,km) djl
                 }
                 if ( i == m ) {
                     int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                    int nj = ibas_ab_sym[hnj][j][n];
-                    int kl = ibas_ab_sym[hnj][l][k];
-                    A_p[d2aboff[hnj] + nj*gems_ab[hnj]+kl] += dum; // D2(nj,kl) dim
+                    int nj = ibas_ab(j,n);
+                    int kl = ibas_ab(l,k);
+                    myA_p[d2aboff[hnj] + nj*gems_ab[hnj]+kl] += dum; // D2(nj,kl) dim
                 }
                 if ( j == m ) {
                     int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][i][n];
-                    int kl = ibas_ab_sym[hni][l][k];
-                    A_p[d2aboff[hni] + ni*gems_ab[hni]+kl] -= dum; // -D2(ni,kl) djm
+                    int ni = ibas_ab(i,n);
+                    int kl = ibas_ab(l,k);
+                    myA_p[d2aboff[hni] + ni*gems_ab[hni]+kl] -= dum; // -D2(ni,kl) djm
                 }
             }
         }
@@ -3476,8 +1935,11 @@ void v2RDMSolver::T2_constraints_ATu_slow(SharedVector A,SharedVector u){
     // T2bba
     for (int h = 0; h < nirrep_; h++) {
 
+        #pragma omp parallel for schedule (static) num_threads(ATu_nthreads_)
         for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
 
+            double * myA_p = ATu_buffer_ + omp_get_thread_num() * dimx_d2q2g2_;
+
             int i = bas_aab_sym[h][ijk][0];
             int j = bas_aab_sym[h][ijk][1];
             int k = bas_aab_sym[h][ijk][2];
@@ -3494,47 +1956,47 @@ void v2RDMSolver::T2_constraints_ATu_slow(SharedVector A,SharedVector u){
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
-                    A_p[d2bboff[hij] + ij*gems_aa[hij]+lm] += dum; // + D2(ij,lm) dkn
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
+                    myA_p[d2bboff[hij] + ij*gems_aa[hij]+lm] += dum; // + D2(ij,lm) dkn
                 }
 
                 if ( j == m && i == l ) {
                     int h2 = symmetry[k];
                     int kk = k - pitzer_offset[h2];
                     int nn = n - pitzer_offset[h2];
-                    A_p[d1aoff[h2] + nn*amopi_[h2]+kk] += dum; // + D1(n,k) djm dil
+                    myA_p[d1aoff[h2] + nn*amopi_[h2]+kk] += dum; // + D1(n,k) djm dil
                 }
                 if ( j == l && i == m ) {
                     int h2 = symmetry[k];
                     int kk = k - pitzer_offset[h2];
                     int nn = n - pitzer_offset[h2];
-                    A_p[d1aoff[h2] + nn*amopi_[h2]+kk] -= dum; // - D1(n,k) djl dim
+                    myA_p[d1aoff[h2] + nn*amopi_[h2]+kk] -= dum; // - D1(n,k) djl dim
                 }
 
                 if ( i == l ) {
                     int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                    int nj = ibas_ab_sym[hnj][n][j];
-                    int km = ibas_ab_sym[hnj][k][m];
-                    A_p[d2aboff[hnj] + nj*gems_ab[hnj]+km] -= dum; // - D2(nj,km) dil
+                    int nj = ibas_ab(n,j);
+                    int km = ibas_ab(k,m);
+                    myA_p[d2aboff[hnj] + nj*gems_ab[hnj]+km] -= dum; // - D2(nj,km) dil
                 }
                 if ( j == l ) {
                     int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int km = ibas_ab_sym[hni][k][m];
-                    A_p[d2aboff[hni] + ni*gems_ab[hni]+km] += dum; // D2(ni,km) djl
+                    int ni = ibas_ab(n,i);
+                    int km = ibas_ab(k,m);
+                    myA_p[d2aboff[hni] + ni*gems_ab[hni]+km] += dum; // D2(ni,km) djl
                 }
                 if ( i == m ) {
                     int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                    int nj = ibas_ab_sym[hnj][n][j];
-                    int kl = ibas_ab_sym[hnj][k][l];
-                    A_p[d2aboff[hnj] + nj*gems_ab[hnj]+kl] += dum; // D2(nj,kl) dim
+                    int nj = ibas_ab(n,j);
+                    int kl = ibas_ab(k,l);
+                    myA_p[d2aboff[hnj] + nj*gems_ab[hnj]+kl] += dum; // D2(nj,kl) dim
                 }
                 if ( j == m ) {
                     int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int kl = ibas_ab_sym[hni][k][l];
-                    A_p[d2aboff[hni] + ni*gems_ab[hni]+kl] -= dum; // -D2(ni,kl) djm
+                    int ni = ibas_ab(n,i);
+                    int kl = ibas_ab(k,l);
+                    myA_p[d2aboff[hni] + ni*gems_ab[hni]+kl] -= dum; // -D2(ni,kl) djm
                 }
             }
         }
@@ -3545,8 +2007,11 @@ void v2RDMSolver::T2_constraints_ATu_slow(SharedVector A,SharedVector u){
     for (int h = 0; h < nirrep_; h++) {
 
         // T2aaa/aaa
+        #pragma omp parallel for schedule (static) num_threads(ATu_nthreads_)
         for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
 
+            double * myA_p = ATu_buffer_ + omp_get_thread_num() * dimx_d2q2g2_;
+
             int i = bas_aab_sym[h][ijk][0];
             int j = bas_aab_sym[h][ijk][1];
             int k = bas_aab_sym[h][ijk][2];
@@ -3566,81 +2031,84 @@ void v2RDMSolver::T2_constraints_ATu_slow(SharedVector A,SharedVector u){
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
-                    A_p[d2aaoff[hij] + ij*gems_aa[hij]+lm] += dum; // + D2(ij,lm) dkn
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
+                    myA_p[d2aaoff[hij] + ij*gems_aa[hij]+lm] += dum; // + D2(ij,lm) dkn
                 }
 
                 if ( j == m && i == l ) {
                     int h2 = symmetry[k];
                     int kk = k - pitzer_offset[h2];
                     int nn = n - pitzer_offset[h2];
-                    A_p[d1aoff[h2] + nn*amopi_[h2]+kk] += dum; // + D1(n,k) djm dil
+                    myA_p[d1aoff[h2] + nn*amopi_[h2]+kk] += dum; // + D1(n,k) djm dil
                 }
                 if ( j == l && i == m ) {
                     int h2 = symmetry[k];
                     int kk = k - pitzer_offset[h2];
                     int nn = n - pitzer_offset[h2];
-                    A_p[d1aoff[h2] + nn*amopi_[h2]+kk] -= dum; // - D1(n,k) djl dim
+                    myA_p[d1aoff[h2] + nn*amopi_[h2]+kk] -= dum; // - D1(n,k) djl dim
                 }
 
                 if ( i == l ) {
                     if ( n != j && k != m ) {
                         int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int km = ibas_aa_sym[hnj][k][m];
+                        int nj = ibas_aa(n,j);
+                        int km = ibas_aa(k,m);
 
                         int s = 1;
                         if ( n > j ) s = -s;
                         if ( k > m ) s = -s;
 
-                        A_p[d2aaoff[hnj] + nj*gems_aa[hnj]+km] -= s * dum; // - D2(nj,km) dil
+                        myA_p[d2aaoff[hnj] + nj*gems_aa[hnj]+km] -= s * dum; // - D2(nj,km) dil
                     }
                 }
                 if ( j == l ) {
                     if ( n != i && k != m ) {
                         int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                        int ni = ibas_aa_sym[hni][n][i];
-                        int km = ibas_aa_sym[hni][k][m];
+                        int ni = ibas_aa(n,i);
+                        int km = ibas_aa(k,m);
 
                         int s = 1;
                         if ( n > i ) s = -s;
                         if ( k > m ) s = -s;
 
-                        A_p[d2aaoff[hni] + ni*gems_aa[hni]+km] += s * dum; // D2(ni,km) djl
+                        myA_p[d2aaoff[hni] + ni*gems_aa[hni]+km] += s * dum; // D2(ni,km) djl
                     }
                 }
                 if ( i == m ) {
                     if ( n != j && k != l ) {
                         int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int kl = ibas_aa_sym[hnj][k][l];
+                        int nj = ibas_aa(n,j);
+                        int kl = ibas_aa(k,l);
 
                         int s = 1;
                         if ( n > j ) s = -s;
                         if ( k > l ) s = -s;
 
-                        A_p[d2aaoff[hnj] + nj*gems_aa[hnj]+kl] += s * dum; // D2(nj,kl) dim
+                        myA_p[d2aaoff[hnj] + nj*gems_aa[hnj]+kl] += s * dum; // D2(nj,kl) dim
                     }
                 }
                 if ( j == m ) {
                     if ( n != i && k != l ) {
                         int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                        int ni = ibas_aa_sym[hni][n][i];
-                        int kl = ibas_aa_sym[hni][k][l];
+                        int ni = ibas_aa(n,i);
+                        int kl = ibas_aa(k,l);
 
                         int s = 1;
                         if ( n > i ) s = -s;
                         if ( k > l ) s = -s;
 
-                        A_p[d2aaoff[hni] + ni*gems_aa[hni]+kl] -= s * dum; // -D2(ni,kl) djm
+                        myA_p[d2aaoff[hni] + ni*gems_aa[hni]+kl] -= s * dum; // -D2(ni,kl) djm
                     }
                 }
             }
         }
         // T2aaa/abb
+        #pragma omp parallel for schedule (static) num_threads(ATu_nthreads_)
         for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
 
+            double * myA_p = ATu_buffer_ + omp_get_thread_num() * dimx_d2q2g2_;
+
             int i = bas_aab_sym[h][ijk][0];
             int j = bas_aab_sym[h][ijk][1];
             int k = bas_aab_sym[h][ijk][2];
@@ -3659,22 +2127,25 @@ void v2RDMSolver::T2_constraints_ATu_slow(SharedVector A,SharedVector u){
 
                 if ( i == l ) {
                     int hjn = SymmetryPair(symmetry[j],symmetry[n]);
-                    int jn = ibas_ab_sym[hjn][j][n];
-                    int km = ibas_ab_sym[hjn][k][m];
-                    A_p[d2aboff[hjn]+jn*gems_ab[hjn]+km] += dum; // D2(jn,km) dil
+                    int jn = ibas_ab(j,n);
+                    int km = ibas_ab(k,m);
+                    myA_p[d2aboff[hjn]+jn*gems_ab[hjn]+km] += dum; // D2(jn,km) dil
                 }
                 if ( j == l ) {
                     int hin = SymmetryPair(symmetry[i],symmetry[n]);
-                    int in = ibas_ab_sym[hin][i][n];
-                    int km = ibas_ab_sym[hin][k][m];
-                    A_p[d2aboff[hin]+in*gems_ab[hin]+km] -= dum; // -D2(in,km) djl
+                    int in = ibas_ab(i,n);
+                    int km = ibas_ab(k,m);
+                    myA_p[d2aboff[hin]+in*gems_ab[hin]+km] -= dum; // -D2(in,km) djl
                 }
             }
         }
 
         // T2abb/aaa
+        #pragma omp parallel for schedule (static) num_threads(ATu_nthreads_)
         for (int ijk = 0; ijk < trip_aba[h]; ijk++) {
 
+            double * myA_p = ATu_buffer_ + omp_get_thread_num() * dimx_d2q2g2_;
+
             int i = bas_aba_sym[h][ijk][0];
             int j = bas_aba_sym[h][ijk][1];
             int k = bas_aba_sym[h][ijk][2];
@@ -3693,22 +2164,25 @@ void v2RDMSolver::T2_constraints_ATu_slow(SharedVector A,SharedVector u){
 
                 if ( i == l ) {
                     int hjn = SymmetryPair(symmetry[j],symmetry[n]);
-                    int jn = ibas_ab_sym[hjn][n][j];
-                    int km = ibas_ab_sym[hjn][m][k];
-                    A_p[d2aboff[hjn]+jn*gems_ab[hjn]+km] += dum; // D2(jn,km) dil
+                    int jn = ibas_ab(n,j);
+                    int km = ibas_ab(m,k);
+                    myA_p[d2aboff[hjn]+jn*gems_ab[hjn]+km] += dum; // D2(jn,km) dil
                 }
                 if ( i == m ) {
                     int hnj = SymmetryPair(symmetry[j],symmetry[n]);
-                    int nj = ibas_ab_sym[hnj][n][j];
-                    int lk = ibas_ab_sym[hnj][l][k];
-                    A_p[d2aboff[hnj]+nj*gems_ab[hnj]+lk] -= dum; // -D2(in,km) djl
+                    int nj = ibas_ab(n,j);
+                    int lk = ibas_ab(l,k);
+                    myA_p[d2aboff[hnj]+nj*gems_ab[hnj]+lk] -= dum; // -D2(in,km) djl
                 }
             }
         }
 
         // T2abb/abb
+        #pragma omp parallel for schedule (static) num_threads(ATu_nthreads_)
         for (int ijk = 0; ijk < trip_aba[h]; ijk++) {
 
+            double * myA_p = ATu_buffer_ + omp_get_thread_num() * dimx_d2q2g2_;
+
             int i = bas_aba_sym[h][ijk][0];
             int j = bas_aba_sym[h][ijk][1];
             int k = bas_aba_sym[h][ijk][2];
@@ -3727,36 +2201,36 @@ void v2RDMSolver::T2_constraints_ATu_slow(SharedVector A,SharedVector u){
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_ab_sym[hij][i][j];
-                    int lm = ibas_ab_sym[hij][l][m];
-                    A_p[d2aboff[hij] + ij*gems_ab[hij]+lm] += dum; // + D2(ij,lm) dkn
+                    int ij = ibas_ab(i,j);
+                    int lm = ibas_ab(l,m);
+                    myA_p[d2aboff[hij] + ij*gems_ab[hij]+lm] += dum; // + D2(ij,lm) dkn
                 }
 
                 if ( j == m && i == l ) {
                     int h2 = symmetry[k];
                     int kk = k - pitzer_offset[h2];
                     int nn = n - pitzer_offset[h2];
-                    A_p[d1boff[h2] + nn*amopi_[h2]+kk] += dum; // + D1(n,k) djm dil
+                    myA_p[d1boff[h2] + nn*amopi_[h2]+kk] += dum; // + D1(n,k) djm dil
                 }
 
                 if ( i == l ) {
                     if ( n != j && k != m ) {
                         int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int km = ibas_aa_sym[hnj][k][m];
+                        int nj = ibas_aa(n,j);
+                        int km = ibas_aa(k,m);
 
                         int s = 1;
                         if ( n > j ) s = -s;
                         if ( k > m ) s = -s;
 
-                        A_p[d2bboff[hnj] + nj*gems_aa[hnj]+km] -= s * dum; // - D2(nj,km) dil
+                        myA_p[d2bboff[hnj] + nj*gems_aa[hnj]+km] -= s * dum; // - D2(nj,km) dil
                     }
                 }
                 if ( j == m ) {
                     int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][i][n];
-                    int kl = ibas_ab_sym[hni][l][k];
-                    A_p[d2aboff[hni] + ni*gems_ab[hni]+kl] -= dum; // -D2(ni,kl) djm
+                    int ni = ibas_ab(i,n);
+                    int kl = ibas_ab(l,k);
+                    myA_p[d2aboff[hni] + ni*gems_ab[hni]+kl] -= dum; // -D2(ni,kl) djm
                 }
             }
         }
@@ -3768,8 +2242,11 @@ void v2RDMSolver::T2_constraints_ATu_slow(SharedVector A,SharedVector u){
     for (int h = 0; h < nirrep_; h++) {
 
         // T2bbb/bbb
+        #pragma omp parallel for schedule (static) num_threads(ATu_nthreads_)
         for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
 
+            double * myA_p = ATu_buffer_ + omp_get_thread_num() * dimx_d2q2g2_;
+
             int i = bas_aab_sym[h][ijk][0];
             int j = bas_aab_sym[h][ijk][1];
             int k = bas_aab_sym[h][ijk][2];
@@ -3789,81 +2266,84 @@ void v2RDMSolver::T2_constraints_ATu_slow(SharedVector A,SharedVector u){
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
-                    A_p[d2bboff[hij] + ij*gems_aa[hij]+lm] += dum; // + D2(ij,lm) dkn
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
+                    myA_p[d2bboff[hij] + ij*gems_aa[hij]+lm] += dum; // + D2(ij,lm) dkn
                 }
 
                 if ( j == m && i == l ) {
                     int h2 = symmetry[k];
                     int kk = k - pitzer_offset[h2];
                     int nn = n - pitzer_offset[h2];
-                    A_p[d1boff[h2] + nn*amopi_[h2]+kk] += dum; // + D1(n,k) djm dil
+                    myA_p[d1boff[h2] + nn*amopi_[h2]+kk] += dum; // + D1(n,k) djm dil
                 }
                 if ( j == l && i == m ) {
                     int h2 = symmetry[k];
                     int kk = k - pitzer_offset[h2];
                     int nn = n - pitzer_offset[h2];
-                    A_p[d1boff[h2] + nn*amopi_[h2]+kk] -= dum; // - D1(n,k) djl dim
+                    myA_p[d1boff[h2] + nn*amopi_[h2]+kk] -= dum; // - D1(n,k) djl dim
                 }
 
                 if ( i == l ) {
                     if ( n != j && k != m ) {
                         int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int km = ibas_aa_sym[hnj][k][m];
+                        int nj = ibas_aa(n,j);
+                        int km = ibas_aa(k,m);
 
                         int s = 1;
                         if ( n > j ) s = -s;
                         if ( k > m ) s = -s;
 
-                        A_p[d2bboff[hnj] + nj*gems_aa[hnj]+km] -= s * dum; // - D2(nj,km) dil
+                        myA_p[d2bboff[hnj] + nj*gems_aa[hnj]+km] -= s * dum; // - D2(nj,km) dil
                     }
                 }
                 if ( j == l ) {
                     if ( n != i && k != m ) {
                         int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                        int ni = ibas_aa_sym[hni][n][i];
-                        int km = ibas_aa_sym[hni][k][m];
+                        int ni = ibas_aa(n,i);
+                        int km = ibas_aa(k,m);
 
                         int s = 1;
                         if ( n > i ) s = -s;
                         if ( k > m ) s = -s;
 
-                        A_p[d2bboff[hni] + ni*gems_aa[hni]+km] += s * dum; // D2(ni,km) djl
+                        myA_p[d2bboff[hni] + ni*gems_aa[hni]+km] += s * dum; // D2(ni,km) djl
                     }
                 }
                 if ( i == m ) {
                     if ( n != j && k != l ) {
                         int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int kl = ibas_aa_sym[hnj][k][l];
+                        int nj = ibas_aa(n,j);
+                        int kl = ibas_aa(k,l);
 
                         int s = 1;
                         if ( n > j ) s = -s;
                         if ( k > l ) s = -s;
 
-                        A_p[d2bboff[hnj] + nj*gems_aa[hnj]+kl] += s * dum; // D2(nj,kl) dim
+                        myA_p[d2bboff[hnj] + nj*gems_aa[hnj]+kl] += s * dum; // D2(nj,kl) dim
                     }
                 }
                 if ( j == m ) {
                     if ( n != i && k != l ) {
                         int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                        int ni = ibas_aa_sym[hni][n][i];
-                        int kl = ibas_aa_sym[hni][k][l];
+                        int ni = ibas_aa(n,i);
+                        int kl = ibas_aa(k,l);
 
                         int s = 1;
                         if ( n > i ) s = -s;
                         if ( k > l ) s = -s;
 
-                        A_p[d2bboff[hni] + ni*gems_aa[hni]+kl] -= s * dum; // -D2(ni,kl) djm
+                        myA_p[d2bboff[hni] + ni*gems_aa[hni]+kl] -= s * dum; // -D2(ni,kl) djm
                     }
                 }
             }
         }
         // T2bbb/baa
+        #pragma omp parallel for schedule (static) num_threads(ATu_nthreads_)
         for (int ijk = 0; ijk < trip_aab[h]; ijk++) {
 
+            double * myA_p = ATu_buffer_ + omp_get_thread_num() * dimx_d2q2g2_;
+
             int i = bas_aab_sym[h][ijk][0];
             int j = bas_aab_sym[h][ijk][1];
             int k = bas_aab_sym[h][ijk][2];
@@ -3882,22 +2362,25 @@ void v2RDMSolver::T2_constraints_ATu_slow(SharedVector A,SharedVector u){
 
                 if ( i == l ) {
                     int hjn = SymmetryPair(symmetry[j],symmetry[n]);
-                    int jn = ibas_ab_sym[hjn][n][j];
-                    int km = ibas_ab_sym[hjn][m][k];
-                    A_p[d2aboff[hjn]+jn*gems_ab[hjn]+km] += dum; // D2(jn,km) dil
+                    int jn = ibas_ab(n,j);
+                    int km = ibas_ab(m,k);
+                    myA_p[d2aboff[hjn]+jn*gems_ab[hjn]+km] += dum; // D2(jn,km) dil
                 }
                 if ( j == l ) {
                     int hin = SymmetryPair(symmetry[i],symmetry[n]);
-                    int in = ibas_ab_sym[hin][n][i];
-                    int km = ibas_ab_sym[hin][m][k];
-                    A_p[d2aboff[hin]+in*gems_ab[hin]+km] -= dum; // -D2(in,km) djl
+                    int in = ibas_ab(n,i);
+                    int km = ibas_ab(m,k);
+                    myA_p[d2aboff[hin]+in*gems_ab[hin]+km] -= dum; // -D2(in,km) djl
                 }
             }
         }
 
         // T2baa/bbb
+        #pragma omp parallel for schedule (static) num_threads(ATu_nthreads_)
         for (int ijk = 0; ijk < trip_aba[h]; ijk++) {
 
+            double * myA_p = ATu_buffer_ + omp_get_thread_num() * dimx_d2q2g2_;
+
             int i = bas_aba_sym[h][ijk][0];
             int j = bas_aba_sym[h][ijk][1];
             int k = bas_aba_sym[h][ijk][2];
@@ -3916,22 +2399,25 @@ void v2RDMSolver::T2_constraints_ATu_slow(SharedVector A,SharedVector u){
 
                 if ( i == l ) {
                     int hjn = SymmetryPair(symmetry[j],symmetry[n]);
-                    int jn = ibas_ab_sym[hjn][j][n];
-                    int km = ibas_ab_sym[hjn][k][m];
-                    A_p[d2aboff[hjn]+jn*gems_ab[hjn]+km] += dum; // D2(jn,km) dil
+                    int jn = ibas_ab(j,n);
+                    int km = ibas_ab(k,m);
+                    myA_p[d2aboff[hjn]+jn*gems_ab[hjn]+km] += dum; // D2(jn,km) dil
                 }
                 if ( i == m ) {
                     int hnj = SymmetryPair(symmetry[j],symmetry[n]);
-                    int nj = ibas_ab_sym[hnj][j][n];
-                    int lk = ibas_ab_sym[hnj][k][l];
-                    A_p[d2aboff[hnj]+nj*gems_ab[hnj]+lk] -= dum; // -D2(in,km) djl
+                    int nj = ibas_ab(j,n);
+                    int lk = ibas_ab(k,l);
+                    myA_p[d2aboff[hnj]+nj*gems_ab[hnj]+lk] -= dum; // -D2(in,km) djl
                 }
             }
         }
 
         // T2baa/baa
+        #pragma omp parallel for schedule (static) num_threads(ATu_nthreads_)
         for (int ijk = 0; ijk < trip_aba[h]; ijk++) {
 
+            double * myA_p = ATu_buffer_ + omp_get_thread_num() * dimx_d2q2g2_;
+
             int i = bas_aba_sym[h][ijk][0];
             int j = bas_aba_sym[h][ijk][1];
             int k = bas_aba_sym[h][ijk][2];
@@ -3950,36 +2436,36 @@ void v2RDMSolver::T2_constraints_ATu_slow(SharedVector A,SharedVector u){
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_ab_sym[hij][j][i];
-                    int lm = ibas_ab_sym[hij][m][l];
-                    A_p[d2aboff[hij] + ij*gems_ab[hij]+lm] += dum; // + D2(ij,lm) dkn
+                    int ij = ibas_ab(j,i);
+                    int lm = ibas_ab(m,l);
+                    myA_p[d2aboff[hij] + ij*gems_ab[hij]+lm] += dum; // + D2(ij,lm) dkn
                 }
 
                 if ( j == m && i == l ) {
                     int h2 = symmetry[k];
                     int kk = k - pitzer_offset[h2];
                     int nn = n - pitzer_offset[h2];
-                    A_p[d1aoff[h2] + nn*amopi_[h2]+kk] += dum; // + D1(n,k) djm dil
+                    myA_p[d1aoff[h2] + nn*amopi_[h2]+kk] += dum; // + D1(n,k) djm dil
                 }
 
                 if ( i == l ) {
                     if ( n != j && k != m ) {
                         int hnj = SymmetryPair(symmetry[n],symmetry[j]);
-                        int nj = ibas_aa_sym[hnj][n][j];
-                        int km = ibas_aa_sym[hnj][k][m];
+                        int nj = ibas_aa(n,j);
+                        int km = ibas_aa(k,m);
 
                         int s = 1;
                         if ( n > j ) s = -s;
                         if ( k > m ) s = -s;
 
-                        A_p[d2aaoff[hnj] + nj*gems_aa[hnj]+km] -= s * dum; // - D2(nj,km) dil
+                        myA_p[d2aaoff[hnj] + nj*gems_aa[hnj]+km] -= s * dum; // - D2(nj,km) dil
                     }
                 }
                 if ( j == m ) {
                     int hni = SymmetryPair(symmetry[n],symmetry[i]);
-                    int ni = ibas_ab_sym[hni][n][i];
-                    int kl = ibas_ab_sym[hni][k][l];
-                    A_p[d2aboff[hni] + ni*gems_ab[hni]+kl] -= dum; // -D2(ni,kl) djm
+                    int ni = ibas_ab(n,i);
+                    int kl = ibas_ab(k,l);
+                    myA_p[d2aboff[hni] + ni*gems_ab[hni]+kl] -= dum; // -D2(ni,kl) djm
                 }
             }
         }
@@ -3988,6 +2474,7 @@ void v2RDMSolver::T2_constraints_ATu_slow(SharedVector A,SharedVector u){
     }
 #endif
 
+    ReduceATuBuffers(A_p);
 }
 
 // T2 tilde portion of A.u (actually what Mazziotti calls T2)
@@ -4017,15 +2504,15 @@ void v2RDMSolver::T2_tilde_constraints_Au(SharedVector A,SharedVector u){
                 double dum = -u_p[t2aaboff[h] + ijk*trip_aab[h]+lmn]; // - T2(ijk,lmn)
 
                 int h2 = SymmetryPair(symmetry[i],SymmetryPair(symmetry[j],symmetry[n]));
-                int ijn = ibas_aab_sym[h2][i][j][n];
-                int lmk = ibas_aab_sym[h2][l][m][k];
+                int ijn = ibas_aab(i,j,n);
+                int lmk = ibas_aab(l,m,k);
 
                 dum -= u_p[t1aaboff[h2] + ijn*trip_aab[h2] + lmk]; // - T1(ijn,lmk)
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
                     dum += u_p[d2aaoff[hij] + ij*gems_aa[hij] + lm];  // D2(ij,lm) dkn
                     dum += u_p[q2aaoff[hij] + lm*gems_aa[hij] + ij];  // Q2(lm,ij) dkn
                 }
@@ -4055,8 +2542,8 @@ void v2RDMSolver::T2_tilde_constraints_Au(SharedVector A,SharedVector u){
 
                 if ( i != n && l != k ) {
                     int h2 = SymmetryPair(symmetry[i],SymmetryPair(symmetry[j],symmetry[n]));
-                    int ijn = ibas_aab_sym[h2][i][n][j];
-                    int lmk = ibas_aab_sym[h2][l][k][m];
+                    int ijn = ibas_aab(i,n,j);
+                    int lmk = ibas_aab(l,k,m);
 
                     int s = 1;
                     if ( i > n ) s = -s;
@@ -4067,8 +2554,8 @@ void v2RDMSolver::T2_tilde_constraints_Au(SharedVector A,SharedVector u){
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_ab_sym[hij][i][j];
-                    int lm = ibas_ab_sym[hij][l][m];
+                    int ij = ibas_ab(i,j);
+                    int lm = ibas_ab(l,m);
                     dum += u_p[d2aboff[hij] + ij*gems_ab[hij] + lm];  // D2(ij,lm) dkn
                     dum += u_p[q2aboff[hij] + lm*gems_ab[hij] + ij];  // Q2(lm,ij) dkn
                 }
@@ -4098,15 +2585,15 @@ void v2RDMSolver::T2_tilde_constraints_Au(SharedVector A,SharedVector u){
                 double dum = -u_p[t2bbaoff[h] + ijk*trip_aab[h]+lmn]; // - T2(ijk,lmn)
 
                 int h2 = SymmetryPair(symmetry[i],SymmetryPair(symmetry[j],symmetry[n]));
-                int ijn = ibas_aab_sym[h2][i][j][n];
-                int lmk = ibas_aab_sym[h2][l][m][k];
+                int ijn = ibas_aab(i,j,n);
+                int lmk = ibas_aab(l,m,k);
 
                 dum -= u_p[t1bbaoff[h2] + ijn*trip_aab[h2] + lmk]; // - T1(ijn,lmk)
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
                     dum += u_p[d2bboff[hij] + ij*gems_aa[hij] + lm];  // D2(ij,lm) dkn
                     dum += u_p[q2bboff[hij] + lm*gems_aa[hij] + ij];  // Q2(lm,ij) dkn
                 }
@@ -4137,8 +2624,8 @@ void v2RDMSolver::T2_tilde_constraints_Au(SharedVector A,SharedVector u){
 
                 if ( i != n && l != k ) {
                     int h2 = SymmetryPair(symmetry[i],SymmetryPair(symmetry[j],symmetry[n]));
-                    int ijn = ibas_aab_sym[h2][i][n][j];
-                    int lmk = ibas_aab_sym[h2][l][k][m];
+                    int ijn = ibas_aab(i,n,j);
+                    int lmk = ibas_aab(l,k,m);
 
                     int s = 1;
                     if ( i > n ) s = -s;
@@ -4149,8 +2636,8 @@ void v2RDMSolver::T2_tilde_constraints_Au(SharedVector A,SharedVector u){
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_ab_sym[hij][j][i];
-                    int lm = ibas_ab_sym[hij][m][l];
+                    int ij = ibas_ab(j,i);
+                    int lm = ibas_ab(m,l);
                     dum += u_p[d2aboff[hij] + ij*gems_ab[hij] + lm];  // D2(ij,lm) dkn
                     dum += u_p[q2aboff[hij] + lm*gems_ab[hij] + ij];  // Q2(lm,ij) dkn
                 }
@@ -4181,8 +2668,8 @@ void v2RDMSolver::T2_tilde_constraints_Au(SharedVector A,SharedVector u){
 
                 if ( i != n && j != n && l != k && m != k) {
                     int h2 = SymmetryPair(symmetry[i],SymmetryPair(symmetry[j],symmetry[n]));
-                    int ijn = ibas_aaa_sym[h2][i][j][n];
-                    int lmk = ibas_aaa_sym[h2][l][m][k];
+                    int ijn = ibas_aaa(i,j,n);
+                    int lmk = ibas_aaa(l,m,k);
 
                     int s = 1;
                     if ( n < j ) s = -s;
@@ -4195,8 +2682,8 @@ void v2RDMSolver::T2_tilde_constraints_Au(SharedVector A,SharedVector u){
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
                     dum += u_p[d2aaoff[hij] + ij*gems_aa[hij] + lm];  // D2(ij,lm) dkn
                     dum += u_p[q2aaoff[hij] + lm*gems_aa[hij] + ij];  // Q2(lm,ij) dkn
                 }
@@ -4227,8 +2714,8 @@ void v2RDMSolver::T2_tilde_constraints_Au(SharedVector A,SharedVector u){
 
                 if ( i != n && j != n && l != k && m != k) {
                     int h2 = SymmetryPair(symmetry[i],SymmetryPair(symmetry[j],symmetry[n]));
-                    int ijn = ibas_aaa_sym[h2][i][j][n];
-                    int lmk = ibas_aaa_sym[h2][l][m][k];
+                    int ijn = ibas_aaa(i,j,n);
+                    int lmk = ibas_aaa(l,m,k);
 
                     int s = 1;
                     if ( n < j ) s = -s;
@@ -4241,8 +2728,8 @@ void v2RDMSolver::T2_tilde_constraints_Au(SharedVector A,SharedVector u){
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
                     dum += u_p[d2bboff[hij] + ij*gems_aa[hij] + lm];  // D2(ij,lm) dkn
                     dum += u_p[q2bboff[hij] + lm*gems_aa[hij] + ij];  // Q2(lm,ij) dkn
                 }
@@ -4284,15 +2771,15 @@ void v2RDMSolver::T2_tilde_constraints_ATu(SharedVector A,SharedVector u){
                 A_p[t2aaboff[h] + ijk*trip_aab[h]+lmn] -= dum; // - T2(ijk,lmn)
 
                 int h2 = SymmetryPair(symmetry[i],SymmetryPair(symmetry[j],symmetry[n]));
-                int ijn = ibas_aab_sym[h2][i][j][n];
-                int lmk = ibas_aab_sym[h2][l][m][k];
+                int ijn = ibas_aab(i,j,n);
+                int lmk = ibas_aab(l,m,k);
 
                 A_p[t1aaboff[h2] + ijn*trip_aab[h2] + lmk] -= dum; // - T1(ijn,lmk)
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
                     A_p[d2aaoff[hij] + ij*gems_aa[hij] + lm] += dum;  // D2(ij,lm) dkn
                     A_p[q2aaoff[hij] + lm*gems_aa[hij] + ij] += dum;  // Q2(lm,ij) dkn
                 }
@@ -4322,8 +2809,8 @@ void v2RDMSolver::T2_tilde_constraints_ATu(SharedVector A,SharedVector u){
 
                 if ( i != n && l != k ) {
                     int h2 = SymmetryPair(symmetry[i],SymmetryPair(symmetry[j],symmetry[n]));
-                    int ijn = ibas_aab_sym[h2][i][n][j];
-                    int lmk = ibas_aab_sym[h2][l][k][m];
+                    int ijn = ibas_aab(i,n,j);
+                    int lmk = ibas_aab(l,k,m);
 
                     int s = 1;
                     if ( i > n ) s = -s;
@@ -4334,8 +2821,8 @@ void v2RDMSolver::T2_tilde_constraints_ATu(SharedVector A,SharedVector u){
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_ab_sym[hij][i][j];
-                    int lm = ibas_ab_sym[hij][l][m];
+                    int ij = ibas_ab(i,j);
+                    int lm = ibas_ab(l,m);
                     A_p[d2aboff[hij] + ij*gems_ab[hij] + lm] += dum;  // D2(ij,lm) dkn
                     A_p[q2aboff[hij] + lm*gems_ab[hij] + ij] += dum;  // Q2(lm,ij) dkn
                 }
@@ -4364,15 +2851,15 @@ void v2RDMSolver::T2_tilde_constraints_ATu(SharedVector A,SharedVector u){
                 A_p[t2bbaoff[h] + ijk*trip_aab[h]+lmn] -= dum; // - T2(ijk,lmn)
 
                 int h2 = SymmetryPair(symmetry[i],SymmetryPair(symmetry[j],symmetry[n]));
-                int ijn = ibas_aab_sym[h2][i][j][n];
-                int lmk = ibas_aab_sym[h2][l][m][k];
+                int ijn = ibas_aab(i,j,n);
+                int lmk = ibas_aab(l,m,k);
 
                 A_p[t1bbaoff[h2] + ijn*trip_aab[h2] + lmk] -= dum; // - T1(ijn,lmk)
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
                     A_p[d2bboff[hij] + ij*gems_aa[hij] + lm] += dum;  // D2(ij,lm) dkn
                     A_p[q2bboff[hij] + lm*gems_aa[hij] + ij] += dum;  // Q2(lm,ij) dkn
                 }
@@ -4402,8 +2889,8 @@ void v2RDMSolver::T2_tilde_constraints_ATu(SharedVector A,SharedVector u){
 
                 if ( i != n && l != k ) {
                     int h2 = SymmetryPair(symmetry[i],SymmetryPair(symmetry[j],symmetry[n]));
-                    int ijn = ibas_aab_sym[h2][i][n][j];
-                    int lmk = ibas_aab_sym[h2][l][k][m];
+                    int ijn = ibas_aab(i,n,j);
+                    int lmk = ibas_aab(l,k,m);
 
                     int s = 1;
                     if ( i > n ) s = -s;
@@ -4414,8 +2901,8 @@ void v2RDMSolver::T2_tilde_constraints_ATu(SharedVector A,SharedVector u){
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_ab_sym[hij][j][i];
-                    int lm = ibas_ab_sym[hij][m][l];
+                    int ij = ibas_ab(j,i);
+                    int lm = ibas_ab(m,l);
                     A_p[d2aboff[hij] + ij*gems_ab[hij] + lm] += dum;  // D2(ij,lm) dkn
                     A_p[q2aboff[hij] + lm*gems_ab[hij] + ij] += dum;  // Q2(lm,ij) dkn
                 }
@@ -4445,8 +2932,8 @@ void v2RDMSolver::T2_tilde_constraints_ATu(SharedVector A,SharedVector u){
                 if ( i != n && j != n && l != k && m != k) {
 
                     int h2 = SymmetryPair(symmetry[i],SymmetryPair(symmetry[j],symmetry[n]));
-                    int ijn = ibas_aaa_sym[h2][i][j][n];
-                    int lmk = ibas_aaa_sym[h2][l][m][k];
+                    int ijn = ibas_aaa(i,j,n);
+                    int lmk = ibas_aaa(l,m,k);
 
                     int s = 1;
                     if ( n < j ) s = -s;
@@ -4459,8 +2946,8 @@ void v2RDMSolver::T2_tilde_constraints_ATu(SharedVector A,SharedVector u){
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
                     A_p[d2aaoff[hij] + ij*gems_aa[hij] + lm] += dum;  // D2(ij,lm) dkn
                     A_p[q2aaoff[hij] + lm*gems_aa[hij] + ij] += dum;  // Q2(lm,ij) dkn
                 }
@@ -4491,8 +2978,8 @@ void v2RDMSolver::T2_tilde_constraints_ATu(SharedVector A,SharedVector u){
                 if ( i != n && j != n && l != k && m != k) {
 
                     int h2 = SymmetryPair(symmetry[i],SymmetryPair(symmetry[j],symmetry[n]));
-                    int ijn = ibas_aaa_sym[h2][i][j][n];
-                    int lmk = ibas_aaa_sym[h2][l][m][k];
+                    int ijn = ibas_aaa(i,j,n);
+                    int lmk = ibas_aaa(l,m,k);
 
                     int s = 1;
                     if ( n < j ) s = -s;
@@ -4505,8 +2992,8 @@ void v2RDMSolver::T2_tilde_constraints_ATu(SharedVector A,SharedVector u){
 
                 if ( k == n ) {
                     int hij = SymmetryPair(symmetry[i],symmetry[j]);
-                    int ij = ibas_aa_sym[hij][i][j];
-                    int lm = ibas_aa_sym[hij][l][m];
+                    int ij = ibas_aa(i,j);
+                    int lm = ibas_aa(l,m);
                     A_p[d2bboff[hij] + ij*gems_aa[hij] + lm] += dum;  // D2(ij,lm) dkn
                     A_p[q2bboff[hij] + lm*gems_aa[hij] + ij] += dum;  // Q2(lm,ij) dkn
                 }
@@ -4518,4 +3005,10 @@ void v2RDMSolver::T2_tilde_constraints_ATu(SharedVector A,SharedVector u){
 */
 }
 
+// C1 and point-group instantiations (selected in common_init)
+template void v2RDMSolver::T2_constraints_Au_kernel<C1Symmetry>(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+template void v2RDMSolver::T2_constraints_ATu_kernel<C1Symmetry>(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+template void v2RDMSolver::T2_constraints_Au_kernel<PointGroupSymmetry>(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+template void v2RDMSolver::T2_constraints_ATu_kernel<PointGroupSymmetry>(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+
 }} // end namespaces
@@ -174,6 +174,10 @@ void v2RDMSolver::RepackIntegrals(){
         }
     }
 
+    // when the beta blocks are not stored (SPIN_RESTRICTED), the alpha
+    // blocks carry the energy of both spins
+    double fac = spin_restricted_ ? 2.0 : 1.0;
+
     for (int h = 0; h < nirrep_; h++) {
         #pragma omp parallel for schedule (static)
         for (long int ij = 0; ij < gems_aa[h]; ij++) {
@@ -196,8 +200,8 @@ void v2RDMSolver::RepackIntegrals(){
                 double dum1 = TEI(ii,kk,jj,ll,hik);
                 double dum2 = TEI(ii,ll,jj,kk,hil);
 
-                c_p[d2aaoff[h] + ij*gems_aa[h]+kl]    = dum1 - dum2;
-                c_p[d2bboff[h] + ij*gems_aa[h]+kl]    = dum1 - dum2;
+                c_p[d2aaoff[h] + ij*gems_aa[h]+kl]    = fac * ( dum1 - dum2 );
+                c_p[d2bboff[h] + ij*gems_aa[h]+kl]    = fac * ( dum1 - dum2 );
             }
         }
     }
@@ -238,6 +242,10 @@ void v2RDMSolver::FrozenCoreEnergy() {
 
     double * c_p = c->pointer();
 
+    // when the beta blocks are not stored (SPIN_RESTRICTED), the alpha
+    // blocks carry the energy of both spins
+    double fac = spin_restricted_ ? 2.0 : 1.0;
+
     // adjust one-electron integrals for core repulsion contribution
     offset = 0;
     offset3 = 0;
@@ -267,10 +275,8 @@ void v2RDMSolver::FrozenCoreEnergy() {
                     }
                     offset2 += nmopi_[h2] - frzvpi_[h2];
                 }
-                c_p[d1aoff[h] + (i-rstcpi_[h]-frzcpi_[h])*amopi_[h] + (j-rstcpi_[h]-frzcpi_[h])] = oei_full_sym_[offset3+INDEX(i,j)];
-                c_p[d1boff[h] + (i-rstcpi_[h]-frzcpi_[h])*amopi_[h] + (j-rstcpi_[h]-frzcpi_[h])] = oei_full_sym_[offset3+INDEX(i,j)];
-                c_p[d1aoff[h] + (i-rstcpi_[h]-frzcpi_[h])*amopi_[h] + (j-rstcpi_[h]-frzcpi_[h])] += dum;
-                c_p[d1boff[h] + (i-rstcpi_[h]-frzcpi_[h])*amopi_[h] + (j-rstcpi_[h]-frzcpi_[h])] += dum;
+                c_p[d1aoff[h] + (i-rstcpi_[h]-frzcpi_[h])*amopi_[h] + (j-rstcpi_[h]-frzcpi_[h])] = fac * ( oei_full_sym_[offset3+INDEX(i,j)] + dum );
+                c_p[d1boff[h] + (i-rstcpi_[h]-frzcpi_[h])*amopi_[h] + (j-rstcpi_[h]-frzcpi_[h])] = fac * ( oei_full_sym_[offset3+INDEX(i,j)] + dum );
             }
         }
         offset += nmopi_[h] - frzvpi_[h];
@@ -98,13 +98,13 @@ void v2RDMSolver::UpdatePrimal() {
         for (int ij = 0; ij < gems_aa[h]; ij++) {
             int i = bas_aa_sym[h][ij][0];
             int j = bas_aa_sym[h][ij][1];
-            int ijb = ibas_ab_sym[h][i][j];
-            int jib = ibas_ab_sym[h][j][i];
+            int ijb = ibas_ab(i,j);
+            int jib = ibas_ab(j,i);
             for (int kl = 0; kl < gems_aa[h]; kl++) {
                 int k = bas_aa_sym[h][kl][0];
                 int l = bas_aa_sym[h][kl][1];
-                int klb = ibas_ab_sym[h][k][l];
-                int lkb = ibas_ab_sym[h][l][k];
+                int klb = ibas_ab(k,l);
+                int lkb = ibas_ab(l,k);
                 double dum = x_p[d2aaoff[h] + ij*gems_aa[h] + kl];
                 z_p[d2aboff[h] + ijb*gems_ab[h] + klb] =  dum;
                 z_p[d2aboff[h] + ijb*gems_ab[h] + lkb] = -dum;
@@ -122,31 +122,34 @@ void v2RDMSolver::UpdatePrimal() {
         for (int ij = 0; ij < gems_aa[h]; ij++) {
             int i = bas_aa_sym[h][ij][0];
             int j = bas_aa_sym[h][ij][1];
-            int ijb = ibas_ab_sym[h][i][j];
-            int jib = ibas_ab_sym[h][j][i];
+            int ijb = ibas_ab(i,j);
+            int jib = ibas_ab(j,i);
             for (int kl = 0; kl < gems_aa[h]; kl++) {
                 int k = bas_aa_sym[h][kl][0];
                 int l = bas_aa_sym[h][kl][1];
-                int klb = ibas_ab_sym[h][k][l];
-                int lkb = ibas_ab_sym[h][l][k];
+                int klb = ibas_ab(k,l);
+                int lkb = ibas_ab(l,k);
                 x_p[d2aaoff[h] + ij*gems_aa[h] + kl] = z_p[d2aboff[h] + ijb*gems_ab[h] + klb];
             }
         }
     }
 
+    // D2bb is the same block as D2aa for spin-restricted singlets
+    if ( spin_restricted_ ) return;
+
     // unpack D2bb block and copy into z
     memset((void*)z_p,'\0',dimx_*sizeof(double));
     for (int h = 0; h < nirrep_; h++) {
         for (int ij = 0; ij < gems_aa[h]; ij++) {
             int i = bas_aa_sym[h][ij][0];
             int j = bas_aa_sym[h][ij][1];
-            int ijb = ibas_ab_sym[h][i][j];
-            int jib = ibas_ab_sym[h][j][i];
+            int ijb = ibas_ab(i,j);
+            int jib = ibas_ab(j,i);
             for (int kl = 0; kl < gems_aa[h]; kl++) {
                 int k = bas_aa_sym[h][kl][0];
                 int l = bas_aa_sym[h][kl][1];
-                int klb = ibas_ab_sym[h][k][l];
-                int lkb = ibas_ab_sym[h][l][k];
+                int klb = ibas_ab(k,l);
+                int lkb = ibas_ab(l,k);
                 double dum = x_p[d2bboff[h] + ij*gems_aa[h] + kl];
                 z_p[d2aboff[h] + ijb*gems_ab[h] + klb] =  dum;
                 z_p[d2aboff[h] + ijb*gems_ab[h] + lkb] = -dum;
@@ -164,13 +167,13 @@ void v2RDMSolver::UpdatePrimal() {
         for (int ij = 0; ij < gems_aa[h]; ij++) {
             int i = bas_aa_sym[h][ij][0];
             int j = bas_aa_sym[h][ij][1];
-            int ijb = ibas_ab_sym[h][i][j];
-            int jib = ibas_ab_sym[h][j][i];
+            int ijb = ibas_ab(i,j);
+            int jib = ibas_ab(j,i);
             for (int kl = 0; kl < gems_aa[h]; kl++) {
                 int k = bas_aa_sym[h][kl][0];
                 int l = bas_aa_sym[h][kl][1];
-                int klb = ibas_ab_sym[h][k][l];
-                int lkb = ibas_ab_sym[h][l][k];
+                int klb = ibas_ab(k,l);
+                int lkb = ibas_ab(l,k);
                 x_p[d2bboff[h] + ij*gems_aa[h] + kl] = z_p[d2aboff[h] + ijb*gems_ab[h] + klb];
             }
         }
@@ -192,7 +195,7 @@ void v2RDMSolver::TransformFourIndex(double * inout, double * tmp, SharedMatrix
                 for (int pp = 0; pp < amopi_[hl]; pp++) {
 
                     int p = pp + pitzer_offset[hl];
-                    int kp = ibas_ab_sym[h][k][p];
+                    int kp = ibas_ab(k,p);
 
                     dum += inout[d2aboff[h] + ij*gems_ab[h] + kp] * t_p[l-pitzer_offset[hl] + frzcpi_[hl]+rstcpi_[hl]][pp + frzcpi_[hl]+rstcpi_[hl]];
 
@@ -213,7 +216,7 @@ void v2RDMSolver::TransformFourIndex(double * inout, double * tmp, SharedMatrix
                 for (int pp = 0; pp < amopi_[hk]; pp++) {
 
                     int p = pp + pitzer_offset[hk];
-                    int pl = ibas_ab_sym[h][p][l];
+                    int pl = ibas_ab(p,l);
 
                     dum += tmp[d2aboff[h] + ij*gems_ab[h] + pl] * t_p[k-pitzer_offset[hk] + frzcpi_[hk]+rstcpi_[hk]][pp + frzcpi_[hk]+rstcpi_[hk]];
 
@@ -234,7 +237,7 @@ void v2RDMSolver::TransformFourIndex(double * inout, double * tmp, SharedMatrix
                 for (int pp = 0; pp < amopi_[hl]; pp++) {
 
                     int p = pp + pitzer_offset[hl];
-                    int kp = ibas_ab_sym[h][k][p];
+                    int kp = ibas_ab(k,p);
 
                     dum += inout[d2aboff[h] + kp*gems_ab[h] + ij] * t_p[l-pitzer_offset[hl] + frzcpi_[hl]+rstcpi_[hl]][pp + frzcpi_[hl]+rstcpi_[hl]];
 
@@ -255,7 +258,7 @@ void v2RDMSolver::TransformFourIndex(double * inout, double * tmp, SharedMatrix
                 for (int pp = 0; pp < amopi_[hk]; pp++) {
 
                     int p = pp + pitzer_offset[hk];
-                    int pl = ibas_ab_sym[h][p][l];
+                    int pl = ibas_ab(p,l);
 
                     dum += tmp[d2aboff[h] + pl*gems_ab[h] + ij] * t_p[k-pitzer_offset[hk] + frzcpi_[hk]+rstcpi_[hk]][pp + frzcpi_[hk]+rstcpi_[hk]];
 
@@ -70,8 +70,16 @@ int read_options(std::string name, Options& options)
         /*- File containing previous primal/dual solutions and integrals. -*/
         options.add_str("RESTART_FROM_CHECKPOINT_FILE","");
         /*- Frequency with which the pentalty-parameter, mu, is updated. mu is
-        updated every MU_UPDATE_FREQUENCY iterations.   -*/
+        updated every MU_UPDATE_FREQUENCY iterations.  With MU_UPDATE =
+        ADAPTIVE, this is the longest interval between updates. -*/
         options.add_int("MU_UPDATE_FREQUENCY",500);
+        /*- Scheme for updating the penalty parameter, mu, in the
+        boundary-point iterations.  FIXED sets mu = mu * ep / ed every
+        MU_UPDATE_FREQUENCY iterations.  ADAPTIVE follows the averaged ratio
+        of the primal and dual errors, with hysteresis, and the progress of
+        the errors and the energy gap, and also adjusts the CG convergence
+        threshold. -*/
+        options.add_str("MU_UPDATE","FIXED","FIXED ADAPTIVE");
         /*- The type of 2-positivity computation -*/
         options.add_str("POSITIVITY", "DQG", "DQG D DQ DG DQGT1 DQGT2 DQGT1T2");
         /*- Do constrain D3 to D2 mapping? -*/
@@ -82,6 +90,26 @@ int read_options(std::string name, Options& options)
         options.add_bool("SPIN_ADAPT_Q2", false);
         /*- Do constrain spin squared? -*/
         options.add_bool("CONSTRAIN_SPIN", true);
+        /*- Do store only the alpha-spin blocks of the primal solution for a
+        singlet state?  D1b, D2bb, Q2bb, T1bbb, etc. are then identical to
+        their alpha-spin counterparts and are not stored.  Requires
+        CONSTRAIN_SPIN and multiplicity 1. -*/
+        options.add_bool("SPIN_RESTRICTED", false);
+        /*- Do store the D2, Q2, and G2 blocks of the constraint matrix in a
+        sparse format?  A is assembled once, and A.u / A^T.u are evaluated as
+        sparse matrix-vector products.  If the matrix does not fit in the
+        available memory, the matrix-free algorithm is used. -*/
+        options.add_bool("SPARSE_CONSTRAINTS", false);
+        /*- Algorithm for the T2 portions of A.u and A^T.u.  FAST visits only
+        the nonzero elements of A; SLOW is the original reference
+        implementation.  FAST mappings are checked against SLOW ones once
+        at startup. -*/
+        options.add_str("T2_ALGORITHM", "SLOW", "FAST SLOW");
+        /*- Do only verify and time the constraint mappings (A.u and A^T.u
+        for each family of constraints) rather than solve the SDP? -*/
+        options.add_bool("CONSTRAINT_BENCHMARK", false);
+        /*- number of calls averaged in each constraint-mapping timing -*/
+        options.add_int("CONSTRAINT_BENCHMARK_REPETITIONS", 10);
         /*- convergence in the primal/dual energy gap -*/
         options.add_double("E_CONVERGENCE", 1e-4);
         /*- convergence in the primal error -*/
@@ -92,9 +120,59 @@ int read_options(std::string name, Options& options)
         options.add_int("MAXITER", 10000);
         /*- maximum number of conjugate gradient iterations -*/
         options.add_int("CG_MAXITER", 10000);
+        /*- Algorithm for the SDP.  BPSDP is the boundary-point method.
+        SSN_CG is an augmented Lagrangian method whose subproblems are solved
+        by a semismooth Newton-CG method; each of its outer iterations is
+        more expensive than one of BPSDP. -*/
+        options.add_str("SDP_SOLVER", "BPSDP", "BPSDP SSN_CG");
+        /*- Preconditioner for the conjugate gradient solution of A.A^T.y = b.
+        JACOBI scales the residual by the inverse of the diagonal of A.A^T,
+        which is computed once, after the constraints are built.  With T2
+        conditions, a few diagonal elements of the T2 rows are approximate
+        (terms that fall on the same element of D2 are counted separately),
+        which affects only the rate of convergence. -*/
+        options.add_str("CG_PRECONDITIONER", "NONE", "JACOBI NONE");
+        /*- Solver for the linear equations for the dual solution, A.A^T.y = b.
+        CHOLESKY factorizes A.A^T once (A does not change during the
+        computation) and solves the equations directly in each iteration.
+        CG is used instead if the factor does not fit in memory or if T1, T2,
+        or D3 conditions are enforced.  PIPELINED_CG is a CG variant that
+        fuses the vector updates and dot products into one pass over memory
+        per iteration. -*/
+        options.add_str("DUAL_SOLVER", "CG", "CG PIPELINED_CG CHOLESKY");
+        /*- Number of approximate eigenvectors of A.A^T (those of smallest
+        eigenvalue) that are kept between CG solutions and deflated from
+        subsequent ones.  Zero disables recycling.  Not used with
+        CG_PRECONDITIONER = JACOBI, DUAL_SOLVER = CHOLESKY or PIPELINED_CG, or
+        CG_MIXED_PRECISION. -*/
+        options.add_int("CG_RECYCLE_DIMENSION", 0);
+        /*- Do apply A.A^T in single precision in the CG microiterations,
+        with iterative refinement in double precision?  Requires the sparse
+        constraint matrix (only D2, Q2, and G2 conditions).  Not used with
+        CG_PRECONDITIONER = JACOBI or DUAL_SOLVER = CHOLESKY. -*/
+        options.add_bool("CG_MIXED_PRECISION", false);
+        /*- Do drop linearly dependent D2, Q2, and G2 constraints and scale
+        the remaining rows of A to unit norm for the CG solution of
+        A.A^T.y = b?  The row norms of the T2 rows are approximate in the
+        same way as the diagonal for CG_PRECONDITIONER = JACOBI.  Not used
+        with CG_PRECONDITIONER = JACOBI or DUAL_SOLVER = CHOLESKY. -*/
+        options.add_bool("PRESOLVE_CONSTRAINTS", false);
+        /*- Do start the diagonalization of each block of x and z from the
+        eigenvectors of the previous iteration?  Requires memory for one more
+        copy of the primal solution. -*/
+        options.add_bool("EIGENSOLVER_WARM_START", false);
+        /*- Anderson acceleration of the boundary-point iterations in the
+        dual solution and mu x - z.  Not combined with DIIS_EXTRAPOLATION. -*/
+        options.add_str("ANDERSON_ACCELERATION", "NONE", "NONE TYPE_I TYPE_II");
+        /*- Maximum number of previous iterations used in Anderson
+        acceleration -*/
+        options.add_int("ANDERSON_HISTORY", 5);
+        /*- Do accelerate the boundary-point iterations by DIIS extrapolation
+        of the square roots of the primal and dual solutions? -*/
+        options.add_bool("DIIS_EXTRAPOLATION", false);
         /*- maximum number of diis vectors -*/
         options.add_int("DIIS_MAX_VECS", 8);
-        /*- Frequency of DIIS extrapolation steps -*/
+        /*- Frequency of DIIS extrapolation steps.  Must be at least 1. -*/
         options.add_int("DIIS_UPDATE_FREQUENCY",50);
 
         /*- Auxiliary basis set for SCF density fitting computations.
@@ -154,6 +232,12 @@ SharedWavefunction v2rdm_casscf(SharedWavefunction ref_wfn, Options& options)
 
     std::shared_ptr<v2RDMSolver > v2rdm (new v2RDMSolver(ref_wfn,options));
 
+    if ( options.get_bool("CONSTRAINT_BENCHMARK") ) {
+        v2rdm->BenchmarkConstraints();
+        tstop();
+        return (SharedWavefunction)v2rdm;
+    }
+
     double energy = v2rdm->compute_energy();
 
     Process::environment.globals["CURRENT ENERGY"] = energy;
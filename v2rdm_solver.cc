@@ -29,6 +29,8 @@
 #include <stdlib.h>
 #include <math.h>
 
+#include <algorithm>
+
 #include <psi4/libmints/writer.h>
 #include <psi4/libmints/writer_file_prefix.h>
 
@@ -60,6 +62,7 @@
 
 #include "cg_solver.h"
 #include "v2rdm_solver.h"
+#include "symmetry_policy.h"
 
 // greg
 #include "fortran.h"
@@ -70,6 +73,7 @@
 #else
     #define omp_get_wtime() ( (double)clock() / CLOCKS_PER_SEC )
     #define omp_get_max_threads() 1
+    #define omp_get_thread_num() 0
 #endif
 
 using namespace psi;
@@ -87,7 +91,8 @@ inline void DGEEV(char& JOBVL,char& JOBVR,long int& N,double* A,long int& LDA,do
 
 
 // diagonalize real, nonsymmetric matrix
-void NonsymmetricEigenvalue(long int N, double * A, double * VL, double * VR, double * WR, double *WI){
+// WORK must hold at least 4*N elements
+void NonsymmetricEigenvalue(long int N, double * A, double * VL, double * VR, double * WR, double *WI, double * WORK){
 
     char JOBVL = 'V';
     char JOBVR = 'V';
@@ -95,7 +100,6 @@ void NonsymmetricEigenvalue(long int N, double * A, double * VL, double * VR, do
     long int LDVL = N;
     long int LDVR = N;
     long int LWORK = 4*N;
-    double * WORK = (double*)malloc(LWORK*sizeof(double));
     long int INFO;
 
     DGEEV(JOBVL, JOBVR, N, A, LDA, WR, WI, VL, LDVL, VR, LDVR, WORK, LWORK, INFO);
@@ -107,18 +111,27 @@ void NonsymmetricEigenvalue(long int N, double * A, double * VL, double * VR, do
             WI[i] = 0.0;
         }
     }
-
-    free(WORK);
 }
 
-static void evaluate_Ap(long int n, SharedVector Ax, SharedVector x, void * data) {
-
-    // reinterpret void * as an instance of v2RDMSolver
-    v2rdm_casscf::v2RDMSolver* BPSDPcg = reinterpret_cast<v2rdm_casscf::v2RDMSolver*>(data);
-    // call a function from class to evaluate Ax product:
-    BPSDPcg->cg_Ax(n,Ax,x);
-
-}
+// A.A^T for CGSolver, or (S.A).(S.A)^T with the row scaling of the presolve
+class AATOperator : public CGOperator {
+public:
+    AATOperator(v2rdm_casscf::v2RDMSolver * solver, bool scaled)
+        : solver_(solver), scaled_(scaled) {}
+    void apply(long int n, SharedVector Ax, SharedVector x) {
+        if ( scaled_ ) {
+            solver_->cg_Ax_scaled(n,Ax,x);
+        }else {
+            solver_->cg_Ax(n,Ax,x);
+        }
+    }
+    void apply_sp(long int n, float * Ax, const float * x) {
+        solver_->cg_Ax_sp(n,Ax,x);
+    }
+private:
+    v2rdm_casscf::v2RDMSolver * solver_;
+    bool scaled_;
+};
 namespace psi{ namespace v2rdm_casscf{
 
 v2RDMSolver::v2RDMSolver(SharedWavefunction reference_wavefunction,Options & options):
@@ -134,6 +147,33 @@ v2RDMSolver::~v2RDMSolver()
     free(d2_plus_core_sym_);
     free(d1_act_spatial_sym_);
 
+    free(ATu_buffer_);
+
+    for (int t = 0; t < update_work_.size(); t++) {
+        free(update_work_[t]);
+        free(update_iwork_[t]);
+    }
+    free(update_work_nonsym_);
+
+    free(diisvec_);
+    free(diis_vec_);
+    free(diis_err_);
+    free(diis_in_);
+    free(diis_b_);
+    free(diis_A_);
+    free(diis_ipiv_);
+
+    free(anderson_df_);
+    free(anderson_dg_);
+    free(anderson_ff_);
+    free(anderson_gf_);
+    free(anderson_f_);
+    free(anderson_g_);
+    free(anderson_u_);
+    free(anderson_a_);
+    free(anderson_gamma_);
+    free(anderson_ipiv_);
+
     free(amopi_);
     free(rstcpi_);
     free(rstvpi_);
@@ -191,6 +231,22 @@ v2RDMSolver::~v2RDMSolver()
 
 }
 
+template <class Symmetry>
+void v2RDMSolver::SelectConstraintKernels() {
+    Q2_constraints_Au_fn_               = &v2RDMSolver::Q2_constraints_Au_kernel<Symmetry>;
+    Q2_constraints_ATu_fn_              = &v2RDMSolver::Q2_constraints_ATu_kernel<Symmetry>;
+    Q2_constraints_Au_spin_adapted_fn_  = &v2RDMSolver::Q2_constraints_Au_spin_adapted_kernel<Symmetry>;
+    Q2_constraints_ATu_spin_adapted_fn_ = &v2RDMSolver::Q2_constraints_ATu_spin_adapted_kernel<Symmetry>;
+    G2_constraints_Au_fn_               = &v2RDMSolver::G2_constraints_Au_kernel<Symmetry>;
+    G2_constraints_ATu_fn_              = &v2RDMSolver::G2_constraints_ATu_kernel<Symmetry>;
+    G2_constraints_Au_spin_adapted_fn_  = &v2RDMSolver::G2_constraints_Au_spin_adapted_kernel<Symmetry>;
+    G2_constraints_ATu_spin_adapted_fn_ = &v2RDMSolver::G2_constraints_ATu_spin_adapted_kernel<Symmetry>;
+    T1_constraints_Au_fn_               = &v2RDMSolver::T1_constraints_Au_kernel<Symmetry>;
+    T1_constraints_ATu_fn_              = &v2RDMSolver::T1_constraints_ATu_kernel<Symmetry>;
+    T2_constraints_Au_fn_               = &v2RDMSolver::T2_constraints_Au_kernel<Symmetry>;
+    T2_constraints_ATu_fn_              = &v2RDMSolver::T2_constraints_ATu_kernel<Symmetry>;
+}
+
 void  v2RDMSolver::common_init(){
 
     is_df_ = false;
@@ -463,6 +519,21 @@ void  v2RDMSolver::common_init(){
     spin_adapt_g2_  = options_.get_bool("SPIN_ADAPT_G2");
     spin_adapt_q2_  = options_.get_bool("SPIN_ADAPT_Q2");
     constrain_spin_ = options_.get_bool("CONSTRAIN_SPIN");
+    spin_restricted_ = options_.get_bool("SPIN_RESTRICTED");
+
+    sparse_constraints_ = options_.get_bool("SPARSE_CONSTRAINTS");
+    cg_mixed_precision_ = false;
+
+    // fast or slow T2 mappings?
+    fast_t2_ = ( options_.get_str("T2_ALGORITHM") == "FAST" );
+
+    // constraint kernels specialized on the point group.  in C1, all
+    // symmetry lookups in the Q2, G2, T1, and T2 mappings are constants
+    if ( nirrep_ == 1 ) {
+        SelectConstraintKernels<C1Symmetry>();
+    }else {
+        SelectConstraintKernels<PointGroupSymmetry>();
+    }
 
     if ( constrain_t1_ || constrain_t2_ ) {
         if (spin_adapt_g2_) {
@@ -486,6 +557,17 @@ void  v2RDMSolver::common_init(){
         }
     }
 
+    // spin-restricted singlets: the beta blocks of x are not stored, and the
+    // beta offsets below point to the corresponding alpha blocks
+    if ( spin_restricted_ ) {
+        if ( multiplicity_ != 1 || nalpha_ != nbeta_ ) {
+            throw PsiException("SPIN_RESTRICTED requires a singlet state",__FILE__,__LINE__);
+        }
+        if ( !constrain_spin_ ) {
+            throw PsiException("SPIN_RESTRICTED requires CONSTRAIN_SPIN",__FILE__,__LINE__);
+        }
+    }
+
     // dimension of variable buffer (x)
     dimx_ = 0;
     for ( int h = 0; h < nirrep_; h++) {
@@ -494,14 +576,18 @@ void  v2RDMSolver::common_init(){
     for ( int h = 0; h < nirrep_; h++) {
         dimx_ += gems_aa[h]*gems_aa[h]; // D2aa
     }
-    for ( int h = 0; h < nirrep_; h++) {
-        dimx_ += gems_aa[h]*gems_aa[h]; // D2bb
+    if ( !spin_restricted_ ) {
+        for ( int h = 0; h < nirrep_; h++) {
+            dimx_ += gems_aa[h]*gems_aa[h]; // D2bb
+        }
     }
     for ( int h = 0; h < nirrep_; h++) {
         dimx_ += amopi_[h]*amopi_[h]; // D1a
-        dimx_ += amopi_[h]*amopi_[h]; // D1b
-        dimx_ += amopi_[h]*amopi_[h]; // Q1b
         dimx_ += amopi_[h]*amopi_[h]; // Q1a
+        if ( !spin_restricted_ ) {
+            dimx_ += amopi_[h]*amopi_[h]; // D1b
+            dimx_ += amopi_[h]*amopi_[h]; // Q1b
+        }
     }
     if ( constrain_spin_ && nalpha_ == nbeta_ ) {
         for ( int h = 0; h < nirrep_; h++) {
@@ -520,8 +606,10 @@ void  v2RDMSolver::common_init(){
             for ( int h = 0; h < nirrep_; h++) {
                 dimx_ += gems_aa[h]*gems_aa[h]; // Q2aa
             }
-            for ( int h = 0; h < nirrep_; h++) {
-                dimx_ += gems_aa[h]*gems_aa[h]; // Q2bb
+            if ( !spin_restricted_ ) {
+                for ( int h = 0; h < nirrep_; h++) {
+                    dimx_ += gems_aa[h]*gems_aa[h]; // Q2bb
+                }
             }
         }else {
             for ( int h = 0; h < nirrep_; h++) {
@@ -568,42 +656,54 @@ void  v2RDMSolver::common_init(){
         for ( int h = 0; h < nirrep_; h++) {
             dimx_ += trip_aaa[h]*trip_aaa[h]; // T1aaa
         }
-        for ( int h = 0; h < nirrep_; h++) {
-            dimx_ += trip_aaa[h]*trip_aaa[h]; // T1bbb
+        if ( !spin_restricted_ ) {
+            for ( int h = 0; h < nirrep_; h++) {
+                dimx_ += trip_aaa[h]*trip_aaa[h]; // T1bbb
+            }
         }
         for ( int h = 0; h < nirrep_; h++) {
             dimx_ += trip_aab[h]*trip_aab[h]; // T1aab
         }
-        for ( int h = 0; h < nirrep_; h++) {
-            dimx_ += trip_aab[h]*trip_aab[h]; // T1bba
+        if ( !spin_restricted_ ) {
+            for ( int h = 0; h < nirrep_; h++) {
+                dimx_ += trip_aab[h]*trip_aab[h]; // T1bba
+            }
         }
     }
     if ( constrain_t2_ ) {
         for ( int h = 0; h < nirrep_; h++) {
             dimx_ += (trip_aba[h]+trip_aab[h])*(trip_aab[h]+trip_aba[h]); // T2aaa
         }
-        for ( int h = 0; h < nirrep_; h++) {
-            dimx_ += (trip_aba[h]+trip_aab[h])*(trip_aab[h]+trip_aba[h]); // T2bbb
+        if ( !spin_restricted_ ) {
+            for ( int h = 0; h < nirrep_; h++) {
+                dimx_ += (trip_aba[h]+trip_aab[h])*(trip_aab[h]+trip_aba[h]); // T2bbb
+            }
         }
         for ( int h = 0; h < nirrep_; h++) {
             dimx_ += trip_aab[h]*trip_aab[h]; // T2aab
         }
-        for ( int h = 0; h < nirrep_; h++) {
-            dimx_ += trip_aab[h]*trip_aab[h]; // T2bba
+        if ( !spin_restricted_ ) {
+            for ( int h = 0; h < nirrep_; h++) {
+                dimx_ += trip_aab[h]*trip_aab[h]; // T2bba
+            }
         }
     }
     if ( constrain_d3_ ) {
         for ( int h = 0; h < nirrep_; h++) {
             dimx_ += trip_aaa[h] * trip_aaa[h]; // D3aaa
         }
-        for ( int h = 0; h < nirrep_; h++) {
-            dimx_ += trip_aaa[h] * trip_aaa[h]; // D3bbb
+        if ( !spin_restricted_ ) {
+            for ( int h = 0; h < nirrep_; h++) {
+                dimx_ += trip_aaa[h] * trip_aaa[h]; // D3bbb
+            }
         }
         for ( int h = 0; h < nirrep_; h++) {
             dimx_ += trip_aab[h]*trip_aab[h]; // D3aab
         }
-        for ( int h = 0; h < nirrep_; h++) {
-            dimx_ += trip_aab[h]*trip_aab[h]; // D3bba
+        if ( !spin_restricted_ ) {
+            for ( int h = 0; h < nirrep_; h++) {
+                dimx_ += trip_aab[h]*trip_aab[h]; // D3bba
+            }
         }
     }
 
@@ -621,7 +721,11 @@ void  v2RDMSolver::common_init(){
         d2aaoff[h] = offset; offset += gems_aa[h]*gems_aa[h];
     }
     for (int h = 0; h < nirrep_; h++) {
-        d2bboff[h] = offset; offset += gems_aa[h]*gems_aa[h];
+        if ( spin_restricted_ ) {
+            d2bboff[h] = d2aaoff[h];
+        }else {
+            d2bboff[h] = offset; offset += gems_aa[h]*gems_aa[h];
+        }
     }
     if ( constrain_spin_ && nalpha_ == nbeta_ ) {
         for (int h = 0; h < nirrep_; h++) {
@@ -641,15 +745,25 @@ void  v2RDMSolver::common_init(){
         d1aoff[h] = offset; offset += amopi_[h]*amopi_[h];
     }
     for (int h = 0; h < nirrep_; h++) {
-        d1boff[h] = offset; offset += amopi_[h]*amopi_[h];
+        if ( spin_restricted_ ) {
+            d1boff[h] = d1aoff[h];
+        }else {
+            d1boff[h] = offset; offset += amopi_[h]*amopi_[h];
+        }
     }
     for (int h = 0; h < nirrep_; h++) {
         q1aoff[h] = offset; offset += amopi_[h]*amopi_[h];
     }
     for (int h = 0; h < nirrep_; h++) {
-        q1boff[h] = offset; offset += amopi_[h]*amopi_[h];
+        if ( spin_restricted_ ) {
+            q1boff[h] = q1aoff[h];
+        }else {
+            q1boff[h] = offset; offset += amopi_[h]*amopi_[h];
+        }
     }
 
+    dimx_d2_ = offset;
+
     if ( constrain_q2_ ) {
         if ( !spin_adapt_q2_ ) {
             q2aboff = (int*)malloc(nirrep_*sizeof(int));
@@ -662,7 +776,11 @@ void  v2RDMSolver::common_init(){
                 q2aaoff[h] = offset; offset += gems_aa[h]*gems_aa[h];
             }
             for (int h = 0; h < nirrep_; h++) {
-                q2bboff[h] = offset; offset += gems_aa[h]*gems_aa[h];
+                if ( spin_restricted_ ) {
+                    q2bboff[h] = q2aaoff[h];
+                }else {
+                    q2bboff[h] = offset; offset += gems_aa[h]*gems_aa[h];
+                }
             }
         }else {
             q2soff = (int*)malloc(nirrep_*sizeof(int));
@@ -684,6 +802,8 @@ void  v2RDMSolver::common_init(){
         }
     }
 
+    dimx_d2q2_ = offset;
+
     if ( constrain_g2_ ) {
         if ( ! spin_adapt_g2_ ) {
             g2aboff = (int*)malloc(nirrep_*sizeof(int));
@@ -717,6 +837,7 @@ void  v2RDMSolver::common_init(){
             }
         }
     }
+    dimx_d2q2g2_ = offset;
 
     if ( constrain_t1_ ) {
         t1aaboff = (int*)malloc(nirrep_*sizeof(int));
@@ -727,13 +848,21 @@ void  v2RDMSolver::common_init(){
             t1aaaoff[h] = offset; offset += trip_aaa[h]*trip_aaa[h]; // T1aaa
         }
         for (int h = 0; h < nirrep_; h++) {
-            t1bbboff[h] = offset; offset += trip_aaa[h]*trip_aaa[h]; // T1bbb
+            if ( spin_restricted_ ) {
+                t1bbboff[h] = t1aaaoff[h];
+            }else {
+                t1bbboff[h] = offset; offset += trip_aaa[h]*trip_aaa[h]; // T1bbb
+            }
         }
         for (int h = 0; h < nirrep_; h++) {
             t1aaboff[h] = offset; offset += trip_aab[h]*trip_aab[h]; // T1aab
         }
         for (int h = 0; h < nirrep_; h++) {
-            t1bbaoff[h] = offset; offset += trip_aab[h]*trip_aab[h]; // T1bba
+            if ( spin_restricted_ ) {
+                t1bbaoff[h] = t1aaboff[h];
+            }else {
+                t1bbaoff[h] = offset; offset += trip_aab[h]*trip_aab[h]; // T1bba
+            }
         }
     }
 
@@ -746,13 +875,21 @@ void  v2RDMSolver::common_init(){
             t2aaaoff[h] = offset; offset += (trip_aab[h]+trip_aba[h])*(trip_aab[h]+trip_aba[h]); // T2aaa
         }
         for (int h = 0; h < nirrep_; h++) {
-            t2bbboff[h] = offset; offset += (trip_aab[h]+trip_aba[h])*(trip_aab[h]+trip_aba[h]); // T2bbb
+            if ( spin_restricted_ ) {
+                t2bbboff[h] = t2aaaoff[h];
+            }else {
+                t2bbboff[h] = offset; offset += (trip_aab[h]+trip_aba[h])*(trip_aab[h]+trip_aba[h]); // T2bbb
+            }
         }
         for (int h = 0; h < nirrep_; h++) {
             t2aaboff[h] = offset; offset += trip_aab[h]*trip_aab[h]; // T2aab
         }
         for (int h = 0; h < nirrep_; h++) {
-            t2bbaoff[h] = offset; offset += trip_aab[h]*trip_aab[h]; // T2bba
+            if ( spin_restricted_ ) {
+                t2bbaoff[h] = t2aaboff[h];
+            }else {
+                t2bbaoff[h] = offset; offset += trip_aab[h]*trip_aab[h]; // T2bba
+            }
         }
     }
     if ( constrain_d3_ ) {
@@ -764,13 +901,21 @@ void  v2RDMSolver::common_init(){
             d3aaaoff[h] = offset; offset += trip_aaa[h]*trip_aaa[h]; // D3aaa
         }
         for (int h = 0; h < nirrep_; h++) {
-            d3bbboff[h] = offset; offset += trip_aaa[h]*trip_aaa[h]; // D3bbb
+            if ( spin_restricted_ ) {
+                d3bbboff[h] = d3aaaoff[h];
+            }else {
+                d3bbboff[h] = offset; offset += trip_aaa[h]*trip_aaa[h]; // D3bbb
+            }
         }
         for (int h = 0; h < nirrep_; h++) {
             d3aaboff[h] = offset; offset += trip_aab[h]*trip_aab[h]; // D3aab
         }
         for (int h = 0; h < nirrep_; h++) {
-            d3bbaoff[h] = offset; offset += trip_aab[h]*trip_aab[h]; // D3bba
+            if ( spin_restricted_ ) {
+                d3bbaoff[h] = d3aaboff[h];
+            }else {
+                d3bbaoff[h] = offset; offset += trip_aab[h]*trip_aab[h]; // D3bba
+            }
         }
     }
     // constraints:
@@ -806,11 +951,13 @@ void  v2RDMSolver::common_init(){
     }
     // additional spin constraints for singlets:
     if ( constrain_spin_ && nalpha_ == nbeta_ ) {
-        for ( int h = 0; h < nirrep_; h++) {
-            nconstraints_ += amopi_[h]*amopi_[h]; // D1a = D1b
-        }
-        for ( int h = 0; h < nirrep_; h++) {
-            nconstraints_ += gems_aa[h]*gems_aa[h]; // D2aa = D2bb
+        if ( !spin_restricted_ ) {
+            for (int h = 0; h < nirrep_; h++) {
+                nconstraints_ += amopi_[h]*amopi_[h]; // D1a = D1b
+            }
+            for (int h = 0; h < nirrep_; h++) {
+                nconstraints_ += gems_aa[h]*gems_aa[h]; // D2aa = D2bb
+            }
         }
         for ( int h = 0; h < nirrep_; h++) {
             nconstraints_ += gems_aa[h]*gems_aa[h]; // D2aa[pq][rs] = 1/2(D2ab[pq][rs] - D2ab[pq][sr] - D2ab[qp][rs] + D2ab[qp][sr])
@@ -830,6 +977,7 @@ void  v2RDMSolver::common_init(){
     for ( int h = 0; h < nirrep_; h++) {
         nconstraints_ += amopi_[h]*amopi_[h]; // contract D2bb        -> D1 b
     }
+    nconstraints_d2_ = nconstraints_;
     if ( constrain_q2_ ) {
         if ( ! spin_adapt_q2_ ) {
             for ( int h = 0; h < nirrep_; h++) {
@@ -857,6 +1005,7 @@ void  v2RDMSolver::common_init(){
         }
 
     }
+    nconstraints_d2q2_ = nconstraints_;
     if ( constrain_g2_ ) {
         if ( ! spin_adapt_g2_ ) {
             for ( int h = 0; h < nirrep_; h++) {
@@ -887,6 +1036,7 @@ void  v2RDMSolver::common_init(){
         //    nconstraints_ += gems_ab[0];
         //}
     }
+    nconstraints_d2q2g2_ = nconstraints_;
     if ( constrain_t1_ ) {
         for (int h = 0; h < nirrep_; h++) {
             nconstraints_ += trip_aaa[h]*trip_aaa[h]; // T1aaa
@@ -901,6 +1051,7 @@ void  v2RDMSolver::common_init(){
             nconstraints_ += trip_aab[h]*trip_aab[h]; // T1bba
         }
     }
+    nconstraints_d2q2g2t1_ = nconstraints_;
     if ( constrain_t2_ ) {
         for (int h = 0; h < nirrep_; h++) {
             nconstraints_ += (trip_aab[h]+trip_aba[h])*(trip_aab[h]+trip_aba[h]); // T2aaa
@@ -915,6 +1066,7 @@ void  v2RDMSolver::common_init(){
             nconstraints_ += trip_aab[h]*trip_aab[h]; // T2bba
         }
     }
+    nconstraints_d2q2g2t1t2_ = nconstraints_;
     if ( constrain_d3_ ) {
         if ( nalpha_ - nrstc_ - nfrzc_ > 2 ) {
             for (int h = 0; h < nirrep_; h++) {
@@ -944,8 +1096,10 @@ void  v2RDMSolver::common_init(){
         }
         // additional spin constraints for singlets:
         if ( constrain_spin_ && nalpha_ == nbeta_ ) {
-            for (int h = 0; h < nirrep_; h++) {
-                nconstraints_ += trip_aab[h]*trip_aab[h]; // D3aab = D3bba
+            if ( !spin_restricted_ ) {
+                for (int h = 0; h < nirrep_; h++) {
+                    nconstraints_ += trip_aab[h]*trip_aab[h]; // D3aab = D3bba
+                }
             }
             for (int h = 0; h < nirrep_; h++) {
                 nconstraints_ += trip_aaa[h]*trip_aaa[h]; // D3aab -> D3aaa
@@ -961,8 +1115,10 @@ void  v2RDMSolver::common_init(){
     for (int h = 0; h < nirrep_; h++) {
         dimensions_.push_back(gems_aa[h]); // D2aa
     }
-    for (int h = 0; h < nirrep_; h++) {
-        dimensions_.push_back(gems_aa[h]); // D2bb
+    if ( !spin_restricted_ ) {
+        for (int h = 0; h < nirrep_; h++) {
+            dimensions_.push_back(gems_aa[h]); // D2bb
+        }
     }
     if ( constrain_spin_ && nalpha_ == nbeta_ ) {
         for (int h = 0; h < nirrep_; h++) {
@@ -976,14 +1132,18 @@ void  v2RDMSolver::common_init(){
     for (int h = 0; h < nirrep_; h++) {
         dimensions_.push_back(amopi_[h]); // D1a
     }
-    for (int h = 0; h < nirrep_; h++) {
-        dimensions_.push_back(amopi_[h]); // D1b
+    if ( !spin_restricted_ ) {
+        for (int h = 0; h < nirrep_; h++) {
+            dimensions_.push_back(amopi_[h]); // D1b
+        }
     }
     for (int h = 0; h < nirrep_; h++) {
         dimensions_.push_back(amopi_[h]); // Q1a
     }
-    for (int h = 0; h < nirrep_; h++) {
-        dimensions_.push_back(amopi_[h]); // Q1b
+    if ( !spin_restricted_ ) {
+        for (int h = 0; h < nirrep_; h++) {
+            dimensions_.push_back(amopi_[h]); // Q1b
+        }
     }
     if ( constrain_q2_ ) {
         if ( !spin_adapt_q2_ ) {
@@ -993,8 +1153,10 @@ void  v2RDMSolver::common_init(){
             for (int h = 0; h < nirrep_; h++) {
                 dimensions_.push_back(gems_aa[h]); // Q2aa
             }
-            for (int h = 0; h < nirrep_; h++) {
-                dimensions_.push_back(gems_aa[h]); // Q2bb
+            if ( !spin_restricted_ ) {
+                for (int h = 0; h < nirrep_; h++) {
+                    dimensions_.push_back(gems_aa[h]); // Q2bb
+                }
             }
         }else {
             for (int h = 0; h < nirrep_; h++) {
@@ -1041,45 +1203,69 @@ void  v2RDMSolver::common_init(){
         for (int h = 0; h < nirrep_; h++) {
             dimensions_.push_back(trip_aaa[h]); // T1aaa
         }
-        for (int h = 0; h < nirrep_; h++) {
-            dimensions_.push_back(trip_aaa[h]); // T1bbb
+        if ( !spin_restricted_ ) {
+            for (int h = 0; h < nirrep_; h++) {
+                dimensions_.push_back(trip_aaa[h]); // T1bbb
+            }
         }
         for (int h = 0; h < nirrep_; h++) {
             dimensions_.push_back(trip_aab[h]); // T1aab
         }
-        for (int h = 0; h < nirrep_; h++) {
-            dimensions_.push_back(trip_aab[h]); // T1bba
+        if ( !spin_restricted_ ) {
+            for (int h = 0; h < nirrep_; h++) {
+                dimensions_.push_back(trip_aab[h]); // T1bba
+            }
         }
     }
     if ( constrain_t2_ ) {
         for (int h = 0; h < nirrep_; h++) {
             dimensions_.push_back(trip_aab[h]+trip_aba[h]); // T2aaa
         }
-        for (int h = 0; h < nirrep_; h++) {
-            dimensions_.push_back(trip_aab[h]+trip_aba[h]); // T2bbb
+        if ( !spin_restricted_ ) {
+            for (int h = 0; h < nirrep_; h++) {
+                dimensions_.push_back(trip_aab[h]+trip_aba[h]); // T2bbb
+            }
         }
         for (int h = 0; h < nirrep_; h++) {
             dimensions_.push_back(trip_aab[h]); // T2aab
         }
-        for (int h = 0; h < nirrep_; h++) {
-            dimensions_.push_back(trip_aab[h]); // T2bba
+        if ( !spin_restricted_ ) {
+            for (int h = 0; h < nirrep_; h++) {
+                dimensions_.push_back(trip_aab[h]); // T2bba
+            }
         }
     }
     if ( constrain_d3_ ) {
         for (int h = 0; h < nirrep_; h++) {
             dimensions_.push_back(trip_aaa[h]); // D3aaa
         }
-        for (int h = 0; h < nirrep_; h++) {
-            dimensions_.push_back(trip_aaa[h]); // D3bbb
+        if ( !spin_restricted_ ) {
+            for (int h = 0; h < nirrep_; h++) {
+                dimensions_.push_back(trip_aaa[h]); // D3bbb
+            }
         }
         for (int h = 0; h < nirrep_; h++) {
             dimensions_.push_back(trip_aab[h]); // D3aab
         }
-        for (int h = 0; h < nirrep_; h++) {
-            dimensions_.push_back(trip_aab[h]); // D3bba
+        if ( !spin_restricted_ ) {
+            for (int h = 0; h < nirrep_; h++) {
+                dimensions_.push_back(trip_aab[h]); // D3bba
+            }
         }
     }
 
+    // block offsets, and the blocks from largest to smallest
+    block_offsets_.resize(dimensions_.size());
+    update_npos_.assign(dimensions_.size(),-1);
+    long int block_offset = 0;
+    for (int i = 0; i < dimensions_.size(); i++) {
+        block_offsets_[i] = block_offset;
+        block_offset += (long int)dimensions_[i] * dimensions_[i];
+        if ( dimensions_[i] > 0 ) update_order_.push_back(i);
+    }
+    std::stable_sort(update_order_.begin(),update_order_.end(),
+        [this](int a, int b) { return dimensions_[a] > dimensions_[b]; });
+
     // v2rdm sdp convergence thresholds:
     r_convergence_  = options_.get_double("R_CONVERGENCE");
     e_convergence_  = options_.get_double("E_CONVERGENCE");
@@ -1346,6 +1532,25 @@ void  v2RDMSolver::common_init(){
         throw PsiException("Not enough memory",__FILE__,__LINE__);
     }
 
+    // per-thread buffers for the T1 / T2 parts of A^T.u
+    ATu_buffer_   = NULL;
+
+    // workspaces for Update_xz are allocated on the first update
+    update_nthreads_    = 0;
+    update_nlarge_      = 0;
+    update_work_nonsym_ = NULL;
+    ATu_nthreads_ = 1;
+    if ( constrain_t1_ || constrain_t2_ ) {
+        long int maxthreads = available_memory_ / ( 8L * dimx_d2q2g2_ );
+        ATu_nthreads_ = omp_get_max_threads();
+        if ( ATu_nthreads_ > maxthreads ) ATu_nthreads_ = maxthreads;
+        if ( ATu_nthreads_ < 1 )          ATu_nthreads_ = 1;
+        ATu_buffer_ = (double*)malloc(ATu_nthreads_*dimx_d2q2g2_*sizeof(double));
+        available_memory_ -= ATu_nthreads_*dimx_d2q2g2_*8L;
+        outfile->Printf("        Threads for T1/T2 part of A^T.u: %8i\n",ATu_nthreads_);
+        outfile->Printf("\n");
+    }
+
     // mo-mo transformation matrix
     newMO_ = (SharedMatrix)(new Matrix(reference_wavefunction_->Ca()));
     newMO_->zero();
@@ -1410,13 +1615,35 @@ void  v2RDMSolver::common_init(){
     z      = SharedVector(new Vector("dual solution 2",dimx_));
     b      = SharedVector(new Vector("constraints",nconstraints_));
 
-    // DIIS stuff
-    //rx       = SharedVector(new Vector("diis x",dimx_));
-    //rz       = SharedVector(new Vector("diis z",dimx_));
-    //rx_error = SharedVector(new Vector("diis error x",dimx_));
-    //rz_error = SharedVector(new Vector("diis error z",dimx_));
-    //junk1    = (double*)malloc(2 * dimx_*sizeof(double));
-    //junk2    = (double*)malloc(2 * dimx_*sizeof(double));
+    // DIIS buffers are allocated in compute_energy (DIIS_EXTRAPOLATION)
+    diis_vec_ = NULL;
+    diis_err_ = NULL;
+    diis_in_  = NULL;
+    diis_b_   = NULL;
+    diis_A_    = NULL;
+    diis_ipiv_ = NULL;
+
+    // eigenvectors of M are kept for EIGENSOLVER_WARM_START or
+    // SDP_SOLVER = SSN_CG
+    update_warm_start_ = false;
+    sdp_newton_        = false;
+
+    // so are those for anderson acceleration (ANDERSON_ACCELERATION)
+    anderson_type_     = 0;
+    anderson_max_      = 0;
+    anderson_nrestart_ = 0;
+    anderson_used_     = 0;
+    anderson_restart_  = false;
+    anderson_df_       = NULL;
+    anderson_dg_       = NULL;
+    anderson_ff_       = NULL;
+    anderson_gf_       = NULL;
+    anderson_f_        = NULL;
+    anderson_g_        = NULL;
+    anderson_u_        = NULL;
+    anderson_a_        = NULL;
+    anderson_gamma_    = NULL;
+    anderson_ipiv_     = NULL;
 
 
     // input/output array for orbopt sweeps
@@ -1510,6 +1737,39 @@ double v2RDMSolver::compute_energy() {
     // generate constraint vector
     BuildConstraints();
 
+    // validate fast T2 mappings
+    if ( constrain_t2_ && fast_t2_ ) {
+        CheckT2Constraints();
+    }
+
+    // assemble sparse constraint matrix
+    if ( sparse_constraints_ ) {
+        BuildSparseConstraints();
+    }
+
+    // the semismooth newton-CG solver replaces the CG microiterations
+    sdp_newton_ = ( options_.get_str("SDP_SOLVER") == "SSN_CG" );
+
+    // jacobi preconditioner for the CG microiterations
+    if ( options_.get_str("CG_PRECONDITIONER") == "JACOBI" && !sdp_newton_ ) {
+        BuildPreconditioner();
+    }
+
+    // direct solution of A.A^T.y = B
+    if ( options_.get_str("DUAL_SOLVER") == "CHOLESKY" && !sdp_newton_ ) {
+        BuildCholeskyAAT();
+    }
+
+    // dependent rows and row scaling for the CG microiterations
+    if ( options_.get_bool("PRESOLVE_CONSTRAINTS") && !aat_cholesky_ && !cg_precon_ && !sdp_newton_ ) {
+        BuildPresolve();
+    }
+
+    // single-precision A.A^T for the CG microiterations
+    if ( options_.get_bool("CG_MIXED_PRECISION") && !aat_cholesky_ && !cg_precon_ && !sdp_newton_ ) {
+        BuildSinglePrecisionAAT();
+    }
+
     // AATy = A(c-z)+tu(b-Ax) rearange w.r.t cg solver
     // Ax   = AATy and b=A(c-z)+tu(b-Ax)
     SharedVector B   = SharedVector(new Vector("compound B",nconstraints_));
@@ -1519,6 +1779,123 @@ double v2RDMSolver::compute_energy() {
     std::shared_ptr<CGSolver> cg (new CGSolver(N));
     cg->set_max_iter(cg_maxiter_);
 
+    // A.A^T, or (S.A).(S.A)^T with the presolve
+    AATOperator AAT(this,(bool)row_scale_);
+    AATOperator AAT_unscaled(this,false);
+
+    // pipelined CG (fused vector updates and dot products)
+    bool pipelined_cg = ( options_.get_str("DUAL_SOLVER") == "PIPELINED_CG" );
+
+    // semismooth newton-CG: the spectral decompositions of the blocks of M,
+    // x at the start of each subproblem, A^T.u for the newton operator, and
+    // five vectors and a CG solver (three more) for the newton iterations
+    if ( sdp_newton_ && !update_eval_ ) {
+        long int neval = 0;
+        update_eval_offsets_.resize(dimensions_.size());
+        for (int i = 0; i < dimensions_.size(); i++) {
+            update_eval_offsets_[i] = neval;
+            neval += dimensions_[i];
+        }
+        long int mem = 8L * ( 3L * dimx_ + neval + 8L * nconstraints_ );
+        if ( mem > available_memory_ ) {
+            throw PsiException("Not enough memory for SDP_SOLVER = SSN_CG",__FILE__,__LINE__);
+        }
+        update_evec_ = SharedVector(new Vector("eigenvectors of M",dimx_));
+        update_eval_ = SharedVector(new Vector("eigenvalues of M",neval));
+        ssn_x0_      = SharedVector(new Vector("newton x0",dimx_));
+        ssn_h_       = SharedVector(new Vector("newton A^T.u",dimx_));
+        ssn_r_       = SharedVector(new Vector("newton residual",nconstraints_));
+        ssn_d_       = SharedVector(new Vector("newton step",nconstraints_));
+        ssn_rhs_     = SharedVector(new Vector("newton rhs",nconstraints_));
+        ssn_Ad_      = SharedVector(new Vector("newton A.d",nconstraints_));
+        ssn_yt_      = SharedVector(new Vector("newton trial y",nconstraints_));
+        ssn_cg_      = std::shared_ptr<CGSolver>(new CGSolver(nconstraints_));
+        available_memory_ -= mem;
+    }
+
+    // eigenvectors of the blocks of M for warm starts in Update_xz
+    if ( options_.get_bool("EIGENSOLVER_WARM_START") && !update_warm_start_ ) {
+        if ( !update_evec_ && 8L * dimx_ > available_memory_ ) {
+            outfile->Printf("\n");
+            outfile->Printf("  Not enough memory for EIGENSOLVER_WARM_START\n");
+        }else {
+            if ( !update_evec_ ) {
+                update_evec_ = SharedVector(new Vector("eigenvectors of M",dimx_));
+                available_memory_ -= 8L * dimx_;
+            }
+            update_warm_start_ = true;
+            update_nwarm_.assign(dimensions_.size(),-1);
+            update_warm_total_.assign(dimensions_.size(),0);
+            update_full_total_.assign(dimensions_.size(),0);
+        }
+    }
+
+    // anderson acceleration: the changes in f and g from anderson_max_
+    // iterations, their overlaps, the previous f, g, and u, and the
+    // equations for the mixing coefficients.  these accelerate the
+    // boundary-point iterations only
+    if ( options_.get_str("ANDERSON_ACCELERATION") != "NONE" && !anderson_u_ && !sdp_newton_ ) {
+        anderson_max_ = options_.get_int("ANDERSON_HISTORY");
+        anderson_dim_ = nconstraints_ + dimx_;
+        long int mem = ( 2L * anderson_max_ + 3L ) * anderson_dim_ * sizeof(double);
+        if ( anderson_max_ < 1 || mem > available_memory_ ) {
+            outfile->Printf("\n");
+            outfile->Printf("  Not enough memory for ANDERSON_ACCELERATION\n");
+        }else {
+            anderson_type_  = ( options_.get_str("ANDERSON_ACCELERATION") == "TYPE_I" ) ? 1 : 2;
+            anderson_df_    = (double*)malloc(anderson_max_ * anderson_dim_ * sizeof(double));
+            anderson_dg_    = (double*)malloc(anderson_max_ * anderson_dim_ * sizeof(double));
+            anderson_ff_    = (double*)malloc(anderson_max_ * anderson_max_ * sizeof(double));
+            anderson_gf_    = (double*)malloc(anderson_max_ * anderson_max_ * sizeof(double));
+            anderson_f_     = (double*)malloc(anderson_dim_ * sizeof(double));
+            anderson_g_     = (double*)malloc(anderson_dim_ * sizeof(double));
+            anderson_u_     = (double*)malloc(anderson_dim_ * sizeof(double));
+            anderson_a_     = (double*)malloc(anderson_max_ * anderson_max_ * sizeof(double));
+            anderson_gamma_ = (double*)malloc(anderson_max_ * sizeof(double));
+            anderson_ipiv_  = (long int*)malloc(anderson_max_ * sizeof(long int));
+            available_memory_ -= mem;
+        }
+    }
+
+    // DIIS extrapolation of the square roots of x and z: rx and rz, the
+    // vectors and errors from maxdiis_ iterations, and the current input.
+    // not combined with anderson acceleration
+    if ( options_.get_bool("DIIS_EXTRAPOLATION") && options_.get_int("DIIS_UPDATE_FREQUENCY") < 1 ) {
+        throw PsiException("DIIS_UPDATE_FREQUENCY must be at least 1",__FILE__,__LINE__);
+    }
+    if ( options_.get_bool("DIIS_EXTRAPOLATION") && maxdiis_ > 1 && !diis_vec_ && anderson_type_ == 0 && !sdp_newton_ ) {
+        long int mem = ( 2L * maxdiis_ + 2L ) * 2L * dimx_ * sizeof(double);
+        if ( mem > available_memory_ ) {
+            outfile->Printf("\n");
+            outfile->Printf("  Not enough memory for DIIS_EXTRAPOLATION\n");
+        }else {
+            dimdiis_  = 2L * dimx_;
+            rx        = SharedVector(new Vector("diis x",dimx_));
+            rz        = SharedVector(new Vector("diis z",dimx_));
+            diis_vec_ = (double*)malloc(maxdiis_ * dimdiis_ * sizeof(double));
+            diis_err_ = (double*)malloc(maxdiis_ * dimdiis_ * sizeof(double));
+            diis_in_  = (double*)malloc(dimdiis_ * sizeof(double));
+            diis_b_   = (double*)malloc(maxdiis_ * maxdiis_ * sizeof(double));
+            available_memory_ -= mem;
+        }
+    }
+
+    // recycled subspace for deflated CG (A.A^T is the same in every iteration)
+    int nrecycle = options_.get_int("CG_RECYCLE_DIMENSION");
+    bool cg_recycle = false;
+    if ( nrecycle > 0 && !aat_cholesky_ && !cg_precon_ && !cg_mixed_precision_ && !pipelined_cg && !sdp_newton_ ) {
+        // W, A.W, two work vectors, and 2 * nrecycle search directions
+        long int maxrecycle = available_memory_ / ( 8L * 8L * N );
+        if ( nrecycle > maxrecycle ) {
+            outfile->Printf("\n");
+            outfile->Printf("  CG recycle dimension reduced to %li (memory)\n",maxrecycle);
+            nrecycle = (int)maxrecycle;
+        }
+        cg->set_recycle_dimension(nrecycle);
+        available_memory_ -= 8L * 8L * N * nrecycle;
+        cg_recycle = ( nrecycle > 0 );
+    }
+
     // evaluate guess energy (c.x):
     double energy_primal = C_DDOT(dimx_,c->pointer(),1,x->pointer(),1);
 
@@ -1534,24 +1911,35 @@ double v2RDMSolver::compute_energy() {
     outfile->Printf("      E gap)");
     outfile->Printf("      mu");
     outfile->Printf("     eps(p)");
-    outfile->Printf("     eps(d)\n");
+    outfile->Printf("     eps(d)");
+    if ( anderson_type_ > 0 ) {
+        outfile->Printf("  AA");
+    }
+    outfile->Printf("\n");
 
-    double energy_dual,egap;
+    double energy_dual;
+    double egap = 0.0;
     double denergy_primal = fabs(energy_primal);
 
     int checkpoint_frequency = options_.get_int("ORBOPT_FREQUENCY");
     if ( options_["CHECKPOINT_FREQUENCY"].has_changed() ) {
         checkpoint_frequency = options_.get_int("CHECKPOINT_FREQUENCY");
     }
-    int mu_update_frequency  = options_.get_int("MU_UPDATE_FREQUENCY");
-    int orbopt_frequency     = options_.get_int("ORBOPT_FREQUENCY");
-    bool orbopt_one_step     = options_.get_bool("ORBOPT_ONE_STEP");
+    int mu_update_frequency   = options_.get_int("MU_UPDATE_FREQUENCY");
+    int orbopt_frequency      = options_.get_int("ORBOPT_FREQUENCY");
+    bool orbopt_one_step      = options_.get_bool("ORBOPT_ONE_STEP");
+    int diis_update_frequency = options_.get_int("DIIS_UPDATE_FREQUENCY");
 
     int oiter=0;
 
-    diis_oiter_           = 0;
-    int diis_iter         = 0;
-    int replace_diis_iter = 1;
+    DIIS_Reset();
+    Anderson_Reset();
+    long int ndiis = 0;
+
+    // penalty parameter and CG forcing term
+    adaptive_mu_ = ( options_.get_str("MU_UPDATE") == "ADAPTIVE" );
+    cg_forcing_  = 0.01;
+    ResetMuController(oiter);
 
     bool stop_updating_mu = false;
     do {
@@ -1559,33 +1947,80 @@ double v2RDMSolver::compute_energy() {
 
         double start = omp_get_wtime();
 
-        // evaluate tau * mu * (b - Ax) for CG
-        bpsdp_Au(Ax, x);
-        Ax->subtract(b);
-        Ax->scale(-tau*mu);
+        int iiter = 0;
 
-        // evaluate A(c-z) ( but don't overwrite c! )
-        z->scale(-1.0);
-        z->add(c);
-        bpsdp_Au(B,z);
+        if ( sdp_newton_ ) {
 
-        // add tau*mu*(b-Ax) to A(c-z) and put result in B
-        B->add(Ax);
+            // semismooth newton-CG solution of the subproblem in y, which
+            // also updates x and z.  its residual is || Ax - b ||
+            double ssn_conv_i = ( oiter == 0 ) ? 0.01 : 0.1 * ed;
+            if ( ssn_conv_i < 0.1 * r_convergence_ )
+                ssn_conv_i = 0.1 * r_convergence_;
+            iiter = SemismoothNewton(ssn_conv_i);
 
+        }else {
 
-        // set convergence for CG problem (step 1 in table 1 of PRL 106 083001)
-        double cg_conv_i = cg_convergence_;
-        if (oiter == 0) 
-            cg_conv_i = 0.01;
-        else
-            cg_conv_i = (ep > ed) ? 0.01 * ed : 0.01 * ep;
-        if (cg_conv_i < cg_convergence_)
-            cg_conv_i = cg_convergence_;
-        cg->set_convergence(cg_conv_i);
+            // evaluate tau * mu * (b - Ax) for CG
+            bpsdp_Au(Ax, x);
+            Ax->subtract(b);
+            Ax->scale(-tau*mu);
+
+            // evaluate A(c-z) ( but don't overwrite c! )
+            z->scale(-1.0);
+            z->add(c);
+            bpsdp_Au(B,z);
+
+            // add tau*mu*(b-Ax) to A(c-z) and put result in B
+            B->add(Ax);
+
+
+            // set convergence for CG problem (step 1 in table 1 of PRL 106 083001)
+            double cg_conv_i = cg_convergence_;
+            if (oiter == 0) 
+                cg_conv_i = 0.01;
+            else
+                cg_conv_i = (ep > ed) ? cg_forcing_ * ed : cg_forcing_ * ep;
+            if (cg_conv_i < cg_convergence_)
+                cg_conv_i = cg_convergence_;
+            cg->set_convergence(cg_conv_i);
+
+            // presolve: solve (S.A).(S.A)^T.y' = S.B, starting from y' = S^-1.y
+            if ( row_scale_ ) {
+                double * s_p = row_scale_->pointer();
+                double * B_p = B->pointer();
+                double * y_p = y->pointer();
+                for (long int i = 0; i < nconstraints_; i++) {
+                    B_p[i] *= s_p[i];
+                    y_p[i]  = ( s_p[i] != 0.0 ) ? y_p[i] / s_p[i] : 0.0;
+                }
+            }
+
+            // solve CG problem (step 1 in table 1 of PRL 106 083001)
+            if ( aat_cholesky_ ) {
+                aat_cholesky_->solve(y->pointer(),B->pointer());
+            }else if ( cg_precon_ ) {
+                cg->preconditioned_solve(N,Ax,y,B,cg_precon_,AAT_unscaled);
+                iiter = cg->total_iterations();
+            }else if ( cg_mixed_precision_ ) {
+                cg->mixed_precision_solve(N,Ax,y,B,AAT);
+                iiter = cg->total_iterations();
+            }else if ( pipelined_cg ) {
+                cg->pipelined_solve(N,Ax,y,B,AAT);
+                iiter = cg->total_iterations();
+            }else {
+                cg->solve(N,Ax,y,B,AAT);
+                iiter = cg->total_iterations();
+            }
 
-        // solve CG problem (step 1 in table 1 of PRL 106 083001)
-        cg->solve(N,Ax,y,B,evaluate_Ap,(void*)this);
-        int iiter = cg->total_iterations();
+            // y = S.y' (in the original numbering of the constraints)
+            if ( row_scale_ ) {
+                double * s_p = row_scale_->pointer();
+                double * y_p = y->pointer();
+                for (long int i = 0; i < nconstraints_; i++) {
+                    y_p[i] *= s_p[i];
+                }
+            }
+        }
 
         double end = omp_get_wtime();
 
@@ -1595,7 +2030,17 @@ double v2RDMSolver::compute_energy() {
         start = omp_get_wtime();
 
         // update primal and dual solutions
-        Update_xz();
+        if ( !sdp_newton_ ) {
+            Update_xz();
+        }
+
+        // DIIS extrapolation of the square roots of x and z
+        if ( rx ) {
+            DIIS_WriteVector();
+            if ( oiter % diis_update_frequency == 0 && oiter > 0 ) {
+                if ( DIIS_Extrapolate() ) ndiis++;
+            }
+        }
 
         end = omp_get_wtime();
 
@@ -1615,14 +2060,20 @@ double v2RDMSolver::compute_energy() {
         Ax->subtract(b);
         ep = Ax->norm();///sqrt(nconstraints_);
 
-        // don't update mu every iteration
-        if ( oiter % mu_update_frequency == 0 && oiter > 0 && !stop_updating_mu) {
-            mu = mu*ep/ed;
+        // with the newton solver, mu follows the ratio of the errors in
+        // every iteration, by at most a factor of 2
+        if ( sdp_newton_ && ed > 0.0 && !stop_updating_mu ) {
+            double ratio = ep / ed;
+            if ( ratio > 2.0 ) ratio = 2.0;
+            if ( ratio < 0.5 ) ratio = 0.5;
+            mu *= ratio;
+
+        // don't update mu every iteration (see UpdateMu)
+        }else if ( !sdp_newton_ && !stop_updating_mu && UpdateMu(oiter,ep,ed,egap,mu_update_frequency) ) {
 
-            // reset DIIS
-            diis_oiter_       = 0;
-            diis_iter         = 0;
-            replace_diis_iter = 1;
+            // reset DIIS and anderson acceleration
+            DIIS_Reset();
+            Anderson_Reset();
 
         }
 
@@ -1641,10 +2092,10 @@ double v2RDMSolver::compute_energy() {
                 orbopt_time_      += end - start;
                 orbopt_iter_total_++;
 
-                // reset DIIS
-                diis_oiter_       = 0;
-                diis_iter         = 0;
-                replace_diis_iter = 1;
+                // reset DIIS, anderson acceleration, and the mu controller
+                DIIS_Reset();
+                Anderson_Reset();
+                ResetMuController(oiter);
 
                 // compute current primal and dual energies
                 current_energy = C_DDOT(dimx_,c->pointer(),1,x->pointer(),1);
@@ -1657,8 +2108,14 @@ double v2RDMSolver::compute_energy() {
 
         //energy_primal = C_DDOT(dimx_,c->pointer(),1,x->pointer(),1);
 
-        outfile->Printf("      %5i %5i %11.6lf %11.6lf %11.6lf %7.3lf %10.5lf %10.5lf\n",
+        outfile->Printf("      %5i %5i %11.6lf %11.6lf %11.6lf %7.3lf %10.5lf %10.5lf",
                     oiter,iiter,current_energy+enuc_+efzc_,energy_dual+efzc_+enuc_,fabs(current_energy-energy_dual),mu,ep,ed);
+        // anderson acceleration: the number of changes used, and R if the
+        // history was discarded
+        if ( anderson_type_ > 0 ) {
+            outfile->Printf(" %3li%s",anderson_used_,anderson_restart_ ? "R" : "");
+        }
+        outfile->Printf("\n");
         oiter++;
 
         if (oiter == maxiter_) break;
@@ -1678,6 +2135,11 @@ double v2RDMSolver::compute_energy() {
                 orbopt_time_      += end - start;
                 orbopt_iter_total_++;
 
+                // reset DIIS, anderson acceleration, and the mu controller
+                DIIS_Reset();
+                Anderson_Reset();
+                ResetMuController(oiter);
+
                 energy_primal = C_DDOT(dimx_,c->pointer(),1,x->pointer(),1);
             }
         }else {
@@ -1694,14 +2156,34 @@ double v2RDMSolver::compute_energy() {
     outfile->Printf("      v2RDM iterations converged!\n");
     outfile->Printf("\n");
 
+    if ( update_warm_start_ ) {
+        long int nwarm = 0;
+        long int nfull = 0;
+        for (int i = 0; i < dimensions_.size(); i++) {
+            nwarm += update_warm_total_[i];
+            nfull += update_full_total_[i];
+        }
+        outfile->Printf("      Warm-started block diagonalizations: %10li\n",nwarm);
+        outfile->Printf("      Full block diagonalizations:         %10li\n",nfull);
+        outfile->Printf("\n");
+    }
+    if ( rx ) {
+        outfile->Printf("      DIIS extrapolations:                 %10li\n",ndiis);
+        outfile->Printf("\n");
+    }
+    if ( anderson_type_ > 0 ) {
+        outfile->Printf("      Anderson acceleration restarts:      %10li\n",anderson_nrestart_);
+        outfile->Printf("\n");
+    }
+
     // evaluate spin squared
     double s2 = 0.0;
     double * x_p = x->pointer();
     for (int i = 0; i < amo_; i++){
         for (int j = 0; j < amo_; j++){
             int h = SymmetryPair(symmetry[i],symmetry[j]);
-            int ij = ibas_ab_sym[h][i][j];
-            int ji = ibas_ab_sym[h][j][i];
+            int ij = ibas_ab(i,j);
+            int ji = ibas_ab(j,i);
             s2 += x_p[d2aboff[h] + ij*gems_ab[h]+ji];
         }
     }
@@ -1801,6 +2283,24 @@ double v2RDMSolver::compute_energy() {
     outfile->Printf("      Total:                      %12.2lf s\n",end_total_time - start_total_time);
     outfile->Printf("\n");
 
+    Process::environment.globals["V2RDM MICROITERATIONS"] = iiter_total_;
+    Process::environment.globals["V2RDM MACROITERATIONS"] = oiter_total_;
+
+    // which of the optional solvers and accelerations were actually used,
+    // after any fallbacks (1 or 0)
+    Process::environment.globals["V2RDM SDP_SOLVER SSN_CG USED"] = sdp_newton_ ? 1.0 : 0.0;
+    Process::environment.globals["V2RDM DIIS_EXTRAPOLATION USED"] = ( ndiis > 0 ) ? 1.0 : 0.0;
+    Process::environment.globals["V2RDM SPIN_RESTRICTED USED"] = spin_restricted_ ? 1.0 : 0.0;
+    Process::environment.globals["V2RDM CG_PRECONDITIONER JACOBI USED"] = cg_precon_ ? 1.0 : 0.0;
+    Process::environment.globals["V2RDM DUAL_SOLVER CHOLESKY USED"] = aat_cholesky_ ? 1.0 : 0.0;
+    Process::environment.globals["V2RDM CG_RECYCLE_DIMENSION USED"] = cg_recycle ? 1.0 : 0.0;
+    Process::environment.globals["V2RDM DUAL_SOLVER PIPELINED_CG USED"] = ( pipelined_cg && !aat_cholesky_ && !cg_precon_ && !cg_mixed_precision_ && !sdp_newton_ ) ? 1.0 : 0.0;
+    Process::environment.globals["V2RDM CG_MIXED_PRECISION USED"] = cg_mixed_precision_ ? 1.0 : 0.0;
+    Process::environment.globals["V2RDM PRESOLVE_CONSTRAINTS USED"] = row_scale_ ? 1.0 : 0.0;
+    Process::environment.globals["V2RDM EIGENSOLVER_WARM_START USED"] = update_warm_start_ ? 1.0 : 0.0;
+    Process::environment.globals["V2RDM ANDERSON_ACCELERATION USED"] = ( anderson_type_ > 0 ) ? 1.0 : 0.0;
+    Process::environment.globals["V2RDM MU_UPDATE ADAPTIVE USED"] = adaptive_mu_ ? 1.0 : 0.0;
+
     //CheckSpinStructure();
 
     return energy_primal + enuc_ + efzc_;
@@ -1819,13 +2319,13 @@ void v2RDMSolver::CheckSpinStructure() {
         for (int ij = 0; ij < gems_aa[h]; ij++) {
             int i = bas_aa_sym[h][ij][0];
             int j = bas_aa_sym[h][ij][1];
-            int ijb = ibas_ab_sym[h][i][j];
-            int jib = ibas_ab_sym[h][j][i];
+            int ijb = ibas_ab(i,j);
+            int jib = ibas_ab(j,i);
             for (int kl = 0; kl < gems_aa[h]; kl++) {
                 int k = bas_aa_sym[h][kl][0];
                 int l = bas_aa_sym[h][kl][1];
-                int klb = ibas_ab_sym[h][k][l];
-                int lkb = ibas_ab_sym[h][l][k];
+                int klb = ibas_ab(k,l);
+                int lkb = ibas_ab(l,k);
                 double dum = x_p[d2aaoff[h] + ij*gems_aa[h]+kl];
                 dum -= 0.5 * x_p[d2aboff[h] + ijb*gems_ab[h] + klb];
                 dum += 0.5 * x_p[d2aboff[h] + jib*gems_ab[h] + klb];
@@ -1842,13 +2342,13 @@ void v2RDMSolver::CheckSpinStructure() {
         for (int ij = 0; ij < gems_aa[h]; ij++) {
             int i = bas_aa_sym[h][ij][0];
             int j = bas_aa_sym[h][ij][1];
-            int ijb = ibas_ab_sym[h][i][j];
-            int jib = ibas_ab_sym[h][j][i];
+            int ijb = ibas_ab(i,j);
+            int jib = ibas_ab(j,i);
             for (int kl = 0; kl < gems_aa[h]; kl++) {
                 int k = bas_aa_sym[h][kl][0];
                 int l = bas_aa_sym[h][kl][1];
-                int klb = ibas_ab_sym[h][k][l];
-                int lkb = ibas_ab_sym[h][l][k];
+                int klb = ibas_ab(k,l);
+                int lkb = ibas_ab(l,k);
                 double dum = x_p[d2aaoff[h] + ij*gems_aa[h]+kl];
                 dum -= 0.5 * x_p[d2aboff[h] + ijb*gems_ab[h] + klb];
                 dum += 0.5 * x_p[d2aboff[h] + jib*gems_ab[h] + klb];
@@ -2094,7 +2594,7 @@ void v2RDMSolver::Guess(){
                         int ii = i + poff1;
                         int jj = j + poff2;
                         int h3 = SymmetryPair(symmetry[ii],symmetry[jj]);
-                        int ij = ibas_ab_sym[h3][ii][jj];
+                        int ij = ibas_ab(ii,jj);
                         x_p[d2aboff[h3] + ij*gems_ab[h3]+ij] = 1.0;
                     }
                     poff2   += nmopi_[h2] - rstcpi_[h2] - frzcpi_[h2] - rstvpi_[h2] - frzvpi_[h2];
@@ -2114,7 +2614,7 @@ void v2RDMSolver::Guess(){
                         int jj = j + poff2;
                         if ( jj >= ii ) continue;
                         int h3 = SymmetryPair(symmetry[ii],symmetry[jj]);
-                        int ij = ibas_aa_sym[h3][ii][jj];
+                        int ij = ibas_aa(ii,jj);
                         x_p[d2aaoff[h3] + ij*gems_aa[h3]+ij] = 1.0;
                     }
                     poff2   += nmopi_[h2] - rstcpi_[h2] - frzcpi_[h2] - rstvpi_[h2] - frzvpi_[h2];
@@ -2134,7 +2634,7 @@ void v2RDMSolver::Guess(){
                         int jj = j + poff2;
                         if ( jj >= ii ) continue;
                         int h3 = SymmetryPair(symmetry[ii],symmetry[jj]);
-                        int ij = ibas_aa_sym[h3][ii][jj];
+                        int ij = ibas_aa(ii,jj);
                         x_p[d2bboff[h3] + ij*gems_aa[h3]+ij] = 1.0;
                     }
                     poff2   += nmopi_[h2] - rstcpi_[h2] - frzcpi_[h2] - rstvpi_[h2] - frzvpi_[h2];
@@ -2299,11 +2799,13 @@ void v2RDMSolver::PrintDual(){
     }
     // additional spin constraints for singlets:
     if ( constrain_spin_ && nalpha_ == nbeta_ ) {
-        for ( int h = 0; h < nirrep_; h++) {
-            offset += amopi_[h]*amopi_[h]; // D1a = D1b
-        }
-        for ( int h = 0; h < nirrep_; h++) {
-            offset += gems_aa[h]*gems_aa[h]; // D2aa = D2bb
+        if ( !spin_restricted_ ) {
+            for (int h = 0; h < nirrep_; h++) {
+                offset += amopi_[h]*amopi_[h]; // D1a = D1b
+            }
+            for (int h = 0; h < nirrep_; h++) {
+                offset += gems_aa[h]*gems_aa[h]; // D2aa = D2bb
+            }
         }
         for ( int h = 0; h < nirrep_; h++) {
             offset += gems_aa[h]*gems_aa[h]; // D2aa[pq][rs] = 1/2(D2ab[pq][rs] - D2ab[pq][sr] - D2ab[qp][rs] + D2ab[qp][sr])
@@ -2666,8 +3168,10 @@ void v2RDMSolver::PrintDual(){
         }
         // additional spin constraints for singlets:
         if ( constrain_spin_ && nalpha_ == nbeta_ ) {
-            for (int h = 0; h < nirrep_; h++) {
-                offset += trip_aab[h]*trip_aab[h]; // D3aab = D3bba
+            if ( !spin_restricted_ ) {
+                for (int h = 0; h < nirrep_; h++) {
+                    offset += trip_aab[h]*trip_aab[h]; // D3aab = D3bba
+                }
             }
             for (int h = 0; h < nirrep_; h++) {
                 offset += trip_aaa[h]*trip_aaa[h]; // D3aab -> D3aaa
@@ -2768,11 +3272,13 @@ void v2RDMSolver::BuildConstraints(){
     }
     // additional spin constraints for singlets:
     if ( constrain_spin_ && nalpha_ == nbeta_ ) {
-        for ( int h = 0; h < nirrep_; h++) {
-            offset += amopi_[h]*amopi_[h]; // D1a = D1b
-        }
-        for ( int h = 0; h < nirrep_; h++) {
-            offset += gems_aa[h]*gems_aa[h]; // D2aa = D2bb
+        if ( !spin_restricted_ ) {
+            for (int h = 0; h < nirrep_; h++) {
+                offset += amopi_[h]*amopi_[h]; // D1a = D1b
+            }
+            for (int h = 0; h < nirrep_; h++) {
+                offset += gems_aa[h]*gems_aa[h]; // D2aa = D2bb
+            }
         }
         for ( int h = 0; h < nirrep_; h++) {
             offset += gems_aa[h]*gems_aa[h]; // D2aa[pq][rs] = 1/2(D2ab[pq][rs] - D2ab[pq][sr] - D2ab[qp][rs] + D2ab[qp][sr])
@@ -3089,8 +3595,10 @@ void v2RDMSolver::BuildConstraints(){
         }
         // additional spin constraints for singlets:
         if ( constrain_spin_ && nalpha_ == nbeta_ ) {
-            for (int h = 0; h < nirrep_; h++) {
-                offset += trip_aab[h]*trip_aab[h]; // D3aab = D3bba
+            if ( !spin_restricted_ ) {
+                for (int h = 0; h < nirrep_; h++) {
+                    offset += trip_aab[h]*trip_aab[h]; // D3aab = D3bba
+                }
             }
             for (int h = 0; h < nirrep_; h++) {
                 offset += trip_aaa[h]*trip_aaa[h]; // D3aab -> D3aaa
@@ -3107,37 +3615,14 @@ void v2RDMSolver::bpsdp_Au(SharedVector A, SharedVector u){
     //A->zero();
     memset((void*)A->pointer(),'\0',nconstraints_*sizeof(double));
 
-    offset = 0;
-    D2_constraints_Au(A,u);
+    if ( A_sparse_ ) {
 
-    if ( constrain_q2_ ) {
-        if ( !spin_adapt_q2_ ) {
-            Q2_constraints_Au(A,u);
-        }else {
-            Q2_constraints_Au_spin_adapted(A,u);
-        }
-    }
-
-    if ( constrain_g2_ ) {
-        if ( ! spin_adapt_g2_ ) {
-            G2_constraints_Au(A,u);
-        }else {
-            G2_constraints_Au_spin_adapted(A,u);
-        }
-    }
-
-    if ( constrain_t1_ ) {
-        T1_constraints_Au(A,u);
-    }
+        // D2, Q2, and G2 rows from sparse A
+        A_sparse_->Au(A->pointer(),u->pointer());
 
-    if ( constrain_t2_ ) {
-        //T2_constraints_Au(A,u);
-        T2_constraints_Au_slow(A,u);
     }
 
-    if ( constrain_d3_ ) {
-        D3_constraints_Au(A,u);
-    }
+    Au_tasks(A,u,!A_sparse_,fast_t2_,SkippedBlocks());
 
 } // end Au
 
@@ -3146,38 +3631,70 @@ void v2RDMSolver::bpsdp_Au_slow(SharedVector A, SharedVector u){
     //A->zero();
     memset((void*)A->pointer(),'\0',nconstraints_*sizeof(double));
 
-    offset = 0;
-    D2_constraints_Au(A,u);
+    Au_tasks(A,u,true,false,SkippedBlocks());
 
-    if ( constrain_q2_ ) {
-        if ( !spin_adapt_q2_ ) {
-            Q2_constraints_Au(A,u);
-        }else {
-            Q2_constraints_Au_spin_adapted(A,u);
-        }
-    }
+} // end Au
 
-    if ( constrain_g2_ ) {
-        if ( ! spin_adapt_g2_ ) {
-            G2_constraints_Au(A,u);
-        }else {
-            G2_constraints_Au_spin_adapted(A,u);
-        }
-    }
+// each block of conditions writes to its own rows of A, starting at the row
+// offsets determined in common_init, so the blocks do not depend on one
+// another.  one thread walks the blocks and spawns tasks for each symmetry
+// block (or part of one) that the whole team executes, so many small
+// irreps or a small family do not leave threads idle.  the T2 and T1 blocks
+// are the most expensive, so they are spawned first.
+void v2RDMSolver::Au_tasks(SharedVector A, SharedVector u, bool d2q2g2, bool fast_t2, const SkippedBlocks & skip){
+
+    #pragma omp parallel
+    {
+        #pragma omp single
+        {
+            if ( constrain_t2_ ) {
+                offset = nconstraints_d2q2g2t1_;
+                if ( fast_t2 ) {
+                    T2_constraints_Au(A,u,skip);
+                }else {
+                    T2_constraints_Au_slow(A,u);
+                }
+            }
 
-    if ( constrain_t1_ ) {
-        T1_constraints_Au(A,u);
-    }
+            if ( constrain_t1_ ) {
+                offset = nconstraints_d2q2g2_;
+                T1_constraints_Au(A,u,skip);
+            }
 
-    if ( constrain_t2_ ) {
-        //T2_constraints_Au(A,u);
-        T2_constraints_Au_slow(A,u);
-    }
-    if ( constrain_d3_ ) {
-        D3_constraints_Au(A,u);
+            if ( constrain_d3_ ) {
+                offset = nconstraints_d2q2g2t1t2_;
+                D3_constraints_Au(A,u);
+            }
+
+            if ( d2q2g2 ) {
+
+                if ( constrain_g2_ ) {
+                    offset = nconstraints_d2q2_;
+                    if ( ! spin_adapt_g2_ ) {
+                        G2_constraints_Au(A,u,skip);
+                    }else {
+                        G2_constraints_Au_spin_adapted(A,u);
+                    }
+                }
+
+                if ( constrain_q2_ ) {
+                    offset = nconstraints_d2_;
+                    if ( !spin_adapt_q2_ ) {
+                        Q2_constraints_Au(A,u,skip);
+                    }else {
+                        Q2_constraints_Au_spin_adapted(A,u,skip);
+                    }
+                }
+
+                offset = 0;
+                D2_constraints_Au(A,u);
+            }
+        }
     }
 
-} // end Au
+    offset = nconstraints_;
+
+}
 
 ///Build AT dot u where u =[z,c]
 void v2RDMSolver::bpsdp_ATu(SharedVector A, SharedVector u){
@@ -3186,21 +3703,30 @@ void v2RDMSolver::bpsdp_ATu(SharedVector A, SharedVector u){
     memset((void*)A->pointer(),'\0',dimx_*sizeof(double));
 
     offset = 0;
-    D2_constraints_ATu(A,u);
+    if ( A_sparse_ ) {
 
-    if ( constrain_q2_ ) {
-        if ( !spin_adapt_q2_ ) {
-            Q2_constraints_ATu(A,u);
-        }else {
-            Q2_constraints_ATu_spin_adapted(A,u);
+        // D2, Q2, and G2 rows from sparse A
+        A_sparse_->ATu(A->pointer(),u->pointer());
+        offset = nconstraints_d2q2g2_;
+
+    }else {
+
+        D2_constraints_ATu(A,u);
+
+        if ( constrain_q2_ ) {
+            if ( !spin_adapt_q2_ ) {
+                Q2_constraints_ATu(A,u);
+            }else {
+                Q2_constraints_ATu_spin_adapted(A,u);
+            }
         }
-    }
 
-    if ( constrain_g2_ ) {
-        if ( ! spin_adapt_g2_ ) {
-            G2_constraints_ATu(A,u);
-        }else {
-            G2_constraints_ATu_spin_adapted(A,u);
+        if ( constrain_g2_ ) {
+            if ( ! spin_adapt_g2_ ) {
+                G2_constraints_ATu(A,u);
+            }else {
+                G2_constraints_ATu_spin_adapted(A,u);
+            }
         }
     }
 
@@ -3209,8 +3735,11 @@ void v2RDMSolver::bpsdp_ATu(SharedVector A, SharedVector u){
     }
 
     if ( constrain_t2_ ) {
-        //T2_constraints_ATu(A,u);
-        T2_constraints_ATu_slow(A,u);
+        if ( fast_t2_ ) {
+            T2_constraints_ATu(A,u);
+        }else {
+            T2_constraints_ATu_slow(A,u);
+        }
     }
     if ( constrain_d3_ ) {
         D3_constraints_ATu(A,u);
@@ -3247,7 +3776,6 @@ void v2RDMSolver::bpsdp_ATu_slow(SharedVector A, SharedVector u){
     }
 
     if ( constrain_t2_ ) {
-        //T2_constraints_ATu(A,u);
         T2_constraints_ATu_slow(A,u);
     }
 
@@ -3257,14 +3785,155 @@ void v2RDMSolver::bpsdp_ATu_slow(SharedVector A, SharedVector u){
 
 }//end ATu
 
+void v2RDMSolver::ZeroATuBuffers(){
+
+    long int n = ATu_nthreads_ * dimx_d2q2g2_;
+
+    #pragma omp parallel for schedule (static)
+    for (long int i = 0; i < n; i++) {
+        ATu_buffer_[i] = 0.0;
+    }
+
+}
+
+void v2RDMSolver::ReduceATuBuffers(double * A_p){
+
+    // the buffers are always summed in the same order, so the result does
+    // not depend on how the threads are scheduled
+    #pragma omp parallel for schedule (static)
+    for (long int i = 0; i < dimx_d2q2g2_; i++) {
+        double dum = 0.0;
+        for (int thread = 0; thread < ATu_nthreads_; thread++) {
+            dum += ATu_buffer_[thread * dimx_d2q2g2_ + i];
+        }
+        A_p[i] += dum;
+    }
+
+}
+
+// A.A^T.u.  the rows of the Q2, G2, T1, and T2 conditions each contain a
+// single -1 for their own block of x, and (barring the exceptions below) no
+// other row touches those blocks, so their contribution to A.A^T.u is just
+// u.  only the remaining blocks of A^T.u are built (in ATy) and contracted
+// with A, which avoids streaming the large T1/T2 blocks through memory.
+void v2RDMSolver::bpsdp_AATu(SharedVector A, SharedVector u){
+
+    double * A_p   = A->pointer();
+    double * u_p   = u->pointer();
+    double * ATy_p = ATy->pointer();
+
+    // T1 rows involve Q2 and G2, spin-adapted G2 has extra spin conditions,
+    // and the sparse D2/Q2/G2 rows always include their own blocks.  with
+    // SPIN_RESTRICTED, the alpha and beta rows share one block, so its
+    // contribution is not the identity.
+    SkippedBlocks skip;
+    skip.q2 = constrain_q2_ && !constrain_t1_ && !A_sparse_ && !( spin_restricted_ && !spin_adapt_q2_ );
+    skip.g2 = constrain_g2_ && !constrain_t1_ && !spin_adapt_g2_ && !A_sparse_;
+    skip.t1 = constrain_t1_ && !spin_restricted_;
+    skip.t2 = constrain_t2_ && !spin_restricted_;
+
+    // zero the blocks of ATy that are needed
+    if ( !A_sparse_ ) {
+        memset((void*)ATy_p,'\0',dimx_d2_*sizeof(double));
+        if ( !skip.q2 ) {
+            memset((void*)(ATy_p+dimx_d2_),'\0',(dimx_d2q2_-dimx_d2_)*sizeof(double));
+        }
+        if ( !skip.g2 ) {
+            memset((void*)(ATy_p+dimx_d2q2_),'\0',(dimx_d2q2g2_-dimx_d2q2_)*sizeof(double));
+        }
+    }
+    if ( ( constrain_t1_ && !skip.t1 ) || ( constrain_t2_ && !skip.t2 ) ) {
+        memset((void*)(ATy_p+dimx_d2q2g2_),'\0',(dimx_-dimx_d2q2g2_)*sizeof(double));
+    }else if ( constrain_d3_ ) {
+        memset((void*)(ATy_p+d3aaaoff[0]),'\0',(dimx_-d3aaaoff[0])*sizeof(double));
+    }
+
+    // A^T.u
+    offset = 0;
+    if ( A_sparse_ ) {
+        A_sparse_->ATu(ATy_p,u_p,dimx_d2q2g2_);
+        offset = nconstraints_d2q2g2_;
+    }else {
+        D2_constraints_ATu(ATy,u);
+        if ( constrain_q2_ ) {
+            if ( !spin_adapt_q2_ ) {
+                Q2_constraints_ATu(ATy,u,skip);
+            }else {
+                Q2_constraints_ATu_spin_adapted(ATy,u,skip);
+            }
+        }
+        if ( constrain_g2_ ) {
+            if ( ! spin_adapt_g2_ ) {
+                G2_constraints_ATu(ATy,u,skip);
+            }else {
+                G2_constraints_ATu_spin_adapted(ATy,u);
+            }
+        }
+    }
+    if ( constrain_t1_ ) {
+        T1_constraints_ATu(ATy,u,skip);
+    }
+    if ( constrain_t2_ ) {
+        T2_constraints_ATu(ATy,u,skip);
+    }
+    if ( constrain_d3_ ) {
+        D3_constraints_ATu(ATy,u);
+    }
+
+    // A.(A^T.u)
+    memset((void*)A_p,'\0',nconstraints_*sizeof(double));
+    if ( A_sparse_ ) {
+        A_sparse_->Au(A_p,ATy_p);
+    }
+    Au_tasks(A,ATy,!A_sparse_,true,skip);
+
+    // identity contributions
+    if ( skip.q2 ) C_DAXPY(nconstraints_d2q2_ - nconstraints_d2_,1.0,u_p + nconstraints_d2_,1,A_p + nconstraints_d2_,1);
+    if ( skip.g2 ) C_DAXPY(nconstraints_d2q2g2_ - nconstraints_d2q2_,1.0,u_p + nconstraints_d2q2_,1,A_p + nconstraints_d2q2_,1);
+    if ( skip.t1 ) C_DAXPY(nconstraints_d2q2g2t1_ - nconstraints_d2q2g2_,1.0,u_p + nconstraints_d2q2g2_,1,A_p + nconstraints_d2q2g2_,1);
+    if ( skip.t2 ) C_DAXPY(nconstraints_d2q2g2t1t2_ - nconstraints_d2q2g2t1_,1.0,u_p + nconstraints_d2q2g2t1_,1,A_p + nconstraints_d2q2g2t1_,1);
+
+}
+
 void v2RDMSolver::cg_Ax(long int N,SharedVector A,SharedVector ux){
 
+    // the fused A.A^T.u relies on the fast T2 mappings
+    if ( !constrain_t2_ || fast_t2_ ) {
+        bpsdp_AATu(A,ux);
+        return;
+    }
+
     A->zero();
     bpsdp_ATu(ATy,ux);
     bpsdp_Au(A,ATy);
 
 }//end cg_Ax
 
+// (S.A).(S.A)^T.u, for the presolve (see BuildPresolve)
+void v2RDMSolver::cg_Ax_scaled(long int N,SharedVector A,SharedVector ux){
+
+    double * s_p  = row_scale_->pointer();
+    double * u_p  = ux->pointer();
+    double * su_p = row_scale_u_->pointer();
+    double * A_p  = A->pointer();
+
+    for (long int i = 0; i < nconstraints_; i++) {
+        su_p[i] = s_p[i] * u_p[i];
+    }
+    cg_Ax(N,A,row_scale_u_);
+    for (long int i = 0; i < nconstraints_; i++) {
+        A_p[i] *= s_p[i];
+    }
+}
+
+// with only D2, Q2, and G2 conditions, A is entirely in A_sparse_ (see
+// BuildSinglePrecisionAAT).  with the presolve, the rows of the single-
+// precision copy are already scaled by S
+void v2RDMSolver::cg_Ax_sp(long int N, float * A, const float * u){
+    A_sparse_->ATu(ATy_sp_.data(),u);
+    A_sparse_->Au(A,ATy_sp_.data());
+}
+
 // update x and z
 void v2RDMSolver::Update_xz() {
 
@@ -3274,72 +3943,372 @@ void v2RDMSolver::Update_xz() {
     x->scale(mu);
     ATy->add(x);
 
-    // loop over each block of x/z
-    for (int i = 0; i < dimensions_.size(); i++) {
-        if ( dimensions_[i] == 0 ) continue;
-        int myoffset = 0;
-        for (int j = 0; j < i; j++) {
-            myoffset += dimensions_[j] * dimensions_[j];
-        }
+    // anderson acceleration of the iterations in y and M (the projection
+    // below keeps x and z positive semidefinite)
+    if ( anderson_type_ > 0 ) {
+        Anderson_Step();
+    }
 
-        SharedMatrix mat     (new Matrix(dimensions_[i],dimensions_[i]));
-        SharedMatrix eigvec  (new Matrix(dimensions_[i],dimensions_[i]));
-        SharedMatrix eigvec2 (new Matrix(dimensions_[i],dimensions_[i]));
-        SharedVector eigval  (new Vector(dimensions_[i]));
+    Project_xz();
+}
 
-        double ** mat_p = mat->pointer();
-        double * A_p    = ATy->pointer();
+// x and z from M (in ATy), by projection onto its positive and negative
+// eigenspaces
+void v2RDMSolver::Project_xz() {
+    ForEachUpdateBlock(&v2RDMSolver::Update_xz_block);
+}
 
-        for (int p = 0; p < dimensions_[i]; p++) {
-            for (int q = p; q < dimensions_[i]; q++) {
-                double dum = 0.5 * ( A_p[myoffset + p * dimensions_[i] + q] +
-                                     A_p[myoffset + q * dimensions_[i] + p] );
-                mat_p[p][q] = mat_p[q][p] = dum;
+// apply a per-block kernel (Update_xz_block or ssn_Jacobian_block) to every
+// block of the primal vector.  the blocks are independent.  large blocks
+// are processed one at a time, with threaded LAPACK/BLAS, and the rest are
+// distributed over the threads, largest first (see BuildUpdateWorkspace).
+// BLAS is pinned to one thread for the latter, so the threads aren't
+// oversubscribed.
+void v2RDMSolver::ForEachUpdateBlock(UpdateBlockKernel kernel) {
 
-            }
-        }
+    if ( update_nthreads_ != omp_get_max_threads() ) {
+        BuildUpdateWorkspace();
+    }
+    int nblocks = update_order_.size();
 
-        mat->diagonalize(eigvec,eigval);
-        //for (int p = 0; p < dimensions_[i]; p++) {
-        //    if ( fabs(eigval->pointer()[p]) < r_convergence_*0.1 ) eigval->pointer()[p] = 0.0;
-        //}
+    for (int k = 0; k < update_nlarge_; k++) {
+        (this->*kernel)(update_order_[k],0);
+    }
 
-        // separate U+ and U-, transform back to nondiagonal basis
+    int blas_nthreads = SetBLASThreads(1);
+
+    #pragma omp parallel for schedule (dynamic,1)
+    for (int k = update_nlarge_; k < nblocks; k++) {
+        (this->*kernel)(update_order_[k],omp_get_thread_num());
+    }
 
-        double * eval_p   = eigval->pointer();
-        double ** evec_p  = eigvec->pointer();
-        double ** evec2_p = eigvec2->pointer();
+    if ( blas_nthreads > 0 ) {
+        SetBLASThreads(blas_nthreads);
+    }
+}
 
-        double * x_p      = x->pointer();
-        double * z_p      = z->pointer();
+// per-thread workspaces for Update_xz, allocated once.  a block whose
+// O(n^3) cost exceeds an even share of the total would leave the other
+// threads idle, so such blocks are diagonalized one at a time, with
+// threaded LAPACK/BLAS, in the workspace of thread 0.  the rest are each
+// diagonalized by a single thread, so the other workspaces only need to
+// hold the largest of those.  each workspace holds a block, the selected
+// eigenvectors, a third matrix for the warm start (Update_xz_warm_start),
+// the eigenvalues, and the dsyevr work arrays, whose lengths are queried
+// once.  if the number of BLAS threads cannot be set (see SetBLASThreads),
+// the small blocks would oversubscribe the threads of a threaded BLAS, so
+// every block is treated as a large one.
+void v2RDMSolver::BuildUpdateWorkspace() {
+
+    for (int t = 0; t < update_work_.size(); t++) {
+        free(update_work_[t]);
+        free(update_iwork_[t]);
+    }
+
+    update_nthreads_ = omp_get_max_threads();
+    int nblocks = update_order_.size();
+
+    int blas_nthreads = SetBLASThreads(1);
+    bool blas_pinned = ( blas_nthreads > 0 );
+    if ( blas_pinned ) {
+        SetBLASThreads(blas_nthreads);
+    }else if ( update_nthreads_ > 1 ) {
+        outfile->Printf("\n");
+        outfile->Printf("  Warning: the number of BLAS threads cannot be set.  The blocks of x\n");
+        outfile->Printf("  and z will be diagonalized one at a time.\n");
+    }
+
+    double total_cost = 0.0;
+    for (int k = 0; k < nblocks; k++) {
+        double n = dimensions_[update_order_[k]];
+        total_cost += n * n * n;
+    }
+
+    update_nlarge_ = 0;
+    while ( update_nlarge_ < nblocks ) {
+        double n = dimensions_[update_order_[update_nlarge_]];
+        if ( blas_pinned && update_nthreads_ > 1 && n * n * n * update_nthreads_ < total_cost ) break;
+        update_nlarge_++;
+    }
+
+    long int nmax   = nblocks > 0 ? dimensions_[update_order_[0]] : 0;
+    long int nsmall = update_nlarge_ < nblocks ? dimensions_[update_order_[update_nlarge_]] : 0;
+
+    update_work_.resize(update_nthreads_);
+    update_iwork_.resize(update_nthreads_);
+    update_lwork_.resize(update_nthreads_);
+    update_liwork_.resize(update_nthreads_);
+    for (int t = 0; t < update_nthreads_; t++) {
+        long int n = ( t == 0 ) ? nmax : nsmall;
+
+        // workspace query
+        long int lwork  = 26 * n;
+        long int liwork = 10 * n;
+        if ( n > 0 ) {
+            char jobz  = 'V';
+            char range = 'V';
+            char uplo  = 'U';
+            long int lda = n;
+            long int il = 1, iu = n, m, info;
+            long int query = -1;
+            double vl = -1.0, vu = 1.0, abstol = 0.0;
+            double dum, optimal;
+            long int ioptimal, idum;
+            DSYEVR(jobz,range,uplo,n,&dum,lda,vl,vu,il,iu,abstol,m,&dum,&dum,lda,&idum,
+                   &optimal,query,&ioptimal,query,info);
+            if ( (long int)optimal > lwork ) lwork  = (long int)optimal;
+            if ( ioptimal > liwork )         liwork = ioptimal;
+        }
+
+        update_lwork_[t]  = lwork;
+        update_liwork_[t] = liwork;
+        update_work_[t]   = (double*)malloc(( 3 * n * n + n + lwork + 1 ) * sizeof(double));
+        update_iwork_[t]  = (long int*)malloc(( 2 * n + liwork + 1 ) * sizeof(long int));
+    }
+}
 
-        // (+) part
-        long int mydim = 0;
-        for (long int j = 0; j < dimensions_[i]; j++) {
-            if ( eval_p[j] > 0.0 ) {
-                for (long int q = 0; q < dimensions_[i]; q++) {
-                    mat_p[q][mydim]   = evec_p[q][j] * eval_p[j]/mu;
-                    evec2_p[q][mydim] = evec_p[q][j];
+// update x and z for one block.  with M = M(mu*x + ATy - c) = P+ - P-,
+// where P+ and P- are the projections of M onto its positive and negative
+// eigenspaces, x = P+ / mu and z = P-.  only the eigenpairs of one sign are
+// computed (dsyevr, with a range of eigenvalues): those of the sign that
+// had fewer eigenvalues in the previous update of this block, since near
+// convergence x and z are strongly rank deficient.  that projection is
+// built with dsyrk, and the other one is obtained from M = P+ - P-.
+//
+// with EIGENSOLVER_WARM_START, the full spectrum is kept instead, and the
+// eigenvectors of each block are reused in the next update (see
+// Update_xz_warm_start).  dsyevr is called only when those are not good
+// enough, and periodically, to restore their orthogonality.
+void v2RDMSolver::Update_xz_block(int i, int thread) {
+
+    long int n        = dimensions_[i];
+    long int myoffset = block_offsets_[i];
+
+    double * a_p    = update_work_[thread];
+    double * evec_p = a_p + n * n;
+    double * eval_p = evec_p + 2 * n * n;
+    double * work_p = eval_p + n;
+    long int * isuppz_p = update_iwork_[thread];
+    long int * iwork_p  = isuppz_p + 2 * n;
+    long int lwork  = update_lwork_[thread];
+    long int liwork = update_liwork_[thread];
+
+    double * A_p = ATy->pointer();
+    double * x_p = x->pointer() + myoffset;
+    double * z_p = z->pointer() + myoffset;
+
+    // symmetrized M.  the eigenvalues lie within +/- its frobenius norm
+    double nrm = 0.0;
+    for (long int p = 0; p < n; p++) {
+        for (long int q = p; q < n; q++) {
+            double dum = 0.5 * ( A_p[myoffset + p * n + q] +
+                                 A_p[myoffset + q * n + p] );
+            a_p[p * n + q] = a_p[q * n + p] = dum;
+            nrm += ( p == q ) ? dum * dum : 2.0 * dum * dum;
+        }
+    }
+    nrm = sqrt(nrm) + 1.0;
+
+    // positive part: eigenvalues in (0,nrm].  negative part: (-nrm,0]
+    bool positive = ( update_npos_[i] >= 0 && 2 * update_npos_[i] < n );
+
+    char jobz  = 'V';
+    char range = 'V';
+    char uplo  = 'U';
+    double vl = positive ? 0.0 : -nrm;
+    double vu = positive ? nrm : 0.0;
+    double abstol = 0.0;
+    long int il = 1, iu = n, m, info;
+
+    if ( update_evec_ || rx ) {
+
+        // all eigenpairs, with the eigenvectors in update_evec_ (or in
+        // evec_p).  the rotations of the warm starts slowly degrade their
+        // orthogonality
+        const int max_warm = 50;
+        double * v_p = update_evec_ ? update_evec_->pointer() + myoffset : evec_p;
+        if ( update_warm_start_ && update_nwarm_[i] >= 0 && update_nwarm_[i] < max_warm && Update_xz_warm_start(i,thread,nrm) ) {
+            update_nwarm_[i]++;
+            update_warm_total_[i]++;
+        }else {
+            range = 'A';
+            DSYEVR(jobz,range,uplo,n,a_p,n,vl,vu,il,iu,abstol,m,eval_p,v_p,n,isuppz_p,
+                   work_p,lwork,iwork_p,liwork,info);
+            if ( update_warm_start_ ) {
+                update_nwarm_[i] = 0;
+                update_full_total_[i]++;
+            }
+        }
+
+        // the spectrum, for the newton solver
+        if ( update_eval_ ) {
+            C_DCOPY(n,eval_p,1,update_eval_->pointer() + update_eval_offsets_[i],1);
+        }
+
+        // square roots of x and z for DIIS: rx = T.T^T, with
+        // T = V+.(lambda/mu)^(1/4), and rz = T.T^T, with T = V-.(-lambda)^(1/4)
+        if ( rx ) {
+            double * t_p = evec_p + n * n;
+            for (int part = 0; part < 2; part++) {
+                long int k = 0;
+                for (long int j = 0; j < n; j++) {
+                    if ( ( eval_p[j] > 0.0 ) != ( part == 0 ) ) continue;
+                    double scale = ( part == 0 ) ? pow(eval_p[j] / mu,0.25) : pow(-eval_p[j],0.25);
+                    C_DCOPY(n,v_p + j * n,1,t_p + k * n,1);
+                    C_DSCAL(n,scale,t_p + k * n,1);
+                    k++;
+                }
+                double * r_p = ( part == 0 ? rx : rz )->pointer() + myoffset;
+                char trans = 'N';
+                double one  = 1.0;
+                double zero = 0.0;
+                DSYRK(uplo,trans,n,k,one,t_p,n,zero,r_p,n);
+                for (long int q = 0; q < n; q++) {
+                    for (long int p = 0; p < q; p++) {
+                        r_p[p * n + q] = r_p[q * n + p];
+                    }
                 }
-                mydim++;
             }
         }
-        F_DGEMM('t','n',dimensions_[i],dimensions_[i],mydim,1.0,&mat_p[0][0],dimensions_[i],&evec2_p[0][0],dimensions_[i],0.0,x_p+myoffset,dimensions_[i]);
 
-        // (-) part
-        mydim = 0;
-        for (long int j = 0; j < dimensions_[i]; j++) {
-            if ( eval_p[j] < 0.0 ) {
-                for (long int q = 0; q < dimensions_[i]; q++) {
-                    mat_p[q][mydim]   = -evec_p[q][j] * eval_p[j];
-                    evec2_p[q][mydim] =  evec_p[q][j];
+        long int npos = 0;
+        for (long int j = 0; j < n; j++) {
+            if ( eval_p[j] > 0.0 ) npos++;
+        }
+        positive = ( 2 * npos < n );
+        update_npos_[i] = npos;
+
+        // the eigenpairs of the smaller part
+        m = 0;
+        for (long int j = 0; j < n; j++) {
+            if ( ( eval_p[j] > 0.0 ) != positive ) continue;
+            C_DCOPY(n,v_p + j * n,1,evec_p + m * n,1);
+            eval_p[m++] = eval_p[j];
+        }
+
+    }else {
+
+        DSYEVR(jobz,range,uplo,n,a_p,n,vl,vu,il,iu,abstol,m,eval_p,evec_p,n,isuppz_p,
+               work_p,lwork,iwork_p,liwork,info);
+
+        update_npos_[i] = positive ? m : n - m;
+    }
+
+    // P = S.S^T, with S = V.|lambda|^(1/2) (and 1/mu for x)
+    for (long int j = 0; j < m; j++) {
+        double scale = positive ? sqrt(eval_p[j] / mu) : sqrt(-eval_p[j]);
+        C_DSCAL(n,scale,evec_p + j * n,1);
+    }
+
+    double * P_p = positive ? x_p : z_p;
+    double * Q_p = positive ? z_p : x_p;
+
+    char trans = 'N';
+    double one  = 1.0;
+    double zero = 0.0;
+    DSYRK(uplo,trans,n,m,one,evec_p,n,zero,P_p,n);
+
+    // dsyrk fills P_p[q*n+p] for p <= q.  z = mu x - M or x = ( M + z ) / mu
+    for (long int q = 0; q < n; q++) {
+        for (long int p = 0; p <= q; p++) {
+            double pij = P_p[q * n + p];
+            double mij = 0.5 * ( A_p[myoffset + p * n + q] +
+                                 A_p[myoffset + q * n + p] );
+            double qij = positive ? mu * pij - mij : ( mij + pij ) / mu;
+            P_p[p * n + q] = pij;
+            Q_p[q * n + p] = Q_p[p * n + q] = qij;
+        }
+    }
+}
+
+// eigenpairs of block i, M (in the workspace of thread), from its
+// eigenvectors V in the previous update.  M changes little from one update
+// to the next, so B = V^T.M.V is nearly diagonal: this is the rayleigh-ritz
+// matrix of M in the previous eigenvectors.  B is diagonalized by cyclic
+// jacobi sweeps, whose rotations are accumulated in V, and each sweep costs
+// O(n^2) when few rotations are needed, so the cost is dominated by the two
+// matrix products.  rotations are skipped for elements of B below
+// tol * |M| / n, which bounds the norm of the neglected off-diagonal part by
+// tol * |M|.  returns false if the previous eigenvectors are too far from
+// those of M, or if the sweeps do not converge, in which case M is intact
+// but V is not.  otherwise, the eigenvalues are returned in the workspace.
+bool v2RDMSolver::Update_xz_warm_start(int i, int thread, double nrm) {
+
+    const double tol     = 1.0e-10;
+    const int max_sweeps = 4;
+
+    long int n = dimensions_[i];
+
+    double * a_p    = update_work_[thread];
+    double * t_p    = a_p + n * n;
+    double * b_p    = t_p + n * n;
+    double * eval_p = b_p + n * n;
+    double * v_p    = update_evec_->pointer() + block_offsets_[i];
+
+    // B = V^T.(M.V)
+    F_DGEMM('n','n',n,n,n,1.0,a_p,n,v_p,n,0.0,t_p,n);
+    F_DGEMM('t','n',n,n,n,1.0,v_p,n,t_p,n,0.0,b_p,n);
+
+    double off = 0.0;
+    for (long int p = 0; p < n; p++) {
+        for (long int q = p + 1; q < n; q++) {
+            off += 2.0 * b_p[q * n + p] * b_p[q * n + p];
+        }
+    }
+    if ( sqrt(off) > 0.1 * nrm ) return false;
+
+    double thresh = tol * nrm / n;
+
+    for (int sweep = 0; sweep < max_sweeps; sweep++) {
+
+        long int nrot = 0;
+
+        for (long int p = 0; p < n; p++) {
+            for (long int q = p + 1; q < n; q++) {
+
+                double bpq = b_p[q * n + p];
+                if ( fabs(bpq) <= thresh ) continue;
+
+                // the rotation that zeroes B(p,q)
+                double theta = 0.5 * ( b_p[q * n + q] - b_p[p * n + p] ) / bpq;
+                double t = 1.0 / ( fabs(theta) + sqrt(theta * theta + 1.0) );
+                if ( theta < 0.0 ) t = -t;
+                double c = 1.0 / sqrt(t * t + 1.0);
+                double s = t * c;
+
+                // B = J^T.B.J and V = V.J
+                for (long int k = 0; k < n; k++) {
+                    double bkp = b_p[p * n + k];
+                    double bkq = b_p[q * n + k];
+                    b_p[p * n + k] = c * bkp - s * bkq;
+                    b_p[q * n + k] = s * bkp + c * bkq;
                 }
-                mydim++;
+                for (long int k = 0; k < n; k++) {
+                    double bpk = b_p[k * n + p];
+                    double bqk = b_p[k * n + q];
+                    b_p[k * n + p] = c * bpk - s * bqk;
+                    b_p[k * n + q] = s * bpk + c * bqk;
+                }
+                b_p[q * n + p] = b_p[p * n + q] = 0.0;
+                for (long int k = 0; k < n; k++) {
+                    double vkp = v_p[p * n + k];
+                    double vkq = v_p[q * n + k];
+                    v_p[p * n + k] = c * vkp - s * vkq;
+                    v_p[q * n + k] = s * vkp + c * vkq;
+                }
+                nrot++;
             }
         }
-        F_DGEMM('t','n',dimensions_[i],dimensions_[i],mydim,1.0,&mat_p[0][0],dimensions_[i],&evec2_p[0][0],dimensions_[i],0.0,z_p+myoffset,dimensions_[i]);
 
+        if ( nrot == 0 ) {
+            for (long int j = 0; j < n; j++) {
+                eval_p[j] = b_p[j * n + j];
+            }
+            return true;
+        }
     }
+
+    return false;
 }
 
 // update x and z.  This version does not symmetrize the matrix M(mu*x+ATy-c)
@@ -3355,20 +4324,24 @@ void v2RDMSolver::Update_xz_nonsymmetric() {
     // loop over each block of x/z
     for (int i = 0; i < dimensions_.size(); i++) {
         if ( dimensions_[i] == 0 ) continue;
-        int myoffset = 0;
-        for (int j = 0; j < i; j++) {
-            myoffset += dimensions_[j] * dimensions_[j];
-        }
+        long int myoffset = block_offsets_[i];
 
-        SharedVector Up     (new Vector(dimensions_[i]));
-        SharedVector Um     (new Vector(dimensions_[i]));
-        double * A_p   = ATy->pointer();
+        // workspace for the largest block, allocated once
+        if ( !update_work_nonsym_ ) {
+            long int nmax = dimensions_[update_order_[0]];
+            update_work_nonsym_ = (double*)malloc(( 3 * nmax * nmax + 8 * nmax ) * sizeof(double));
+        }
 
-        double * myA = (double*)malloc(dimensions_[i]*dimensions_[i]*sizeof(double));
-        double * VL  = (double*)malloc(dimensions_[i]*dimensions_[i]*sizeof(double));
-        double * VR  = (double*)malloc(dimensions_[i]*dimensions_[i]*sizeof(double));
-        double * WR  = (double*)malloc(dimensions_[i]*sizeof(double));
-        double * WI  = (double*)malloc(dimensions_[i]*sizeof(double));
+        long int n = dimensions_[i];
+        double * A_p  = ATy->pointer();
+        double * myA  = update_work_nonsym_;
+        double * VL   = myA + n * n;
+        double * VR   = VL + n * n;
+        double * WR   = VR + n * n;
+        double * WI   = WR + n;
+        double * u_p  = WI + n;
+        double * u_m  = u_p + n;
+        double * WORK = u_m + n;
 
         C_DCOPY(dimensions_[i]*dimensions_[i],&A_p[myoffset],1,myA,1);
 
@@ -3377,11 +4350,9 @@ void v2RDMSolver::Update_xz_nonsymmetric() {
         memset((void*)WR,'\0',dimensions_[i]*sizeof(double));
         memset((void*)WI,'\0',dimensions_[i]*sizeof(double));
 
-        NonsymmetricEigenvalue(dimensions_[i],myA,VL,VR,WR,WI);
+        NonsymmetricEigenvalue(dimensions_[i],myA,VL,VR,WR,WI,WORK);
 
         // separate U+ and U-
-        double * u_p    = Up->pointer();
-        double * u_m    = Um->pointer();
         double * eval_p = WR;//eigval->pointer();
         for (int p = 0; p < dimensions_[i]; p++) {
             if ( eval_p[p] < 0.0 ) {
@@ -3430,11 +4401,6 @@ void v2RDMSolver::Update_xz_nonsymmetric() {
         //        z_p[myoffset+p*dimensions_[i]+q] = 0.5 * dumz;
         //    }
         //}
-
-        free(VL);
-        free(VR);
-        free(WR);
-        free(WI);
     }
 }
 
@@ -3455,9 +4421,9 @@ void v2RDMSolver::UnpackDensityPlusCore() {
             int hj           = symmetry[j];
             int ifull        = full_basis[i];
             int jfull        = full_basis[j];
-            int ij_ab        = ibas_ab_sym[h][i][j];
-            int ji_ab        = ibas_ab_sym[h][j][i];
-            int ij_aa        = ibas_aa_sym[h][i][j];
+            int ij_ab        = ibas_ab(i,j);
+            int ji_ab        = ibas_ab(j,i);
+            int ij_aa        = ibas_aa(i,j);
 
             for (int kl = 0; kl < gems_ab[h]; kl++) {
                 int k          = bas_ab_sym[h][kl][0];
@@ -3466,9 +4432,9 @@ void v2RDMSolver::UnpackDensityPlusCore() {
                 int hl         = symmetry[l];
                 int kfull      = full_basis[k];
                 int lfull      = full_basis[l];
-                int kl_ab      = ibas_ab_sym[h][k][l];
-                int lk_ab      = ibas_ab_sym[h][l][k];
-                int kl_aa      = ibas_aa_sym[h][k][l];
+                int kl_ab      = ibas_ab(k,l);
+                int lk_ab      = ibas_ab(l,k);
+                int kl_aa      = ibas_aa(k,l);
 
                 //if ( i > k ) continue;
                 //if ( j > l ) continue;
@@ -3482,14 +4448,14 @@ void v2RDMSolver::UnpackDensityPlusCore() {
 
                 int hkj = SymmetryPair(hk,hj);
 
-                int kj_ab = ibas_ab_sym[hkj][k][j];
-                int il_ab = ibas_ab_sym[hkj][i][l];
+                int kj_ab = ibas_ab(k,j);
+                int il_ab = ibas_ab(i,l);
 
-                int jk_ab = ibas_ab_sym[hkj][j][k];
-                int li_ab = ibas_ab_sym[hkj][l][i];
+                int jk_ab = ibas_ab(j,k);
+                int li_ab = ibas_ab(l,i);
 
-                int kj_aa = ibas_aa_sym[hkj][k][j];
-                int il_aa = ibas_aa_sym[hkj][i][l];
+                int kj_aa = ibas_aa(k,j);
+                int il_aa = ibas_aa(i,l);
 
                 offset = 0;
                 for (int myh = 0; myh < hik; myh++) {
@@ -3729,34 +4695,34 @@ void v2RDMSolver::PackSpatialDensity() {
             int j            = bas_ab_sym[h][ij][1];
             int hi           = symmetry[i];
             int hj           = symmetry[j];
-            int ij_ab        = ibas_ab_sym[h][i][j];
-            int ji_ab        = ibas_ab_sym[h][j][i];
-            int ij_aa        = ibas_aa_sym[h][i][j];
+            int ij_ab        = ibas_ab(i,j);
+            int ji_ab        = ibas_ab(j,i);
+            int ij_aa        = ibas_aa(i,j);
 
             for (int kl = 0; kl < gems_ab[h]; kl++) {
                 int k          = bas_ab_sym[h][kl][0];
                 int l          = bas_ab_sym[h][kl][1];
                 int hk         = symmetry[k];
                 int hl         = symmetry[l];
-                int kl_ab      = ibas_ab_sym[h][k][l];
-                int lk_ab      = ibas_ab_sym[h][l][k];
-                int kl_aa      = ibas_aa_sym[h][k][l];
+                int kl_ab      = ibas_ab(k,l);
+                int lk_ab      = ibas_ab(l,k);
+                int kl_aa      = ibas_aa(k,l);
 
                 int hik = SymmetryPair(hi,hk);
 
-                int ik = ibas_00_sym[hik][i][k];
-                int jl = ibas_00_sym[hik][j][l];
+                int ik = ibas_00(i,k);
+                int jl = ibas_00(j,l);
 
                 int hkj = SymmetryPair(hk,hj);
 
-                int kj_ab = ibas_ab_sym[hkj][k][j];
-                int il_ab = ibas_ab_sym[hkj][i][l];
+                int kj_ab = ibas_ab(k,j);
+                int il_ab = ibas_ab(i,l);
 
-                int jk_ab = ibas_ab_sym[hkj][j][k];
-                int li_ab = ibas_ab_sym[hkj][l][i];
+                int jk_ab = ibas_ab(j,k);
+                int li_ab = ibas_ab(l,i);
 
-                int kj_aa = ibas_aa_sym[hkj][k][j];
-                int il_aa = ibas_aa_sym[hkj][i][l];
+                int kj_aa = ibas_aa(k,j);
+                int il_aa = ibas_aa(i,l);
 
                 offset = 0;
                 for (int myh = 0; myh < hik; myh++) {
@@ -46,6 +46,9 @@
 // greg
 #include"fortran.h"
 
+#include"sparse_matrix.h"
+#include"sparse_cholesky.h"
+
 // TODO: move to psifiles.h
 #define PSIF_DCC_QMO          268
 #define PSIF_V2RDM_CHECKPOINT 269
@@ -57,7 +60,22 @@
 #define PSIF_V2RDM_D3BBA      275
 #define PSIF_V2RDM_D3BBB      276
 
-namespace psi{ namespace v2rdm_casscf{
+namespace psi{
+
+class CGSolver;
+
+namespace v2rdm_casscf{
+
+/// the -Q2, -G2, -T1, or -T2 terms left out of the mappings.  each row of
+/// these conditions contains exactly one such term, so the corresponding
+/// part of A.A^T.u is the identity, which bpsdp_AATu adds directly
+struct SkippedBlocks {
+    SkippedBlocks() : q2(false), g2(false), t1(false), t2(false) {}
+    bool q2;
+    bool g2;
+    bool t1;
+    bool t2;
+};
 
 class v2RDMSolver: public Wavefunction{
   public:
@@ -65,12 +83,25 @@ class v2RDMSolver: public Wavefunction{
     ~v2RDMSolver();
     void common_init();
     double compute_energy();
+
+    /// verify (adjointness) and time A.u and A^T.u for each family of
+    /// constraints, without solving the SDP
+    void BenchmarkConstraints();
     virtual bool same_a_b_orbs() const { return same_a_b_orbs_; }
     virtual bool same_a_b_dens() const { return same_a_b_dens_; }
 
     // public methods
     void cg_Ax(long int n,SharedVector A, SharedVector u);
 
+    /// (S.A).(S.A)^T.u, with the row scaling S of the presolve
+    void cg_Ax_scaled(long int n,SharedVector A, SharedVector u);
+
+    /// A.A^T.u in single precision (requires cg_mixed_precision_)
+    void cg_Ax_sp(long int n, float * A, const float * u);
+
+    /// A.J.A^T.u + shift u, the operator of the semismooth newton equations
+    void ssn_Ax(long int n, SharedVector A, SharedVector u);
+
   protected:
 
     /// constrain Q2 to be positive semidefinite?
@@ -97,6 +128,10 @@ class v2RDMSolver: public Wavefunction{
     /// constrain spin?
     bool constrain_spin_;
 
+    /// spin-restricted singlet: store only the alpha blocks of x (D1b, D2bb,
+    /// Q2bb, ... alias D1a, D2aa, Q2aa, ...)
+    bool spin_restricted_;
+
     /// symmetry product table:
     int * table;
 
@@ -160,18 +195,64 @@ class v2RDMSolver: public Wavefunction{
     /// grab one-electron integrals (T+V) in MO basis
     SharedMatrix GetOEI();
 
-    /// DIIS stuff
-    void DIIS(double*c,long int nvec,int replace_diis_iter);
-    void DIIS_WriteOldVector(long int iter,int diis_iter,int replace_diis_iter);
-    void DIIS_WriteErrorVector(int diis_iter,int replace_diis_iter,int iter);
-    void DIIS_Extrapolate(int diis_iter,int&replace_diis_iter);
+    /// DIIS extrapolation of the square roots of x and z (see diis.cc)
+    void DIIS_Reset();
+    void DIIS_WriteVector();
+    bool DIIS_Extrapolate();
     long int maxdiis_;
-    double * diisvec_;
-    double * junk1;
-    double * junk2;
-    long int diis_oiter_;
+    double * diisvec_;    // extrapolation coefficients
+    double * diis_vec_;   // (rx,rz) from the last maxdiis_ iterations
+    double * diis_err_;   // their changes in those iterations
+    double * diis_in_;    // (rx,rz) entering the current iteration
+    double * diis_b_;     // overlaps of the error vectors
+    double * diis_A_;     // the DIIS equations, (maxdiis_+1)^2
+    long int * diis_ipiv_;
+    long int diis_iter_;  // number of vectors stored since the last reset
+    bool diis_have_in_;
     long int dimdiis_;
 
+    /// update mu after iteration oiter (MU_UPDATE; see mu_controller.cc).
+    /// returns true if mu changed
+    bool UpdateMu(int oiter, double ep, double ed, double egap, int frequency);
+    void ResetMuController(int oiter);
+    bool adaptive_mu_;          // MU_UPDATE = ADAPTIVE?
+    double cg_forcing_;         // CG convergence / min(ep,ed)
+    double mu_log_ratio_;       // averaged log(ep/ed)
+    long int mu_nsamples_;      // number of ratios in the average
+    int mu_last_update_;        // iteration of the last change in mu
+    double mu_best_error_;      // smallest max(ep,ed) since then (in steps of 10%)
+    int mu_best_iter_;          // and its iteration
+    double mu_gap_ref_;         // energy gap at the last change in mu
+    double mu_rate_;            // averaged reduction of max(ep,ed) per iteration
+    double mu_error_prev_;      // max(ep,ed) in the previous iteration
+    int cg_last_update_;        // iteration of the last change in cg_forcing_
+
+    /// anderson acceleration of the iterations in y and M = mu x - z (see
+    /// anderson.cc)
+    void Anderson_Reset();
+    void Anderson_Step();
+    int anderson_type_;          // 0 (none), 1 (type I), or 2 (type II)
+    long int anderson_max_;      // maximum number of stored changes
+    long int anderson_dim_;      // nconstraints_ + dimx_
+    double * anderson_df_;       // changes in the residual f = g - u
+    double * anderson_dg_;       // changes in g = G(u)
+    double * anderson_ff_;       // dF^T.dF
+    double * anderson_gf_;       // dG^T.dF
+    double * anderson_f_;        // f from the previous iteration
+    double * anderson_g_;        // g from the previous iteration
+    double * anderson_u_;        // u entering the current iteration
+    double * anderson_a_;        // the equations for gamma, anderson_max_^2
+    double * anderson_gamma_;    // the mixing coefficients
+    long int * anderson_ipiv_;
+    double anderson_fnorm_;      // |f| from the previous iteration
+    long int anderson_iter_;     // number of changes stored since the last restart
+    long int anderson_nvec_;     // number of changes in the history
+    bool anderson_have_u_;
+    bool anderson_have_prev_;
+    long int anderson_used_;     // changes used in the last step
+    bool anderson_restart_;      // was the history discarded in the last step?
+    long int anderson_nrestart_; // number of restarts
+
     /// offsets
     int * d1aoff;
     int * d1boff;
@@ -226,6 +307,13 @@ class v2RDMSolver: public Wavefunction{
     /// standard vector of dimensions of each block of primal solution vector
     std::vector<int> dimensions_;
 
+    /// offset of each block of the primal solution vector
+    std::vector<long int> block_offsets_;
+
+    /// nonempty blocks of the primal solution vector, largest first (the
+    /// order in which Update_xz schedules them)
+    std::vector<int> update_order_;
+
     int offset;
 
     // mapping arrays with abelian symmetry
@@ -238,28 +326,45 @@ class v2RDMSolver: public Wavefunction{
     int * gems_00;
     int * gems_full;
     int * gems_plus_core;
-    int *** bas_ab_sym;
-    int *** bas_aa_sym;
-    int *** bas_00_sym;
+
+    /// geminals in each irrep: bas_ab_sym[h][ij][0] = i, etc.  the geminals
+    /// of all irreps are stored contiguously; bas_ab_sym[h] points to the
+    /// first geminal of irrep h
+    int (** bas_ab_sym)[2];
+    int (** bas_aa_sym)[2];
+    int (** bas_00_sym)[2];
     int *** bas_full_sym;
     int *** bas_really_full_sym;
-    int *** ibas_ab_sym;
-    int *** ibas_aa_sym;
-    int *** ibas_00_sym;
     int *** ibas_full_sym;
     int *** ibas_really_full_sym;
 
+    /// index of geminal ij within its irrep (-999 if not a valid geminal).
+    /// the irrep of ij is fixed by i and j, so these tables are flat
+    /// (amo_ x amo_) arrays rather than one table per irrep
+    int * ibas_ab_;
+    int * ibas_aa_;
+    int * ibas_00_;
+    inline int ibas_ab(int i, int j) { return ibas_ab_[i * amo_ + j]; }
+    inline int ibas_aa(int i, int j) { return ibas_aa_[i * amo_ + j]; }
+    inline int ibas_00(int i, int j) { return ibas_00_[i * amo_ + j]; }
+
     /// triplets for each irrep:
     std::vector < std::vector < std::tuple<int,int,int> > > triplets;
     int * trip_aaa;
     int * trip_aab;
     int * trip_aba;
-    int  ***  bas_aaa_sym;
-    int  ***  bas_aab_sym;
-    int  ***  bas_aba_sym;
-    int **** ibas_aaa_sym;
-    int **** ibas_aab_sym;
-    int **** ibas_aba_sym;
+    int (** bas_aaa_sym)[3];
+    int (** bas_aab_sym)[3];
+    int (** bas_aba_sym)[3];
+
+    /// index of triplet ijk within its irrep (-999 if not a valid triplet).
+    /// flat (amo_ x amo_ x amo_) arrays, as for the geminals
+    int * ibas_aaa_;
+    int * ibas_aab_;
+    int * ibas_aba_;
+    inline int ibas_aaa(int i, int j, int k) { return ibas_aaa_[( i * amo_ + j ) * amo_ + k]; }
+    inline int ibas_aab(int i, int j, int k) { return ibas_aab_[( i * amo_ + j ) * amo_ + k]; }
+    inline int ibas_aba(int i, int j, int k) { return ibas_aba_[( i * amo_ + j ) * amo_ + k]; }
 
     void PrintHeader();
 
@@ -289,28 +394,189 @@ class v2RDMSolver: public Wavefunction{
     void bpsdp_Au_slow(SharedVector A, SharedVector u);
     void D2_constraints_Au(SharedVector A,SharedVector u);
     void Q2_constraints_Au(SharedVector A,SharedVector u);
+    void Q2_constraints_Au(SharedVector A,SharedVector u,const SkippedBlocks & skip);
     void Q2_constraints_Au_spin_adapted(SharedVector A,SharedVector u);
+    void Q2_constraints_Au_spin_adapted(SharedVector A,SharedVector u,const SkippedBlocks & skip);
     void G2_constraints_Au(SharedVector A,SharedVector u);
+    void G2_constraints_Au(SharedVector A,SharedVector u,const SkippedBlocks & skip);
     void G2_constraints_Au_spin_adapted(SharedVector A,SharedVector u);
     void T1_constraints_Au(SharedVector A,SharedVector u);
+    void T1_constraints_Au(SharedVector A,SharedVector u,const SkippedBlocks & skip);
     void T2_constraints_Au(SharedVector A,SharedVector u);
+    void T2_constraints_Au(SharedVector A,SharedVector u,const SkippedBlocks & skip);
     void T2_constraints_Au_slow(SharedVector A,SharedVector u);
     void T2_tilde_constraints_Au(SharedVector A,SharedVector u);
     void D3_constraints_Au(SharedVector A,SharedVector u);
 
     void bpsdp_ATu(SharedVector A, SharedVector u);
     void bpsdp_ATu_slow(SharedVector A, SharedVector u);
+
+    /// A.A^T.u, evaluated without forming the full A^T.u intermediate
+    void bpsdp_AATu(SharedVector A, SharedVector u);
+
+    /// the D2, Q2, G2 (if d2q2g2), T1, T2, and D3 parts of A.u, evaluated
+    /// as concurrent tasks.  A must be zeroed on entry.
+    void Au_tasks(SharedVector A, SharedVector u, bool d2q2g2, bool fast_t2, const SkippedBlocks & skip);
+
     void D2_constraints_ATu(SharedVector A,SharedVector u);
     void Q2_constraints_ATu(SharedVector A,SharedVector u);
+    void Q2_constraints_ATu(SharedVector A,SharedVector u,const SkippedBlocks & skip);
     void Q2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u);
+    void Q2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u,const SkippedBlocks & skip);
     void G2_constraints_ATu(SharedVector A,SharedVector u);
+    void G2_constraints_ATu(SharedVector A,SharedVector u,const SkippedBlocks & skip);
     void G2_constraints_ATu_spin_adapted(SharedVector A,SharedVector u);
     void T1_constraints_ATu(SharedVector A,SharedVector u);
+    void T1_constraints_ATu(SharedVector A,SharedVector u,const SkippedBlocks & skip);
     void T2_constraints_ATu(SharedVector A,SharedVector u);
+    void T2_constraints_ATu(SharedVector A,SharedVector u,const SkippedBlocks & skip);
     void T2_constraints_ATu_slow(SharedVector A,SharedVector u);
+
+    /// use fast T2 mappings (rather than the slow reference versions)?
+    bool fast_t2_;
+
+    /// check fast T2 mappings against the slow ones (disables them on failure)
+    void CheckT2Constraints();
+
+    /// T2aab/T2bba block of A.u, A^T.u, or diag(A.A^T) (mapping is a T2Mapping, see t2.cc)
+    template <class Symmetry> void T2_constraints_aab_terms(Symmetry sym, double * A_p, double * u_p, int h, long int rowoff, long int t2off, bool beta, int mapping, bool skip_t2);
+    template <class Symmetry> void T2_constraints_aab_row(Symmetry sym, double * A_p, double * u_p, int h, long int rowoff, long int t2off, int ijk, bool beta, int mapping, bool skip_t2);
+
+    /// T2aaa/T2bbb block of A.u, A^T.u, or diag(A.A^T)
+    template <class Symmetry> void T2_constraints_aaa_terms(Symmetry sym, double * A_p, double * u_p, int h, long int rowoff, long int t2off, bool beta, int mapping, bool skip_t2);
+    template <class Symmetry> void T2_constraints_aaa_row(Symmetry sym, double * A_p, double * u_p, int h, long int rowoff, long int t2off, int ijk, bool beta, int mapping, bool skip_t2);
+
+    /// Q2, G2, T1, and T2 mappings, templated on a symmetry policy (see
+    /// symmetry_policy.h).  the X_constraints_Au/ATu functions above call
+    /// through the pointers below, which SelectConstraintKernels() sets to
+    /// the C1 or point-group instantiations once, in common_init.
+    template <class Symmetry> void Q2_constraints_Au_kernel(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+    template <class Symmetry> void Q2_constraints_ATu_kernel(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+    template <class Symmetry> void Q2_constraints_Au_spin_adapted_kernel(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+    template <class Symmetry> void Q2_constraints_ATu_spin_adapted_kernel(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+    template <class Symmetry> void G2_constraints_Au_kernel(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+    template <class Symmetry> void G2_constraints_ATu_kernel(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+    template <class Symmetry> void G2_constraints_Au_spin_adapted_kernel(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+    template <class Symmetry> void G2_constraints_ATu_spin_adapted_kernel(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+    template <class Symmetry> void T1_constraints_Au_kernel(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+    template <class Symmetry> void T1_constraints_ATu_kernel(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+    template <class Symmetry> void T2_constraints_Au_kernel(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+    template <class Symmetry> void T2_constraints_ATu_kernel(SharedVector A,SharedVector u,const SkippedBlocks & skip);
+    template <class Symmetry> void SelectConstraintKernels();
+
+    typedef void (v2RDMSolver::*ConstraintKernel)(SharedVector,SharedVector);
+    typedef void (v2RDMSolver::*SkippingKernel)(SharedVector,SharedVector,const SkippedBlocks &);
+    SkippingKernel Q2_constraints_Au_fn_;
+    SkippingKernel Q2_constraints_ATu_fn_;
+    SkippingKernel Q2_constraints_Au_spin_adapted_fn_;
+    SkippingKernel Q2_constraints_ATu_spin_adapted_fn_;
+    SkippingKernel G2_constraints_Au_fn_;
+    SkippingKernel G2_constraints_ATu_fn_;
+    SkippingKernel G2_constraints_Au_spin_adapted_fn_;
+    SkippingKernel G2_constraints_ATu_spin_adapted_fn_;
+    SkippingKernel T1_constraints_Au_fn_;
+    SkippingKernel T1_constraints_ATu_fn_;
+    SkippingKernel T2_constraints_Au_fn_;
+    SkippingKernel T2_constraints_ATu_fn_;
+
+    /// A.u for the family of constraints whose rows begin at rowoff
+    void BenchmarkAu(ConstraintKernel Au, long int rowoff, SharedVector A, SharedVector u);
+
+    /// the T1, T2, and D3 parts of diag(A.A^T), written to d beginning at row
+    /// offset (which is advanced past the rows of each family)
+    void T1_constraints_AAT_diagonal(double * d);
+    void T2_constraints_AAT_diagonal(double * d);
+    void D3_constraints_AAT_diagonal(double * d);
+
+    /// build the jacobi preconditioner for the CG solution of A.A^T.y = b
+    void BuildPreconditioner();
+
+    /// inverse of the diagonal of A.A^T (NULL if CG is not preconditioned)
+    SharedVector cg_precon_;
+
+    /// diag(A.A^T), the squared norms of the rows of A, in d
+    void AATDiagonal(double * d);
+
+    /// drop linearly dependent rows of A and equilibrate the rest for the
+    /// CG solution of A.A^T.y = b (see preconditioner.cc)
+    void BuildPresolve();
+
+    /// row scaling, S, for the CG solution of (S.A).(S.A)^T.y' = S.b, with
+    /// y = S.y'.  zero for dropped rows (NULL if there is no presolve)
+    SharedVector row_scale_;
+
+    /// S.u (for cg_Ax with the presolve)
+    SharedVector row_scale_u_;
     void T2_tilde_constraints_ATu(SharedVector A,SharedVector u);
     void D3_constraints_ATu(SharedVector A,SharedVector u);
 
+    /// number of primal variables in the D2, D1, and Q1 blocks
+    long int dimx_d2_;
+
+    /// number of primal variables in the D2, D1, Q1, and Q2 blocks
+    long int dimx_d2q2_;
+
+    /// number of primal variables in the D2, D1, Q1, Q2, and G2 blocks
+    long int dimx_d2q2g2_;
+
+    /// per-thread buffers (dimx_d2q2g2_ each) for the T1 and T2 parts of A^T.u
+    double * ATu_buffer_;
+
+    /// number of threads (and buffers) used in the T1 and T2 parts of A^T.u
+    int ATu_nthreads_;
+
+    /// zero per-thread A^T.u buffers
+    void ZeroATuBuffers();
+
+    /// add per-thread A^T.u buffers to A (in a fixed order)
+    void ReduceATuBuffers(double * A_p);
+
+    /// use a sparse (csr) representation of the D2, Q2, and G2 rows of A?
+    bool sparse_constraints_;
+
+    /// number of constraints arising from the D2, Q2, and G2 conditions
+    long int nconstraints_d2q2g2_;
+
+    /// number of constraints arising from the D2 conditions, the D2 and Q2
+    /// conditions, etc. (i.e., the first rows of each block of conditions)
+    long int nconstraints_d2_;
+    long int nconstraints_d2q2_;
+    long int nconstraints_d2q2g2t1_;
+    long int nconstraints_d2q2g2t1t2_;
+
+    /// D2, Q2, and G2 rows of A, stored in csr format
+    std::shared_ptr<SparseMatrix> A_sparse_;
+
+    /// assemble A_sparse_ (falls back to matrix-free A.u if memory is insufficient)
+    void BuildSparseConstraints();
+    void D2Q2G2_constraints_sparse(std::shared_ptr<SparseMatrix> A);
+
+    /// assemble and check the sparse D2, Q2, and G2 rows (NULL on failure)
+    std::shared_ptr<SparseMatrix> AssembleSparseConstraints();
+
+    /// compare sparse D2, Q2, and G2 rows to the matrix-free mappings
+    bool CheckSparseConstraints(std::shared_ptr<SparseMatrix> A);
+
+    /// cholesky factor of A.A^T, for the direct solution of A.A^T.y = B
+    /// (NULL if CG is used)
+    std::shared_ptr<SparseCholesky> aat_cholesky_;
+
+    /// factorize A.A^T (falls back to CG if the factor does not fit in memory)
+    void BuildCholeskyAAT();
+
+    /// apply A.A^T in single precision in the CG microiterations?  (set by
+    /// BuildSinglePrecisionAAT, which requires the sparse constraint matrix)
+    bool cg_mixed_precision_;
+    void BuildSinglePrecisionAAT();
+
+    /// single-precision A^T.u (for cg_Ax_sp)
+    std::vector<float> ATy_sp_;
+    void D2_constraints_sparse(std::shared_ptr<SparseMatrix> A);
+    void Q2_constraints_sparse(std::shared_ptr<SparseMatrix> A);
+    void Q2_constraints_sparse_spin_adapted(std::shared_ptr<SparseMatrix> A);
+    void G2_constraints_sparse(std::shared_ptr<SparseMatrix> A);
+    void G2_constraints_sparse_spin_adapted(std::shared_ptr<SparseMatrix> A);
+
     /// SCF energy
     double escf_;
 
@@ -329,12 +595,107 @@ class v2RDMSolver: public Wavefunction{
     SharedVector z;      // second dual solution
     SharedVector rx;       // square root of x (for diis)
     SharedVector rz;       // square root of z (for diis)
-    SharedVector rx_error; // error vector for x (for diis)
-    SharedVector rz_error; // error vector for z (for diis)
 
     void Update_xz();
     void Update_xz_nonsymmetric();
 
+    /// the update of x and z for block i, in the workspace of thread
+    /// (see Update_xz)
+    void Update_xz_block(int i, int thread);
+
+    /// allocate the per-thread workspaces for Update_xz and choose the
+    /// blocks that are diagonalized with threaded LAPACK
+    void BuildUpdateWorkspace();
+
+    /// number of threads for which the workspaces were built
+    int update_nthreads_;
+
+    /// the first update_nlarge_ blocks in update_order_ are diagonalized
+    /// one at a time, with threaded LAPACK/BLAS
+    int update_nlarge_;
+
+    /// per-thread workspaces for Update_xz and the lengths of the dsyevr
+    /// work arrays in each
+    std::vector<double*> update_work_;
+    std::vector<long int*> update_iwork_;
+    std::vector<long int> update_lwork_;
+    std::vector<long int> update_liwork_;
+
+    /// number of positive eigenvalues of each block in the previous update
+    /// (-1 before the first one), which decides the part of the spectrum
+    /// that Update_xz_block computes
+    std::vector<long int> update_npos_;
+
+    /// x and z from M (in ATy), block by block
+    void Project_xz();
+
+    /// a kernel applied to one block of the primal vector, in the
+    /// workspace of a thread (Update_xz_block or ssn_Jacobian_block)
+    typedef void (v2RDMSolver::*UpdateBlockKernel)(int,int);
+
+    /// apply kernel to every block, scheduled as described at
+    /// BuildUpdateWorkspace
+    void ForEachUpdateBlock(UpdateBlockKernel kernel);
+
+    /// semismooth newton-CG solution of the augmented lagrangian subproblem
+    /// in y (SDP_SOLVER = SSN_CG; see semismooth_newton.cc).  returns the
+    /// number of CG iterations
+    int SemismoothNewton(double tol);
+
+    /// the objective of the subproblem at u, with x, z, and the spectrum of
+    /// M(u), and the residual r = b - A.x
+    double ssn_Evaluate(SharedVector u, SharedVector r);
+
+    /// J.H for block i of ssn_h_, in place, with the generalized jacobian J
+    /// of the projection onto the positive semidefinite cone
+    void ssn_Jacobian_block(int i, int thread);
+
+    /// use the semismooth newton-CG solver?
+    bool sdp_newton_;
+
+    /// x at the start of the newton subproblem, and A^T.u for ssn_Ax
+    SharedVector ssn_x0_;
+    SharedVector ssn_h_;
+
+    /// residual, step, right-hand side, A.d, and trial y for the newton
+    /// iterations, and the CG solver for the newton steps
+    SharedVector ssn_r_;
+    SharedVector ssn_d_;
+    SharedVector ssn_rhs_;
+    SharedVector ssn_Ad_;
+    SharedVector ssn_yt_;
+    std::shared_ptr<CGSolver> ssn_cg_;
+
+    /// diagonal shift of the newton operator
+    double ssn_shift_;
+
+    /// eigenvalues of each block of M in the last update (with SSN_CG), at
+    /// update_eval_offsets_
+    SharedVector update_eval_;
+    std::vector<long int> update_eval_offsets_;
+
+    /// warm-start the diagonalizations (EIGENSOLVER_WARM_START)?
+    bool update_warm_start_;
+
+    /// eigenpairs of block i from the eigenvectors of its previous update.
+    /// false if those are not close enough (EIGENSOLVER_WARM_START)
+    bool Update_xz_warm_start(int i, int thread, double nrm);
+
+    /// eigenvectors of each block of M in the previous update, at the
+    /// offsets of the blocks in x (with EIGENSOLVER_WARM_START or SSN_CG)
+    SharedVector update_evec_;
+
+    /// number of consecutive warm-started updates of each block (-1 before
+    /// the first update)
+    std::vector<int> update_nwarm_;
+
+    /// numbers of warm-started and full diagonalizations of each block
+    std::vector<long int> update_warm_total_;
+    std::vector<long int> update_full_total_;
+
+    /// workspace for Update_xz_nonsymmetric (allocated on first use)
+    double * update_work_nonsym_;
+
     void NaturalOrbitals();
     void MullikenPopulations();
 
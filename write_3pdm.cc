@@ -85,7 +85,7 @@ void v2RDMSolver::WriteActive3PDM(){
             int jfull = full_basis[j];
             int kfull = full_basis[k];
 
-            int ijk_aab = ibas_aab_sym[h][i][j][k];
+            int ijk_aab = ibas_aab(i,j,k);
 
             for (int lmn = 0; lmn < trip_aba[h]; lmn++) {
 
@@ -99,7 +99,7 @@ void v2RDMSolver::WriteActive3PDM(){
                 int mfull = full_basis[m];
                 int nfull = full_basis[n];
 
-                int lmn_aab = ibas_aab_sym[h][l][m][n];
+                int lmn_aab = ibas_aab(l,m,n);
 
                 double valaab = x_p[d3aaboff[h] + ijk_aab*trip_aab[h] + lmn_aab];
                 double valbba = x_p[d3bbaoff[h] + ijk_aab*trip_aab[h] + lmn_aab];
@@ -143,7 +143,7 @@ void v2RDMSolver::WriteActive3PDM(){
             int jfull = full_basis[j];
             int kfull = full_basis[k];
 
-            int ijk_aaa = ibas_aaa_sym[h][i][j][k];
+            int ijk_aaa = ibas_aaa(i,j,k);
 
             for (int lmn = 0; lmn < trip_aba[h]; lmn++) {
 
@@ -157,7 +157,7 @@ void v2RDMSolver::WriteActive3PDM(){
                 int mfull = full_basis[m];
                 int nfull = full_basis[n];
 
-                int lmn_aaa = ibas_aaa_sym[h][l][m][n];
+                int lmn_aaa = ibas_aaa(l,m,n);
 
                 double valaaa = x_p[d3aaaoff[h] + ijk_aaa*trip_aaa[h] + lmn_aaa];
                 double valbbb = x_p[d3bbboff[h] + ijk_aaa*trip_aaa[h] + lmn_aaa];
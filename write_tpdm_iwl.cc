@@ -81,8 +81,8 @@ void v2RDMSolver::WriteTPDM_IWL(){
                 // an exact case (FH/STO-3G, a two-hole system)
                 if ( i != j && k != l ) {
 
-                    int ija = ibas_aa_sym[h][i][j];
-                    int kla = ibas_aa_sym[h][k][l];
+                    int ija = ibas_aa(i,j);
+                    int kla = ibas_aa(k,l);
 
                     int sij = i < j ? 1 : -1;
                     int skl = k < l ? 1 : -1;